@@ -409,7 +409,7 @@ int main(int argc, char *argv[])
       { GeoFile=strdup(argv[1]); 
         argv[1]=0; 
       }
-     else if (Ext && !strcasecmp(Ext,"msh"))
+     else if (Ext && (!strcasecmp(Ext,"msh") || !strcasecmp(Ext,"scuffmesh")))
       { MeshFile=strdup(argv[1]); 
         argv[1]=0; 
       }
@@ -423,6 +423,7 @@ int main(int argc, char *argv[])
   bool WriteGPFiles=0;
   bool WritePPFiles=0;
   bool WriteLabels=0;
+  bool WriteScuffMesh=false;
   int Neighbors=0;
   int EEPs[2]={-1,-1};
   bool RegionVolumes=false;
@@ -439,6 +440,7 @@ int main(int argc, char *argv[])
      {"WriteGnuplotFiles",  PA_BOOL,   0, 1, (void *)&WriteGPFiles,   0, "write gnuplot visualization files"},
      {"WriteGMSHFiles",     PA_BOOL,   0, 1, (void *)&WritePPFiles,   0, "write GMSH visualization files "},
      {"WriteGMSHLabels",    PA_BOOL,   0, 1, (void *)&WriteLabels,    0, "write GMSH labels"},
+     {"WriteScuffMesh",     PA_BOOL,   0, 1, (void *)&WriteScuffMesh, 0, "write binary .scuffmesh file"},
      {"Neighbors",          PA_INT,    1, 1, (void *)&Neighbors,      0, "number of neighboring cells to plot"},
      {"EEPs",               PA_INT,    2, 1, (void *)EEPs,            0, "analyze equivalent edge pairs for surfaces xx, xx"},
      {"RegionVolumes",      PA_BOOL,   0, 1, (void *)&RegionVolumes,  0, "compute volumes of closed regions"},
@@ -458,6 +460,8 @@ int main(int argc, char *argv[])
    ErrExit("--PhysicalRegion option may only be used with --meshfile");
   if (TransFile && GeoFile==0)
    ErrExit("--transfile option may only be used with --geometry");
+  if (WriteScuffMesh && MeshFile==0)
+   ErrExit("--WriteScuffMesh option may only be used with --meshfile");
   if (EPFile)
    WritePPFiles=true;
   if (WriteLabels)
@@ -483,6 +487,21 @@ int main(int argc, char *argv[])
      if (WritePPFiles)
       WriteMeshPPFiles(S);
 
+     if (WriteScuffMesh)
+      { char SMFileName[MAXSTR];
+        if (PhysicalRegion==-1)
+         snprintf(SMFileName,MAXSTR,"%s.scuffmesh",GetFileBase(MeshFile));
+        else
+         snprintf(SMFileName,MAXSTR,"%s.%i.scuffmesh",GetFileBase(MeshFile),PhysicalRegion);
+        char *p=GetFileExtension(MeshFile);
+        if (p && !strcasecmp(p,"scuffmesh"))
+         ErrExit("%s is already a .scuffmesh file",MeshFile);
+        char *ErrMsg=S->WriteScuffMeshFile(SMFileName);
+        if (ErrMsg)
+         ErrExit(ErrMsg);
+        printf("Binary mesh data written to file %s.\n\n",SMFileName);
+      }
+
    }
   else
    { G=new RWGGeometry(GeoFile);
@@ -0,0 +1,397 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Kernels.cc     -- reference problems and timed kernels for scuff-bench
+ *
+ * Each reference problem is built from one of the sample meshes in
+ * the examples/ directory of the scuff-em distribution, at several
+ * refinements. Each kernel does all of its setup (geometry
+ * construction, matrix assembly for kernels that need an assembled
+ * matrix as input, etc.) outside the timed region.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "scuff-bench.h"
+
+#define II cdouble(0.0,1.0)
+
+/***************************************************************/
+/* table of reference problems; within each family, entries    */
+/* are listed in order of increasing refinement                */
+/***************************************************************/
+BenchProblem BenchProblems[]=
+ { { FAMILY_COMPACT,  0, "Sphere_138",    "SolidSphere/Sphere_138.msh",   0 },
+   { FAMILY_COMPACT,  1, "Sphere_327",    "SolidSphere/Sphere_327.msh",   0 },
+   { FAMILY_COMPACT,  2, "Sphere_654",    "SolidSphere/Sphere_654.msh",   0 },
+   { FAMILY_COMPACT,  3, "Sphere_1362",   "SolidSphere/Sphere_1362.msh",  0 },
+   { FAMILY_PERIODIC, 0, "PFSUnitCell_340",  "PerforatedThinFilm/PFSUnitCell_340.msh",  0 },
+   { FAMILY_PERIODIC, 1, "PFSUnitCell_1491", "PerforatedThinFilm/PFSUnitCell_1491.msh", 0 },
+   { FAMILY_STATIC,   0, "Capacitor_40",   "TwoBodyCapacitors/Square_40.msh",   0 },
+   { FAMILY_STATIC,   1, "Capacitor_280",  "TwoBodyCapacitors/Square_280.msh",  0 },
+   { FAMILY_STATIC,   2, "Capacitor_1160", "TwoBodyCapacitors/Square_1160.msh", 0 },
+   { FAMILY_POINTS,   0, "Points_16",  0, 16  },
+   { FAMILY_POINTS,   1, "Points_64",  0, 64  },
+   { FAMILY_POINTS,   2, "Points_256", 0, 256 },
+   { 0, 0, 0, 0, 0 }
+ };
+
+/***************************************************************/
+/* write a .scuffgeo file for a reference problem into the     */
+/* current directory and return its name                       */
+/***************************************************************/
+char *WriteBenchGeometry(BenchProblem *P, BenchOptions *BO)
+{
+  char GeoFileName[MAXSTR];
+  snprintf(GeoFileName,MAXSTR,"scuff-bench_%s.scuffgeo",P->Name);
+  FILE *f=fopen(GeoFileName,"w");
+  if (!f)
+   ErrExit("could not open file %s",GeoFileName);
+
+  char MeshFileName[MAXSTR];
+  snprintf(MeshFileName,MAXSTR,"%s/%s",BO->MeshDir,P->MeshFile);
+  FILE *ff=fopen(MeshFileName,"r");
+  if (!ff)
+   ErrExit("could not find mesh file %s (use --MeshDir to set the location of the scuff-em examples directory)",MeshFileName);
+  fclose(ff);
+
+  switch(P->Family)
+   {
+     case FAMILY_COMPACT:
+       fprintf(f,"OBJECT Sphere\n");
+       fprintf(f,"  MESHFILE %s\n",MeshFileName);
+       fprintf(f,"  MATERIAL CONST_EPS_10\n");
+       fprintf(f,"ENDOBJECT\n");
+       break;
+
+     case FAMILY_PERIODIC:
+       fprintf(f,"LATTICE\n");
+       fprintf(f,"  VECTOR 0.75 0\n");
+       fprintf(f,"  VECTOR 0    0.75\n");
+       fprintf(f,"ENDLATTICE\n\n");
+       fprintf(f,"OBJECT UnitCell\n");
+       fprintf(f,"  MESHFILE %s\n",MeshFileName);
+       fprintf(f,"  MATERIAL PEC\n");
+       fprintf(f,"ENDOBJECT\n");
+       break;
+
+     case FAMILY_STATIC:
+       fprintf(f,"OBJECT UpperPlate\n");
+       fprintf(f,"  MESHFILE %s\n",MeshFileName);
+       fprintf(f,"  DISPLACED 0 0 1\n");
+       fprintf(f,"ENDOBJECT\n\n");
+       fprintf(f,"OBJECT LowerPlate\n");
+       fprintf(f,"  MESHFILE %s\n",MeshFileName);
+       fprintf(f,"ENDOBJECT\n");
+       break;
+
+     default:
+       ErrExit("%s:%i: internal error",__FILE__,__LINE__);
+   };
+
+  fclose(f);
+  return strdupEC(GeoFileName);
+}
+
+/***************************************************************/
+/* deterministic evaluation points: NX points spread evenly    */
+/* over a sphere of radius R (Fibonacci lattice), so that      */
+/* every run sees exactly the same inputs                      */
+/***************************************************************/
+static HMatrix *GetSpherePoints(int NX, double R)
+{
+  HMatrix *XMatrix = new HMatrix(NX, 3);
+  double GoldenAngle = M_PI*(3.0-sqrt(5.0));
+  for(int nx=0; nx<NX; nx++)
+   { double z   = 1.0 - (2.0*nx + 1.0)/NX;
+     double Rho = sqrt(1.0-z*z);
+     double Phi = GoldenAngle*nx;
+     XMatrix->SetEntry(nx, 0, R*Rho*cos(Phi));
+     XMatrix->SetEntry(nx, 1, R*Rho*sin(Phi));
+     XMatrix->SetEntry(nx, 2, R*z);
+   };
+  return XMatrix;
+}
+
+/***************************************************************/
+/* state shared by all kernels; each kernel fills in only the  */
+/* fields it needs                                             */
+/***************************************************************/
+typedef struct KernelState
+ {
+   cdouble Omega;
+   double kBloch[2];
+
+   RWGGeometry *G;
+   HMatrix *M, *M0;          // BEM matrix and pristine copy
+   HMatrix *RHS, *RHS0;      // multiple right-hand sides
+   HMatrix *XMatrix, *FMatrix;
+   HVector *KN;
+   PlaneWave *PW;
+   PFTOptions *PFTOpts;
+
+   StaticSolver *SS;
+   LayeredSubstrate *Substrate;
+
+ } KernelState;
+
+static KernelState *CreateKernelState(BenchOptions *BO)
+{
+  KernelState *KS = (KernelState *)mallocEC(sizeof(KernelState));
+  memset(KS, 0, sizeof(KernelState));
+  KS->Omega     = BO->Omega;
+  KS->kBloch[0] = 0.1;
+  KS->kBloch[1] = 0.2;
+  return KS;
+}
+
+static void DestroyKernelState(void *State)
+{
+  KernelState *KS=(KernelState *)State;
+  if (KS->M)         delete KS->M;
+  if (KS->M0)        delete KS->M0;
+  if (KS->RHS)       delete KS->RHS;
+  if (KS->RHS0)      delete KS->RHS0;
+  if (KS->XMatrix)   delete KS->XMatrix;
+  if (KS->FMatrix)   delete KS->FMatrix;
+  if (KS->KN)        delete KS->KN;
+  if (KS->PW)        delete KS->PW;
+  if (KS->PFTOpts)   free(KS->PFTOpts);
+  if (KS->SS)        delete KS->SS;
+  if (KS->G)         delete KS->G;
+  if (KS->Substrate) delete KS->Substrate;
+  free(KS);
+}
+
+static RWGGeometry *CreateBenchGeometry(BenchProblem *P, BenchOptions *BO)
+{
+  char *GeoFileName=WriteBenchGeometry(P, BO);
+  RWGGeometry *G = new RWGGeometry(GeoFileName);
+  free(GeoFileName);
+  return G;
+}
+
+/***************************************************************/
+/* dense BEM matrix assembly for a compact geometry ************/
+/***************************************************************/
+static void *SetupAssemble(BenchProblem *P, BenchOptions *BO, int *Size)
+{
+  KernelState *KS = CreateKernelState(BO);
+  KS->G = CreateBenchGeometry(P, BO);
+  KS->M = KS->G->AllocateBEMMatrix();
+  *Size = KS->G->TotalBFs;
+  return (void *)KS;
+}
+
+static void RunAssemble(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->G->AssembleBEMMatrix(KS->Omega, KS->M);
+}
+
+/***************************************************************/
+/* BEM matrix assembly for a periodic geometry; the periodic   */
+/* Green's function is evaluated via GBarAccelerator           */
+/***************************************************************/
+static void RunAssemblePBC(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->G->AssembleBEMMatrix(KS->Omega, KS->kBloch, KS->M);
+}
+
+/***************************************************************/
+/* LU factorization: the assembled matrix is restored from a   */
+/* pristine copy before each run                               */
+/***************************************************************/
+static void *SetupLUFactorize(BenchProblem *P, BenchOptions *BO, int *Size)
+{
+  KernelState *KS = (KernelState *)SetupAssemble(P, BO, Size);
+  KS->G->AssembleBEMMatrix(KS->Omega, KS->M);
+  KS->M0 = new HMatrix(KS->M);
+  return (void *)KS;
+}
+
+static void PrepareLUFactorize(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->M->Copy(KS->M0);
+}
+
+static void RunLUFactorize(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->M->LUFactorize();
+}
+
+/***************************************************************/
+/* back-substitution for many right-hand sides at once *********/
+/***************************************************************/
+static void *SetupLUSolve(BenchProblem *P, BenchOptions *BO, int *Size)
+{
+  KernelState *KS = (KernelState *)SetupAssemble(P, BO, Size);
+  KS->G->AssembleBEMMatrix(KS->Omega, KS->M);
+  KS->M->LUFactorize();
+
+  int NBF=KS->G->TotalBFs, NRHS=BO->NumRHS;
+  KS->RHS0 = new HMatrix(NBF, NRHS, LHM_COMPLEX);
+  for(int nr=0; nr<NBF; nr++)
+   for(int nc=0; nc<NRHS; nc++)
+    KS->RHS0->SetEntry(nr, nc, cos(0.1*(nr+1)*(nc+1)) + II*sin(0.3*(nr+nc)));
+  KS->RHS = new HMatrix(KS->RHS0);
+  return (void *)KS;
+}
+
+static void PrepareLUSolve(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->RHS->Copy(KS->RHS0);
+}
+
+static void RunLUSolve(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->M->LUSolve(KS->RHS);
+}
+
+/***************************************************************/
+/* matrix relating surface currents to scattered fields at a   */
+/* set of evaluation points                                    */
+/***************************************************************/
+static void *SetupGetRFMatrix(BenchProblem *P, BenchOptions *BO, int *Size)
+{
+  KernelState *KS = CreateKernelState(BO);
+  KS->G = CreateBenchGeometry(P, BO);
+  KS->XMatrix = GetSpherePoints(BO->NumEvalPoints, 2.0);
+  *Size = KS->G->TotalBFs;
+  return (void *)KS;
+}
+
+static void RunGetRFMatrix(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->FMatrix=KS->G->GetRFMatrix(KS->Omega, 0, KS->XMatrix, KS->FMatrix);
+}
+
+/***************************************************************/
+/* power, force, and torque on a sphere illuminated by a plane */
+/* wave, by the EMT and DSI methods                            */
+/***************************************************************/
+static void *SetupPFT(BenchProblem *P, BenchOptions *BO, int *Size, int PFTMethod)
+{
+  KernelState *KS = (KernelState *)SetupAssemble(P, BO, Size);
+  RWGGeometry *G = KS->G;
+
+  cdouble E0[3]={1.0, 0.0, 0.0};
+  double nHat[3]={0.0, 0.0, 1.0};
+  KS->PW = new PlaneWave(E0, nHat);
+
+  G->AssembleBEMMatrix(KS->Omega, KS->M);
+  KS->M->LUFactorize();
+  KS->KN = G->AssembleRHSVector(KS->Omega, KS->PW);
+  HVector *RHSVector = new HVector(KS->KN);
+  KS->M->LUSolve(KS->KN);
+
+  KS->PFTOpts            = InitPFTOptions();
+  KS->PFTOpts->PFTMethod = PFTMethod;
+  KS->PFTOpts->IF        = KS->PW;
+  KS->PFTOpts->RHSVector = RHSVector;  // freed by CleanupPFT
+  return (void *)KS;
+}
+
+static void *SetupEMTPFT(BenchProblem *P, BenchOptions *BO, int *Size)
+ { return SetupPFT(P, BO, Size, SCUFF_PFT_EMT); }
+
+static void *SetupDSIPFT(BenchProblem *P, BenchOptions *BO, int *Size)
+ { return SetupPFT(P, BO, Size, SCUFF_PFT_DSI); }
+
+static void RunPFT(void *State)
+{ KernelState *KS=(KernelState *)State;
+  double PFT[NUMPFT];
+  KS->G->GetPFT(0, KS->KN, KS->Omega, PFT, KS->PFTOpts);
+}
+
+static void CleanupPFT(void *State)
+{ KernelState *KS=(KernelState *)State;
+  if (KS->PFTOpts && KS->PFTOpts->RHSVector)
+   delete KS->PFTOpts->RHSVector;
+  DestroyKernelState(State);
+}
+
+/***************************************************************/
+/* full-wave dyadic Green's function of a grounded dielectric  */
+/* slab at a cloud of source/destination point pairs           */
+/***************************************************************/
+static void *SetupSubstrateDGF(BenchProblem *P, BenchOptions *BO, int *Size)
+{
+  KernelState *KS = CreateKernelState(BO);
+  KS->Substrate = CreateLayeredSubstrate("0.0 CONST_EPS_11.7\n -1.0 GROUNDPLANE\n");
+  if (KS->Substrate==0 || KS->Substrate->ErrMsg)
+   ErrExit("could not create substrate for benchmark");
+
+  int NX=P->NumPoints;
+  KS->XMatrix = new HMatrix(NX, 6);
+  for(int nx=0; nx<NX; nx++)
+   { double t = (nx+0.5)/NX;
+     KS->XMatrix->SetEntry(nx, 0, 0.5*cos(2.0*M_PI*t));
+     KS->XMatrix->SetEntry(nx, 1, 0.5*sin(2.0*M_PI*t));
+     KS->XMatrix->SetEntry(nx, 2, 0.1 + 0.4*t);
+     KS->XMatrix->SetEntry(nx, 3, 0.0);
+     KS->XMatrix->SetEntry(nx, 4, 0.0);
+     KS->XMatrix->SetEntry(nx, 5, 0.25);
+   };
+  KS->FMatrix = new HMatrix(36, NX, LHM_COMPLEX);
+  *Size = NX;
+  return (void *)KS;
+}
+
+static void RunSubstrateDGF(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->Substrate->GetSubstrateDGF(KS->Omega, KS->XMatrix, KS->FMatrix);
+}
+
+/***************************************************************/
+/* electrostatic BEM matrix assembly ***************************/
+/***************************************************************/
+static void *SetupStaticSolver(BenchProblem *P, BenchOptions *BO, int *Size)
+{
+  KernelState *KS = CreateKernelState(BO);
+  char *GeoFileName=WriteBenchGeometry(P, BO);
+  KS->SS = new StaticSolver(GeoFileName);
+  free(GeoFileName);
+  KS->M  = KS->SS->AllocateBEMMatrix();
+  *Size  = KS->M->NR;
+  return (void *)KS;
+}
+
+static void RunStaticSolver(void *State)
+{ KernelState *KS=(KernelState *)State;
+  KS->SS->AssembleBEMMatrix(KS->M);
+}
+
+/***************************************************************/
+/* table of kernels ********************************************/
+/***************************************************************/
+BenchKernel BenchKernels[]=
+ { { "Assemble",     FAMILY_COMPACT,  SetupAssemble,     0,                  RunAssemble,     DestroyKernelState },
+   { "AssemblePBC",  FAMILY_PERIODIC, SetupAssemble,     0,                  RunAssemblePBC,  DestroyKernelState },
+   { "LUFactorize",  FAMILY_COMPACT,  SetupLUFactorize,  PrepareLUFactorize, RunLUFactorize,  DestroyKernelState },
+   { "LUSolve",      FAMILY_COMPACT,  SetupLUSolve,      PrepareLUSolve,     RunLUSolve,      DestroyKernelState },
+   { "GetRFMatrix",  FAMILY_COMPACT,  SetupGetRFMatrix,  0,                  RunGetRFMatrix,  DestroyKernelState },
+   { "EMTPFT",       FAMILY_COMPACT,  SetupEMTPFT,       0,                  RunPFT,          CleanupPFT },
+   { "DSIPFT",       FAMILY_COMPACT,  SetupDSIPFT,       0,                  RunPFT,          CleanupPFT },
+   { "SubstrateDGF", FAMILY_POINTS,   SetupSubstrateDGF, 0,                  RunSubstrateDGF, DestroyKernelState },
+   { "StaticSolver", FAMILY_STATIC,   SetupStaticSolver, 0,                  RunStaticSolver, DestroyKernelState },
+   { 0, 0, 0, 0, 0, 0 }
+ };
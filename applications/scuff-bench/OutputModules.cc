@@ -0,0 +1,247 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * OutputModules.cc -- CSV, JSON, and scaling-curve output for
+ *                  -- scuff-bench, and comparison of results
+ *                  -- against a stored baseline
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scuff-bench.h"
+
+#define CSVHEADER "kernel,problem,size,threads,repeats,min_seconds,median_seconds,max_seconds,speedup,efficiency"
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void WriteCSVFile(const char *FileName, BenchResult *Results, int NumResults)
+{
+  FILE *f=fopen(FileName,"w");
+  if (!f)
+   ErrExit("could not open file %s",FileName);
+
+  fprintf(f,"%s\n",CSVHEADER);
+  for(int nr=0; nr<NumResults; nr++)
+   { BenchResult *R=Results+nr;
+     fprintf(f,"%s,%s,%i,%i,%i,%.6e,%.6e,%.6e,%.4f,%.4f\n",
+                R->Kernel, R->Problem, R->Size, R->NumThreads, R->NumRepeats,
+                R->MinTime, R->MedianTime, R->MaxTime,
+                R->Speedup, R->Efficiency);
+   };
+  fclose(f);
+  printf("Benchmark results written to %s.\n",FileName);
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void WriteJSONFile(const char *FileName, BenchResult *Results, int NumResults,
+                   BenchOptions *BO)
+{
+  FILE *f=fopen(FileName,"w");
+  if (!f)
+   ErrExit("could not open file %s",FileName);
+
+  fprintf(f,"{\n");
+  fprintf(f,"  \"host\": \"%s\",\n",GetHostName());
+  fprintf(f,"  \"date\": \"%s\",\n",GetTimeString());
+  fprintf(f,"  \"omega\": [%e, %e],\n",real(BO->Omega),imag(BO->Omega));
+  fprintf(f,"  \"results\": [");
+  for(int nr=0; nr<NumResults; nr++)
+   { BenchResult *R=Results+nr;
+     fprintf(f,"%s\n    { \"kernel\": \"%s\", \"problem\": \"%s\", ",
+                nr==0 ? "" : ",", R->Kernel, R->Problem);
+     fprintf(f,"\"size\": %i, \"threads\": %i, \"repeats\": %i,\n",
+                R->Size, R->NumThreads, R->NumRepeats);
+     fprintf(f,"      \"min_seconds\": %.6e, \"median_seconds\": %.6e, \"max_seconds\": %.6e,\n",
+                R->MinTime, R->MedianTime, R->MaxTime);
+     fprintf(f,"      \"speedup\": %.4f, \"efficiency\": %.4f }",
+                R->Speedup, R->Efficiency);
+   };
+  fprintf(f,"\n  ]\n}\n");
+  fclose(f);
+  printf("Benchmark results written to %s.\n",FileName);
+}
+
+/***************************************************************/
+/* scaling curves in gnuplot-friendly form: one data block     */
+/* (separated by two blank lines, so that blocks may be        */
+/* selected with gnuplot's 'index' keyword) per curve.         */
+/*                                                             */
+/* strong-scaling blocks (one per kernel and problem):         */
+/*  1 threads  2 median time  3 speedup  4 efficiency          */
+/*                                                             */
+/* size-scaling blocks (one per kernel and thread count):      */
+/*  1 problem size  2 median time                              */
+/***************************************************************/
+void WriteScalingFile(const char *FileName, BenchResult *Results, int NumResults)
+{
+  FILE *f=fopen(FileName,"w");
+  if (!f)
+   ErrExit("could not open file %s",FileName);
+
+  int NumBlocks=0;
+  bool *Done = (bool *)mallocEC(NumResults*sizeof(bool));
+
+  // strong scaling
+  memset(Done, 0, NumResults*sizeof(bool));
+  for(int nr=0; nr<NumResults; nr++)
+   { if (Done[nr]) continue;
+     BenchResult *R=Results+nr;
+     fprintf(f,"%s# index %i: thread scaling, %s on %s (size %i)\n",
+                NumBlocks==0 ? "" : "\n\n", NumBlocks, R->Kernel, R->Problem, R->Size);
+     fprintf(f,"# 1 threads  2 median time (s)  3 speedup  4 efficiency\n");
+     for(int mr=nr; mr<NumResults; mr++)
+      { BenchResult *RR=Results+mr;
+        if ( strcmp(RR->Kernel,R->Kernel) || strcmp(RR->Problem,R->Problem) )
+         continue;
+        fprintf(f,"%i %e %e %e\n",RR->NumThreads,RR->MedianTime,RR->Speedup,RR->Efficiency);
+        Done[mr]=true;
+      };
+     NumBlocks++;
+   };
+
+  // size scaling
+  memset(Done, 0, NumResults*sizeof(bool));
+  for(int nr=0; nr<NumResults; nr++)
+   { if (Done[nr]) continue;
+     BenchResult *R=Results+nr;
+     fprintf(f,"\n\n# index %i: size scaling, %s with %i threads\n",
+                NumBlocks, R->Kernel, R->NumThreads);
+     fprintf(f,"# 1 problem size  2 median time (s)\n");
+     for(int mr=nr; mr<NumResults; mr++)
+      { BenchResult *RR=Results+mr;
+        if ( strcmp(RR->Kernel,R->Kernel) || RR->NumThreads!=R->NumThreads )
+         continue;
+        fprintf(f,"%i %e\n",RR->Size,RR->MedianTime);
+        Done[mr]=true;
+      };
+     NumBlocks++;
+   };
+
+  free(Done);
+  fclose(f);
+  printf("Scaling curves written to %s.\n",FileName);
+}
+
+/***************************************************************/
+/* compare median timings against a baseline CSV file written  */
+/* by a previous run. A result regresses if its median time    */
+/* exceeds the baseline median by more than the tolerance for  */
+/* its kernel (a fraction, e.g. 0.1 = 10%). Results with no    */
+/* matching baseline entry are reported but not counted.       */
+/* Returns the number of regressions.                          */
+/***************************************************************/
+int CompareToBaseline(const char *BaselineFile,
+                      BenchResult *Results, int NumResults,
+                      double DefaultTolerance,
+                      char **KernelTolerances, int NumKernelTolerances)
+{
+  FILE *f=fopen(BaselineFile,"r");
+  if (!f)
+   ErrExit("could not open baseline file %s",BaselineFile);
+
+  /*--------------------------------------------------------------*/
+  /*- read baseline entries --------------------------------------*/
+  /*--------------------------------------------------------------*/
+  int NumBaseline=0, MaxBaseline=0;
+  BenchResult *Baseline=0;
+  char Line[MAXSTR];
+  int LineNum=0;
+  while( fgets(Line,MAXSTR,f) )
+   { LineNum++;
+     if ( Line[0]=='#' || !strncmp(Line,"kernel,",7) ) continue;
+
+     char *Tokens[10];
+     int nTokens=0;
+     for(char *s=strtok(Line,",\n"); s && nTokens<10; s=strtok(0,",\n"))
+      Tokens[nTokens++]=s;
+     if (nTokens==0) continue;
+     if (nTokens!=10)
+      ErrExit("%s:%i: syntax error",BaselineFile,LineNum);
+
+     if (NumBaseline==MaxBaseline)
+      { MaxBaseline = (MaxBaseline==0 ? 64 : 2*MaxBaseline);
+        Baseline = (BenchResult *)reallocEC(Baseline, MaxBaseline*sizeof(BenchResult));
+      };
+     BenchResult *B=Baseline + NumBaseline++;
+     B->Kernel     = strdupEC(Tokens[0]);
+     B->Problem    = strdupEC(Tokens[1]);
+     B->Size       = atoi(Tokens[2]);
+     B->NumThreads = atoi(Tokens[3]);
+     B->MedianTime = strtod(Tokens[6],0);
+   };
+  fclose(f);
+  Log("Read %i entries from baseline file %s.",NumBaseline,BaselineFile);
+
+  /*--------------------------------------------------------------*/
+  /*- compare ----------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  int NumRegressions=0;
+  printf("\nComparison to baseline %s:\n",BaselineFile);
+  printf("%-14s %-18s %7s %12s %12s %8s  %s\n",
+         "kernel","problem","threads","baseline(s)","current(s)","ratio","status");
+  for(int nr=0; nr<NumResults; nr++)
+   {
+     BenchResult *R=Results+nr;
+
+     double Tolerance=DefaultTolerance;
+     for(int nkt=0; nkt<NumKernelTolerances; nkt++)
+      if ( !StrCaseCmp(KernelTolerances[2*nkt],R->Kernel) )
+       Tolerance=strtod(KernelTolerances[2*nkt+1],0);
+
+     BenchResult *B=0;
+     for(int nb=0; nb<NumBaseline && B==0; nb++)
+      if (    !strcmp(Baseline[nb].Kernel,R->Kernel)
+           && !strcmp(Baseline[nb].Problem,R->Problem)
+           && Baseline[nb].NumThreads==R->NumThreads
+         ) B=Baseline+nb;
+
+     if (B==0)
+      { printf("%-14s %-18s %7i %12s %12.4e %8s  %s\n",
+               R->Kernel,R->Problem,R->NumThreads,"-",R->MedianTime,"-","no baseline");
+        continue;
+      };
+
+     double Ratio = R->MedianTime / B->MedianTime;
+     const char *Status="ok";
+     if (Ratio > 1.0+Tolerance)
+      { Status="REGRESSION";
+        NumRegressions++;
+        Log("Regression: %s on %s with %i threads: %e s (baseline %e s)",
+             R->Kernel,R->Problem,R->NumThreads,R->MedianTime,B->MedianTime);
+      }
+     else if (Ratio < 1.0-Tolerance)
+      Status="improved";
+     printf("%-14s %-18s %7i %12.4e %12.4e %8.3f  %s\n",
+             R->Kernel,R->Problem,R->NumThreads,B->MedianTime,R->MedianTime,Ratio,Status);
+   };
+
+  for(int nb=0; nb<NumBaseline; nb++)
+   { free((char *)Baseline[nb].Kernel);
+     free((char *)Baseline[nb].Problem);
+   };
+  free(Baseline);
+
+  printf("%i regression%s.\n",NumRegressions,NumRegressions==1 ? "" : "s");
+  return NumRegressions;
+}
@@ -0,0 +1,249 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * scuff-bench.cc -- a standalone code within the scuff-EM suite for
+ *                -- timing the core computational kernels on a set of
+ *                -- reference problems, over a range of thread counts
+ *                -- and problem sizes, and for detecting performance
+ *                -- regressions against a stored baseline
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scuff-bench.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef USE_OPENMP
+#  include <omp.h>
+#endif
+
+#ifndef SCUFF_BENCH_MESHDIR
+#  define SCUFF_BENCH_MESHDIR "."
+#endif
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+static void SetBenchThreads(int NumThreads)
+{
+  SetNumThreads(NumThreads);
+#ifdef USE_OPENMP
+  omp_set_num_threads(NumThreads);
+#endif
+}
+
+static int CompareDoubles(const void *a, const void *b)
+{ double da=*(const double *)a, db=*(const double *)b;
+  return (da<db) ? -1 : (da>db) ? 1 : 0;
+}
+
+static int CompareInts(const void *a, const void *b)
+{ return *(const int *)a - *(const int *)b; }
+
+/***************************************************************/
+/* time one kernel on one problem at each thread count; an     */
+/* untimed warmup run precedes the timed runs at each count,   */
+/* so caches (FIPPI, TBlock, etc.) are warm in every sample    */
+/***************************************************************/
+static int RunBenchmark(BenchKernel *K, BenchProblem *P, BenchOptions *BO,
+                        int *ThreadCounts, int NumThreadCounts,
+                        int NumRepeats, BenchResult *Results)
+{
+  Log("Setting up %s on %s...",K->Name,P->Name);
+  int Size=0;
+  void *State=K->Setup(P, BO, &Size);
+
+  double *Times = (double *)mallocEC(NumRepeats*sizeof(double));
+  for(int ntc=0; ntc<NumThreadCounts; ntc++)
+   {
+     int NumThreads=ThreadCounts[ntc];
+     SetBenchThreads(NumThreads);
+
+     if (K->Prepare) K->Prepare(State);
+     K->Run(State);
+
+     for(int nr=0; nr<NumRepeats; nr++)
+      { if (K->Prepare) K->Prepare(State);
+        double T0=Secs();
+        K->Run(State);
+        Times[nr]=Secs()-T0;
+      };
+     qsort(Times, NumRepeats, sizeof(double), CompareDoubles);
+
+     BenchResult *R = Results + ntc;
+     R->Kernel     = K->Name;
+     R->Problem    = P->Name;
+     R->Size       = Size;
+     R->NumThreads = NumThreads;
+     R->NumRepeats = NumRepeats;
+     R->MinTime    = Times[0];
+     R->MaxTime    = Times[NumRepeats-1];
+     R->MedianTime = (NumRepeats%2) ? Times[NumRepeats/2]
+                                    : 0.5*(Times[NumRepeats/2-1] + Times[NumRepeats/2]);
+     R->Speedup    = Results[0].MedianTime / R->MedianTime;
+     R->Efficiency = R->Speedup * Results[0].NumThreads / NumThreads;
+
+     printf("%-14s %-18s %7i %7i %12.4e %8.2f %8.2f\n",
+             K->Name, P->Name, Size, NumThreads, R->MedianTime,
+             R->Speedup, R->Efficiency);
+     Log(" %s(%s,%i threads): median %e s (min %e, max %e)",
+          K->Name, P->Name, NumThreads, R->MedianTime, R->MinTime, R->MaxTime);
+   };
+
+  free(Times);
+  K->Cleanup(State);
+  return NumThreadCounts;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  InstallHRSignalHandler();
+  InitializeLog(argv[0]);
+
+  /***************************************************************/
+  /* process options *********************************************/
+  /***************************************************************/
+  char *MeshDir=0;
+  char *Kernels[MAXKERNELS];              int nKernels=0;
+  int ThreadCounts[MAXTHREADCOUNTS];      int nThreadCounts=0;
+  int Levels=2;
+  int NumRepeats=3;
+  cdouble Omega=1.0;
+  int NumRHS=16;
+  int NumEvalPoints=1000;
+  char *FileBase=0;
+  char *Baseline=0;
+  double Tolerance=0.10;
+  char *KernelTolerances[2*MAXTOLERANCES]; int nKernelTolerances=0;
+  bool ListKernels=false;
+  /* name               type    #args  max_instances  storage           count         description*/
+  OptStruct OSArray[]=
+   { {"MeshDir",        PA_STRING,  1, 1,               (void *)&MeshDir,         0,                "location of the scuff-em examples/ directory"},
+     {"Kernel",         PA_STRING,  1, MAXKERNELS,      (void *)Kernels,          &nKernels,        "kernel to benchmark (default: all)"},
+     {"ListKernels",    PA_BOOL,    0, 1,               (void *)&ListKernels,     0,                "list available kernels and exit\n"},
+/**/
+     {"NumThreads",     PA_INT,     1, MAXTHREADCOUNTS, (void *)ThreadCounts,     &nThreadCounts,   "thread count (default: 1 and all available)"},
+     {"Levels",         PA_INT,     1, 1,               (void *)&Levels,          0,                "number of mesh refinements per problem (default: 2)"},
+     {"NumRepeats",     PA_INT,     1, 1,               (void *)&NumRepeats,      0,                "number of timed runs per data point (default: 3)"},
+     {"Omega",          PA_CDOUBLE, 1, 1,               (void *)&Omega,           0,                "angular frequency (default: 1)"},
+     {"NumRHS",         PA_INT,     1, 1,               (void *)&NumRHS,          0,                "number of right-hand sides for LUSolve (default: 16)"},
+     {"NumEvalPoints",  PA_INT,     1, 1,               (void *)&NumEvalPoints,   0,                "number of evaluation points for GetRFMatrix (default: 1000)\n"},
+/**/
+     {"FileBase",       PA_STRING,  1, 1,               (void *)&FileBase,        0,                "base name for output files (default: scuff-bench)"},
+     {"Baseline",       PA_STRING,  1, 1,               (void *)&Baseline,        0,                "CSV file from a previous run to compare against"},
+     {"Tolerance",      PA_DOUBLE,  1, 1,               (void *)&Tolerance,       0,                "allowed fractional slowdown relative to baseline (default: 0.1)"},
+     {"KernelTolerance", PA_STRING, 2, MAXTOLERANCES,   (void *)KernelTolerances, &nKernelTolerances, "per-kernel override of --Tolerance (name, value)"},
+/**/
+     {0,0,0,0,0,0,0}
+   };
+  ProcessOptions(argc, argv, OSArray);
+
+  if (ListKernels)
+   { for(int nk=0; BenchKernels[nk].Name; nk++)
+      printf("%s\n",BenchKernels[nk].Name);
+     return 0;
+   };
+
+  if (NumRepeats<1)
+   ErrExit("--NumRepeats must be positive");
+  if (Levels<1)
+   ErrExit("--Levels must be positive");
+
+  for(int nk=0; nk<nKernels; nk++)
+   { bool Found=false;
+     for(int mk=0; BenchKernels[mk].Name && !Found; mk++)
+      Found = !StrCaseCmp(Kernels[nk],BenchKernels[mk].Name);
+     if (!Found)
+      ErrExit("unknown kernel %s (use --ListKernels for a list)",Kernels[nk]);
+   };
+
+  if (nThreadCounts==0)
+   { ThreadCounts[nThreadCounts++]=1;
+     if (GetNumThreads()>1)
+      ThreadCounts[nThreadCounts++]=GetNumThreads();
+   };
+  qsort(ThreadCounts, nThreadCounts, sizeof(int), CompareInts);
+  for(int ntc=0; ntc<nThreadCounts; ntc++)
+   if (ThreadCounts[ntc]<1)
+    ErrExit("invalid thread count %i",ThreadCounts[ntc]);
+
+  BenchOptions MyBO, *BO=&MyBO;
+  BO->MeshDir       = MeshDir ? MeshDir : (char *)SCUFF_BENCH_MESHDIR;
+  BO->Omega         = Omega;
+  BO->NumRHS        = NumRHS;
+  BO->NumEvalPoints = NumEvalPoints;
+
+  if (!FileBase)
+   FileBase=strdupEC("scuff-bench");
+
+  /***************************************************************/
+  /* run all selected kernels on all selected problems          */
+  /***************************************************************/
+  int MaxResults=0;
+  for(int nk=0; BenchKernels[nk].Name; nk++)
+   for(int np=0; BenchProblems[np].Name; np++)
+    MaxResults+=nThreadCounts;
+  BenchResult *Results=(BenchResult *)mallocEC(MaxResults*sizeof(BenchResult));
+  int NumResults=0;
+
+  printf("%-14s %-18s %7s %7s %12s %8s %8s\n",
+         "kernel","problem","size","threads","median(s)","speedup","effic.");
+  for(int nk=0; BenchKernels[nk].Name; nk++)
+   {
+     BenchKernel *K=BenchKernels+nk;
+     bool Selected=(nKernels==0);
+     for(int mk=0; mk<nKernels && !Selected; mk++)
+      Selected = !StrCaseCmp(Kernels[mk],K->Name);
+     if (!Selected) continue;
+
+     for(int np=0; BenchProblems[np].Name; np++)
+      { BenchProblem *P=BenchProblems+np;
+        if (P->Family!=K->Family || P->Level>=Levels) continue;
+        NumResults+=RunBenchmark(K, P, BO, ThreadCounts, nThreadCounts,
+                                 NumRepeats, Results+NumResults);
+      };
+   };
+
+  /***************************************************************/
+  /* compare to baseline and write output files. the comparison  */
+  /* comes first, since the baseline file may be one of the      */
+  /* output files of an earlier run with the same --FileBase     */
+  /* (which is then updated in place).                           */
+  /***************************************************************/
+  int NumRegressions=0;
+  if (Baseline)
+   NumRegressions=CompareToBaseline(Baseline, Results, NumResults, Tolerance,
+                                    KernelTolerances, nKernelTolerances);
+
+  WriteCSVFile(vstrdup("%s.csv",FileBase), Results, NumResults);
+  WriteJSONFile(vstrdup("%s.json",FileBase), Results, NumResults, BO);
+  WriteScalingFile(vstrdup("%s.scaling",FileBase), Results, NumResults);
+
+  free(Results);
+  printf("Thank you for your support.\n");
+  return NumRegressions ? 1 : 0;
+}
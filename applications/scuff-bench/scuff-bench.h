@@ -0,0 +1,117 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * scuff-bench.h  -- header file for scuff-bench, a performance
+ *                -- benchmark and regression harness for scuff-em
+ */
+#ifndef SCUFFBENCH_H
+#define SCUFFBENCH_H
+
+#include <libhrutil.h>
+#include <libhmat.h>
+#include <libIncField.h>
+#include <libscuff.h>
+#include <libSubstrate.h>
+#include <StaticSolver.h>
+
+using namespace scuff;
+
+#define MAXTHREADCOUNTS 16
+#define MAXKERNELS      16
+#define MAXTOLERANCES   16
+
+/***************************************************************/
+/* the reference problems are grouped into families; each      */
+/* kernel runs on all refinements of one family                */
+/***************************************************************/
+#define FAMILY_COMPACT   0  // dielectric sphere
+#define FAMILY_PERIODIC  1  // perforated PEC film, 2D lattice
+#define FAMILY_STATIC    2  // two-plate capacitor
+#define FAMILY_POINTS    3  // clouds of evaluation points
+
+typedef struct BenchProblem
+ { int Family;
+   int Level;             // 0 = coarsest refinement in family
+   const char *Name;
+   const char *MeshFile;  // relative to the mesh directory
+   int NumPoints;         // FAMILY_POINTS only
+ } BenchProblem;
+
+extern BenchProblem BenchProblems[];
+
+/***************************************************************/
+/* options shared by all kernels *******************************/
+/***************************************************************/
+typedef struct BenchOptions
+ { char *MeshDir;
+   cdouble Omega;
+   int NumRHS;            // right-hand sides for LUSolve
+   int NumEvalPoints;     // evaluation points for GetRFMatrix
+ } BenchOptions;
+
+/***************************************************************/
+/* a benchmark kernel is a set of callbacks: Setup builds the  */
+/* problem and returns an opaque state, Prepare (which may be  */
+/* NULL) restores the inputs before each run, Run is the timed */
+/* region, and Cleanup releases the state.                     */
+/***************************************************************/
+typedef struct BenchKernel
+ { const char *Name;
+   int Family;
+   void *(*Setup)(BenchProblem *P, BenchOptions *BO, int *Size);
+   void (*Prepare)(void *State);
+   void (*Run)(void *State);
+   void (*Cleanup)(void *State);
+ } BenchKernel;
+
+extern BenchKernel BenchKernels[];
+
+/***************************************************************/
+/* timing results for one (kernel, problem, thread count)      */
+/***************************************************************/
+typedef struct BenchResult
+ { const char *Kernel;
+   const char *Problem;
+   int Size;              // unknowns, panels, or points
+   int NumThreads;
+   int NumRepeats;
+   double MinTime, MedianTime, MaxTime;
+   double Speedup;        // relative to fewest threads
+   double Efficiency;     // Speedup * (fewest threads) / NumThreads
+ } BenchResult;
+
+/***************************************************************/
+/* Kernels.cc **************************************************/
+/***************************************************************/
+char *WriteBenchGeometry(BenchProblem *P, BenchOptions *BO);
+
+/***************************************************************/
+/* OutputModules.cc ********************************************/
+/***************************************************************/
+void WriteCSVFile(const char *FileName, BenchResult *Results, int NumResults);
+void WriteJSONFile(const char *FileName, BenchResult *Results, int NumResults,
+                   BenchOptions *BO);
+void WriteScalingFile(const char *FileName, BenchResult *Results, int NumResults);
+int CompareToBaseline(const char *BaselineFile,
+                      BenchResult *Results, int NumResults,
+                      double DefaultTolerance,
+                      char **KernelTolerances, int NumKernelTolerances);
+
+#endif // SCUFFBENCH_H
@@ -30,13 +30,6 @@
 
 #include "libTDRT.h"
 
-#ifdef HAVE_CONFIG_H
-#  include "config.h"
-#endif
-#ifdef USE_PTHREAD
-#  include <pthread.h>
-#endif
-
 #define II cdouble(0,1)
 
 #define FORMULATION_EFIE  0
@@ -56,7 +49,7 @@ typedef struct ThreadData
    HMatrix *T;
 
    /* these fields used by both */
-   int nt, NumTasks;
+   int NextRow; // shared among threads; see ClaimTDRTTask
    double Xi, q;
    double EpsOut, MuOut, EpsIn, MuIn;
    StaticSSIDataTable *SSSIDT;
@@ -85,7 +78,7 @@ static void *AssembleU_Thread(void *data)
   StaticSSIDataTable *SSSIDT = TD->SSSIDT;
 
   /* other local variables */
-  int niva, NIVa, nivb, NIVb, nt, IndexA, IndexB;
+  int niva, NIVa, nivb, NIVb, IndexA, IndexB;
   double Kappa, Kappa2, Z, KZ, KoZ;
   int Formulation;
   LFBuffer LBuf, *L=&LBuf;
@@ -108,21 +101,6 @@ static void *AssembleU_Thread(void *data)
   else  
    Formulation=FORMULATION_PMCHW;
 
-  /*--------------------------------------------------------------*/
-  /*- EXPERIMENTAL -----------------------------------------------*/
-  /*--------------------------------------------------------------*/
-#ifdef USE_PTHREAD
-#ifdef _GNU_SOURCE
-  cpu_set_t cpuset;
-  CPU_ZERO(&cpuset);
-  CPU_SET(TD->nt,&cpuset);
-  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
-#endif
-#endif
-  /*--------------------------------------------------------------*/
-  /*- EXPERIMENTAL -----------------------------------------------*/
-  /*--------------------------------------------------------------*/
-
   /****************************************************************/ 
   /*- loop over all control points (interior vertices) on both   -*/
   /*- objects; for each pair of control points, compute the      -*/
@@ -130,13 +108,9 @@ static void *AssembleU_Thread(void *data)
   /*- pair of control points and stamp them into their proper    -*/
   /*- slots in the U matrix                                      -*/
   /****************************************************************/  
-  nt=0;
-  for(niva=0; niva<NIVa; niva++)
+  while( (niva=ClaimTDRTTask(&(TD->NextRow))) < NIVa )
    for(nivb=0; nivb<NIVb; nivb++)
     { 
-      nt++;
-      if (nt==TD->NumTasks) nt=0;
-      if (nt!=TD->nt) continue;
 
       /* get the L functions for all basis functions associated with */
       /* this pair of control points                                 */
@@ -276,70 +250,23 @@ void AssembleU(TDRTObject *Oa, TDRTObject *Ob, double Xi, double q,
   else
    ErrExit("mixed PEC / dielectric geometries not supported");
 
-  Log("Assembling U(%s,%s) at (Xi,q)=(%e,%e)",Oa->Label,Ob->Label,Xi,q);
-#ifdef USE_PTHREAD
-  ThreadData *TDs = new ThreadData[NumThreads], *TD;
-  pthread_t *Threads = new pthread_t[NumThreads];
-  Log(" POSIX multithreading (%i threads)",NumThreads);
-  for(int nt=0; nt<NumThreads; nt++)
-   { 
-     TD=&(TDs[nt]);
-     TD->nt=nt;
-     TD->NumTasks=NumThreads;
-
-     TD->SSSIDT=SSSIDT;
-     TD->Oa=Oa;
-     TD->Ob=Ob;
-     TD->Xi=Xi;
-     TD->q=q;
-     TD->EpsOut=EpsOut;
-     TD->MuOut=MuOut;
-     TD->EpsIn=EpsIn;
-     TD->U=U;
-     TD->dUdX=dUdX;
-     TD->dUdY=dUdY;
-
-     if (nt+1 == NumThreads)
-       AssembleU_Thread((void *)TD);
-     else
-       pthread_create( &(Threads[nt]), 0, AssembleU_Thread, (void *)TD);
-   }
-
-  for(int nt=0; nt<NumThreads-1; nt++)
-   pthread_join(Threads[nt],0);
-
-  delete[] Threads;
-  delete[] TDs;
-
-#else 
-#ifndef USE_OPENMP
-  int NumTasks=NumThreads=1;
-#else
-  int NumTasks=NumThreads*100;
-  Log(" OpenMP multithreading (%i/%i threads/tasks)",NumThreads/NumTasks);
-#pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads)
-#endif
-  for(int nt=0; nt<NumTasks; nt++)
-   { 
-     ThreadData TD1;
-     TD1.nt=nt;
-     TD1.NumTasks=NumTasks;
-
-     TD1.SSSIDT=SSSIDT;
-     TD1.Oa=Oa;
-     TD1.Ob=Ob;
-     TD1.Xi=Xi;
-     TD1.q=q;
-     TD1.EpsOut=EpsOut;
-     TD1.MuOut=MuOut;
-     TD1.EpsIn=EpsIn;
-     TD1.U=U;
-     TD1.dUdX=dUdX;
-     TD1.dUdY=dUdY;
-
-     AssembleU_Thread((void *)&TD1);
-   };
-#endif
+  Log("Assembling U(%s,%s) at (Xi,q)=(%e,%e) (%i threads)",
+       Oa->Label,Ob->Label,Xi,q,NumThreads);
+
+  ThreadData MyTD, *TD=&MyTD;
+  TD->NextRow=0;
+  TD->SSSIDT=SSSIDT;
+  TD->Oa=Oa;
+  TD->Ob=Ob;
+  TD->Xi=Xi;
+  TD->q=q;
+  TD->EpsOut=EpsOut;
+  TD->MuOut=MuOut;
+  TD->EpsIn=EpsIn;
+  TD->U=U;
+  TD->dUdX=dUdX;
+  TD->dUdY=dUdY;
+  RunTDRTTaskPool(AssembleU_Thread, (void *)TD, NumThreads);
 
 }
 
@@ -386,7 +313,7 @@ static void *AssembleT_Thread(void *data)
   StaticSSIDataTable *SSSIDT = TD->SSSIDT;
 
   /* other local variables */
-  int niva, nivb, NIV, nt, IndexA, IndexB;
+  int niva, nivb, NIV, IndexA, IndexB;
   int Formulation;
 
   double KappaOut2, KappaOut, ZOut, KZOut, KoZOut;
@@ -414,28 +341,9 @@ static void *AssembleT_Thread(void *data)
      KoZIn=KappaIn/ZIn;
    };
 
-  /*--------------------------------------------------------------*/
-  /*- EXPERIMENTAL -----------------------------------------------*/
-  /*--------------------------------------------------------------*/
-#ifdef USE_PTHREAD
-#ifdef _GNU_SOURCE
-  cpu_set_t cpuset;
-  CPU_ZERO(&cpuset);
-  CPU_SET(TD->nt,&cpuset);
-  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
-#endif
-#endif
-  /*--------------------------------------------------------------*/
-  /*- EXPERIMENTAL -----------------------------------------------*/
-  /*--------------------------------------------------------------*/
-
-  nt=0;
-  for(niva=0; niva<NIV; niva++)
+  while( (niva=ClaimTDRTTask(&(TD->NextRow))) < NIV )
    for(nivb=niva; nivb<NIV; nivb++)
     { 
-      nt++;
-      if (nt==TD->NumTasks) nt=0;
-      if (nt!=TD->nt) continue;
 
   
       if ( Formulation == FORMULATION_EFIE )
@@ -538,66 +446,19 @@ void AssembleT(TDRTObject *O, double Xi, double q,
      EpsIn = real(zEps);
      MuIn  = real(zMu);
    };
-  Log("Assembling T(%s) at (Xi,q)=(%e,%e)",O->Label,Xi,q);
-
-#ifdef USE_PTHREAD
-  Log(" POSIX multithreading (%i threads)",NumThreads);
-  ThreadData *TDs = new ThreadData[NumThreads], *TD;
-  pthread_t *Threads = new pthread_t[NumThreads];
-  for(int nt=0; nt<NumThreads; nt++)
-   { 
-     TD=&(TDs[nt]);
-     TD->nt=nt;
-     TD->NumTasks=NumThreads;
-
-     TD->SSSIDT=SSSIDT;
-     TD->O=O;
-     TD->Xi=Xi;
-     TD->q=q;
-     TD->EpsOut=EpsOut;
-     TD->MuOut=MuOut;
-     TD->EpsIn=EpsIn;
-     TD->MuIn=MuIn;
-     TD->T=T;
-
-     if (nt+1 == NumThreads)
-       AssembleT_Thread((void *)TD);
-     else
-       pthread_create( &(Threads[nt]), 0, AssembleT_Thread, (void *)TD);
-   }
-
-  for(int nt=0; nt<NumThreads-1; nt++)
-   pthread_join(Threads[nt],0);
-
-  delete[] Threads;
-  delete[] TDs;
-
-#else 
-#ifndef USE_OPENMP
-  int NumTasks=NumThreads=1;
-#else
-  int NumTasks=NumThreads*100;
-  Log(" OpenMP multithreading (%i/%i threads/tasks)",NumThreads/NumTasks);
-#pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads)
-#endif
-  for(int nt=0; nt<NumTasks; nt++)
-   { 
-     ThreadData TD1;
-     TD1.nt=nt;
-     TD1.NumTasks=NumTasks;
-
-     TD1.SSSIDT=SSSIDT;
-     TD1.O=O;
-     TD1.Xi=Xi;
-     TD1.q=q;
-     TD1.EpsOut=EpsOut;
-     TD1.MuOut=MuOut;
-     TD1.EpsIn=EpsIn;
-     TD1.MuIn=MuIn;
-     TD1.T=T;
-
-     AssembleT_Thread((void *)&TD1);
-   };
-#endif
+  Log("Assembling T(%s) at (Xi,q)=(%e,%e) (%i threads)",O->Label,Xi,q,NumThreads);
+
+  ThreadData MyTD, *TD=&MyTD;
+  TD->NextRow=0;
+  TD->SSSIDT=SSSIDT;
+  TD->O=O;
+  TD->Xi=Xi;
+  TD->q=q;
+  TD->EpsOut=EpsOut;
+  TD->MuOut=MuOut;
+  TD->EpsIn=EpsIn;
+  TD->MuIn=MuIn;
+  TD->T=T;
+  RunTDRTTaskPool(AssembleT_Thread, (void *)TD, NumThreads);
 
 }
@@ -7,9 +7,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "libhrutil.h"
 #include "libTDRT.h"
@@ -17,9 +22,6 @@
 #ifdef HAVE_CONFIG_H
 #  include "config.h"
 #endif
-#ifdef USE_PTHREAD
-#  include <pthread.h>
-#endif
 
 /*******************************************************************/
 /* function that returns 1 if the two edges are nearby each other **/
@@ -139,7 +141,7 @@ typedef struct ThreadData
    TDRTObject *Oa, *Ob;
    StaticSSIDataTable *SSSIDT;
 
-   int nt, NumTasks;
+   int NextRow; // shared among threads; see ClaimTDRTTask
 
  } ThreadData;
 
@@ -160,17 +162,12 @@ void *CreateStaticSSIDataTable_Thread(void *pTD)
   int iCVb, iEV1b, iEV2b;
   double *CVb, *EV1b, *EV2b;
   StaticSSIDataRecord *SSSIDR;
-  int nt;
 
   NeedDerivatives = (Oa==Ob ? 0 : 1);
   
-  nt=0;
-  for(niva=0; niva<Oa->NumIVs; niva++)
+  while( (niva=ClaimTDRTTask(&(TD->NextRow))) < Oa->NumIVs )
    for(nivb=(Oa==Ob ? niva : 0); nivb<Ob->NumIVs; nivb++)
     {
-      nt++;
-      if (nt==TD->NumTasks) nt=0;
-      if (nt!=TD->nt) continue;
 
       /*--------------------------------------------------------------*/
       /*--------------------------------------------------------------*/
@@ -211,6 +208,42 @@ if (TDRTGeometry::LogLevel>=2)
   return 0;
 }
 
+/*******************************************************************/
+/* hash of everything that determines the contents of the table    */
+/* for a given pair of objects: the vertex coordinates (in their   */
+/* current, possibly transformed, positions) and the basis-function*/
+/* connectivity of both objects.                                   */
+/*******************************************************************/
+static unsigned long long HashBytes(unsigned long long Hash,
+                                    const void *Data, size_t Size)
+{ const unsigned char *Bytes=(const unsigned char *)Data;
+  for(size_t n=0; n<Size; n++)
+   { Hash ^= Bytes[n];
+     Hash *= 1099511628211ULL; // 64-bit FNV-1a
+   };
+  return Hash;
+}
+
+static unsigned long long GetStaticSSIDataTableHash(TDRTObject *Oa, TDRTObject *Ob)
+{
+  unsigned long long Hash=14695981039346656037ULL;
+  int Header[2];
+  Header[0] = (Oa==Ob);
+  Header[1] = sizeof(StaticSSIDataRecord);
+  double Radius = DESINGULARIZATION_RADIUS;
+  Hash=HashBytes(Hash, Header, sizeof(Header));
+  Hash=HashBytes(Hash, &Radius, sizeof(double));
+  for(int n=0; n<(Oa==Ob ? 1 : 2); n++)
+   { TDRTObject *O = (n==0 ? Oa : Ob);
+     Hash=HashBytes(Hash, &(O->NumVertices), sizeof(int));
+     Hash=HashBytes(Hash, &(O->NumIVs), sizeof(int));
+     Hash=HashBytes(Hash, O->Vertices, 2*O->NumVertices*sizeof(double));
+     Hash=HashBytes(Hash, O->IVs, O->NumIVs*sizeof(int));
+     Hash=HashBytes(Hash, O->Neighbors, 2*O->NumIVs*sizeof(int));
+   };
+  return Hash;
+}
+
 /*******************************************************************/
 /* Create a new SSIDataTable containing static segment-segment     */
 /* integrals for all pairs of nearby segments on the given object  */
@@ -237,6 +270,22 @@ StaticSSIDataTable *CreateStaticSSIDataTable(TDRTObject *Oa, TDRTObject *Ob, int
 
   NeedDerivatives = (Oa==Ob ? 0 : 1);
 
+  /*******************************************************************/
+  /* if ${SCUFF_CACHE_PATH} is set, look there for a table computed  */
+  /* by an earlier run for the same meshes in the same positions.    */
+  /*******************************************************************/
+  char CacheFileName[1000];
+  unsigned long long Hash=GetStaticSSIDataTableHash(Oa, Ob);
+  char *CacheDir=getenv("SCUFF_CACHE_PATH");
+  if (CacheDir)
+   { snprintf(CacheFileName,1000,"%s/%016llx.ssidata",CacheDir,Hash);
+     if ( (SSSIDT=LoadStaticSSIDataTable(CacheFileName, Hash)) )
+      { if (TDRTGeometry::LogLevel>=2)
+         Log(" read %i records from %s",SSSIDT->NumRecords,CacheFileName);
+        return SSSIDT;
+      };
+   };
+
   /*******************************************************************/
   /* first pass to count how many nearby segments there are.         */
   /*******************************************************************/
@@ -285,6 +334,9 @@ StaticSSIDataTable *CreateStaticSSIDataTable(TDRTObject *Oa, TDRTObject *Ob, int
   /*******************************************************************/
   SSSIDT=(StaticSSIDataTable *)malloc(sizeof(*SSSIDT));
   SSSIDT->Map=new StaticSSIDataMap;
+  SSSIDT->NumRecords=NNearby;
+  SSSIDT->MappedFile=0;
+  SSSIDT->MappedSize=0;
   // the following two commands are needed if we are using the 
   // google dense_hash_map implementation of map, but not for  
   // the std::tr1 implementation
@@ -354,60 +406,116 @@ StaticSSIDataTable *CreateStaticSSIDataTable(TDRTObject *Oa, TDRTObject *Ob, int
   /*******************************************************************/
   /* finally, a multithreaded third pass to compute the data records.*/
   /*******************************************************************/
-#ifdef USE_PTHREAD
-  ThreadData *TDs = new ThreadData[NumThreads], *TD;
-  pthread_t *Threads = new pthread_t[NumThreads];
-  for(int nt=0; nt<NumThreads; nt++)
-   { 
-     TD=&(TDS[nt]);
-     TD->nt=nt;
-     TD->NumTasks=NumThreads;
-
-     TD->Oa=Oa;
-     TD->Ob=Ob;
-     TD->SSSIDT=SSSIDT;
-
-     if (nt+1 == NumThreads)
-      CreateStaticSSIDataTable_Thread((void *)TD);
-     else
-      pthread_create( &(Threads[nt]), 0, CreateStaticSSIDataTable_Thread, (void *)TD);
-   };
+  ThreadData MyTD, *TD=&MyTD;
+  TD->NextRow=0;
+  TD->Oa=Oa;
+  TD->Ob=Ob;
+  TD->SSSIDT=SSSIDT;
+  RunTDRTTaskPool(CreateStaticSSIDataTable_Thread, (void *)TD, NumThreads);
 
-  for(int nt=0; nt<NumThreads; nt++)
-   pthread_join(Threads[nt],0);
+  if (TDRTGeometry::LogLevel>=2) 
+   Log(" done!");
 
-  delete[] Threads;
-  delete[] TDs;
+  if (CacheDir)
+   StoreStaticSSIDataTable(SSSIDT, CacheFileName, Hash);
 
-#else 
-#ifndef USE_OPENMP
-  int NumTasks=NumThreads=1;
-#else
-  int NumTasks=NumThreads*100;
-#pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads)
-#endif
-  for(int nt=0; nt<NumTasks; nt++)
-   { 
-     ThreadData TD1;
-     TD1.nt=nt;
-     TD1.NumTasks=NumTasks;
+  /*******************************************************************/
+  /*******************************************************************/
+  /*******************************************************************/
+  return SSSIDT;
 
-     TD1.Oa=Oa;
-     TD1.Ob=Ob;
-     TD1.SSSIDT=SSSIDT;
+}
+
+/***************************************************************/
+/* Cache files store a table as                                */
+/*  bytes 0--7:     'TDRTSSI' + 0                              */
+/*  bytes 8--15:    hash of the geometry (see above)           */
+/*  bytes 16--23:   number of records N                        */
+/*  next 8N bytes:  table keys                                 */
+/*  remainder:      N StaticSSIDataRecords, in the same order  */
+/* (non-portable w.r.t. endianness). Loading maps the file     */
+/* read-only, so the records are paged in only as needed and   */
+/* shared among processes reading the same file.               */
+/***************************************************************/
+#define SSIDATA_SIGNATURE "TDRTSSI"
 
-     CreateStaticSSIDataTable_Thread((void *)&TD1);
+StaticSSIDataTable *LoadStaticSSIDataTable(const char *FileName,
+                                           unsigned long long Hash)
+{
+  int fd=open(FileName, O_RDONLY);
+  if (fd==-1) return 0;
+
+  struct stat st;
+  if ( fstat(fd,&st)!=0 || st.st_size<24 )
+   { close(fd); return 0; }
+  size_t Size=st.st_size;
+  void *MappedFile=mmap(0, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MappedFile==MAP_FAILED) return 0;
+
+  char *Bytes=(char *)MappedFile;
+  uint64_t FileHash, NumRecords;
+  memcpy(&FileHash,   Bytes+8,  8);
+  memcpy(&NumRecords, Bytes+16, 8);
+  if (    memcmp(Bytes, SSIDATA_SIGNATURE, 8)
+       || FileHash!=Hash
+       || Size != 24 + NumRecords*(8+sizeof(StaticSSIDataRecord))
+     )
+   { Warn("%s: invalid static SSI data file (ignoring)",FileName);
+     munmap(MappedFile, Size);
+     return 0;
    };
-#endif
 
-  if (TDRTGeometry::LogLevel>=2) 
-   Log(" done!");
+  StaticSSIDataTable *SSSIDT=(StaticSSIDataTable *)malloc(sizeof(*SSSIDT));
+  SSSIDT->Map=new StaticSSIDataMap;
+  SSSIDT->NumRecords=(int)NumRecords;
+  SSSIDT->MappedFile=MappedFile;
+  SSSIDT->MappedSize=Size;
+  uint64_t *Keys=(uint64_t *)(Bytes+24);
+  SSSIDT->Buffer=(StaticSSIDataRecord *)(Bytes + 24 + 8*NumRecords);
+  for(uint64_t n=0; n<NumRecords; n++)
+   SSSIDT->Map->insert( std::pair<unsigned long, StaticSSIDataRecord *>(Keys[n], SSSIDT->Buffer+n) );
 
-  /*******************************************************************/
-  /*******************************************************************/
-  /*******************************************************************/
   return SSSIDT;
+}
 
+void StoreStaticSSIDataTable(StaticSSIDataTable *SSSIDT, const char *FileName,
+                             unsigned long long Hash)
+{
+  if (!SSSIDT || SSSIDT->MappedFile) return;
+
+  uint64_t NumRecords=SSSIDT->NumRecords;
+  uint64_t *Keys=(uint64_t *)mallocEC(NumRecords*sizeof(uint64_t));
+  StaticSSIDataMap::iterator it;
+  for(it=SSSIDT->Map->begin(); it!=SSSIDT->Map->end(); it++)
+   Keys[ it->second - SSSIDT->Buffer ] = it->first;
+
+  // write to a temporary file and rename it into place, so that
+  // concurrent runs never see a partially-written file
+  char TempFileName[1100];
+  snprintf(TempFileName,1100,"%s.%i",FileName,(int)getpid());
+  FILE *f=fopen(TempFileName,"w");
+  if (!f)
+   { Warn("could not open file %s (not caching static SSI data)",TempFileName);
+     free(Keys);
+     return;
+   };
+  uint64_t FileHash=Hash;
+  bool OK =    fwrite(SSIDATA_SIGNATURE, 8, 1, f)==1
+            && fwrite(&FileHash, 8, 1, f)==1
+            && fwrite(&NumRecords, 8, 1, f)==1
+            && fwrite(Keys, sizeof(uint64_t), NumRecords, f)==NumRecords
+            && fwrite(SSSIDT->Buffer, sizeof(StaticSSIDataRecord), NumRecords, f)==NumRecords;
+  OK = (fclose(f)==0) && OK;
+  free(Keys);
+
+  if ( !OK || rename(TempFileName, FileName)!=0 )
+   { Warn("could not write file %s (not caching static SSI data)",FileName);
+     unlink(TempFileName);
+     return;
+   };
+  if (TDRTGeometry::LogLevel>=2)
+   Log(" wrote %i records to %s",SSSIDT->NumRecords,FileName);
 }
 
 /***************************************************************/
@@ -417,7 +525,11 @@ void DestroyStaticSSIDataTable(StaticSSIDataTable *SSSIDT)
 {
   if (!SSSIDT || !(SSSIDT->Buffer) )
    return;
-  free(SSSIDT->Buffer); 
+  if (SSSIDT->MappedFile)
+   munmap(SSSIDT->MappedFile, SSSIDT->MappedSize);
+  else
+   free(SSSIDT->Buffer); 
+  delete SSSIDT->Map;
   free(SSSIDT);
 
 }
@@ -6,6 +6,13 @@
 #include <math.h>
 #include "libTDRT.h"
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+#ifdef USE_PTHREAD
+#  include <pthread.h>
+#endif
+
 double VecDot(double *v1, double *v2)
 { return v1[0]*v2[0] + v1[1]*v2[1]; }
 
@@ -58,3 +65,30 @@ double VecD2(double *v1, double *v2)
 
   return (v3[0]*v3[0] + v3[1]*v3[1]);
 }
+
+/***************************************************************/
+/* work is handed out one item at a time from a shared counter,*/
+/* so threads that draw cheap items simply draw more of them.  */
+/***************************************************************/
+int ClaimTDRTTask(int *NextTask)
+{ return __sync_fetch_and_add(NextTask, 1); }
+
+void RunTDRTTaskPool(void *(*Task)(void *), void *Data, int NumThreads)
+{
+  if (NumThreads<1) NumThreads=1;
+
+#if defined(USE_PTHREAD)
+  pthread_t *Threads = new pthread_t[NumThreads];
+  for(int nt=0; nt<NumThreads-1; nt++)
+   pthread_create( &(Threads[nt]), 0, Task, Data);
+  Task(Data);
+  for(int nt=0; nt<NumThreads-1; nt++)
+   pthread_join(Threads[nt],0);
+  delete[] Threads;
+#elif defined(USE_OPENMP)
+#pragma omp parallel num_threads(NumThreads)
+  Task(Data);
+#else
+  Task(Data);
+#endif
+}
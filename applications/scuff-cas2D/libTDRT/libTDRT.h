@@ -98,6 +98,12 @@ typedef struct StaticSSIDataTable
  { 
     StaticSSIDataMap *Map;
     StaticSSIDataRecord *Buffer;
+    int NumRecords;
+
+    /* if the table was loaded from a cache file, Buffer points   */
+    /* into a read-only mapping of that file                      */
+    void *MappedFile;
+    size_t MappedSize;
 
  } StaticSSIDataTable;
 
@@ -358,6 +364,10 @@ int Nearby(double *Xs, double *Xe, double *Xsp, double *Xep);
 StaticSSIDataTable *CreateStaticSSIDataTable(TDRTObject *O, int nThread);
 StaticSSIDataTable *CreateStaticSSIDataTable(TDRTObject *Oa, TDRTObject *Ob, int nThread);
 void DestroyStaticSSIDataTable(StaticSSIDataTable *SSSIDT);
+StaticSSIDataTable *LoadStaticSSIDataTable(const char *FileName,
+                                           unsigned long long Hash);
+void StoreStaticSSIDataTable(StaticSSIDataTable *SSSIDT, const char *FileName,
+                             unsigned long long Hash);
 StaticSSIDataRecord *GetStaticSSIData(StaticSSIDataTable *SSSIDT,
                                       TDRTObject *Oa, int iXs, int iXe, 
                                       TDRTObject *Ob, int iXsp, int iXep, 
@@ -390,4 +400,14 @@ void VecPlusEquals(double *v1, double alpha, double *v2);
 double VecDistance(double *v1, double *v2);
 double VecD2(double *v1, double *v2);
 
+/*--------------------------------------------------------------*/
+/*- a minimal task pool: RunTDRTTaskPool runs Task(Data) on     */
+/*- NumThreads threads at once, and each instance of Task takes */
+/*- work items (typically rows of a matrix) from a counter      */
+/*- shared among the threads by calling ClaimTDRTTask until it  */
+/*- returns an index past the end of the work.                  */
+/*--------------------------------------------------------------*/
+void RunTDRTTaskPool(void *(*Task)(void *), void *Data, int NumThreads);
+int ClaimTDRTTask(int *NextTask);
+
 #endif  
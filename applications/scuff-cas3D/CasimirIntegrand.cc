@@ -280,17 +280,11 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
   Log("Mem usage: %lu",GetMemoryUsage()/1048576);
 
   /***************************************************************/
-  /* SurfaceNeverMoved[ns] is initialized true and remains true  */
-  /* as long as surface #ns is not displaced or rotated by any   */
-  /* geometrical transformation, but switches to false as soon as*/
-  /* that surface is moved, and then remains false for the rest  */
-  /* of the calculations done at this frequency                  */
+  /* off-diagonal blocks computed at other frequencies are of no */
+  /* further use                                                 */
   /***************************************************************/
-  static bool *SurfaceNeverMoved=0;
-  if (SurfaceNeverMoved==0)
-   SurfaceNeverMoved=(bool *)mallocEC(G->NumSurfaces*sizeof(bool));
-  for(int ns=0; ns<G->NumSurfaces; ns++)
-   SurfaceNeverMoved[ns]=true;
+  UBlockCache *UBCache=SC3D->UBCache;
+  UBCache->Clear(Omega);
 
   /***************************************************************/
   /* assemble T matrices                                         */
@@ -370,18 +364,11 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
   /* for each line in the TransFile, apply the specified         */
   /* transformation, then calculate all quantities requested.    */
   /***************************************************************/
-  FILE *ByXiKFile = (G->LDim==0) ? 0 : fopen(SC3D->ByXiKFileName,"a");
   int NT=SC3D->NumTransformations;
   for(int ntnq=0, nt=0; nt<NT; nt++)
    { 
      char *Tag=SC3D->GTCs[nt]->Tag;
 
-     if (ByXiKFile)
-      { fprintf(ByXiKFile,"%s %6e ",Tag,Xi);
-        for(int d=0; d<G->LDim; d++)
-         fprintf(ByXiKFile,"%6e ",kBloch[d]);
-      };
-
      /******************************************************************/
      /* skip if all quantities are already converged at this transform */
      /******************************************************************/
@@ -407,13 +394,6 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
         for(int nq=0; nq<SC3D->NumQuantities; nq++)
          EFT[ntnq++]=0.0;
 
-        if (ByXiKFile)
-         { for(int nq=0; nq<SC3D->NumQuantities; nq++)
-            fprintf(ByXiKFile,"%8e ",0.0);
-           fprintf(ByXiKFile,"\n");
-           fflush(ByXiKFile);
-         };
-
         continue;
       };
 
@@ -422,8 +402,6 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
      /******************************************************************/
      Log("Applying transform %s...",Tag);
      G->Transform( SC3D->GTCs[nt] );
-     for(int ns=0; ns<G->NumSurfaces; ns++)
-      if (G->SurfaceMoved[ns]) SurfaceNeverMoved[ns]=false;
 
      /***************************************************************/
      /* assemble U_{a,b} blocks and dUdXYZT_{0,b} blocks            */
@@ -431,11 +409,21 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
      for(int nb=0, ns=0; ns<G->NumSurfaces; ns++)
       for(int nsp=ns+1; nsp<G->NumSurfaces; nsp++, nb++)
        { 
-         /* if we already computed the interaction between objects ns  */
-         /* and nsp once at this frequency, and if neither object has  */
-         /* moved, then we do not need to recompute the interaction    */
-         if ( nt>0 && SurfaceNeverMoved[ns] && SurfaceNeverMoved[nsp] )
-          continue;
+         /* we can skip the computation if we already computed the     */
+         /* interaction between objects ns and nsp at this frequency   */
+         /* for the same relative pose of the two objects. the force   */
+         /* derivatives dU are unchanged only by common translations,  */
+         /* and the torque derivatives (about fixed lab-frame axes) by */
+         /* no common motion at all.                                   */
+         HMatrix **dU = (ns==0) ? SC3D->dUBlocks + 6*nb : 0;
+         int NumdU = (ns==0) ? 6 : 0, Invariance=UBC_RIGID;
+         for(int Mu=0; Mu<NumdU; Mu++)
+          if (dU[Mu])
+           Invariance = (Mu<3 && Invariance!=UBC_FIXED) ? UBC_TRANSLATION : UBC_FIXED;
+         if ( UBCache->Fetch(ns, nsp, SC3D->UBlocks[nb], dU, NumdU, Invariance) )
+          { Log(" Reusing stored data for U(%i,%i)",ns,nsp);
+            continue;
+          };
 
          Log(" Assembling U(%i,%i)",ns,nsp);
          void *Accelerator = PBC ? SC3D->UAccelerators[nt][nb] : 0;
@@ -447,6 +435,7 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
          else
           G->AssembleBEMMatrixBlock(ns, nsp, Omega, kBloch, SC3D->UBlocks[nb], 0,
                                     0, 0, Accelerator, false);
+         UBCache->Store(ns, nsp, SC3D->UBlocks[nb], dU, NumdU);
        };
 
      /***************************************************************/
@@ -472,17 +461,6 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
      if ( SC3D->WhichQuantities & QUANTITY_TORQUE3 )
       EFT[ntnq++]=GetTraceMInvdM(SC3D,'3');
 
-     /******************************************************************/
-     /* for periodic geometries, write bloch-vector-resolved data      */
-     /* to the .byXiK file                                             */
-     /******************************************************************/
-     if (ByXiKFile)
-      { for(int nq=SC3D->NumQuantities; nq>0; nq--)
-         fprintf(ByXiKFile,"%.8e ",EFT[ntnq-nq]);
-        fprintf(ByXiKFile,"\n");
-        fflush(ByXiKFile);
-      };
-
      if (SC3D->WriteHDF5Files)
       ExportHDF5Data(SC3D, Xi, kBloch, (NT==1 ? 0 : Tag) );
 
@@ -493,8 +471,40 @@ void GetCasimirIntegrand(void *pSC3D, cdouble Omega,
 
    }; // for(ntnq=nt=0; nt<SC3D->NumTransformations; nt++)
 
-  if (ByXiKFile)
-   fclose(ByXiKFile);
+  /***************************************************************/
+  /* for periodic geometries, write bloch-vector-resolved data   */
+  /* to the .byXiK file. (all lines for this (Xi,kBloch) point   */
+  /* are written at once, so that several Xi workers running     */
+  /* concurrently do not interleave their output.)               */
+  /***************************************************************/
+  if (PBC)
+   {
+     if (SC3D->OutputFormat & RESULT_FORMAT_TEXT)
+#ifdef USE_OPENMP
+#pragma omp critical(ByXiKFile)
+#endif
+      { FILE *ByXiKFile=fopen(SC3D->ByXiKFileName,"a");
+        for(int ntnq=0, nt=0; nt<NT; nt++)
+         { fprintf(ByXiKFile,"%s %6e ",SC3D->GTCs[nt]->Tag,Xi);
+           for(int d=0; d<G->LDim; d++)
+            fprintf(ByXiKFile,"%6e ",kBloch[d]);
+           for(int nq=0; nq<SC3D->NumQuantities; nq++)
+            fprintf(ByXiKFile,"%.8e ",EFT[ntnq++]);
+           fprintf(ByXiKFile,"\n");
+         };
+        fclose(ByXiKFile);
+      };
+
+     if (SC3D->ByXiKTable)
+      { double Keys[3];
+        Keys[0] = Xi;
+        Keys[1] = kBloch[0];
+        Keys[2] = (G->LDim>=2) ? kBloch[1] : 0.0;
+        for(int nt=0; nt<NT; nt++)
+         SC3D->ByXiKTable->Append(SC3D->GTCs[nt]->Tag, Keys,
+                                  EFT + nt*SC3D->NumQuantities);
+      };
+   };
 
   /***************************************************************/
   /***************************************************************/
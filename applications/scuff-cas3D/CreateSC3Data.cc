@@ -36,13 +36,72 @@
 
 using namespace scuff;
 
+/***************************************************************/
+/* create HDF5 tables with the same columns as the .byXi and   */
+/* .byXikBloch files                                           */
+/***************************************************************/
+static const char *QuantityNames[7]=
+ { "Energy", "XForce", "YForce", "ZForce", "Torque1", "Torque2", "Torque3" };
+
+void CreateResultTables(SC3Data *SC3D)
+{
+  int LDim = SC3D->G->LBasis ? SC3D->G->LBasis->NC : 0;
+  int NQ   = SC3D->NumQuantities;
+
+  // periodic .byXi files carry a BZ-integration error column
+  // after each quantity
+  int NV = (LDim>0) ? 2*NQ : NQ;
+  char **XiValueNames  = (char **)mallocEC(NV*sizeof(char *));
+  const char **XiKValueNames = (const char **)mallocEC(NQ*sizeof(char *));
+  for(int nq=0, nqq=0; nq<7; nq++)
+   if ( SC3D->WhichQuantities & (1<<nq) )
+    { XiKValueNames[nqq] = QuantityNames[nq];
+      if (LDim>0)
+       { XiValueNames[2*nqq+0] = strdupEC(QuantityNames[nq]);
+         XiValueNames[2*nqq+1] = vstrdup("%sError",QuantityNames[nq]);
+       }
+      else
+       XiValueNames[nqq] = strdupEC(QuantityNames[nq]);
+      nqq++;
+    };
+
+  const char *XiKeyNames[3]={"Xi", "kx", "ky"};
+  SC3D->ByXiTable = new ResultTable(vstrdup("%s.h5",SC3D->ByXiFileName),
+                                    1, XiKeyNames, NV, (const char **)XiValueNames);
+  if (SC3D->ByXiTable->ErrMsg)
+   ErrExit(SC3D->ByXiTable->ErrMsg);
+
+  if (LDim>0)
+   { SC3D->ByXiKTable = new ResultTable(vstrdup("%s.h5",SC3D->ByXiKFileName),
+                                        3, XiKeyNames, NQ, XiKValueNames);
+     if (SC3D->ByXiKTable->ErrMsg)
+      ErrExit(SC3D->ByXiKTable->ErrMsg);
+   };
+
+  for(int nv=0; nv<NV; nv++)
+   free(XiValueNames[nv]);
+  free(XiValueNames);
+  free(XiKValueNames);
+}
+
+/***************************************************************/
+/* flush and close the HDF5 tables (main structure only)       */
+/***************************************************************/
+void CloseResultTables(SC3Data *SC3D)
+{
+  if (SC3D->ByXiTable)  delete SC3D->ByXiTable;
+  if (SC3D->ByXiKTable) delete SC3D->ByXiKTable;
+  SC3D->ByXiTable=SC3D->ByXiKTable=0;
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
 SC3Data *CreateSC3Data(RWGGeometry *G, char *TransFile,
                        int WhichQuantities, int NumQuantities,
                        int NumTorqueAxes, double TorqueAxes[9],
-                       bool NewEnergyMethod, char *FileBase)
+                       bool NewEnergyMethod, char *FileBase,
+                       bool WritePreambles)
 {
   SC3Data *SC3D=(SC3Data *)mallocEC(sizeof(*SC3D));
   SC3D->G = G;
@@ -68,6 +127,7 @@ SC3Data *CreateSC3Data(RWGGeometry *G, char *TransFile,
   /*- this case the list of GTComplices is initialized to contain */
   /*- a single empty GTComplex and the check automatically passes.*/
   /*--------------------------------------------------------------*/
+  SC3D->TransFile = TransFile ? strdup(TransFile) : 0;
   SC3D->GTCs=ReadTransFile(TransFile);
   SC3D->NumTransformations = SC3D->GTCs.size();
   char *ErrMsg=G->CheckGTCList(SC3D->GTCs);
@@ -81,6 +141,7 @@ SC3Data *CreateSC3Data(RWGGeometry *G, char *TransFile,
    SC3D->BZConverged = 0;
   else
    SC3D->BZConverged = (bool *)mallocEC( (SC3D->NTNQ) * sizeof(bool) );
+  SC3D->UBCache = new UBlockCache(G);
 
   /*--------------------------------------------------------------*/
   /*- allocate arrays of matrix subblocks that allow us to reuse  */
@@ -172,14 +233,33 @@ SC3Data *CreateSC3Data(RWGGeometry *G, char *TransFile,
 
   SC3D->OutFileName=vstrdup("%s.out",FileBase);
 
+  SC3D->UTIntegralBuffer[0]=SC3D->UTIntegralBuffer[1]=0;
+  SC3D->BZIArgs=0;
+
+  SC3D->OutputFormat = GetResultFormat();
+  bool WriteText = (SC3D->OutputFormat & RESULT_FORMAT_TEXT);
+
   SC3D->ByXiFileName=vstrdup("%s.byXi",FileBase);
-  WriteFilePreamble(SC3D, PREAMBLE_BYXI);
+  if (WritePreambles && WriteText)
+   WriteFilePreamble(SC3D, PREAMBLE_BYXI);
 
   if (LDim>0)
    { SC3D->ByXiKFileName=vstrdup("%s.byXikBloch",FileBase);
-     WriteFilePreamble(SC3D, PREAMBLE_BYXIK);
+     if (WritePreambles && WriteText)
+      WriteFilePreamble(SC3D, PREAMBLE_BYXIK);
    }
 
+  // Xi workers (WritePreambles==false) share the tables of the
+  // main structure; see InitXiWorkers
+  SC3D->ByXiTable=SC3D->ByXiKTable=0;
+  if (WritePreambles && (SC3D->OutputFormat & RESULT_FORMAT_HDF5) )
+   CreateResultTables(SC3D);
+
+  SC3D->NumXiWorkers=1;
+  SC3D->XiWorkers=0;
+  SC3D->NumXiCosts=0;
+  SC3D->XiCostXi=SC3D->XiCostWork=0;
+
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -300,8 +380,4 @@ void WriteFilePreamble(SC3Data *SC3D, int PreambleType)
 
   fclose(f);
 
-  SC3D->UTIntegralBuffer[0]=SC3D->UTIntegralBuffer[1]=0;
-
-  SC3D->BZIArgs=0;
-
 }
@@ -101,6 +101,35 @@ bool CacheRead(SC3Data *SC3D, double Xi, double *kBloch, double *EFT)
   if(NumKeys>=2) Keys[1]=kBloch[0];
   if(NumKeys>=3) Keys[2]=kBloch[1];
 
+  /*----------------------------------------------------------*/
+  /* if we have a binary table, look up each transformation  -*/
+  /* directly by (Tag, Xi, kBloch) instead of scanning text   */
+  /*----------------------------------------------------------*/
+  ResultTable *RT = kBloch ? SC3D->ByXiKTable : SC3D->ByXiTable;
+  if (RT)
+   { int NQ = SC3D->NumQuantities;
+     int Stride = RT->NumValues / NQ; // 2 if the table has error columns
+     double TableKeys[3]={Xi, 0.0, 0.0};
+     if (kBloch)
+      { TableKeys[1]=kBloch[0];
+        TableKeys[2]=(LDim>=2) ? kBloch[1] : 0.0;
+      };
+     double *Values = new double[RT->NumValues];
+     bool Found=true;
+     for(int nt=0; Found && nt<SC3D->NumTransformations; nt++)
+      { Found=RT->Lookup(SC3D->GTCs[nt]->Tag, TableKeys, Values);
+        for(int nq=0; Found && nq<NQ; nq++)
+         EFT[nt*NQ + nq] = Values[Stride*nq];
+      };
+     delete[] Values;
+     if (Found)
+      { Log("...found data for all transforms in %s",RT->FileName);
+        return true;
+      };
+     if (!(SC3D->OutputFormat & RESULT_FORMAT_TEXT))
+      return false;
+   };
+
   /*----------------------------------------------------------*/
   /* 0. try to open the cache file. --------------------------*/
   /*----------------------------------------------------------*/
@@ -453,56 +482,97 @@ void GetCasimirBZIntegral(SC3Data *SC3D, double Xi, double *EFT)
 /* periodic geometries, this means integrating over the        */
 /* Brillouin zone at the Xi value in question.                 */
 /***************************************************************/
-void GetXiIntegrand(SC3Data *SC3D, double Xi, double *EFT)
+void ComputeXiIntegrand(SC3Data *SC3D, double Xi, double *EFT)
 {
-  /***************************************************************/
-  /***************************************************************/
-  /***************************************************************/
-  bool Periodic = (SC3D->G->LDim > 0);
-  if (Periodic)
+  if (SC3D->G->LDim > 0)
    GetBZIntegral(SC3D->BZIArgs, cdouble(0.0,Xi), EFT);
   else
    GetCasimirIntegrand((void *)SC3D, cdouble(0.0,Xi), 0, EFT);
+}
 
-  /***************************************************************/
-  /* write data to .byXi file                                    */
-  /***************************************************************/
-  FILE *f=fopen(SC3D->ByXiFileName,"a");
-  double *Error = Periodic ? SC3D->BZIArgs->BZIError : 0;
-  for(int ntnq=0, nt=0; nt<SC3D->NumTransformations; nt++)
-   { fprintf(f,"%s %.6e ",SC3D->GTCs[nt]->Tag,Xi);
-     for(int nq=0; nq<SC3D->NumQuantities; nq++, ntnq++)
-      { fprintf(f,"%.8e ",EFT[ntnq]);
-        if (Periodic)
-         fprintf(f,"%.8e ",Error ? Error[ntnq] : 0.0);
+/***************************************************************/
+/* write data to .byXi file. Error is the BZ-integration error */
+/* (ignored for non-periodic geometries).                      */
+/***************************************************************/
+void WriteXiIntegrand(SC3Data *SC3D, double Xi, double *EFT, double *Error)
+{
+  bool Periodic = (SC3D->G->LDim > 0);
+  int NQ = SC3D->NumQuantities;
+
+  // Xi workers may call this routine concurrently (see
+  // XiScheduler.cc); the ResultTable does its own locking
+  if (SC3D->OutputFormat & RESULT_FORMAT_TEXT)
+#ifdef USE_OPENMP
+#pragma omp critical(ByXiFile)
+#endif
+   { FILE *f=fopen(SC3D->ByXiFileName,"a");
+     for(int ntnq=0, nt=0; nt<SC3D->NumTransformations; nt++)
+      { fprintf(f,"%s %.6e ",SC3D->GTCs[nt]->Tag,Xi);
+        for(int nq=0; nq<NQ; nq++, ntnq++)
+         { fprintf(f,"%.8e ",EFT[ntnq]);
+           if (Periodic)
+            fprintf(f,"%.8e ",Error ? Error[ntnq] : 0.0);
+         };
+        fprintf(f,"\n");
       };
-     fprintf(f,"\n");
+     fclose(f);
    };
-  fclose(f);
 
+  if (SC3D->ByXiTable)
+   { double *Values = new double[2*NQ];
+     for(int ntnq=0, nt=0; nt<SC3D->NumTransformations; nt++)
+      { for(int nq=0; nq<NQ; nq++, ntnq++)
+         if (Periodic)
+          { Values[2*nq+0] = EFT[ntnq];
+            Values[2*nq+1] = Error ? Error[ntnq] : 0.0;
+          }
+         else
+          Values[nq] = EFT[ntnq];
+        SC3D->ByXiTable->Append(SC3D->GTCs[nt]->Tag, &Xi, Values);
+      };
+     SC3D->ByXiTable->Flush();
+     delete[] Values;
+   };
 }
 
 /***************************************************************/
-/* wrapper with correct prototype for pcubature (over an       */
-/* infinite interval)                                          */
 /***************************************************************/
-int GetXiIntegrand2(unsigned ndim, const double *x, void *params, 
-                    unsigned fdim, double *fval)
+/***************************************************************/
+void GetXiIntegrand(SC3Data *SC3D, double Xi, double *EFT)
+{
+  ComputeXiIntegrand(SC3D, Xi, EFT);
+
+  bool Periodic = (SC3D->G->LDim > 0);
+  double *Error = Periodic ? SC3D->BZIArgs->BZIError : 0;
+  WriteXiIntegrand(SC3D, Xi, EFT, Error);
+}
+
+/***************************************************************/
+/* wrapper with correct prototype for pcubature_v (over an     */
+/* infinite interval). all npt points requested by the         */
+/* integrator in one refinement pass are handed off together   */
+/* to GetXiIntegrands, which may evaluate them concurrently.   */
+/***************************************************************/
+int GetXiIntegrand2(unsigned ndim, size_t npt, const double *x,
+                    void *params, unsigned fdim, double *fval)
 {
   (void) ndim; // unused
-  (void) fdim; // unused
 
   SC3Data *SC3D = (SC3Data *)params;
 
-  double Xi = SC3D->XiMin + x[0]/(1.0-x[0]); 
-  double Jacobian = 1.0/( (1.0-x[0])*(1.0-x[0]) );
-  double *EFT = fval;
+  double *Xis = new double[npt];
+  for(size_t np=0; np<npt; np++)
+   Xis[np] = SC3D->XiMin + x[np]/(1.0-x[np]);
 
-  GetXiIntegrand(SC3D, Xi, EFT);
+  GetXiIntegrands(SC3D, npt, Xis, fval);
 
-  for(int ntnq=0; ntnq<SC3D->NTNQ; ntnq++)
-   EFT[ntnq]*=Jacobian;
+  for(size_t np=0; np<npt; np++)
+   { double Jacobian = 1.0/( (1.0-x[np])*(1.0-x[np]) );
+     for(unsigned ntnq=0; ntnq<fdim; ntnq++)
+      fval[np*fdim + ntnq]*=Jacobian;
+   };
 
+  delete[] Xis;
   return 0;
 
 }
@@ -532,56 +602,53 @@ int GetXiIntegrand3(unsigned ndim, const double *x, void *params,
 void GetXiIntegral_TrapSimp(SC3Data *SC3D, int NumIntervals, double *I, double *E)
 { 
   int fdim = SC3D->NTNQ;
-  double *fLeft  = new double[fdim];
-  double *fMid   = new double[fdim];
-  double *fRight = new double[fdim];
-  double Xi;
 
   /*--------------------------------------------------------------*/
-  /*- evaluate integrand at leftmost frequency point and estimate */
-  /*- the integral from 0 to XIMIN by assuming that the integrand */
-  /*- is constant in that range                                   */
+  /*- the trap/simp frequency points are known in advance, so we  */
+  /*- evaluate the integrand at all of them in a single batch:    */
+  /*- Xi[0] is the leftmost point and Xi[2n+1], Xi[2n+2] are the  */
+  /*- midpoint and right endpoint of the nth interval.            */
+  /*--------------------------------------------------------------*/
+  double Delta = (XIMAX - XIMIN ) / NumIntervals;
+  int NumXis   = 2*NumIntervals + 1;
+  double *Xis  = new double[NumXis];
+  Xis[0]=SC3D->XiMin;
+  for(int nXi=1; nXi<NumXis; nXi++)
+   Xis[nXi] = Xis[nXi-1] + 0.5*Delta;
+
+  double *fValues = new double[NumXis*fdim];
+  GetXiIntegrands(SC3D, NumXis, Xis, fValues);
+
+  /*--------------------------------------------------------------*/
+  /*- estimate the integral from 0 to XIMIN by assuming that the  */
+  /*- integrand is constant in that range                         */
   /*--------------------------------------------------------------*/
-  Xi=SC3D->XiMin;
-  GetXiIntegrand(SC3D, Xi, fLeft);
   for(int nf=0; nf<fdim; nf++)
-   I[nf] = fLeft[nf] * (SC3D->XiMin);
+   I[nf] = fValues[nf] * (SC3D->XiMin);
   memset(E,0,SC3D->NTNQ*sizeof(double));
+
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
-  double Delta = (XIMAX - XIMIN ) / NumIntervals;
-  double *ISimp  = new double[fdim];
-  double *ITrap  = new double[fdim];
   for(int nIntervals=0; nIntervals<NumIntervals; nIntervals++)
    { 
-     // evaluate integrand at midpoint of interval 
-     Xi += 0.5*Delta;
-     GetXiIntegrand(SC3D, Xi, fMid);
-
-     // evaluate integrand at right end of interval 
-     Xi += 0.5*Delta;
-     GetXiIntegrand(SC3D, Xi, fRight);
+     double *fLeft  = fValues + (2*nIntervals + 0)*fdim;
+     double *fMid   = fValues + (2*nIntervals + 1)*fdim;
+     double *fRight = fValues + (2*nIntervals + 2)*fdim;
 
      // compute the simpson's rule and trapezoidal rule
      // estimates of the integral over this interval  
      // and take their difference as the error
      for(int nf=0; nf<fdim; nf++)
-      { ISimp[nf] = (fLeft[nf] + 4.0*fMid[nf] + fRight[nf])*Delta/6.0;
-        ITrap[nf] = (fLeft[nf] + 2.0*fMid[nf] + fRight[nf])*Delta/4.0;
-        I[nf] += ISimp[nf];
-        E[nf] += fabs(ISimp[nf] - ITrap[nf]);
+      { double ISimp = (fLeft[nf] + 4.0*fMid[nf] + fRight[nf])*Delta/6.0;
+        double ITrap = (fLeft[nf] + 2.0*fMid[nf] + fRight[nf])*Delta/4.0;
+        I[nf] += ISimp;
+        E[nf] += fabs(ISimp - ITrap);
       };
-
-     // prepare for next iteration
-     memcpy(fLeft, fRight, fdim*sizeof(double));
-
    };
-  delete[] fLeft;
-  delete[] fMid;
-  delete[] fRight;
-  delete[] ISimp;
-  delete[] ITrap;
+
+  delete[] Xis;
+  delete[] fValues;
 
 }
 
@@ -594,9 +661,9 @@ void GetXiIntegral_Adaptive(SC3Data *SC3D, double *EFT, double *Error)
   double Lower[1] = {0.0}; 
   double Upper[1] = {1.0};
 
-  pcubature(SC3D->NTNQ, GetXiIntegrand2, (void *)SC3D, 1, Lower, Upper,
-            SC3D->MaxXiPoints, SC3D->AbsTol, SC3D->RelTol,
-            ERROR_INDIVIDUAL, EFT, Error);
+  pcubature_v(SC3D->NTNQ, GetXiIntegrand2, (void *)SC3D, 1, Lower, Upper,
+              SC3D->MaxXiPoints, SC3D->AbsTol, SC3D->RelTol,
+              ERROR_INDIVIDUAL, EFT, Error);
    
 }
 
@@ -667,9 +734,15 @@ void GetXiIntegral_Cliff(SC3Data *SC3D, double *I, double *E)
 void GetMatsubaraSum(SC3Data *SC3D, double Temperature, double *EFT, double *Error)
 { 
   int n, ntnq, NTNQ=SC3D->NTNQ;
-  double Xi, Weight;
-
-  double *dEFT = new double [NTNQ]; 
+  double Weight;
+
+  // Matsubara frequencies are evaluated in batches of NumXiWorkers
+  // points at a time; when the sum converges partway through a
+  // batch the remaining points are simply discarded
+  int BatchSize = SC3D->NumXiWorkers > 1 ? SC3D->NumXiWorkers : 1;
+  double *XiBatch = new double[BatchSize];
+  double *dEFTBatch = new double[BatchSize*NTNQ];
+  int nBatch=0, NumInBatch=0;
   double *LastEFT = new double[NTNQ]; 
   double RelDelta;
   int AllConverged=0;
@@ -688,20 +761,25 @@ void GetMatsubaraSum(SC3Data *SC3D, double Temperature, double *EFT, double *Err
      /***************************************************************/
      /* compute the next matsubara frequency ************************/
      /***************************************************************/
-     if (n==0)
-      { Weight=0.5;
-        // NOTE: we assume that the integrand is constant for Xi < XIMIN
-        Xi=XIMIN;
-      }
-     else
-      { Weight=1.0;
-        Xi=2.0*M_PI*kT*((double)n);
-      };
+     Weight = (n==0) ? 0.5 : 1.0;
 
      /***************************************************************/
-     /* evaluate the frequency integrand at this matsubara frequency*/
+     /* evaluate the frequency integrand at the next batch of       */
+     /* matsubara frequencies if we have used up the current batch  */
      /***************************************************************/
-     GetXiIntegrand(SC3D, Xi, dEFT);
+     if ( n == (nBatch + NumInBatch) )
+      { nBatch=n;
+        NumInBatch=BatchSize;
+        if ( nBatch+NumInBatch > SC3D->MaxXiPoints )
+         NumInBatch = SC3D->MaxXiPoints - nBatch;
+        for(int nb=0; nb<NumInBatch; nb++)
+         { int nn=nBatch+nb;
+           // NOTE: we assume that the integrand is constant for Xi < XIMIN
+           XiBatch[nb] = (nn==0) ? XIMIN : 2.0*M_PI*kT*((double)nn);
+         };
+        GetXiIntegrands(SC3D, NumInBatch, XiBatch, dEFTBatch);
+      };
+     double *dEFT = dEFTBatch + (n-nBatch)*NTNQ;
 
      /***************************************************************/
      /* accumulate contributions to the sum.                        */
@@ -721,10 +799,15 @@ void GetMatsubaraSum(SC3Data *SC3D, double Temperature, double *EFT, double *Err
      /*  2\pi kT *  \sum_n^\prime FI(\xi_n)                       */
      /*                                                             */
      /* where FI is what is returned by GetXiIntegrand.             */
+     /*                                                             */
+     /* quantities that have already converged are skipped, since   */
+     /* points in a batch may have been evaluated before the        */
+     /* quantity was marked converged.                              */
      /***************************************************************/
      memcpy(LastEFT,EFT,NTNQ*sizeof(double));
      for(ntnq=0; ntnq<NTNQ; ntnq++)
-      EFT[ntnq] += Weight * 2.0*M_PI* kT * dEFT[ntnq];
+      if ( !SC3D->XiConverged[ntnq] )
+       EFT[ntnq] += Weight * 2.0*M_PI* kT * dEFT[ntnq];
 
      /*********************************************************************/
      /* convergence analysis.                                             */
@@ -758,7 +841,8 @@ void GetMatsubaraSum(SC3Data *SC3D, double Temperature, double *EFT, double *Err
 
    }; /* for (n=0 ... */
 
-  delete[] dEFT;   
+  delete[] XiBatch;
+  delete[] dEFTBatch;
   delete[] LastEFT;
   delete[] ConvergedIters;
   
@@ -0,0 +1,345 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * XiScheduler.cc -- evaluate the Casimir integrand at several
+ *                -- imaginary frequencies concurrently
+ *
+ * The frequency integrators and the Matsubara sum request
+ * integrand values at batches of Xi points (all trap/simp points
+ * at once, each refinement pass of the adaptive integrator, a
+ * block of Matsubara frequencies). Rather than handing each Xi
+ * point in turn to the full thread pool---which scales poorly
+ * because of the serial LU-factorization and output phases of
+ * each calculation---we split the batch among NumXiWorkers
+ * workers, each of which owns a private copy of the SC3Data
+ * structure (with its own RWGGeometry and matrix storage) and
+ * runs with its own share of the available threads. Threads are
+ * apportioned among workers according to the estimated cost of
+ * the points assigned to them, which is taken from the measured
+ * cost of previously-evaluated points at nearby frequencies.
+ */
+
+#include "scuff-cas3D.h"
+
+#ifdef USE_OPENMP
+#  include <omp.h>
+#endif
+
+/***************************************************************/
+/* create NumXiWorkers-1 additional copies of the SC3Data      */
+/* structure (worker #0 is SC3D itself). this must be called   */
+/* after SC3D is fully initialized, including BZIArgs.         */
+/***************************************************************/
+void InitXiWorkers(SC3Data *SC3D, int NumXiWorkers)
+{
+  if (NumXiWorkers<=1)
+   return;
+
+  int NumThreads = GetNumThreads();
+  if (NumXiWorkers > NumThreads)
+   { Warn("%i Xi workers requested but only %i threads available (using %i)",
+           NumXiWorkers,NumThreads,NumThreads);
+     NumXiWorkers=NumThreads;
+     if (NumXiWorkers<=1) 
+      return;
+   };
+
+  Log("Creating %i Xi workers...",NumXiWorkers);
+
+  SC3D->NumXiWorkers = NumXiWorkers;
+  SC3D->XiWorkers = (SC3Data **)mallocEC(NumXiWorkers*sizeof(SC3Data *));
+  SC3D->XiWorkers[0] = SC3D;
+  for(int nw=1; nw<NumXiWorkers; nw++)
+   { 
+     RWGGeometry *G = new RWGGeometry(SC3D->G->GeoFileName);
+     G->SetLogLevel(SC3D->G->LogLevel);
+
+     SC3Data *W = CreateSC3Data(G, SC3D->TransFile,
+                                SC3D->WhichQuantities, SC3D->NumQuantities,
+                                SC3D->NumTorqueAxes, SC3D->TorqueAxes,
+                                SC3D->NewEnergyMethod, SC3D->FileBase,
+                                false);
+
+     W->WriteHDF5Files  = SC3D->WriteHDF5Files;
+     W->AbsTol          = SC3D->AbsTol;
+     W->RelTol          = SC3D->RelTol;
+     W->UseExistingData = SC3D->UseExistingData;
+     W->MaxXiPoints     = SC3D->MaxXiPoints;
+     W->XiMin           = SC3D->XiMin;
+     W->ByXiTable       = SC3D->ByXiTable;
+     W->ByXiKTable      = SC3D->ByXiKTable;
+     W->SeparationNodes = SC3D->SeparationNodes;
+     W->SeparationTol   = SC3D->SeparationTol;
+     if (W->SeparationNodes>0)
+      W->UBCache->PlanSeparationInterpolation(W->GTCs, W->SeparationNodes, W->SeparationTol);
+
+     if (SC3D->BZIArgs)
+      { W->BZIArgs = (GetBZIArgStruct *)mallocEC(sizeof(GetBZIArgStruct));
+        memcpy(W->BZIArgs, SC3D->BZIArgs, sizeof(GetBZIArgStruct));
+        W->BZIArgs->UserData = (void *)W;
+        W->BZIArgs->RLBasis  = G->RLBasis;
+        W->BZIArgs->BufSize  = 0;
+        W->BZIArgs->BZIError = 0;
+        memset(W->BZIArgs->DataBuffer, 0, 4*sizeof(double *));
+      };
+
+     SC3D->XiWorkers[nw] = W;
+   };
+
+#ifdef USE_OPENMP
+  omp_set_max_active_levels(2);
+#endif
+
+  Log("...done creating Xi workers: mem=%3.1f GB",GetMemoryUsage()/1.0e9);
+}
+
+/***************************************************************/
+/* estimated cost (in thread-seconds) of evaluating the        */
+/* integrand at Xi, taken to be the measured cost at the       */
+/* nearest previously-evaluated frequency.                     */
+/***************************************************************/
+static double EstimateXiCost(SC3Data *SC3D, double Xi)
+{
+  if (SC3D->NumXiCosts==0)
+   return 1.0;
+
+  int nBest=0;
+  double BestDelta=fabs(Xi - SC3D->XiCostXi[0]);
+  for(int n=1; n<SC3D->NumXiCosts; n++)
+   { double Delta = fabs(Xi - SC3D->XiCostXi[n]);
+     if (Delta<BestDelta)
+      { nBest=n;
+        BestDelta=Delta;
+      };
+   };
+
+  return fmax(SC3D->XiCostWork[nBest], 1.0e-3);
+}
+
+static void RecordXiCost(SC3Data *SC3D, double Xi, double Work)
+{
+  int n=SC3D->NumXiCosts++;
+  SC3D->XiCostXi   = (double *)reallocEC(SC3D->XiCostXi,   (n+1)*sizeof(double));
+  SC3D->XiCostWork = (double *)reallocEC(SC3D->XiCostWork, (n+1)*sizeof(double));
+  SC3D->XiCostXi[n]   = Xi;
+  SC3D->XiCostWork[n] = Work;
+}
+
+/***************************************************************/
+/* batched version of GetCasimirIntegrand for use by the BZ    */
+/* integrator: the NumPoints Bloch vectors in a batch are      */
+/* dealt out round-robin to the Xi workers, each of which gets */
+/* an equal share of the thread pool. if we are already inside */
+/* a parallel region (i.e. this is a worker evaluating its own */
+/* Xi point) the points are evaluated serially.                */
+/***************************************************************/
+void GetCasimirIntegrands_v(void *pSC3D, cdouble Omega, int NumPoints,
+                            double *kBlochs, double *EFTs)
+{
+  SC3Data *SC3D = (SC3Data *)pSC3D;
+  int NTNQ = SC3D->NTNQ;
+  int NW   = SC3D->NumXiWorkers;
+  if (NW > NumPoints)
+   NW = NumPoints;
+
+  bool Serial = (NW<=1);
+#ifdef USE_OPENMP
+  if (omp_in_parallel())
+   Serial=true;
+#else
+  Serial=true;
+#endif
+
+  if (Serial)
+   { for(int np=0; np<NumPoints; np++)
+      GetCasimirIntegrand(pSC3D, Omega, kBlochs + 3*np, EFTs + np*NTNQ);
+     return;
+   };
+
+  int NumThreads = GetNumThreads();
+  Log("Evaluating %i Bloch vectors on %i workers",NumPoints,NW);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static,1), num_threads(NW)
+#endif
+  for(int nw=0; nw<NW; nw++)
+   { 
+#ifdef USE_OPENMP
+     omp_set_num_threads( NumThreads/NW + (nw < NumThreads%NW ? 1 : 0) );
+#endif
+     SC3Data *W = SC3D->XiWorkers[nw];
+     if (W!=SC3D)
+      memcpy(W->XiConverged, SC3D->XiConverged, NTNQ*sizeof(bool));
+     for(int np=nw; np<NumPoints; np+=NW)
+      GetCasimirIntegrand((void *)W, Omega, kBlochs + 3*np, EFTs + np*NTNQ);
+   };
+#ifdef USE_OPENMP
+  omp_set_num_threads(NumThreads);
+#endif
+}
+
+/***************************************************************/
+/* evaluate the Xi integrand at NumXis frequencies.            */
+/* on return, EFTs[nXi*NTNQ + ntnq] is the ntnqth component    */
+/* of the integrand at Xis[nXi]. each point is written to the */
+/* .byXi file by its worker as soon as it has been evaluated,  */
+/* so with several workers the rows need not appear in the     */
+/* order of the Xis array.                                     */
+/***************************************************************/
+void GetXiIntegrands(SC3Data *SC3D, int NumXis, double *Xis, double *EFTs)
+{
+  int NTNQ = SC3D->NTNQ;
+  int NW   = SC3D->NumXiWorkers;
+  if (NW > NumXis)
+   NW = NumXis;
+
+  /*--------------------------------------------------------------*/
+  /*- if we have only one worker, or only one point, just use    -*/
+  /*- the full thread pool for each point in turn                -*/
+  /*--------------------------------------------------------------*/
+  if (NW<=1)
+   { for(int nXi=0; nXi<NumXis; nXi++)
+      GetXiIntegrand(SC3D, Xis[nXi], EFTs + nXi*NTNQ);
+     return;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- assign points to workers: visit points in order of         -*/
+  /*- decreasing estimated cost and hand each to the worker with -*/
+  /*- the smallest total load so far                             -*/
+  /*--------------------------------------------------------------*/
+  double *Cost   = new double[NumXis];
+  int *Owner     = new int[NumXis];
+  bool *Assigned = new bool[NumXis];
+  double *Load   = new double[NW];
+  for(int nXi=0; nXi<NumXis; nXi++)
+   { Cost[nXi]     = EstimateXiCost(SC3D, Xis[nXi]);
+     Assigned[nXi] = false;
+   };
+  memset(Load, 0, NW*sizeof(double));
+  for(int na=0; na<NumXis; na++)
+   { 
+     int nMax=-1;
+     for(int nXi=0; nXi<NumXis; nXi++)
+      if ( !Assigned[nXi] && (nMax==-1 || Cost[nXi]>Cost[nMax]) )
+       nMax=nXi;
+
+     int nwMin=0;
+     for(int nw=1; nw<NW; nw++)
+      if (Load[nw] < Load[nwMin])
+       nwMin=nw;
+
+     Owner[nMax]=nwMin;
+     Assigned[nMax]=true;
+     Load[nwMin]+=Cost[nMax];
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- apportion threads among workers in proportion to load;     -*/
+  /*- leftover threads go to the workers with the greatest load  -*/
+  /*- per thread                                                 -*/
+  /*--------------------------------------------------------------*/
+  int NumThreads = GetNumThreads();
+  int *WorkerThreads = new int[NW];
+  double TotalLoad=0.0;
+  for(int nw=0; nw<NW; nw++)
+   TotalLoad+=Load[nw];
+  int ThreadsUsed=0;
+  for(int nw=0; nw<NW; nw++)
+   { WorkerThreads[nw] = (int)floor(NumThreads*Load[nw]/TotalLoad);
+     if (WorkerThreads[nw]<1) 
+      WorkerThreads[nw]=1;
+     ThreadsUsed+=WorkerThreads[nw];
+   };
+  for(; ThreadsUsed<NumThreads; ThreadsUsed++)
+   { int nwMax=0;
+     for(int nw=1; nw<NW; nw++)
+      if ( Load[nw]/WorkerThreads[nw] > Load[nwMax]/WorkerThreads[nwMax] )
+       nwMax=nw;
+     WorkerThreads[nwMax]++;
+   };
+
+  Log("Evaluating %i Xi points on %i workers:",NumXis,NW);
+  for(int nw=0; nw<NW; nw++)
+   LogC(" %i",WorkerThreads[nw]);
+  LogC(" threads");
+
+  /*--------------------------------------------------------------*/
+  /*- evaluate all points. the master structure's XiConverged    -*/
+  /*- flags are propagated to all workers first, and each point  -*/
+  /*- is written out by its worker as soon as it is done (the    -*/
+  /*- output routines serialize the writes).                     -*/
+  /*--------------------------------------------------------------*/
+  bool Periodic  = (SC3D->G->LDim > 0);
+  double *Work   = new double[NumXis];
+  char *WriteCache=SC3D->WriteCache;
+  SC3D->WriteCache=0;
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static,1), num_threads(NW)
+#endif
+  for(int nw=0; nw<NW; nw++)
+   { 
+#ifdef USE_OPENMP
+     omp_set_num_threads(WorkerThreads[nw]);
+#endif
+     SC3Data *W = SC3D->XiWorkers[nw];
+     if (W!=SC3D)
+      memcpy(W->XiConverged, SC3D->XiConverged, NTNQ*sizeof(bool));
+
+     for(int nXi=0; nXi<NumXis; nXi++)
+      { 
+        if (Owner[nXi]!=nw)
+         continue;
+
+        double Time=Secs();
+        ComputeXiIntegrand(W, Xis[nXi], EFTs + nXi*NTNQ);
+        Work[nXi] = (Secs() - Time)*WorkerThreads[nw];
+
+        WriteXiIntegrand(SC3D, Xis[nXi], EFTs + nXi*NTNQ,
+                         Periodic ? W->BZIArgs->BZIError : 0);
+      };
+   };
+#ifdef USE_OPENMP
+  omp_set_num_threads(NumThreads);
+#endif
+
+  /*--------------------------------------------------------------*/
+  /*- merge the workers' XiConverged flags back into the master  -*/
+  /*- structure and update cost estimates                        -*/
+  /*--------------------------------------------------------------*/
+  for(int nw=1; nw<NW; nw++)
+   for(int ntnq=0; ntnq<NTNQ; ntnq++)
+    if (SC3D->XiWorkers[nw]->XiConverged[ntnq])
+     SC3D->XiConverged[ntnq]=true;
+
+  for(int nXi=0; nXi<NumXis; nXi++)
+   RecordXiCost(SC3D, Xis[nXi], Work[nXi]);
+
+  if (WriteCache)
+   StoreCache(WriteCache);
+
+  delete[] Cost;
+  delete[] Owner;
+  delete[] Assigned;
+  delete[] Load;
+  delete[] WorkerThreads;
+  delete[] Work;
+}
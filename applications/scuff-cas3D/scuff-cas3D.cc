@@ -101,6 +101,9 @@ int main(int argc, char *argv[])
   bool UseExistingData = false;
   bool NewEnergyMethod = false;
   bool WriteHDF5Files  = false;
+  int XiWorkers        = 1;
+  int SeparationNodes  = 0;
+  double SeparationTol = 1.0e-6;
 
 //
   /* name               type    #args  max_instances  storage           count         description*/
@@ -125,6 +128,10 @@ int main(int argc, char *argv[])
      {"Intervals",      PA_INT,     1, 1,       (void *)&Intervals,     0,             "number of subintervals for frequency quadrature"},
      {"AbsTol",         PA_DOUBLE,  1, 1,       (void *)&AbsTol,        0,             "absolute tolerance for sums and integrations"},
      {"RelTol",         PA_DOUBLE,  1, 1,       (void *)&RelTol,        0,             "relative tolerance for sums and integrations"},
+     {"XiWorkers",      PA_INT,     1, 1,       (void *)&XiWorkers,     0,             "number of Xi points to evaluate concurrently"},
+//
+     {"SeparationNodes", PA_INT,    1, 1,       (void *)&SeparationNodes, 0,           "number of nodes for interpolating BEM blocks in separation"},
+     {"SeparationTol",  PA_DOUBLE,  1, 1,       (void *)&SeparationTol, 0,             "relative accuracy of separation interpolation"},
 //
      {"FileBase",       PA_STRING,  1, 1,       (void *)&FileBase,      0,             "base filename for output files"},
 //
@@ -273,15 +280,26 @@ int main(int argc, char *argv[])
   SC3D->UseExistingData    = UseExistingData;
   SC3D->MaxXiPoints        = MaxXiPoints;
   SC3D->XiMin              = XiMin;
+  SC3D->SeparationNodes    = SeparationNodes;
+  SC3D->SeparationTol      = SeparationTol;
+  if (SeparationNodes>0)
+   SC3D->UBCache->PlanSeparationInterpolation(SC3D->GTCs, SeparationNodes, SeparationTol);
 
   if (G->LDim>=1)
    { UpdateBZIArgs(BZIArgs, G->RLBasis, G->RLVolume);
-     BZIArgs->BZIFunc  = GetCasimirIntegrand;
-     BZIArgs->UserData = (void *)SC3D;
-     BZIArgs->FDim     = SC3D->NTNQ;
-     SC3D->BZIArgs     = BZIArgs;
+     BZIArgs->BZIFunc   = GetCasimirIntegrand;
+     BZIArgs->BZIFunc_v = GetCasimirIntegrands_v;
+     BZIArgs->UserData  = (void *)SC3D;
+     BZIArgs->FDim      = SC3D->NTNQ;
+     SC3D->BZIArgs      = BZIArgs;
    };
 
+  /*******************************************************************/
+  /* create additional copies of the SC3Data structure for           */
+  /* concurrent evaluation of several Xi points                      */
+  /*******************************************************************/
+  InitXiWorkers(SC3D, XiWorkers);
+
   /*******************************************************************/
   /* now switch off based on the requested frequency behavior to     */
   /* perform the actual calculations                                 */
@@ -302,8 +320,14 @@ int main(int argc, char *argv[])
    }
   else if ( XiPoints )
    { 
-     for (int nr=0; nr<XiPoints->NR; nr++)
-      GetXiIntegrand(SC3D, XiPoints->GetEntryD(nr,0), EFT);
+     int NumXis = XiPoints->NR;
+     double *Xis = new double[NumXis];
+     double *EFTs = new double[NumXis*SC3D->NTNQ];
+     for (int nr=0; nr<NumXis; nr++)
+      Xis[nr] = XiPoints->GetEntryD(nr,0);
+     GetXiIntegrands(SC3D, NumXis, Xis, EFTs);
+     delete[] Xis;
+     delete[] EFTs;
    }
   else if ( Temperature > 0.0)
    { 
@@ -340,6 +364,7 @@ int main(int argc, char *argv[])
    };
 
   delete[] EFT;
+  CloseResultTables(SC3D);
 
   /***************************************************************/
   /***************************************************************/
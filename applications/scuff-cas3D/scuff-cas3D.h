@@ -101,6 +101,13 @@ typedef struct SC3Data
 
    char *FileBase, *ByXiFileName, *ByXiKFileName, *OutFileName;
 
+   // binary (HDF5) versions of the .byXi and .byXikBloch files,
+   // nonzero only if requested by SCUFF_OUTPUT_FORMAT. these
+   // are owned by the main SC3Data structure and shared by
+   // all Xi workers.
+   int OutputFormat;
+   ResultTable *ByXiTable, *ByXiKTable;
+
    // adaptive frequency integration limits
    double XiMin;
    int MaxXiPoints, MaxkBlochPoints;
@@ -114,15 +121,40 @@ typedef struct SC3Data
    bool UseExistingData;
    bool WriteHDF5Files;
    char *WriteCache;
+   char *TransFile;
+
+   // off-diagonal blocks computed at the current frequency,
+   // keyed by the relative pose of the two surfaces
+   UBlockCache *UBCache;
+
+   // number of Chebyshev nodes and accuracy for interpolating
+   // off-diagonal blocks in the separation between surfaces
+   // (SeparationNodes=0 to disable)
+   int SeparationNodes;
+   double SeparationTol;
+
+   // items relevant for concurrent evaluation of several Xi
+   // points (see XiScheduler.cc). XiWorkers[nw] is a private
+   // copy of this structure, with its own RWGGeometry and
+   // matrix storage, used by worker #nw. XiCostXi, XiCostWork
+   // record the measured cost (in thread-seconds) of previous
+   // Xi evaluations and are used to apportion threads.
+   int NumXiWorkers;
+   struct SC3Data **XiWorkers;
+   int NumXiCosts;
+   double *XiCostXi, *XiCostWork;
 
  } SC3Data;
 
 SC3Data *CreateSC3Data(RWGGeometry *G, char *TransFile,
                        int WhichQuantities, int NumQuantities,
                        int NumTorqueAxes, double TorqueAxes[9],
-                       bool NewEnergyMethod, char *FileBase);
+                       bool NewEnergyMethod, char *FileBase,
+                       bool WritePreambles=true);
 
 void WriteFilePreamble(SC3Data *SC3D, int PreambleType);
+void CreateResultTables(SC3Data *SC3D);
+void CloseResultTables(SC3Data *SC3D);
 
 /***************************************************************/
 /* The total Casimir energy (or force, or torque) is an        */
@@ -146,10 +178,22 @@ void WriteFilePreamble(SC3Data *SC3D, int PreambleType);
 /***************************************************************/
 void GetCasimirIntegrand(void *SC3D, cdouble Omega, double *kBloch, double *EFT);
 void GetXiIntegrand(SC3Data *SC3D, double Xi, double *EFT);
+void ComputeXiIntegrand(SC3Data *SC3D, double Xi, double *EFT);
+void WriteXiIntegrand(SC3Data *SC3D, double Xi, double *EFT, double *Error);
 void GetXiIntegral_Adaptive(SC3Data *SC3D, double *EFT, double *Error);
 void GetXiIntegral_TrapSimp(SC3Data *SC3D, int NumIntervals, double *I, double *E);
 void GetXiIntegral_Cliff(SC3Data *SC3D, double *EFT, double *Error);
 void GetMatsubaraSum(SC3Data *SC3D, double Temperature, double *EFT, double *Error);
 bool CacheRead(SC3Data *SC3D, double Xi, double *kBloch, double *EFT);
 
+/***************************************************************/
+/* in XiScheduler.cc: evaluate several Xi points concurrently, */
+/* each on a private copy of the SC3Data structure with its    */
+/* own share of the available threads                          */
+/***************************************************************/
+void InitXiWorkers(SC3Data *SC3D, int NumXiWorkers);
+void GetXiIntegrands(SC3Data *SC3D, int NumXis, double *Xis, double *EFTs);
+void GetCasimirIntegrands_v(void *pSC3D, cdouble Omega, int NumPoints,
+                            double *kBlochs, double *EFTs);
+
 #endif // #define SCUFFCAS3D_H
@@ -0,0 +1,142 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * scuff-exportTable.cc -- a little application to convert the binary
+ *                      -- HDF5 result tables written by scuff-neq,
+ *                      -- scuff-cas3D, and scuff-ldos (when run with
+ *                      -- SCUFF_OUTPUT_FORMAT=hdf5) to text files
+ *
+ * --------------------------------------------------------------
+ *
+ * usage:
+ *
+ *   scuff-exportTable --table MyGeometry.byXi.h5 [--table ...]
+ *
+ * options:
+ *
+ *  --table  xx  (HDF5 result table to convert; may be repeated)
+ *  --output xx  (name of text file to write; only allowed with
+ *                a single --table. default is the name of the
+ *                table with the .h5 extension removed, which is
+ *                the name of the text file the application would
+ *                have written.)
+ *
+ * --------------------------------------------------------------
+ *
+ * each line of the output file contains the tag (transformation
+ * label), the key columns (frequency, Bloch vector, ...), and the
+ * value columns of one row of the table, in the order in which
+ * the rows were computed; a comment header lists the column names.
+ * existing files are never overwritten.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libhrutil.h"
+#include "libhmat.h"
+
+#define MAXTABLES 100
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  InitializeLog(argv[0]);
+
+  /***************************************************************/
+  /* process command-line arguments ******************************/
+  /***************************************************************/
+  char *Tables[MAXTABLES];   int nTables=0;
+  char *OutFileName=0;
+  /* name        type    #args  max_instances  storage    count  description*/
+  OptStruct OSArray[]=
+   { {"table",       PA_STRING,  1, MAXTABLES, (void *)Tables, &nTables, "HDF5 result table"},
+     {"output",      PA_STRING,  1, 1, (void *)&OutFileName,    0,  "name of output text file"},
+     {0,0,0,0,0,0,0}
+   };
+  ProcessOptions(argc, argv, OSArray);
+  if (nTables==0)
+   OSUsage(argv[0], OSArray, "you must specify at least one --table");
+  if (OutFileName && nTables>1)
+   OSUsage(argv[0], OSArray, "--output may only be used with a single --table");
+
+  /***************************************************************/
+  /***************************************************************/
+  /***************************************************************/
+  int NumFailed=0;
+  for(int nt=0; nt<nTables; nt++)
+   {
+     char *TextFileName;
+     if (OutFileName)
+      TextFileName = strdupEC(OutFileName);
+     else
+      { TextFileName = strdupEC(Tables[nt]);
+        int Len=strlen(TextFileName);
+        if (Len>3 && !strcmp(TextFileName+Len-3,".h5"))
+         TextFileName[Len-3]=0;
+        else
+         { free(TextFileName);
+           TextFileName=vstrdup("%s.txt",Tables[nt]);
+         };
+      };
+
+     FILE *f=fopen(TextFileName,"r");
+     if (f)
+      { fclose(f);
+        Warn("file %s exists (skipping table %s)",TextFileName,Tables[nt]);
+        free(TextFileName);
+        NumFailed++;
+        continue;
+      };
+
+     ResultTable *RT=new ResultTable(Tables[nt]);
+     if (RT->ErrMsg)
+      { Warn("%s (skipping)",RT->ErrMsg);
+        delete RT;
+        free(TextFileName);
+        NumFailed++;
+        continue;
+      };
+
+     f=fopen(TextFileName,"w");
+     if (!f)
+      { Warn("could not open file %s (skipping table %s)",TextFileName,Tables[nt]);
+        delete RT;
+        free(TextFileName);
+        NumFailed++;
+        continue;
+      };
+     fprintf(f,"# exported from %s by scuff-exportTable on %s ",Tables[nt],GetHostName());
+     fprintf(f,"%s\n",GetTimeString());
+     fprintf(f,"# columns: \n");
+     for(int nc=0; nc<1+RT->NumKeys+RT->NumValues; nc++)
+      fprintf(f,"# %i: %s\n",nc+1,RT->ColumnNames[nc]);
+     fclose(f);
+
+     int NumRows=RT->ExportToText(TextFileName, true);
+     printf("Wrote %i rows from %s to %s.\n",NumRows,Tables[nt],TextFileName);
+     delete RT;
+     free(TextFileName);
+   };
+
+  return NumFailed==0 ? 0 : 1;
+}
@@ -103,12 +103,15 @@ SLDData *CreateSLDData(char *GeoFile, char *TransFile,
   Data->MaxEvals    = 100000;
   Data->HalfSpaceMP = 0;
   Data->GroundPlane = false;
+  Data->NumWorkers = 1;
+  Data->Workers    = 0;
 
   /***************************************************************/
   /* read in geometry and allocate BEM matrix and RHS vector     */
   /***************************************************************/
   RWGGeometry *G = Data->G = new RWGGeometry(GeoFile);
   Data->M = G->AllocateBEMMatrix();
+  Data->Workspace = new SCUFFWorkspace();
 
   /***************************************************************/
   /* read in geometrical transformation file if any **************/
@@ -181,6 +184,13 @@ SLDData *CreateSLDData(char *GeoFile, char *TransFile,
   for(int nm=0; nm<NumXMatrices; nm++)
    Data->WrotePreamble[0][nm]=Data->WrotePreamble[1][nm]=false;
 
+  // HDF5 tables are created on first use (see WriteData)
+  Data->OutputFormat = GetResultFormat();
+  Data->Tables[0] = (ResultTable **)mallocEC(NumXMatrices*sizeof(ResultTable *));
+  Data->Tables[1] = (ResultTable **)mallocEC(NumXMatrices*sizeof(ResultTable *));
+  for(int nm=0; nm<NumXMatrices; nm++)
+   Data->Tables[0][nm]=Data->Tables[1][nm]=0;
+
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
@@ -214,3 +224,15 @@ SLDData *CreateSLDData(char *GeoFile, char *TransFile,
   return Data;
 }
 
+/***************************************************************/
+/* flush and close the HDF5 tables (main structure only)       */
+/***************************************************************/
+void CloseResultTables(SLDData *Data)
+{
+  for(int FileType=0; FileType<2; FileType++)
+   for(int nm=0; nm<Data->NumXMatrices; nm++)
+    if (Data->Tables[FileType][nm])
+     { delete Data->Tables[FileType][nm];
+       Data->Tables[FileType][nm]=0;
+     };
+}
@@ -27,11 +27,62 @@
 #include "libscuff.h"
 #include "scuff-ldos.h"
 
+#ifdef USE_OPENMP
+#  include <omp.h>
+#endif
+
 #define ABSTOL 1.0e-20
 #define MAXSTR 1000
 
 using namespace scuff;
 
+/***************************************************************/
+/* create an HDF5 table with the same columns as a .LDOS,      */
+/* .2PDGF, or .byOmegakBloch file                              */
+/***************************************************************/
+static const char *FunNames[38]=
+ { "ELDOS", "MLDOS",
+   "ReGExx", "ImGExx", "ReGExy", "ImGExy", "ReGExz", "ImGExz",
+   "ReGEyx", "ImGEyx", "ReGEyy", "ImGEyy", "ReGEyz", "ImGEyz",
+   "ReGEzx", "ImGEzx", "ReGEzy", "ImGEzy", "ReGEzz", "ImGEzz",
+   "ReGMxx", "ImGMxx", "ReGMxy", "ImGMxy", "ReGMxz", "ImGMxz",
+   "ReGMyx", "ImGMyx", "ReGMyy", "ImGMyy", "ReGMyz", "ImGMyz",
+   "ReGMzx", "ImGMzx", "ReGMzy", "ImGMzy", "ReGMzz", "ImGMzz"
+ };
+
+static ResultTable *CreateResultTable(const char *FileName, int NumKeys,
+                                      bool TwoPointDGF, int NFun, bool HaveErrors)
+{
+  const char *KeyNames[10]
+   ={"x", "y", "z", "ReOmega", "ImOmega", "kx", "ky", 0, 0, 0};
+  if (TwoPointDGF)
+   { const char *TPKeyNames[10]
+      ={"xDest", "yDest", "zDest", "xSource", "ySource", "zSource",
+        "ReOmega", "ImOmega", "kx", "ky"};
+     memcpy(KeyNames, TPKeyNames, 10*sizeof(const char *));
+   };
+
+  int NV = HaveErrors ? 2*NFun : NFun;
+  char **ValueNames = (char **)mallocEC(NV*sizeof(char *));
+  for(int nf=0; nf<NFun; nf++)
+   { ValueNames[nf] = strdupEC(FunNames[nf]);
+     if (HaveErrors)
+      ValueNames[NFun+nf] = vstrdup("%sError",FunNames[nf]);
+   };
+
+  char *TableName = vstrdup("%s.h5",FileName);
+  ResultTable *RT
+   = new ResultTable(TableName, NumKeys, KeyNames, NV, (const char **)ValueNames);
+  if (RT->ErrMsg)
+   ErrExit(RT->ErrMsg);
+
+  free(TableName);
+  for(int nv=0; nv<NV; nv++)
+   free(ValueNames[nv]);
+  free(ValueNames);
+  return RT;
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -58,43 +109,88 @@ void WriteData(SLDData *Data, cdouble Omega, double *kBloch,
   else
    snprintf(FileName,MAXSTR,"%s.%s.%s",FileBase,EPFileBase,Extension);
 
-  bool HaveGTCList = (Data->GTCs.size()!=0);
-  if ( Data->WrotePreamble[FileType][WhichMatrix] == false )
-   { Data->WrotePreamble[FileType][WhichMatrix] = true;
-     WriteFilePreamble(FileName, FileType, LDim, HaveGTCList, TwoPointDGF);
-   };
-
   int NFun = (Data->LDOSOnly ? 2 : 38);
   int Offset=0;
   for(int nm=0; nm<WhichMatrix; nm++)
    Offset += NFun * (Data->XMatrices[nm]->NR);
-  
-  FILE *f=fopen(FileName,"a");
-  for(int nx=0; nx<XMatrix->NR; nx++)
+
+  bool HaveGTCList = (Data->GTCs.size()!=0);
+
+  // the workers share the output files (and the WrotePreamble
+  // flags and tables), so writes are serialized
+#ifdef USE_OPENMP
+#pragma omp critical(SLDWriteData)
+#endif
+  if (Data->OutputFormat & RESULT_FORMAT_TEXT)
+   {
+     if ( Data->WrotePreamble[FileType][WhichMatrix] == false )
+      { Data->WrotePreamble[FileType][WhichMatrix] = true;
+        WriteFilePreamble(FileName, FileType, LDim, HaveGTCList, TwoPointDGF);
+      };
+
+     FILE *f=fopen(FileName,"a");
+     for(int nx=0; nx<XMatrix->NR; nx++)
+      { 
+        double X[6];
+        XMatrix->GetEntriesD(nx,":",X);
+
+        fprintf(f,"%e %e %e ", X[0],X[1],X[2]);
+        if (TwoPointDGF)
+         fprintf(f,"%e %e %e ", X[3],X[4],X[5]);
+        fprintf(f,"%e %e ",real(Omega),imag(Omega));
+        if (HaveGTCList)
+         fprintf(f,"%s ",Data->GTCs[WhichTransform]->Tag);
+        if (FileType==FILETYPE_BYK && LDim>0 && kBloch!=0)
+         for(int nd=0; nd<LDim; nd++)
+          fprintf(f,"%e ",kBloch[nd]);
+
+        for(int nf=0; nf<NFun; nf++)
+         fprintf(f,"%e ",Result[Offset + NFun*nx + nf]);
+
+        if (Error)
+         for(int nf=0; nf<NFun; nf++) 
+          fprintf(f,"%e ",Error[Offset + NFun*nx + nf]);
+
+        fprintf(f,"\n");
+      };
+     fclose(f);
+   };
+
+  if (Data->OutputFormat & RESULT_FORMAT_HDF5)
    { 
-     double X[6];
-     XMatrix->GetEntriesD(nx,":",X);
-
-     fprintf(f,"%e %e %e ", X[0],X[1],X[2]);
-     if (TwoPointDGF)
-      fprintf(f,"%e %e %e ", X[3],X[4],X[5]);
-     fprintf(f,"%e %e ",real(Omega),imag(Omega));
-     if (HaveGTCList)
-      fprintf(f,"%s ",Data->GTCs[WhichTransform]->Tag);
+     // keys: evaluation point(s), Omega, and (for .byOmegakBloch) kBloch
+     int NumKeys = (TwoPointDGF ? 6 : 3) + 2;
      if (FileType==FILETYPE_BYK && LDim>0 && kBloch!=0)
-      for(int nd=0; nd<LDim; nd++)
-       fprintf(f,"%e ",kBloch[nd]);
+      NumKeys += LDim;
 
-     for(int nf=0; nf<NFun; nf++)
-      fprintf(f,"%e ",Result[Offset + NFun*nx + nf]);
+#ifdef USE_OPENMP
+#pragma omp critical(SLDCreateTable)
+#endif
+     if (Data->Tables[FileType][WhichMatrix]==0)
+      Data->Tables[FileType][WhichMatrix]
+       = CreateResultTable(FileName, NumKeys, TwoPointDGF, NFun, Error!=0);
+     ResultTable *RT = Data->Tables[FileType][WhichMatrix];
 
-     if (Error)
-      for(int nf=0; nf<NFun; nf++) 
-       fprintf(f,"%e ",Error[Offset + NFun*nx + nf]);
+     const char *Tag = HaveGTCList ? Data->GTCs[WhichTransform]->Tag : "DEFAULT";
+     double Keys[10], *Values = new double[2*NFun];
+     for(int nx=0; nx<XMatrix->NR; nx++)
+      { 
+        int nk = TwoPointDGF ? 6 : 3;
+        XMatrix->GetEntriesD(nx,":",Keys);
+        Keys[nk++] = real(Omega);
+        Keys[nk++] = imag(Omega);
+        for(int nd=nk; nd<NumKeys; nd++)
+         Keys[nd] = kBloch[nd-nk];
 
-     fprintf(f,"\n");
+        for(int nf=0; nf<NFun; nf++)
+         { Values[nf] = Result[Offset + NFun*nx + nf];
+           if (Error)
+            Values[NFun+nf] = Error[Offset + NFun*nx + nf];
+         };
+        RT->Append(Tag, Keys, Values);
+      };
+     delete[] Values;
    };
-  fclose(f);
 }
 
 /***************************************************************/
@@ -187,7 +283,7 @@ void GetLDOS(void *pData, cdouble Omega, double *kBloch,
      M->LUFactorize();
      for(int nm=0; nm<NumXMatrices; nm++)
       G->GetDyadicGFs(Omega, kBloch, XMatrices[nm], M, GMatrices[nm],
-                      ScatteringOnly);
+                      ScatteringOnly, Data->Workspace);
    }
   else 
    {
@@ -225,7 +321,7 @@ void GetLDOS(void *pData, cdouble Omega, double *kBloch,
         for(int nm=0; nm<NumXMatrices; nm++)
          G->GetDyadicGFs(Omega, kBloch, XMatrices[nm], M,
                          GMatrices[nt*NumXMatrices + nm],
-                         ScatteringOnly);
+                         ScatteringOnly, Data->Workspace);
 
         G->UnTransform();
       };
@@ -282,3 +378,122 @@ void GetLDOS(void *pData, cdouble Omega, double *kBloch,
    }; // for(int nm=0; nm<NumXMatrices; nm++)
 
 }
+
+/***************************************************************/
+/* create NumWorkers-1 additional copies of the SLDData        */
+/* structure (worker #0 is Data itself) for evaluating several */
+/* (Omega, kBloch) points concurrently. this must be called    */
+/* after Data is fully initialized.                            */
+/***************************************************************/
+void InitLDOSWorkers(SLDData *Data, int NumWorkers,
+                     char *GeoFile, char *TransFile,
+                     char **EPFiles, int nEPFiles)
+{
+  if (NumWorkers<=1)
+   return;
+
+  int NumThreads = GetNumThreads();
+  if (NumWorkers > NumThreads)
+   { Warn("%i workers requested but only %i threads available (using %i)",
+           NumWorkers,NumThreads,NumThreads);
+     NumWorkers=NumThreads;
+     if (NumWorkers<=1) 
+      return;
+   };
+
+  Log("Creating %i workers...",NumWorkers);
+
+  Data->NumWorkers = NumWorkers;
+  Data->Workers = (SLDData **)mallocEC(NumWorkers*sizeof(SLDData *));
+  Data->Workers[0] = Data;
+  for(int nw=1; nw<NumWorkers; nw++)
+   { 
+     SLDData *W = CreateSLDData(GeoFile, TransFile, EPFiles, nEPFiles);
+     W->G->SetLogLevel(Data->G->LogLevel);
+
+     W->RelTol         = Data->RelTol;
+     W->AbsTol         = Data->AbsTol;
+     W->MaxEvals       = Data->MaxEvals;
+     W->FileBase       = Data->FileBase;
+     W->LDOSOnly       = Data->LDOSOnly;
+     W->ScatteringOnly = Data->ScatteringOnly;
+     W->GroundPlane    = Data->GroundPlane;
+     if (Data->HalfSpaceMP)
+      W->HalfSpaceMP   = new MatProp(Data->HalfSpaceMP->Name);
+
+     // all workers append to the same output files
+     free(W->WrotePreamble[0]);
+     free(W->WrotePreamble[1]);
+     W->WrotePreamble[0] = Data->WrotePreamble[0];
+     W->WrotePreamble[1] = Data->WrotePreamble[1];
+     free(W->Tables[0]);
+     free(W->Tables[1]);
+     W->Tables[0] = Data->Tables[0];
+     W->Tables[1] = Data->Tables[1];
+
+     Data->Workers[nw] = W;
+   };
+
+#ifdef USE_OPENMP
+  omp_set_max_active_levels(2);
+#endif
+
+  Log("...done creating workers: mem=%3.1f GB",GetMemoryUsage()/1.0e9);
+}
+
+/***************************************************************/
+/* compute the LDOS at NumPoints (Omega, kBloch) points, with  */
+/* Omega=Omegas[np] and kBloch=kBlochs+3*np (kBlochs=0 for     */
+/* non-periodic geometries). the points are dealt out          */
+/* round-robin to the workers, each of which gets an equal     */
+/* share of the thread pool. on return, Results + np*FDim is   */
+/* the result vector for point #np.                            */
+/***************************************************************/
+void GetLDOSBatch(SLDData *Data, int NumPoints, cdouble *Omegas,
+                  double *kBlochs, double *Results)
+{
+  int FDim = Data->TotalEvalPoints * (Data->LDOSOnly ? 2 : 38);
+  int NW   = Data->NumWorkers;
+  if (NW > NumPoints)
+   NW = NumPoints;
+
+  if (NW<=1)
+   { for(int np=0; np<NumPoints; np++)
+      GetLDOS((void *)Data, Omegas[np], kBlochs ? kBlochs + 3*np : 0,
+              Results + np*FDim);
+     return;
+   };
+
+  int NumThreads = GetNumThreads();
+  Log("Evaluating %i points on %i workers",NumPoints,NW);
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(static,1), num_threads(NW)
+#endif
+  for(int nw=0; nw<NW; nw++)
+   { 
+#ifdef USE_OPENMP
+     omp_set_num_threads( NumThreads/NW + (nw < NumThreads%NW ? 1 : 0) );
+#endif
+     SLDData *W = Data->Workers[nw];
+     for(int np=nw; np<NumPoints; np+=NW)
+      GetLDOS((void *)W, Omegas[np], kBlochs ? kBlochs + 3*np : 0,
+              Results + np*FDim);
+   };
+#ifdef USE_OPENMP
+  omp_set_num_threads(NumThreads);
+#endif
+}
+
+/***************************************************************/
+/* batched version of GetLDOS for use by the BZ integrator     */
+/***************************************************************/
+void GetLDOS_v(void *pData, cdouble Omega, int NumPoints,
+               double *kBlochs, double *Results)
+{
+  cdouble *Omegas = new cdouble[NumPoints];
+  for(int np=0; np<NumPoints; np++)
+   Omegas[np]=Omega;
+  GetLDOSBatch((SLDData *)pData, NumPoints, Omegas, kBlochs, Results);
+  delete[] Omegas;
+}
@@ -76,6 +76,8 @@ int main(int argc, char *argv[])
   char *FileBase=0;
   bool LDOSOnly=false;
   bool FullTPDGF=false;
+/**/
+  int Workers=1;
 /**/
   /* name        type    #args  max_instances  storage    count  description*/
   OptStruct OSArray[]=
@@ -102,6 +104,8 @@ int main(int argc, char *argv[])
      {"FileBase",    PA_STRING,  1, 1, (void *)&FileBase,      0,  "base name for output files"},
      {"LDOSOnly",    PA_BOOL,    0, 1, (void *)&LDOSOnly,      0,  "omit DGF components from Brillouin-zone integration"},
      {"FullTPDGF",   PA_BOOL,    0, 1, (void *)&FullTPDGF,     0,  "compute full (bare+scattered) two-point DGF (default is scattering part only)"},
+//
+     {"Workers",     PA_INT,     1, 1, (void *)&Workers,       0,  "number of frequencies or Bloch vectors to evaluate concurrently"},
      {0,0,0,0,0,0,0}
    };
   ProcessOptions(argc, argv, OSArray);
@@ -179,6 +183,12 @@ int main(int argc, char *argv[])
   int FDim       = NX*NFun;
   double *Result = (double *)mallocEC(FDim*sizeof(double));
 
+  /***************************************************************/
+  /* create workers for evaluating several (Omega, kBloch)       */
+  /* points at once if requested                                 */
+  /***************************************************************/
+  InitLDOSWorkers(Data, Workers, GeoFile, TransFile, EPFiles, nEPFiles);
+
   /***************************************************************/
   /* now switch off to figure out what to do:                    */
   /*  1. if we have a non-periodic geometry, simply evaluate     */
@@ -200,8 +210,14 @@ int main(int argc, char *argv[])
   /*--------------------------------------------------------------*/
   if (LDim==0)
    {  
-     for(int no=0; no<OmegaPoints->N; no++)
-      GetLDOS( (void *)Data, OmegaPoints->GetEntry(no), 0, Result);
+     int NO=OmegaPoints->N;
+     cdouble *Omegas  = new cdouble[NO];
+     double *Results  = new double[NO*FDim];
+     for(int no=0; no<NO; no++)
+      Omegas[no]=OmegaPoints->GetEntry(no);
+     GetLDOSBatch(Data, NO, Omegas, 0, Results);
+     delete[] Omegas;
+     delete[] Results;
    }
   /*--------------------------------------------------------------*/
   /*- PBC structure with specified kBloch points: do a periodic   */
@@ -209,16 +225,23 @@ int main(int argc, char *argv[])
   /*--------------------------------------------------------------*/
   else if (OkBPoints)
    {  
-     for(int nokb=0; nokb<OkBPoints->NR; nokb++)
+     int NOkB=OkBPoints->NR;
+     cdouble *Omegas = new cdouble[NOkB];
+     double *kBlochs = new double[3*NOkB];
+     double *Results = new double[NOkB*FDim];
+     for(int nokb=0; nokb<NOkB; nokb++)
       { 
-        cdouble Omega=OkBPoints->GetEntry(nokb,0);
+        Omegas[nokb]=OkBPoints->GetEntry(nokb,0);
 
-        double kBloch[3]={0.0, 0.0, 0.0};
+        double *kBloch=kBlochs + 3*nokb;
+        kBloch[0]=kBloch[1]=kBloch[2]=0.0;
         for(int d=0; d<LDim; d++)
          kBloch[d]=OkBPoints->GetEntryD(nokb,1+d);
-
-        GetLDOS( (void *)Data, Omega, kBloch, Result);
       };
+     GetLDOSBatch(Data, NOkB, Omegas, kBlochs, Results);
+     delete[] Omegas;
+     delete[] kBlochs;
+     delete[] Results;
    }
   /*--------------------------------------------------------------*/
   /*- PBC structure without specified kBloch points: perform a    */
@@ -231,6 +254,7 @@ int main(int argc, char *argv[])
      /* that we started to initialize above                         */
      /***************************************************************/
      BZIArgs->BZIFunc     = GetLDOS;
+     BZIArgs->BZIFunc_v   = GetLDOS_v;
      BZIArgs->UserData    = (void *)Data;
      BZIArgs->FDim        = FDim;
      UpdateBZIArgs(BZIArgs, Data->G->RLBasis, Data->G->RLVolume);
@@ -246,4 +270,5 @@ int main(int argc, char *argv[])
       };
    };
 
+  CloseResultTables(Data);
 }
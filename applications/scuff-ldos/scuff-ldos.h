@@ -45,11 +45,14 @@ typedef struct SLDData
    // data on the BEM geometry and linear algebra workspaces
    RWGGeometry *G;
    HMatrix *M;
+   SCUFFWorkspace *Workspace;
 
    // data on evaluation points and DGFs at evaluation points
    HMatrix **XMatrices, **GMatrices;
    char **EPFileBases;
    bool *WrotePreamble[2];
+   int OutputFormat;         // RESULT_FORMAT_xx bitmask
+   ResultTable **Tables[2];  // HDF5 counterparts of the output files
    int NumXMatrices;
    int TotalEvalPoints;
 
@@ -74,6 +77,14 @@ typedef struct SLDData
    cdouble Omega;
    double *kBloch;
 
+   // items relevant for concurrent evaluation of several
+   // frequencies, or of the batches of Bloch vectors requested
+   // by the BZ integrator. Workers[nw] is a private copy of this
+   // structure, with its own RWGGeometry and matrix storage,
+   // used by worker #nw.
+   int NumWorkers;
+   struct SLDData **Workers;
+
  } SLDData;
 
 /***************************************************************/
@@ -85,6 +96,7 @@ void WriteFilePreamble(char *FileName, int FileType, int LDim,
                        bool HaveGTCList, bool TwoPointDGF);
 SLDData *CreateSLDData(char *GeoFile, char *TransFile,
                        char **EPFiles, int nEPFiles);
+void CloseResultTables(SLDData *Data);
 
 // GetLDOS.cc
 void WriteData(SLDData *Data, cdouble Omega, double *kBloch,
@@ -94,6 +106,13 @@ void WriteData(SLDData *Data, cdouble Omega, double *kBloch,
                int FileType, double *Result, double *Error);
 void GetLDOS(void *Data, cdouble Omega, double *kBloch, 
              double *Result);
+void InitLDOSWorkers(SLDData *Data, int NumWorkers,
+                     char *GeoFile, char *TransFile,
+                     char **EPFiles, int nEPFiles);
+void GetLDOSBatch(SLDData *Data, int NumPoints, cdouble *Omegas,
+                  double *kBlochs, double *Results);
+void GetLDOS_v(void *Data, cdouble Omega, int NumPoints,
+               double *kBlochs, double *Results);
 
 /***************************************************************/
 // AnalyticalDGFs.cc
@@ -68,6 +68,19 @@ void WriteSIFluxFilePreamble(SNEQData *SNEQD, char *FileName, bool ByRegion=fals
   fclose(f);
 }
 
+const char *SIFluxKeyNames[SIFLUX_NUMKEYS]=
+ { "Omega", "kx", "ky", "SourceSurface", "DestSurface" };
+
+const char *SRFluxKeyNames[SRFLUX_NUMKEYS]=
+ { "Omega", "kx", "ky", "x", "y", "z", "SourceSurface" };
+
+const char *SRFluxValueNames[NUMSRFLUX]=
+ { "Px",  "Py",  "Pz",
+   "Txx", "Txy", "Txz",
+   "Tyx", "Tyy", "Tyz",
+   "Tzx", "Tzy", "Tzz"
+ };
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -115,6 +128,7 @@ SNEQData *CreateSNEQData(char *GeoFile, char *TransFile,
   InitPFTOptions( &(SNEQD->PFTOpts) );
   SNEQD->NumPFTMethods = NumPFTMethods;
   SNEQD->DSIOmegaPoints=0;
+  SNEQD->OutputFormat = GetResultFormat();
   for(int npm=0; npm<NumPFTMethods; npm++)
    { 
      SNEQD->PFTMethods[npm] = PFTMethods[npm];
@@ -135,7 +149,18 @@ SNEQData *CreateSNEQData(char *GeoFile, char *TransFile,
 
      SNEQD->SIFluxFileNames[npm]
       = vstrdup("%s.SIFlux.%s",SNEQD->FileBase,PFTName);
-     WriteSIFluxFilePreamble(SNEQD, SNEQD->SIFluxFileNames[npm]);
+     if (SNEQD->OutputFormat & RESULT_FORMAT_TEXT)
+      WriteSIFluxFilePreamble(SNEQD, SNEQD->SIFluxFileNames[npm]);
+
+     SNEQD->SIFluxTables[npm]=0;
+     if (SNEQD->OutputFormat & RESULT_FORMAT_HDF5)
+      { ResultTable *RT = new ResultTable(vstrdup("%s.h5",SNEQD->SIFluxFileNames[npm]),
+                                         SIFLUX_NUMKEYS, SIFluxKeyNames,
+                                         NUMPFT, QuantityNames);
+        if (RT->ErrMsg)
+         ErrExit(RT->ErrMsg);
+        SNEQD->SIFluxTables[npm]=RT;
+      };
    };
   
   int NT = SNEQD->NumTransformations;
@@ -202,6 +227,7 @@ SNEQData *CreateSNEQData(char *GeoFile, char *TransFile,
         SNEQD->U[nb] = new HMatrix(NBF, NBFp, LHM_COMPLEX);
       };
    };
+  SNEQD->UBCache = new UBlockCache(G);
   Log("After T, U blocks: mem=%3.1f GB",GetMemoryUsage()/1.0e9);
 
   /*--------------------------------------------------------------*/
@@ -214,7 +240,16 @@ SNEQData *CreateSNEQData(char *GeoFile, char *TransFile,
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
-  if (SNEQD->NumSRQs>0)
+  SNEQD->SRFluxTable=0;
+  if (SNEQD->NumSRQs>0 && (SNEQD->OutputFormat & RESULT_FORMAT_HDF5) )
+   { SNEQD->SRFluxTable = new ResultTable(vstrdup("%s.SRFlux.h5",SNEQD->FileBase),
+                                          SRFLUX_NUMKEYS, SRFluxKeyNames,
+                                          NUMSRFLUX, SRFluxValueNames);
+     if (SNEQD->SRFluxTable->ErrMsg)
+      ErrExit(SNEQD->SRFluxTable->ErrMsg);
+   };
+
+  if (SNEQD->NumSRQs>0 && (SNEQD->OutputFormat & RESULT_FORMAT_TEXT) )
    { FILE *f=vfopen("%s.SRFlux","a",SNEQD->FileBase);
      fprintf(f,"\n");
      fprintf(f,"# scuff-neq run on %s (%s)\n",GetHostName(),GetTimeString());
@@ -247,7 +282,8 @@ SNEQData *CreateSNEQData(char *GeoFile, char *TransFile,
      SNEQD->RegionRegionPFT = (HMatrix **)mallocEC( NumPFTMethods*sizeof(HMatrix *));
      for(int npm=0; npm<NumPFTMethods; npm++)
       { SNEQD->RegionRegionPFT[npm]=new HMatrix( (NR+1)*(NR+1), NUMPFT);
-        WriteSIFluxFilePreamble(SNEQD, SNEQD->SIFluxFileNames[npm], true);
+        if (SNEQD->OutputFormat & RESULT_FORMAT_TEXT)
+         WriteSIFluxFilePreamble(SNEQD, SNEQD->SIFluxFileNames[npm], true);
       };
    };
 
@@ -255,3 +291,19 @@ SNEQData *CreateSNEQData(char *GeoFile, char *TransFile,
   return SNEQD;
 
 }
+
+/***************************************************************/
+/* flush and close any binary output tables                    */
+/***************************************************************/
+void CloseResultTables(SNEQData *SNEQD)
+{
+  for(int npm=0; npm<SNEQD->NumPFTMethods; npm++)
+   if (SNEQD->SIFluxTables[npm])
+    { delete SNEQD->SIFluxTables[npm];
+      SNEQD->SIFluxTables[npm]=0;
+    };
+  if (SNEQD->SRFluxTable)
+   { delete SNEQD->SRFluxTable;
+     SNEQD->SRFluxTable=0;
+   };
+}
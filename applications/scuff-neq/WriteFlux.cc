@@ -215,6 +215,10 @@ void WriteFlux(SNEQData *SNEQD, cdouble Omega, double *kBloch)
 
   Log("Computing neq quantities at omega=%s...",z2s(Omega));
 
+  // U blocks from other frequencies or Bloch vectors are of no further use
+  UBlockCache *UBCache = SNEQD->UBCache;
+  UBCache->Clear(Omega);
+
   /***************************************************************/
   /* preinitialize an argument structure for the BEM matrix      */
   /* block assembly routine                                      */
@@ -268,14 +272,16 @@ void WriteFlux(SNEQData *SNEQD, cdouble Omega, double *kBloch)
      /*--------------------------------------------------------------*/
      /* assemble off-diagonal matrix blocks.                         */
      /* note that not all off-diagonal blocks necessarily need to    */
-     /* be recomputed for all transformations; this is what the 'if' */
-     /* statement here is checking for.                              */
+     /* be recomputed for all transformations: a block is reused if  */
+     /* the relative pose of its two surfaces was seen before.       */
      /*--------------------------------------------------------------*/
      Args->Symmetric=0;
      for(int nb=0, ns=0; ns<NS; ns++)
       for(int nsp=ns+1; nsp<NS; nsp++, nb++)
-       if ( nt==0 || G->SurfaceMoved[ns] || G->SurfaceMoved[nsp] )
-        G->AssembleBEMMatrixBlock(ns, nsp, Omega, kBloch, U[nb]);
+       if ( !UBCache->Fetch(ns, nsp, U[nb]) )
+        { G->AssembleBEMMatrixBlock(ns, nsp, Omega, kBloch, U[nb]);
+          UBCache->Store(ns, nsp, U[nb]);
+        };
      Log("...SN done with ABMB");
 
      /*--------------------------------------------------------------*/
@@ -334,17 +340,31 @@ void WriteFlux(SNEQData *SNEQD, cdouble Omega, double *kBloch)
            if (Status==0)
             continue;
 
-           FILE *f=vfopen(SNEQD->SIFluxFileNames[npm],"a");
-           for(int nsd=0; nsd<NS; nsd++)
-            { 
-              fprintf(f,"%s %e ",Tag,real(Omega));
-              if (kBloch) fprintVec(f,kBloch,G->LDim);
-              fprintf(f,"%i%i ",nss+1,nsd+1);
-              for(int nq=0; nq<NUMPFT; nq++)
-               fprintf(f,"%+.8e ",PFTMatrix->GetEntryD(nsd,nq));
-              fprintf(f,"\n");
+           if (SNEQD->OutputFormat & RESULT_FORMAT_TEXT)
+            { FILE *f=vfopen(SNEQD->SIFluxFileNames[npm],"a");
+              for(int nsd=0; nsd<NS; nsd++)
+               { 
+                 fprintf(f,"%s %e ",Tag,real(Omega));
+                 if (kBloch) fprintVec(f,kBloch,G->LDim);
+                 fprintf(f,"%i%i ",nss+1,nsd+1);
+                 for(int nq=0; nq<NUMPFT; nq++)
+                  fprintf(f,"%+.8e ",PFTMatrix->GetEntryD(nsd,nq));
+                 fprintf(f,"\n");
+               };
+              fclose(f);
             };
-           fclose(f);
+
+           if (SNEQD->SIFluxTables[npm])
+            for(int nsd=0; nsd<NS; nsd++)
+             { double Keys[SIFLUX_NUMKEYS], Flux[NUMPFT];
+               Keys[0] = real(Omega);
+               Keys[1] = (kBloch && G->LDim>=1) ? kBloch[0] : 0.0;
+               Keys[2] = (kBloch && G->LDim>=2) ? kBloch[1] : 0.0;
+               Keys[3] = nss+1;
+               Keys[4] = nsd+1;
+               PFTMatrix->GetEntriesD(nsd,":",Flux);
+               SNEQD->SIFluxTables[npm]->Append(Tag, Keys, Flux);
+             };
 
            if (PFTByRegion)
             { GetPFTByRegion(G, PFTMatrix, PFTByRegion);
@@ -370,13 +390,28 @@ void WriteFlux(SNEQData *SNEQD, cdouble Omega, double *kBloch)
             HMatrix *DRMatrix  = SNEQD->DRMatrix;
             GetSRFluxTrace(G, SRXMatrix, Omega, DRMatrix, SRFMatrix);
 
-            FILE *f=vfopen("%s.SRFlux","a",FileBase);
+            FILE *f=0;
+            if (SNEQD->OutputFormat & RESULT_FORMAT_TEXT)
+             f=vfopen("%s.SRFlux","a",FileBase);
             for(int nx=0; nx<SRXMatrix->NR; nx++)
              {
                double X[3], SRFlux[NUMSRFLUX];
                SRXMatrix->GetEntriesD(nx,":",X);
                SRFMatrix->GetEntriesD(nx,":",SRFlux);
 
+               if (SNEQD->SRFluxTable)
+                { double Keys[SRFLUX_NUMKEYS];
+                  Keys[0] = real(Omega);
+                  Keys[1] = (kBloch && G->LDim>=1) ? kBloch[0] : 0.0;
+                  Keys[2] = (kBloch && G->LDim>=2) ? kBloch[1] : 0.0;
+                  Keys[3] = X[0];
+                  Keys[4] = X[1];
+                  Keys[5] = X[2];
+                  Keys[6] = nss;
+                  SNEQD->SRFluxTable->Append(Tag, Keys, SRFlux);
+                };
+
+               if (!f) continue;
                fprintf(f,"%s %e ",Tag,real(Omega));
                if (kBloch) 
                 fprintVec(f, kBloch, G->LDim);
@@ -385,7 +420,7 @@ void WriteFlux(SNEQData *SNEQD, cdouble Omega, double *kBloch)
                 fprintf(f,"%e ",SRFMatrix->GetEntryD(nx,nfc));
                fprintf(f,"\n");
              };
-            fclose(f);
+            if (f) fclose(f);
           };
 
       }; // for(int nss=0; nss<NS; nss++)
@@ -423,6 +458,15 @@ void WriteFlux(SNEQData *SNEQD, cdouble Omega, double *kBloch)
 
   }; // for (nt=0; nt<SNEQD->NumTransformations... )
 
+  /*--------------------------------------------------------------*/
+  /*- make this frequency's rows durable in any binary tables    -*/
+  /*--------------------------------------------------------------*/
+  for(int npm=0; npm<SNEQD->NumPFTMethods; npm++)
+   if (SNEQD->SIFluxTables[npm])
+    SNEQD->SIFluxTables[npm]->Flush();
+  if (SNEQD->SRFluxTable)
+   SNEQD->SRFluxTable->Flush();
+
   /*--------------------------------------------------------------*/
   /*- at the end of the first successful frequency calculation,  -*/
   /*- we dump out the cache to disk, and then tell ourselves not -*/
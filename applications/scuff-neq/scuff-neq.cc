@@ -98,6 +98,10 @@ int main(int argc, char *argv[])
   char *ReadCache[MAXCACHE];         int nReadCache;
   char *WriteCache=0;
 
+  /*--------------------------------------------------------------*/
+  int SeparationNodes  = 0;
+  double SeparationTol = 1.0e-6;
+
   /* name               type    #args  max_instances  storage           count         description*/
   OptStruct OSArray[]=
    { 
@@ -130,6 +134,9 @@ int main(int argc, char *argv[])
      {"Cache",          PA_STRING,  1, 1,       (void *)&Cache,      0,             "read/write cache"},
      {"ReadCache",      PA_STRING,  1, MAXCACHE,(void *)ReadCache,   &nReadCache,   "read cache"},
      {"WriteCache",     PA_STRING,  1, 1,       (void *)&WriteCache, 0,             "write cache"},
+/**/     
+     {"SeparationNodes", PA_INT,    1, 1,       (void *)&SeparationNodes, 0,        "number of nodes for interpolating BEM blocks in separation"},
+     {"SeparationTol",  PA_DOUBLE,  1, 1,       (void *)&SeparationTol, 0,          "relative accuracy of separation interpolation"},
 /**/     
      {0,0,0,0,0,0,0}
    };
@@ -226,6 +233,8 @@ int main(int argc, char *argv[])
   SNEQD->PFTOpts.DSIRadius       = DSIRadius;
   SNEQD->PFTOpts.DSIFarField     = DSIFarField;
   SNEQD->DSIOmegaPoints          = DSIOmegaFile ? new HVector(DSIOmegaFile) : 0;
+  if (SeparationNodes>0)
+   SNEQD->UBCache->PlanSeparationInterpolation(SNEQD->GTCs, SeparationNodes, SeparationTol);
 
   if (OmegaKBPoints && !G->LBasis)
    ErrExit("--OmegaKBPoints may only be used with extended geometries");
@@ -278,6 +287,8 @@ int main(int argc, char *argv[])
    for (int nFreq=0; nFreq<NumFreqs; nFreq++)
     WriteFlux(SNEQD, OmegaPoints->GetEntry(nFreq));
 
+  CloseResultTables(SNEQD);
+
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
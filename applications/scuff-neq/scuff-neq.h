@@ -60,6 +60,10 @@ using namespace scuff;
 
 #define NUMSRFLUX      12
 
+// key columns of the binary output tables
+#define SIFLUX_NUMKEYS  5
+#define SRFLUX_NUMKEYS  7
+
 // quadrature methods 
 #define QMETHOD_ADAPTIVE 0
 #define QMETHOD_CLIFF    1
@@ -99,6 +103,14 @@ typedef struct SNEQData
    int PFTMethods[MAXPFTMETHODS];
    char *SIFluxFileNames[MAXPFTMETHODS];
 
+   /*--------------------------------------------------------------*/
+   /*- binary (HDF5) output tables, nonzero only if requested by  -*/
+   /*- SCUFF_OUTPUT_FORMAT                                        -*/
+   /*--------------------------------------------------------------*/
+   int OutputFormat;
+   ResultTable *SIFluxTables[MAXPFTMETHODS];
+   ResultTable *SRFluxTable;
+
    /*--------------------------------------------------------------*/
    /* storage for the BEM matrix and its subblocks.                */
    // Note: Buffer[0..N] are pointers into an internally-allocated */
@@ -109,6 +121,7 @@ typedef struct SNEQData
    HMatrix **TInt;    // TInt[ns], TExt[ns] = interior and exterior
    HMatrix **TExt;    // contributions to BEM block for surface #ns
    HMatrix **U;       // U[nb] = // off-diagonal U-matrix block #nb 
+   UBlockCache *UBCache; // reuses U blocks over transformations
 
    /*--------------------------------------------------------------*/
    /*- miscellaneous other options                                -*/
@@ -132,5 +145,6 @@ SNEQData *CreateSNEQData(char *GeoFile, char *TransFile,
 /*- in GetFlux.cc ----------------------------------------------*/
 /*--------------------------------------------------------------*/
 void WriteFlux(SNEQData *SNEQD, cdouble Omega, double *kBloch=0);
+void CloseResultTables(SNEQData *SNEQD);
 
 #endif
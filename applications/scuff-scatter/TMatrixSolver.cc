@@ -0,0 +1,804 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * TMatrixSolver.cc -- T-matrix solver for scattering from sparse
+ *                  -- collections of compact bodies
+ *
+ * The surfaces in the geometry are grouped into 'clusters' of bodies
+ * whose bounding spheres are close to one another:
+ *
+ *  surfaces i and j are in the same cluster if
+ *   |Xi - Xj| < NearFactor * (Ri + Rj)
+ *
+ * (Xi, Ri = center, radius of bounding sphere of surface i).
+ * Interactions within a cluster are treated by full BEM. Each
+ * cluster c is characterized by its T-matrix T_c, computed once
+ * per frequency as T_c = P_c * Inverse[M_c] * R_c, where M_c is
+ * the BEM matrix of the isolated cluster and R_c, P_c are the
+ * matrices returned by GetSphericalWaveMatrices() for spherical
+ * waves centered at the cluster center X_c. Clusters that are
+ * rigid translations of one another (same surface Mates, same
+ * relative vertex positions) share a single M_c, R_c, P_c, T_c.
+ *
+ * Clusters interact by spherical-wave translation. If a_c is the
+ * vector of outgoing-wave coefficients of the field scattered by
+ * cluster c about X_c, the field scattered by all other clusters
+ * is a regular-wave field about X_c with coefficients
+ *
+ *  q_c = \sum_{d!=c} Tr_{cd}^T a_d,
+ *
+ * with Tr_{cd} the translation matrix (GetTranslationMatrices())
+ * for the displacement X_d - X_c, and we have
+ *
+ *  a_c - T_c q_c = b_c,    b_c = P_c * Inverse[M_c] * RHS_c
+ *
+ * where RHS_c is the portion of the usual RHS vector describing
+ * the incident field on cluster c. This system, of dimension
+ * (#clusters)*(#spherical waves), is solved by restarted GMRES;
+ * the surface currents on cluster c are then
+ *
+ *  KN_c = Inverse[M_c] * (RHS_c + R_c q_c)
+ *
+ * and are written into the usual KN vector, so that all the
+ * usual post-processing (fields, PFTs, ...) works unmodified.
+ *
+ * tunable parameters (environment variables):
+ *  SCUFF_TMATRIX_MAXITERS   max number of GMRES iterations (500)
+ *  SCUFF_TMATRIX_RESTART    GMRES restart length (30)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+
+#include <libhrutil.h>
+#include <libhmat.h>
+#include <libSpherical.h>
+
+#include "scuff-scatter.h"
+
+// in libscuff/GetSphericalMoments.cc
+void GetSphericalWaveMatrices(RWGGeometry *G, int ns, double X0[3],
+                              cdouble Omega, int lMax,
+                              HMatrix *RHSMatrix, HMatrix *PMatrix);
+
+#define EXTERIOR_REGION 0
+
+/***************************************************************/
+/* data for a class of identical clusters (rigid translations  */
+/* of one another)                                             */
+/***************************************************************/
+typedef struct TMClusterType
+ {
+   int NumSurfaces;
+   int *MateRoots;       // root of the Mate[] chain for each surface
+   int NumVertices;
+   double *XRel;         // vertex coordinates relative to cluster center
+   int NBF;              // total number of basis functions
+   HMatrix *M;           // LU-factorized BEM matrix of isolated cluster
+   HMatrix *R, *P, *T;   // RHS, projection, T matrices
+   bool InUse;
+ } TMClusterType;
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+typedef struct TMCluster
+ {
+   std::vector<int> Surfaces;
+   double X0[3], Radius;
+   TMClusterType *Type;
+ } TMCluster;
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+struct TMSolver
+ {
+   RWGGeometry *G;
+   int LMax, NM;          // NM = number of spherical waves per cluster
+   double NearFactor, Tol;
+   int MaxIters, Restart;
+
+   cdouble Omega;
+   cdouble k;             // wavenumber in exterior region
+
+   std::vector<TMClusterType *> Types;
+   std::vector<TMCluster> Clusters;
+
+   // Tr[np] = translation matrix for cluster pair #np = (c,d), c<d,
+   // for displacement X_d - X_c; the matrix for X_c - X_d differs
+   // only by the signs in TrSign
+   HMatrix **Tr;
+   int NumPairs;
+   double *TrSign;        // TrSign[a*NM + b] = (-1)^(La+Lb) * (Ta==Tb ? 1 : -1)
+
+   cdouble *qBuffer;      // #clusters * NM
+ };
+
+/***************************************************************/
+/* l-value and type (0=M, 1=N) of spherical wave #nmw          */
+/***************************************************************/
+static void GetLT(int nmw, int *L, int *T)
+{
+  int Alpha = nmw/2 + 1;
+  *L = (int)floor(sqrt((double)Alpha) + 1.0e-9);
+  *T = nmw%2;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+TMSolver *CreateTMSolver(RWGGeometry *G, int LMax, double NearFactor, double Tol)
+{
+  if (G->LDim>0)
+   ErrExit("--TMatrixLMax is only supported for compact geometries");
+  if (G->Substrate)
+   ErrExit("--TMatrixLMax is not supported for geometries with substrates");
+  if (G->NumMMJs>0)
+   ErrExit("--TMatrixLMax is not supported for geometries with multi-material junctions");
+  if (LMax<1 || LMax>15)
+   ErrExit("--TMatrixLMax must lie between 1 and 15");
+  if (NearFactor<1.0)
+   ErrExit("--TMatrixNearFactor must be at least 1");
+
+  TMSolver *TMS   = new TMSolver;
+  TMS->G          = G;
+  TMS->LMax       = LMax;
+  TMS->NM         = 2*( (LMax+1)*(LMax+1) - 1 );
+  TMS->NearFactor = NearFactor;
+  TMS->Tol        = Tol;
+  TMS->Omega      = 0.0;
+  TMS->k          = 0.0;
+  TMS->Tr         = 0;
+  TMS->NumPairs   = 0;
+  TMS->qBuffer    = 0;
+
+  TMS->MaxIters=500;
+  TMS->Restart=30;
+  char *s;
+  if ( (s=getenv("SCUFF_TMATRIX_MAXITERS")) ) sscanf(s,"%i",&(TMS->MaxIters));
+  if ( (s=getenv("SCUFF_TMATRIX_RESTART")) )  sscanf(s,"%i",&(TMS->Restart));
+  if (TMS->Restart<1) TMS->Restart=1;
+
+  int NM=TMS->NM;
+  TMS->TrSign = new double[NM*NM];
+  for(int a=0; a<NM; a++)
+   for(int b=0; b<NM; b++)
+    { int La, Ta, Lb, Tb;
+      GetLT(a, &La, &Ta);
+      GetLT(b, &Lb, &Tb);
+      double Sign = ((La+Lb)%2) ? -1.0 : 1.0;
+      TMS->TrSign[a*NM + b] = (Ta==Tb) ? Sign : -Sign;
+    };
+
+  Log("T-matrix solver: LMax=%i (%i spherical waves per cluster), near factor %g",
+       LMax, NM, NearFactor);
+
+  return TMS;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+static void DestroyClusterType(TMClusterType *CT)
+{
+  free(CT->MateRoots);
+  free(CT->XRel);
+  delete CT->M;
+  delete CT->R;
+  delete CT->P;
+  delete CT->T;
+  free(CT);
+}
+
+static void ClearTranslations(TMSolver *TMS)
+{
+  for(int np=0; np<TMS->NumPairs; np++)
+   delete TMS->Tr[np];
+  free(TMS->Tr);
+  TMS->Tr=0;
+  TMS->NumPairs=0;
+}
+
+void DestroyTMSolver(TMSolver *TMS)
+{
+  for(size_t nt=0; nt<TMS->Types.size(); nt++)
+   DestroyClusterType(TMS->Types[nt]);
+  ClearTranslations(TMS);
+  delete[] TMS->TrSign;
+  if (TMS->qBuffer) free(TMS->qBuffer);
+  delete TMS;
+}
+
+/***************************************************************/
+/* bounding sphere of a set of surfaces (center of bounding box*/
+/* and max distance of any panel vertex from that center)      */
+/***************************************************************/
+static void GetBoundingSphere(RWGGeometry *G, std::vector<int> &Surfaces,
+                              double X0[3], double *Radius)
+{
+  double RMin[3]={ 1.0e89,  1.0e89,  1.0e89};
+  double RMax[3]={-1.0e89, -1.0e89, -1.0e89};
+  for(size_t n=0; n<Surfaces.size(); n++)
+   { RWGSurface *S=G->Surfaces[Surfaces[n]];
+     for(int np=0; np<S->NumPanels; np++)
+      for(int nv=0; nv<3; nv++)
+       { double *V = S->Vertices + 3*S->Panels[np]->VI[nv];
+         for(int Mu=0; Mu<3; Mu++)
+          { RMin[Mu] = fmin(RMin[Mu], V[Mu]);
+            RMax[Mu] = fmax(RMax[Mu], V[Mu]);
+          };
+       };
+   };
+
+  for(int Mu=0; Mu<3; Mu++)
+   X0[Mu] = 0.5*(RMin[Mu] + RMax[Mu]);
+
+  *Radius=0.0;
+  for(size_t n=0; n<Surfaces.size(); n++)
+   { RWGSurface *S=G->Surfaces[Surfaces[n]];
+     for(int np=0; np<S->NumPanels; np++)
+      for(int nv=0; nv<3; nv++)
+       *Radius = fmax(*Radius, VecDistance(X0, S->Vertices + 3*S->Panels[np]->VI[nv]));
+   };
+}
+
+/***************************************************************/
+/* group surfaces into clusters of near bodies                 */
+/***************************************************************/
+static int FindRoot(int *Parent, int n)
+{
+  while(Parent[n]!=n)
+   n=Parent[n]=Parent[Parent[n]];
+  return n;
+}
+
+static void MergeClusters(int *Parent, int ns, int nsp)
+{
+  int r=FindRoot(Parent,ns), rp=FindRoot(Parent,nsp);
+  if (r!=rp)
+   Parent[ (r>rp) ? r : rp ] = (r>rp) ? rp : r;
+}
+
+static void FindClusters(TMSolver *TMS)
+{
+  RWGGeometry *G = TMS->G;
+  int NS = G->NumSurfaces;
+  double NearFactor = TMS->NearFactor;
+
+  double *X0 = new double[3*NS], *Radii = new double[NS];
+  for(int ns=0; ns<NS; ns++)
+   { std::vector<int> Surface(1,ns);
+     GetBoundingSphere(G, Surface, X0 + 3*ns, Radii + ns);
+   };
+
+  int *Parent = new int[NS];
+  for(int ns=0; ns<NS; ns++)
+   Parent[ns]=ns;
+  for(int ns=0; ns<NS; ns++)
+   for(int nsp=ns+1; nsp<NS; nsp++)
+    if ( VecDistance(X0+3*ns, X0+3*nsp) < NearFactor*(Radii[ns]+Radii[nsp]) )
+     MergeClusters(Parent, ns, nsp);
+
+  /***************************************************************/
+  /* the bounding sphere of a merged cluster can be larger than  */
+  /* those of its members and may now overlap other clusters, in */
+  /* which case the translation-matrix expansion of the coupling */
+  /* between them would not converge. so we keep merging        */
+  /* clusters until all cluster pairs satisfy the same criterion */
+  /* as surface pairs (which, for NearFactor>=1, implies         */
+  /* disjoint bounding spheres).                                 */
+  /***************************************************************/
+  int *ClusterIndex = new int[NS];
+  bool Merged=true;
+  while(Merged)
+   {
+     // clusters are ordered by their lowest-numbered surface, and
+     // the surfaces within each cluster are in ascending order
+     TMS->Clusters.clear();
+     for(int ns=0; ns<NS; ns++)
+      { int r=FindRoot(Parent,ns);
+        if (r==ns)
+         { ClusterIndex[ns]=TMS->Clusters.size();
+           TMS->Clusters.push_back(TMCluster());
+         };
+        TMS->Clusters[ClusterIndex[r]].Surfaces.push_back(ns);
+      };
+
+     int NC=TMS->Clusters.size();
+     for(int nc=0; nc<NC; nc++)
+      { TMCluster *C=&(TMS->Clusters[nc]);
+        GetBoundingSphere(G, C->Surfaces, C->X0, &(C->Radius));
+        C->Type=0;
+      };
+
+     Merged=false;
+     for(int nc=0; nc<NC; nc++)
+      for(int nd=nc+1; nd<NC; nd++)
+       { TMCluster *C=&(TMS->Clusters[nc]), *D=&(TMS->Clusters[nd]);
+         if ( VecDistance(C->X0, D->X0) < NearFactor*(C->Radius + D->Radius) )
+          { MergeClusters(Parent, C->Surfaces[0], D->Surfaces[0]);
+            Merged=true;
+          };
+       };
+   };
+
+  delete[] ClusterIndex;
+  delete[] Parent;
+  delete[] X0;
+  delete[] Radii;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+static int GetMateRoot(RWGGeometry *G, int ns)
+{
+  while(G->Mate[ns]!=-1)
+   ns=G->Mate[ns];
+  return ns;
+}
+
+static bool ClusterMatchesType(RWGGeometry *G, TMCluster *C, TMClusterType *CT)
+{
+  if ( (int)C->Surfaces.size() != CT->NumSurfaces )
+   return false;
+
+  for(int n=0, nv=0; n<CT->NumSurfaces; n++)
+   { RWGSurface *S=G->Surfaces[C->Surfaces[n]];
+     if (GetMateRoot(G, C->Surfaces[n])!=CT->MateRoots[n])
+      return false;
+     for(int nvp=0; nvp<S->NumVertices; nvp++, nv++)
+      for(int Mu=0; Mu<3; Mu++)
+       if ( fabs(S->Vertices[3*nvp+Mu] - C->X0[Mu] - CT->XRel[3*nv+Mu]) > 1.0e-8*C->Radius )
+        return false;
+   };
+  return true;
+}
+
+/***************************************************************/
+/* assemble the BEM matrix of an isolated cluster, the RHS and */
+/* projection matrices for spherical waves about its center,   */
+/* and its T-matrix                                            */
+/***************************************************************/
+static TMClusterType *CreateClusterType(TMSolver *TMS, TMCluster *C)
+{
+  RWGGeometry *G = TMS->G;
+  cdouble Omega  = TMS->Omega;
+  int NM         = TMS->NM;
+
+  TMClusterType *CT = (TMClusterType *)mallocEC(sizeof(TMClusterType));
+  CT->NumSurfaces = C->Surfaces.size();
+  CT->MateRoots   = (int *)mallocEC(CT->NumSurfaces*sizeof(int));
+  CT->NumVertices = 0;
+  CT->NBF         = 0;
+  for(int n=0; n<CT->NumSurfaces; n++)
+   { RWGSurface *S    = G->Surfaces[C->Surfaces[n]];
+     CT->MateRoots[n] = GetMateRoot(G, C->Surfaces[n]);
+     CT->NumVertices += S->NumVertices;
+     CT->NBF         += S->NumBFs;
+   };
+  CT->XRel = (double *)mallocEC(3*CT->NumVertices*sizeof(double));
+  for(int n=0, nv=0; n<CT->NumSurfaces; n++)
+   { RWGSurface *S=G->Surfaces[C->Surfaces[n]];
+     for(int nvp=0; nvp<S->NumVertices; nvp++, nv++)
+      VecSub(S->Vertices + 3*nvp, C->X0, CT->XRel + 3*nv);
+   };
+
+  Log(" T-matrix for cluster of %i surface(s) (%i BFs)...",CT->NumSurfaces,CT->NBF);
+
+  /***************************************************************/
+  /* BEM matrix: above-diagonal blocks, then fill in the lower   */
+  /* triangle by symmetry, as in AssembleBEMMatrix               */
+  /***************************************************************/
+  int NBF = CT->NBF;
+  CT->M = new HMatrix(NBF, NBF, LHM_COMPLEX);
+  for(int n=0, RowOffset=0; n<CT->NumSurfaces; n++)
+   { int ns = C->Surfaces[n];
+     for(int np=n, ColOffset=RowOffset; np<CT->NumSurfaces; np++)
+      { int nsp = C->Surfaces[np];
+        G->AssembleBEMMatrixBlock(ns, nsp, Omega, 0, CT->M, 0, RowOffset, ColOffset);
+        ColOffset += G->Surfaces[nsp]->NumBFs;
+      };
+     RowOffset += G->Surfaces[ns]->NumBFs;
+   };
+  for(int nr=1; nr<NBF; nr++)
+   for(int nc=0; nc<nr; nc++)
+    CT->M->SetEntry(nr, nc, CT->M->GetEntry(nc, nr));
+
+  /***************************************************************/
+  /* RHS and projection matrices, stacked surface by surface     */
+  /***************************************************************/
+  CT->R = new HMatrix(NBF, NM, LHM_COMPLEX);
+  CT->P = new HMatrix(NM, NBF, LHM_COMPLEX);
+  for(int n=0, Offset=0; n<CT->NumSurfaces; n++)
+   { int ns = C->Surfaces[n];
+     int NBFS = G->Surfaces[ns]->NumBFs;
+     HMatrix RS(NBFS, NM, LHM_COMPLEX), PS(NM, NBFS, LHM_COMPLEX);
+     GetSphericalWaveMatrices(G, ns, C->X0, Omega, TMS->LMax, &RS, &PS);
+     CT->R->InsertBlock(&RS, Offset, 0);
+     CT->P->InsertBlock(&PS, 0, Offset);
+     Offset += NBFS;
+   };
+
+  /***************************************************************/
+  /* T = P * M^{-1} * R                                          */
+  /***************************************************************/
+  CT->M->LUFactorize();
+  HMatrix MInvR(CT->R);
+  CT->M->LUSolve(&MInvR);
+  CT->T = new HMatrix(NM, NM, LHM_COMPLEX);
+  CT->P->Multiply(&MInvR, CT->T);
+
+  CT->InUse = true;
+  return CT;
+}
+
+/***************************************************************/
+/* prepare the solver for the current frequency and the current*/
+/* positions of the surfaces. T-matrices computed for previous */
+/* transformations at the same frequency are reused for        */
+/* clusters that are rigid translations of earlier clusters.   */
+/***************************************************************/
+void PrepareTMSolver(TMSolver *TMS, cdouble Omega)
+{
+  RWGGeometry *G = TMS->G;
+  int NM         = TMS->NM;
+
+  if (Omega!=TMS->Omega)
+   { for(size_t nt=0; nt<TMS->Types.size(); nt++)
+      DestroyClusterType(TMS->Types[nt]);
+     TMS->Types.clear();
+     TMS->Omega=Omega;
+     cdouble Eps, Mu;
+     G->RegionMPs[EXTERIOR_REGION]->GetEpsMu(Omega, &Eps, &Mu);
+     TMS->k = sqrt(Eps*Mu)*Omega;
+   };
+
+  /***************************************************************/
+  /* identify clusters and their types                           */
+  /***************************************************************/
+  FindClusters(TMS);
+  int NC = TMS->Clusters.size();
+
+  for(size_t nt=0; nt<TMS->Types.size(); nt++)
+   TMS->Types[nt]->InUse=false;
+  for(int nc=0; nc<NC; nc++)
+   { TMCluster *C=&(TMS->Clusters[nc]);
+     for(size_t nt=0; nt<TMS->Types.size() && C->Type==0; nt++)
+      if (ClusterMatchesType(G, C, TMS->Types[nt]))
+       { C->Type=TMS->Types[nt];
+         C->Type->InUse=true;
+       };
+     if (C->Type==0)
+      { C->Type=CreateClusterType(TMS, C);
+        TMS->Types.push_back(C->Type);
+      };
+   };
+
+  // discard types left over from earlier transformations
+  for(size_t nt=0; nt<TMS->Types.size(); )
+   if (TMS->Types[nt]->InUse)
+    nt++;
+   else
+    { DestroyClusterType(TMS->Types[nt]);
+      TMS->Types.erase(TMS->Types.begin() + nt);
+    };
+
+  Log("T-matrix solver: %i surfaces in %i clusters (%i distinct)",
+       G->NumSurfaces, NC, (int)TMS->Types.size());
+
+  /***************************************************************/
+  /* translation matrices for all cluster pairs                  */
+  /***************************************************************/
+  ClearTranslations(TMS);
+  TMS->NumPairs = NC*(NC-1)/2;
+  TMS->Tr = (HMatrix **)mallocEC(TMS->NumPairs*sizeof(HMatrix *));
+  if (TMS->NumPairs>0)
+   Log("Computing %i translation matrices (%.1f MB)...",
+        TMS->NumPairs, TMS->NumPairs*NM*NM*sizeof(cdouble)/1.0e6);
+
+  int LMax   = TMS->LMax;
+  int NAlpha = (LMax+1)*(LMax+1);
+  HMatrix *A = new HMatrix(NAlpha, NAlpha, LHM_COMPLEX);
+  HMatrix *B = new HMatrix(NAlpha, NAlpha, LHM_COMPLEX);
+  HMatrix *C = new HMatrix(NAlpha, NAlpha, LHM_COMPLEX);
+  for(int nc=0, np=0; nc<NC; nc++)
+   for(int nd=nc+1; nd<NC; nd++, np++)
+    { double Xcd[3];
+      VecSub(TMS->Clusters[nd].X0, TMS->Clusters[nc].X0, Xcd);
+      GetTranslationMatrices(Xcd, TMS->k, LMax, A, B, C);
+
+      // M_a(out) = \sum_b B_{ab} M_b(reg) + C_{ab} N_b(reg)
+      // N_a(out) = \sum_b -C_{ab} M_b(reg) + B_{ab} N_b(reg)
+      HMatrix *Tr = TMS->Tr[np] = new HMatrix(NM, NM, LHM_COMPLEX);
+      for(int a=0; a<NM; a++)
+       for(int b=0; b<NM; b++)
+        { int Alpha = a/2 + 1, Ta = a%2;
+          int Beta  = b/2 + 1, Tb = b%2;
+          cdouble Entry;
+          if (Ta==Tb)
+           Entry = B->GetEntry(Alpha, Beta);
+          else if (Ta==0)
+           Entry = C->GetEntry(Alpha, Beta);
+          else
+           Entry = -1.0*C->GetEntry(Alpha, Beta);
+          Tr->SetEntry(a, b, Entry);
+        };
+    };
+  delete A;
+  delete B;
+  delete C;
+
+  if (TMS->qBuffer) free(TMS->qBuffer);
+  TMS->qBuffer = (cdouble *)mallocEC(NC*NM*sizeof(cdouble));
+}
+
+/***************************************************************/
+/* q_c = \sum_{d!=c} Tr_{cd}^T a_d for all clusters c          */
+/***************************************************************/
+static void GetRegularCoefficients(TMSolver *TMS, cdouble *a, cdouble *q)
+{
+  int NC = TMS->Clusters.size(), NM = TMS->NM;
+  double *TrSign = TMS->TrSign;
+  memset(q, 0, NC*NM*sizeof(cdouble));
+  for(int nc=0, np=0; nc<NC; nc++)
+   for(int nd=nc+1; nd<NC; nd++, np++)
+    { HMatrix *Tr=TMS->Tr[np];
+      cdouble *ac = a + nc*NM, *ad = a + nd*NM;
+      cdouble *qc = q + nc*NM, *qd = q + nd*NM;
+      for(int b=0; b<NM; b++)
+       { cdouble *TrColumn = (cdouble *)Tr->GetColumnPointer(b);
+         cdouble Sum1=0.0, Sum2=0.0;
+         for(int a=0; a<NM; a++)
+          { Sum1 += TrColumn[a]*ad[a];
+            Sum2 += TrSign[a*NM+b]*TrColumn[a]*ac[a];
+          };
+         qc[b] += Sum1;
+         qd[b] += Sum2;
+       };
+    };
+}
+
+/***************************************************************/
+/* y = (1 - T*Tr^T) a                                          */
+/***************************************************************/
+static void TMMatVec(TMSolver *TMS, cdouble *a, cdouble *y)
+{
+  int NC = TMS->Clusters.size(), NM = TMS->NM;
+  cdouble *q = TMS->qBuffer;
+  GetRegularCoefficients(TMS, a, q);
+  for(int nc=0; nc<NC; nc++)
+   { HMatrix *T = TMS->Clusters[nc].Type->T;
+     HVector qc(NM, LHM_COMPLEX, q + nc*NM), yc(NM, LHM_COMPLEX, y + nc*NM);
+     T->Apply(&qc, &yc);
+     for(int n=0; n<NM; n++)
+      y[nc*NM+n] = a[nc*NM+n] - y[nc*NM+n];
+   };
+}
+
+/***************************************************************/
+/* solve (1 - T*Tr^T) a = b by restarted GMRES; on return b is */
+/* overwritten with a. the return value is the number of       */
+/* iterations.                                                 */
+/***************************************************************/
+static int GMRESSolve(TMSolver *TMS, cdouble *b)
+{
+  int N        = TMS->Clusters.size()*TMS->NM;
+  int m        = TMS->Restart;
+  double Tol   = TMS->Tol;
+  int MaxIters = TMS->MaxIters;
+
+  cdouble *X  = new cdouble[N];
+  cdouble *W  = new cdouble[N];
+  cdouble *V  = new cdouble[(m+1)*N];
+  cdouble *H  = new cdouble[(m+1)*m];  // H[i + j*(m+1)]
+  double *CS  = new double[m];
+  cdouble *SN = new cdouble[m];
+  cdouble *g  = new cdouble[m+1];
+  cdouble *y  = new cdouble[m];
+  memset(X, 0, N*sizeof(cdouble));
+
+  double BNorm = VecNorm(b, N);
+  if (BNorm==0.0) BNorm=1.0;
+  double Residual=0.0;
+
+  int Iters=0;
+  while(Iters<MaxIters)
+   {
+     /*--------------------------------------------------------------*/
+     /*- true residual at start of each restart cycle               -*/
+     /*--------------------------------------------------------------*/
+     TMMatVec(TMS, X, W);
+     for(int n=0; n<N; n++)
+      V[n] = b[n] - W[n];
+     double Beta = VecNorm(V, N);
+     Residual = Beta/BNorm;
+     if (Residual<Tol)
+      break;
+     VecScale(V, 1.0/Beta, N);
+     memset(g, 0, (m+1)*sizeof(cdouble));
+     g[0] = Beta;
+
+     /*--------------------------------------------------------------*/
+     /*- arnoldi iteration                                          -*/
+     /*--------------------------------------------------------------*/
+     int NumSteps=0;
+     for(int j=0; j<m && Iters<MaxIters; j++, Iters++)
+      {
+        cdouble *w = V + (j+1)*N;
+        TMMatVec(TMS, V + j*N, w);
+
+        // modified gram-schmidt
+        for(int i=0; i<=j; i++)
+         { cdouble hij = VecHDot(V + i*N, w, N);
+           H[i + j*(m+1)] = hij;
+           VecPlusEquals(w, -hij, V + i*N, N);
+         };
+        double hj1j = VecNorm(w, N);
+        H[j+1 + j*(m+1)] = hj1j;
+        if (hj1j>0.0) VecScale(w, 1.0/hj1j, N);
+
+        // apply previous givens rotations to new column
+        for(int i=0; i<j; i++)
+         { cdouble a = H[i + j*(m+1)], bb = H[i+1 + j*(m+1)];
+           H[i + j*(m+1)]   =  CS[i]*a + SN[i]*bb;
+           H[i+1 + j*(m+1)] = -conj(SN[i])*a + CS[i]*bb;
+         };
+
+        // new givens rotation to eliminate subdiagonal
+        cdouble a = H[j + j*(m+1)], bb = H[j+1 + j*(m+1)];
+        double r = sqrt(norm(a) + norm(bb));
+        if (r==0.0)
+         { CS[j]=1.0; SN[j]=0.0; }
+        else if (abs(a)==0.0)
+         { CS[j]=0.0; SN[j]=conj(bb)/r; }
+        else
+         { CS[j]=abs(a)/r; SN[j]=(a/abs(a))*conj(bb)/r; }
+        H[j + j*(m+1)]   = CS[j]*a + SN[j]*bb;
+        H[j+1 + j*(m+1)] = 0.0;
+        g[j+1] = -conj(SN[j])*g[j];
+        g[j]   = CS[j]*g[j];
+
+        NumSteps = j+1;
+        Residual = abs(g[j+1]) / BNorm;
+        if (Residual<Tol || hj1j==0.0)
+         { Iters++;
+           break;
+         };
+      };
+
+     /*--------------------------------------------------------------*/
+     /*- update solution: X += V*y, with y = H \ g                  -*/
+     /*--------------------------------------------------------------*/
+     for(int i=NumSteps-1; i>=0; i--)
+      { cdouble Sum=g[i];
+        for(int l=i+1; l<NumSteps; l++)
+         Sum -= H[i + l*(m+1)]*y[l];
+        y[i] = (H[i + i*(m+1)]==0.0) ? 0.0 : Sum / H[i + i*(m+1)];
+      };
+     for(int i=0; i<NumSteps; i++)
+      VecPlusEquals(X, y[i], V + i*N, N);
+
+     Log(" GMRES iteration %i: relative residual %.2e",Iters,Residual);
+     if (Residual<Tol)
+      break;
+   };
+
+  if (Residual>=Tol)
+   Warn("GMRES did not converge in %i iterations (residual %.2e)",Iters,Residual);
+
+  memcpy(b, X, N*sizeof(cdouble));
+
+  delete[] X;
+  delete[] W;
+  delete[] V;
+  delete[] H;
+  delete[] CS;
+  delete[] SN;
+  delete[] g;
+  delete[] y;
+
+  return Iters;
+}
+
+/***************************************************************/
+/* copy the rows of a full-geometry vector belonging to the    */
+/* surfaces of cluster C into (or out of) a cluster vector     */
+/***************************************************************/
+static void ExtractClusterVector(RWGGeometry *G, TMCluster *C, HVector *V, cdouble *VC)
+{
+  for(size_t n=0, Offset=0; n<C->Surfaces.size(); n++)
+   { int ns=C->Surfaces[n];
+     int NBF=G->Surfaces[ns]->NumBFs, GOffset=G->BFIndexOffset[ns];
+     for(int nbf=0; nbf<NBF; nbf++)
+      VC[Offset + nbf] = V->GetEntry(GOffset + nbf);
+     Offset+=NBF;
+   };
+}
+
+static void InsertClusterVector(RWGGeometry *G, TMCluster *C, cdouble *VC, HVector *V)
+{
+  for(size_t n=0, Offset=0; n<C->Surfaces.size(); n++)
+   { int ns=C->Surfaces[n];
+     int NBF=G->Surfaces[ns]->NumBFs, GOffset=G->BFIndexOffset[ns];
+     for(int nbf=0; nbf<NBF; nbf++)
+      V->SetEntry(GOffset + nbf, VC[Offset + nbf]);
+     Offset+=NBF;
+   };
+}
+
+/***************************************************************/
+/* given the RHS vector for an incident field (as assembled by */
+/* AssembleRHSVector), compute the surface-current vector KN.  */
+/* KN and RHS may be the same vector.                          */
+/***************************************************************/
+void TMSolve(TMSolver *TMS, HVector *RHS, HVector *KN)
+{
+  RWGGeometry *G = TMS->G;
+  int NC = TMS->Clusters.size(), NM = TMS->NM;
+
+  /***************************************************************/
+  /* solve the isolated-cluster problems: x_c = M_c^{-1} RHS_c,  */
+  /* b_c = P_c x_c                                               */
+  /***************************************************************/
+  std::vector<HVector *> XC(NC);
+  cdouble *a = new cdouble[NC*NM];
+  for(int nc=0; nc<NC; nc++)
+   { TMCluster *C      = &(TMS->Clusters[nc]);
+     TMClusterType *CT = C->Type;
+     XC[nc] = new HVector(CT->NBF, LHM_COMPLEX);
+     ExtractClusterVector(G, C, RHS, XC[nc]->ZV);
+     CT->M->LUSolve(XC[nc]);
+     HVector bc(NM, LHM_COMPLEX, a + nc*NM);
+     CT->P->Apply(XC[nc], &bc);
+   };
+
+  /***************************************************************/
+  /* solve for the outgoing-wave coefficients of all clusters    */
+  /***************************************************************/
+  if (NC>1)
+   { Log("Solving T-matrix system (%i clusters, %i unknowns)...",NC,NC*NM);
+     int Iters=GMRESSolve(TMS, a);
+     Log(" ...%i GMRES iterations",Iters);
+   };
+
+  /***************************************************************/
+  /* KN_c = M_c^{-1} (RHS_c + R_c q_c) = x_c + M_c^{-1} R_c q_c  */
+  /***************************************************************/
+  cdouble *q = TMS->qBuffer;
+  GetRegularCoefficients(TMS, a, q);
+  for(int nc=0; nc<NC; nc++)
+   { TMCluster *C      = &(TMS->Clusters[nc]);
+     TMClusterType *CT = C->Type;
+     HVector qc(NM, LHM_COMPLEX, q + nc*NM);
+     HVector Rq(CT->NBF, LHM_COMPLEX);
+     CT->R->Apply(&qc, &Rq);
+     CT->M->LUSolve(&Rq);
+     for(int n=0; n<CT->NBF; n++)
+      XC[nc]->ZV[n] += Rq.ZV[n];
+     InsertClusterVector(G, C, XC[nc]->ZV, KN);
+     delete XC[nc];
+   };
+  delete[] a;
+}
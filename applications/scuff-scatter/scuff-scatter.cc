@@ -57,6 +57,10 @@ int main(int argc, char *argv[])
   /* process options *********************************************/
   /***************************************************************/
   InstallHRSignalHandler();
+  InitMPI(&argc, &argv);
+  int MPIRank=GetMPIRank(), MPISize=GetMPISize();
+  if (MPIRank>0)
+   SetLogFileName("%s.rank%i.log",GetFileBase(argv[0]),MPIRank);
   InitializeLog(argv[0]);
 
 //
@@ -111,6 +115,12 @@ int main(int argc, char *argv[])
   bool PlotSurfaceCurrents=false;
 //
   char *HDF5File=0;
+//
+  int BlockSize=0;
+//
+  int TMatrixLMax=0;
+  double TMatrixNearFactor=1.5;
+  double TMatrixTol=1.0e-6;
   char *Cache=0;
   char *ReadCache[MAXCACHE];         int nReadCache;
   char *WriteCache=0;
@@ -167,6 +177,12 @@ int main(int argc, char *argv[])
      {"PlotSurfaceCurrents", PA_BOOL, 0, 1,     (void *)&PlotSurfaceCurrents,  0,   "generate surface current visualization files\n"},
 /**/
      {"HDF5File",       PA_STRING,  1, 1,       (void *)&HDF5File,   0,             "name of HDF5 file for BEM matrix/vector export\n"},
+/**/
+     {"BlockSize",      PA_INT,     1, 1,       (void *)&BlockSize,  0,             "block size for distributed BEM matrix (MPI runs)\n"},
+/**/
+     {"TMatrixLMax",    PA_INT,     1, 1,       (void *)&TMatrixLMax,       0,      "couple well-separated bodies by T-matrices with spherical waves up to this l"},
+     {"TMatrixNearFactor", PA_DOUBLE, 1, 1,     (void *)&TMatrixNearFactor, 0,      "bodies closer than this times the sum of their radii are treated by full BEM"},
+     {"TMatrixTol",     PA_DOUBLE,  1, 1,       (void *)&TMatrixTol,        0,      "relative residual for the iterative T-matrix solve\n"},
 /**/
      {"LogLevel",       PA_STRING,  1, 1,       (void *)&LogLevel,   0,             "none | terse | verbose | verbose2\n"},
 /**/
@@ -284,7 +300,9 @@ int main(int argc, char *argv[])
   SSData MySSData, *SSD=&MySSData;
 
   RWGGeometry *G      = SSD->G   = new RWGGeometry(GeoFile);
-  HMatrix *M          = SSD->M   = G->AllocateBEMMatrix();
+  HMatrix *M          = SSD->M   = 0;
+  DMatrix *DM         = 0;
+  TMSolver *TMS       = 0;
   HVector *RHS        = SSD->RHS = G->AllocateRHSVector();
   HVector *KN         = SSD->KN  = G->AllocateRHSVector();
   double *kBloch      = SSD->kBloch = 0;
@@ -295,6 +313,30 @@ int main(int argc, char *argv[])
 
   if (LogLevel) G->SetLogLevel(LogLevel);
 
+  /*--------------------------------------------------------------*/
+  /*- when running under MPI with more than one rank, the BEM     */
+  /*- matrix is stored distributed over all ranks and never       */
+  /*- assembled in full; every rank participates in assembly and  */
+  /*- solves, but only rank 0 writes output files.                */
+  /*-                                                             */
+  /*- in T-matrix mode the full BEM matrix is never assembled;    */
+  /*- only the matrices of isolated clusters of near bodies are.  */
+  /*--------------------------------------------------------------*/
+  if (TMatrixLMax>0)
+   { if (MPISize>1 || HDF5File)
+      ErrExit("--TMatrixLMax is not supported with --HDF5File or in MPI runs");
+     TMS = CreateTMSolver(G, TMatrixLMax, TMatrixNearFactor, TMatrixTol);
+   }
+  else if (MPISize>1)
+   { if (G->LDim>0 || TransFile || HDF5File)
+      ErrExit("--TransFile, --HDF5File and periodic geometries are not supported in MPI runs");
+     DM = G->AllocateDistributedBEMMatrix(BlockSize);
+     Log("Distributing BEM matrix over %i ranks (%ix%i grid, block size %i)",
+          MPISize,DM->NPRow,DM->NPCol,DM->NB);
+   }
+  else
+   M = SSD->M = G->AllocateBEMMatrix();
+
   /*--------------------------------------------------------------*/
   /*- read the transformation file if one was specified and check */
   /*- that it plays well with the specified geometry file.        */
@@ -347,7 +389,7 @@ int main(int argc, char *argv[])
   /*******************************************************************/
   HMatrix **TBlocks=0, **UBlocks=0;
   int NS=G->NumSurfaces;
-  if (NumTransformations>1)
+  if (NumTransformations>1 && !TMS)
    { int NADB = NS*(NS-1)/2; // number of above-diagonal blocks
      TBlocks  = (HMatrix **)mallocEC(NS*sizeof(HMatrix *));
      UBlocks  = (HMatrix **)mallocEC(NADB*sizeof(HMatrix *));
@@ -398,7 +440,11 @@ int main(int argc, char *argv[])
      /* matrix blocks at this frequency; otherwise just assemble the    */
      /* whole matrix                                                    */
      /*******************************************************************/
-     if (NumTransformations==1)
+     if (TMS)
+      ; // cluster matrices are assembled by PrepareTMSolver below
+     else if (DM)
+      G->AssembleDistributedBEMMatrix(Omega, DM);
+     else if (NumTransformations==1)
       G->AssembleBEMMatrix(Omega, kBloch, M);
      else
       for(int ns=0; ns<G->NumSurfaces; ns++)
@@ -413,7 +459,7 @@ int main(int argc, char *argv[])
      /* will have been computed and the cache will not grow any further */
      /* for the rest of the program run.                                */
      /*******************************************************************/
-     if (WriteCache)
+     if (WriteCache && MPIRank==0)
       { StoreCache( WriteCache );
         WriteCache=0;       
       };
@@ -434,7 +480,7 @@ int main(int argc, char *argv[])
         /*******************************************************************/
         /* assemble and insert off-diagonal blocks as necessary ************/
         /*******************************************************************/
-        if (NumTransformations>1)
+        if (NumTransformations>1 && !TMS)
          { for(int ns=0, nb=0; ns<G->NumSurfaces; ns++)
             for(int nsp=ns+1; nsp<G->NumSurfaces; nsp++, nb++)
              G->AssembleBEMMatrixBlock(ns, nsp, Omega, kBloch, UBlocks[nb]);
@@ -468,8 +514,16 @@ int main(int argc, char *argv[])
         /* LU-factorize the BEM matrix to prepare for solving scattering   */
         /* problems                                                        */
         /*******************************************************************/
-        Log("  LU-factorizing BEM matrix...");
-        M->LUFactorize();
+        if (TMS)
+         PrepareTMSolver(TMS, Omega);
+        else if (DM)
+         { Log("  LU-factorizing BEM matrix...");
+           DM->LUFactorize();
+         }
+        else
+         { Log("  LU-factorizing BEM matrix...");
+           M->LUFactorize();
+         };
 
         /***************************************************************/
         /* loop over incident fields                                   */
@@ -492,7 +546,12 @@ int main(int argc, char *argv[])
            G->AssembleRHSVector(Omega, kBloch, IF, KN);
            RHS->Copy(KN); // copy RHS vector for later 
            Log("  Solving the BEM system...");
-           M->LUSolve(KN);
+           if (TMS)
+            TMSolve(TMS, RHS, KN);
+           else if (DM)
+            DM->LUSolve(KN);
+           else
+            M->LUSolve(KN);
    
            if (HDF5Context)
             { RHS->ExportToHDF5(HDF5Context,"RHS_%s%s%s",OmegaStr,TransformStr,IFStr);
@@ -502,6 +561,8 @@ int main(int argc, char *argv[])
            /***************************************************************/
            /* now process all requested outputs                           */
            /***************************************************************/
+           if (MPIRank>0)
+            continue;
    
            /*--------------------------------------------------------------*/
            /*- power, force, torque by various methods --------------------*/
@@ -573,6 +634,12 @@ int main(int argc, char *argv[])
   /***************************************************************/
   if (HDF5Context)
    HMatrix::CloseHDF5Context(HDF5Context);
-  printf("Thank you for your support.\n");
+  if (DM)
+   delete DM;
+  if (TMS)
+   DestroyTMSolver(TMS);
+  FinalizeMPI();
+  if (MPIRank==0)
+   printf("Thank you for your support.\n");
    
 }
@@ -62,4 +62,14 @@ void ProcessEPFile(SSData *SSData, char *EPFileName);
 void VisualizeFields(SSData *SSData, 
                      char *FVMesh, char *FVMeshTransFile, char *FuncList);
 
+/***************************************************************/
+/* T-matrix solver for sparse collections of compact bodies    */
+/* (TMatrixSolver.cc)                                          */
+/***************************************************************/
+struct TMSolver;
+TMSolver *CreateTMSolver(RWGGeometry *G, int LMax, double NearFactor, double Tol);
+void DestroyTMSolver(TMSolver *TMS);
+void PrepareTMSolver(TMSolver *TMS, cdouble Omega);
+void TMSolve(TMSolver *TMS, HVector *RHS, HVector *KN);
+
 #endif
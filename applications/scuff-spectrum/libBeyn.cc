@@ -32,6 +32,13 @@
 
 #include <libBeyn.h>
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+#ifdef USE_OPENMP
+#  include <omp.h>
+#endif
+
 #define II cdouble(0.0,1.0)
 
 cdouble zrandN(double Sigma=1.0, double Mu=0.0)
@@ -98,6 +105,13 @@ void DestroyBeynSolver(BeynSolver *Solver)
 
   free(Solver->Workspace);
 
+  if (Solver->CachedM)
+   for(int n=0; n<Solver->MaxMatrices; n++)
+    if (Solver->CachedM[n]) delete Solver->CachedM[n];
+  free(Solver->CachedM);
+  free(Solver->Cachedz);
+  free(Solver->CacheValid);
+
   delete Solver;
 }
 
@@ -116,6 +130,251 @@ void ReRandomize(BeynSolver *Solver, unsigned int RandSeed)
 
 }
 
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void SetBeynFactorFunction(BeynSolver *Solver, BeynFactorFunction FactorFunc,
+                           int MaxMatrices, int Symmetry)
+{
+  if (MaxMatrices<1) MaxMatrices=1;
+
+  if (Solver->CachedM && Solver->MaxMatrices!=MaxMatrices)
+   { for(int n=0; n<Solver->MaxMatrices; n++)
+      if (Solver->CachedM[n]) delete Solver->CachedM[n];
+     free(Solver->CachedM);
+     free(Solver->Cachedz);
+     free(Solver->CacheValid);
+     Solver->CachedM=0;
+   }
+
+  if (Solver->CachedM==0)
+   { Solver->CachedM    = (HMatrix **)mallocEC(MaxMatrices*sizeof(HMatrix *));
+     Solver->Cachedz    = (cdouble *)mallocEC(MaxMatrices*sizeof(cdouble));
+     Solver->CacheValid = (bool *)mallocEC(MaxMatrices*sizeof(bool));
+   }
+  else if (Solver->FactorFunc!=FactorFunc)
+   ClearBeynCache(Solver);
+
+  Solver->FactorFunc         = FactorFunc;
+  Solver->MaxMatrices        = MaxMatrices;
+  Solver->Symmetry           = Symmetry;
+}
+
+void ClearBeynCache(BeynSolver *Solver)
+{
+  for(int n=0; n<Solver->MaxMatrices; n++)
+   Solver->CacheValid[n]=false;
+}
+
+/***************************************************************/
+/* contour points are computed afresh by each call to          */
+/* BeynSolve, so they are matched with tolerance               */
+/***************************************************************/
+static bool SamePoint(cdouble z1, cdouble z2)
+{ return abs(z1-z2) <= 1.0e-10*(abs(z1) + abs(z2)); }
+
+// reflection of z under the symmetry M(zBar) = conj(M(z))
+static cdouble Reflect(BeynSolver *Solver, cdouble z)
+{ return (Solver->Symmetry==BEYN_IMAGAXIS) ? -conj(z) : conj(z); }
+
+/***************************************************************/
+/* return the index of the pool matrix holding the             */
+/* factorization of M(z), or of M(zBar) (in which case         */
+/* *Conjugate is set to true), or -1 if there is none          */
+/***************************************************************/
+static int FindCachedFactorization(BeynSolver *Solver, cdouble z, bool *Conjugate)
+{
+  for(int n=0; n<Solver->MaxMatrices; n++)
+   if (Solver->CacheValid[n] && SamePoint(Solver->Cachedz[n], z))
+    { *Conjugate=false;
+      return n;
+    }
+  if (Solver->Symmetry!=BEYN_NOSYMMETRY)
+   for(int n=0; n<Solver->MaxMatrices; n++)
+    if (Solver->CacheValid[n] && SamePoint(Solver->Cachedz[n], Reflect(Solver,z)))
+     { *Conjugate=true;
+       return n;
+     }
+  return -1;
+}
+
+/***************************************************************/
+/* X <- Inverse[M(z)]*VHat, where M holds the LU factorization */
+/* of M(z), or of M(zBar) = conj(M(z)) if Conjugate==true.     */
+/***************************************************************/
+static void SolveAtContourPoint(HMatrix *M, bool Conjugate, HMatrix *VHat, HMatrix *X)
+{
+  X->Copy(VHat);
+  size_t ML = ((size_t)X->NR)*X->NC;
+  if (Conjugate)
+   for(size_t n=0; n<ML; n++)
+    X->ZM[n] = conj(X->ZM[n]);
+  M->LUSolve(X);
+  if (Conjugate)
+   for(size_t n=0; n<ML; n++)
+    X->ZM[n] = conj(X->ZM[n]);
+}
+
+/***************************************************************/
+/* add the contribution of the contour point z0+z1 to the      */
+/* A0, A1 matrices and (for even-numbered points) to their     */
+/* coarse versions                                             */
+/***************************************************************/
+static void AccumulateContourPoint(BeynSolver *Solver, int n, cdouble z1,
+                                   cdouble dz, HMatrix *MInvVHat)
+{
+  int ML = Solver->M * Solver->L;
+  VecPlusEquals(Solver->A0->ZM, dz,    MInvVHat->ZM, ML);
+  VecPlusEquals(Solver->A1->ZM, z1*dz, MInvVHat->ZM, ML);
+  if ( (n%2)==0 )
+   { VecPlusEquals(Solver->A0Coarse->ZM, 2.0*dz,    MInvVHat->ZM, ML);
+     VecPlusEquals(Solver->A1Coarse->ZM, 2.0*z1*dz, MInvVHat->ZM, ML);
+   }
+}
+
+/***************************************************************/
+/* evaluate the contour integrals using the user's             */
+/* BeynFactorFunction.                                         */
+/*                                                             */
+/* each "primary" contour point requires a factorization of    */
+/* M(z), which is either retained from an earlier call or      */
+/* computed now into one of the pool matrices; if M(z) has a   */
+/* symmetry, a point whose reflection zBar is a primary point  */
+/* reuses that point's factorization. Primary points are       */
+/* processed in batches of up to NumConcurrent, by separate    */
+/* threads, with points having retained factorizations first   */
+/* so that their pool matrices are freed up for the others.    */
+/***************************************************************/
+static void EvaluateContourByFactorization(BeynSolver *Solver, void *UserData,
+                                           cdouble z0, int N,
+                                           cdouble *z1, cdouble *dz)
+{
+  int M           = Solver->M;
+  int L           = Solver->L;
+  int MaxMatrices = Solver->MaxMatrices;
+
+  // Source[n] = primary point whose factorization serves point n
+  int *Source = (int *)mallocEC(N*sizeof(int));
+  for(int n=0; n<N; n++)
+   { Source[n]=n;
+     if (Solver->Symmetry!=BEYN_NOSYMMETRY)
+      for(int m=0; m<n; m++)
+       if ( Source[m]==m && SamePoint(z0+z1[n], Reflect(Solver,z0+z1[m])) )
+        { Source[n]=m;
+          break;
+        }
+   }
+
+  // list primary points, those with retained factorizations first
+  int *Primaries    = (int *)mallocEC(N*sizeof(int));
+  int *Slot         = (int *)mallocEC(N*sizeof(int));
+  bool *SlotConj    = (bool *)mallocEC(N*sizeof(bool));
+  int *SlotUsers    = (int *)mallocEC(MaxMatrices*sizeof(int));
+  int NumPrimaries=0, NumRetained=0;
+  for(int Pass=0; Pass<2; Pass++)
+   for(int n=0; n<N; n++)
+    { if (Source[n]!=n) continue;
+      bool Conjugate=false;
+      int s = FindCachedFactorization(Solver, z0+z1[n], &Conjugate);
+      if ( (Pass==0) != (s!=-1) ) continue;
+      Primaries[NumPrimaries++]=n;
+      Slot[n]=s;
+      SlotConj[n]=Conjugate;
+      if (s!=-1)
+       { SlotUsers[s]++;
+         NumRetained++;
+       }
+    }
+  Log(" Evaluating contour integral (%i points, %i factorizations, %i retained)...",
+      N, NumPrimaries, NumRetained);
+
+  int NumConcurrent = GetNumThreads();
+  if (NumConcurrent>MaxMatrices) NumConcurrent=MaxMatrices;
+  if (NumConcurrent<1) NumConcurrent=1;
+
+  // each primary point serves at most two contour points
+  HMatrix **X = (HMatrix **)mallocEC(2*NumConcurrent*sizeof(HMatrix *));
+  for(int nx=0; nx<2*NumConcurrent; nx++)
+   X[nx] = new HMatrix(M, L, LHM_COMPLEX);
+  bool *NeedsFactor = (bool *)mallocEC(NumConcurrent*sizeof(bool));
+
+  for(int p0=0; p0<NumPrimaries; p0+=NumConcurrent)
+   { 
+     int NP = NumPrimaries - p0;
+     if (NP>NumConcurrent) NP=NumConcurrent;
+
+     // assign pool matrices to points that need new factorizations,
+     // preferring unused matrices over ones holding factorizations
+     for(int np=0; np<NP; np++)
+      { int n = Primaries[p0+np];
+        NeedsFactor[np] = (Slot[n]==-1);
+        if (!NeedsFactor[np]) continue;
+        int s=-1;
+        for(int ns=0; ns<MaxMatrices && s==-1; ns++)
+         if (!Solver->CacheValid[ns] && SlotUsers[ns]==0)
+          s=ns;
+        for(int ns=0; ns<MaxMatrices && s==-1; ns++)
+         if (SlotUsers[ns]==0)
+          s=ns;
+        if (s==-1)
+         ErrExit("%s:%i: internal error",__FILE__,__LINE__);
+        if (Solver->CachedM[s]==0)
+         Solver->CachedM[s] = new HMatrix(M, M, LHM_COMPLEX);
+        Solver->CacheValid[s]=false;
+        SlotUsers[s]++;
+        Slot[n]=s;
+        SlotConj[n]=false;
+      }
+
+     // assemble the matrices serially: the user's function is not
+     // assumed to be reentrant (assembling a BEM matrix modifies
+     // data in the RWGGeometry), but is typically multithreaded itself
+     for(int np=0; np<NP; np++)
+      if (NeedsFactor[np])
+       { int n = Primaries[p0+np];
+         Solver->FactorFunc(z0+z1[n], UserData, Solver->CachedM[Slot[n]]);
+       }
+
+     // factorize and solve at each point of the batch
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic,1) num_threads(NumConcurrent)
+#endif
+     for(int np=0; np<NP; np++)
+      { int n = Primaries[p0+np];
+        int s = Slot[n];
+        if (NeedsFactor[np])
+         { Solver->CachedM[s]->LUFactorize();
+           Solver->Cachedz[s]    = z0+z1[n];
+           Solver->CacheValid[s] = true;
+         }
+        SolveAtContourPoint(Solver->CachedM[s], SlotConj[n], Solver->VHat, X[2*np+0]);
+        for(int m=n+1; m<N; m++)
+         if (Source[m]==n)
+          SolveAtContourPoint(Solver->CachedM[s], !SlotConj[n], Solver->VHat, X[2*np+1]);
+      }
+
+     // accumulate contributions (serially, in a fixed order)
+     for(int np=0; np<NP; np++)
+      { int n = Primaries[p0+np];
+        AccumulateContourPoint(Solver, n, z1[n], dz[n], X[2*np+0]);
+        for(int m=n+1; m<N; m++)
+         if (Source[m]==n)
+          AccumulateContourPoint(Solver, m, z1[m], dz[m], X[2*np+1]);
+        SlotUsers[Slot[n]]--;
+      }
+   }
+
+  for(int nx=0; nx<2*NumConcurrent; nx++)
+   delete X[nx];
+  free(X);
+  free(NeedsFactor);
+  free(SlotUsers);
+  free(SlotConj);
+  free(Slot);
+  free(Primaries);
+  free(Source);
+}
+
 /***************************************************************/
 /* perform linear-algebra manipulations on the A0 and A1       */
 /* matrices (obtained via numerical quadrature) to extract     */
@@ -236,8 +495,6 @@ int BeynSolve(BeynSolver *Solver,
   else
    Log("Applying Beyn method with z0=%s,Rx=%e,Ry=%e,N=%i...",z2s(z0),Rx,Ry,N);
 
-  int M                 = Solver->M;
-  int L                 = Solver->L;
   HMatrix *A0           = Solver->A0;
   HMatrix *A1           = Solver->A1;
   HMatrix *A0Coarse     = Solver->A0Coarse;
@@ -254,25 +511,26 @@ int BeynSolve(BeynSolver *Solver,
   A0Coarse->Zero();
   A1Coarse->Zero();
   double DeltaTheta = 2.0*M_PI / ((double)N);
-  Log(" Evaluating contour integral (%i points)...",N);
+  cdouble *z1 = (cdouble *)mallocEC(2*N*sizeof(cdouble)), *dz = z1 + N;
   for(int n=0; n<N; n++)
    { 
      double Theta = ((double)n)*DeltaTheta;
      double CT    = cos(Theta), ST=sin(Theta);
-     cdouble z1   = Rx*CT + II*Ry*ST;
-     cdouble dz   = (II*Rx*ST + Ry*CT)/((double)N);
-
-     MInvVHat->Copy(VHat);
-     UserFunc(z0+z1, UserData, MInvVHat, 0);
-
-     VecPlusEquals(A0->ZM, dz,    MInvVHat->ZM, M*L);
-     VecPlusEquals(A1->ZM, z1*dz, MInvVHat->ZM, M*L);
+     z1[n]        = Rx*CT + II*Ry*ST;
+     dz[n]        = (II*Rx*ST + Ry*CT)/((double)N);
+   }
 
-     if ( (n%2)==0 )
-      { VecPlusEquals(A0Coarse->ZM, 2.0*dz,    MInvVHat->ZM, M*L);
-        VecPlusEquals(A1Coarse->ZM, 2.0*z1*dz, MInvVHat->ZM, M*L);
+  if (Solver->FactorFunc)
+   EvaluateContourByFactorization(Solver, UserData, z0, N, z1, dz);
+  else
+   { Log(" Evaluating contour integral (%i points)...",N);
+     for(int n=0; n<N; n++)
+      { MInvVHat->Copy(VHat);
+        UserFunc(z0+z1[n], UserData, MInvVHat, 0);
+        AccumulateContourPoint(Solver, n, z1[n], dz[n], MInvVHat);
       }
    }
+  free(z1);
 
   /***************************************************************/
   /***************************************************************/
@@ -46,6 +46,18 @@
 /***************************************************************/
 typedef void (*BeynFunction)(cdouble z, void *UserData, HMatrix *VHat, HMatrix *MVHat);
 
+/***************************************************************/
+/* optional alternative to the above: the user's function      */
+/* should assemble M(z) into the MxM matrix M. The solver      */
+/* LU-factorizes the matrices for several contour points at    */
+/* once (in separate threads; the user's function itself is   */
+/* only ever called from one thread at a time), and retains    */
+/* the factorizations for reuse by later calls to BeynSolve at */
+/* the same contour points (for example after ReRandomize, or  */
+/* when refining a contour by doubling N).                     */
+/***************************************************************/
+typedef void (*BeynFactorFunction)(cdouble z, void *UserData, HMatrix *M);
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -61,6 +73,16 @@ typedef struct BeynSolver
    HVector *Sigma;
    cdouble *Workspace;
 
+   // fields used only if a BeynFactorFunction was specified:
+   // pool of MaxMatrices MxM matrices, of which those with
+   // CacheValid[n]==true hold the factorization of M(Cachedz[n])
+   BeynFactorFunction FactorFunc;
+   int Symmetry;
+   int MaxMatrices;
+   HMatrix **CachedM;
+   cdouble *Cachedz;
+   bool *CacheValid;
+
  } BeynSolver;
 
 // constructor, destructor
@@ -71,6 +93,32 @@ void DestroyBeynSolver(BeynSolver *Solver);
 // 
 void ReRandomize(BeynSolver *Solver, unsigned int RandSeed=0);
 
+// have BeynSolve compute M(z)\VHat by calling FactorFunc to
+// assemble M(z) and LU-factorizing and solving itself, instead
+// of calling the BeynFunction.
+// MaxMatrices is the number of MxM matrices the solver may
+// allocate; it bounds both the number of contour points that
+// are processed simultaneously (by separate threads) and the
+// number of factorizations retained for reuse.
+// Symmetry may be used to assert that M(zBar) = conj(M(z)),
+// where zBar is the reflection of z about the real axis
+// (BEYN_REALAXIS) or the imaginary axis (BEYN_IMAGAXIS); the
+// solver then uses the factorization at z to handle the
+// contour point zBar, if the contour contains both.
+// (for electromagnetic problems with exp(-i*omega*t) time
+// dependence, BEYN_IMAGAXIS holds if all material properties
+// satisfy eps(-conj(w)) = conj(eps(w)) and kBloch = 0.)
+#define BEYN_NOSYMMETRY 0
+#define BEYN_REALAXIS   1
+#define BEYN_IMAGAXIS   2
+void SetBeynFactorFunction(BeynSolver *Solver, BeynFactorFunction FactorFunc,
+                           int MaxMatrices=1, int Symmetry=BEYN_NOSYMMETRY);
+
+// discard all retained factorizations (needed if the user's
+// M(z) changes between calls to BeynSolve, e.g. because the
+// geometry was transformed)
+void ClearBeynCache(BeynSolver *Solver);
+
 // for both of the following routines,
 // the return value is the number of eigenvalues found,
 // and the eigenvalues and eigenvectors are stored in the
@@ -65,6 +65,9 @@ void BeynFunc(cdouble Omega, void *UserData, HMatrix *VHat, HMatrix *MVHat)
   if (G->LDim==2)
    Log(" assembling BEM matrix at k={%e,%e},Omega=%s", kBloch[0],kBloch[1],CD2S(Omega));
 
+  if (M==0)
+   M = Data->M = G->AllocateBEMMatrix();
+
   if (G->LDim==0)
    G->AssembleBEMMatrix(Omega, M);
   else
@@ -83,6 +86,28 @@ void BeynFunc(cdouble Omega, void *UserData, HMatrix *VHat, HMatrix *MVHat)
    }
 }
 
+/***************************************************************/
+/* alternative to BeynFunc used when several BEM matrices may  */
+/* be stored at once: the Beyn solver supplies the matrix,     */
+/* calls this routine to assemble it, and factorizes it and    */
+/* keeps the factorization itself.                             */
+/***************************************************************/
+void BeynFactorFunc(cdouble Omega, void *UserData, HMatrix *M)
+{
+  BFData *Data   = (BFData *)UserData;
+  RWGGeometry *G = Data->G;
+  double *kBloch = Data->kBloch;
+
+  Log(" assembling BEM matrix at Omega=%s",CD2S(Omega));
+  if (G->LDim==0)
+   G->AssembleBEMMatrix(Omega, M);
+  else
+   G->AssembleBEMMatrix(Omega, kBloch, M);
+
+  if (Data->LogFile)
+   fprintf(Data->LogFile,"%e %e\n",real(Omega),imag(Omega));
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -104,6 +129,8 @@ int main(int argc, char *argv[])
   double kx        = 0.0;  int nkx;
   double ky        = 0.0;  int nky;
   char *ContourFile=0;
+  double MaxMemory=0.0;
+  bool Symmetric=false;
 //
   char *FileBase=0;
 //
@@ -132,6 +159,9 @@ int main(int argc, char *argv[])
      {"ky",                 PA_INT,     1, 1, (void *)&ky,                 &nky, "y component of bloch vector"},
 //
      {"ContourFile",        PA_STRING,  1, 1, (void *)&ContourFile,        0,   "list of contours"},
+//
+     {"MaxMemory",          PA_DOUBLE,  1, 1, (void *)&MaxMemory,          0,   "memory (GB) available for BEM matrices at simultaneous contour points"},
+     {"Symmetric",          PA_BOOL,    0, 1, (void *)&Symmetric,          0,   "assume M(-conj(w)) = conj(M(w)) to halve the number of BEM matrices"},
 //
      {"PlotContours",       PA_BOOL,    0, 1, (void *)&PlotContours,       0,   "plot contours for visualization"},
 //
@@ -163,9 +193,15 @@ int main(int argc, char *argv[])
   /* initialize RWGGeometry, read list of contours               */
   /***************************************************************/
   RWGGeometry *G         = new RWGGeometry(GeoFile);
-  HMatrix *M             = G->AllocateBEMMatrix();
+  HMatrix *M             = 0; // allocated on demand by BeynFunc
   int D = G->TotalBFs;
 
+  // number of BEM matrices that fit in the user's memory budget
+  double MatrixBytes = 16.0*((double)D)*((double)D);
+  int MaxMatrices = (int)floor(MaxMemory*1.0e9 / MatrixBytes);
+  if (MaxMemory>0.0 && MaxMatrices<1)
+   Warn("--MaxMemory %g GB is too small for one BEM matrix (%g GB)",MaxMemory,MatrixBytes/1.0e9);
+
   /***************************************************************/
   /* process contour specifications ******************************/
   /***************************************************************/
@@ -234,7 +270,17 @@ int main(int argc, char *argv[])
      HVector *EVErrors     = Solver->EVErrors;
      HMatrix *Eigenvectors = Solver->Eigenvectors;
      HVector *Residuals    = Solver->Residuals;
+     // M(-conj(w)) = conj(M(w)) fails for nonzero Bloch vectors
+     bool SymmetricContour = Symmetric;
+     if (Symmetric && kBloch && (kBloch[0]!=0.0 || (G->LDim>1 && kBloch[1]!=0.0)) )
+      { Warn("--Symmetric is only valid at kBloch=0 (ignoring for contour %s)",ContourLabel);
+        SymmetricContour = false;
+      }
+     if (MaxMatrices>0 || SymmetricContour)
+      SetBeynFactorFunction(Solver, BeynFactorFunc, MaxMatrices,
+                            SymmetricContour ? BEYN_IMAGAXIS : BEYN_NOSYMMETRY);
      int NumModes=BeynSolve(Solver, BeynFunc, (void *)&MyBFData, Omega0, Rx, Ry, N);
+     M = MyBFData.M;
 
      if (PlotContours)
       fclose(MyBFData.LogFile);
@@ -49,12 +49,8 @@ typedef struct BFData
    HMatrix *M;
  } BFData;
 
-void BeynFunc(cdouble z, void *UserData, HMatrix *VHat, HMatrix *MVHat)
+void AssembleM(cdouble z, HMatrix *M)
 {
-  // unpack fields from data structure
-  BFData *Data   = (BFData *)UserData;
-  HMatrix *M     = Data->M;
-
   // assemble M matrix as described in Beyn section 4.11
   int NR = M->NR;
   double m = (double)NR;
@@ -69,6 +65,15 @@ void BeynFunc(cdouble z, void *UserData, HMatrix *VHat, HMatrix *MVHat)
    };
   M->SetEntry(NR-1, NR-2, ODE);
   M->SetEntry(NR-1, NR-1, 0.5*DE + z/(z-1.0) ); // bottom row
+}
+
+void BeynFunc(cdouble z, void *UserData, HMatrix *VHat, HMatrix *MVHat)
+{
+  // unpack fields from data structure
+  BFData *Data   = (BFData *)UserData;
+  HMatrix *M     = Data->M;
+
+  AssembleM(z, M);
 
   if (MVHat)
    M->Multiply(VHat, MVHat);
@@ -79,6 +84,14 @@ void BeynFunc(cdouble z, void *UserData, HMatrix *VHat, HMatrix *MVHat)
    }
 }
 
+// alternative to BeynFunc for use with SetBeynFactorFunction;
+// the matrix has real coefficients, so M(conj(z)) = conj(M(z))
+void BeynFactorFunc(cdouble z, void *UserData, HMatrix *M)
+{
+  (void) UserData;
+  AssembleM(z, M);
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -96,6 +109,9 @@ int main(int argc, char *argv[])
   int L       = 10;
   int N       = 50;
   int Dim     = 400;
+  int MaxMatrices = 0;
+  bool Symmetric  = false;
+  bool Repeat     = false;
   /* name        type    #args  max_instances  storage    count  description*/
   OptStruct OSArray[]=
    { {"z0",                 PA_CDOUBLE, 1, 1, (void *)&z0,   0,   "center of elliptical contour ({150,0})"},
@@ -109,6 +125,12 @@ int main(int argc, char *argv[])
      {"L",                  PA_INT,     1, 1, (void *)&L,    0,   "number of EVs expected in contour (10)"},
 //
      {"Dim",                PA_INT,     1, 1, (void *)&Dim,  0,   "dimension of problem (400)"},
+//
+     {"MaxMatrices",        PA_INT,     1, 1, (void *)&MaxMatrices, 0, "number of factorized matrices to retain (0: use BeynFunc)"},
+//
+     {"Symmetric",          PA_BOOL,    0, 1, (void *)&Symmetric, 0, "exploit M(conj(z)) = conj(M(z))"},
+//
+     {"Repeat",             PA_BOOL,    0, 1, (void *)&Repeat,    0, "solve again with a new random matrix"},
      {0,0,0,0,0,0,0}
    };
   ProcessOptions(argc, argv, OSArray);
@@ -118,6 +140,9 @@ int main(int argc, char *argv[])
   /* initialize BeynSolver data structure ************************/
   /***************************************************************/
   BeynSolver *Solver = CreateBeynSolver(Dim, L);
+  if (MaxMatrices>0)
+   SetBeynFactorFunction(Solver, BeynFactorFunc, MaxMatrices,
+                         Symmetric ? BEYN_REALAXIS : BEYN_NOSYMMETRY);
 
   /***************************************************************/
   /* initialize data structure needed for our BeynFunction  ******/
@@ -128,10 +153,15 @@ int main(int argc, char *argv[])
   /***************************************************************/
   /* compute eigenvalues by Beyn method                          */
   /***************************************************************/
-  int K=BeynSolve(Solver, BeynFunc, (void *)BFD, z0, Rx, Ry, N);
+  for(int nr=0; nr<(Repeat ? 2 : 1); nr++)
+   { 
+     if (nr>0) ReRandomize(Solver);
 
-  printf("Found %i eigenvalues: \n",K);
-  for(int k=0; k<K; k++)
-   printf("%i: %s \n",k,CD2S(Solver->Eigenvalues->GetEntry(k)));
+     int K=BeynSolve(Solver, BeynFunc, (void *)BFD, z0, Rx, Ry, N);
+
+     printf("Found %i eigenvalues: \n",K);
+     for(int k=0; k<K; k++)
+      printf("%i: %s \n",k,CD2S(Solver->Eigenvalues->GetEntry(k)));
+   }
 
 }
@@ -121,7 +121,7 @@ void WritePolarizabilities(StaticSolver *SS, HMatrix *M, HVector *Sigma, char *P
      Data.E0[Mu]=1.0;
   
      SS->AssembleRHSVector(&SE, Sigma);
-     M->LUSolve(Sigma);
+     SS->SolveBEMSystem(M, Sigma);
      SS->GetCartesianMoments(Sigma, QP);
      for(int ns=0; ns<NS; ns++)
       { PolMatrix->SetEntry(ns, 0*3+Mu, QP->GetEntryD(ns,1));
@@ -251,7 +251,7 @@ void WriteCMatrix(StaticSolver *SS, HMatrix *M, HVector *Sigma,
       StaticField SFs[1]={SphericalStaticField};
       StaticExcitation SE={0,0,SFs,(void **)(&Data),1};
       SS->AssembleRHSVector(&SE, Sigma);
-      M->LUSolve(Sigma);
+      SS->SolveBEMSystem(M, Sigma);
 
       /*--------------------------------------------------------------*/
       /*--------------------------------------------------------------*/
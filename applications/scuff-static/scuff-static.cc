@@ -120,6 +120,7 @@ int main(int argc, char *argv[])
   char *SolutionFile= 0;
   char *SolutionName= 0;
   bool DisableEquivalentPairs = false;
+  bool FastSolver = false;
   /* name               type    #args  max_instances  storage           count         description*/
   OptStruct OSArray[]=
    { 
@@ -148,7 +149,8 @@ int main(int argc, char *argv[])
 /**/
      {"SolutionFile",   PA_STRING,  1, 1,       (void *)&SolutionFile, 0,           "name of HDF5 file for solution input/output"},
      {"SolutionName",   PA_STRING,  1, 1,       (void *)&SolutionName, 0,           "name of dataset within HDF5 file\n"},
-     {"DisableEquivalentPairs", PA_BOOL, 1, 0,  (void *)&DisableEquivalentPairs, 0, "do not identify equivalent surface pairs\n"},
+     {"DisableEquivalentPairs", PA_BOOL, 1, 0,  (void *)&DisableEquivalentPairs, 0, "do not identify equivalent surface pairs"},
+     {"FastSolver",     PA_BOOL,    1, 0,       (void *)&FastSolver, 0,             "use octree-accelerated iterative solver instead of dense LU\n"},
 /**/
      {0,0,0,0,0,0,0}
    };
@@ -240,7 +242,7 @@ int main(int argc, char *argv[])
   //BMAccelerator *BMA = (NT==1) ? 0 : CreateBMAccelerator(SS);
   // TODO figure out interaction between transfiles and equivalent pairs
   if (NT>1) DisableEquivalentPairs=true; 
-  BMAccelerator *BMA = CreateBMAccelerator(SS, GTCs, !DisableEquivalentPairs);
+  BMAccelerator *BMA = FastSolver ? 0 : CreateBMAccelerator(SS, GTCs, !DisableEquivalentPairs);
 
   /*******************************************************************/
   /* loop over transformations.                                      */
@@ -262,7 +264,18 @@ int main(int argc, char *argv[])
      if (SolutionFile)
       HaveSolution=FileOp(FILEOP_READ, Sigma, SolutionFile, SolutionName, SS->TransformLabel);
 
-     if (!HaveSolution)
+     /*******************************************************************/
+     /* the fast solver's octree must be rebuilt at each transformation;*/
+     /* if we will not be solving at this transformation we discard it  */
+     /* so that field computations do not use the stale octree          */
+     /*******************************************************************/
+     if (FastSolver)
+      { if (!HaveSolution || PolFile || CapFile || CMatrixFile)
+         SS->InitFastSolver();
+        else
+         SS->DestroyFastSolver();
+      }
+     else if (!HaveSolution)
       ReassembleBEMMatrix(SS, &M, BMA, nt);
 
      /*******************************************************************/
@@ -289,7 +302,7 @@ int main(int argc, char *argv[])
         if (!HaveSolution)
          { 
            SS->AssembleRHSVector(SE, Sigma);
-           M->LUSolve(Sigma);
+           SS->SolveBEMSystem(M, Sigma);
            if (SolutionFile)
             FileOp(FILEOP_WRITE, Sigma, SolutionFile, SolutionName, SS->TransformLabel);
          };
@@ -54,6 +54,9 @@ using namespace scuff;
 HVector *GetSphericalMoments(RWGGeometry *G, cdouble k, int LMax,
                              HVector *KN, HVector *MomentVector);
 
+void GetSphericalWaveMatrices(RWGGeometry *G, cdouble Omega, int lMax,
+                              HMatrix *RHSMatrix, HMatrix *PMatrix);
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -72,6 +75,7 @@ int main(int argc, char *argv[])
   char *Cache=0;             // scuff cache file 
   char *FileBase=0;          // base filename for output file
   bool WriteHDF5Files=false; // write T-matrix data to HDF5 files
+  bool ColumnByColumn=false; // compute T-matrix one column at a time
   /* name        type    #args  max_instances  storage    count  description*/
   OptStruct OSArray[]=
    { {"geometry",       PA_STRING,  1, 1, (void *)&GeoFileName,    0,  ".scuffgeo file"},
@@ -81,6 +85,7 @@ int main(int argc, char *argv[])
      {"Cache",          PA_STRING,  1, 1, (void *)&Cache,          0,  "scuff cache file"},
      {"FileBase",       PA_STRING,  1, 1, (void *)&FileBase,       0,  "base filename for output files"},
      {"WriteHDF5Files", PA_BOOL,    0, 1, (void *)&WriteHDF5Files, 0,  "write HDF5 output files"},
+     {"ColumnByColumn", PA_BOOL,    0, 1, (void *)&ColumnByColumn, 0,  "solve for one T-matrix column at a time (slow; for cross-checking)"},
      {0,0,0,0,0,0,0}
    };
   ProcessOptions(argc, argv, OSArray);
@@ -121,6 +126,18 @@ int main(int argc, char *argv[])
   int NumMoments= 2*NumLMs;
   HMatrix *TMatrix = new HMatrix(NumMoments, NumMoments, LHM_COMPLEX);
 
+  /*--------------------------------------------------------------*/
+  /*- unless --ColumnByColumn was specified, we compute the       */
+  /*- T-matrix as T = P * Inverse[M] * R, where the columns of R  */
+  /*- are the RHS vectors for all incident spherical waves and    */
+  /*- the rows of P project surface currents onto outgoing waves. */
+  /*--------------------------------------------------------------*/
+  HMatrix *RMatrix = 0, *PMatrix = 0;
+  if (!ColumnByColumn)
+   { RMatrix = new HMatrix(G->TotalBFs, NumMoments, LHM_COMPLEX);
+     PMatrix = new HMatrix(NumMoments, G->TotalBFs, LHM_COMPLEX);
+   }
+
   /*--------------------------------------------------------------*/
   /* instantiate a SphericalWave structure (we will set the L, M, */
   /* and P fields later)                                          */
@@ -159,24 +176,32 @@ int main(int argc, char *argv[])
      /*- of the T matrix; note Betais a running column index)        */
      /*--------------------------------------------------------------*/
      TMatrix->Zero();
-     for(int LBeta=1, Beta=0; LBeta<=LMax; LBeta++)
-      for(int MBeta=-LBeta; MBeta<=LBeta; MBeta++)
-       for(int PBeta=0; PBeta<2; PBeta++, Beta++)
-        { 
-           SW.SetL(LBeta);
-           SW.SetM(MBeta);
-           SW.SetP(PBeta);
-
-           // solve the scattering problem for this incident spherical wave
-           Log("Solving scattering problem with incident spherical wave #%i: (L,M,P)=(%i,%i,%i)",Beta,LBeta,MBeta,PBeta);
-           G->AssembleRHSVector(Omega, &SW, KN);
-           M->LUSolve(KN);
-
-           // compute the full vector of spherical multipole moments induced by the
-           // incident wave on the object and store it as the Betath column of the T-matrix
-           HVector TColumn(NumMoments, LHM_COMPLEX, (cdouble *)TMatrix->GetColumnPointer(Beta));
-           GetSphericalMoments(G, Omega, LMax, KN, &TColumn);
-        }; // for (nc=l=0...)
+     if (!ColumnByColumn)
+      { GetSphericalWaveMatrices(G, Omega, LMax, RMatrix, PMatrix);
+        Log("Solving scattering problems for %i incident spherical waves",NumMoments);
+        M->LUSolve(RMatrix);
+        PMatrix->Multiply(RMatrix, TMatrix);
+      }
+     else
+      { for(int LBeta=1, Beta=0; LBeta<=LMax; LBeta++)
+        for(int MBeta=-LBeta; MBeta<=LBeta; MBeta++)
+         for(int PBeta=0; PBeta<2; PBeta++, Beta++)
+          { 
+             SW.SetL(LBeta);
+             SW.SetM(MBeta);
+             SW.SetP(PBeta);
+
+             // solve the scattering problem for this incident spherical wave
+             Log("Solving scattering problem with incident spherical wave #%i: (L,M,P)=(%i,%i,%i)",Beta,LBeta,MBeta,PBeta);
+             G->AssembleRHSVector(Omega, &SW, KN);
+             M->LUSolve(KN);
+
+             // compute the full vector of spherical multipole moments induced by the
+             // incident wave on the object and store it as the Betath column of the T-matrix
+             HVector TColumn(NumMoments, LHM_COMPLEX, (cdouble *)TMatrix->GetColumnPointer(Beta));
+             GetSphericalMoments(G, Omega, LMax, KN, &TColumn);
+          }; // for (nc=l=0...)
+      }
 
      /*--------------------------------------------------------------*/
      /*- write the full content of the T-matrix at this frequency to */
@@ -203,6 +228,8 @@ int main(int argc, char *argv[])
     }; // for( nOmega= ... )
 
   fclose(f);
+  if (RMatrix) delete RMatrix;
+  if (PMatrix) delete PMatrix;
       
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
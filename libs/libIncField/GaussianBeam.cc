@@ -73,26 +73,43 @@ void GaussianBeam::SetE0(cdouble pE0[3])      { memcpy(E0,    pE0,    3*sizeof(c
 void GaussianBeam::SetW0(double pW0)          { W0 = pW0; }
 
 /***************************************************************/
+/* quantities that depend only on the beam parameters and not  */
+/* on the evaluation point; these are computed once per call   */
+/* to GetFields(), so that a batched call pays for them only   */
+/* once.                                                       */
 /***************************************************************/
-/***************************************************************/
-void GaussianBeam::GetFields(const double X[3], cdouble EH[6])
+typedef struct GBData
+ { 
+   double k;             // wavenumber of medium
+   double ZR;            // relative wave impedance of medium
+   double z0, kz0;
+   double X0[3];
+   dVector zHat;
+
+   // local coordinate systems for the real and imaginary parts
+   // of E0: ^z = kProp, ^x ~ Re(E0) or Im(E0), ^y ~ ^z x ^x
+   double rnorm, inorm;
+   dVector xHatR, yHatR, xHatI, yHatI;
+
+   // normalization factors for ordinary and rescaled f,g
+   double Eorig, EorigRescaled;
+
+ } GBData;
+
+static void InitGBData(GaussianBeam *GB, GBData *Data)
 {
-  if ( imag(Eps) !=0.0 || imag(Mu) != 0.0 )
+  if ( imag(GB->Eps) !=0.0 || imag(GB->Mu) != 0.0 )
    ErrExit("%s:%i: gaussian beams not implemented for dispersive media");
-  if ( imag(Omega) !=0.0 )
+  if ( imag(GB->Omega) !=0.0 )
    ErrExit("%s:%i: gaussian beams not implemented for imaginary frequencies");
-  if ( LBasis )
+  if ( GB->LBasis )
    ErrExit("%s:%i: gaussian beams not implemented for bloch-periodic geometries");
 
-  const cdouble IU(0,1);
-  double EpsR = real(Eps);
-  double MuR  = real(Mu);
-  double k    = sqrt(EpsR*MuR)*real(Omega); // wavenumber of medium 
-  double ZR   = sqrt(MuR/EpsR);             // relative wave impedance of medium
-
-  zVector zvE0     = E0;     // complex field-strength vector
-                          // containing information on the 
-                          // field strength and polarization 
+  double EpsR = real(GB->Eps);
+  double MuR  = real(GB->Mu);
+  double k    = sqrt(EpsR*MuR)*real(GB->Omega);
+  Data->k     = k;
+  Data->ZR    = sqrt(MuR/EpsR);
 
   // we follow CJR Sheppard & S Saghafi, J Opt Soc Am A 16, 1381 and
   // approximate the Gaussian beam as the field of the sum of an   
@@ -100,21 +117,58 @@ void GaussianBeam::GetFields(const double X[3], cdouble EH[6])
   // the complex point X = (0,0,i z0)
   // this has the advantage that the field can be analytically calculated
   // and exactly solves Maxwell's equations everywhere in space
-  double z0 = k*W0*W0/2;
+  double z0 = k*GB->W0*GB->W0/2;
   double kz0 = k*z0;
-  dVector Xrel = dVector(X) - dVector(X0);
+  Data->z0  = z0;
+  Data->kz0 = kz0;
+  memcpy(Data->X0, GB->X0, 3*sizeof(double));
+
+  Data->zHat = GB->KProp; Data->zHat.normalize();
 
   // the field has NO cylindrical symmetry! this means that for
   // complex polarization vectors, we have to do a separate calculation
   // for the real and for the complex part
+  zVector zvE0 = GB->E0; // complex field-strength vector
+                         // containing information on the 
+                         // field strength and polarization 
+  Data->rnorm = norm(zvE0.real());
+  if (Data->rnorm>1e-13)
+   { Data->xHatR = zvE0.real() / Data->rnorm;
+     Data->yHatR = cross(Data->zHat,Data->xHatR);
+   };
+  Data->inorm = norm(zvE0.imag());
+  if (Data->inorm>1e-13)
+   { Data->xHatI = zvE0.imag() / Data->inorm;
+     Data->yHatI = cross(Data->zHat,Data->xHatI);
+   };
+
+  // the field as calculated below is not normalized, so we get the field strength at the origin
+  // (for E0 == 1)
+  // this can be simplified very much by using that for x=y=z=0, R = sqrt((-i z0)**2) = i z0
+  // 20130915 HR see comments below; note sinh(kz0)/exp(kz0) = 0.5(1-exp(-2*kz0)) 
+  Data->EorigRescaled = 3./(2*kz0*kz0*kz0) * (kz0*(kz0-1) + 0.5*(1.0-exp(-2.0*kz0)) );
+  Data->Eorig         = 3./(2*kz0*kz0*kz0) * (exp(kz0)*kz0*(kz0-1) + sinh(kz0));
+}
+
+/***************************************************************/
+/* fields at a single point given the precomputed beam data;   */
+/* the six field components are written to EH[0], EH[Stride],  */
+/* ..., EH[5*Stride].                                          */
+/***************************************************************/
+static void GetGBFields(GBData *Data, const double X[3], cdouble *EH, int Stride)
+{
+  const cdouble IU(0,1);
+  double k    = Data->k;
+  double z0   = Data->z0;
+  double kz0  = Data->kz0;
+  dVector Xrel = dVector(X) - dVector(Data->X0);
 
   // first, we do everything that is not direction dependent, i.e.
   // where we only need the z-coordinate and the radial distance rho
-  dVector zHat = KProp; zHat.normalize();
   double z, rho;
 
   // this is from libVec.h
-  GetLocalCylinderCoordinates(Xrel, zHat, rho, z);
+  GetLocalCylinderCoordinates(Xrel, Data->zHat, rho, z);
 
   // HR 20130915 the cos, sin below can overflow if kR has large 
   // imaginary part, so in that case we use the 'rescaled' versions 
@@ -156,14 +210,14 @@ void GaussianBeam::GetFields(const double X[3], cdouble EH[6])
   cdouble i2fk = 0.5*IU*f*k;
 
   // now calculate the actual coordinates for having either zvE0.real() or zvE0.imag() as the x axis
-  // local coordinate system given by ^z = kProp, ^x ~ Re(E0) or Im(E0), ^y ~ ^z x ^x  
   zVector E, H;
+  zVector zHat = Data->zHat;
 
-  double rnorm = norm(zvE0.real());
+  double rnorm = Data->rnorm;
   if (rnorm>1e-13) {
     // calculate fields in local coordinate system
-    dVector xHat = zvE0.real() / rnorm;
-    dVector yHat = cross(zHat,xHat);
+    dVector &xHat = Data->xHatR;
+    dVector &yHat = Data->yHatR;
     double  x  = dot(xHat,Xrel);
     double  y  = dot(yHat,Xrel);
     
@@ -175,15 +229,15 @@ void GaussianBeam::GetFields(const double X[3], cdouble EH[6])
     cdouble Hz =     fmgbRsq * y * zc - i2fk * y;
 
     // go back to the laboratory frame
-    E += cdouble(rnorm) * (Ex * zVector(xHat) + Ey * zVector(yHat) + Ez * zVector(zHat));
-    H += cdouble(rnorm) * (Hx * zVector(xHat) + Hy * zVector(yHat) + Hz * zVector(zHat));
+    E += cdouble(rnorm) * (Ex * zVector(xHat) + Ey * zVector(yHat) + Ez * zHat);
+    H += cdouble(rnorm) * (Hx * zVector(xHat) + Hy * zVector(yHat) + Hz * zHat);
   } 
   
-  double inorm = norm(zvE0.imag());
+  double inorm = Data->inorm;
   if (inorm>1e-13) {
     // calculate fields in local coordinate system
-    dVector xHat = zvE0.imag() / inorm;
-    dVector yHat = cross(zHat,xHat);
+    dVector &xHat = Data->xHatI;
+    dVector &yHat = Data->yHatI;
     double  x  = dot(xHat,Xrel);
     double  y  = dot(yHat,Xrel);
     
@@ -195,26 +249,39 @@ void GaussianBeam::GetFields(const double X[3], cdouble EH[6])
     cdouble Hz =     fmgbRsq * y * zc - i2fk * y;
     
     // go back to the laboratory frame
-    E += IU * inorm * (Ex * zVector(xHat) + Ey * zVector(yHat) + Ez * zVector(zHat));
-    H += IU * inorm * (Hx * zVector(xHat) + Hy * zVector(yHat) + Hz * zVector(zHat));
+    E += IU * inorm * (Ex * zVector(xHat) + Ey * zVector(yHat) + Ez * zHat);
+    H += IU * inorm * (Hx * zVector(xHat) + Hy * zVector(yHat) + Hz * zHat);
   }
 
-  // the field as calculated above is not normalized, so we get the field strength at the origin
-  // (for E0 == 1)
-  // this can be simplified very much by using that for x=y=z=0, R = sqrt((-i z0)**2) = i z0
-
-  // 20130915 HR see comments above; note sinh(kz0)/exp(kz0) = 0.5(1-exp(-2*kz0)) 
-  double Eorig; 
-  if (UseRescaledFG)
-   Eorig = 3./(2*kz0*kz0*kz0) * (kz0*(kz0-1) + 0.5*(1.0-exp(-2.0*kz0)) );
-  else
-   Eorig = 3./(2*kz0*kz0*kz0) * (exp(kz0)*kz0*(kz0-1) + sinh(kz0));
-  
   // now scale the fields to have E(0,0,0) = E0
+  double Eorig = UseRescaledFG ? Data->EorigRescaled : Data->Eorig;
   E /= Eorig;
-  EH[0] = E[0]; EH[1] = E[1]; EH[2] = E[2];
-  H /= (Eorig*ZVAC*ZR);
-  EH[3] = H[0]; EH[4] = H[1]; EH[5] = H[2];
+  EH[0*Stride] = E[0]; EH[1*Stride] = E[1]; EH[2*Stride] = E[2];
+  H /= (Eorig*ZVAC*Data->ZR);
+  EH[3*Stride] = H[0]; EH[4*Stride] = H[1]; EH[5*Stride] = H[2];
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void GaussianBeam::GetFields(const double X[3], cdouble EH[6])
+{
+  GBData Data;
+  InitGBData(this, &Data);
+  GetGBFields(&Data, X, EH, 1);
+}
+
+void GaussianBeam::GetFields(int NX, const double *X, cdouble *EH)
+{
+  GBData Data;
+  InitGBData(this, &Data);
+  for(int nx=0; nx<NX; nx++)
+   { double XX[3];
+     XX[0]=X[nx + 0*NX];
+     XX[1]=X[nx + 1*NX];
+     XX[2]=X[nx + 2*NX];
+     GetGBFields(&Data, XX, EH + nx, NX);
+   };
 }
 
 /**********************************************************************/
@@ -174,6 +174,39 @@ void IncField::GetTotalFields(const double X[3], cdouble EH[6])
    };
 }
 
+/***************************************************************/
+/* default implementation of the batched field routine: gather */
+/* each point out of the structure-of-arrays input, call the   */
+/* single-point routine, and scatter the result.               */
+/***************************************************************/
+void IncField::GetFields(int NX, const double *X, cdouble *EH)
+{
+  for(int nx=0; nx<NX; nx++)
+   { double XX[3];
+     cdouble PEH[6];
+     XX[0]=X[nx + 0*NX];
+     XX[1]=X[nx + 1*NX];
+     XX[2]=X[nx + 2*NX];
+     GetFields(XX, PEH);
+     for(int nc=0; nc<6; nc++)
+      EH[nx + nc*NX] = PEH[nc];
+   };
+}
+
+void IncField::GetTotalFields(int NX, const double *X, cdouble *EH)
+{
+  if (NX<=0) return;
+
+  memset(EH, 0, 6*NX*sizeof(cdouble));
+  cdouble *PEH = (cdouble *)mallocEC(6*NX*sizeof(cdouble));
+  for(IncField *IFD=this; IFD; IFD=IFD->Next)
+   { IFD->GetFields(NX, X, PEH);
+     for(int n=0; n<6*NX; n++)
+      EH[n] += PEH[n];
+   };
+  free(PEH);
+}
+
 /***************************************************************/
 /* get field gradients by finite-differencing; this method may */
 /* be overridden by subclasses who know how to compute their   */
@@ -86,6 +86,33 @@ void PlaneWave::GetFields(const double X[3], cdouble EH[6])
   
 } 
 
+/**********************************************************************/
+/* batched version: K, Z, and nHat x E0 are computed once per batch,  */
+/* leaving only the phase factor to be evaluated at each point.       */
+/**********************************************************************/
+void PlaneWave::GetFields(int NX, const double *X, cdouble *EH)
+{
+  cdouble K=sqrt(Eps*Mu) * Omega;
+  cdouble Z=ZVAC*sqrt(Mu/Eps);
+
+  cdouble H0[3];
+  H0[0] = (nHat[1]*E0[2] - nHat[2]*E0[1]) / Z;
+  H0[1] = (nHat[2]*E0[0] - nHat[0]*E0[2]) / Z;
+  H0[2] = (nHat[0]*E0[1] - nHat[1]*E0[0]) / Z;
+
+  const double *XX=X, *YY=X+NX, *ZZ=X+2*NX;
+  cdouble iK=II*K;
+  for(int nx=0; nx<NX; nx++)
+   { cdouble ExpFac=exp(iK*(nHat[0]*XX[nx] + nHat[1]*YY[nx] + nHat[2]*ZZ[nx]));
+     EH[nx + 0*NX] = E0[0] * ExpFac;
+     EH[nx + 1*NX] = E0[1] * ExpFac;
+     EH[nx + 2*NX] = E0[2] * ExpFac;
+     EH[nx + 3*NX] = H0[0] * ExpFac;
+     EH[nx + 4*NX] = H0[1] * ExpFac;
+     EH[nx + 5*NX] = H0[2] * ExpFac;
+   };
+}
+
 /***************************************************************/
 /* overrides the default implementation of this method in      */
 /* the base class                                              */
@@ -40,14 +40,13 @@
 
 namespace scuff {
 
-void GBarVDEwald(double *R, cdouble k, double *kBloch,
+void GBarVDEwald(int NumPoints, double *R, cdouble k, double *kBloch,
                  double (*LBV)[3], int LDim,
                  double E, bool ExcludeInnerCells, cdouble *GBarVD);
 
-void GetGCBar2D_Fourier(cdouble k, double *kBloch,
-                        HMatrix *RLBasis, double RLVolume,
-                        double *XDest, double *XSource,
-                        cdouble G[3][3], cdouble C[3][3]);
+HMatrix *GetGCBar2D_Fourier(cdouble k, double *kBloch,
+                            HMatrix *RLBasis, double RLVolume,
+                            HMatrix *XDXSMatrix, HMatrix *GCMatrix);
                 }
 
 /**********************************************************************/
@@ -117,66 +116,76 @@ bool PointSource::GetSourcePoint(double X[3]) const
 /* moment divided by \epsilon_0, which means that P has units of      */
 /* voltage*length^2.                                                  */
 /*                                                                    */
+/* The single-point routines are just the NX=1 case of the batched    */
+/* routines, for which the structure-of-arrays layout coincides with  */
+/* the X[3], EH[6] layout.                                            */
 /**********************************************************************/
 void PointSource::GetFields(const double X[3], cdouble EH[6])
+{ GetFields(1, X, EH); }
+
+void PointSource::GetFields_Periodic(const double X[3], cdouble EH[6])
+{ GetFields_Periodic(1, X, EH); }
+
+void PointSource::GetFields(int NX, const double *X, cdouble *EH)
 {
   if (LBasis)
-   { GetFields_Periodic(X, EH);
+   { GetFields_Periodic(NX, X, EH);
      return; 
    };
 
-  /* construct R, RHat, etc. */
-  double RHat[3], R;
-  RHat[0]=X[0] - X0[0];
-  RHat[1]=X[1] - X0[1];
-  RHat[2]=X[2] - X0[2];
-  R=sqrt(  RHat[0]*RHat[0] + RHat[1]*RHat[1] + RHat[2]*RHat[2] );
-  RHat[0]/=R;
-  RHat[1]/=R;
-  RHat[2]/=R;
-
-  cdouble PDotR, RCrossP[3];
-  PDotR=P[0]*RHat[0] + P[1]*RHat[1] + P[2]*RHat[2];
-  RCrossP[0]= RHat[1]*P[2] - RHat[2]*P[1];
-  RCrossP[1]= RHat[2]*P[0] - RHat[0]*P[2];
-  RCrossP[2]= RHat[0]*P[1] - RHat[1]*P[0];
-  
+  /* quantities that are the same for all evaluation points */
   cdouble k      = Omega*sqrt(Eps*Mu);
-  cdouble ikr    = II*k*R;
-  cdouble ikr2   = ikr*ikr;
-  cdouble ExpFac = k*k*exp(ikr) / (4.0*M_PI*R);
-
   cdouble Z      = ZVAC*sqrt(Mu/Eps);
+  cdouble ik     = II*k;
+  cdouble PreFac = k*k / (4.0*M_PI);
+  PreFac /= (Type==LIF_ELECTRIC_DIPOLE ? Eps : Mu);
 
-  /* compute the various scalar quantities in the point source formulae */
-  cdouble Term1=  1.0 - 1.0/ikr + 1.0/ikr2; 
-  cdouble Term2= (-1.0 + 3.0/ikr - 3.0/ikr2) * PDotR; 
-  cdouble Term3= (1.0 - 1.0/ikr);
-
-  /* now assemble everything based on source type */
-  if ( Type == LIF_ELECTRIC_DIPOLE )
-   { 
-     ExpFac /= Eps;
-
-     EH[0]=ExpFac*( Term1*P[0] + Term2*RHat[0] );
-     EH[1]=ExpFac*( Term1*P[1] + Term2*RHat[1] );
-     EH[2]=ExpFac*( Term1*P[2] + Term2*RHat[2] );
-
-     EH[3]=ExpFac*Term3*RCrossP[0] / Z;
-     EH[4]=ExpFac*Term3*RCrossP[1] / Z;
-     EH[5]=ExpFac*Term3*RCrossP[2] / Z;
-   }
-  else // ( Type == LIF_MAGNETIC_DIPOLE )
+  for(int nx=0; nx<NX; nx++)
    { 
-     ExpFac /= Mu;
-
-     EH[0]=-1.0*Z*ExpFac*Term3*RCrossP[0];
-     EH[1]=-1.0*Z*ExpFac*Term3*RCrossP[1];
-     EH[2]=-1.0*Z*ExpFac*Term3*RCrossP[2];
-
-     EH[3]=ExpFac*( Term1*P[0] + Term2*RHat[0] );
-     EH[4]=ExpFac*( Term1*P[1] + Term2*RHat[1] );
-     EH[5]=ExpFac*( Term1*P[2] + Term2*RHat[2] );
+     /* construct R, RHat, etc. */
+     double RHat[3], R;
+     RHat[0]=X[nx + 0*NX] - X0[0];
+     RHat[1]=X[nx + 1*NX] - X0[1];
+     RHat[2]=X[nx + 2*NX] - X0[2];
+     R=sqrt(  RHat[0]*RHat[0] + RHat[1]*RHat[1] + RHat[2]*RHat[2] );
+     RHat[0]/=R;
+     RHat[1]/=R;
+     RHat[2]/=R;
+
+     cdouble PDotR, RCrossP[3];
+     PDotR=P[0]*RHat[0] + P[1]*RHat[1] + P[2]*RHat[2];
+     RCrossP[0]= RHat[1]*P[2] - RHat[2]*P[1];
+     RCrossP[1]= RHat[2]*P[0] - RHat[0]*P[2];
+     RCrossP[2]= RHat[0]*P[1] - RHat[1]*P[0];
+
+     cdouble ikr    = ik*R;
+     cdouble ikr2   = ikr*ikr;
+     cdouble ExpFac = PreFac*exp(ikr) / R;
+
+     /* compute the various scalar quantities in the point source formulae */
+     cdouble Term1=  1.0 - 1.0/ikr + 1.0/ikr2; 
+     cdouble Term2= (-1.0 + 3.0/ikr - 3.0/ikr2) * PDotR; 
+     cdouble Term3= (1.0 - 1.0/ikr);
+
+     /* now assemble everything based on source type */
+     cdouble *EE, *HH;
+     if ( Type == LIF_ELECTRIC_DIPOLE )
+      { EE = EH + nx;
+        HH = EH + nx + 3*NX;
+      }
+     else // ( Type == LIF_MAGNETIC_DIPOLE )
+      { EE = EH + nx + 3*NX;
+        HH = EH + nx;
+        Term3 *= -1.0*Z*Z;
+      };
+
+     EE[0*NX]=ExpFac*( Term1*P[0] + Term2*RHat[0] );
+     EE[1*NX]=ExpFac*( Term1*P[1] + Term2*RHat[1] );
+     EE[2*NX]=ExpFac*( Term1*P[2] + Term2*RHat[2] );
+
+     HH[0*NX]=ExpFac*Term3*RCrossP[0] / Z;
+     HH[1*NX]=ExpFac*Term3*RCrossP[1] / Z;
+     HH[2*NX]=ExpFac*Term3*RCrossP[2] / Z;
    };
 
 }
@@ -184,28 +193,31 @@ void PointSource::GetFields(const double X[3], cdouble EH[6])
 /**********************************************************************/
 /* 20160629 this is my older implementation of the periodic point-source */
 /* fields, which used Ewald summation; I am replacing it with the new */
+/*                                                                    */
+/* In the batched version, the seven Ewald sums needed at each point  */
+/* (the point itself plus the six finite-difference displacements)    */
+/* for all points in the batch are evaluated in a single call to      */
+/* GBarVDEwald, so the lattice setup is done only once per batch.     */
 /**********************************************************************/
-void PointSource::GetFields_Periodic(const double X[3], cdouble EH[6])
+#define NUMEWALDPTS 7
+void PointSource::GetFields_Periodic(int NX, const double *X, cdouble *EH)
 {
   if (!LBasis)
    { Warn("PointSource::GetFields_Periodic called for non-periodic source");
-     memset(EH,0,6*sizeof(cdouble));
+     memset(EH,0,6*NX*sizeof(cdouble));
      return;
    };
 
+  if (NX<=0) return;
+
   if ( LBasis->NC==2 && UseEwaldFields==false )
-   { Get2DPeriodicFields_Fourier(X, EH);
+   { Get2DPeriodicFields_Fourier(NX, X, EH);
      return;
    };
 
   cdouble k    = sqrt(Eps*Mu) * Omega;
   cdouble k2   = k*k;
 
-  double R[3];
-  R[0]= X[0]-X0[0];
-  R[1]= X[1]-X0[1];
-  R[2]= X[2]-X0[2];
-
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
@@ -218,45 +230,35 @@ void PointSource::GetFields_Periodic(const double X[3], cdouble EH[6])
   /***************************************************************/
   /* get the scalar green's function, its first derivatives, and */
   /* its mixed second partials by Ewald summation.               */
-  /***************************************************************/
-  cdouble GArray[8];
-  scuff::GBarVDEwald(R, k, kBloch, LBV, LDim, -1.0, false, GArray);
-
-  cdouble G = GArray[0];
-
-  cdouble dG[3];
-  dG[0] = GArray[1];
-  dG[1] = GArray[2];
-  dG[2] = GArray[3];
-
-  cdouble ddG[3][3];
-  ddG[0][1] = ddG[1][0] = GArray[4];
-  ddG[0][2] = ddG[2][0] = GArray[5];
-  ddG[1][2] = ddG[2][1] = GArray[6];
-
-  /***************************************************************/
   /* The Ewald routine only computes the mixed second partials,  */
-  /* so we do finite differencing to get unmixed second partials.*/
+  /* so we do finite differencing to get unmixed second partials;*/
+  /* RArray[3*(NUMEWALDPTS*nx + 0) + ...] = R for point #nx, and */
+  /* RArray[3*(NUMEWALDPTS*nx + 1 + 2*i + 0/1) + ...] = R +- Delta */
+  /* in the ith direction.                                       */
   /***************************************************************/
-  for(int i=0; i<3; i++)
+  int NR = NUMEWALDPTS*NX;
+  double *RArray   = (double *)mallocEC(3*NR*sizeof(double));
+  double *DeltaR   = (double *)mallocEC(3*NX*sizeof(double));
+  cdouble *GArray  = (cdouble *)mallocEC(8*NR*sizeof(cdouble));
+  for(int nx=0; nx<NX; nx++)
    { 
-     double DeltaR = (R[i]==0.0 ? 1.0e-4 : 1.0e-4*fabs(R[i]) );
-     double RTweaked[3];
-
-     memcpy(RTweaked, R, 3*sizeof(double));
-     RTweaked[i]+=DeltaR;
-     cdouble GPArray[8];
-     scuff::GBarVDEwald(RTweaked, k, kBloch, LBV, LDim, -1.0, false, GPArray);
-     cdouble GP=GPArray[0];
-
-     memcpy(RTweaked, R, 3*sizeof(double));
-     RTweaked[i]-=DeltaR;
-     cdouble GMArray[8];
-     scuff::GBarVDEwald(RTweaked, k, kBloch, LBV, LDim, -1.0, false, GMArray);
-     cdouble GM=GMArray[0];
-
-     ddG[i][i] = (GP + GM - 2.0*G) / (DeltaR*DeltaR);
+     double R[3];
+     R[0]= X[nx + 0*NX]-X0[0];
+     R[1]= X[nx + 1*NX]-X0[1];
+     R[2]= X[nx + 2*NX]-X0[2];
+
+     double *RR = RArray + 3*NUMEWALDPTS*nx;
+     for(int n=0; n<NUMEWALDPTS; n++)
+      memcpy(RR + 3*n, R, 3*sizeof(double));
+
+     for(int i=0; i<3; i++)
+      { double Delta = (R[i]==0.0 ? 1.0e-4 : 1.0e-4*fabs(R[i]) );
+        DeltaR[3*nx + i] = Delta;
+        RR[3*(1 + 2*i + 0) + i] += Delta;
+        RR[3*(1 + 2*i + 1) + i] -= Delta;
+      };
    };
+  scuff::GBarVDEwald(NR, RArray, k, kBloch, LBV, LDim, -1.0, false, GArray);
 
   /***************************************************************/
   /* now assemble the derivatives of G0 appropriately to form the*/
@@ -267,76 +269,102 @@ void PointSource::GetFields_Periodic(const double X[3], cdouble EH[6])
   /* specify to scuff is the dipole moment in coulombs*microns   */
   /* divided by 377 (the impedance of free space).               */
   /***************************************************************/
+  cdouble PreFac1, PreFac2;
+  cdouble *EE, *HH;
   if ( Type == LIF_ELECTRIC_DIPOLE )
-   { 
-     cdouble PreFac1 = k*k/Eps;
-     cdouble PreFac2 = II*Omega/ZVAC;
-
-     EH[0*3 + 0 ]
-      = PreFac1 * (G*P[0] + (ddG[0][0]*P[0]+ddG[0][1]*P[1]+ddG[0][2]*P[2])/k2 );
-     EH[0*3 + 1 ] 
-      = PreFac1 * (G*P[1] + (ddG[1][0]*P[0]+ddG[1][1]*P[1]+ddG[1][2]*P[2])/k2 );
-     EH[0*3 + 2 ] 
-      = PreFac1 * (G*P[2] + (ddG[2][0]*P[0]+ddG[2][1]*P[1]+ddG[2][2]*P[2])/k2 );
-
-     EH[1*3 + 0] = PreFac2 * (P[1]*dG[2] - P[2]*dG[1]);
-     EH[1*3 + 1] = PreFac2 * (P[2]*dG[0] - P[0]*dG[2]);
-     EH[1*3 + 2] = PreFac2 * (P[0]*dG[1] - P[1]*dG[0]);
+   { PreFac1 = k*k/Eps;
+     PreFac2 = II*Omega/ZVAC;
+     EE      = EH;
+     HH      = EH + 3*NX;
    }
   else
+   { PreFac1 = k*k/Mu;
+     PreFac2 = -II*Omega*ZVAC;
+     EE      = EH + 3*NX;
+     HH      = EH;
+   };
+
+  for(int nx=0; nx<NX; nx++)
    { 
-     cdouble PreFac1 = k*k/Mu;
-     cdouble PreFac2 = II*Omega*ZVAC;
+     cdouble *GBarVD = GArray + 8*NUMEWALDPTS*nx;
 
-     EH[0*3 + 0] = -PreFac2 * (P[1]*dG[2] - P[2]*dG[1]);
-     EH[0*3 + 1] = -PreFac2 * (P[2]*dG[0] - P[0]*dG[2]);
-     EH[0*3 + 2] = -PreFac2 * (P[0]*dG[1] - P[1]*dG[0]);
+     cdouble G = GBarVD[0];
 
-     EH[1*3 + 0 ]
-      = PreFac1 * (G*P[0] + (ddG[0][0]*P[0]+ddG[0][1]*P[1]+ddG[0][2]*P[2])/k2 );
-     EH[1*3 + 1 ] 
-      = PreFac1 * (G*P[1] + (ddG[1][0]*P[0]+ddG[1][1]*P[1]+ddG[1][2]*P[2])/k2 );
-     EH[1*3 + 2 ] 
-      = PreFac1 * (G*P[2] + (ddG[2][0]*P[0]+ddG[2][1]*P[1]+ddG[2][2]*P[2])/k2 );
+     cdouble dG[3];
+     dG[0] = GBarVD[1];
+     dG[1] = GBarVD[2];
+     dG[2] = GBarVD[3];
 
+     cdouble ddG[3][3];
+     ddG[0][1] = ddG[1][0] = GBarVD[4];
+     ddG[0][2] = ddG[2][0] = GBarVD[5];
+     ddG[1][2] = ddG[2][1] = GBarVD[6];
+     for(int i=0; i<3; i++)
+      { cdouble GP = GBarVD[8*(1 + 2*i + 0)];
+        cdouble GM = GBarVD[8*(1 + 2*i + 1)];
+        double Delta = DeltaR[3*nx + i];
+        ddG[i][i] = (GP + GM - 2.0*G) / (Delta*Delta);
+      };
+
+     for(int i=0; i<3; i++)
+      EE[nx + i*NX]
+       = PreFac1 * (G*P[i] + (ddG[i][0]*P[0]+ddG[i][1]*P[1]+ddG[i][2]*P[2])/k2 );
+
+     HH[nx + 0*NX] = PreFac2 * (P[1]*dG[2] - P[2]*dG[1]);
+     HH[nx + 1*NX] = PreFac2 * (P[2]*dG[0] - P[0]*dG[2]);
+     HH[nx + 2*NX] = PreFac2 * (P[0]*dG[1] - P[1]*dG[0]);
    };
 
+  free(GArray);
+  free(DeltaR);
+  free(RArray);
 }
 
 /***************************************************************/
-/***************************************************************/
+/* In the batched version, the lattice sum over reciprocal     */
+/* lattice vectors is carried out once for all points.         */
 /***************************************************************/
 void PointSource::Get2DPeriodicFields_Fourier(const double X[3], cdouble EH[6])
+{ Get2DPeriodicFields_Fourier(1, X, EH); }
+
+void PointSource::Get2DPeriodicFields_Fourier(int NX, const double *X, cdouble *EH)
 {
   cdouble k    = sqrt(Eps*Mu) * Omega;
   cdouble ZRel = sqrt(Mu/Eps);
 
-  double XDest[3], *XSource=X0;
-  XDest[0]=X[0];
-  XDest[1]=X[1];
-  XDest[2]=X[2];
-  cdouble G[3][3], C[3][3];
-  scuff::GetGCBar2D_Fourier(k, kBloch, RLBasis, RLVolume,
-                            XDest, XSource, G, C);
-
-  memset(EH, 0, 6*sizeof(cdouble));
+  HMatrix XDXSMatrix(NX, 6, LHM_REAL);
+  for(int nx=0; nx<NX; nx++)
+   for(int i=0; i<3; i++)
+    { XDXSMatrix.SetEntry(nx, i, X[nx + i*NX]);
+      XDXSMatrix.SetEntry(nx, 3+i, X0[i]);
+    };
+  HMatrix *GCMatrix
+   = scuff::GetGCBar2D_Fourier(k, kBloch, RLBasis, RLVolume, &XDXSMatrix, 0);
+
+  cdouble GPreFac, CPreFac;
+  cdouble *GG, *CC;
   if (Type==LIF_ELECTRIC_DIPOLE)
-   { cdouble EPreFac = k*k/Eps;
-     cdouble HPreFac = -k*k/(Eps*ZVAC*ZRel);
-     for(int i=0; i<3; i++)
-      for(int j=0; j<3; j++)
-       { EH[0*3 + i] += EPreFac*G[i][j]*P[j];
-         EH[1*3 + i] += HPreFac*C[i][j]*P[j];
-       };
+   { GPreFac = k*k/Eps;
+     CPreFac = -k*k/(Eps*ZVAC*ZRel);
+     GG      = EH;
+     CC      = EH + 3*NX;
    }
   else // (Type==LIF_MAGNETIC_DIPOLE)
-   { cdouble EPreFac = +k*k*ZVAC*ZRel/Mu;
-     cdouble HPreFac = k*k/Mu;
-     for(int i=0; i<3; i++)
+   { GPreFac = k*k/Mu;
+     CPreFac = +k*k*ZVAC*ZRel/Mu;
+     GG      = EH + 3*NX;
+     CC      = EH;
+   };
+  for(int nx=0; nx<NX; nx++)
+   for(int i=0; i<3; i++)
+    { cdouble GP=0.0, CP=0.0;
       for(int j=0; j<3; j++)
-       { EH[0*3 + i] += EPreFac*C[i][j]*P[j];
-         EH[1*3 + i] += HPreFac*G[i][j]*P[j];
+       { GP += GCMatrix->GetEntry(nx, 0*9 + 3*i + j)*P[j];
+         CP += GCMatrix->GetEntry(nx, 1*9 + 3*i + j)*P[j];
        };
-   };
+      GG[nx + i*NX] = GPreFac*GP;
+      CC[nx + i*NX] = CPreFac*CP;
+    };
 
+  delete GCMatrix;
 }
@@ -84,6 +84,16 @@ class IncField
    virtual void GetFields(const double X[3], cdouble EH[6]) = 0 ;
    void GetTotalFields(const double X[3], cdouble EH[6]);
 
+   // batched versions of the above: fields at NX points in one call,
+   // in structure-of-arrays layout, i.e. X and EH are stored like
+   // column-major NX x 3 and NX x 6 matrices:
+   //  X[nx + NX*i] = ith coordinate of nx-th point
+   // EH[nx + NX*j] = jth field component at nx-th point
+   // the default implementation loops over the single-point routine;
+   // subclasses override it to hoist per-point setup out of the loop
+   virtual void GetFields(int NX, const double *X, cdouble *EH);
+   void GetTotalFields(int NX, const double *X, cdouble *EH);
+
    // the default implementation of this routine uses finite-differencing;
    // subclasses may override it in cases where they know how to compute
    // field gradients directly
@@ -117,7 +127,9 @@ class PlaneWave : public IncField
    void SetE0(cdouble pE0[3]);
    void SetnHat(double nHat[3]);
 
+   using IncField::GetFields;
    void GetFields(const double X[3], cdouble EH[6]);
+   void GetFields(int NX, const double *X, cdouble *EH);
    void GetFieldGradients(const double X[3], cdouble dEH[3][6]);
 
  };
@@ -146,9 +158,13 @@ class PointSource: public IncField
    void SetP(cdouble P[3]);
    void SetType(int pType);
 
+   using IncField::GetFields;
    void GetFields(const double X[3], cdouble EH[6]);
+   void GetFields(int NX, const double *X, cdouble *EH);
    void GetFields_Periodic(const double X[3], cdouble EH[6]);
+   void GetFields_Periodic(int NX, const double *X, cdouble *EH);
    void Get2DPeriodicFields_Fourier(const double X[3], cdouble EH[6]);
+   void Get2DPeriodicFields_Fourier(int NX, const double *X, cdouble *EH);
 
    bool GetSourcePoint(double X[3]) const;
 
@@ -176,7 +192,9 @@ class GaussianBeam: public IncField
    void SetE0(cdouble pE0[3]);
    void SetW0(double pW0);
 
+   using IncField::GetFields;
    void GetFields(const double X[3], cdouble EH[6]);
+   void GetFields(int NX, const double *X, cdouble *EH);
 
    double TotalBeamFlux();
 
@@ -202,6 +220,7 @@ class SphericalWave : public IncField
    void SetP(int NewP);
    void SetType(int NewP); // DELETEME legacy routine for backward compat
 
+   using IncField::GetFields;
    void GetFields(const double X[3], cdouble EH[6]);
 
  };
@@ -223,6 +223,20 @@ Interp2D::Interp2D(double *pX1Points, int pN1,
 
 }
 
+/****************************************************************/
+/* construct the class from a user-supplied table of function   */
+/* values and derivatives on a nonuniform grid; the table has   */
+/* the layout described in InitInterp2D below.                  */
+/****************************************************************/
+Interp2D::Interp2D(double *PhiVDTable,
+                   double *pX1Points, int pN1,
+                   double *pX2Points, int pN2,
+                   int pnFun, int pLogLevel)
+ : Interp2D(pX1Points, pN1, pX2Points, pN2, pnFun, 0, 0, pLogLevel)
+{
+   InitInterp2D(0, 0, PhiVDTable);
+}
+
 /****************************************************************/
 /* class constructor 2: construct the class from user-supplied  */
 /* uniform grids                                                */
@@ -278,7 +292,7 @@ Interp2D::Interp2D(double pX1Min, double X1Max, int pN1,
 /****************************************************************/
 /* main body of class constructor for the above two entry points*/
 /****************************************************************/
-void Interp2D::InitInterp2D(Phi2D PhiFunc, void *UserData)
+void Interp2D::InitInterp2D(Phi2D PhiFunc, void *UserData, double *PhiVDTable)
 {
    if (LogLevel>=LMDI_LOGLEVEL_TERSE)
     Log("Creating interpolation grid with %i grid points...",N1*N2);
@@ -298,73 +312,81 @@ void Interp2D::InitInterp2D(Phi2D PhiFunc, void *UserData)
    /*-                                                             */
    /*- is a pointer to an array of NDATA doubles which are the     */
    /*- value and derivatives of function #nf at grid point (n1,n2).*/
+   /*-                                                             */
+   /*- if the caller supplied the table, we skip straight to the   */
+   /*- computation of the interpolation coefficients.              */
    /*--------------------------------------------------------------*/
-   double *PhiVDTable=(double *)mallocEC(N1*N2*nFun*NDATA*sizeof(double));
-   if (!PhiVDTable)
-    ErrExit("%s:%i:out of memory",__FILE__,__LINE__);
+   bool OwnsPhiVDTable = false;
+   if (PhiVDTable==0)
+    { OwnsPhiVDTable=true;
+      PhiVDTable=(double *)mallocEC(N1*N2*nFun*NDATA*sizeof(double));
+      if (!PhiVDTable)
+       ErrExit("%s:%i:out of memory",__FILE__,__LINE__);
 
-   /*--------------------------------------------------------------*/
-   /*- fire off threads that will call the user's function to     -*/
-   /*- populate the PVDTable table.                               -*/
-   /*--------------------------------------------------------------*/
-   if (LogLevel>=LMDI_LOGLEVEL_VERBOSE)
-    Log("Computing user function at grid points...");
-   int nThread=GetNumThreads();
+      /*--------------------------------------------------------------*/
+      /*- fire off threads that will call the user's function to     -*/
+      /*- populate the PVDTable table.                               -*/
+      /*--------------------------------------------------------------*/
+      if (LogLevel>=LMDI_LOGLEVEL_VERBOSE)
+       Log("Computing user function at grid points...");
+      int nThread=GetNumThreads();
 
 #ifdef USE_PTHREAD
-   ThreadData *TDs = new ThreadData[nThread], *TD;
-   pthread_t *Threads = new pthread_t[nThread];
+      ThreadData *TDs = new ThreadData[nThread], *TD;
+      pthread_t *Threads = new pthread_t[nThread];
 #endif
-   ThreadData TD1;
-   int nt;
-
-   TD1.X1Points=X1Points;
-   TD1.X2Points=X2Points;
-   TD1.N1=N1;
-   TD1.N2=N2;
-   TD1.X1Min=X1Min;
-   TD1.X2Min=X2Min;
-   TD1.DX1=DX1;
-   TD1.DX2=DX2;
-   TD1.nFun=nFun;
-   TD1.PhiFunc=PhiFunc;
-   TD1.UserData=UserData;
-   TD1.PhiVDTable=PhiVDTable;
-   TD1.nThread=nThread;
-   TD1.LogLevel=LogLevel;
+      ThreadData TD1;
+      int nt;
+
+      TD1.X1Points=X1Points;
+      TD1.X2Points=X2Points;
+      TD1.N1=N1;
+      TD1.N2=N2;
+      TD1.X1Min=X1Min;
+      TD1.X2Min=X2Min;
+      TD1.DX1=DX1;
+      TD1.DX2=DX2;
+      TD1.nFun=nFun;
+      TD1.PhiFunc=PhiFunc;
+      TD1.UserData=UserData;
+      TD1.PhiVDTable=PhiVDTable;
+      TD1.nThread=nThread;
+      TD1.LogLevel=LogLevel;
 #ifdef USE_OPENMP
 #pragma omp parallel for firstprivate(TD1), schedule(static,1), num_threads(nThread)
 #endif
-   for(nt=0; nt<nThread; nt++)
-    {
+      for(nt=0; nt<nThread; nt++)
+       {
 #ifdef USE_PTHREAD
-      TD=&(TDs[nt]);
-      *TD = TD1;
+         TD=&(TDs[nt]);
+         *TD = TD1;
 #else
-      ThreadData *TD=&TD1;
+         ThreadData *TD=&TD1;
 #endif
-      TD->nt=nt;
+         TD->nt=nt;
 #ifdef USE_PTHREAD
-      if (nt+1 == nThread)
-	GetPhiVD_Thread((void *)TD);
-      else
-	pthread_create( &(Threads[nt]), 0, GetPhiVD_Thread, (void *)TD);
+         if (nt+1 == nThread)
+          GetPhiVD_Thread((void *)TD);
+         else
+          pthread_create( &(Threads[nt]), 0, GetPhiVD_Thread, (void *)TD);
 #else
-      GetPhiVD_Thread((void *)TD);
+         GetPhiVD_Thread((void *)TD);
 #endif
-    };
+       };
 
 #ifdef USE_PTHREAD
-   /*--------------------------------------------------------------*/
-   /*- wait for threads to terminate ------------------------------*/
-   /*--------------------------------------------------------------*/ 
-   for(nt=0; nt<nThread-1; nt++)
-    pthread_join(Threads[nt],0);
+      /*--------------------------------------------------------------*/
+      /*- wait for threads to terminate ------------------------------*/
+      /*--------------------------------------------------------------*/ 
+      for(nt=0; nt<nThread-1; nt++)
+       pthread_join(Threads[nt],0);
 
-   delete[] Threads;
-   delete[] TDs;
+      delete[] Threads;
+      delete[] TDs;
 #endif
 
+    }; // if (PhiVDTable==0)
+
    /*--------------------------------------------------------------*/
    /*- construct the matrix whose inverse maps a vector of        -*/
    /*- phi values and derivatives into polynomial coefficients.   -*/
@@ -460,7 +482,8 @@ void Interp2D::InitInterp2D(Phi2D PhiFunc, void *UserData)
    /*--------------------------------------------------------------*/
    delete C;
    delete M;
-   free(PhiVDTable);
+   if (OwnsPhiVDTable)
+    free(PhiVDTable);
    if (LogLevel>=LMDI_LOGLEVEL_VERBOSE)
     Log("...interpolation table constructed!");
 
@@ -469,9 +492,9 @@ void Interp2D::InitInterp2D(Phi2D PhiFunc, void *UserData)
 /****************************************************************/
 /****************************************************************/
 /****************************************************************/
-void Interp2D::ReInitialize(Phi2D PhiFunc, void *UserData)
+void Interp2D::ReInitialize(Phi2D PhiFunc, void *UserData, double *PhiVDTable)
 { 
-  InitInterp2D(PhiFunc, UserData);
+  InitInterp2D(PhiFunc, UserData, PhiVDTable);
 }
 
 /****************************************************************/
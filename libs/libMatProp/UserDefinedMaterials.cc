@@ -356,6 +356,7 @@ char *AddMaterialToMatPropDataBase(FILE *f, char *FileName,
 
   if (MP->ErrMsg)
    return MP->ErrMsg;
+  MP->CompileExpressions();
 
   AddMPToMatPropDataBase(MP);
 
@@ -365,28 +366,49 @@ char *AddMaterialToMatPropDataBase(FILE *f, char *FileName,
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
-void MatProp::GetEpsMu_Parsed(cdouble Omega, cdouble *pEps, cdouble *pMu)
+void MatProp::GetEpsMu_Parsed(int NumFreqs, const cdouble *Omegas,
+                              cdouble *pEps, cdouble *pMu)
 {
   static char *OmegaVar=const_cast<char *>("w");
-  Omega *= FreqUnit;
 
   // Note that this is thread-safe since "w" is an indexed variable,
   // which means that the internal symbol table is not modified, but
   // we MUST pass its value as the 0th array entry in cevaluator_evaluate.
+  // The compiled programs, if present, take "w" as their only input.
 
-  if (pEps) {
-    if (EpsExpression) {
-      *pEps = cevaluator_evaluate(EpsExpression, 1,&OmegaVar,&Omega);
-    }
-    else
-      *pEps = 1.0;
-  }
-
-  if (pMu) {
-    if (MuExpression) {
-      *pMu = cevaluator_evaluate(MuExpression, 1,&OmegaVar,&Omega);
-    }
-    else
-      *pMu = 1.0;
-  }
+#define PARSED_CHUNK 64
+  cdouble w[PARSED_CHUNK];
+  for(int nf0=0; nf0<NumFreqs; nf0+=PARSED_CHUNK)
+   { 
+     int NF = (NumFreqs-nf0 < PARSED_CHUNK) ? NumFreqs-nf0 : PARSED_CHUNK;
+     for(int nf=0; nf<NF; nf++)
+      w[nf] = Omegas[nf0+nf] * FreqUnit;
+
+     if (pEps)
+      { if (EpsProgram)
+         cevaluator_evaluate_compiled(EpsProgram, NF, w, pEps+nf0);
+        else 
+         for(int nf=0; nf<NF; nf++)
+          pEps[nf0+nf] = EpsExpression ? cevaluator_evaluate(EpsExpression, 1, &OmegaVar, w+nf) : 1.0;
+      };
+
+     if (pMu)
+      { if (MuProgram)
+         cevaluator_evaluate_compiled(MuProgram, NF, w, pMu+nf0);
+        else 
+         for(int nf=0; nf<NF; nf++)
+          pMu[nf0+nf] = MuExpression ? cevaluator_evaluate(MuExpression, 1, &OmegaVar, w+nf) : 1.0;
+      };
+   };
+}
+
+/***************************************************************/
+/* compile the Eps(w) and Mu(w) expressions into register      */
+/* programs for fast and batched evaluation                    */
+/***************************************************************/
+void MatProp::CompileExpressions()
+{
+  static char *OmegaVar=const_cast<char *>("w");
+  EpsProgram = EpsExpression ? cevaluator_compile(EpsExpression, 1, &OmegaVar) : 0;
+  MuProgram  = MuExpression  ? cevaluator_compile(MuExpression,  1, &OmegaVar) : 0;
 }
@@ -113,6 +113,27 @@ extern          "C" {
 	extern void    *cevaluator_derivative_z(void *cevaluator);
 
 
+        /* Compile cevaluator into a register program for repeated
+	 * evaluation.  Constant subexpressions are folded and common
+	 * subexpressions are computed only once.  The variables named in
+	 * the names array become the inputs of the program, in the given
+	 * order; other variables keep taking their values from the
+	 * cevaluator's symbol table, so the cevaluator must not be
+	 * destroyed before the program.  Returns null pointer on error. */
+        extern void    *cevaluator_compile(void *cevaluator, int count,
+					  char **names);
+
+        /* Evaluate compiled program for n points at once.  The values of
+	 * the count input variables for point i are inputs[i*count],
+	 * ..., inputs[i*count+count-1], and the result is stored in
+	 * outputs[i].  Thread-safe. */
+        extern void     cevaluator_evaluate_compiled(void *program, int n,
+						    const cevaluator_complex *inputs,
+						    cevaluator_complex *outputs);
+
+        /* Destroy compiled program. */
+        extern void     cevaluator_destroy_compiled(void *program);
+
         /* Determine whether an expression can be guaranteed to be real for
 	   ALL values of the variables.  The only assumption is that
 	   variables currently set to real values are assumed to ALWAYS
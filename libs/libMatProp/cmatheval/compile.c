@@ -0,0 +1,367 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * compile.c -- translation of an expression tree into a flat register
+ *           -- program that may be evaluated for many sets of variable
+ *           -- values at once
+ *
+ * Every instruction of the program writes one register, and the
+ * register index is the instruction index, so the program is just an
+ * array of instructions in evaluation order. While emitting, we
+ *
+ *  (a) fold any operation whose operands are all constants (including
+ *      symbolic constants like pi) into a single constant register,
+ *  (b) reuse the register of any previously-emitted instruction with
+ *      the same operation and operands (common-subexpression
+ *      elimination; commutative operands are put in canonical order),
+ *  (c) replace powers with small integer exponents by multiplications.
+ *
+ * Evaluation then proceeds in blocks of up to PROGRAM_BLOCK points:
+ * each instruction is applied to all points of the block before the
+ * next instruction is considered, so the inner loops are simple
+ * elementwise operations on contiguous arrays.
+ */
+
+#include "common.h"
+#include "node.h"
+#include "compile.h"
+
+/* number of points processed together by program_evaluate */
+#define PROGRAM_BLOCK 32
+
+/* registers that fit in the stack buffer of program_evaluate */
+#define STACK_REGISTERS 1024
+
+/* largest integer exponent expanded into multiplications */
+#define MAX_EXPANDED_POWER 16
+
+/* Instruction (and register) types: 'n' constant, 'i' input variable,
+ * 's' variable read from the symbol table, '_' negation, 'f' function
+ * call, 'p' integer power, and '+', '-', '*', '/', '^' for binary
+ * operations. */
+typedef struct {
+	char            op;
+	int             a, b;	/* Operand registers, or exponent for 'p',
+				 * or input index for 'i'. */
+	cmplx           value;	/* Value for 'n'. */
+	cmplx           (*function) (cmplx);	/* Function for 'f'. */
+	Record         *record;	/* Symbol-table record for 's'. */
+} Instruction;
+
+struct _Program {
+	Instruction    *code;
+	int             length, capacity;
+	int             count;	/* Number of input variables per point. */
+	int             result;	/* Register holding the result. */
+};
+
+static cmplx
+integer_power(cmplx x, int k)
+{
+	cmplx           result = 1.0;
+	int             m = k < 0 ? -k : k;
+
+	while (m) {
+		if (m & 1)
+			result *= x;
+		x *= x;
+		m >>= 1;
+	}
+	return k < 0 ? 1.0 / result : result;
+}
+
+static void
+clear_instruction(Instruction * Ins)
+{
+	Ins->op = 0;
+	Ins->a = Ins->b = 0;
+	Ins->value = 0.0;
+	Ins->function = NULL;
+	Ins->record = NULL;
+}
+
+/* Append instruction Ins to the program, unless an identical
+ * instruction already exists; return its register. */
+static int
+emit(Program * program, Instruction * Ins)
+{
+	int             r;
+
+	for (r = 0; r < program->length; r++) {
+		Instruction    *J = program->code + r;
+		if (J->op != Ins->op || J->a != Ins->a || J->b != Ins->b)
+			continue;
+		if (Ins->op == 'n' && J->value != Ins->value)
+			continue;
+		if (Ins->op == 'f' && J->function != Ins->function)
+			continue;
+		if (Ins->op == 's' && J->record != Ins->record)
+			continue;
+		return r;
+	}
+
+	if (program->length == program->capacity) {
+		program->capacity = 2 * program->capacity + 8;
+		program->code =
+		    XREALLOC(Instruction, program->code, program->capacity);
+	}
+	program->code[program->length] = *Ins;
+	return program->length++;
+}
+
+static int
+emit_constant(Program * program, cmplx value)
+{
+	Instruction     Ins;
+	clear_instruction(&Ins);
+	Ins.op = 'n';
+	Ins.value = value;
+	return emit(program, &Ins);
+}
+
+/* Emit an operation, folding it into a constant if all operands
+ * are constants. */
+static int
+emit_operation(Program * program, char op, int a, int b,
+	       cmplx(*function) (cmplx))
+{
+	Instruction     Ins;
+	Instruction    *code = program->code;
+	int             unary = (op == '_' || op == 'f' || op == 'p');
+
+	if (code[a].op == 'n' && (unary || code[b].op == 'n')) {
+		cmplx           x = code[a].value, y = unary ? x : code[b].value;
+		switch (op) {
+		case '_': return emit_constant(program, -x);
+		case 'f': return emit_constant(program, function(x));
+		case 'p': return emit_constant(program, integer_power(x, b));
+		case '+': return emit_constant(program, x + y);
+		case '-': return emit_constant(program, x - y);
+		case '*': return emit_constant(program, x * y);
+		case '/': return emit_constant(program, x / y);
+		case '^': return emit_constant(program, cpow(x, y));
+		}
+	}
+
+	/* x^k with small integer k is computed by repeated
+	 * multiplication */
+	if (op == '^' && code[b].op == 'n') {
+		cmplx           k = code[b].value;
+		if (cimag(k) == 0.0 && creal(k) == floor(creal(k))
+		    && fabs(creal(k)) <= MAX_EXPANDED_POWER)
+			return emit_operation(program, 'p', a,
+					      (int) creal(k), 0);
+	}
+
+	/* canonical operand order for commutative operations */
+	if ((op == '+' || op == '*') && a > b) {
+		int             t = a;
+		a = b;
+		b = t;
+	}
+
+	clear_instruction(&Ins);
+	Ins.op = op;
+	Ins.a = a;
+	Ins.b = unary && op != 'p' ? 0 : b;
+	Ins.function = function;
+	return emit(program, &Ins);
+}
+
+static int
+compile_node(Program * program, Node * node, int count, char **names)
+{
+	Instruction     Ins;
+	int             a, b, n;
+
+	switch (node->type) {
+	case 'n':
+		return emit_constant(program, node->Number);
+
+	case 'c':
+		return emit_constant(program, node->data.constant->data.value);
+
+	case 'v':
+		/* variables named in the names array are inputs; a
+		 * thread-safe variable not named there is read from its
+		 * fixed index in the input array, as it would be by
+		 * cevaluator_evaluate; any other variable is read from
+		 * the symbol table at evaluation time */
+		clear_instruction(&Ins);
+		for (n = 0; n < count; n++)
+			if (!strcmp(names[n], node->data.variable->name))
+				break;
+		if (n == count && node->data.variable->type == 'V'
+		    && node->data.variable->data.index < count)
+			n = (int) node->data.variable->data.index;
+		if (n < count) {
+			Ins.op = 'i';
+			Ins.a = n;
+		} else {
+			Ins.op = 's';
+			Ins.record = node->data.variable;
+		}
+		return emit(program, &Ins);
+
+	case 'f':
+		a = compile_node(program, node->data.function.child, count,
+				 names);
+		return emit_operation(program, 'f', a, 0,
+				      node->data.function.record->data.
+				      function);
+
+	case 'u':
+		a = compile_node(program, node->data.un_op.child, count,
+				 names);
+		return emit_operation(program, '_', a, 0, 0);
+
+	case 'b':
+		a = compile_node(program, node->data.bin_op.left, count,
+				 names);
+		b = compile_node(program, node->data.bin_op.right, count,
+				 names);
+		return emit_operation(program, node->data.bin_op.operation,
+				      a, b, 0);
+	}
+
+	return emit_constant(program, 0.0);
+}
+
+Program        *
+program_compile(Node * root, int count, char **names)
+{
+	Program        *program = XMALLOC(Program, 1);
+
+	program->code = NULL;
+	program->length = program->capacity = 0;
+	program->count = count;
+
+	program->result = compile_node(program, root, count, names);
+
+	return program;
+}
+
+void
+program_destroy(Program * program)
+{
+	if (!program)
+		return;
+	XFREE(program->code);
+	XFREE(program);
+}
+
+int
+program_get_length(Program * program)
+{
+	return program->length;
+}
+
+void
+program_evaluate(Program * program, int n, const cmplx * inputs,
+		 cmplx * outputs)
+{
+	double          stack_buffer[2 * STACK_REGISTERS];
+	cmplx          *registers;
+	int             L = program->length, count = program->count;
+	int             B = n < PROGRAM_BLOCK ? n : PROGRAM_BLOCK;
+	int             n0, r, j;
+
+	if (n <= 0)
+		return;
+
+	/* std::complex and C99 complex are both laid out as two doubles */
+	if (L * B <= STACK_REGISTERS)
+		registers = (cmplx *) stack_buffer;
+	else
+		registers = XMALLOC(cmplx, L * B);
+
+	/* constant registers are filled once */
+	for (r = 0; r < L; r++)
+		if (program->code[r].op == 'n')
+			for (j = 0; j < B; j++)
+				registers[r * B + j] = program->code[r].value;
+
+	for (n0 = 0; n0 < n; n0 += B) {
+		int             NB = (n - n0 < B) ? n - n0 : B;
+		const cmplx    *in = inputs + n0 * count;
+
+		for (r = 0; r < L; r++) {
+			Instruction    *Ins = program->code + r;
+			int             binary = strchr("+-*/^", Ins->op) != NULL;
+			cmplx          *R = registers + r * B;
+			cmplx          *A = registers + (Ins->op == 'i' ? 0 : Ins->a) * B;
+			cmplx          *Y = registers + (binary ? Ins->b : 0) * B;
+			switch (Ins->op) {
+			case 'n':
+				break;
+			case 'i':
+				for (j = 0; j < NB; j++)
+					R[j] = in[j * count + Ins->a];
+				break;
+			case 's':
+				for (j = 0; j < NB; j++)
+					R[j] = Ins->record->data.value;
+				break;
+			case '_':
+				for (j = 0; j < NB; j++)
+					R[j] = -A[j];
+				break;
+			case 'f':
+				for (j = 0; j < NB; j++)
+					R[j] = Ins->function(A[j]);
+				break;
+			case 'p':
+				if (Ins->b == 2)
+					for (j = 0; j < NB; j++)
+						R[j] = A[j] * A[j];
+				else
+					for (j = 0; j < NB; j++)
+						R[j] = integer_power(A[j], Ins->b);
+				break;
+			case '+':
+				for (j = 0; j < NB; j++)
+					R[j] = A[j] + Y[j];
+				break;
+			case '-':
+				for (j = 0; j < NB; j++)
+					R[j] = A[j] - Y[j];
+				break;
+			case '*':
+				for (j = 0; j < NB; j++)
+					R[j] = A[j] * Y[j];
+				break;
+			case '/':
+				for (j = 0; j < NB; j++)
+					R[j] = A[j] / Y[j];
+				break;
+			case '^':
+				for (j = 0; j < NB; j++)
+					R[j] = cpow(A[j], Y[j]);
+				break;
+			}
+		}
+
+		for (j = 0; j < NB; j++)
+			outputs[n0 + j] = registers[program->result * B + j];
+	}
+
+	if (registers != (cmplx *) stack_buffer)
+		XFREE(registers);
+}
@@ -0,0 +1,47 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPILE_H
+#define COMPILE_H 1
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "node.h"
+
+/* Register program compiled from an expression tree.  */
+typedef struct _Program Program;
+
+/* Compile tree rooted at given node.  Variables with names in the
+ * names array become inputs to the program, in the given order.  */
+Program        *program_compile(Node * root, int count, char **names);
+
+/* Destroy program.  */
+void            program_destroy(Program * program);
+
+/* Return number of instructions (registers) in program.  */
+int             program_get_length(Program * program);
+
+/* Evaluate program for n sets of input values; the inputs for point
+ * i are inputs[i*count ... i*count+count-1].  */
+void            program_evaluate(Program * program, int n,
+				 const cmplx * inputs, cmplx * outputs);
+
+#endif
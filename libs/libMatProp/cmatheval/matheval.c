@@ -29,6 +29,7 @@
 #include "cmatheval.h"
 #include "node.h"
 #include "symbol_table.h"
+#include "compile.h"
 
 /* Minimal length of cevaluator symbol table.  */
 #define MIN_TABLE_LENGTH 211
@@ -345,3 +346,25 @@ cevaluator_derivative_z(void *cevaluator)
 	/* Differentiate function using derivation variable "z". */
 	return cevaluator_derivative(cevaluator, "z");
 }
+
+void           *
+cevaluator_compile(void *cevaluator, int count, char **names)
+{
+	if (!cevaluator)
+		return NULL;
+	return program_compile(((Evaluator *) cevaluator)->root, count,
+			       names);
+}
+
+void
+cevaluator_evaluate_compiled(void *program, int n, const cmplx * inputs,
+			     cmplx * outputs)
+{
+	program_evaluate((Program *) program, n, inputs, outputs);
+}
+
+void
+cevaluator_destroy_compiled(void *program)
+{
+	program_destroy((Program *) program);
+}
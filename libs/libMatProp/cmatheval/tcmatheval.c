@@ -49,6 +49,18 @@ int main(int argc, char **argv)
 	       printf("expression value = %g\n", creal(val));
 	  else
 	       printf("expression value = %g%+gi\n", creal(val), cimag(val));
+	  {
+	       /* check that the compiled program agrees */
+	       void *prog = cevaluator_compile(eval, count, names);
+	       cevaluator_complex cval;
+	       double d;
+	       cevaluator_evaluate_compiled(prog, 1, vals, &cval);
+	       d = fabs(creal(cval - val)) + fabs(cimag(cval - val));
+	       if (d > 1.0e-12 * (1.0 + fabs(creal(val)) + fabs(cimag(val))))
+		    printf("compiled value = %g%+gi (MISMATCH)\n",
+			   creal(cval), cimag(cval));
+	       cevaluator_destroy_compiled(prog);
+	  }
 #if TEST_VAR_INDEX
 	  free(vals);
 #endif
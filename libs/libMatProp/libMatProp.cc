@@ -83,12 +83,14 @@ MatProp::MatProp()
  { Type=MP_PEC; 
    Zeroed=0;
    Name=strdupEC("PEC");
+   EpsProgram=MuProgram=0;
  }
 
 MatProp::MatProp(int pType)
  { Type=pType;
    Zeroed=0;
    Name=strdupEC("VACUUM");
+   EpsProgram=MuProgram=0;
  }
  
 MatProp::MatProp(const char *MaterialName)
@@ -148,6 +150,7 @@ MatProp::MatProp(MatProp *MP)
       
     };
    OwnsExpressions= true;
+   CompileExpressions();
 
  }
 
@@ -165,6 +168,7 @@ void MatProp::InitMatProp(const char *MaterialName, const char *MatPropFileName)
   Mu=1.0;
   Zeroed=0;
   EpsExpression = MuExpression = NULL;
+  EpsProgram = MuProgram = NULL;
   InterpReal = InterpImag = NULL;
   OwnsExpressions = OwnsInterpolators = false;
 
@@ -292,6 +296,7 @@ void MatProp::InitMatProp(const char *MaterialName, const char *MatPropFileName)
 	   cevaluator_set_var_index(MuExpression, "w", 0);
          };
 	OwnsExpressions=true;
+        CompileExpressions();
       };
      
      return;
@@ -351,6 +356,7 @@ void MatProp::InitMatProp(const char *MaterialName, const char *MatPropFileName)
        OwnsExpressions = true;
        AddMPToMatPropDataBase(this);
      };
+    CompileExpressions();
 }
 
 /***************************************************************/
@@ -464,6 +470,9 @@ MatProp::~MatProp()
       if (MuExpression) cevaluator_destroy(MuExpression);
    };
 
+  if (EpsProgram) cevaluator_destroy_compiled(EpsProgram);
+  if (MuProgram) cevaluator_destroy_compiled(MuProgram);
+
 }  
 
 /***************************************************************/
@@ -545,13 +554,26 @@ void MatProp::GetEpsMu(cdouble Omega, cdouble *pEps, cdouble *pMu)
    }
   else if ( Type==MP_PARSED ) 
    { 
-       GetEpsMu_Parsed(Omega, &EpsRV, &MuRV);
+       GetEpsMu_Parsed(1, &Omega, &EpsRV, &MuRV);
    }; // if (Type==... )
 
   if (pEps) *pEps=EpsRV;
   if (pMu) *pMu=MuRV;
 }
 
+/***************************************************************/
+/* get eps and mu at NumFreqs frequencies. Eps and Mu, if      */
+/* non-NULL, must have room for NumFreqs values.               */
+/***************************************************************/
+void MatProp::GetEpsMu(int NumFreqs, const cdouble *Omegas, cdouble *pEps, cdouble *pMu)
+{ 
+  if ( Type==MP_PARSED && !Zeroed )
+   GetEpsMu_Parsed(NumFreqs, Omegas, pEps, pMu);
+  else
+   for(int nf=0; nf<NumFreqs; nf++)
+    GetEpsMu(Omegas[nf], pEps ? pEps+nf : 0, pMu ? pMu+nf : 0);
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
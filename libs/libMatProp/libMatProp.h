@@ -73,6 +73,9 @@ class MatProp
 
    /* get epsilon and mu at a given frequency */
    void GetEpsMu(cdouble Omega, cdouble *Eps, cdouble *Mu);
+
+   /* get epsilon and mu at NumFreqs frequencies at once */
+   void GetEpsMu(int NumFreqs, const cdouble *Omegas, cdouble *Eps, cdouble *Mu);
    cdouble GetEps(cdouble Omega);
    cdouble GetMu(cdouble Omega);
 
@@ -108,7 +111,9 @@ class MatProp
    void CreateUserDefinedMaterial(const char *MatPropFileName, const char *MaterialName);
    int ReadMaterialFromFile(const char *FileName, const char *MaterialName);
    int ParseMaterialSectionInFile(FILE *f, const char *FileName, int *LineNum);
-   void GetEpsMu_Parsed(cdouble Omega, cdouble *pEps, cdouble *pMu);
+   void GetEpsMu_Parsed(int NumFreqs, const cdouble *Omegas,
+                        cdouble *pEps, cdouble *pMu);
+   void CompileExpressions();
 
    /***************************************************************/
    /* class data **************************************************/
@@ -129,6 +134,9 @@ class MatProp
    void *EpsExpression, *MuExpression;
    bool OwnsExpressions;
 
+   // compiled versions of the above, always owned by this MatProp
+   void *EpsProgram, *MuProgram;
+
    // angular frequency unit (common to all instances of MatProp)
    static double FreqUnit;
 
@@ -148,7 +148,7 @@ void GetVSWRadialFunctions(int LMax, cdouble k, double r,
                            bool Conjugate)
 {
   if (r==0.0)
-   { memset(RFArray, 0, 3*(LMax+1));
+   { memset(RFArray, 0, 3*(LMax+1)*sizeof(cdouble));
      if (TimesrFactor) return;
      RFArray[3*1+1] = 2.0/3.0;
      RFArray[3*1+2] = -M_SQRT2/3.0; //-1.41421356237309504880/3.0;
@@ -246,7 +246,8 @@ HMatrix *GetWaveMatrix(double r, double Theta, double Phi,
   cdouble *RFArray       = dYdThetaArray + NAlpha;
   cdouble *dWorkspace    = RFArray       + 3*(LMax+1);
 
-  GetVSWRadialFunctions(LMax, k, r, WaveType, RFArray, (double *)dWorkspace, RConjugate);
+  GetVSWRadialFunctions(LMax, k, r, WaveType, RFArray, (double *)dWorkspace,
+                        false, RConjugate);
 
   /***************************************************************/
   /* fetch angular functions                                     */
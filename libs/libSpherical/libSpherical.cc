@@ -252,7 +252,7 @@ void GetPlm(int lMax, int m, double x, double *Plm, double *PlmPrime)
   for(int np=2, l=m+2; l<=lMax; l++, np++)
    { Factor=sqrt( (4.0*l*l-1.0) / (l*l-m*m) );
      Plm[np]=Factor*(x*Plm[np-1] - Plm[np-2]/OldFactor);
-     Alm=sqrt( (2*l+1)*(l*l-m*m) / (2*l-1) );
+     Alm=sqrt( (2.0*l+1.0)*(l*l-m*m) / (2.0*l-1.0) );
      PlmPrime[np] = (Alm*Plm[np-1] - l*x*Plm[np])/omx2;
      OldFactor=Factor;
    };
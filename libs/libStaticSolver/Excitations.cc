@@ -66,6 +66,34 @@ void SetVars(double x[3], cdouble VariableValues[NUMVARS])
   VariableValues[6] = Phi;
 }
 
+/***************************************************************/
+/* evaluate the expression (or its compiled version Program, if */
+/* non-NULL) at NumPoints points, with the values of the        */
+/* variables for point n in Values[n*NUMVARS...]                */
+/***************************************************************/
+static void EvaluateUserExpression(void *Evaluator, void *Program,
+                                   int NumPoints, cdouble *Values,
+                                   cdouble *Results)
+{
+  if (Program)
+   cevaluator_evaluate_compiled(Program, NumPoints, Values, Results);
+  else
+   for(int np=0; np<NumPoints; np++)
+    Results[np]=cevaluator_evaluate(Evaluator, NUMVARS,
+                                    const_cast<char **>(VariableNames),
+                                    Values + np*NUMVARS);
+}
+
+UserSFData *CreateUserSFData(const char *PhiString)
+{
+  UserSFData *Data = (UserSFData *)mallocEC(sizeof *Data);
+  Data->PhiEvaluator=cevaluator_create(const_cast<char *>(PhiString));
+  if (Data->PhiEvaluator)
+   Data->PhiProgram=cevaluator_compile(Data->PhiEvaluator, NUMVARS,
+                                       const_cast<char **>(VariableNames));
+  return Data;
+}
+
 void UserStaticField(double *x, void *UserData, double PhiE[4])
 {
   UserSFData *Data = (UserSFData *)UserData;
@@ -74,51 +102,37 @@ void UserStaticField(double *x, void *UserData, double PhiE[4])
   if ( Data==0 || Data->PhiEvaluator==0 ) return;
 
   /*--------------------------------------------------------------*/
+  /*- evaluate Phi at x and, for each component of E, at          */
+  /*- x+Delta and x-Delta for a centered finite difference, all   */
+  /*- in a single batch                                           */
   /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  cdouble VariableValues[NUMVARS];
+  cdouble VariableValues[7*NUMVARS], Phi[7];
+  double Delta[3];
   SetVars(x, VariableValues);
-  PhiE[0] = real( cevaluator_evaluate(Data->PhiEvaluator, NUMVARS,
-                                      const_cast<char **>(VariableNames), 
-                                      VariableValues) );
+  for(int Mu=0; Mu<3; Mu++)
+   { 
+     Delta[Mu] = 1.0e-4*fabs(x[Mu]);
+     if (Delta[Mu]==0.0) Delta[Mu]=1.0e-4;
+     double xp[3];
+     xp[0]=x[0];
+     xp[1]=x[1];
+     xp[2]=x[2];
+     xp[Mu] = x[Mu] + Delta[Mu];
+     SetVars(xp, VariableValues + (1+2*Mu)*NUMVARS);
+     xp[Mu] = x[Mu] - Delta[Mu];
+     SetVars(xp, VariableValues + (2+2*Mu)*NUMVARS);
+   };
+  EvaluateUserExpression(Data->PhiEvaluator, Data->PhiProgram,
+                         7, VariableValues, Phi);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
+  PhiE[0] = real(Phi[0]);
   for(int Mu=0; Mu<3; Mu++)
-   { 
-     if (Data->EEvaluator[Mu])
-      { 
-        SetVars(x, VariableValues);
-        PhiE[1+Mu] = real( cevaluator_evaluate(Data->EEvaluator[Mu], NUMVARS, 
-                                               const_cast<char **>(VariableNames), 
-                                               VariableValues) 
-                         );
-      }
-     else
-      { 
-        double xp[3];
-        xp[0]=x[0];
-        xp[1]=x[1];
-        xp[2]=x[2];
-
-        double Delta = 1.0e-4*fabs(x[Mu]);
-        if (Delta==0.0) Delta=1.0e-4;
-        xp[Mu] += Delta;
-        SetVars(xp, VariableValues);
-        double PhiPlus = real( cevaluator_evaluate(Data->PhiEvaluator, NUMVARS,
-                                                   const_cast<char **>(VariableNames), 
-                                                   VariableValues) 
-                             );
-
-        xp[Mu] += Delta;
-        SetVars(xp, VariableValues);
-        double PhiMinus= real( cevaluator_evaluate(Data->PhiEvaluator, NUMVARS,
-                                                   const_cast<char **>(VariableNames), 
-                                                   VariableValues) 
-                             );
-        PhiE[1+Mu] = (PhiMinus - PhiPlus) / (2.0*Delta);
-      };
+   { double PhiPlus  = real(Phi[1+2*Mu]);
+     double PhiMinus = real(Phi[2+2*Mu]);
+     PhiE[1+Mu] = (PhiMinus - PhiPlus) / (2.0*Delta[Mu]);
    };
    
 }
@@ -341,11 +355,10 @@ StaticExcitation *ParseExcitationSection(StaticSolver *SSS,
         if (NumTokens<1)
          ErrExit("%s:%i: invalid PHI specification",FileName,*LineNum);
 
-        UserSFData *Data = (UserSFData *)mallocEC(sizeof *Data);
         char *str=0;
         for(int nt=1; nt<NumTokens; nt++)
          str=vstrappend(str, " %s",Tokens[nt]);
-        Data->PhiEvaluator=cevaluator_create(str);
+        UserSFData *Data = CreateUserSFData(str);
         AddStaticField(SE, UserStaticField, (void *)Data);
         Log("Excitation %s: added user-defined field Phi=%s",Label,str);
         free(str);
@@ -549,8 +562,7 @@ StaticExcitation **CreateSimpleSEList(RWGGeometry *G,
   /***************************************************************/
   if (PhiExt)
    { 
-     UserSFData *Data = (UserSFData *)mallocEC(sizeof(*Data));
-     Data->PhiEvaluator=cevaluator_create(PhiExt);
+     UserSFData *Data = CreateUserSFData(PhiExt);
      AddStaticField(SE, UserStaticField, (void *)Data);
    };
  
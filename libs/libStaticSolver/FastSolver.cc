@@ -0,0 +1,1006 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * FastSolver.cc -- fast iterative solver for the electrostatic BEM
+ *               -- system in large geometries
+ *
+ * The BEM matrix is never stored as a dense matrix. Instead we
+ * build an octree over the panel centroids of all surfaces and
+ * split the matrix into
+ *
+ *  (a) a sparse near-field part, consisting of exact panel-panel
+ *      integrals (computed once by GetPPI and stored in an SMatrix)
+ *      for all pairs of panels that are not well-separated, and
+ *
+ *  (b) a far-field part, evaluated on the fly at each matrix-vector
+ *      product by expanding the charge in each octree cell in a
+ *      cartesian multipole expansion about the cell center and
+ *      averaging the expansion over distant panels. Both the moments
+ *      and the averages use the three-point edge-midpoint rule on
+ *      each panel, which matches the panel-panel integrals of (a)
+ *      to second order in the panel size.
+ *
+ * A cell is 'well-separated' from a destination panel if
+ *  (cell radius + panel radius) < Theta * (distance between centers)
+ *
+ * The linear system is solved by restarted GMRES with a diagonal
+ * (Jacobi) preconditioner. Several right-hand sides (e.g. one per conductor
+ * in a capacitance calculation) are advanced in lockstep so that each
+ * sweep over the near-field matrix and the octree serves all of them.
+ *
+ * The octree is tied to the pose of the surfaces it was built for;
+ * HaveFastSolver() returns false once any surface has been transformed,
+ * and callers must then call InitFastSolver() again.
+ *
+ * tunable parameters (environment variables):
+ *  SCUFF_FASTSOLVER_THETA      multipole acceptance parameter (0.5)
+ *  SCUFF_FASTSOLVER_ORDER      order of multipole expansions (4)
+ *  SCUFF_FASTSOLVER_LEAFSIZE   max number of panels per leaf cell (32)
+ *  SCUFF_FASTSOLVER_TOL        relative residual for GMRES (1e-6)
+ *  SCUFF_FASTSOLVER_MAXITERS   max number of GMRES iterations (500)
+ *  SCUFF_FASTSOLVER_RESTART    GMRES restart length (100)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include <vector>
+
+#include <libhrutil.h>
+#include <libhmat.h>
+
+#include "libscuff.h"
+#include "StaticSolver.h"
+
+namespace scuff {
+
+#define DEFAULT_THETA     0.5
+#define DEFAULT_LEAFSIZE  32
+#define DEFAULT_TOL       1.0e-6
+#define DEFAULT_MAXITERS  500
+#define DEFAULT_RESTART   100
+#define MAXTREEDEPTH      24
+
+// order of the cartesian multipole expansion of each cell
+// (2 = monopole, dipole, quadrupole), and the largest order
+// allowed, with the corresponding number of Taylor coefficients
+#define DEFAULT_ORDER     4
+#define MAXORDER          12
+#define MAXCOEFFS         ((MAXORDER+2)*(MAXORDER+3)*(MAXORDER+4)/6)
+
+/***************************************************************/
+/* a single cell in the octree. Panels in the cell are         */
+/* PanelOrder[Begin], ..., PanelOrder[End-1].                  */
+/***************************************************************/
+typedef struct TreeCell
+ { double Center[3];
+   double Radius;           // radius of sphere about Center enclosing all panels in cell
+   int Begin, End;
+   int Children[8];
+   int NumChildren;
+ } TreeCell;
+
+typedef struct FSData
+ {
+   int N;                   // total number of panels
+   double Theta;
+   int LeafSize;
+   double Tol;
+   int MaxIters, Restart;
+
+   // cartesian multipole expansions (see InitMultiIndices)
+   int Order, NumMoments, NumCoeffs;
+   std::vector<int> Exponents, Lower1, Lower2, Upper1;
+
+   // per-panel data, indexed by global panel index
+   int *SurfaceIndex, *PanelIndex;
+   double *Centroids, *Normals, *Areas, *Radii;
+
+   // edge midpoints of each panel (MidPoints + 9*n); the three-point
+   // rule on these points integrates quadratics over the panel exactly,
+   // and is used both for the moments of source panels and for the
+   // average of the far field over destination panels
+   double *MidPoints;
+
+   // per-panel data describing how the BEM matrix row for
+   // this panel is related to the potential and field:
+   // RowKind=0: row is Scale * (average potential over panel)
+   // RowKind=1: row is Scale * (average of nHat \cdot E over panel)
+   int *RowKind;
+   double *RowScale;
+
+   // octree
+   std::vector<TreeCell> Cells;
+   int *PanelOrder;         // PanelOrder[n] = global index of nth panel in tree order
+   int *TreePosition;       // inverse of PanelOrder
+   std::vector<int> Leaves;
+
+   // near-field matrix entries
+   SMatrix *NearMatrix;
+
+   // far-field interaction lists in CSR form: the cells whose
+   // multipole expansions contribute to row n are FarCells[FarStart[n]],
+   // ..., FarCells[FarStart[n+1]-1].
+   int *FarStart, *FarCells;
+
+   // diagonal (Jacobi) preconditioner
+   double *InverseDiagonal;
+
+   // TransformStamp of each surface when the octree was built;
+   // if any surface has since been moved, the octree is stale
+   unsigned *TransformStamps;
+
+ } FSData;
+
+/***************************************************************/
+/* recursively build the octree below a cell with the given    */
+/* center and half-width                                       */
+/***************************************************************/
+static int BuildCell(FSData *FSD, int Begin, int End,
+                     double Center[3], double HalfWidth, int Depth)
+{
+  int nc = FSD->Cells.size();
+  FSD->Cells.push_back(TreeCell());
+  TreeCell *C = &(FSD->Cells[nc]);
+  VecCopy(Center, C->Center);
+  C->Begin       = Begin;
+  C->End         = End;
+  C->NumChildren = 0;
+
+  /*--------------------------------------------------------------*/
+  /*- radius of enclosing sphere ---------------------------------*/
+  /*--------------------------------------------------------------*/
+  double Radius=0.0;
+  for(int n=Begin; n<End; n++)
+   { int np = FSD->PanelOrder[n];
+     double r = VecDistance(FSD->Centroids + 3*np, Center) + FSD->Radii[np];
+     Radius = fmax(Radius, r);
+   };
+  C->Radius = Radius;
+
+  if ( (End-Begin) <= FSD->LeafSize || Depth>=MAXTREEDEPTH )
+   { FSD->Leaves.push_back(nc);
+     return nc;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- sort panels into octants -----------------------------------*/
+  /*--------------------------------------------------------------*/
+  int NP = End-Begin;
+  int *Octant = new int[NP];
+  int Count[8]={0,0,0,0,0,0,0,0};
+  for(int n=0; n<NP; n++)
+   { double *X = FSD->Centroids + 3*FSD->PanelOrder[Begin+n];
+     int o = (X[0]>Center[0] ? 1 : 0) + (X[1]>Center[1] ? 2 : 0) + (X[2]>Center[2] ? 4 : 0);
+     Octant[n]=o;
+     Count[o]++;
+   };
+
+  int Start[9];
+  Start[0]=0;
+  for(int o=0; o<8; o++)
+   Start[o+1] = Start[o] + Count[o];
+
+  int *Sorted = new int[NP];
+  int Fill[8];
+  memcpy(Fill, Start, 8*sizeof(int));
+  for(int n=0; n<NP; n++)
+   Sorted[ Fill[Octant[n]]++ ] = FSD->PanelOrder[Begin+n];
+  memcpy(FSD->PanelOrder + Begin, Sorted, NP*sizeof(int));
+  delete[] Sorted;
+  delete[] Octant;
+
+  /*--------------------------------------------------------------*/
+  /*- recurse into nonempty octants. note that FSD->Cells may be -*/
+  /*- reallocated by the recursive calls, so we may not hold on  -*/
+  /*- to the pointer C                                           -*/
+  /*--------------------------------------------------------------*/
+  int Children[8], NumChildren=0;
+  for(int o=0; o<8; o++)
+   { if (Count[o]==0) continue;
+     double ChildCenter[3];
+     ChildCenter[0] = Center[0] + ( (o&1) ? 0.5 : -0.5)*HalfWidth;
+     ChildCenter[1] = Center[1] + ( (o&2) ? 0.5 : -0.5)*HalfWidth;
+     ChildCenter[2] = Center[2] + ( (o&4) ? 0.5 : -0.5)*HalfWidth;
+     Children[NumChildren++]
+      = BuildCell(FSD, Begin+Start[o], Begin+Start[o+1], ChildCenter, 0.5*HalfWidth, Depth+1);
+   };
+
+  C = &(FSD->Cells[nc]);
+  C->NumChildren = NumChildren;
+  memcpy(C->Children, Children, NumChildren*sizeof(int));
+  return nc;
+}
+
+/***************************************************************/
+/* get the list of panels that interact with a destination     */
+/* point X (with radius r) directly, and the list of cells     */
+/* that interact with it via multipole expansions              */
+/***************************************************************/
+static void GetInteractionLists(FSData *FSD, double *X, double r,
+                                std::vector<int> &NearPanels,
+                                std::vector<int> *FarCells)
+{
+  int Stack[8*MAXTREEDEPTH+8];
+  int StackSize=0;
+  Stack[StackSize++]=0;
+  while(StackSize>0)
+   {
+     TreeCell *C = &(FSD->Cells[ Stack[--StackSize] ]);
+     double d = VecDistance(X, C->Center);
+     if ( FarCells && (C->Radius + r) < FSD->Theta*d )
+      FarCells->push_back( C - &(FSD->Cells[0]) );
+     else if ( C->NumChildren==0 )
+      { for(int n=C->Begin; n<C->End; n++)
+         NearPanels.push_back(FSD->PanelOrder[n]);
+      }
+     else
+      for(int nc=0; nc<C->NumChildren; nc++)
+       Stack[StackSize++] = C->Children[nc];
+   };
+}
+
+/***************************************************************/
+/* exact value of the (na,nb) BEM matrix element, where na, nb */
+/* are global panel indices; this duplicates the logic of      */
+/* StaticSolver::AssembleBEMMatrixBlock.                       */
+/***************************************************************/
+static double GetExactEntry(StaticSolver *SS, FSData *FSD,
+                            SurfType *SurfaceTypes, double *Deltas, double *Lambdas,
+                            int na, int nb)
+{
+  int nsa = FSD->SurfaceIndex[na], npa = FSD->PanelIndex[na];
+  int nsb = FSD->SurfaceIndex[nb], npb = FSD->PanelIndex[nb];
+  RWGSurface *Sa = SS->G->Surfaces[nsa];
+  RWGSurface *Sb = SS->G->Surfaces[nsb];
+
+  double MatrixEntry=0.0;
+  switch(SurfaceTypes[nsa])
+   {
+     case PEC:
+       MatrixEntry = SS->GetPPI(Sa,npa,Sb,npb,0);
+       break;
+
+     case LAMBDASURFACE:
+       MatrixEntry = -1.0*SS->GetPPI(Sa,npa,Sb,npb,0);
+       if (na==nb) MatrixEntry -= Lambdas[nsa]*FSD->Areas[na];
+       break;
+
+     case DIELECTRIC:
+       if (na==nb)
+        MatrixEntry = FSD->Areas[na];
+       else
+        MatrixEntry = Deltas[nsa] * SS->GetPPI(Sa,npa,Sb,npb,1);
+       break;
+   };
+  return MatrixEntry;
+}
+
+/***************************************************************/
+/* tables of the multi-indices k=(k_x,k_y,k_z) of the cartesian*/
+/* expansion, ordered by degree |k|=k_x+k_y+k_z. the moments   */
+/* of a cell are M_k = \sum q (x-x_C)^k for |k| <= Order; the  */
+/* field needs Taylor coefficients up to |k| = Order+1.        */
+/***************************************************************/
+static void InitMultiIndices(FSData *FSD)
+{
+  int P = FSD->Order;
+  std::vector<int> &K = FSD->Exponents;
+  K.clear();
+  for(int Degree=0; Degree<=P+1; Degree++)
+   for(int kx=Degree; kx>=0; kx--)
+    for(int ky=Degree-kx; ky>=0; ky--)
+     { K.push_back(kx);
+       K.push_back(ky);
+       K.push_back(Degree-kx-ky);
+     };
+  FSD->NumCoeffs  = K.size()/3;
+  FSD->NumMoments = (P+1)*(P+2)*(P+3)/6;
+
+  // Index[(kx*(P+2) + ky)*(P+2) + kz] = position of k in the list
+  int D=P+2;
+  std::vector<int> Index(D*D*D, -1);
+  for(int n=0; n<FSD->NumCoeffs; n++)
+   Index[ (K[3*n]*D + K[3*n+1])*D + K[3*n+2] ] = n;
+
+  FSD->Lower1.assign(3*FSD->NumCoeffs, -1);
+  FSD->Lower2.assign(3*FSD->NumCoeffs, -1);
+  FSD->Upper1.assign(3*FSD->NumMoments, -1);
+  for(int n=0; n<FSD->NumCoeffs; n++)
+   for(int i=0; i<3; i++)
+    { int k[3]={K[3*n], K[3*n+1], K[3*n+2]};
+      if (k[i]>=1)
+       { k[i]--;
+         FSD->Lower1[3*n+i] = Index[ (k[0]*D + k[1])*D + k[2] ];
+         k[i]++;
+       };
+      if (k[i]>=2)
+       { k[i]-=2;
+         FSD->Lower2[3*n+i] = Index[ (k[0]*D + k[1])*D + k[2] ];
+         k[i]+=2;
+       };
+      if (n<FSD->NumMoments)
+       { k[i]++;
+         FSD->Upper1[3*n+i] = Index[ (k[0]*D + k[1])*D + k[2] ];
+       };
+    };
+}
+
+/***************************************************************/
+/* compute multipole moments of all octree cells for NRHS      */
+/* charge-density vectors stored in the columns of Sigma.      */
+/* Moments[ NumMoments*(nc*NRHS + nrhs) + ... ]                */
+/***************************************************************/
+static void GetCellMoments(FSData *FSD, double *Sigma, int NRHS,
+                           double *Moments)
+{
+  int N  = FSD->N;
+  int NC = FSD->Cells.size();
+  int P  = FSD->Order;
+  int NM = FSD->NumMoments;
+  int *K = &(FSD->Exponents[0]);
+#ifdef USE_OPENMP
+  int NumThreads = GetNumThreads();
+#pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads)
+#endif
+  for(int nc=0; nc<NC; nc++)
+   {
+     TreeCell *C = &(FSD->Cells[nc]);
+     for(int nrhs=0; nrhs<NRHS; nrhs++)
+      {
+        double *M = Moments + NM*(nc*NRHS + nrhs);
+        memset(M, 0, NM*sizeof(double));
+        for(int n=C->Begin; n<C->End; n++)
+         { int np = FSD->PanelOrder[n];
+           double q = Sigma[nrhs*N + np] * FSD->Areas[np] / 3.0;
+           if (q==0.0) continue;
+           for(int nq=0; nq<3; nq++)
+            { double d[3], Powers[3][MAXORDER+1];
+              VecSub(FSD->MidPoints + 9*np + 3*nq, C->Center, d);
+              for(int i=0; i<3; i++)
+               { Powers[i][0]=1.0;
+                 for(int p=1; p<=P; p++)
+                  Powers[i][p] = Powers[i][p-1]*d[i];
+               };
+              for(int nm=0; nm<NM; nm++)
+               M[nm] += q*Powers[0][K[3*nm]]*Powers[1][K[3*nm+1]]*Powers[2][K[3*nm+2]];
+            };
+         };
+      };
+   };
+}
+
+/***************************************************************/
+/* add the potential and field at X due to the multipole       */
+/* expansion of a single cell. the Taylor coefficients         */
+/*  a_k = (1/k!) D_Y^k (1/|X-Y|) at Y=Center                   */
+/* satisfy the recurrence                                      */
+/*  |k| R^2 a_k = (2|k|-1) \sum_i R_i a_{k-e_i}                 */
+/*                 - (|k|-1) \sum_i a_{k-2e_i}                  */
+/* with R=X-Center, and then                                   */
+/*  Phi = \sum_k a_k M_k,  E_i = \sum_k (k_i+1) a_{k+e_i} M_k   */
+/* (up to the factor 1/4pi).                                   */
+/***************************************************************/
+static void AddMultipolePhiE(FSData *FSD, double *M, double *Center,
+                             double *X, double PhiE[4])
+{
+  double R[3];
+  VecSub(X, Center, R);
+  double R2=VecNorm2(R);
+
+  int *K = &(FSD->Exponents[0]);
+  int *Lower1 = &(FSD->Lower1[0]), *Lower2 = &(FSD->Lower2[0]);
+  double a[MAXCOEFFS];
+  a[0] = 1.0/sqrt(R2);
+  for(int n=1; n<FSD->NumCoeffs; n++)
+   { int Degree = K[3*n] + K[3*n+1] + K[3*n+2];
+     double Sum1=0.0, Sum2=0.0;
+     for(int i=0; i<3; i++)
+      { if (Lower1[3*n+i]>=0) Sum1 += R[i]*a[ Lower1[3*n+i] ];
+        if (Lower2[3*n+i]>=0) Sum2 += a[ Lower2[3*n+i] ];
+      };
+     a[n] = ( (2*Degree-1)*Sum1 - (Degree-1)*Sum2 ) / (Degree*R2);
+   };
+
+  int *Upper1 = &(FSD->Upper1[0]);
+  double Phi=0.0, E[3]={0.0, 0.0, 0.0};
+  for(int n=0; n<FSD->NumMoments; n++)
+   { Phi += a[n]*M[n];
+     for(int i=0; i<3; i++)
+      E[i] += (K[3*n+i]+1)*a[ Upper1[3*n+i] ]*M[n];
+   };
+
+  double PreFac = 1.0/(4.0*M_PI);
+  PhiE[0] += PreFac*Phi;
+  for(int i=0; i<3; i++)
+   PhiE[1+i] += PreFac*E[i];
+}
+
+/***************************************************************/
+/* Y = M*X for NRHS vectors stored column-wise in X, Y         */
+/***************************************************************/
+static void TreeMatVec(FSData *FSD, double *X, double *Y, int NRHS)
+{
+  int N  = FSD->N;
+  int NC = FSD->Cells.size();
+
+  double *Moments = new double[FSD->NumMoments*NC*NRHS];
+  GetCellMoments(FSD, X, NRHS, Moments);
+
+  int *RowStart = FSD->NearMatrix->RowStart;
+  int *ColIndices = FSD->NearMatrix->ColIndices;
+  double *NearEntries = FSD->NearMatrix->DM;
+
+#ifdef USE_OPENMP
+  int NumThreads = GetNumThreads();
+#pragma omp parallel for schedule(dynamic,64), num_threads(NumThreads)
+#endif
+  for(int nr=0; nr<N; nr++)
+   {
+     std::vector<double> Sums(NRHS, 0.0), PhiE(4*NRHS, 0.0);
+
+     for(int i=RowStart[nr]; i<RowStart[nr+1]; i++)
+      for(int nrhs=0; nrhs<NRHS; nrhs++)
+       Sums[nrhs] += NearEntries[i] * X[ nrhs*N + ColIndices[i] ];
+
+     for(int i=FSD->FarStart[nr]; i<FSD->FarStart[nr+1]; i++)
+      { int nc = FSD->FarCells[i];
+        for(int nq=0; nq<3; nq++)
+         for(int nrhs=0; nrhs<NRHS; nrhs++)
+          AddMultipolePhiE(FSD, Moments + FSD->NumMoments*(nc*NRHS + nrhs),
+                           FSD->Cells[nc].Center, FSD->MidPoints + 9*nr + 3*nq,
+                           &(PhiE[4*nrhs]));
+      };
+
+     for(int nrhs=0; nrhs<NRHS; nrhs++)
+      { double Far = (FSD->RowKind[nr]==0) ? PhiE[4*nrhs]
+                                           : VecDot(FSD->Normals + 3*nr, &(PhiE[4*nrhs+1]));
+        Y[nrhs*N + nr] = Sums[nrhs] + FSD->RowScale[nr]*Far/3.0;
+      };
+   };
+
+  delete[] Moments;
+}
+
+/***************************************************************/
+/* X = P^{-1} * X with P the diagonal of the BEM matrix        */
+/***************************************************************/
+static void ApplyPreconditioner(FSData *FSD, double *X)
+{
+  for(int n=0; n<FSD->N; n++)
+   X[n] *= FSD->InverseDiagonal[n];
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void StaticSolver::DestroyFastSolver()
+{
+  FSData *FSD = (FSData *)FastSolverData;
+  if (!FSD) return;
+
+  free(FSD->SurfaceIndex);
+  free(FSD->PanelIndex);
+  free(FSD->Centroids);
+  free(FSD->Normals);
+  free(FSD->Areas);
+  free(FSD->Radii);
+  free(FSD->MidPoints);
+  free(FSD->RowKind);
+  free(FSD->RowScale);
+  free(FSD->PanelOrder);
+  free(FSD->TreePosition);
+  free(FSD->FarStart);
+  free(FSD->FarCells);
+  free(FSD->TransformStamps);
+  if (FSD->NearMatrix) delete FSD->NearMatrix;
+  free(FSD->InverseDiagonal);
+  delete FSD;
+  FastSolverData=0;
+}
+
+/***************************************************************/
+/* returns true if InitFastSolver() has been called since the  */
+/* geometry was last transformed. an octree built for an       */
+/* earlier pose of the geometry is discarded, so that callers  */
+/* fall back to the dense-matrix code paths (or, in SolveFast  */
+/* and ApplyBEMMatrix, abort) instead of silently using it.    */
+/***************************************************************/
+bool StaticSolver::HaveFastSolver()
+{
+  FSData *FSD = (FSData *)FastSolverData;
+  if (!FSD) return false;
+
+  for(int ns=0; ns<G->NumSurfaces; ns++)
+   if (G->Surfaces[ns]->TransformStamp != FSD->TransformStamps[ns])
+    { Log("geometry transformed since InitFastSolver(); discarding octree");
+      DestroyFastSolver();
+      return false;
+    };
+  return true;
+}
+
+/***************************************************************/
+/* build the octree, compute and store the exact near-field    */
+/* matrix elements, and set up the diagonal preconditioner.    */
+/* this must be called again whenever the geometry is          */
+/* transformed (HaveFastSolver() detects that).                */
+/***************************************************************/
+void StaticSolver::InitFastSolver(double Theta, int LeafSize)
+{
+  if (Substrate)
+   ErrExit("fast solver not yet supported for geometries with substrates");
+
+  DestroyFastSolver();
+  FSData *FSD = new FSData;
+  FastSolverData = (void *)FSD;
+
+  /*--------------------------------------------------------------*/
+  /*- solver parameters ------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  FSD->Theta    = (Theta>0.0) ? Theta : DEFAULT_THETA;
+  FSD->LeafSize = (LeafSize>0) ? LeafSize : DEFAULT_LEAFSIZE;
+  FSD->Tol      = DEFAULT_TOL;
+  FSD->MaxIters = DEFAULT_MAXITERS;
+  FSD->Restart  = DEFAULT_RESTART;
+  if (Theta<=0.0)   CheckEnv("SCUFF_FASTSOLVER_THETA",    &(FSD->Theta));
+  if (LeafSize<=0)  CheckEnv("SCUFF_FASTSOLVER_LEAFSIZE", &(FSD->LeafSize));
+  CheckEnv("SCUFF_FASTSOLVER_TOL",      &(FSD->Tol));
+  CheckEnv("SCUFF_FASTSOLVER_MAXITERS", &(FSD->MaxIters));
+  CheckEnv("SCUFF_FASTSOLVER_RESTART",  &(FSD->Restart));
+  FSD->Order = DEFAULT_ORDER;
+  CheckEnv("SCUFF_FASTSOLVER_ORDER",    &(FSD->Order));
+  if (FSD->Order<0) FSD->Order=0;
+  if (FSD->Order>MAXORDER) FSD->Order=MAXORDER;
+  InitMultiIndices(FSD);
+  if (FSD->LeafSize<1) FSD->LeafSize=1;
+  if (FSD->Restart<1)  FSD->Restart=1;
+
+  FSD->TransformStamps=(unsigned *)mallocEC(G->NumSurfaces*sizeof(unsigned));
+  for(int ns=0; ns<G->NumSurfaces; ns++)
+   FSD->TransformStamps[ns]=G->Surfaces[ns]->TransformStamp;
+
+  /*--------------------------------------------------------------*/
+  /*- gather per-panel data --------------------------------------*/
+  /*--------------------------------------------------------------*/
+  int N = FSD->N    = G->TotalPanels;
+  FSD->SurfaceIndex = (int *)mallocEC(N*sizeof(int));
+  FSD->PanelIndex   = (int *)mallocEC(N*sizeof(int));
+  FSD->Centroids    = (double *)mallocEC(3*N*sizeof(double));
+  FSD->Normals      = (double *)mallocEC(3*N*sizeof(double));
+  FSD->Areas        = (double *)mallocEC(N*sizeof(double));
+  FSD->Radii        = (double *)mallocEC(N*sizeof(double));
+  FSD->MidPoints    = (double *)mallocEC(9*N*sizeof(double));
+  FSD->RowKind      = (int *)mallocEC(N*sizeof(int));
+  FSD->RowScale     = (double *)mallocEC(N*sizeof(double));
+  FSD->PanelOrder   = (int *)mallocEC(N*sizeof(int));
+  FSD->TreePosition = (int *)mallocEC(N*sizeof(int));
+  FSD->NearMatrix   = 0;
+  FSD->InverseDiagonal = 0;
+
+  int NS = G->NumSurfaces;
+  SurfType *SurfaceTypes = new SurfType[NS];
+  double *Deltas  = new double[NS];
+  double *Lambdas = new double[NS];
+  double RMin[3]={HUGE_VAL, HUGE_VAL, HUGE_VAL}, RMax[3]={-HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+  for(int ns=0, n=0; ns<NS; ns++)
+   {
+     RWGSurface *S = G->Surfaces[ns];
+     Deltas[ns]=Lambdas[ns]=0.0;
+     SurfaceTypes[ns] = GetSurfaceType(S, Deltas+ns, Lambdas+ns);
+
+     for(int np=0; np<S->NumPanels; np++, n++)
+      { RWGPanel *P = S->Panels[np];
+        FSD->SurfaceIndex[n] = ns;
+        FSD->PanelIndex[n]   = np;
+        VecCopy(P->Centroid, FSD->Centroids + 3*n);
+        VecCopy(P->ZHat,     FSD->Normals + 3*n);
+        FSD->Areas[n]        = P->Area;
+        FSD->Radii[n]        = P->Radius;
+        for(int i=0; i<3; i++)
+         { double *V1 = S->Vertices + 3*P->VI[i];
+           double *V2 = S->Vertices + 3*P->VI[(i+1)%3];
+           for(int j=0; j<3; j++)
+            FSD->MidPoints[9*n + 3*i + j] = 0.5*(V1[j] + V2[j]);
+         };
+        FSD->PanelOrder[n]   = n;
+
+        for(int i=0; i<3; i++)
+         { RMin[i] = fmin(RMin[i], P->Centroid[i]);
+           RMax[i] = fmax(RMax[i], P->Centroid[i]);
+         };
+
+        switch(SurfaceTypes[ns])
+         { case PEC:           FSD->RowKind[n]=0; FSD->RowScale[n]=P->Area;   break;
+           case LAMBDASURFACE: FSD->RowKind[n]=0; FSD->RowScale[n]=-P->Area;  break;
+           case DIELECTRIC:    FSD->RowKind[n]=1; FSD->RowScale[n]=Deltas[ns]*P->Area; break;
+         };
+      };
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- build octree -----------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  Log("Building octree for fast solver (%i panels, leaf size %i, theta=%g)...",
+       N, FSD->LeafSize, FSD->Theta);
+  double Center[3], HalfWidth=0.0;
+  for(int i=0; i<3; i++)
+   { Center[i] = 0.5*(RMin[i] + RMax[i]);
+     HalfWidth = fmax(HalfWidth, 0.5*(RMax[i]-RMin[i]));
+   };
+  BuildCell(FSD, 0, N, Center, HalfWidth*(1.0+1.0e-6), 0);
+  for(int n=0; n<N; n++)
+   FSD->TreePosition[ FSD->PanelOrder[n] ] = n;
+  Log(" ...%i cells, %i leaves",(int)FSD->Cells.size(), (int)FSD->Leaves.size());
+
+  /*--------------------------------------------------------------*/
+  /*- get interaction lists and near-field matrix elements       -*/
+  /*--------------------------------------------------------------*/
+  Log("Computing near-field interactions...");
+  std::vector< std::vector<int> > NearLists(N), FarLists(N);
+  std::vector< std::vector<double> > NearEntries(N);
+#ifdef USE_OPENMP
+  int NumThreads = GetNumThreads();
+  Log("OpenMP multithreading (%i threads)",NumThreads);
+#pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads)
+#endif
+  for(int nr=0; nr<N; nr++)
+   {
+     if (G->LogLevel>=SCUFF_VERBOSE2) LogPercent(nr, N);
+     GetInteractionLists(FSD, FSD->Centroids + 3*nr, FSD->Radii[nr],
+                         NearLists[nr], &(FarLists[nr]));
+     NearEntries[nr].resize(NearLists[nr].size());
+     for(size_t i=0; i<NearLists[nr].size(); i++)
+      NearEntries[nr][i] = GetExactEntry(this, FSD, SurfaceTypes, Deltas, Lambdas,
+                                         nr, NearLists[nr][i]);
+   };
+
+  size_t NNZ=0, NumFar=0;
+  for(int nr=0; nr<N; nr++)
+   { NNZ    += NearLists[nr].size();
+     NumFar += FarLists[nr].size();
+   };
+
+  FSD->NearMatrix = new SMatrix(N, N, LHM_REAL);
+  FSD->NearMatrix->BeginAssembly(NNZ);
+  FSD->FarStart = (int *)mallocEC( (N+1)*sizeof(int));
+  FSD->FarCells = (int *)mallocEC( (NumFar+1)*sizeof(int));
+  FSD->FarStart[0]=0;
+  for(int nr=0; nr<N; nr++)
+   { for(size_t i=0; i<NearLists[nr].size(); i++)
+      FSD->NearMatrix->AddEntry(nr, NearLists[nr][i], NearEntries[nr][i], false);
+     FSD->FarStart[nr+1] = FSD->FarStart[nr] + FarLists[nr].size();
+     for(size_t i=0; i<FarLists[nr].size(); i++)
+      FSD->FarCells[ FSD->FarStart[nr] + i ] = FarLists[nr][i];
+     std::vector<int>().swap(NearLists[nr]);
+     std::vector<int>().swap(FarLists[nr]);
+     std::vector<double>().swap(NearEntries[nr]);
+   };
+  FSD->NearMatrix->EndAssembly();
+  Log(" ...%lu near-field entries (%.2f%% of dense), %lu far-field cell interactions",
+       NNZ, 100.0*((double)NNZ)/((double)N*(double)N), NumFar);
+
+  delete[] SurfaceTypes;
+  delete[] Deltas;
+  delete[] Lambdas;
+
+  /*--------------------------------------------------------------*/
+  /*- diagonal preconditioner. (a block-Jacobi preconditioner     */
+  /*- built from the leaf blocks of the near-field matrix needs   */
+  /*- several times more iterations for PEC surfaces: the rows    */
+  /*- of the first-kind equation for a truncated patch of surface */
+  /*- have an inverse with large spurious charges at the edges of */
+  /*- the patch.)                                                 */
+  /*--------------------------------------------------------------*/
+  FSD->InverseDiagonal = (double *)mallocEC(N*sizeof(double));
+  for(int n=0; n<N; n++)
+   FSD->InverseDiagonal[n] = 1.0 / FSD->NearMatrix->GetEntryD(n,n);
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void StaticSolver::ApplyBEMMatrix(HVector *Sigma, HVector *MSigma)
+{
+  if (!HaveFastSolver())
+   ErrExit("%s:%i: InitFastSolver() must be called before ApplyBEMMatrix() (and after any transformation)",__FILE__,__LINE__);
+  FSData *FSD = (FSData *)FastSolverData;
+  if (Sigma->N!=FSD->N || MSigma->N!=FSD->N || Sigma->RealComplex!=LHM_REAL || MSigma->RealComplex!=LHM_REAL)
+   ErrExit("%s:%i: invalid vectors passed to ApplyBEMMatrix()",__FILE__,__LINE__);
+  TreeMatVec(FSD, Sigma->DV, MSigma->DV, 1);
+}
+
+/***************************************************************/
+/* solve M*X = B for NRHS right-hand sides stored column-wise  */
+/* in B, by right-preconditioned restarted GMRES. the NRHS     */
+/* systems are iterated in lockstep so that each tree matvec   */
+/* serves all of them; systems drop out as they converge.      */
+/* on return, B is overwritten with X. the return value is the */
+/* number of iterations.                                       */
+/***************************************************************/
+static int GMRESSolve(FSData *FSD, double *B, int NRHS, double Tol, int MaxIters)
+{
+  int N = FSD->N;
+  int m = FSD->Restart;
+  size_t NN = ((size_t)N)*NRHS;
+
+  double *X  = new double[NN];
+  double *W  = new double[NN];
+  double *V  = new double[(m+1)*NN];
+  double *H  = new double[NRHS*(m+1)*m];
+  double *CS = new double[NRHS*m];
+  double *SN = new double[NRHS*m];
+  double *g  = new double[NRHS*(m+1)];
+  double *BNorm    = new double[NRHS];
+  double *Residual = new double[NRHS];
+  bool *Active     = new bool[NRHS];
+  int *NumSteps    = new int[NRHS];
+  memset(X, 0, NN*sizeof(double));
+
+  for(int k=0; k<NRHS; k++)
+   { BNorm[k] = VecNorm(B + k*N, N);
+     Active[k] = (BNorm[k]>0.0);
+     if (BNorm[k]==0.0) BNorm[k]=1.0;
+     Residual[k]=0.0;
+   };
+
+  int Iters=0;
+  while(Iters<MaxIters)
+   {
+     /*--------------------------------------------------------------*/
+     /*- compute true residuals at start of each restart cycle      -*/
+     /*--------------------------------------------------------------*/
+     TreeMatVec(FSD, X, W, NRHS);
+     int NumActive=0;
+     for(int k=0; k<NRHS; k++)
+      { if (!Active[k]) continue;
+        double *R = V + k*N;
+        for(int n=0; n<N; n++)
+         R[n] = B[k*N+n] - W[k*N+n];
+        double Beta = VecNorm(R, N);
+        Residual[k] = Beta/BNorm[k];
+        if (Residual[k] < Tol)
+         { Active[k]=false;
+           continue;
+         };
+        VecScale(R, 1.0/Beta, N);
+        memset(g + k*(m+1), 0, (m+1)*sizeof(double));
+        g[k*(m+1)] = Beta;
+        NumSteps[k]=0;
+        NumActive++;
+      };
+     if (NumActive==0) break;
+
+     /*--------------------------------------------------------------*/
+     /*- arnoldi iteration                                          -*/
+     /*--------------------------------------------------------------*/
+     for(int j=0; j<m && Iters<MaxIters && NumActive>0; j++, Iters++)
+      {
+        double *Vj = V + j*NN, *Vj1 = V + (j+1)*NN;
+        for(int k=0; k<NRHS; k++)
+         { if (Active[k] && NumSteps[k]==j)
+            { memcpy(W + k*N, Vj + k*N, N*sizeof(double));
+              ApplyPreconditioner(FSD, W + k*N);
+            }
+           else
+            memset(W + k*N, 0, N*sizeof(double));
+         };
+        TreeMatVec(FSD, W, Vj1, NRHS);
+
+        for(int k=0; k<NRHS; k++)
+         {
+           if (!Active[k] || NumSteps[k]!=j) continue;
+
+           double *w  = Vj1 + k*N;
+           double *Hk = H + k*(m+1)*m;    // Hk[i + j*(m+1)]
+           double *ck = CS + k*m, *sk = SN + k*m, *gk = g + k*(m+1);
+
+           // modified gram-schmidt
+           for(int i=0; i<=j; i++)
+            { double *Vi = V + i*NN + k*N;
+              double hij = VecDot(w, Vi, N);
+              Hk[i + j*(m+1)] = hij;
+              VecPlusEquals(w, -hij, Vi, N);
+            };
+           double hj1j = VecNorm(w, N);
+           Hk[j+1 + j*(m+1)] = hj1j;
+           if (hj1j>0.0) VecScale(w, 1.0/hj1j, N);
+
+           // apply previous givens rotations to new column
+           for(int i=0; i<j; i++)
+            { double a = Hk[i + j*(m+1)], b = Hk[i+1 + j*(m+1)];
+              Hk[i + j*(m+1)]   =  ck[i]*a + sk[i]*b;
+              Hk[i+1 + j*(m+1)] = -sk[i]*a + ck[i]*b;
+            };
+
+           // new givens rotation to eliminate subdiagonal
+           double a = Hk[j + j*(m+1)], b = Hk[j+1 + j*(m+1)];
+           double r = sqrt(a*a + b*b);
+           ck[j] = (r==0.0) ? 1.0 : a/r;
+           sk[j] = (r==0.0) ? 0.0 : b/r;
+           Hk[j + j*(m+1)]   = r;
+           Hk[j+1 + j*(m+1)] = 0.0;
+           gk[j+1] = -sk[j]*gk[j];
+           gk[j]   =  ck[j]*gk[j];
+
+           NumSteps[k] = j+1;
+           Residual[k] = fabs(gk[j+1]) / BNorm[k];
+           if (Residual[k]<Tol || hj1j==0.0)
+            NumActive--; // converged within this cycle; stop extending its Krylov space
+         };
+      };
+
+     /*--------------------------------------------------------------*/
+     /*- update solutions: X += P^{-1} * V*y, with y = H \ g        -*/
+     /*--------------------------------------------------------------*/
+     for(int k=0; k<NRHS; k++)
+      {
+        if (!Active[k]) continue;
+        int NumSteps_k = NumSteps[k];
+        double *Hk = H + k*(m+1)*m, *gk = g + k*(m+1);
+        double *y = new double[NumSteps_k+1];
+        for(int i=NumSteps_k-1; i>=0; i--)
+         { double Sum=gk[i];
+           for(int l=i+1; l<NumSteps_k; l++)
+            Sum -= Hk[i + l*(m+1)]*y[l];
+           y[i] = (Hk[i + i*(m+1)]==0.0) ? 0.0 : Sum / Hk[i + i*(m+1)];
+         };
+        double *u = W + k*N;
+        memset(u, 0, N*sizeof(double));
+        for(int i=0; i<NumSteps_k; i++)
+         VecPlusEquals(u, y[i], V + i*NN + k*N, N);
+        ApplyPreconditioner(FSD, u);
+        VecPlusEquals(X + k*N, 1.0, u, N);
+        delete[] y;
+      };
+
+     double MaxResidual=0.0;
+     for(int k=0; k<NRHS; k++)
+      if (Active[k]) MaxResidual = fmax(MaxResidual, Residual[k]);
+     Log(" GMRES iteration %i: max relative residual %.2e",Iters,MaxResidual);
+   };
+
+  double MaxResidual=0.0;
+  for(int k=0; k<NRHS; k++)
+   MaxResidual = fmax(MaxResidual, Residual[k]);
+  if (MaxResidual>=Tol)
+   Warn("GMRES did not converge in %i iterations (residual %.2e)",Iters,MaxResidual);
+
+  memcpy(B, X, NN*sizeof(double));
+
+  delete[] X;
+  delete[] W;
+  delete[] V;
+  delete[] H;
+  delete[] CS;
+  delete[] SN;
+  delete[] g;
+  delete[] BNorm;
+  delete[] Residual;
+  delete[] Active;
+  delete[] NumSteps;
+
+  return Iters;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int StaticSolver::SolveFast(HMatrix *RHS, double Tol, int MaxIters)
+{
+  if (!HaveFastSolver())
+   ErrExit("%s:%i: InitFastSolver() must be called before SolveFast() (and after any transformation)",__FILE__,__LINE__);
+  FSData *FSD = (FSData *)FastSolverData;
+  if (RHS->NR!=FSD->N || RHS->RealComplex!=LHM_REAL || RHS->StorageType!=LHM_NORMAL)
+   ErrExit("%s:%i: invalid RHS matrix passed to SolveFast()",__FILE__,__LINE__);
+
+  if (Tol<=0.0) Tol=FSD->Tol;
+  if (MaxIters<=0) MaxIters=FSD->MaxIters;
+
+  Log("Solving BEM system iteratively (%i right-hand sides)...",RHS->NC);
+  int Iters=GMRESSolve(FSD, RHS->DM, RHS->NC, Tol, MaxIters);
+  Log(" ...%i GMRES iterations",Iters);
+  return Iters;
+}
+
+int StaticSolver::SolveFast(HVector *RHS, double Tol, int MaxIters)
+{
+  if (!HaveFastSolver())
+   ErrExit("%s:%i: InitFastSolver() must be called before SolveFast() (and after any transformation)",__FILE__,__LINE__);
+  FSData *FSD = (FSData *)FastSolverData;
+  if (RHS->N!=FSD->N || RHS->RealComplex!=LHM_REAL)
+   ErrExit("%s:%i: invalid RHS vector passed to SolveFast()",__FILE__,__LINE__);
+
+  if (Tol<=0.0) Tol=FSD->Tol;
+  if (MaxIters<=0) MaxIters=FSD->MaxIters;
+
+  Log("Solving BEM system iteratively...");
+  int Iters=GMRESSolve(FSD, RHS->DV, 1, Tol, MaxIters);
+  Log(" ...%i GMRES iterations",Iters);
+  return Iters;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void StaticSolver::SolveBEMSystem(HMatrix *M, HVector *RHS)
+{
+  if (M)
+   M->LUSolve(RHS);
+  else if (HaveFastSolver())
+   SolveFast(RHS);
+  else
+   ErrExit("%s:%i: no BEM matrix and no fast solver",__FILE__,__LINE__);
+}
+
+/***************************************************************/
+/* contributions of surface charges to the potential and field */
+/* at a list of points, with the far-field contributions       */
+/* computed from the octree multipole expansions and the near- */
+/* field contributions computed exactly                        */
+/***************************************************************/
+HMatrix *StaticSolver::GetFieldsFast(HVector *Sigma, HMatrix *X, HMatrix *PhiE)
+{
+  FSData *FSD = (FSData *)FastSolverData;
+
+  int NC = FSD->Cells.size();
+  double *Moments = new double[FSD->NumMoments*NC];
+  GetCellMoments(FSD, Sigma->DV, 1, Moments);
+
+  int NX = X->NR;
+#ifdef USE_OPENMP
+  int NumThreads = GetNumThreads();
+#pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads)
+#endif
+  for(int nx=0; nx<NX; nx++)
+   {
+     double R[3];
+     R[0]=X->GetEntryD(nx,0);
+     R[1]=X->GetEntryD(nx,1);
+     R[2]=X->GetEntryD(nx,2);
+
+     std::vector<int> NearPanels, FarCells;
+     GetInteractionLists(FSD, R, 0.0, NearPanels, &FarCells);
+
+     double PhiESum[4]={0.0, 0.0, 0.0, 0.0};
+     for(size_t i=0; i<FarCells.size(); i++)
+      { int nc = FarCells[i];
+        AddMultipolePhiE(FSD, Moments + FSD->NumMoments*nc, FSD->Cells[nc].Center, R, PhiESum);
+      };
+
+     for(size_t i=0; i<NearPanels.size(); i++)
+      { int n = NearPanels[i];
+        double DeltaPhiE[4];
+        GetPhiE(FSD->SurfaceIndex[n], FSD->PanelIndex[n], R, DeltaPhiE);
+        VecPlusEquals(PhiESum, Sigma->DV[n], DeltaPhiE, 4);
+      };
+
+     for(int i=0; i<4; i++)
+      PhiE->SetEntry(nx, i, PhiESum[i]);
+   };
+
+  delete[] Moments;
+  return PhiE;
+}
+
+} // namespace scuff
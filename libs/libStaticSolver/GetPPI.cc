@@ -54,11 +54,11 @@ double GetPPI_CC(double *Va[3], double *Vb[3], double *nHat, int Order, int Whic
 
   V0=Va[0];
   VecSub(Va[1], Va[0], A);
-  VecSub(Va[2], Va[1], B);
+  VecSub(Va[2], Va[0], B);
 
   V0P=Vb[0];
   VecSub(Vb[1], Vb[0], AP);
-  VecSub(Vb[2], Vb[1], BP);
+  VecSub(Vb[2], Vb[0], BP);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -121,7 +121,7 @@ double GetPPI_CE(StaticSolver *SSS, double *Va[3], double *nHat, int ns2, int np
 
   V0=Va[0];
   VecSub(Va[1], Va[0], A);
-  VecSub(Va[2], Va[1], B);
+  VecSub(Va[2], Va[0], B);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
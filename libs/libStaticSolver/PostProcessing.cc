@@ -227,6 +227,46 @@ HMatrix *StaticSolver::GetCapacitanceMatrix(HMatrix *M,
   if (CMatrix==0)
    CMatrix = new HMatrix(NCS, NCS);
 
+  /*--------------------------------------------------------------*/
+  /*- if the fast solver is active and no BEM matrix was given,   */
+  /*- solve for all conductors at once as a multi-RHS system      */
+  /*--------------------------------------------------------------*/
+  if (M==0 && HaveFastSolver())
+   { 
+     int N = G->TotalPanels;
+     HMatrix *RHSMatrix = new HMatrix(N, NCS, LHM_REAL);
+     HVector *RHS = AllocateRHSVector();
+     double *Potentials = new double[NS];
+     for(int ns=0, ncs=0; ns<NS; ns++)
+      { if ( !(G->Surfaces[ns]->IsPEC) )
+         continue;
+        memset(Potentials, 0, NS*sizeof(double));
+        Potentials[ns]=1.0;
+        AssembleRHSVector(Potentials, RHS);
+        RHSMatrix->SetEntriesD(":", ncs++, RHS->DV);
+      };
+
+     SolveFast(RHSMatrix);
+
+     HMatrix *QP = new HMatrix(NS, 4);
+     for(int ncs=0; ncs<NCS; ncs++)
+      { RHSMatrix->GetEntriesD(":", ncs, RHS->DV);
+        GetCartesianMoments(RHS, QP);
+        for(int nsp=0, ncsp=-1; nsp<NS; nsp++)
+         { if ( !(G->Surfaces[nsp]->IsPEC) )
+            continue;
+           ncsp++;
+           CMatrix->SetEntry(ncsp, ncs, QP->GetEntry(nsp,0));
+         };
+      };
+
+     delete QP;
+     delete[] Potentials;
+     delete RHS;
+     delete RHSMatrix;
+     return CMatrix;
+   };
+
   /*--------------------------------------------------------------*/
   /*- allocate BEM matrix and RHS vector if necessary             */
   /*--------------------------------------------------------------*/
@@ -54,6 +54,7 @@ StaticSolver::StaticSolver(const char *GeoFileName, const char *SubstrateFile, i
   TransformLabel=0;
   ExcitationLabel=0;
   SeparateOutputFiles=false;
+  FastSolverData=0;
 
   G=new RWGGeometry(GeoFileName, LogLevel);
   if (G->LDim>0)
@@ -76,6 +77,7 @@ StaticSolver::StaticSolver(const char *GeoFileName, const char *SubstrateFile, i
 /***********************************************************************/
 StaticSolver::~StaticSolver()
 {
+  DestroyFastSolver();
   delete G;
 }
 
@@ -121,6 +123,28 @@ HMatrix *StaticSolver::AssembleBEMMatrix(HMatrix *M)
   return M;
 }
 
+/***********************************************************************/
+/* classify surface S as a PEC, dielectric, or lambda surface and     */
+/* return the relevant material parameter (Delta for dielectric       */
+/* surfaces, Lambda for lambda surfaces).                              */
+/***********************************************************************/
+SurfType StaticSolver::GetSurfaceType(RWGSurface *S, double *pDelta, double *pLambda)
+{
+  if (S->IsPEC)
+   return PEC;
+
+  double EpsR  = real( G->RegionMPs[ S->RegionIndices[0] ] -> GetEps(0.0) );
+  cdouble EpsRP = G->RegionMPs[ S->RegionIndices[1] ] -> GetEps(0.0);
+
+  if ( real(EpsRP)==0.0 && imag(EpsRP)<=0.0 )
+   { if (pLambda) *pLambda = -imag(EpsRP);
+     return LAMBDASURFACE;
+   };
+
+  if (pDelta) *pDelta = 2.0*(EpsR - real(EpsRP)) / (EpsR + real(EpsRP));
+  return DIELECTRIC;
+}
+
 /***********************************************************************/
 /***********************************************************************/
 /***********************************************************************/
@@ -136,23 +160,8 @@ void StaticSolver::AssembleBEMMatrixBlock(int nsa, int nsb,
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
-  SurfType SurfaceType;
   double Delta=0.0, Lambda=0.0;
-  if (Sa->IsPEC)
-   SurfaceType = PEC;
-  else
-   { double EpsR  = real( G->RegionMPs[ Sa->RegionIndices[0] ] -> GetEps(0.0) );
-     cdouble EpsRP = G->RegionMPs[ Sa->RegionIndices[1] ] -> GetEps(0.0);
-
-     if ( real(EpsRP)==0.0 && imag(EpsRP)<=0.0 )
-      { SurfaceType = LAMBDASURFACE;
-        Lambda = -imag(EpsRP);
-      }
-     else
-      { SurfaceType = DIELECTRIC;
-        Delta = 2.0*(EpsR - real(EpsRP)) / (EpsR + real(EpsRP));
-      };
-   };
+  SurfType SurfaceType = GetSurfaceType(Sa, &Delta, &Lambda);
 
   /***************************************************************/
   /***************************************************************/
@@ -505,6 +514,25 @@ HMatrix *StaticSolver::GetFields(StaticExcitation *SE, HVector *Sigma,
   if (PhiE==0)
    PhiE = new HMatrix(NX, 4);
   
+  /*--------------------------------------------------------------*/
+  /*- if the fast solver is active, use its octree to get the    -*/
+  /*- contributions of the surface charges                       -*/
+  /*--------------------------------------------------------------*/
+  if (!Substrate && HaveFastSolver())
+   { GetFieldsFast(Sigma, X, PhiE);
+     if (SE && SE->NumSFs)
+      for(int nx=0; nx<NX; nx++)
+       { double R[3], DeltaPhiE[4];
+         R[0]=X->GetEntryD(nx,0);
+         R[1]=X->GetEntryD(nx,1);
+         R[2]=X->GetEntryD(nx,2);
+         EvalStaticField(SE, R, DeltaPhiE);
+         for(int i=0; i<4; i++)
+          PhiE->AddEntry(nx, i, DeltaPhiE[i]);
+       };
+     return PhiE;
+   };
+
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -116,6 +116,25 @@ class StaticSolver
    HMatrix *GetCapacitanceMatrix(HMatrix *M=0, HVector *Sigma=0,
                                  HMatrix *CMatrix=0);
 
+   /* fast iterative solver for large geometries: the BEM matrix is  */
+   /* never formed; instead, matrix-vector products are computed by  */
+   /* a multipole-accelerated octree (exact panel-panel integrals    */
+   /* for nearby pairs, multipole expansions for distant clusters)   */
+   /* and the system is solved by Jacobi-preconditioned GMRES.       */
+   /* HaveFastSolver() is false (and the octree is discarded) once   */
+   /* any surface has been transformed since InitFastSolver().       */
+   void InitFastSolver(double Theta=0.0, int LeafSize=0);
+   void DestroyFastSolver();
+   bool HaveFastSolver();
+   void ApplyBEMMatrix(HVector *Sigma, HVector *MSigma);
+   int SolveFast(HVector *RHS, double Tol=0.0, int MaxIters=0);
+   int SolveFast(HMatrix *RHS, double Tol=0.0, int MaxIters=0);
+
+   /* solve the BEM system, by LU if M is non-NULL (and has been  */
+   /* LU-factorized) or with the fast solver otherwise; on return */
+   /* RHS has been overwritten with the solution                  */
+   void SolveBEMSystem(HMatrix *M, HVector *RHS);
+
    /* visualization */
    void PlotChargeDensity(HVector *Sigma, char *FileName);
    void VisualizeFields(HVector *Sigma,  char *FVMeshFile,
@@ -128,6 +147,8 @@ class StaticSolver
    /*--------------------------------------------------------------------*/ 
    double GetPPI(RWGSurface *Sa, int npa, RWGSurface *Sb, int npb, int WhichIntegral);
    void GetPhiE(int ns, int np, double *X, double PhiE[4]);
+   SurfType GetSurfaceType(RWGSurface *S, double *pDelta=0, double *pLambda=0);
+   HMatrix *GetFieldsFast(HVector *Sigma, HMatrix *X, HMatrix *PhiE);
 
    /*--------------------------------------------------------------------*/ 
    /*- class data fields intended for internal use only, i.e. which -----*/ 
@@ -141,6 +162,9 @@ class StaticSolver
    char *ExcitationLabel;
    bool SeparateOutputFiles;
 
+   // non-NULL iff InitFastSolver() has been called
+   void *FastSolverData;
+
    /*--------------------------------------------------------------*/
    /*- helper functions for contributions of layered dielectric    */
    /*- substrates                                                  */
@@ -159,8 +183,9 @@ class StaticSolver
 /***************************************************************/
 typedef struct UserSFData
  { void *PhiEvaluator;
-   void *EEvaluator[3];
+   void *PhiProgram;    // compiled version of the above
  } UserSFData;
+UserSFData *CreateUserSFData(const char *PhiString);
 void UserStaticField(double *x, void *UserData, double PhiE[4]);
 
 typedef struct SphericalSFData
@@ -72,7 +72,40 @@ int DCUTRI(void *opW, double **Vertices, TriIntFun func,
 /***************************************************************/
 /***************************************************************/
 const char *BZIMethodNames[]=
- { "DEFAULT", "CC", "TC", "POLAR", "POLAR2" };
+ { "DEFAULT", "CC", "TC", "POLAR", "POLAR2", "ATC" };
+
+/***************************************************************/
+/* evaluate the BZ integrand at a batch of NumPoints Bloch     */
+/* vectors, using the caller's batched integrand if one was    */
+/* provided. kBlochs[3*np+i], BZIntegrands[np*FDim + nf].      */
+/***************************************************************/
+static void EvaluateBZBatch(GetBZIArgStruct *Args, int NumPoints,
+                            double *kBlochs, double *BZIntegrands)
+{
+  if (NumPoints==0) 
+   return;
+
+  int FDim = Args->FDim;
+  if (Args->BZIFunc_v)
+   Args->BZIFunc_v(Args->UserData, Args->Omega, NumPoints, kBlochs, BZIntegrands);
+  else
+   for(int np=0; np<NumPoints; np++)
+    Args->BZIFunc(Args->UserData, Args->Omega, kBlochs + 3*np, BZIntegrands + np*FDim);
+
+  Args->NumCalls += NumPoints;
+}
+
+/***************************************************************/
+/* convert a point u in the unit cell of the reciprocal        */
+/* lattice (in reduced coordinates) to a Bloch vector          */
+/***************************************************************/
+static void UTokBloch(HMatrix *RLBasis, const double *u, double kBloch[3])
+{ 
+  kBloch[0]=kBloch[1]=kBloch[2]=0.0;
+  for(int nd=0; nd<RLBasis->NC; nd++)
+   for(int nc=0; nc<3; nc++)
+    kBloch[nc] += u[nd]*RLBasis->GetEntryD(nc,nd);
+}
 
 /***************************************************************/
 /***************************************************************/
@@ -155,6 +188,119 @@ int BZIntegrand_CCCubature(unsigned ndim, const double *u,
   return 0;
 }
 
+/***************************************************************/
+/* vectorized BZ integrand passed to pcubature_v for adaptive  */
+/* clenshaw-curtis cubature: all points requested by one       */
+/* refinement pass are evaluated as a single batch.            */
+/***************************************************************/
+int BZIntegrand_CCCubature_v(unsigned ndim, size_t npt, const double *u,
+                             void *pArgs, unsigned fdim,
+                             double *BZIntegrands)
+{
+  GetBZIArgStruct *Args  = (GetBZIArgStruct *)pArgs;
+
+  double *kBlochs = new double[3*npt];
+  double *Weights = new double[npt];
+  for(size_t np=0; np<npt; np++)
+   { double uVector[3];
+     memcpy(uVector, u + np*ndim, ndim*sizeof(double));
+     Weights[np]=1.0;
+     // Duffy transform for SymmetryFactor = 8 (see above)
+     if (Args->SymmetryFactor==8)
+      { uVector[1]*=uVector[0];
+        Weights[np]*=uVector[0];
+      };
+     UTokBloch(Args->RLBasis, uVector, kBlochs + 3*np);
+   };
+
+  EvaluateBZBatch(Args, npt, kBlochs, BZIntegrands);
+
+  for(size_t np=0; np<npt; np++)
+   VecScale(BZIntegrands + np*fdim, Weights[np], fdim);
+
+  delete[] kBlochs;
+  delete[] Weights;
+  return 0;
+}
+
+/***************************************************************/
+/* fixed-order clenshaw-curtis cubature over the rectangle     */
+/* [Lower, Upper]. all cubature points are evaluated as a      */
+/* single batch.                                               */
+/***************************************************************/
+static void GetBZIntegral_CCFixed(GetBZIArgStruct *Args,
+                                  double *Lower, double *Upper,
+                                  double *BZIntegral)
+{
+  HMatrix *RLBasis    = Args->RLBasis;
+  int LDim            = RLBasis->NC;
+  int FDim            = Args->FDim;
+  int Order           = Args->Order;
+  int SymmetryFactor  = Args->SymmetryFactor;
+
+  double *CCQR = GetCCRule(Order);
+  if (!CCQR) 
+   ErrExit("invalid CCRule order (%i) in GetBZIntegral_CC",Order);
+
+  double uAvg[MAXBZDIM], uDelta[MAXBZDIM];
+  for(int d=0; d<LDim; d++)
+   { uAvg[d]   = 0.5*(Upper[d] + Lower[d]);
+     uDelta[d] = 0.5*(Upper[d] - Lower[d]);
+   };
+
+  int MaxPoints = Order;
+  for(int d=1; d<LDim; d++)
+   MaxPoints*=Order;
+  double *kBlochs = new double[3*MaxPoints];
+  double *Weights = new double[MaxPoints];
+
+  /*--------------------------------------------------------------*/
+  /*- assemble the list of cubature points. for SymmetryFactor=8 -*/
+  /*- we omit points with ky > kx and halve the contributions of -*/
+  /*- points with kx==ky                                         -*/
+  /*--------------------------------------------------------------*/
+  int ncp[MAXBZDIM]={0,0,0};
+  int NumPoints=0;
+  bool Done=false;
+  while(!Done)
+   { 
+     double u[MAXBZDIM], w=1.0;
+     for(int nd=0; nd<LDim; nd++)
+      { u[nd]  = uAvg[nd] - uDelta[nd]*CCQR[2*ncp[nd] + 0];
+           w  *=            uDelta[nd]*CCQR[2*ncp[nd] + 1];
+      }; 
+
+     for(int nd=0; nd<LDim; nd++)
+      { ncp[nd] = (ncp[nd]+1)%Order;
+        if(ncp[nd]) break;
+        if(nd==(LDim-1)) Done=true;
+      };
+
+     if (SymmetryFactor==8)
+      { if ( EqualFloat(u[0],u[1]) ) 
+         w*=0.5;
+        else if (u[1]>u[0])
+         continue;
+      };
+
+     UTokBloch(RLBasis, u, kBlochs + 3*NumPoints);
+     Weights[NumPoints++]=w;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  double *Integrands = new double[NumPoints*FDim];
+  EvaluateBZBatch(Args, NumPoints, kBlochs, Integrands);
+  memset(BZIntegral, 0, FDim*sizeof(double));
+  for(int np=0; np<NumPoints; np++)
+   VecPlusEquals(BZIntegral, Weights[np], Integrands + np*FDim, FDim);
+
+  delete[] kBlochs;
+  delete[] Weights;
+  delete[] Integrands;
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -192,9 +338,16 @@ void GetBZIntegral_CC(GetBZIArgStruct *Args,
              Upper[0]=0.5; Upper[1]=(Order==0) ? 1.0 : 0.5;
              break;
    };
-  CCCubature(Order, FDim, BZIntegrand_CCCubature, (void *)Args, LDim,
-	     Lower, Upper, MaxEvals, AbsTol, RelTol,
-	     ERROR_INDIVIDUAL, BZIntegral, DataBuffer[0]);
+  if (Order==0)
+   pcubature_v(FDim, BZIntegrand_CCCubature_v, (void *)Args, LDim,
+	       Lower, Upper, MaxEvals, AbsTol, RelTol,
+	       ERROR_INDIVIDUAL, BZIntegral, DataBuffer[0]);
+  else if (Order>0)
+   GetBZIntegral_CCFixed(Args, Lower, Upper, BZIntegral);
+  else
+   CCCubature(Order, FDim, BZIntegrand_CCCubature, (void *)Args, LDim,
+	      Lower, Upper, MaxEvals, AbsTol, RelTol,
+	      ERROR_INDIVIDUAL, BZIntegral, DataBuffer[0]);
   VecScale(BZIntegral, SymmetryFactor, FDim);
  
 }
@@ -259,21 +412,6 @@ void GetBZIntegral_TC(GetBZIArgStruct *Args, cdouble Omega,
 
   Args->Omega=Omega;
 
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  static int FDimSave=0, MaxEvalsSave=0;
-  static void *Workspace=0;
-  if (Order==0)
-   {
-     if (FDimSave!=FDim || MaxEvalsSave!=Args->MaxEvals )
-      { FDimSave=FDim;
-        MaxEvalsSave=Args->MaxEvals;
-        if (Workspace) free(Workspace);
-        Workspace=CreateDCUTRIWorkspace(FDim, Args->MaxEvals);
-      };
-   };
-  
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -282,18 +420,291 @@ void GetBZIntegral_TC(GetBZIArgStruct *Args, cdouble Omega,
   double V3[3]={0.5, 0.5, 0.0};
   double *Vertices[3]={V1,V2,V3};
   if (Order==0)
-   Args->NumCalls = DCUTRI(Workspace, Vertices,
-                           BZIntegrand_TC, (void *) Args,
-                           Args->AbsTol, Args->RelTol,
-                           BZIntegral, DataBuffer[0]);
+   { 
+     // the DCUTRI workspace is allocated per call, so that
+     // concurrent BZ integrations (e.g. at several frequencies
+     // in parallel) do not share it
+     void *Workspace=CreateDCUTRIWorkspace(FDim, Args->MaxEvals);
+     Args->NumCalls = DCUTRI(Workspace, Vertices,
+                             BZIntegrand_TC, (void *) Args,
+                             Args->AbsTol, Args->RelTol,
+                             BZIntegral, DataBuffer[0]);
+     free(Workspace);
+   }
   else
-   Args->NumCalls = TriIntFixed(BZIntegrand_TC, FDim, (void *)Args,
-                                V1, V2, V3, Order, BZIntegral);
+   { 
+     // fixed-order rule: evaluate all cubature points, and
+     // all of their octant images, as a single batch
+     int NumPts;
+     double *TCR=GetTCR(Order, &NumPts);
+     int NumOctants = 8/SymmetryFactor;
+     double J = (V2[0]-V1[0])*(V3[1]-V1[1]) - (V2[1]-V1[1])*(V3[0]-V1[0]);
+     double *kBlochs    = new double[3*NumPts*NumOctants];
+     double *Integrands = new double[FDim*NumPts*NumOctants];
+     for(int ncp=0, np=0; ncp<NumPts; ncp++)
+      { double u[2], kBloch[3];
+        u[0] = V1[0] + TCR[3*ncp+0]*(V2[0]-V1[0]) + TCR[3*ncp+1]*(V3[0]-V1[0]);
+        u[1] = V1[1] + TCR[3*ncp+0]*(V2[1]-V1[1]) + TCR[3*ncp+1]*(V3[1]-V1[1]);
+        UTokBloch(Args->RLBasis, u, kBloch);
+        for(int n=0; n<NumOctants; n++, np++)
+         { kBlochs[3*np+2]=0.0;
+           GetOctantImage(kBloch, n, kBlochs + 3*np);
+         };
+      };
+     EvaluateBZBatch(Args, NumPts*NumOctants, kBlochs, Integrands);
+     memset(BZIntegral, 0, FDim*sizeof(double));
+     for(int ncp=0, np=0; ncp<NumPts; ncp++)
+      for(int n=0; n<NumOctants; n++, np++)
+       VecPlusEquals(BZIntegral, J*TCR[3*ncp+2], Integrands + np*FDim, FDim);
+     delete[] kBlochs;
+     delete[] Integrands;
+   };
 
   VecScale(BZIntegral, SymmetryFactor, FDim);
 
 }
 
+/***************************************************************/
+/* adaptive triangle cubature over the irreducible region of   */
+/* the BZ (in reduced coordinates u).                          */
+/*                                                             */
+/* On each refinement level we (a) evaluate the integrand at   */
+/* the cubature points of all newly-created triangles as a     */
+/* single batch, (b) form an integral and error estimate for   */
+/* each triangle by comparing cubature rules of degree 7 and   */
+/* 4, and (c) split every triangle whose error is comparable   */
+/* to the largest per-triangle error into four subtriangles.   */
+/***************************************************************/
+#define ATC_HIGHORDER 7
+#define ATC_LOWORDER  4
+#define ATC_REFINEFRACTION 0.25
+
+typedef struct ATCTriangle
+ { double V[3][2];
+   double *I, *E;
+ } ATCTriangle;
+
+static void AddATCTriangle(ATCTriangle **Triangles, int *NumTriangles,
+                           int *MaxTriangles,
+                           const double *V1, const double *V2, const double *V3)
+{
+  if (*NumTriangles == *MaxTriangles)
+   { *MaxTriangles = (*MaxTriangles==0) ? 16 : 2*(*MaxTriangles);
+     *Triangles = (ATCTriangle *)reallocEC(*Triangles, (*MaxTriangles)*sizeof(ATCTriangle));
+   };
+  ATCTriangle *T = (*Triangles) + (*NumTriangles)++;
+  memcpy(T->V[0], V1, 2*sizeof(double));
+  memcpy(T->V[1], V2, 2*sizeof(double));
+  memcpy(T->V[2], V3, 2*sizeof(double));
+  T->I = T->E = 0;
+}
+
+static void AddATCRectangle(ATCTriangle **Triangles, int *NumTriangles,
+                            int *MaxTriangles,
+                            double x0, double x1, double y0, double y1)
+{
+  double V00[2]={x0,y0}, V10[2]={x1,y0}, V11[2]={x1,y1}, V01[2]={x0,y1};
+  AddATCTriangle(Triangles, NumTriangles, MaxTriangles, V00, V10, V11);
+  AddATCTriangle(Triangles, NumTriangles, MaxTriangles, V00, V11, V01);
+}
+
+void GetBZIntegral_ATC(GetBZIArgStruct *Args, cdouble Omega,
+                       double *BZIntegral)
+{
+  int FDim            = Args->FDim;
+  int SymmetryFactor  = Args->SymmetryFactor;
+  double *BZIError    = Args->DataBuffer[0];
+
+  Args->Omega=Omega;
+
+  if (Args->RLBasis->NC!=2)
+   ErrExit("adaptive triangle BZ integration requires 2D lattices");
+
+  int NumHigh, NumLow;
+  double *TCRHigh = GetTCR(ATC_HIGHORDER, &NumHigh);
+  double *TCRLow  = GetTCR(ATC_LOWORDER,  &NumLow);
+  int PointsPerTriangle = NumHigh + NumLow;
+
+  /*--------------------------------------------------------------*/
+  /*- initial triangulation of the irreducible region, which is  -*/
+  /*- the same region used by the CC scheme                      -*/
+  /*--------------------------------------------------------------*/
+  ATCTriangle *Triangles=0;
+  int NumTriangles=0, MaxTriangles=0;
+  switch(SymmetryFactor)
+   { case 8: 
+      { double V1[2]={0.0,0.0}, V2[2]={0.5,0.0}, V3[2]={0.5,0.5};
+        AddATCTriangle(&Triangles, &NumTriangles, &MaxTriangles, V1, V2, V3);
+      };
+      break;
+     case 4:
+      AddATCRectangle(&Triangles, &NumTriangles, &MaxTriangles, 0.0, 0.5, 0.0, 0.5);
+      break;
+     case 2:
+      AddATCRectangle(&Triangles, &NumTriangles, &MaxTriangles, -0.5, 0.0, 0.0, 0.5);
+      AddATCRectangle(&Triangles, &NumTriangles, &MaxTriangles,  0.0, 0.5, 0.0, 0.5);
+      break;
+     default:
+      AddATCRectangle(&Triangles, &NumTriangles, &MaxTriangles, -0.5, 0.0, -0.5, 0.0);
+      AddATCRectangle(&Triangles, &NumTriangles, &MaxTriangles,  0.0, 0.5, -0.5, 0.0);
+      AddATCRectangle(&Triangles, &NumTriangles, &MaxTriangles, -0.5, 0.0,  0.0, 0.5);
+      AddATCRectangle(&Triangles, &NumTriangles, &MaxTriangles,  0.0, 0.5,  0.0, 0.5);
+      break;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- refinement loop. triangles [FirstNew, NumTriangles) are    -*/
+  /*- the triangles that have not yet been evaluated.            -*/
+  /*--------------------------------------------------------------*/
+  double *kBlochs=0, *Integrands=0;
+  int BufferPoints=0;
+  double *Score = 0;
+  int FirstNew=0;
+  for(int Level=0; ; Level++)
+   { 
+     /*--------------------------------------------------------------*/
+     /*- evaluate integrand at all points of all new triangles      -*/
+     /*--------------------------------------------------------------*/
+     int NumNew    = NumTriangles - FirstNew;
+     int NumPoints = NumNew * PointsPerTriangle;
+     if (NumPoints > BufferPoints)
+      { BufferPoints = NumPoints;
+        kBlochs    = (double *)reallocEC(kBlochs,    3*BufferPoints*sizeof(double));
+        Integrands = (double *)reallocEC(Integrands, FDim*BufferPoints*sizeof(double));
+      };
+     for(int nt=FirstNew, np=0; nt<NumTriangles; nt++)
+      { ATCTriangle *T=Triangles + nt;
+        for(int nr=0; nr<2; nr++)
+         { double *TCR = nr==0 ? TCRHigh : TCRLow;
+           int NumPts  = nr==0 ? NumHigh : NumLow;
+           for(int ncp=0; ncp<NumPts; ncp++, np++)
+            { double u[2];
+              for(int i=0; i<2; i++)
+               u[i] = T->V[0][i] + TCR[3*ncp+0]*(T->V[1][i]-T->V[0][i])
+                                 + TCR[3*ncp+1]*(T->V[2][i]-T->V[0][i]);
+              UTokBloch(Args->RLBasis, u, kBlochs + 3*np);
+            };
+         };
+      };
+     EvaluateBZBatch(Args, NumPoints, kBlochs, Integrands);
+
+     /*--------------------------------------------------------------*/
+     /*- per-triangle integral and error estimates                  -*/
+     /*--------------------------------------------------------------*/
+     for(int nt=FirstNew, np=0; nt<NumTriangles; nt++)
+      { ATCTriangle *T=Triangles + nt;
+        double J = fabs(  (T->V[1][0]-T->V[0][0])*(T->V[2][1]-T->V[0][1])
+                        - (T->V[1][1]-T->V[0][1])*(T->V[2][0]-T->V[0][0]) );
+        T->I = (double *)mallocEC(FDim*sizeof(double));
+        T->E = (double *)mallocEC(FDim*sizeof(double));
+        for(int ncp=0; ncp<NumHigh; ncp++, np++)
+         VecPlusEquals(T->I, J*TCRHigh[3*ncp+2], Integrands + np*FDim, FDim);
+        for(int ncp=0; ncp<NumLow; ncp++, np++)
+         VecPlusEquals(T->E, J*TCRLow[3*ncp+2], Integrands + np*FDim, FDim);
+        for(int nf=0; nf<FDim; nf++)
+         T->E[nf] = fabs(T->I[nf] - T->E[nf]);
+      };
+
+     /*--------------------------------------------------------------*/
+     /*- global integral and error, convergence check               -*/
+     /*--------------------------------------------------------------*/
+     memset(BZIntegral, 0, FDim*sizeof(double));
+     memset(BZIError,   0, FDim*sizeof(double));
+     for(int nt=0; nt<NumTriangles; nt++)
+      { VecPlusEquals(BZIntegral, 1.0, Triangles[nt].I, FDim);
+        VecPlusEquals(BZIError,   1.0, Triangles[nt].E, FDim);
+      };
+
+     bool Converged=true;
+     for(int nf=0; nf<FDim && Converged; nf++)
+      if ( BZIError[nf] > Args->AbsTol && BZIError[nf] > Args->RelTol*fabs(BZIntegral[nf]) )
+       Converged=false;
+     if (Converged)
+      break;
+
+     /*--------------------------------------------------------------*/
+     /*- score each triangle by its error relative to the tolerance -*/
+     /*- and select those within ATC_REFINEFRACTION of the worst    -*/
+     /*--------------------------------------------------------------*/
+     Score = (double *)reallocEC(Score, NumTriangles*sizeof(double));
+     double MaxScore=0.0;
+     for(int nt=0; nt<NumTriangles; nt++)
+      { Score[nt]=0.0;
+        for(int nf=0; nf<FDim; nf++)
+         { double Tol = fmax(Args->AbsTol, Args->RelTol*fabs(BZIntegral[nf]));
+           if (Tol>0.0)
+            Score[nt] = fmax(Score[nt], Triangles[nt].E[nf] / Tol);
+         };
+        MaxScore = fmax(MaxScore, Score[nt]);
+      };
+     int NumRefine=0;
+     for(int nt=0; nt<NumTriangles; nt++)
+      if ( Score[nt] >= ATC_REFINEFRACTION*MaxScore )
+       NumRefine++;
+
+     if ( Args->NumCalls + 4*NumRefine*PointsPerTriangle > Args->MaxEvals )
+      { Warn("adaptive BZ integration at Omega=%s unconverged after %i points",
+              z2s(Omega),Args->NumCalls);
+        break;
+      };
+
+     /*--------------------------------------------------------------*/
+     /*- split selected triangles into four subtriangles, which are -*/
+     /*- appended to the list; the parents are marked (I==0) and    -*/
+     /*- then removed, leaving the new triangles contiguous at the  -*/
+     /*- end of the list.                                           -*/
+     /*--------------------------------------------------------------*/
+     FirstNew=NumTriangles;
+     int NumOld=NumTriangles;
+     for(int nt=0; nt<NumOld; nt++)
+      { 
+        if ( Score[nt] < ATC_REFINEFRACTION*MaxScore )
+         continue;
+
+        double V[3][2], M[3][2];
+        memcpy(V, Triangles[nt].V, 6*sizeof(double));
+        for(int i=0; i<2; i++)
+         { M[0][i] = 0.5*(V[0][i] + V[1][i]);
+           M[1][i] = 0.5*(V[1][i] + V[2][i]);
+           M[2][i] = 0.5*(V[2][i] + V[0][i]);
+         };
+
+        free(Triangles[nt].I);
+        free(Triangles[nt].E);
+        AddATCTriangle(&Triangles, &NumTriangles, &MaxTriangles, V[0], M[0], M[2]);
+        AddATCTriangle(&Triangles, &NumTriangles, &MaxTriangles, M[0], V[1], M[1]);
+        AddATCTriangle(&Triangles, &NumTriangles, &MaxTriangles, M[2], M[1], V[2]);
+        AddATCTriangle(&Triangles, &NumTriangles, &MaxTriangles, M[0], M[1], M[2]);
+        Triangles[nt].I = Triangles[nt].E = 0;
+      };
+
+     int ntNew=0;
+     for(int nt=0; nt<NumTriangles; nt++)
+      { if (nt<NumOld && Triangles[nt].I==0)
+         continue;
+        if (nt==FirstNew)
+         FirstNew=ntNew;
+        Triangles[ntNew++] = Triangles[nt];
+      };
+     NumTriangles=ntNew;
+
+     Log("ATC level %i: %i triangles, %i refined, %i calls",
+          Level,NumTriangles,NumRefine,Args->NumCalls);
+   };
+
+  VecScale(BZIntegral, SymmetryFactor, FDim);
+  VecScale(BZIError,   SymmetryFactor, FDim);
+
+  for(int nt=0; nt<NumTriangles; nt++)
+   { free(Triangles[nt].I);
+     free(Triangles[nt].E);
+   };
+  free(Triangles);
+  free(kBlochs);
+  free(Integrands);
+  free(Score);
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -540,6 +951,10 @@ void GetBZIntegral(GetBZIArgStruct *Args, cdouble Omega,
       GetBZIntegral_Polar(Args, Omega, BZIntegral);
       break;
 
+     case BZI_ATC:
+      GetBZIntegral_ATC(Args, Omega, BZIntegral);
+      break;
+
      default:
       ErrExit("unknown BZIMethod in GetBZIntegral");
    };
@@ -629,16 +1044,17 @@ HMatrix *GetRLBasis(HMatrix *LBasis,
 /***************************************************************/
 const char *BZIOptionsString=
  "\n options controlling Brillouin-zone integration: \n\n"
- "  --BZIMethod   [CC | TC | Polar]\n"
+ "  --BZIMethod   [CC | TC | Polar | ATC]\n"
  "  --BZIOrder    xx \n"
  "  --BZIRelTol   xx \n"
  "  --BZIMaxEvals xx \n"
- "  --BZSymmetryFactor [1|2|4|8]\n"
+ "  --BZSymmetryFactor [1|2|4|8|auto]\n"
  "\n"
  "   allowed values for --BZIOrder: \n"
  "   CC: [0|11|13|...|99]\n"
  "   TC: [1|2|4|5|7|9|13|14|16|20|25]\n"
  "   Polar: 100*M + N, M=N=[11|13|...|99]\n"
+ "   ATC: (adaptive triangle cubature; order ignored)\n"
  "\n";
 
 /***************************************************************/
@@ -676,6 +1092,7 @@ GetBZIArgStruct *InitBZIArgs(int argc, char **argv)
   GetBZIArgStruct *BZIArgs = (GetBZIArgStruct *)mallocEC(sizeof(*BZIArgs));
 
   BZIArgs->BZIFunc=0;
+  BZIArgs->BZIFunc_v=0;
   BZIArgs->UserData=0;
   BZIArgs->FDim=0;
   BZIArgs->RLBasis=0;
@@ -706,7 +1123,9 @@ GetBZIArgStruct *InitBZIArgs(int argc, char **argv)
       { 
         if (Option==0) 
          ErrExit("--BZSymmetryFactor requires an argument");
-        if ( 1!=sscanf(Option,"%i",&(BZIArgs->SymmetryFactor))
+        if (!strcasecmp(Option,"auto"))
+         BZIArgs->SymmetryFactor = BZI_SYMMETRY_AUTO;
+        else if ( 1!=sscanf(Option,"%i",&(BZIArgs->SymmetryFactor))
             ||  (    (BZIArgs->SymmetryFactor != 1)
                   && (BZIArgs->SymmetryFactor != 2)
                   && (BZIArgs->SymmetryFactor != 4)
@@ -731,6 +1150,8 @@ GetBZIArgStruct *InitBZIArgs(int argc, char **argv)
          BZIArgs->BZIMethod = BZI_POLAR;
         else if (!strcasecmp(Option,"Polar2"))
          BZIArgs->BZIMethod = BZI_POLAR2;
+        else if (!strcasecmp(Option,"ATC"))
+         BZIArgs->BZIMethod = BZI_ATC;
         else
          ErrExit("unknown BZIMethod %s",Option);
         argv[narg]=argv[narg+1]=0;
@@ -794,6 +1215,34 @@ bool LatticeIsSquare(HMatrix *LBasis)
   return ( EqualFloat(LXX,LYY) && LXY==0.0 && LYX==0.0 );
 }
 
+/***************************************************************/
+/* deduce the largest BZ symmetry factor supported by the      */
+/* point symmetry of the reciprocal lattice:                   */
+/*  1D lattices:                         2  (k -> -k)          */
+/*  2D oblique lattices:                 2  (k -> -k)          */
+/*  2D rectangular lattices:             4  (kx->-kx, ky->-ky) */
+/*  2D square lattices:                  8  (also kx <-> ky)   */
+/* note that this assumes the contents of the unit cell share  */
+/* the point symmetry of the lattice.                          */
+/***************************************************************/
+int GetLatticeSymmetryFactor(HMatrix *RLBasis)
+{
+  if (RLBasis->NC!=2)
+   return 2;
+
+  double B1[3], B2[3];
+  for(int nc=0; nc<3; nc++)
+   { B1[nc]=RLBasis->GetEntryD(nc,0);
+     B2[nc]=RLBasis->GetEntryD(nc,1);
+   };
+  double N1=VecNorm(B1), N2=VecNorm(B2);
+  if ( fabs(VecDot(B1,B2)) > 1.0e-8*N1*N2 )
+   return 2;
+  if ( EqualFloat(N1,N2) )
+   return 8;
+  return 4;
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -802,6 +1251,18 @@ void UpdateBZIArgs(GetBZIArgStruct *Args,
 {
   Args->RLBasis         = RLBasis;
   Args->BZVolume        = RLVolume;
+
+  if (Args->SymmetryFactor==BZI_SYMMETRY_AUTO)
+   { Args->SymmetryFactor = GetLatticeSymmetryFactor(RLBasis);
+     Log("Using BZ symmetry factor %i deduced from lattice "
+         "(assumes unit-cell contents share lattice symmetry)",
+          Args->SymmetryFactor);
+   };
+  
+  if ( Args->BZIMethod==BZI_ATC && RLBasis->NC!=2 )
+   { Warn("BZ integration scheme ATC is only for 2D lattices (switching to default)");
+     Args->BZIMethod = BZI_DEFAULT;
+   };
   
   if (    (Args->BZIMethod==BZI_TC || Args->BZIMethod==BZI_POLAR || Args->BZIMethod==BZI_POLAR2)
        && !LatticeIsSquare(RLBasis)
@@ -826,5 +1287,8 @@ void UpdateBZIArgs(GetBZIArgStruct *Args,
   else if (Args->BZIMethod==BZI_POLAR2)
    LogC("polar cubature 2, radial order %i, angular order %i}",
          Args->Order/100, Args->Order%100);
+  else if (Args->BZIMethod==BZI_ATC)
+   LogC("adaptive triangle cubature (reltol %g, max evals %i)",
+         Args->RelTol, Args->MaxEvals);
 
 }
@@ -35,6 +35,11 @@
 #define BZI_TC       2
 #define BZI_POLAR    3
 #define BZI_POLAR2   4
+#define BZI_ATC      5
+
+// value of SymmetryFactor requesting that the symmetry factor
+// be deduced from the reciprocal lattice in UpdateBZIArgs()
+#define BZI_SYMMETRY_AUTO 0
 
 // default parameters for adaptive integration
 #define DEF_BZIMAXEVALS 1000    // max # brillouin-zone samples
@@ -48,6 +53,19 @@ typedef void (*BZIFunction)(void *UserData,
                             cdouble Omega, double *kBloch,
                             double *BZIntegrand);
 
+/***************************************************************/
+/* optional batched version of the BZ integrand: on input,     */
+/* kBlochs[3*np + i] is the ith cartesian component of the     */
+/* npth of NumPoints Bloch vectors; on output,                 */
+/* BZIntegrands[np*FDim + nf] must be the nfth integrand       */
+/* component at that point. The integrator hands all points    */
+/* needed at a given refinement level to this routine at once, */
+/* so the caller is free to evaluate them concurrently.        */
+/***************************************************************/
+typedef void (*BZIFunction_v)(void *UserData, cdouble Omega,
+                              int NumPoints, double *kBlochs,
+                              double *BZIntegrands);
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -55,9 +73,10 @@ typedef struct GetBZIArgStruct
 {
   // information on the Brillouin-zone integrand function
   BZIFunction BZIFunc;
+  BZIFunction_v BZIFunc_v; // optional; if 0, BZIFunc is called pointwise
   void *UserData;
   int FDim;            // number of doubles in the integrand vector
-  int SymmetryFactor;  // either 1, 2, 4, or 8
+  int SymmetryFactor;  // either 1, 2, 4, or 8 (or BZI_SYMMETRY_AUTO)
 
   // information on the lattice geometry
   // RLBasis = "reciprocal lattice basis"
@@ -99,6 +118,8 @@ void UpdateBZIArgs(GetBZIArgStruct *BZIArgs, HMatrix *RLBasis,
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
+int GetLatticeSymmetryFactor(HMatrix *RLBasis);
+
 HMatrix *GetRLBasis(HMatrix *LBasis,
                     double *pLVolume,
                     double *pRLVolume);
@@ -0,0 +1,552 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * DMatrix.cc  -- dense complex matrices distributed over the ranks
+ *             -- of an MPI job in 2D block-cyclic fashion, with
+ *             -- distributed LU factorization and solve
+ *
+ * The factorization is the standard right-looking blocked algorithm
+ * used by ScaLAPACK's PZGETRF: for each block column k,
+ *
+ *  (a) the process column owning block column k factors the panel
+ *      (all rows below the diagonal) with partial pivoting, finding
+ *      each pivot by a reduction over the process column;
+ *  (b) the pivots are broadcast and the corresponding row swaps are
+ *      applied to all other columns;
+ *  (c) the L panel is broadcast along process rows, the process row
+ *      owning block row k computes the U block row by a triangular
+ *      solve and broadcasts it down process columns;
+ *  (d) every rank updates its part of the trailing submatrix with a
+ *      single ZGEMM.
+ *
+ * The triangular solves in LUSolve() work on right-hand sides that
+ * are replicated on all ranks; for each diagonal block the partial
+ * products of the off-diagonal blocks are summed over the owning
+ * process row and the solved block is broadcast to all ranks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libhrutil.h>
+
+extern "C" {
+ #include "lapack.h"
+}
+
+#include "libhmat.h"
+
+#ifdef HAVE_MPI
+#  include <mpi.h>
+#endif
+
+#define DEF_DMATRIX_NB 64
+
+#ifdef HAVE_MPI
+
+/***************************************************************/
+/* MPI housekeeping ********************************************/
+/***************************************************************/
+void InitMPI(int *argc, char ***argv)
+{
+  int Initialized;
+  MPI_Initialized(&Initialized);
+  if (Initialized)
+   return;
+
+  // only the main thread makes MPI calls; OpenMP threads are
+  // used for work within each rank
+  int Provided;
+  MPI_Init_thread(argc, argv, MPI_THREAD_FUNNELED, &Provided);
+}
+
+void FinalizeMPI()
+{
+  int Initialized, Finalized;
+  MPI_Initialized(&Initialized);
+  MPI_Finalized(&Finalized);
+  if (Initialized && !Finalized)
+   MPI_Finalize();
+}
+
+int GetMPIRank()
+{
+  int Initialized, Rank=0;
+  MPI_Initialized(&Initialized);
+  if (Initialized)
+   MPI_Comm_rank(MPI_COMM_WORLD, &Rank);
+  return Rank;
+}
+
+int GetMPISize()
+{
+  int Initialized, Size=1;
+  MPI_Initialized(&Initialized);
+  if (Initialized)
+   MPI_Comm_size(MPI_COMM_WORLD, &Size);
+  return Size;
+}
+
+/***************************************************************/
+/* communicators: World has rank MyPRow*NPCol + MyPCol, RowComm */
+/* contains the ranks in my process row (rank = MyPCol), and    */
+/* ColComm contains the ranks in my process column (rank =      */
+/* MyPRow).                                                    */
+/***************************************************************/
+typedef struct DMComms
+ { MPI_Comm RowComm, ColComm;
+ } DMComms;
+
+#define ROWCOMM(D) (((DMComms *)((D)->Comms))->RowComm)
+#define COLCOMM(D) (((DMComms *)((D)->Comms))->ColComm)
+
+// complex numbers are sent as pairs of doubles
+static void BcastZ(cdouble *Buffer, int Count, int Root, MPI_Comm Comm)
+{ MPI_Bcast((void *)Buffer, 2*Count, MPI_DOUBLE, Root, Comm); }
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+DMatrix::DMatrix(int NRows, int NCols, int pNB)
+{
+  int Initialized;
+  MPI_Initialized(&Initialized);
+  if (!Initialized)
+   ErrExit("%s:%i: InitMPI() must be called before creating a DMatrix",__FILE__,__LINE__);
+
+  NR = NRows;
+  NC = NCols;
+  NB = (pNB>0) ? pNB : DEF_DMATRIX_NB;
+
+  /*--------------------------------------------------------------*/
+  /*- choose the most nearly square process grid with NPRow<=NPCol*/
+  /*--------------------------------------------------------------*/
+  int Rank, Size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &Rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &Size);
+  NPRow = (int)floor(sqrt((double)Size));
+  while( Size%NPRow )
+   NPRow--;
+  NPCol  = Size/NPRow;
+  MyPRow = Rank / NPCol;
+  MyPCol = Rank % NPCol;
+
+  DMComms *C = (DMComms *)mallocEC(sizeof(DMComms));
+  MPI_Comm_split(MPI_COMM_WORLD, MyPRow, MyPCol, &(C->RowComm));
+  MPI_Comm_split(MPI_COMM_WORLD, MyPCol, MyPRow, &(C->ColComm));
+  Comms = (void *)C;
+
+  NRLocal = LocalRowStart(NR);
+  NCLocal = LocalColStart(NC);
+  Local   = new HMatrix(NRLocal, NCLocal, LHM_COMPLEX);
+  ipiv    = 0;
+}
+
+DMatrix::~DMatrix()
+{
+  DMComms *C = (DMComms *)Comms;
+  MPI_Comm_free(&(C->RowComm));
+  MPI_Comm_free(&(C->ColComm));
+  free(C);
+  delete Local;
+  if (ipiv) free(ipiv);
+}
+
+/***************************************************************/
+/* number of local rows whose global index is less than nr.    */
+/***************************************************************/
+static int CountLocal(int n, int NB, int NP, int MyP)
+{
+  int nb    = n/NB;                   // block containing index n
+  int Count = ((nb + NP - 1 - MyP)/NP)*NB; // full blocks before it
+  if ( nb%NP == MyP )
+   Count += n%NB;
+  return Count;
+}
+
+int DMatrix::LocalRowStart(int nr)
+ { return CountLocal(nr, NB, NPRow, MyPRow); }
+
+int DMatrix::LocalColStart(int nc)
+ { return CountLocal(nc, NB, NPCol, MyPCol); }
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void DMatrix::Zero()
+{ Local->Zero(); }
+
+void DMatrix::SetEntry(int nr, int nc, cdouble Entry)
+{
+  if (IsLocal(nr,nc))
+   Local->SetEntry(LocalRow(nr), LocalCol(nc), Entry);
+}
+
+cdouble DMatrix::GetEntry(int nr, int nc)
+{
+  if (!IsLocal(nr,nc))
+   ErrExit("%s:%i: entry (%i,%i) is not stored on this rank",__FILE__,__LINE__,nr,nc);
+  return Local->GetEntry(LocalRow(nr), LocalCol(nc));
+}
+
+void DMatrix::Distribute(HMatrix *M)
+{
+  if (M->NR!=NR || M->NC!=NC)
+   ErrExit("%s:%i: dimension mismatch",__FILE__,__LINE__);
+  for(int lc=0; lc<NCLocal; lc++)
+   for(int lr=0; lr<NRLocal; lr++)
+    Local->SetEntry(lr, lc, M->GetEntry(GlobalRow(lr), GlobalCol(lc)));
+}
+
+HMatrix *DMatrix::Gather(HMatrix *M)
+{
+  M=CheckHMatrix(M, NR, NC, LHM_COMPLEX, "DMatrix::Gather");
+  M->Zero();
+  for(int lc=0; lc<NCLocal; lc++)
+   for(int lr=0; lr<NRLocal; lr++)
+    M->SetEntry(GlobalRow(lr), GlobalCol(lc), Local->GetEntry(lr,lc));
+  MPI_Allreduce(MPI_IN_PLACE, (void *)M->ZM, 2*NR*NC, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  return M;
+}
+
+/***************************************************************/
+/* swap global rows r1 and r2 within local columns [lc0,lc1).  */
+/* called by all ranks in a process column; only the (one or   */
+/* two) process rows owning r1 and r2 do anything.             */
+/***************************************************************/
+void DMatrix::SwapRows(int r1, int r2, int lc0, int lc1,
+                       cdouble *SendBuf, cdouble *RecvBuf)
+{
+  if (r1==r2 || lc1<=lc0) return;
+
+  int Owner1 = RowOwner(r1), Owner2 = RowOwner(r2);
+  if (MyPRow!=Owner1 && MyPRow!=Owner2)
+   return;
+
+  cdouble *ZM = Local->ZM;
+  int LD      = NRLocal;
+  int N       = lc1-lc0;
+
+  if (Owner1==Owner2)
+   { int lr1=LocalRow(r1), lr2=LocalRow(r2);
+     for(int lc=lc0; lc<lc1; lc++)
+      { cdouble Temp    = ZM[lr1 + lc*LD];
+        ZM[lr1 + lc*LD] = ZM[lr2 + lc*LD];
+        ZM[lr2 + lc*LD] = Temp;
+      };
+     return;
+   };
+
+  int MyRow   = (MyPRow==Owner1) ? r1 : r2;
+  int Partner = (MyPRow==Owner1) ? Owner2 : Owner1;
+  int lr      = LocalRow(MyRow);
+  for(int lc=lc0; lc<lc1; lc++)
+   SendBuf[lc-lc0] = ZM[lr + lc*LD];
+  MPI_Sendrecv( (void *)SendBuf, 2*N, MPI_DOUBLE, Partner, 0,
+                (void *)RecvBuf, 2*N, MPI_DOUBLE, Partner, 0,
+                COLCOMM(this), MPI_STATUS_IGNORE);
+  for(int lc=lc0; lc<lc1; lc++)
+   ZM[lr + lc*LD] = RecvBuf[lc-lc0];
+}
+
+/***************************************************************/
+/* distributed LU factorization; returns 0 on success, or j+1  */
+/* if U(j,j) is exactly zero, as for ZGETRF.                   */
+/***************************************************************/
+int DMatrix::LUFactorize()
+{
+  if (NR!=NC)
+   ErrExit("%s:%i: LUFactorize requires a square matrix",__FILE__,__LINE__);
+
+  if (ipiv==0)
+   ipiv=(int *)mallocEC(NR*sizeof(int));
+
+  int N       = NR;
+  cdouble *ZM = Local->ZM;
+  int LD      = NRLocal>0 ? NRLocal : 1;
+  int info    = 0;
+
+  int MaxLocal   = NRLocal > NCLocal ? NRLocal : NCLocal;
+  cdouble *LBuf  = (cdouble *)mallocEC( (NRLocal*NB + 1)*sizeof(cdouble) );
+  cdouble *UBuf  = (cdouble *)mallocEC( (NCLocal*NB + 1)*sizeof(cdouble) );
+  cdouble *PivRow= (cdouble *)mallocEC( (NB+1)*sizeof(cdouble) );
+  cdouble *Buf1  = (cdouble *)mallocEC( (MaxLocal+1)*sizeof(cdouble) );
+  cdouble *Buf2  = (cdouble *)mallocEC( (MaxLocal+1)*sizeof(cdouble) );
+
+  cdouble MinusOne=-1.0, One=1.0;
+
+  for(int j0=0; j0<N; j0+=NB)
+   {
+     int j1   = (j0+NB < N) ? j0+NB : N;
+     int w    = j1-j0;
+     int pr   = RowOwner(j0);
+     int pc   = ColOwner(j0);
+     int lrS  = LocalRowStart(j0);   // first local row at or below block row
+     int lcT  = LocalColStart(j1);   // first local trailing column
+     int ncT  = NCLocal - lcT;
+     int lc0  = (MyPCol==pc) ? LocalCol(j0) : 0;
+
+     /*--------------------------------------------------------------*/
+     /*- (a) panel factorization by the owning process column       -*/
+     /*--------------------------------------------------------------*/
+     if (MyPCol==pc)
+      for(int j=j0; j<j1; j++)
+       {
+         int lc = lc0 + (j-j0);
+
+         struct { double Value; int Index; } MyMax, Max;
+         MyMax.Value = -1.0;
+         MyMax.Index = N;
+         for(int lr=LocalRowStart(j); lr<NRLocal; lr++)
+          { double a = abs(ZM[lr + lc*LD]);
+            if (a > MyMax.Value)
+             { MyMax.Value = a;
+               MyMax.Index = GlobalRow(lr);
+             };
+          };
+         MPI_Allreduce(&MyMax, &Max, 1, MPI_DOUBLE_INT, MPI_MAXLOC, COLCOMM(this));
+
+         int p = Max.Index;
+         if (Max.Value==0.0)
+          { if (info==0) info=j+1;
+            p=j;
+          };
+         ipiv[j]=p;
+
+         SwapRows(j, p, lc0, lc0+w, Buf1, Buf2);
+
+         // pivot row, panel columns j..j1-1, to the whole process column
+         if (MyPRow==RowOwner(j))
+          for(int c=j; c<j1; c++)
+           PivRow[c-j] = ZM[ LocalRow(j) + (lc0+c-j0)*LD ];
+         BcastZ(PivRow, j1-j, RowOwner(j), COLCOMM(this));
+
+         if (PivRow[0]==0.0)
+          continue;
+
+         for(int lr=LocalRowStart(j+1); lr<NRLocal; lr++)
+          { cdouble l = ZM[lr + lc*LD] / PivRow[0];
+            ZM[lr + lc*LD] = l;
+            for(int c=j+1; c<j1; c++)
+             ZM[lr + (lc0+c-j0)*LD] -= l*PivRow[c-j];
+          };
+       };
+
+     /*--------------------------------------------------------------*/
+     /*- (b) share pivots, apply row swaps outside the panel        -*/
+     /*--------------------------------------------------------------*/
+     MPI_Bcast(ipiv + j0, w, MPI_INT, pc, MPI_COMM_WORLD);
+     for(int j=j0; j<j1; j++)
+      { if (MyPCol==pc)
+         { SwapRows(j, ipiv[j], 0, lc0, Buf1, Buf2);
+           SwapRows(j, ipiv[j], lc0+w, NCLocal, Buf1, Buf2);
+         }
+        else
+         SwapRows(j, ipiv[j], 0, NCLocal, Buf1, Buf2);
+      };
+     MPI_Allreduce(MPI_IN_PLACE, &info, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+     /*--------------------------------------------------------------*/
+     /*- (c) broadcast L panel along process rows                   -*/
+     /*--------------------------------------------------------------*/
+     int nrP = NRLocal - lrS;
+     if (MyPCol==pc)
+      for(int c=0; c<w; c++)
+       memcpy(LBuf + c*nrP, ZM + lrS + (lc0+c)*LD, nrP*sizeof(cdouble));
+     if (NPCol>1 && nrP>0)
+      BcastZ(LBuf, nrP*w, pc, ROWCOMM(this));
+
+     /*--------------------------------------------------------------*/
+     /*- U block row: U12 = L11 \ A12, broadcast down columns       -*/
+     /*--------------------------------------------------------------*/
+     if (ncT>0)
+      { if (MyPRow==pr)
+         { int ldL = nrP;
+           ztrsm_("L", "L", "N", "U", &w, &ncT, &One, LBuf, &ldL,
+                  ZM + lrS + lcT*LD, &LD);
+           for(int c=0; c<ncT; c++)
+            memcpy(UBuf + c*w, ZM + lrS + (lcT+c)*LD, w*sizeof(cdouble));
+         };
+        if (NPRow>1)
+         BcastZ(UBuf, w*ncT, pr, COLCOMM(this));
+      };
+
+     /*--------------------------------------------------------------*/
+     /*- (d) trailing update A22 -= L21*U12                         -*/
+     /*--------------------------------------------------------------*/
+     int lrT = LocalRowStart(j1);
+     int nrT = NRLocal - lrT;
+     if (nrT>0 && ncT>0)
+      { int ldL = nrP;
+        zgemm_("N", "N", &nrT, &ncT, &w, &MinusOne, LBuf + (lrT-lrS), &ldL,
+               UBuf, &w, &One, ZM + lrT + lcT*LD, &LD);
+      };
+   };
+
+  free(LBuf);
+  free(UBuf);
+  free(PivRow);
+  free(Buf1);
+  free(Buf2);
+
+  return info;
+}
+
+/***************************************************************/
+/* solve A*X=B for replicated right-hand sides B (overwritten  */
+/* by X on all ranks)                                          */
+/***************************************************************/
+int DMatrix::LUSolve(HMatrix *X)
+{
+  if (ipiv==0)
+   ErrExit("LUFactorize() must be called before LUSolve()");
+  if (X->NR!=NR || X->RealComplex!=LHM_COMPLEX)
+   ErrExit("%s:%i: invalid right-hand side in DMatrix::LUSolve",__FILE__,__LINE__);
+
+  int N       = NR;
+  int NRHS    = X->NC;
+  cdouble *ZM = Local->ZM;
+  int LD      = NRLocal>0 ? NRLocal : 1;
+  cdouble *B  = X->ZM;
+  int LDB     = X->NR;
+
+  // XLocal[lc + nrhs*NCLocal] is row GlobalCol(lc) of the solution
+  // computed so far, packed to match the local matrix columns
+  cdouble *XLocal = (cdouble *)mallocEC( (NCLocal*NRHS + 1)*sizeof(cdouble) );
+  cdouble *S      = (cdouble *)mallocEC( (NB*NRHS + 1)*sizeof(cdouble) );
+  cdouble Zero=0.0, One=1.0;
+
+  /*--------------------------------------------------------------*/
+  /*- apply row interchanges ---------------------------------------*/
+  /*--------------------------------------------------------------*/
+  for(int j=0; j<N; j++)
+   if (ipiv[j]!=j)
+    for(int nc=0; nc<NRHS; nc++)
+     { cdouble Temp          = B[j + nc*LDB];
+       B[j + nc*LDB]         = B[ipiv[j] + nc*LDB];
+       B[ipiv[j] + nc*LDB]   = Temp;
+     };
+
+  /*--------------------------------------------------------------*/
+  /*- forward (L) and backward (U) substitution, one block at a  -*/
+  /*- time                                                       -*/
+  /*--------------------------------------------------------------*/
+  int NumBlocks = (N + NB - 1)/NB;
+  for(int Pass=0; Pass<2; Pass++)
+   {
+     bool Lower = (Pass==0);
+     memset(XLocal, 0, NCLocal*NRHS*sizeof(cdouble));
+
+     for(int nbk=0; nbk<NumBlocks; nbk++)
+      {
+        int k   = Lower ? nbk : NumBlocks-1-nbk;
+        int j0  = k*NB;
+        int j1  = (j0+NB < N) ? j0+NB : N;
+        int w   = j1-j0;
+        int pr  = RowOwner(j0);
+        int pc  = ColOwner(j0);
+
+        /*- partial sums of the off-diagonal blocks over my columns -*/
+        if (MyPRow==pr)
+         { int lr0 = LocalRow(j0);
+           int lcA = Lower ? 0 : LocalColStart(j1);
+           int lcB = Lower ? LocalColStart(j0) : NCLocal;
+           int K   = lcB - lcA;
+           memset(S, 0, w*NRHS*sizeof(cdouble));
+           if (K>0)
+            zgemm_("N", "N", &w, &NRHS, &K, &One, ZM + lr0 + lcA*LD, &LD,
+                   XLocal + lcA, &NCLocal, &Zero, S, &w);
+           if (NPCol>1)
+            { if (MyPCol==pc)
+               MPI_Reduce(MPI_IN_PLACE, (void *)S, 2*w*NRHS, MPI_DOUBLE, MPI_SUM, pc, ROWCOMM(this));
+              else
+               MPI_Reduce((void *)S, 0, 2*w*NRHS, MPI_DOUBLE, MPI_SUM, pc, ROWCOMM(this));
+            };
+
+           /*- diagonal-block solve on the owner -*/
+           if (MyPCol==pc)
+            { for(int nc=0; nc<NRHS; nc++)
+               for(int j=0; j<w; j++)
+                S[j + nc*w] = B[j0 + j + nc*LDB] - S[j + nc*w];
+              int lc0 = LocalCol(j0);
+              ztrsm_("L", Lower ? "L" : "U", "N", Lower ? "U" : "N",
+                     &w, &NRHS, &One, ZM + lr0 + lc0*LD, &LD, S, &w);
+            };
+         };
+
+        BcastZ(S, w*NRHS, pr*NPCol + pc, MPI_COMM_WORLD);
+        for(int nc=0; nc<NRHS; nc++)
+         for(int j=0; j<w; j++)
+          B[j0 + j + nc*LDB] = S[j + nc*w];
+
+        if (MyPCol==pc)
+         { int lc0 = LocalCol(j0);
+           for(int nc=0; nc<NRHS; nc++)
+            for(int j=0; j<w; j++)
+             XLocal[lc0 + j + nc*NCLocal] = S[j + nc*w];
+         };
+      };
+   };
+
+  free(XLocal);
+  free(S);
+  return 0;
+}
+
+int DMatrix::LUSolve(HVector *X)
+{
+  if (X->RealComplex!=LHM_COMPLEX)
+   ErrExit("%s:%i: invalid right-hand side in DMatrix::LUSolve",__FILE__,__LINE__);
+  HMatrix XMatrix(X->N, 1, X->ZV);
+  return LUSolve(&XMatrix);
+}
+
+#else // HAVE_MPI
+
+/***************************************************************/
+/* stubs for builds without MPI support ************************/
+/***************************************************************/
+static void NoMPI()
+{ ErrExit("distributed matrices require scuff-em to be configured --with-mpi"); }
+
+void InitMPI(int *argc, char ***argv) { (void) argc; (void) argv; }
+void FinalizeMPI() {}
+int GetMPIRank() { return 0; }
+int GetMPISize() { return 1; }
+
+DMatrix::DMatrix(int NRows, int NCols, int pNB)
+ { (void) NRows; (void) NCols; (void) pNB; NoMPI(); }
+DMatrix::~DMatrix() {}
+int DMatrix::LocalRowStart(int nr) { (void) nr; NoMPI(); return 0; }
+int DMatrix::LocalColStart(int nc) { (void) nc; NoMPI(); return 0; }
+void DMatrix::Zero() { NoMPI(); }
+void DMatrix::SetEntry(int nr, int nc, cdouble Entry)
+ { (void) nr; (void) nc; (void) Entry; NoMPI(); }
+cdouble DMatrix::GetEntry(int nr, int nc)
+ { (void) nr; (void) nc; NoMPI(); return 0.0; }
+void DMatrix::Distribute(HMatrix *M) { (void) M; NoMPI(); }
+HMatrix *DMatrix::Gather(HMatrix *M) { NoMPI(); return M; }
+int DMatrix::LUFactorize() { NoMPI(); return 0; }
+int DMatrix::LUSolve(HMatrix *X) { (void) X; NoMPI(); return 0; }
+int DMatrix::LUSolve(HVector *X) { (void) X; NoMPI(); return 0; }
+
+#endif // HAVE_MPI
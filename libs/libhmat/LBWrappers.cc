@@ -150,6 +150,7 @@ void HMatrix::GetMatrixProductDiagonal(HMatrix *B, HVector *DAB)
 /***************************************************************/
 int HMatrix::LUFactorize()
 { 
+  ProfileTimer PT("LUFactorize(%ix%i)",NR,NC);
   int info;
 
   if (ipiv==0)
@@ -174,6 +175,7 @@ int HMatrix::LUFactorize()
 /***************************************************************/
 int HMatrix::LUSolve(HVector *X)
 { 
+  ProfileTimer PT("LUSolve");
   int info;
   int iOne=1;
 
@@ -207,6 +209,7 @@ int HMatrix::LUSolve(HVector *X)
 /***************************************************************/
 int HMatrix::LUSolve(HMatrix *X, char Trans, int nrhs)
 { 
+  ProfileTimer PT("LUSolve");
   int info;
 
   if ( RealComplex != X->RealComplex )
@@ -250,6 +253,7 @@ int HMatrix::LUSolve(HMatrix *X)
 /***************************************************************/
 int HMatrix::LUInvert()
 { 
+  ProfileTimer PT("LUInvert");
   int info;
   double *dwork;
   cdouble *zwork;
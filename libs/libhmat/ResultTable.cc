@@ -0,0 +1,654 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * ResultTable.cc -- append-only columnar tables of computed results
+ *                -- in binary HDF5 files
+ *
+ * --------------------------------------------------------------
+ *
+ * file layout: the root group of the HDF5 file contains one 1D
+ * dataset per column, all of the same length (the number of rows):
+ *
+ *   Tag                 fixed-length strings (RT_TAGLEN bytes)
+ *   <KeyName0>, ...     doubles
+ *   <ValueName0>, ...   doubles
+ *
+ * the datasets are chunked (RT_CHUNKROWS rows per chunk), extensible,
+ * and deflate-compressed, and the root group carries the integer
+ * attributes NumKeys and NumValues. the order of the columns is
+ * recorded in the string attribute Columns (column names separated
+ * by spaces). the files can be read directly by h5py, MATLAB, etc.
+ *
+ * --------------------------------------------------------------
+ *
+ * usage:
+ *
+ *   const char *KeyNames[3]  ={"Omega", "kx", "ky"};
+ *   const char *ValueNames[2]={"PAbs", "Fz"};
+ *   ResultTable *RT=new ResultTable("MyFile.h5", 3, KeyNames, 2, ValueNames);
+ *
+ *   RT->Append("DEFAULT", Keys, Values);            // from any thread
+ *   if ( RT->Lookup("DEFAULT", Keys, Values) ) ...  // constant time
+ *
+ *   delete RT;  // flushes buffered rows and closes the file
+ *
+ *   RT=new ResultTable("MyFile.h5");  // columns read from the file
+ *   RT->ExportToText("MyFile.dat");
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <libhrutil.h>
+#include "libhmat.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int GetResultFormat()
+{
+  static int Format=0;
+  if (Format) return Format;
+
+  int NewFormat=RESULT_FORMAT_TEXT;
+  char *s=getenv("SCUFF_OUTPUT_FORMAT");
+  if (s)
+   { if (!StrCaseCmp(s,"hdf5"))
+      NewFormat=RESULT_FORMAT_HDF5;
+     else if (!StrCaseCmp(s,"both"))
+      NewFormat=RESULT_FORMAT_TEXT | RESULT_FORMAT_HDF5;
+     else if (StrCaseCmp(s,"text"))
+      Warn("unknown SCUFF_OUTPUT_FORMAT %s (using text)",s);
+   };
+
+#ifndef HAVE_HDF5
+  if (NewFormat & RESULT_FORMAT_HDF5)
+   { Warn("compiled without HDF5 support (writing text output files)");
+     NewFormat=RESULT_FORMAT_TEXT;
+   };
+#endif
+
+  Format=NewFormat;
+  return Format;
+}
+
+#ifdef HAVE_HDF5
+
+#include <hdf5.h>
+#include <H5LTpublic.h>
+
+#ifdef HAVE_CXX11
+#  include <unordered_map>
+#  include <string>
+typedef std::unordered_map<std::string, int> RowIndexMap;
+#elif defined(HAVE_TR1)
+#  include <tr1/unordered_map>
+#  include <string>
+typedef std::tr1::unordered_map<std::string, int> RowIndexMap;
+#endif
+
+#define RT_TAGLEN      64
+#define RT_CHUNKROWS   1024
+#define RT_MAXCOLUMNS  1000
+
+// the HDF5 library is not thread-safe in its default configuration,
+// so a single lock serializes all table operations
+static pthread_mutex_t RTMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/***************************************************************/
+/* internal data for an open table                             */
+/***************************************************************/
+typedef struct ResultTableData
+ {
+   hid_t file_id;
+   hid_t *Datasets;     // [0] = tags, then keys, then values
+   hid_t TagType;
+   int NumColumns;      // 1 + NumKeys + NumValues
+   int RowsOnDisk;
+
+   // rows not yet written to the file
+   int NumBuffered;
+   char *TagBuffer;     // RT_CHUNKROWS x RT_TAGLEN
+   double *RowBuffer;   // RT_CHUNKROWS x (NumKeys+NumValues), row-major
+
+   RowIndexMap *Index;
+
+ } ResultTableData;
+
+/***************************************************************/
+/* hash key for (Tag, Keys). keys are written in hexadecimal   */
+/* floating-point format, which is exact, so only rows whose   */
+/* keys agree bit for bit (apart from the sign of zero) match; */
+/* rounding the keys would let nearby but distinct grid points */
+/* (e.g. Xi=1.0000001, 1.0000004) share an entry.              */
+/***************************************************************/
+static std::string GetIndexKey(const char *Tag, const double *Keys, int NumKeys)
+{
+  std::string Key(Tag);
+  char Buffer[40];
+  for(int nk=0; nk<NumKeys; nk++)
+   { snprintf(Buffer,40," %a",Keys[nk]+0.0);
+     Key+=Buffer;
+   };
+  return Key;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+static char *MakeColumnName(const char *Name, const char *Default, int n)
+{
+  char *s = Name ? strdupEC(Name) : vstrdup("%s%i",Default,n);
+  for(char *p=s; *p; p++)
+   if (*p=='/' || *p==' ' || *p=='.') *p='_';
+  return s;
+}
+
+static hid_t CreateColumn(hid_t file_id, const char *Name, hid_t Type)
+{
+  hsize_t dims[1]    = {0};
+  hsize_t maxdims[1] = {H5S_UNLIMITED};
+  hsize_t chunk[1]   = {RT_CHUNKROWS};
+  hid_t space_id = H5Screate_simple(1, dims, maxdims);
+  hid_t plist_id = H5Pcreate(H5P_DATASET_CREATE);
+  H5Pset_chunk(plist_id, 1, chunk);
+  if (H5Zfilter_avail(H5Z_FILTER_DEFLATE))
+   { H5Pset_shuffle(plist_id);
+     H5Pset_deflate(plist_id, 4);
+   };
+  hid_t dataset_id = H5Dcreate2(file_id, Name, Type, space_id,
+                                H5P_DEFAULT, plist_id, H5P_DEFAULT);
+  H5Pclose(plist_id);
+  H5Sclose(space_id);
+  return dataset_id;
+}
+
+/***************************************************************/
+/* append or read NumRows entries of one column starting at    */
+/* row Offset                                                  */
+/***************************************************************/
+static herr_t WriteColumn(hid_t dataset_id, hid_t Type, int Offset,
+                          int NumRows, const void *Buffer)
+{
+  hsize_t NewSize[1] = { (hsize_t)(Offset + NumRows) };
+  if ( H5Dset_extent(dataset_id, NewSize) < 0 )
+   return -1;
+
+  hid_t file_space = H5Dget_space(dataset_id);
+  hsize_t Start[1] = { (hsize_t)Offset };
+  hsize_t Count[1] = { (hsize_t)NumRows };
+  H5Sselect_hyperslab(file_space, H5S_SELECT_SET, Start, 0, Count, 0);
+  hid_t mem_space = H5Screate_simple(1, Count, 0);
+  herr_t Status=H5Dwrite(dataset_id, Type, mem_space, file_space, H5P_DEFAULT, Buffer);
+  H5Sclose(mem_space);
+  H5Sclose(file_space);
+  return Status;
+}
+
+static herr_t ReadColumn(hid_t dataset_id, hid_t Type, int Offset,
+                         int NumRows, void *Buffer)
+{
+  hid_t file_space = H5Dget_space(dataset_id);
+  hsize_t Start[1] = { (hsize_t)Offset };
+  hsize_t Count[1] = { (hsize_t)NumRows };
+  H5Sselect_hyperslab(file_space, H5S_SELECT_SET, Start, 0, Count, 0);
+  hid_t mem_space = H5Screate_simple(1, Count, 0);
+  herr_t Status=H5Dread(dataset_id, Type, mem_space, file_space, H5P_DEFAULT, Buffer);
+  H5Sclose(mem_space);
+  H5Sclose(file_space);
+  return Status;
+}
+
+/***************************************************************/
+/* try to open an existing table with the given columns.       */
+/* returns 1 on success, 0 if the file does not exist, or -1   */
+/* (with nothing left open) if the file exists but is not a    */
+/* table with the given columns; in the latter case we refuse  */
+/* to overwrite it.                                            */
+/***************************************************************/
+static int OpenExistingTable(ResultTableData *RTD, const char *FileName,
+                             int NumKeys, int NumValues, char **ColumnNames)
+{
+  FILE *f=fopen(FileName,"r");
+  if (!f)
+   return 0;
+  fclose(f);
+
+  hid_t file_id = H5Fopen(FileName, H5F_ACC_RDWR, H5P_DEFAULT);
+  if (file_id<0)
+   return -1;
+
+  int FileNumKeys=-1, FileNumValues=-1;
+  H5LTget_attribute_int(file_id, "/", "NumKeys", &FileNumKeys);
+  H5LTget_attribute_int(file_id, "/", "NumValues", &FileNumValues);
+  bool Match = (FileNumKeys==NumKeys && FileNumValues==NumValues);
+  for(int nc=0; Match && nc<RTD->NumColumns; nc++)
+   Match = (H5LTfind_dataset(file_id, ColumnNames[nc]) > 0);
+  if (!Match)
+   { H5Fclose(file_id);
+     return -1;
+   };
+
+  RTD->file_id=file_id;
+  for(int nc=0; nc<RTD->NumColumns; nc++)
+   RTD->Datasets[nc] = H5Dopen2(file_id, ColumnNames[nc], H5P_DEFAULT);
+
+  hid_t space_id=H5Dget_space(RTD->Datasets[0]);
+  hsize_t dims[1];
+  H5Sget_simple_extent_dims(space_id, dims, 0);
+  H5Sclose(space_id);
+  RTD->RowsOnDisk=(int)dims[0];
+
+  /*--------------------------------------------------------------*/
+  /*- build the index from the tag and key columns, a chunk at a -*/
+  /*- time                                                       -*/
+  /*--------------------------------------------------------------*/
+  char *Tags   = (char *)mallocEC(RT_CHUNKROWS*RT_TAGLEN);
+  double *Keys = (double *)mallocEC(RT_CHUNKROWS*(NumKeys+1)*sizeof(double));
+  double *RowKeys = Keys + RT_CHUNKROWS*NumKeys;
+  for(int Offset=0; Offset<RTD->RowsOnDisk; Offset+=RT_CHUNKROWS)
+   { int NumRows = RTD->RowsOnDisk - Offset;
+     if (NumRows>RT_CHUNKROWS) NumRows=RT_CHUNKROWS;
+     ReadColumn(RTD->Datasets[0], RTD->TagType, Offset, NumRows, Tags);
+     for(int nk=0; nk<NumKeys; nk++)
+      ReadColumn(RTD->Datasets[1+nk], H5T_NATIVE_DOUBLE, Offset, NumRows,
+                 Keys + nk*RT_CHUNKROWS);
+     for(int nr=0; nr<NumRows; nr++)
+      { for(int nk=0; nk<NumKeys; nk++)
+         RowKeys[nk]=Keys[nk*RT_CHUNKROWS + nr];
+        char *Tag=Tags + nr*RT_TAGLEN;
+        Tag[RT_TAGLEN-1]=0;
+        (*RTD->Index)[ GetIndexKey(Tag, RowKeys, NumKeys) ] = Offset + nr;
+      };
+   };
+  free(Tags);
+  free(Keys);
+
+  return 1;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+static bool CreateNewTable(ResultTableData *RTD, const char *FileName,
+                           int NumKeys, int NumValues, char **ColumnNames)
+{
+  hid_t file_id = H5Fcreate(FileName, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  if (file_id<0)
+   return false;
+
+  RTD->file_id=file_id;
+  RTD->RowsOnDisk=0;
+  for(int nc=0; nc<RTD->NumColumns; nc++)
+   { RTD->Datasets[nc]
+      = CreateColumn(file_id, ColumnNames[nc], nc==0 ? RTD->TagType : H5T_NATIVE_DOUBLE);
+     if (RTD->Datasets[nc]<0)
+      return false;
+   };
+
+  H5LTset_attribute_int(file_id, "/", "NumKeys", &NumKeys, 1);
+  H5LTset_attribute_int(file_id, "/", "NumValues", &NumValues, 1);
+  std::string Columns(ColumnNames[0]);
+  for(int nc=1; nc<RTD->NumColumns; nc++)
+   { Columns+=" ";
+     Columns+=ColumnNames[nc];
+   };
+  H5LTset_attribute_string(file_id, "/", "Columns", Columns.c_str());
+  return true;
+}
+
+/***************************************************************/
+/* class constructors ******************************************/
+/***************************************************************/
+ResultTable::ResultTable(const char *pFileName,
+                         int pNumKeys, const char **KeyNames,
+                         int pNumValues, const char **ValueNames,
+                         bool Append)
+{
+  FileName = strdupEC(pFileName);
+  Init(pNumKeys, KeyNames, pNumValues, ValueNames, Append);
+}
+
+ResultTable::ResultTable(const char *pFileName)
+{
+  FileName    = strdupEC(pFileName);
+  NumKeys     = NumValues = NumRows = 0;
+  ColumnNames = 0;
+  ErrMsg      = 0;
+  Data        = 0;
+
+  // read the column layout from the attributes of the root group
+  H5Eset_auto2( 0, 0, 0 );
+  int FileNumKeys=-1, FileNumValues=-1;
+  char *Columns=0;
+  pthread_mutex_lock(&RTMutex);
+  hid_t file_id = H5Fopen(FileName, H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file_id>=0)
+   { H5LTget_attribute_int(file_id, "/", "NumKeys", &FileNumKeys);
+     H5LTget_attribute_int(file_id, "/", "NumValues", &FileNumValues);
+     hsize_t dims; H5T_class_t Class; size_t Size;
+     if (H5LTget_attribute_info(file_id, "/", "Columns", &dims, &Class, &Size) >= 0)
+      { Columns=(char *)mallocEC(Size+1);
+        if (H5LTget_attribute_string(file_id, "/", "Columns", Columns) < 0)
+         { free(Columns);
+           Columns=0;
+         };
+      };
+     H5Fclose(file_id);
+   };
+  pthread_mutex_unlock(&RTMutex);
+
+  char *Tokens[RT_MAXCOLUMNS];
+  int NumTokens = Columns ? Tokenize(Columns, Tokens, RT_MAXCOLUMNS) : 0;
+  if (    FileNumKeys<0 || FileNumValues<0 
+       || NumTokens != 1+FileNumKeys+FileNumValues
+     )
+   { ErrMsg=vstrdup("file %s is not a result table",FileName);
+     if (Columns) free(Columns);
+     return;
+   };
+
+  Init(FileNumKeys, (const char **)(Tokens+1),
+       FileNumValues, (const char **)(Tokens+1+FileNumKeys), true);
+  free(Columns);
+}
+
+/***************************************************************/
+/* body of the constructors                                    */
+/***************************************************************/
+void ResultTable::Init(int pNumKeys, const char **KeyNames,
+                       int pNumValues, const char **ValueNames,
+                       bool Append)
+{
+  NumKeys   = pNumKeys;
+  NumValues = pNumValues;
+  NumRows   = 0;
+  ErrMsg    = 0;
+  Data      = 0;
+
+  // turn off the HDF5 console error messages
+  H5Eset_auto2( 0, 0, 0 );
+
+  ResultTableData *RTD=(ResultTableData *)mallocEC(sizeof(ResultTableData));
+  RTD->NumColumns  = 1 + NumKeys + NumValues;
+  RTD->Datasets    = (hid_t *)mallocEC(RTD->NumColumns*sizeof(hid_t));
+  RTD->NumBuffered = 0;
+  RTD->TagBuffer   = (char *)mallocEC(RT_CHUNKROWS*RT_TAGLEN);
+  RTD->RowBuffer   = (double *)mallocEC(RT_CHUNKROWS*(NumKeys+NumValues)*sizeof(double));
+  RTD->Index       = new RowIndexMap;
+  RTD->TagType     = H5Tcopy(H5T_C_S1);
+  H5Tset_size(RTD->TagType, RT_TAGLEN);
+
+  ColumnNames=(char **)mallocEC(RTD->NumColumns*sizeof(char *));
+  ColumnNames[0]=strdupEC("Tag");
+  for(int nk=0; nk<NumKeys; nk++)
+   ColumnNames[1+nk] = MakeColumnName(KeyNames ? KeyNames[nk] : 0, "Key", nk);
+  for(int nv=0; nv<NumValues; nv++)
+   ColumnNames[1+NumKeys+nv] = MakeColumnName(ValueNames ? ValueNames[nv] : 0, "Value", nv);
+
+  pthread_mutex_lock(&RTMutex);
+  int Status = Append ? OpenExistingTable(RTD, FileName, NumKeys, NumValues, ColumnNames) : 0;
+  bool Success = (Status==1);
+  if (Success)
+   Log("Appending to existing result table %s (%i rows)",FileName,RTD->RowsOnDisk);
+  else if (Status==0)
+   Success = CreateNewTable(RTD, FileName, NumKeys, NumValues, ColumnNames);
+  pthread_mutex_unlock(&RTMutex);
+
+  Data=(void *)RTD;
+  if (!Success)
+   { if (Status==-1)
+      ErrMsg=vstrdup("file %s exists but is not a result table with the expected columns",FileName);
+     else
+      ErrMsg=vstrdup("could not create result table %s",FileName);
+     RTD->file_id=-1;
+     return;
+   };
+  NumRows=RTD->RowsOnDisk;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+ResultTable::~ResultTable()
+{
+  ResultTableData *RTD=(ResultTableData *)Data;
+  if (RTD)
+   { Flush();
+     if (RTD->file_id>=0)
+      { for(int nc=0; nc<RTD->NumColumns; nc++)
+         H5Dclose(RTD->Datasets[nc]);
+        H5Fclose(RTD->file_id);
+      };
+     H5Tclose(RTD->TagType);
+     delete RTD->Index;
+     free(RTD->Datasets);
+     free(RTD->TagBuffer);
+     free(RTD->RowBuffer);
+     free(RTD);
+   };
+  if (ColumnNames)
+   { for(int nc=0; nc<1+NumKeys+NumValues; nc++)
+      free(ColumnNames[nc]);
+     free(ColumnNames);
+   };
+  free(FileName);
+  if (ErrMsg) free(ErrMsg);
+}
+
+/***************************************************************/
+/* write buffered rows to the file (caller holds the lock)     */
+/***************************************************************/
+static void FlushRows(ResultTableData *RTD, int NumKeys, int NumValues)
+{
+  int NB=RTD->NumBuffered;
+  if (NB==0 || RTD->file_id<0) return;
+
+  int Offset=RTD->RowsOnDisk;
+  herr_t Status=WriteColumn(RTD->Datasets[0], RTD->TagType, Offset, NB, RTD->TagBuffer);
+
+  int NKV=NumKeys+NumValues;
+  double *Column=(double *)mallocEC(NB*sizeof(double));
+  for(int nkv=0; nkv<NKV && Status>=0; nkv++)
+   { for(int nr=0; nr<NB; nr++)
+      Column[nr]=RTD->RowBuffer[nr*NKV + nkv];
+     Status=WriteColumn(RTD->Datasets[1+nkv], H5T_NATIVE_DOUBLE, Offset, NB, Column);
+   };
+  free(Column);
+  if (Status<0)
+   ErrExit("%s:%i: error writing HDF5 result table",__FILE__,__LINE__);
+
+  H5Fflush(RTD->file_id, H5F_SCOPE_LOCAL);
+  RTD->RowsOnDisk+=NB;
+  RTD->NumBuffered=0;
+}
+
+void ResultTable::Flush()
+{
+  ResultTableData *RTD=(ResultTableData *)Data;
+  pthread_mutex_lock(&RTMutex);
+  FlushRows(RTD, NumKeys, NumValues);
+  pthread_mutex_unlock(&RTMutex);
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void ResultTable::Append(const char *Tag, const double *Keys, const double *Values)
+{
+  ResultTableData *RTD=(ResultTableData *)Data;
+  if (RTD==0 || RTD->file_id<0) return;
+
+  pthread_mutex_lock(&RTMutex);
+  int nb=RTD->NumBuffered++;
+  char *TagSlot=RTD->TagBuffer + nb*RT_TAGLEN;
+  strncpy(TagSlot, Tag ? Tag : "", RT_TAGLEN-1);
+  TagSlot[RT_TAGLEN-1]=0;
+  int NKV=NumKeys+NumValues;
+  memcpy(RTD->RowBuffer + nb*NKV, Keys, NumKeys*sizeof(double));
+  memcpy(RTD->RowBuffer + nb*NKV + NumKeys, Values, NumValues*sizeof(double));
+  (*RTD->Index)[ GetIndexKey(TagSlot, Keys, NumKeys) ] = RTD->RowsOnDisk + nb;
+  NumRows++;
+  if (RTD->NumBuffered==RT_CHUNKROWS)
+   FlushRows(RTD, NumKeys, NumValues);
+  pthread_mutex_unlock(&RTMutex);
+}
+
+/***************************************************************/
+/* if a row with the given tag and keys exists, fill in Values */
+/* and return true; otherwise return false                     */
+/***************************************************************/
+bool ResultTable::Lookup(const char *Tag, const double *Keys, double *Values)
+{
+  ResultTableData *RTD=(ResultTableData *)Data;
+  if (RTD==0 || RTD->file_id<0) return false;
+
+  char TagBuffer[RT_TAGLEN];
+  strncpy(TagBuffer, Tag ? Tag : "", RT_TAGLEN-1);
+  TagBuffer[RT_TAGLEN-1]=0;
+  std::string IndexKey=GetIndexKey(TagBuffer, Keys, NumKeys);
+
+  pthread_mutex_lock(&RTMutex);
+  bool Found=false;
+  RowIndexMap::iterator it=RTD->Index->find(IndexKey);
+  if (it!=RTD->Index->end())
+   { int Row=it->second;
+     Found=true;
+     if (Row >= RTD->RowsOnDisk)
+      { int NKV=NumKeys+NumValues;
+        memcpy(Values, RTD->RowBuffer + (Row-RTD->RowsOnDisk)*NKV + NumKeys,
+               NumValues*sizeof(double));
+      }
+     else
+      for(int nv=0; nv<NumValues && Found; nv++)
+       Found = ReadColumn(RTD->Datasets[1+NumKeys+nv], H5T_NATIVE_DOUBLE,
+                          Row, 1, Values+nv) >= 0;
+   };
+  pthread_mutex_unlock(&RTMutex);
+  return Found;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int ResultTable::ExportToText(const char *TextFileName, bool AppendToFile)
+{
+  ResultTableData *RTD=(ResultTableData *)Data;
+  if (RTD==0 || RTD->file_id<0) return 0;
+
+  FILE *f=fopen(TextFileName, AppendToFile ? "a" : "w");
+  if (!f)
+   { Warn("could not open file %s (skipping text export)",TextFileName);
+     return 0;
+   };
+
+  pthread_mutex_lock(&RTMutex);
+  FlushRows(RTD, NumKeys, NumValues);
+  int NKV=NumKeys+NumValues;
+  char *Tags=(char *)mallocEC(RT_CHUNKROWS*RT_TAGLEN);
+  double *Columns=(double *)mallocEC(RT_CHUNKROWS*NKV*sizeof(double));
+  for(int Offset=0; Offset<RTD->RowsOnDisk; Offset+=RT_CHUNKROWS)
+   { int NR = RTD->RowsOnDisk - Offset;
+     if (NR>RT_CHUNKROWS) NR=RT_CHUNKROWS;
+     ReadColumn(RTD->Datasets[0], RTD->TagType, Offset, NR, Tags);
+     for(int nkv=0; nkv<NKV; nkv++)
+      ReadColumn(RTD->Datasets[1+nkv], H5T_NATIVE_DOUBLE, Offset, NR,
+                 Columns + nkv*RT_CHUNKROWS);
+     for(int nr=0; nr<NR; nr++)
+      { Tags[nr*RT_TAGLEN + RT_TAGLEN-1]=0;
+        fprintf(f,"%s ",Tags + nr*RT_TAGLEN);
+        for(int nkv=0; nkv<NKV; nkv++)
+         fprintf(f,"%.8e ",Columns[nkv*RT_CHUNKROWS + nr]);
+        fprintf(f,"\n");
+      };
+   };
+  int NumWritten=RTD->RowsOnDisk;
+  pthread_mutex_unlock(&RTMutex);
+
+  free(Tags);
+  free(Columns);
+  fclose(f);
+  return NumWritten;
+}
+
+#else // HAVE_HDF5
+
+/***************************************************************/
+/* without HDF5, tables are created in an error state and all  */
+/* operations are no-ops                                       */
+/***************************************************************/
+ResultTable::ResultTable(const char *pFileName,
+                         int pNumKeys, const char **KeyNames,
+                         int pNumValues, const char **ValueNames,
+                         bool Append)
+{
+  (void) KeyNames; (void) ValueNames; (void) Append;
+  FileName  = strdupEC(pFileName);
+  NumKeys   = pNumKeys;
+  NumValues = pNumValues;
+  NumRows   = 0;
+  ColumnNames = 0;
+  Data      = 0;
+  ErrMsg    = vstrdup("could not create result table %s: compiled without HDF5 support",FileName);
+}
+
+ResultTable::ResultTable(const char *pFileName)
+{
+  FileName  = strdupEC(pFileName);
+  NumKeys   = NumValues = NumRows = 0;
+  ColumnNames = 0;
+  Data      = 0;
+  ErrMsg    = vstrdup("could not open result table %s: compiled without HDF5 support",FileName);
+}
+
+void ResultTable::Init(int pNumKeys, const char **KeyNames,
+                       int pNumValues, const char **ValueNames, bool Append)
+{ (void) pNumKeys; (void) KeyNames; (void) pNumValues; 
+  (void) ValueNames; (void) Append;
+}
+
+ResultTable::~ResultTable()
+{ free(FileName);
+  free(ErrMsg);
+}
+
+void ResultTable::Append(const char *Tag, const double *Keys, const double *Values)
+{ (void) Tag; (void) Keys; (void) Values; }
+
+bool ResultTable::Lookup(const char *Tag, const double *Keys, double *Values)
+{ (void) Tag; (void) Keys; (void) Values;
+  return false;
+}
+
+void ResultTable::Flush()
+{ }
+
+int ResultTable::ExportToText(const char *TextFileName, bool AppendToFile)
+{ (void) TextFileName; (void) AppendToFile;
+  return 0;
+}
+
+#endif // HAVE_HDF5
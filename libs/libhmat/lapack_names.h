@@ -1229,4 +1229,5 @@
 #define dgemv_ F77_FUNC(dgemv,DGEMV)
 #define zgemm_ F77_FUNC(zgemm,ZGEMM)
 #define zgemv_ F77_FUNC(zgemv,ZGEMV)
+#define ztrsm_ F77_FUNC(ztrsm,ZTRSM)
 #endif
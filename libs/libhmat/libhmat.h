@@ -488,4 +488,148 @@ class SMatrix
     int MakeEntry(int nr, int nc, bool force_new); // internal function to allocate entries
  };
 
+/***************************************************************/
+/* ResultTable: an append-only table of computed results,      */
+/* stored column-by-column in chunked, compressed, extensible  */
+/* HDF5 datasets. each row consists of a string tag (e.g. a    */
+/* geometrical-transformation tag), NumKeys key columns (e.g.  */
+/* frequency and Bloch vector), and NumValues value columns.   */
+/*                                                             */
+/* rows are buffered in memory and written out a chunk at a    */
+/* time. all methods are thread-safe. when an existing file   */
+/* is opened in append mode, its tag and key columns are read  */
+/* once into a hash index, after which Lookup() finds the row  */
+/* for a given (tag, keys) in constant time; keys must match   */
+/* exactly.                                                    */
+/*                                                             */
+/* see ResultTable.cc for the file layout.                     */
+/***************************************************************/
+#define RESULT_FORMAT_TEXT 1
+#define RESULT_FORMAT_HDF5 2
+
+// output formats requested via the SCUFF_OUTPUT_FORMAT environment
+// variable ("text", "hdf5", or "both"); a bitmask of RESULT_FORMAT_xx
+int GetResultFormat();
+
+class ResultTable
+ {
+  public:
+
+    // if Append==true and FileName exists, new rows are added to
+    // the existing table (which must have the same columns);
+    // if Append==false the file is created or overwritten.
+    // column names may be NULL,
+    // in which case default names (Key0, Key1, ..., Value0, ...)
+    // are used. if anything fails, ErrMsg is nonzero on return.
+    ResultTable(const char *FileName,
+                int NumKeys, const char **KeyNames,
+                int NumValues, const char **ValueNames,
+                bool Append=true);
+
+    // open an existing table, taking its columns from the file
+    ResultTable(const char *FileName);
+
+    ~ResultTable();
+
+    void Append(const char *Tag, const double *Keys, const double *Values);
+    bool Lookup(const char *Tag, const double *Keys, double *Values);
+    void Flush();
+
+    // write all rows as lines of text: tag, keys, values;
+    // returns the number of rows written
+    int ExportToText(const char *FileName, bool AppendToFile=false);
+
+    int NumKeys, NumValues, NumRows;
+    char **ColumnNames; // "Tag", then the key names, then the value names
+    char *FileName;
+    char *ErrMsg;
+
+  private:
+    void Init(int NumKeys, const char **KeyNames,
+              int NumValues, const char **ValueNames, bool Append);
+    void *Data;
+ };
+
+/***************************************************************/
+/* MPI housekeeping. in builds without MPI support these are   */
+/* no-ops, and GetMPIRank/GetMPISize return 0 and 1.           */
+/***************************************************************/
+void InitMPI(int *argc, char ***argv);
+void FinalizeMPI();
+int GetMPIRank();
+int GetMPISize();
+
+/***************************************************************/
+/* DMatrix: a complex-valued dense matrix distributed over the */
+/* ranks of an MPI job. the ranks are arranged in an           */
+/* NPRow x NPCol process grid, and the matrix is divided into  */
+/* NB x NB blocks which are dealt out to the process grid in   */
+/* 2D block-cyclic fashion (block (I,J) lives on process       */
+/* (I%NPRow, J%NPCol)), which is the layout used by ScaLAPACK. */
+/* the blocks stored on each rank are packed into the HMatrix  */
+/* Local.                                                      */
+/***************************************************************/
+class DMatrix
+ {
+  public:
+
+   // NB=0 selects a default block size
+   DMatrix(int NRows, int NCols, int NB=0);
+   ~DMatrix();
+
+   // global <--> local index conversions
+   int RowOwner(int nr) { return (nr/NB) % NPRow; }
+   int ColOwner(int nc) { return (nc/NB) % NPCol; }
+   bool IsLocal(int nr, int nc)
+    { return RowOwner(nr)==MyPRow && ColOwner(nc)==MyPCol; }
+   int LocalRow(int nr) { return (nr/NB/NPRow)*NB + nr%NB; }
+   int LocalCol(int nc) { return (nc/NB/NPCol)*NB + nc%NB; }
+   int GlobalRow(int lr) { return ((lr/NB)*NPRow + MyPRow)*NB + lr%NB; }
+   int GlobalCol(int lc) { return ((lc/NB)*NPCol + MyPCol)*NB + lc%NB; }
+
+   // number of locally-stored rows (columns) with global index < nr (nc)
+   int LocalRowStart(int nr);
+   int LocalColStart(int nc);
+
+   // entry access; only locally-stored entries may be read,
+   // and attempts to set non-local entries are ignored
+   void Zero();
+   void SetEntry(int nr, int nc, cdouble Entry);
+   cdouble GetEntry(int nr, int nc);
+
+   // copy the locally-stored entries of a matrix that is
+   // replicated on all ranks, or gather the full matrix on
+   // all ranks (the latter is intended only for testing)
+   void Distribute(HMatrix *M);
+   HMatrix *Gather(HMatrix *M=0);
+
+   // distributed LU factorization with partial pivoting; the
+   // right-hand sides passed to LUSolve must be replicated on
+   // all ranks, and the solutions are returned on all ranks
+   int LUFactorize();
+   int LUSolve(HMatrix *X);
+   int LUSolve(HVector *X);
+
+   // the NRLocal x NCLocal matrix of locally-stored entries, in
+   // which local tile (lr,lc) (lr, lc multiples of NB) holds the
+   // global tile starting at (GlobalRow(lr), GlobalCol(lc)); this
+   // is for filling in the local tiles directly, as in
+   // RWGGeometry::AssembleDistributedBEMMatrix
+   HMatrix *GetLocalMatrix() { return Local; }
+
+   // matrix dimensions, block size, and process-grid layout
+   // (read-only)
+   int NR, NC, NB;
+   int NPRow, NPCol, MyPRow, MyPCol;
+   int NRLocal, NCLocal;
+
+  private:
+   HMatrix *Local;
+   int *ipiv;     // global pivot indices, replicated on all ranks
+   void *Comms;   // row and column communicators
+
+   void SwapRows(int r1, int r2, int lc0, int lc1,
+                 cdouble *SendBuf, cdouble *RecvBuf);
+ };
+
 #endif
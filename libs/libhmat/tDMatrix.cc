@@ -0,0 +1,107 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * tDMatrix.cc -- compare distributed LU solve against HMatrix::LUSolve
+ *
+ *             -- usage: mpirun -np 4 tDMatrix --N 1000 --NB 32
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <libhrutil.h>
+#include "libhmat.h"
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  InitMPI(&argc, &argv);
+
+  /*--------------------------------------------------------------*/
+  /*- process options  -------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  int N=1000;
+  int NB=0;
+  int NRHS=3;
+  /* name               type    #args  max_instances  storage           count         description*/
+  OptStruct OSArray[]=
+   { {"N",       PA_INT,     1, 1, (void *)&N,       0, "dimension "},
+     {"NB",      PA_INT,     1, 1, (void *)&NB,      0, "block size"},
+     {"NRHS",    PA_INT,     1, 1, (void *)&NRHS,    0, "number of right-hand sides"},
+     {0,0,0,0,0,0,0}
+   };
+  ProcessOptions(argc, argv, OSArray);
+
+  int Rank = GetMPIRank();
+
+  /*--------------------------------------------------------------*/
+  /*- every rank generates the same random matrix and RHS        -*/
+  /*--------------------------------------------------------------*/
+  srand48(1);
+  HMatrix *M = new HMatrix(N, N, LHM_COMPLEX);
+  HMatrix *X = new HMatrix(N, NRHS, LHM_COMPLEX);
+  for(int m=0; m<N; m++)
+   for(int n=0; n<N; n++)
+    M->SetEntry(m, n, cdouble(drand48()-0.5, drand48()-0.5));
+  for(int m=0; m<N; m++)
+   for(int n=0; n<NRHS; n++)
+    X->SetEntry(m, n, cdouble(drand48()-0.5, drand48()-0.5));
+
+  DMatrix *DM = new DMatrix(N, N, NB);
+  if (Rank==0)
+   printf("%i x %i matrix, %i x %i process grid, block size %i\n",
+           N,N,DM->NPRow,DM->NPCol,DM->NB);
+  DM->Distribute(M);
+
+  /*--------------------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  HMatrix *XD = new HMatrix(X);
+  Tic();
+  int info=DM->LUFactorize();
+  double TFactor=Toc();
+  Tic();
+  DM->LUSolve(XD);
+  double TSolve=Toc();
+
+  HMatrix *XS = new HMatrix(X);
+  M->LUFactorize();
+  M->LUSolve(XS);
+
+  double MaxDiff=0.0, MaxX=0.0;
+  for(int m=0; m<N; m++)
+   for(int n=0; n<NRHS; n++)
+    { MaxDiff = fmax(MaxDiff, abs(XD->GetEntry(m,n) - XS->GetEntry(m,n)));
+      MaxX    = fmax(MaxX,    abs(XS->GetEntry(m,n)));
+    };
+
+  if (Rank==0)
+   { printf("info=%i, factor %.3f s, solve %.3f s\n",info,TFactor,TSolve);
+     printf("max relative difference vs. serial solve: %e (%s)\n",
+             MaxDiff/MaxX, MaxDiff < 1.0e-8*MaxX ? "PASS" : "FAIL");
+   };
+
+  delete DM;
+  FinalizeMPI();
+  return (MaxDiff < 1.0e-8*MaxX) ? 0 : 1;
+}
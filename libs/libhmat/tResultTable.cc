@@ -0,0 +1,171 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libhrutil.h>
+#include "libhmat.h"
+
+#define NUMKEYS   3
+#define NUMVALUES 4
+
+/***************************************************************/
+/* deterministic table contents for row nr                     */
+/***************************************************************/
+void GetRow(int nr, char *Tag, double *Keys, double *Values)
+{
+  sprintf(Tag,"T%i",nr%3);
+  Keys[0] = 0.1*(nr+1);
+  Keys[1] = (nr%7)*0.25;
+  Keys[2] = -1.0*(nr%5);
+  for(int nv=0; nv<NUMVALUES; nv++)
+   Values[nv] = sin(nr + 0.3*nv);
+}
+
+bool CheckRows(ResultTable *RT, int NumRows)
+{
+  char Tag[10];
+  double Keys[NUMKEYS], Values[NUMVALUES], Values2[NUMVALUES];
+  for(int nr=0; nr<NumRows; nr++)
+   { GetRow(nr, Tag, Keys, Values);
+     if ( !RT->Lookup(Tag, Keys, Values2) )
+      { printf("row %i: lookup failed\n",nr);
+        return false;
+      };
+     for(int nv=0; nv<NUMVALUES; nv++)
+      if ( !EqualFloat(Values[nv], Values2[nv]) )
+       { printf("row %i, value %i: (%e,%e)\n",nr,nv,Values[nv],Values2[nv]);
+         return false;
+       };
+   };
+
+  // a key not in the table
+  GetRow(0, Tag, Keys, Values);
+  Keys[0] = -3.0;
+  if ( RT->Lookup(Tag, Keys, Values2) )
+   { printf("lookup of missing row succeeded\n");
+     return false;
+   };
+  return true;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  int NumRows=3000;
+  /* name, type, #args, max_instances, storage, count, description*/
+  OptStruct OSArray[]=
+   { {"NumRows",  PA_INT,  1, 1, (void *)&NumRows, 0, "number of rows"},
+     {0,0,0,0,0,0,0}
+   };
+  ProcessOptions(argc, argv, OSArray);
+
+  const char *KeyNames[NUMKEYS]={"Omega", "kx", "ky"};
+  const char *ValueNames[NUMVALUES]={"PAbs", "PRad", "Fz", "Tz"};
+
+  /*--------------------------------------------------------------*/
+  /*- write the first half of the rows, then reopen the file and -*/
+  /*- append the second half                                     -*/
+  /*--------------------------------------------------------------*/
+  char Tag[10];
+  double Keys[NUMKEYS], Values[NUMVALUES];
+  ResultTable *RT=new ResultTable("tResultTable.h5", NUMKEYS, KeyNames,
+                                  NUMVALUES, ValueNames, false);
+  if (RT->ErrMsg)
+   { printf("%s (skipping test)\n",RT->ErrMsg);
+     return 0;
+   };
+  for(int nr=0; nr<NumRows/2; nr++)
+   { GetRow(nr, Tag, Keys, Values);
+     RT->Append(Tag, Keys, Values);
+   };
+  if (!CheckRows(RT, NumRows/2)) return 1;
+  delete RT;
+
+  RT=new ResultTable("tResultTable.h5", NUMKEYS, KeyNames, NUMVALUES, ValueNames);
+  if (RT->NumRows != NumRows/2)
+   { printf("reopened table has %i rows (should be %i)\n",RT->NumRows,NumRows/2);
+     return 1;
+   };
+  for(int nr=NumRows/2; nr<NumRows; nr++)
+   { GetRow(nr, Tag, Keys, Values);
+     RT->Append(Tag, Keys, Values);
+   };
+  if (!CheckRows(RT, NumRows)) return 1;
+
+  delete RT;
+
+  /*--------------------------------------------------------------*/
+  /*- reopen the file without specifying its columns, as the     -*/
+  /*- text exporter does                                         -*/
+  /*--------------------------------------------------------------*/
+  RT=new ResultTable("tResultTable.h5");
+  if (RT->ErrMsg || RT->NumKeys!=NUMKEYS || RT->NumValues!=NUMVALUES)
+   { printf("could not reopen table from its file alone\n");
+     return 1;
+   };
+  if (    strcmp(RT->ColumnNames[1],KeyNames[0])
+       || strcmp(RT->ColumnNames[1+NUMKEYS+NUMVALUES-1],ValueNames[NUMVALUES-1])
+     )
+   { printf("column names not recovered from file\n");
+     return 1;
+   };
+  if (!CheckRows(RT, NumRows)) return 1;
+
+  if ( RT->ExportToText("tResultTable.dat") != NumRows )
+   { printf("text export failed\n");
+     return 1;
+   };
+  delete RT;
+
+  /*--------------------------------------------------------------*/
+  /*- keys that agree to six significant digits but are distinct -*/
+  /*- must not be confused with one another                      -*/
+  /*--------------------------------------------------------------*/
+  const char *XiName[1]={"Xi"};
+  const char *ValueName[1]={"Energy"};
+  RT=new ResultTable("tResultTable2.h5", 1, XiName, 1, ValueName, false);
+  double Xi[3]={1.0000001, 1.0000004, 1.0000003}, Energy;
+  Energy=1.0; RT->Append("DEFAULT", Xi+0, &Energy);
+  Energy=2.0; RT->Append("DEFAULT", Xi+1, &Energy);
+  for(int Pass=0; Pass<2; Pass++)
+   { if ( !RT->Lookup("DEFAULT", Xi+0, &Energy) || Energy!=1.0 )
+      { printf("lookup of Xi=%.7f did not return the first row\n",Xi[0]);
+        return 1;
+      };
+     if ( RT->Lookup("DEFAULT", Xi+2, &Energy) )
+      { printf("lookup of missing Xi=%.7f succeeded\n",Xi[2]);
+        return 1;
+      };
+     // repeat with the rows on disk and the index rebuilt from the file
+     if (Pass==0)
+      { delete RT;
+        RT=new ResultTable("tResultTable2.h5", 1, XiName, 1, ValueName);
+      };
+   };
+  delete RT;
+
+  printf("Tables agree!\n");
+  return 0;
+}
@@ -0,0 +1,370 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Profile.cc  -- lightweight structured performance profiling:
+ *                hierarchical scoped timers, thread-safe counters,
+ *                and memory high-water marks, written out as a
+ *                JSON report when the program exits
+ *
+ * Profiling is switched on by setting the environment variable
+ *
+ *  SCUFF_PROFILE=1              (report goes to CodeName.profile.json)
+ *  SCUFF_PROFILE=MyReport.json  (report goes to MyReport.json)
+ *
+ * or by calling InitializeProfile() with a file name. When profiling
+ * is off, a ProfileTimer costs one test of a static flag.
+ *
+ * Timers are nodes in a tree: a ProfileTimer created while another
+ * timer is running on the same thread becomes a child of that timer.
+ * Each node records the number of calls, the total wall-clock time,
+ * and the largest increase in the process's peak resident set size
+ * observed over any one call, which identifies the regions that set
+ * the memory high-water mark.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if !defined(_WIN32)
+#  include <sys/resource.h>
+#endif
+
+#include "libhrutil.h"
+
+#define MAXPROFILENODES    4096
+#define MAXPROFILECOUNTERS 256
+#define MAXPROFILENAME     200
+
+/***************************************************************/
+/* global profile state ****************************************/
+/***************************************************************/
+typedef struct ProfileNode
+ { char *Name;
+   int Parent;                 // index of parent node, or -1
+   unsigned long Calls;
+   double Seconds;
+   long MaxRSSGrowth;          // kilobytes
+ } ProfileNode;
+
+typedef struct ProfileCounterSlot
+ { char *Name;
+   unsigned long Value;
+ } ProfileCounterSlot;
+
+static ProfileNode Nodes[MAXPROFILENODES];
+static volatile int NumNodes=0;
+static ProfileCounterSlot Counters[MAXPROFILECOUNTERS];
+static volatile int NumCounters=0;
+
+// -1 = environment not yet checked, 0 = off, 1 = on; changed
+// only under the profile lock
+static volatile int ProfileState=-1;
+static char *ProfileFileName=0;
+static double ProfileStartTime=0.0;
+
+// node of the innermost running timer on this thread
+static __thread int CurrentNode=-1;
+
+// the profile tables are only modified when a node or counter is
+// first created or a timer exits, so a simple spinlock suffices
+// and works the same way under pthreads and OpenMP
+static volatile int ProfileLockWord=0;
+static void ProfileLock()
+{ while( __sync_lock_test_and_set(&ProfileLockWord, 1) )
+   while(ProfileLockWord)
+    ;
+}
+static void ProfileUnlock()
+{ __sync_lock_release(&ProfileLockWord); }
+
+/***************************************************************/
+/* peak resident set size of the process in kilobytes          */
+/***************************************************************/
+static long GetPeakRSS()
+{
+#if defined(_WIN32)
+  return 0;
+#else
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru)) return 0;
+  return ru.ru_maxrss;
+#endif
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+static void WriteProfileAtExit()
+{ if (ProfileFileName) WriteProfile(ProfileFileName); }
+
+/***************************************************************/
+/* Switch profiling on. If FileName is nonzero, the report is  */
+/* written to FileName at exit. Otherwise the SCUFF_PROFILE    */
+/* environment variable is consulted: if it is unset or "0",   */
+/* profiling stays off; if it is "1", the report is written to */
+/* DefaultFileName; any other value is taken as the file name. */
+/* The caller must hold the profile lock.                      */
+/***************************************************************/
+static void InitializeProfileLocked(const char *FileName, const char *DefaultFileName)
+{
+  if (FileName==0)
+   { char *s=getenv("SCUFF_PROFILE");
+     if (s==0 || s[0]==0 || !strcmp(s,"0"))
+      { if (ProfileState==-1) ProfileState=0;
+        return;
+      };
+     FileName = strcmp(s,"1") ? s : DefaultFileName;
+     if (FileName==0) FileName="scuff.profile.json";
+   };
+
+  bool FirstTime = (ProfileFileName==0);
+  if (ProfileFileName) free(ProfileFileName);
+  ProfileFileName=strdupEC(FileName);
+  if (FirstTime)
+   { ProfileStartTime=Secs();
+     atexit(WriteProfileAtExit);
+   };
+  __sync_synchronize();
+  ProfileState=1;
+  Log("Writing performance profile to %s at exit.",ProfileFileName);
+}
+
+void InitializeProfile(const char *FileName, const char *DefaultFileName)
+{
+  ProfileLock();
+  InitializeProfileLocked(FileName, DefaultFileName);
+  ProfileUnlock();
+}
+
+/***************************************************************/
+/* the first call (from whichever thread) checks the           */
+/* environment; later calls only read the flag                 */
+/***************************************************************/
+bool ProfileEnabled()
+{
+  if (ProfileState==-1)
+   { ProfileLock();
+     if (ProfileState==-1)
+      InitializeProfileLocked(0, 0);
+     ProfileUnlock();
+   };
+  return ProfileState==1;
+}
+
+/***************************************************************/
+/* find or create the node with the given name and parent      */
+/***************************************************************/
+static int GetProfileNode(const char *Name, int Parent)
+{
+  // nodes are only ever appended, so existing entries can be
+  // searched without the lock
+  int N=NumNodes;
+  for(int n=0; n<N; n++)
+   if ( Nodes[n].Parent==Parent && !strcmp(Nodes[n].Name, Name) )
+    return n;
+
+  ProfileLock();
+  for(int n=N; n<NumNodes; n++)
+   if ( Nodes[n].Parent==Parent && !strcmp(Nodes[n].Name, Name) )
+    { ProfileUnlock();
+      return n;
+    };
+  int n=NumNodes;
+  if (n==MAXPROFILENODES)
+   { // table full; further regions go unrecorded
+     ProfileUnlock();
+     return -1;
+   };
+  Nodes[n].Name         = strdupEC(Name);
+  Nodes[n].Parent       = Parent;
+  Nodes[n].Calls        = 0;
+  Nodes[n].Seconds      = 0.0;
+  Nodes[n].MaxRSSGrowth = 0;
+  __sync_synchronize();
+  NumNodes=n+1;
+  ProfileUnlock();
+  return n;
+}
+
+/***************************************************************/
+/* scoped timers ***********************************************/
+/***************************************************************/
+ProfileTimer::ProfileTimer(const char *format, ...)
+{
+  Node=-1;
+  if (!ProfileEnabled()) return;
+
+  char Name[MAXPROFILENAME];
+  va_list ap;
+  va_start(ap,format);
+  vsnprintf(Name,MAXPROFILENAME,format,ap);
+  va_end(ap);
+
+  ParentNode  = CurrentNode;
+  Node        = GetProfileNode(Name, ParentNode);
+  if (Node==-1) return;
+  CurrentNode = Node;
+  RSS0        = GetPeakRSS();
+  T0          = Secs();
+}
+
+ProfileTimer::~ProfileTimer()
+{
+  if (Node==-1) return;
+
+  double Elapsed = Secs() - T0;
+  long RSSGrowth = GetPeakRSS() - RSS0;
+  CurrentNode    = ParentNode;
+
+  ProfileLock();
+  Nodes[Node].Calls++;
+  Nodes[Node].Seconds+=Elapsed;
+  if (RSSGrowth > Nodes[Node].MaxRSSGrowth)
+   Nodes[Node].MaxRSSGrowth = RSSGrowth;
+  ProfileUnlock();
+}
+
+/***************************************************************/
+/* add time spent in a region that was measured by other means */
+/* (for example, per-thread totals reduced after a parallel    */
+/* loop) as a child of the innermost running timer             */
+/***************************************************************/
+void ProfileAccumulate(const char *Name, double Seconds, unsigned long Calls)
+{
+  if (!ProfileEnabled()) return;
+  int n=GetProfileNode(Name, CurrentNode);
+  if (n==-1) return;
+  ProfileLock();
+  Nodes[n].Calls+=Calls;
+  Nodes[n].Seconds+=Seconds;
+  ProfileUnlock();
+}
+
+/***************************************************************/
+/* named event counters ****************************************/
+/***************************************************************/
+void ProfileCount(const char *Name, unsigned long Increment)
+{
+  if (!ProfileEnabled()) return;
+
+  int N=NumCounters, nc=-1;
+  for(int n=0; n<N && nc==-1; n++)
+   if ( !strcmp(Counters[n].Name, Name) )
+    nc=n;
+
+  if (nc==-1)
+   { ProfileLock();
+     for(int n=N; n<NumCounters && nc==-1; n++)
+      if ( !strcmp(Counters[n].Name, Name) )
+       nc=n;
+     if (nc==-1 && NumCounters<MAXPROFILECOUNTERS)
+      { nc=NumCounters;
+        Counters[nc].Name=strdupEC(Name);
+        Counters[nc].Value=0;
+        __sync_synchronize();
+        NumCounters=nc+1;
+      };
+     ProfileUnlock();
+     if (nc==-1) return;
+   };
+
+  __sync_fetch_and_add(&(Counters[nc].Value), Increment);
+}
+
+/***************************************************************/
+/* JSON output *************************************************/
+/***************************************************************/
+static void WriteJSONString(FILE *f, const char *s)
+{
+  fputc('"',f);
+  for(; *s; s++)
+   { if (*s=='"' || *s=='\\')
+      fputc('\\',f);
+     if ( (unsigned char)(*s) < 0x20 )
+      fputc(' ',f);
+     else
+      fputc(*s,f);
+   };
+  fputc('"',f);
+}
+
+static void WriteProfileNodes(FILE *f, int Parent, int Indent)
+{
+  const char *Separator="";
+  for(int n=0; n<NumNodes; n++)
+   {
+     if (Nodes[n].Parent!=Parent) continue;
+
+     fprintf(f,"%s\n%*s{ \"name\": ",Separator,Indent,"");
+     WriteJSONString(f,Nodes[n].Name);
+     fprintf(f,", \"calls\": %lu, \"seconds\": %.6f, \"rss_growth_bytes\": %ld",
+               Nodes[n].Calls, Nodes[n].Seconds, 1024*Nodes[n].MaxRSSGrowth);
+
+     bool HasChildren=false;
+     for(int m=n+1; m<NumNodes && !HasChildren; m++)
+      HasChildren = (Nodes[m].Parent==n);
+     if (HasChildren)
+      { fprintf(f,",\n%*s  \"children\": [",Indent,"");
+        WriteProfileNodes(f, n, Indent+4);
+        fprintf(f,"\n%*s  ]",Indent,"");
+      };
+     fprintf(f," }");
+     Separator=",";
+   };
+}
+
+void WriteProfile(const char *FileName)
+{
+  FILE *f=fopen(FileName,"w");
+  if (!f)
+   { Warn("could not open file %s (skipping profile output)",FileName);
+     return;
+   };
+
+  ProfileLock();
+
+  fprintf(f,"{\n");
+  fprintf(f,"  \"host\": ");
+  WriteJSONString(f,GetHostName());
+  fprintf(f,",\n  \"pid\": %i,\n", (int)getpid());
+  fprintf(f,"  \"threads\": %i,\n", GetNumThreads());
+  fprintf(f,"  \"wall_seconds\": %.6f,\n", Secs()-ProfileStartTime);
+  fprintf(f,"  \"peak_rss_bytes\": %ld,\n", 1024*GetPeakRSS());
+  fprintf(f,"  \"timers\": [");
+  WriteProfileNodes(f, -1, 4);
+  fprintf(f,"\n  ],\n");
+  fprintf(f,"  \"counters\": {");
+  for(int n=0; n<NumCounters; n++)
+   { fprintf(f,"%s\n    ",n==0 ? "" : ",");
+     WriteJSONString(f,Counters[n].Name);
+     fprintf(f,": %lu",Counters[n].Value);
+   };
+  fprintf(f,"\n  }\n}\n");
+
+  ProfileUnlock();
+  fclose(f);
+}
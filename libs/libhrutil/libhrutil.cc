@@ -429,6 +429,11 @@ void InitializeLog(char *argv0, const char *Path)
    Path ? SetLogFileName("%s/%s.log",Path,CodeName)
         : SetLogFileName("%s.log",CodeName);
   Log("%s running on %s:%d (%s)",CodeName, GetHostName(), getpid(), GetTimeString());
+
+  char ProfileFileName[MAXSTR];
+  Path ? snprintf(ProfileFileName,MAXSTR,"%s/%s.profile.json",Path,CodeName)
+       : snprintf(ProfileFileName,MAXSTR,"%s.profile.json",CodeName);
+  InitializeProfile(0, ProfileFileName);
 }
 
 // 20120225 thread-safe logging
@@ -109,6 +109,30 @@ double Secs();
 void Tic(bool MeasureBytesAllocated=false);
 double Toc(unsigned long *BytesAllocated=0);
 
+/***************************************************************/
+/* structured performance profiling (Profile.cc); switched on  */
+/* by SCUFF_PROFILE or InitializeProfile(), and reported as    */
+/* JSON at exit                                                */
+/***************************************************************/
+void InitializeProfile(const char *FileName=0, const char *DefaultFileName=0);
+bool ProfileEnabled();
+void ProfileCount(const char *Name, unsigned long Increment=1);
+void ProfileAccumulate(const char *Name, double Seconds, unsigned long Calls=1);
+void WriteProfile(const char *FileName);
+
+// times the enclosing scope; the name is a printf-style format
+class ProfileTimer
+ { 
+  public:
+   ProfileTimer(const char *format, ...);
+   ~ProfileTimer();
+
+  private:
+   int Node, ParentNode;
+   double T0;
+   long RSS0;
+ };
+
 /***************************************************************/
 /* string functions  *******************************************/
 /***************************************************************/
@@ -357,10 +357,16 @@ void RWGGeometry::AssembleBEMMatrixBlock(int nsa, int nsb,
   if (TransposeAccelerator)
    ErrExit("%s:%i: TransposeAccelerator not implemented");
 
+  ProfileTimer PT("AssembleBEMMatrixBlock(%s,%s)",
+                  Surfaces[nsa]->Label, Surfaces[nsb]->Label);
+
   if (    nsa==nsb
        && GradM==0
        && TBlockCacheOp(TBCOP_READ, this, nsa, Omega, kBloch, M, RowOffset, ColOffset)
-     ) return;
+     ) 
+   { ProfileCount("TBlockCache.Hits");
+     return;
+   };
 
   if (LogLevel>=SCUFF_VERBOSELOGGING)
    Log("Assembling BEM matrix block (%i,%i)",nsa,nsb);
@@ -683,6 +689,8 @@ void RWGGeometry::ApplyMMJTransformation(HMatrix *M, HVector *RHS)
 /***************************************************************/
 HMatrix *RWGGeometry::AssembleBEMMatrix(cdouble Omega, double *kBloch, HMatrix *M)
 { 
+  ProfileTimer PT("AssembleBEMMatrix");
+
   if (CheckEnv("SCUFF_MATRIX_2018") && LDim==0 )
    return AssembleBEMMatrix2018(this, Omega, kBloch, M);
 
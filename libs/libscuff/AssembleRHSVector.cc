@@ -74,12 +74,6 @@ int RWGGeometry::UpdateIncFields(IncField *IFList, cdouble Omega, double *kBloch
   if (LBasis)
    IFList->SetLattice(LBasis, true);
 
-  /*--------------------------------------------------------------*/
-  /*- make sure the cached epsilon and mu values for all regions  */
-  /*- are up-to-date for the present frequency                    */
-  /*--------------------------------------------------------------*/
-  UpdateCachedEpsMuValues(Omega);
-
   /*--------------------------------------------------------------*/
   /*- run through the chain of IncField structures and set the   -*/
   /*- epsilon and mu values for each structure depending on the  -*/
@@ -108,7 +102,9 @@ int RWGGeometry::UpdateIncFields(IncField *IFList, cdouble Omega, double *kBloch
      /*- now set the material properties of IF as appropriate for   -*/
      /*- the region in question                                     -*/
      /*--------------------------------------------------------------*/
-     IF->SetFrequencyAndEpsMu(Omega, EpsTF[ IF->RegionIndex ], MuTF[ IF->RegionIndex ] );
+     cdouble Eps, Mu;
+     RegionMPs[IF->RegionIndex]->GetEpsMu(Omega, &Eps, &Mu);
+     IF->SetFrequencyAndEpsMu(Omega, Eps, Mu);
      if (kBloch)
       IF->SetkBloch(kBloch);
 
@@ -118,61 +114,6 @@ int RWGGeometry::UpdateIncFields(IncField *IFList, cdouble Omega, double *kBloch
 
 }
 
-/***************************************************************/
-/* data structure used to pass parameters to                   */
-/* InnerProductIntegrand routine.                              */
-/***************************************************************/
-typedef struct InnerProductIntegrandData 
- { 
-   double *Q;
-   double PreFac;
-
-   IncField **PositiveIFs;
-   int NPositiveIFs;
-   IncField **NegativeIFs;
-   int NNegativeIFs;
-
-   int NeedHProd;
-
- } InnerProductIntegrandData;
-
-/***************************************************************/
-/* integrand routine passed to TriInt. this returns the dot    */
-/* product of the RWG basis function at point X with the       */
-/* electric field at point X, and optionally the dot product   */
-/* with the magnetic field as well.                            */
-/***************************************************************/
-static void InnerProductIntegrand(double *X, void *opIPID, double *F)
-{ 
-  InnerProductIntegrandData *IPID=(InnerProductIntegrandData *)opIPID;
-
-  /* get value of RWG basis function at X */
-  double fRWG[3];
-  VecSub(X,IPID->Q,fRWG);
-  VecScale(fRWG,IPID->PreFac);
-
-  /* get incident E and H fields at X */
-  cdouble dEH[6], EH[6];
-  memset(EH, 0, 6*sizeof(cdouble));
-  int n, nif;
-  for(nif=0; nif<IPID->NPositiveIFs; nif++)
-   { IPID->PositiveIFs[nif]->GetFields(X,dEH);
-     for(n=0; n<6; n++) 
-      EH[n]+=dEH[n];
-   };
-  for(nif=0; nif<IPID->NNegativeIFs; nif++)
-   { IPID->NegativeIFs[nif]->GetFields(X,dEH);
-     for(n=0; n<6; n++) 
-      EH[n]-=dEH[n]; };
-  
-  /* compute dot products */
-  cdouble *zF = (cdouble *)F;
-  zF[0] = fRWG[0]*EH[0] + fRWG[1]*EH[1] + fRWG[2]*EH[2];
-  if (IPID->NeedHProd)
-   zF[1] = fRWG[0]*EH[3] + fRWG[1]*EH[4] + fRWG[2]*EH[5];
-  
-} 
-
 /***************************************************************/
 /* Calculate the inner product of given electric and magnetic  */
 /* fields with the basis function associated with edge #ne on  */
@@ -186,7 +127,12 @@ static void InnerProductIntegrand(double *X, void *opIPID, double *F)
 /*                                                             */
 /* If pHProd==0, we skip the computation of the magnetic-field */
 /* inner product.                                              */
+/*                                                             */
+/* The cubature points on both panels of the edge are gathered */
+/* into a single structure-of-arrays batch, so that each       */
+/* IncField is called just once per edge.                      */
 /***************************************************************/
+#define RHS_CUBATURE_ORDER 20
 void GetInnerProducts(RWGSurface *S, int ne, 
                       IncField **PositiveIFs, int NPositiveIFs,
                       IncField **NegativeIFs, int NNegativeIFs,
@@ -207,41 +153,79 @@ void GetInnerProducts(RWGSurface *S, int ne,
      MArea = S->Panels[E->iMPanel]->Area;
    };
 
-  /* set up data structure passed to InnerProductIntegrand */
-  InnerProductIntegrandData MyIPID, *IPID=&MyIPID;
-  IPID->PositiveIFs  = PositiveIFs;
-  IPID->NPositiveIFs = NPositiveIFs;
-  IPID->NegativeIFs  = NegativeIFs;
-  IPID->NNegativeIFs = NNegativeIFs;
-  IPID->NeedHProd    = (pHProd==NULL ? 0 : 1);
-  
-  int nFun = (pHProd==NULL ? 2 : 4);
-  double I[4], IP[4], IM[4];
-
-  /* integrate over positive panel */
-  IPID->Q=QP;
-  IPID->PreFac=E->Length / (2.0*PArea);
-  TriIntFixed(InnerProductIntegrand, nFun, (void *)IPID, QP, V1, V2, 20, IP);
-
-  /* integrate over negative panel if present */
-  if (QM)
-   { IPID->Q=QM;
-     IPID->PreFac=E->Length / (2.0*MArea);
-     TriIntFixed(InnerProductIntegrand, nFun, (void *)IPID, V1, V2, QM, 20, IM);
-   }
-  else
+  int NCP;
+  double *TCR=GetTCR(RHS_CUBATURE_ORDER, &NCP);
+  int NumPanels = (QM ? 2 : 1);
+  int NX = NumPanels*NCP;
+
+  /***************************************************************/
+  /* gather cubature points on the positive and negative panels: */
+  /* X[nx + NX*i]     = ith coordinate of cubature point #nx     */
+  /* WfRWG[nx + NX*i] = ith component of RWG basis function at   */
+  /*                    cubature point, times cubature weight,   */
+  /*                    times -1 on the negative panel           */
+  /***************************************************************/
+  double *X      = (double *)mallocEC(6*NX*sizeof(double));
+  double *WfRWG  = X + 3*NX;
+  cdouble *EH    = (cdouble *)mallocEC(12*NX*sizeof(cdouble));
+  cdouble *dEH   = EH + 6*NX;
+  for(int np=0; np<NumPanels; np++)
    { 
-     memset(IM, 0, 4*sizeof(double));
+     double *PV1, *PV2, *PV3, *Q, PreFac;
+     if (np==0)
+      { PV1=QP; PV2=V1; PV3=V2; Q=QP;
+        PreFac = E->Length / (2.0*PArea);
+      }
+     else
+      { PV1=V1; PV2=V2; PV3=QM; Q=QM;
+        PreFac = -1.0*E->Length / (2.0*MArea);
+      };
+
+     double A[3], B[3], AxB[3];
+     VecSub(PV2, PV1, A);
+     VecSub(PV3, PV1, B);
+     double J = VecNorm(VecCross(A, B, AxB));
+
+     for(int ncp=0; ncp<NCP; ncp++)
+      { double u=TCR[3*ncp+0];
+        double v=TCR[3*ncp+1];
+        double w=TCR[3*ncp+2]*J*PreFac;
+        int nx = np*NCP + ncp;
+        for(int i=0; i<3; i++)
+         { X[nx + NX*i] = PV1[i] + u*A[i] + v*B[i];
+           WfRWG[nx + NX*i] = w*(X[nx + NX*i] - Q[i]);
+         };
+      };
+   };
+
+  /* get incident E and H fields at all cubature points */
+  memset(EH, 0, 6*NX*sizeof(cdouble));
+  for(int nif=0; nif<NPositiveIFs; nif++)
+   { PositiveIFs[nif]->GetFields(NX, X, dEH);
+     for(int n=0; n<6*NX; n++)
+      EH[n]+=dEH[n];
+   };
+  for(int nif=0; nif<NNegativeIFs; nif++)
+   { NegativeIFs[nif]->GetFields(NX, X, dEH);
+     for(int n=0; n<6*NX; n++)
+      EH[n]-=dEH[n];
    };
 
-  /* total integral is difference between pos and neg pan integrals */
-  for(int nf=0; nf<nFun; nf++)
-   I[nf] = IP[nf] - IM[nf];
-  
+  /* compute dot products */
+  cdouble EProd=0.0, HProd=0.0;
+  for(int i=0; i<3; i++)
+   for(int nx=0; nx<NX; nx++)
+    { EProd += WfRWG[nx + NX*i] * EH[nx + NX*(0+i)];
+      HProd += WfRWG[nx + NX*i] * EH[nx + NX*(3+i)];
+    };
+
+  free(EH);
+  free(X);
+
   /* return values */
-  *pEProd = cdouble(I[0], I[1]);
+  *pEProd = EProd;
   if (pHProd)
-   *pHProd = cdouble(I[2], I[3]);
+   *pHProd = HProd;
 
 }
 
@@ -365,6 +349,8 @@ void *AssembleRHS_Thread(void *data)
 HVector *RWGGeometry::AssembleRHSVector(cdouble Omega, double *kBloch,
                                         IncField *IF, HVector *RHS)
 { 
+  ProfileTimer PT("AssembleRHSVector");
+
   if (RHS==NULL)
    RHS=AllocateRHSVector();
 
@@ -147,22 +147,22 @@ int AssessPanelPair(double **Va, double **Vb)
 int AssessPanelPair(RWGSurface *Sa, int npa, RWGSurface *Sb, int npb,
                     double *rRel, double **Va, double **Vb)
 {
-  RWGPanel *Pa=Sa->Panels[npa];
-  RWGPanel *Pb=Sb->Panels[npb];
+  RWGPackedMesh *PMa=Sa->Packed, *PMb=Sb->Packed;
 
-  Va[0] = Sa->Vertices + 3*Pa->VI[0];
-  Va[1] = Sa->Vertices + 3*Pa->VI[1];
-  Va[2] = Sa->Vertices + 3*Pa->VI[2];
+  Va[0] = PMa->PV + 9*npa + 0;
+  Va[1] = PMa->PV + 9*npa + 3;
+  Va[2] = PMa->PV + 9*npa + 6;
 
-  Vb[0] = Sb->Vertices + 3*Pb->VI[0];
-  Vb[1] = Sb->Vertices + 3*Pb->VI[1];
-  Vb[2] = Sb->Vertices + 3*Pb->VI[2];
+  Vb[0] = PMb->PV + 9*npb + 0;
+  Vb[1] = PMb->PV + 9*npb + 3;
+  Vb[2] = PMb->PV + 9*npb + 6;
 
-  double DC, rRel2, rMax=fmax(Pa->Radius, Pb->Radius);
+  double *CA=PMa->PCentroid + 3*npa, *CB=PMb->PCentroid + 3*npb;
+  double DC, rRel2, rMax=fmax(PMa->PRadius[npa], PMb->PRadius[npb]);
 
-  DC=(Pa->Centroid[0]-Pb->Centroid[0]); rRel2=DC*DC;
-  DC=(Pa->Centroid[1]-Pb->Centroid[1]); rRel2+=DC*DC;
-  DC=(Pa->Centroid[2]-Pb->Centroid[2]); rRel2+=DC*DC;
+  DC=(CA[0]-CB[0]); rRel2=DC*DC;
+  DC=(CA[1]-CB[1]); rRel2+=DC*DC;
+  DC=(CA[2]-CB[2]); rRel2+=DC*DC;
   *rRel=sqrt(rRel2) / rMax;
   if ( *rRel > 2.0 ) // there can be no common vertices in this case 
    return 0;
@@ -0,0 +1,376 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * CalibrateIntegrationRules.cc -- generate the error tables used by
+ *                              -- IntegrationRules.cc to choose cubature
+ *                              -- orders for a given tolerance
+ *
+ * For each point (rRel, kR) of the table grids, we generate random
+ * well-shaped panel configurations (panel radius 1, centroid
+ * separation rRel in a random direction; --NumSamples of them for
+ * panel pairs and --NumFieldSamples for field integrals, whose
+ * worst case near the panel depends more strongly on where the
+ * evaluation point falls) and compute
+ *
+ *  (a) the panel-panel integrals H[0], H[1] with each rule of GetTCR
+ *      (applied to both panels) via GetPPIs_Cubature, and
+ *  (b) the reduced-field integrals \int f G, \int f x \nabla G over a
+ *      single panel at an evaluation point with each rule,
+ *
+ * and compare to a reference computed with the order-25 rule on
+ * subdivided panels (16-fold for panel pairs with rRel<4, 4-fold
+ * otherwise; 256-fold for field integrals). The worst relative error
+ * over all samples is converted to log10, clamped at 1e-12, and made
+ * monotonic (nonincreasing in rRel, nondecreasing in kR); the result
+ * is written to standard output in the form of the PPIErrorTable and
+ * FieldErrorTable declarations in IntegrationRules.cc.
+ *
+ * The grids and rule list below must match those in
+ * IntegrationRules.cc.
+ *
+ * Usage: CalibrateIntegrationRules [--NumSamples 64]
+ *                                  [--NumFieldSamples 256] [--Seed 1]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libhrutil.h>
+#include <libTriInt.h>
+
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+using namespace scuff;
+
+#define NUMRULES 11
+static const int RuleOrders[NUMRULES]={1, 2, 4, 5, 7, 9, 13, 14, 16, 20, 25};
+
+#define NUMKR 6
+static const double kRValues[NUMKR]={0.0, 0.5, 1.0, 2.0, 4.0, 8.0};
+
+#define NUMPPIRREL 9
+static const double PPIrRelValues[NUMPPIRREL]=
+ {2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 24.0, 32.0};
+
+#define NUMFIELDRREL 11
+static const double FieldrRelValues[NUMFIELDRREL]=
+ {1.0, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 24.0, 32.0};
+
+#define LOGERRMIN -12.0
+
+// at kR=0 we use a small nonzero k, since H[0] involves 1/k^2
+#define KMIN 1.0e-3
+
+/***************************************************************/
+/* split each of the NT triangles in V into 4 by joining the   */
+/* edge midpoints; V must have room for 4*NT triangles         */
+/***************************************************************/
+static int Subdivide(double (*V)[3][3], int NT)
+{
+  for(int nt=NT-1; nt>=0; nt--)
+   { double V0[3], V1[3], V2[3], M01[3], M12[3], M20[3];
+     VecCopy(V[nt][0], V0);
+     VecCopy(V[nt][1], V1);
+     VecCopy(V[nt][2], V2);
+     VecLinComb(0.5, V0, 0.5, V1, M01);
+     VecLinComb(0.5, V1, 0.5, V2, M12);
+     VecLinComb(0.5, V2, 0.5, V0, M20);
+     double (*T)[3][3] = V + 4*nt;
+     VecCopy(V0,  T[0][0]); VecCopy(M01, T[0][1]); VecCopy(M20, T[0][2]);
+     VecCopy(M01, T[1][0]); VecCopy(V1,  T[1][1]); VecCopy(M12, T[1][2]);
+     VecCopy(M20, T[2][0]); VecCopy(M12, T[2][1]); VecCopy(V2,  T[2][2]);
+     VecCopy(M01, T[3][0]); VecCopy(M12, T[3][1]); VecCopy(M20, T[3][2]);
+   };
+  return 4*NT;
+}
+
+static int Flatten(double V[3][3], int Levels, double (*T)[3][3])
+{
+  memcpy(T[0], V, 9*sizeof(double));
+  int NT=1;
+  for(int nl=0; nl<Levels; nl++)
+   NT=Subdivide(T, NT);
+  return NT;
+}
+
+/***************************************************************/
+/* panel-panel integrals H[0], H[1] for the RWG functions with */
+/* source/sink vertices Qa, Qb, with panels subdivided 4^Levels*/
+/* times. GetPPIs_Cubature normalizes by the panel areas, and  */
+/* all subtriangles have 1/4^Levels of the panel area.         */
+/***************************************************************/
+static void GetPPIs(double Va[3][3], double *Qa, double Vb[3][3], double *Qb,
+                    cdouble k, int Order, int Levels, cdouble H[2])
+{
+  static double Ta[256][3][3], Tb[256][3][3];
+  int NTa=Flatten(Va, Levels, Ta), NTb=Flatten(Vb, Levels, Tb);
+
+  GetPPIArgStruct MyArgs, *Args=&MyArgs;
+  InitGetPPIArgs(Args);
+  Args->k=k;
+
+  double Scale = 1.0/((double)(NTa*NTb));
+  H[0]=H[1]=0.0;
+  for(int nta=0; nta<NTa; nta++)
+   for(int ntb=0; ntb<NTb; ntb++)
+    { double *VVa[3]={Ta[nta][0], Ta[nta][1], Ta[nta][2]};
+      double *VVb[3]={Tb[ntb][0], Tb[ntb][1], Tb[ntb][2]};
+      GetPPIs_Cubature(Args, 0, Order, VVa, Qa, VVb, Qb);
+      H[0] += Scale*Args->H[0];
+      H[1] += Scale*Args->H[1];
+    };
+}
+
+/***************************************************************/
+/* reduced-field integrals S[0..2] = \int f G and              */
+/* S[3..5] = \int f x \nabla G over panel V (with source       */
+/* vertex Q) at evaluation point X0                            */
+/***************************************************************/
+static void GetFIs(double V[3][3], double *Q, double *X0,
+                   cdouble k, int Order, int Levels, cdouble S[6])
+{
+  static double T[65536][3][3];
+  int NT=Flatten(V, Levels, T);
+
+  int NumPts;
+  double *TCR=GetTCR(Order, &NumPts);
+  cdouble ik=cdouble(0.0,1.0)*k;
+
+  for(int n=0; n<6; n++)
+   S[n]=0.0;
+  for(int nt=0; nt<NT; nt++)
+   { double A[3], B[3], N[3];
+     VecSub(T[nt][1], T[nt][0], A);
+     VecSub(T[nt][2], T[nt][0], B);
+     double Jacobian=VecNorm(VecCross(A, B, N));
+     for(int np=0; np<NumPts; np++)
+      { double u=TCR[3*np], v=TCR[3*np+1], w=Jacobian*TCR[3*np+2];
+        double X[3], F[3], R[3], FxR[3];
+        for(int Mu=0; Mu<3; Mu++)
+         { X[Mu] = T[nt][0][Mu] + u*A[Mu] + v*B[Mu];
+           F[Mu] = X[Mu] - Q[Mu];
+           R[Mu] = X0[Mu] - X[Mu];
+         };
+        double r=VecNorm(R);
+        cdouble G=exp(ik*r)/(4.0*M_PI*r);
+        cdouble dGOverr=G*(ik*r-1.0)/(r*r);
+        VecCross(F, R, FxR);
+        for(int Mu=0; Mu<3; Mu++)
+         { S[Mu]   += w*G*F[Mu];
+           S[3+Mu] += w*dGOverr*FxR[Mu];
+         };
+      };
+   };
+}
+
+/***************************************************************/
+/* random unit vector, and random well-shaped triangle with    */
+/* centroid C and maximum vertex-centroid distance 1           */
+/***************************************************************/
+static void RandomDirection(double *D)
+{
+  for(;;)
+   { for(int Mu=0; Mu<3; Mu++)
+      D[Mu]=randU(-1.0,1.0);
+     double Norm=VecNorm(D);
+     if (Norm>0.1 && Norm<1.0)
+      { VecScale(D, 1.0/Norm);
+        return;
+      };
+   };
+}
+
+static void RandomPanel(double *C, double V[3][3])
+{
+  double N[3], T[3]={1.0, 0.0, 0.0}, E1[3], E2[3];
+  RandomDirection(N);
+  if (fabs(N[0])>0.9)
+   { T[0]=0.0; T[1]=1.0; };
+  VecNormalize(VecCross(N, T, E1));
+  VecCross(N, E1, E2);
+
+  double Theta0=randU(0.0, 2.0*M_PI);
+  for(int nv=0; nv<3; nv++)
+   { double Theta = Theta0 + nv*2.0*M_PI/3.0 + randU(-0.2, 0.2);
+     double r = randU(0.8, 1.0);
+     VecLinComb(r*cos(Theta), E1, r*sin(Theta), E2, V[nv]);
+   };
+
+  double Centroid[3]={0.0, 0.0, 0.0}, RMax=0.0;
+  for(int nv=0; nv<3; nv++)
+   VecPlusEquals(Centroid, 1.0/3.0, V[nv]);
+  for(int nv=0; nv<3; nv++)
+   RMax=fmax(RMax, VecDistance(V[nv], Centroid));
+  for(int nv=0; nv<3; nv++)
+   { VecSub(V[nv], Centroid, V[nv]);
+     VecScale(V[nv], 1.0/RMax);
+     VecPlusEquals(V[nv], 1.0, C);
+   };
+}
+
+/***************************************************************/
+/* LogError[nr][nrr][nk] is the log10 of the worst-case error  */
+/* of rule #nr at (rRel, kR) = (rRelValues[nrr], kRValues[nk]) */
+/***************************************************************/
+static void CalibratePPIs(int NumSamples, double *LogError)
+{
+  for(int nrr=0; nrr<NUMPPIRREL; nrr++)
+   for(int nk=0; nk<NUMKR; nk++)
+    { double rRel=PPIrRelValues[nrr];
+      cdouble k = kRValues[nk]==0.0 ? KMIN : kRValues[nk];
+      int RefLevels = rRel<4.0 ? 2 : 1;
+      double Worst[NUMRULES];
+      memset(Worst, 0, NUMRULES*sizeof(double));
+      for(int ns=0; ns<NumSamples; ns++)
+       { double Ca[3]={0.0, 0.0, 0.0}, Cb[3], Va[3][3], Vb[3][3];
+         RandomDirection(Cb);
+         VecScale(Cb, rRel);
+         RandomPanel(Ca, Va);
+         RandomPanel(Cb, Vb);
+         cdouble HRef[2];
+         GetPPIs(Va, Va[0], Vb, Vb[1], k, 25, RefLevels, HRef);
+         double Norm=abs(HRef[0]) + abs(HRef[1]);
+         for(int nr=0; nr<NUMRULES; nr++)
+          { cdouble H[2];
+            GetPPIs(Va, Va[0], Vb, Vb[1], k, RuleOrders[nr], 0, H);
+            double Error=(abs(H[0]-HRef[0]) + abs(H[1]-HRef[1])) / Norm;
+            Worst[nr]=fmax(Worst[nr], Error);
+          };
+       };
+      for(int nr=0; nr<NUMRULES; nr++)
+       LogError[ (nr*NUMPPIRREL + nrr)*NUMKR + nk ]
+        = fmax(LOGERRMIN, log10(Worst[nr] + 1.0e-17));
+    };
+}
+
+static void CalibrateFieldIntegrals(int NumSamples, double *LogError)
+{
+  for(int nrr=0; nrr<NUMFIELDRREL; nrr++)
+   for(int nk=0; nk<NUMKR; nk++)
+    { double rRel=FieldrRelValues[nrr];
+      cdouble k = kRValues[nk]==0.0 ? KMIN : kRValues[nk];
+      double Worst[NUMRULES];
+      memset(Worst, 0, NUMRULES*sizeof(double));
+      for(int ns=0; ns<NumSamples; ns++)
+       { double C[3]={0.0, 0.0, 0.0}, X0[3], V[3][3];
+         RandomDirection(X0);
+         VecScale(X0, rRel);
+         RandomPanel(C, V);
+         cdouble SRef[6];
+         GetFIs(V, V[0], X0, k, 25, 4, SRef);
+         double Norm = sqrt( norm(SRef[0]) + norm(SRef[1]) + norm(SRef[2]) )
+                      +sqrt( norm(SRef[3]) + norm(SRef[4]) + norm(SRef[5]) );
+         for(int nr=0; nr<NUMRULES; nr++)
+          { cdouble S[6];
+            GetFIs(V, V[0], X0, k, RuleOrders[nr], 0, S);
+            double Error=0.0;
+            for(int n=0; n<6; n++)
+             Error+=abs(S[n]-SRef[n]);
+            Worst[nr]=fmax(Worst[nr], Error/Norm);
+          };
+       };
+      for(int nr=0; nr<NUMRULES; nr++)
+       LogError[ (nr*NUMFIELDRREL + nrr)*NUMKR + nk ]
+        = fmax(LOGERRMIN, log10(Worst[nr] + 1.0e-17));
+    };
+}
+
+/***************************************************************/
+/* make the table monotonic so that looking up the grid point  */
+/* nearer the panel and at the next-higher kR gives an upper   */
+/* bound, then write it out as a C declaration                 */
+/***************************************************************/
+static void WriteTable(const char *Name, const char *NumrRelName,
+                       double *LogError, const double *rRelValues, int NumrRel)
+{
+  for(int nr=0; nr<NUMRULES; nr++)
+   { double *T = LogError + nr*NumrRel*NUMKR;
+     for(int nrr=NumrRel-2; nrr>=0; nrr--)
+      for(int nk=0; nk<NUMKR; nk++)
+       T[nrr*NUMKR + nk] = fmax(T[nrr*NUMKR + nk], T[(nrr+1)*NUMKR + nk]);
+     for(int nrr=0; nrr<NumrRel; nrr++)
+      for(int nk=1; nk<NUMKR; nk++)
+       T[nrr*NUMKR + nk] = fmax(T[nrr*NUMKR + nk], T[nrr*NUMKR + nk-1]);
+   };
+
+  printf("static const double %s[NUMRULES][%s][NUMKR]=\n",Name,NumrRelName);
+  printf(" {\n");
+  for(int nr=0; nr<NUMRULES; nr++)
+   { printf("   { // order %i\n",RuleOrders[nr]);
+     for(int nrr=0; nrr<NumrRel; nrr++)
+      { printf("     { ");
+        for(int nk=0; nk<NUMKR; nk++)
+         { // round first so that e.g. -0.04 is not written as -0.0
+           double LE=0.1*round(10.0*LogError[ (nr*NumrRel + nrr)*NUMKR + nk ]);
+           printf("%5.1f%s", LE + 0.0, nk<NUMKR-1 ? ", " : " ");
+         };
+        printf("}%s // rRel=%g\n", nrr<NumrRel-1 ? "," : " ", rRelValues[nrr]);
+      };
+     printf("   }%s\n", nr<NUMRULES-1 ? "," : "");
+   };
+  printf(" };\n");
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  InstallHRSignalHandler();
+  SetLogFileName("CalibrateIntegrationRules.log");
+
+  int NumSamples=64;
+  int NumFieldSamples=256;
+  int Seed=1;
+  /* name        type    #args  max_instances  storage    count  description*/
+  OptStruct OSArray[]=
+   { {"NumSamples",      PA_INT, 1, 1, (void *)&NumSamples,      0, "random panel pairs per table entry"},
+     {"NumFieldSamples", PA_INT, 1, 1, (void *)&NumFieldSamples, 0, "random panel/point configurations per table entry"},
+     {"Seed",            PA_INT, 1, 1, (void *)&Seed,            0, "random-number seed"},
+     {0,0,0,0,0,0,0}
+   };
+  ProcessOptions(argc, argv, OSArray);
+  srandom(Seed);
+
+  double *PPILogError
+   = (double *)mallocEC(NUMRULES*NUMPPIRREL*NUMKR*sizeof(double));
+  CalibratePPIs(NumSamples, PPILogError);
+
+  double *FieldLogError
+   = (double *)mallocEC(NUMRULES*NUMFIELDRREL*NUMKR*sizeof(double));
+  CalibrateFieldIntegrals(NumFieldSamples, FieldLogError);
+
+  printf("/***************************************************************/\n");
+  printf("/* log10(relative error) for panel-panel integrals             */\n");
+  printf("/***************************************************************/\n");
+  WriteTable("PPIErrorTable", "NUMPPIRREL", PPILogError, PPIrRelValues, NUMPPIRREL);
+  printf("\n");
+  printf("/***************************************************************/\n");
+  printf("/* log10(relative error) for reduced-field integrals           */\n");
+  printf("/***************************************************************/\n");
+  WriteTable("FieldErrorTable", "NUMFIELDRREL", FieldLogError, FieldrRelValues, NUMFIELDRREL);
+
+  free(PPILogError);
+  free(FieldLogError);
+  return 0;
+}
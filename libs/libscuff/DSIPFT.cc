@@ -36,6 +36,7 @@
 #include <libTriInt.h>
 #include <config.h>
 #include "PFTOptions.h"
+#include "libscuffInternals.h"
 
 #ifdef USE_OPENMP
  #include <omp.h>
@@ -67,7 +68,8 @@ inline int GetSRFluxIndex(int NX, int nt, int nx, int nq)
 
 HMatrix *GetSRFluxTrace(RWGGeometry *G, HMatrix *XMatrix, cdouble Omega,
                         HMatrix *DRMatrix, HMatrix *FMatrix,
-                        HMatrix *RFMatrix, bool RFMatrixDirty)
+                        HMatrix *RFMatrix, bool RFMatrixDirty,
+                        SCUFFWorkspace *Workspace)
 { 
   /***************************************************************/
   /* FIXME ? *****************************************************/
@@ -117,26 +119,25 @@ HMatrix *GetSRFluxTrace(RWGGeometry *G, HMatrix *XMatrix, cdouble Omega,
   /***************************************************************/
   /* allocate per-thread storage to avoid costly synchronization */
   /* primitives in the multithreaded loop                        */
-  /* [note the array is automatically zeroed by mallocEC()]      */
+  /* [note the array is zeroed by SCUFFWorkspace::GetBuffer()]   */
   /***************************************************************/
   int NumThreads=1;
 #ifdef USE_OPENMP
   NumThreads=GetNumThreads();
 #endif
+  SCUFFWorkspace LocalWorkspace;
+  if (Workspace==0) Workspace=&LocalWorkspace;
   size_t DeltaSRFluxSize = NumThreads*NX*NUMSRFLUX*sizeof(cdouble);
-  static size_t DeltaSRFluxSizeSave=0;
-  static cdouble *DeltaSRFlux = 0;
-  if (DeltaSRFluxSizeSave<DeltaSRFluxSize)
-   { 
-     DeltaSRFluxSizeSave=DeltaSRFluxSize;
-     DeltaSRFlux=(cdouble *)reallocEC(DeltaSRFlux,DeltaSRFluxSize);
-   }
-  memset(DeltaSRFlux, 0, DeltaSRFluxSize);
+  cdouble *DeltaSRFlux
+   = (cdouble *)Workspace->GetBuffer(WSSLOT_SRFLUX_DELTA, DeltaSRFluxSize);
 
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
-  G->UpdateCachedEpsMuValues(Omega);
+  cdouble *RegionEps = new cdouble[2*G->NumRegions];
+  cdouble *RegionMu  = RegionEps + G->NumRegions;
+  G->GetEpsMuValues(Omega, RegionEps, RegionMu);
+  int *RegionIndices = G->GetRegionIndices(XMatrix);
 #ifdef USE_OPENMP
   LogC("(%i threads)",NumThreads);
 #pragma omp parallel for schedule(dynamic,1),		\
@@ -146,9 +147,9 @@ HMatrix *GetSRFluxTrace(RWGGeometry *G, HMatrix *XMatrix, cdouble Omega,
    {
      double X[3];
      XMatrix->GetEntriesD(nx,"0:2",X);
-     int nr=G->GetRegionIndex(X);
-     double  MuAbs = TENTHIRDS*real(G->MuTF[nr] )*ZVAC;
-     double EpsAbs = TENTHIRDS*real(G->EpsTF[nr])/ZVAC;
+     int nr=RegionIndices[nx];
+     double  MuAbs = TENTHIRDS*real(RegionMu[nr] )*ZVAC;
+     double EpsAbs = TENTHIRDS*real(RegionEps[nr])/ZVAC;
     
      cdouble *EKN[3], *HKN[3];
      for(int Mu=0; Mu<3; Mu++)
@@ -232,7 +233,10 @@ HMatrix *GetSRFluxTrace(RWGGeometry *G, HMatrix *XMatrix, cdouble Omega,
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
-  delete RFMatrix;
+  free(RegionIndices);
+  delete[] RegionEps;
+  if (OwnsRFMatrix)
+   delete RFMatrix;
   return FMatrix;
 
 } // routine GetSRFlux
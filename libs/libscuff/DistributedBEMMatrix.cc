@@ -0,0 +1,161 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * DistributedBEMMatrix.cc -- assembly of arbitrary rectangular tiles
+ *                         -- of the BEM matrix, and of BEM matrices
+ *                         -- distributed over the ranks of an MPI job
+ *
+ * Each rank assembles only the NBxNB tiles of the matrix that it
+ * stores in the 2D block-cyclic layout of the DMatrix class, so
+ * the full matrix never exists on any one rank. The price is that
+ * the symmetry used by AssembleBEMMatrix() to compute only the upper
+ * triangle is available only within the tiles on the diagonal, since
+ * the transpose of an off-diagonal tile generally lives on a
+ * different rank.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <libhmat.h>
+#include <libhrutil.h>
+
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+namespace scuff {
+
+/***************************************************************/
+/* given a range [BF0, BF1) of basis-function indices within   */
+/* the overall BEM system, find the range of basis-function    */
+/* indices of surface ns that it covers. returns false if      */
+/* there are none.                                             */
+/***************************************************************/
+static bool GetBFRange(RWGGeometry *G, int ns, int BF0, int BF1, int BFRange[2])
+{
+  int Offset = G->BFIndexOffset[ns];
+  int NBF    = G->Surfaces[ns]->NumBFs;
+  BFRange[0] = (BF0 > Offset)     ? BF0 - Offset : 0;
+  BFRange[1] = (BF1 < Offset+NBF) ? BF1 - Offset : NBF;
+  return BFRange[0] < BFRange[1];
+}
+
+/***************************************************************/
+/* compute rows [RowStart, RowStart+NumRows) and columns       */
+/* [ColStart, ColStart+NumCols) of the BEM matrix and stamp    */
+/* them into M with the upper-left corner of the tile at       */
+/* (RowOffset, ColOffset). only compact geometries are         */
+/* supported.                                                  */
+/*                                                             */
+/* each surface-pair block overlapping the tile is computed    */
+/* directly into M, with GetSurfaceSurfaceInteractions writing */
+/* only the entries that fall inside the tile. a tile on the   */
+/* diagonal of the matrix is symmetric within each diagonal    */
+/* surface block, so there we compute only its upper triangle. */
+/***************************************************************/
+void RWGGeometry::AssembleBEMMatrixTile(cdouble Omega,
+                                        int RowStart, int NumRows,
+                                        int ColStart, int NumCols,
+                                        HMatrix *M,
+                                        int RowOffset, int ColOffset)
+{
+  if (LBasis)
+   ErrExit("%s:%i: BEM matrix tiles not supported for periodic geometries",__FILE__,__LINE__);
+
+  M->ZeroBlock(RowOffset, NumRows, ColOffset, NumCols);
+
+  bool DiagonalTile = (RowStart==ColStart && NumRows==NumCols);
+
+  GetSSIArgStruct GetSSIArgs, *Args=&GetSSIArgs;
+  InitGetSSIArgs(Args);
+  Args->G          = this;
+  Args->Omega      = Omega;
+  Args->B          = M;
+  Args->Accumulate = true;
+
+  int RowEnd = RowStart+NumRows, ColEnd = ColStart+NumCols;
+  for(int nsa=0; nsa<NumSurfaces; nsa++)
+   for(int nsb=0; nsb<NumSurfaces; nsb++)
+    {
+      if (    !GetBFRange(this, nsa, RowStart, RowEnd, Args->BFRangeA)
+           || !GetBFRange(this, nsb, ColStart, ColEnd, Args->BFRangeB)
+         ) continue;
+
+      Args->Sa        = Surfaces[nsa];
+      Args->Sb        = Surfaces[nsb];
+      Args->RowOffset = RowOffset + BFIndexOffset[nsa] - RowStart;
+      Args->ColOffset = ColOffset + BFIndexOffset[nsb] - ColStart;
+      Args->Symmetric = (DiagonalTile && nsa==nsb);
+      GetSurfaceSurfaceInteractions(Args);
+    };
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+DMatrix *RWGGeometry::AllocateDistributedBEMMatrix(int BlockSize)
+{
+  return new DMatrix(TotalBFs, TotalBFs, BlockSize);
+}
+
+/***************************************************************/
+/* assemble the BEM matrix into a distributed matrix. this     */
+/* must be called by all ranks; each rank assembles only its   */
+/* own tiles.                                                  */
+/***************************************************************/
+DMatrix *RWGGeometry::AssembleDistributedBEMMatrix(cdouble Omega, DMatrix *M)
+{
+  if (LBasis)
+   ErrExit("distributed BEM matrices are not supported for periodic geometries");
+  if (UseHRWGFunctions && NumMMJs>0)
+   ErrExit("distributed BEM matrices are not supported for multi-material junctions");
+
+  if (M==NULL)
+   M=AllocateDistributedBEMMatrix();
+  else if (M->NR!=TotalBFs || M->NC!=TotalBFs)
+   ErrExit("wrong-size matrix passed to AssembleDistributedBEMMatrix");
+
+  Log("Assembling distributed BEM matrix at Omega=%s (%ix%i grid, %ix%i local)",
+       z2s(Omega),M->NPRow,M->NPCol,M->NRLocal,M->NCLocal);
+
+  /*--------------------------------------------------------------*/
+  /*- loop over the NBxNB tiles stored on this rank; each local   */
+  /*- tile is a contiguous block of the local storage matrix      */
+  /*--------------------------------------------------------------*/
+  int NB = M->NB;
+  int NumLocalTiles = 0;
+  for(int lr=0; lr<M->NRLocal; lr+=NB)
+   for(int lc=0; lc<M->NCLocal; lc+=NB)
+    {
+      int RowStart = M->GlobalRow(lr);
+      int ColStart = M->GlobalCol(lc);
+      int NumRows  = (M->NRLocal - lr < NB) ? M->NRLocal - lr : NB;
+      int NumCols  = (M->NCLocal - lc < NB) ? M->NCLocal - lc : NB;
+      AssembleBEMMatrixTile(Omega, RowStart, NumRows, ColStart, NumCols,
+                            M->GetLocalMatrix(), lr, lc);
+      NumLocalTiles++;
+    };
+
+  Log("...assembled %i local tiles",NumLocalTiles);
+  return M;
+}
+
+} // namespace scuff
@@ -467,7 +467,8 @@ void GetExtinctionPFTIntegrals(RWGGeometry *G, int ns, int ne,
 /***************************************************************/
 void GetExtinctionPFTT(RWGGeometry *G, HVector *KN,
                        IncField *IF, cdouble Omega,
-                       HMatrix *PFTTMatrix, bool Interior)
+                       HMatrix *PFTTMatrix, bool Interior,
+                       SCUFFWorkspace *Workspace)
 {
   if ( PFTTMatrix->NR!=G->NumSurfaces || PFTTMatrix->NC != NUMPFTT )
    ErrExit("%s:%i: internal error", __FILE__, __LINE__);
@@ -480,13 +481,10 @@ void GetExtinctionPFTT(RWGGeometry *G, HVector *KN,
   int NQ=NUMPFTT;
   int NTNSNQ=NT*NS*NQ;
 
-  static int DeltaPFTTSize=0;
-  static double *DeltaPFTT=0;
-  if (DeltaPFTTSize < NTNSNQ)
-   { DeltaPFTTSize=NTNSNQ;
-     DeltaPFTT=(double *)reallocEC(DeltaPFTT, DeltaPFTTSize*sizeof(double));
-   };
-  memset(DeltaPFTT, 0, NTNSNQ*sizeof(double));
+  SCUFFWorkspace LocalWorkspace;
+  if (Workspace==0) Workspace=&LocalWorkspace;
+  double *DeltaPFTT
+   = (double *)Workspace->GetBuffer(WSSLOT_EXTPFT_DELTA, NTNSNQ*sizeof(double));
 
 #ifdef USE_OPENMP
 #pragma omp parallel for schedule(dynamic,1), num_threads(NT)
@@ -543,7 +541,8 @@ void GetExtinctionPFTT(RWGGeometry *G, HVector *KN,
 HMatrix *GetEMTPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
                          HVector *KNVector, HMatrix *DRMatrix,
                          HMatrix *PFTMatrix, bool Interior,
-                         int EMTPFTIMethod, bool Itemize)
+                         int EMTPFTIMethod, bool Itemize,
+                         SCUFFWorkspace *Workspace)
 { 
   /***************************************************************/
   /***************************************************************/
@@ -564,37 +563,17 @@ HMatrix *GetEMTPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
      )
    ErrExit("invalid PFTMatrix in GetEMTPFT");
 
-  /***************************************************************/
-  /* ScatteredPFTT[ns] = contributions of surface #ns to         */
-  /*                     scattered PFTT                          */
-  /***************************************************************/
-  static int NSSave=0;
-  static HMatrix **ScatteredPFTT=0, *ExtinctionPFTT=0;
-  if (NSSave!=NS)
-   { if (ScatteredPFTT)
-      { for(int ns=0; ns<NSSave; ns++)
-         if (ScatteredPFTT[ns]) 
-          delete ScatteredPFTT[ns];
-        free(ScatteredPFTT);
-       if (ExtinctionPFTT)
-        delete ExtinctionPFTT;
-      };
-     NSSave=NS;
-     ScatteredPFTT=(HMatrix **)mallocEC(NS*sizeof(HMatrix));
-     for(int ns=0; ns<NS; ns++)
-      ScatteredPFTT[ns]=new HMatrix(NS, NUMPFTT);
-     ExtinctionPFTT=new HMatrix(NS, NUMPFTT);
-   };
+  SCUFFWorkspace LocalWorkspace;
+  if (Workspace==0) Workspace=&LocalWorkspace;
 
   /***************************************************************/
+  /* ScatteredPFTT(nsa, nsb*NUMPFTT + nq) = contribution of      */
+  /*  surface #nsb to scattered PFTT quantity nq on surface #nsa */
   /***************************************************************/
-  /***************************************************************/
-  static int init=0;
-  if (init==0)
-   { init=1;
-     GetGCMEArgStruct MyArgs;
-     InitGetGCMEArgs(&MyArgs);
-   };
+  HMatrix *ScatteredPFTT
+   = Workspace->GetMatrix(WSSLOT_EMTPFT_SCATTERED, NS, NS*NUMPFTT);
+  HMatrix *ExtinctionPFTT
+   = Workspace->GetMatrix(WSSLOT_EMTPFT_EXTINCTION, NS, NUMPFTT);
 
   /*--------------------------------------------------------------*/
   /*- loop over all edge pairs to get scattered PFT contributions */
@@ -609,15 +588,8 @@ HMatrix *GetEMTPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
   int NQ      = NUMPFTT;
   int NS2NQ   = NS*NS*NQ;
   int NTNS2NQ = NT*NS*NS*NQ; 
-  static int DeltaPFTTSize=0;
-  static double *DeltaPFTT=0;
-  if ( DeltaPFTTSize < NTNS2NQ )
-   { Log("(re)allocating DeltaPFTT (%i,%i)",DeltaPFTTSize,NTNS2NQ);
-     DeltaPFTTSize=NTNS2NQ;
-     if (DeltaPFTT) free(DeltaPFTT);
-     DeltaPFTT = (double *)mallocEC(DeltaPFTTSize*sizeof(double));
-   };
-  memset(DeltaPFTT, 0, NTNS2NQ*sizeof(double));
+  double *DeltaPFTT
+   = (double *)Workspace->GetBuffer(WSSLOT_EMTPFT_DELTA, NTNS2NQ*sizeof(double));
 
   /*--------------------------------------------------------------*/
   /*- multithreaded loop over all basis functions on all surfaces-*/
@@ -780,19 +752,18 @@ HMatrix *GetEMTPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
   /*--------------------------------------------------------------*/
   /*- accumulate contributions of all threads                     */
   /*--------------------------------------------------------------*/
-  for(int ns=0; ns<NS; ns++)
-   ScatteredPFTT[ns]->Zero();
+  ScatteredPFTT->Zero();
   for(int nsa=0; nsa<NS; nsa++)
    for(int nsb=0; nsb<NS; nsb++)
     for(int nq=0; nq<NQ; nq++)
      for(int nt=0; nt<NT; nt++)
-      ScatteredPFTT[nsb]->AddEntry(nsa, nq, DeltaPFTT[ nt*NS2NQ + nsa*NS*NQ + nsb*NQ + nq ]);
+      ScatteredPFTT->AddEntry(nsa, nsb*NQ + nq, DeltaPFTT[ nt*NS2NQ + nsa*NS*NQ + nsb*NQ + nq ]);
 
   /***************************************************************/
   /* get incident-field contributions ****************************/
   /***************************************************************/
   if (IF)
-   GetExtinctionPFTT(G, KNVector, IF, Omega, ExtinctionPFTT, Interior);
+   GetExtinctionPFTT(G, KNVector, IF, Omega, ExtinctionPFTT, Interior, Workspace);
   else
    ExtinctionPFTT->Zero();
    
@@ -813,17 +784,17 @@ HMatrix *GetEMTPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
       for(int nsb=0; nsb<NS; nsb++)
        { 
          if (nq==PFT_PABS)
-          PFTMatrix->AddEntry(nsa,nq,-1.0*ScatteredPFTT[nsb]->GetEntry(nsa,PFT_PSCAT));
+          PFTMatrix->AddEntry(nsa,nq,-1.0*ScatteredPFTT->GetEntry(nsa,nsb*NQ+PFT_PSCAT));
          else if (nq==PFT_PSCAT)
-          PFTMatrix->AddEntry(nsa,nq,+1.0*ScatteredPFTT[nsb]->GetEntry(nsa,PFT_PSCAT));
+          PFTMatrix->AddEntry(nsa,nq,+1.0*ScatteredPFTT->GetEntry(nsa,nsb*NQ+PFT_PSCAT));
          else // force or torque 
-          PFTMatrix->AddEntry(nsa,nq,-1.0*ScatteredPFTT[nsb]->GetEntry(nsa,nq));
+          PFTMatrix->AddEntry(nsa,nq,-1.0*ScatteredPFTT->GetEntry(nsa,nsb*NQ+nq));
        };
 
       if (PFT_XTORQUE<=nq && nq<=PFT_ZTORQUE)
        { PFTMatrix->AddEntry(nsa,nq,ExtinctionPFTT->GetEntry(nsa,nq+3));
          for(int nsb=0; nsb<NS; nsb++)
-          PFTMatrix->AddEntry(nsa, nq, -1.0*ScatteredPFTT[nsb]->GetEntry(nsa,nq+3));
+          PFTMatrix->AddEntry(nsa, nq, -1.0*ScatteredPFTT->GetEntry(nsa,nsb*NQ+nq+3));
        };
     };
   
@@ -879,7 +850,7 @@ HMatrix *GetEMTPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
         for(int nsb=0; nsb<NS; nsb++)
          { fprintf(f,"%e %02i ",real(Omega),nsb+1);
             for(int nq=0; nq<NUMPFTT; nq++)
-             fprintf(f,"%+e ",ScatteredPFTT[nsb]->GetEntryD(nsa,nq));
+             fprintf(f,"%+e ",ScatteredPFTT->GetEntryD(nsa,nsb*NQ+nq));
            fprintf(f,"\n");
          };
         fclose(f);
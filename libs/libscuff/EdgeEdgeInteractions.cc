@@ -44,6 +44,53 @@ namespace scuff {
 // DBFTHRESHOLD * the larger of the radii of the two basis functions
 #define DBFTHRESHOLD 10.0
 
+/***************************************************************/
+/* fetch the indices of the positive and negative panels of    */
+/* the basis function for edge #ne (Panels[1]=-1 for half-RWG  */
+/* functions), the indices of the source/sink vertices within  */
+/* those panels, and the edge length. full RWG edges are read  */
+/* from the packed mesh arrays; exterior half-RWG edges (ne<0) */
+/* are not packed.                                             */
+/***************************************************************/
+static double GetEdgePanels(RWGSurface *S, int ne, int Panels[2], int QIndices[2])
+{
+  RWGPackedMesh *PM=S->Packed;
+  if ( 0<=ne && ne<PM->NumEdges )
+   { Panels[0]   = PM->EPanels[2*ne+0];
+     Panels[1]   = PM->EPanels[2*ne+1];
+     QIndices[0] = PM->EQIndex[2*ne+0];
+     QIndices[1] = PM->EQIndex[2*ne+1];
+     return PM->ELength[ne];
+   };
+
+  RWGEdge *E=S->GetEdgeByIndex(ne);
+  Panels[0]   = E->iPPanel;
+  Panels[1]   = E->iMPanel;
+  QIndices[0] = E->PIndex;
+  QIndices[1] = E->MIndex;
+  return E->Length;
+}
+
+/***************************************************************/
+/* compute one panel-panel interaction and record the algorithm*/
+/* (and, if requested, the time) it took in Args->PPIStats     */
+/***************************************************************/
+static void GetPPIsWithStatistics(GetEEIArgStruct *Args,
+                                  GetPPIArgStruct *GetPPIArgs,
+                                  cdouble *H, cdouble *GradH, cdouble *dHdT)
+{
+  double T0 = Args->TimePPIs ? Secs() : 0.0;
+  GetPanelPanelInteractions(GetPPIArgs, H, GradH, dHdT);
+
+  PPIStatistics *Stats=&(Args->PPIStats);
+  int WhichAlgorithm=GetPPIArgs->WhichAlgorithm;
+  Stats->Count[WhichAlgorithm]++;
+  if (GetPPIArgs->Order>0)
+   Stats->OrderCount[GetPPIArgs->Order]++;
+  if (Args->TimePPIs)
+   Stats->Time[WhichAlgorithm] += Secs() - T0;
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -60,8 +107,9 @@ void GetEdgeEdgeInteractions(GetEEIArgStruct *Args)
   int NumGradientComponents = Args->NumGradientComponents;
   int NumTorqueAxes         = Args->NumTorqueAxes;
 
-  RWGEdge *Ea=Sa->GetEdgeByIndex(nea);
-  RWGEdge *Eb=Sb->GetEdgeByIndex(neb);
+  int PanelsA[2], QIndicesA[2], PanelsB[2], QIndicesB[2];
+  double LengthA = GetEdgePanels(Sa, nea, PanelsA, QIndicesA);
+  double LengthB = GetEdgePanels(Sb, neb, PanelsB, QIndicesB);
 
   /***************************************************************/
   /* Since this code doesn't work at DC anyway, we don't bother  */
@@ -151,37 +199,33 @@ void GetEdgeEdgeInteractions(GetEEIArgStruct *Args)
   /*--------------------------------------------------------------*/
   /*- positive-positive, positive-negative, etc. -----------------*/
   /*--------------------------------------------------------------*/
-  GetPPIArgs->npa = Ea->iPPanel;     GetPPIArgs->iQa = Ea->PIndex;
-  GetPPIArgs->npb = Eb->iPPanel;     GetPPIArgs->iQb = Eb->PIndex;
-  GetPanelPanelInteractions(GetPPIArgs, HPP, GradHPP, dHdTPP);
-  Args->PPIAlgorithmCount[GetPPIArgs->WhichAlgorithm]++;
-
-  if ( Eb->iMPanel!=-1 )
-   { GetPPIArgs->npa = Ea->iPPanel;     GetPPIArgs->iQa = Ea->PIndex;
-     GetPPIArgs->npb = Eb->iMPanel;     GetPPIArgs->iQb = Eb->MIndex;
-     GetPanelPanelInteractions(GetPPIArgs, HPM, GradHPM, dHdTPM);
-     Args->PPIAlgorithmCount[GetPPIArgs->WhichAlgorithm]++;
+  GetPPIArgs->npa = PanelsA[0];     GetPPIArgs->iQa = QIndicesA[0];
+  GetPPIArgs->npb = PanelsB[0];     GetPPIArgs->iQb = QIndicesB[0];
+  GetPPIsWithStatistics(Args, GetPPIArgs, HPP, GradHPP, dHdTPP);
+
+  if ( PanelsB[1]!=-1 )
+   { GetPPIArgs->npa = PanelsA[0];     GetPPIArgs->iQa = QIndicesA[0];
+     GetPPIArgs->npb = PanelsB[1];     GetPPIArgs->iQb = QIndicesB[1];
+     GetPPIsWithStatistics(Args, GetPPIArgs, HPM, GradHPM, dHdTPM);
    };
 
-  if ( Ea->iMPanel!=-1 )
-   { GetPPIArgs->npa = Ea->iMPanel;     GetPPIArgs->iQa = Ea->MIndex;
-     GetPPIArgs->npb = Eb->iPPanel;     GetPPIArgs->iQb = Eb->PIndex;
-     GetPanelPanelInteractions(GetPPIArgs, HMP, GradHMP, dHdTMP);
-     Args->PPIAlgorithmCount[GetPPIArgs->WhichAlgorithm]++;
+  if ( PanelsA[1]!=-1 )
+   { GetPPIArgs->npa = PanelsA[1];     GetPPIArgs->iQa = QIndicesA[1];
+     GetPPIArgs->npb = PanelsB[0];     GetPPIArgs->iQb = QIndicesB[0];
+     GetPPIsWithStatistics(Args, GetPPIArgs, HMP, GradHMP, dHdTMP);
    };
  
-  if ( Ea->iMPanel!=-1 && Eb->iMPanel!=-1 )
-   { GetPPIArgs->npa = Ea->iMPanel;     GetPPIArgs->iQa = Ea->MIndex;
-     GetPPIArgs->npb = Eb->iMPanel;     GetPPIArgs->iQb = Eb->MIndex;
-     GetPanelPanelInteractions(GetPPIArgs, HMM, GradHMM, dHdTMM);
-     Args->PPIAlgorithmCount[GetPPIArgs->WhichAlgorithm]++;
+  if ( PanelsA[1]!=-1 && PanelsB[1]!=-1 )
+   { GetPPIArgs->npa = PanelsA[1];     GetPPIArgs->iQa = QIndicesA[1];
+     GetPPIArgs->npb = PanelsB[1];     GetPPIArgs->iQb = QIndicesB[1];
+     GetPPIsWithStatistics(Args, GetPPIArgs, HMM, GradHMM, dHdTMM);
    };
 
   /*--------------------------------------------------------------*/
   /*- assemble the final quantities ------------------------------*/
   /*--------------------------------------------------------------*/
-  double GPreFac = Ea->Length*Eb->Length;
-  cdouble CPreFac = Ea->Length*Eb->Length / (II*k);
+  double GPreFac = LengthA*LengthB;
+  cdouble CPreFac = LengthA*LengthB / (II*k);
   int Mu;
 
   Args->GC[0] = GPreFac*(HPP[0] - HPM[0] - HMP[0] + HMM[0]);
@@ -305,7 +349,8 @@ void InitGetEEIArgs(GetEEIArgStruct *Args)
   Args->Force=EEI_NOFORCE;
   Args->GBA=0;
   Args->ForceFullEwald=false;
-  memset(Args->PPIAlgorithmCount, 0, NUMPPIALGORITHMS*sizeof(unsigned));
+  InitPPIStatistics(&(Args->PPIStats));
+  Args->TimePPIs=false;
 }
 
 /***************************************************************/
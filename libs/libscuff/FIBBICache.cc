@@ -47,6 +47,7 @@
 
 #include <libhrutil.h>
 #include "libscuff.h"
+#include "libscuffInternals.h"
 
 namespace scuff {
 
@@ -294,7 +295,8 @@ void FIBBICache::GetFIBBIData(RWGSurface *SA, int neA,
   pthread_rwlock_unlock(&lock);
 
   if ( Found )
-   { Hits++;
+   { __sync_fetch_and_add(&Hits, 1);
+     ProfileCount("FIBBICache.Hits");
      return;
    }
   
@@ -302,8 +304,12 @@ void FIBBICache::GetFIBBIData(RWGSurface *SA, int neA,
   /* if it was not found, compute a new FIBBI data record and add*/
   /* it to the cache                                             */
   /***************************************************************/
-  Misses++;
-  ComputeFIBBIData(SA, neA, SB, neB, FIBBIs);
+  __sync_fetch_and_add(&Misses, 1);
+  ProfileCount("FIBBICache.Misses");
+  if ( !SharedCacheLookup(SHAREDCACHE_FIBBI, Key.Key, FIBBIs) )
+   { ComputeFIBBIData(SA, neA, SB, neB, FIBBIs);
+     SharedCacheInsert(SHAREDCACHE_FIBBI, Key.Key, FIBBIs);
+   };
   DataStruct DS;
   memcpy(DS.Data, FIBBIs, DATASIZE);
   pthread_rwlock_wrlock(&lock);
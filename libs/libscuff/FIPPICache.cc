@@ -165,7 +165,8 @@ QIFIPPIData *FIPPICache::GetQIFIPPIData(double **OVa, double **OVb, int ncv)
   FCLock.read_unlock();
 
   if ( p != (KVM->end()) )
-   { Hits++;
+   { 
+     __sync_fetch_and_add(&Hits, 1);
      return (QIFIPPIData *)(p->second);
    }
   
@@ -173,11 +174,16 @@ QIFIPPIData *FIPPICache::GetQIFIPPIData(double **OVa, double **OVb, int ncv)
   /* if it was not found, allocate and compute a new QIFIPPIData */
   /* structure, then add this structure to the cache             */
   /***************************************************************/
-  Misses++;
+  __sync_fetch_and_add(&Misses, 1);
   KeyStruct *K2 = (KeyStruct *)mallocEC(sizeof(*K2));
   memcpy(K2->Key, K.Key, KEYSIZE);
   QIFIPPIData *QIFD=(QIFIPPIData *)mallocEC(sizeof *QIFD);
-  ComputeQIFIPPIData(OVa, OVb, ncv, QIFD);
+
+  // another process on this node may already have computed it
+  if ( !SharedCacheLookup(SHAREDCACHE_FIPPI, K.Key, QIFD) )
+   { ComputeQIFIPPIData(OVa, OVb, ncv, QIFD);
+     SharedCacheInsert(SHAREDCACHE_FIPPI, K.Key, QIFD);
+   };
    
   FCLock.write_lock();
   KVM->insert( KeyValuePair(*K2, QIFD) );
@@ -35,6 +35,31 @@
 
 namespace scuff{
 
+/***************************************************************/
+/* pack the output of GBarVDEwald into the array of function   */
+/* values and derivatives expected by Interp2D / Interp3D      */
+/***************************************************************/
+static void GBarVDToPhiVD2D(cdouble *GBarVD, double *PhiVD)
+{
+  PhiVD[0] = real(GBarVD[0]); // real(G)
+  PhiVD[1] = real(GBarVD[1]); // real(dGdX)
+  PhiVD[2] = real(GBarVD[2]); // real(dGdY) = real(dGdRho)
+  PhiVD[3] = real(GBarVD[4]); // real(dG2dXdY) = real(dG2dXdRho)
+
+  PhiVD[4] = imag(GBarVD[0]); // imag(G)
+  PhiVD[5] = imag(GBarVD[1]); // imag(dGdX)
+  PhiVD[6] = imag(GBarVD[2]); // imag(dGdRho)
+  PhiVD[7] = imag(GBarVD[4]); // imag(dG2dXdRho)
+}
+
+static void GBarVDToPhiVD3D(cdouble *GBarVD, double *PhiVD)
+{
+  for(int ns=0; ns<8; ns++)
+   { PhiVD[ns]   = real(GBarVD[ns]);
+     PhiVD[8+ns] = imag(GBarVD[ns]);
+   };
+}
+
 /***************************************************************/
 /* entry point for GBarVD that has the proper prototype for    */
 /* passage to the Interp2D() initialization routine.           */
@@ -51,17 +76,7 @@ void GBarVDPhi2D(double x, double Rho, void *UserData, double *PhiVD)
   cdouble GBarVD[8];
   GBarVDEwald(R, GBA->k, GBA->kBloch, GBA->LBV, GBA->LDim,
               -1.0, GBA->ExcludeInnerCells, GBarVD);
- 
-  PhiVD[0] = real(GBarVD[0]); // real(G)
-  PhiVD[1] = real(GBarVD[1]); // real(dGdX)
-  PhiVD[2] = real(GBarVD[2]); // real(dGdY) = real(dGdRho)
-  PhiVD[3] = real(GBarVD[4]); // real(dG2dXdY) = real(dG2dXdRho)
-
-  PhiVD[4] = imag(GBarVD[0]); // imag(G)
-  PhiVD[5] = imag(GBarVD[1]); // imag(dGdX)
-  PhiVD[6] = imag(GBarVD[2]); // imag(dGdRho)
-  PhiVD[7] = imag(GBarVD[4]); // imag(dG2dXdRho)
-
+  GBarVDToPhiVD2D(GBarVD, PhiVD);
 }
 
 /***************************************************************/
@@ -81,24 +96,7 @@ void GBarVDPhi3D(double X1, double X2, double X3, void *UserData, double *PhiVD)
   cdouble GBarVD[8];
   GBarVDEwald(R, GBA->k, GBA->kBloch, GBA->LBV, GBA->LDim,
               -1.0, GBA->ExcludeInnerCells, GBarVD);
- 
-  PhiVD[ 0] = real(GBarVD[0]);
-  PhiVD[ 1] = real(GBarVD[1]);
-  PhiVD[ 2] = real(GBarVD[2]);
-  PhiVD[ 3] = real(GBarVD[3]);
-  PhiVD[ 4] = real(GBarVD[4]);
-  PhiVD[ 5] = real(GBarVD[5]);
-  PhiVD[ 6] = real(GBarVD[6]);
-  PhiVD[ 7] = real(GBarVD[7]);
-  PhiVD[ 8] = imag(GBarVD[0]);
-  PhiVD[ 9] = imag(GBarVD[1]);
-  PhiVD[10] = imag(GBarVD[2]);
-  PhiVD[11] = imag(GBarVD[3]);
-  PhiVD[12] = imag(GBarVD[4]);
-  PhiVD[13] = imag(GBarVD[5]);
-  PhiVD[14] = imag(GBarVD[6]);
-  PhiVD[15] = imag(GBarVD[7]);
-
+  GBarVDToPhiVD3D(GBarVD, PhiVD);
 } 
 
 void GBarVDPhi2DND(dVec X, void *UserData, double *PhiVD, iVec dXMax)
@@ -333,6 +331,81 @@ void GetOptimalGridSpacing2D(GBarAccelerator *GBA,
 
 }
 
+/***************************************************************/
+/* compute the table of GBar values and derivatives at the     */
+/* points of an interpolation grid, in the layout expected by  */
+/* the Interp2D / Interp3D constructors that accept a table.   */
+/*                                                             */
+/* the grid is traversed in rows along which only x (1D case)  */
+/* or only y (2D case) varies, and each row is handled by a    */
+/* single batched call to GBarVDEwald; this allows the lattice */
+/* sums to share everything that does not depend on the        */
+/* in-plane coordinates among all points in a row.             */
+/***************************************************************/
+static double *GetGBarPhiVDTable1D(GBarAccelerator *GBA,
+                                   double *XPoints, int nx,
+                                   double *RhoPoints, int nRho)
+{
+  double *PhiVDTable = (double *)mallocEC(nx*nRho*8*sizeof(double));
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic,1), num_threads(GetNumThreads())
+#endif
+  for(int nr=0; nr<nRho; nr++)
+   { 
+     double *R       = (double *)mallocEC(3*nx*sizeof(double));
+     cdouble *GBarVD = (cdouble *)mallocEC(8*nx*sizeof(cdouble));
+     for(int n=0; n<nx; n++)
+      { R[3*n + 0] = XPoints[n];
+        R[3*n + 1] = RhoPoints[nr];
+        R[3*n + 2] = 0.0;
+      };
+     GBarVDEwald(nx, R, GBA->k, GBA->kBloch, GBA->LBV, GBA->LDim,
+                 -1.0, GBA->ExcludeInnerCells, GBarVD);
+     for(int n=0; n<nx; n++)
+      GBarVDToPhiVD2D(GBarVD + 8*n, PhiVDTable + 8*(nr + nRho*n));
+     free(R);
+     free(GBarVD);
+   };
+
+  return PhiVDTable;
+}
+
+static double *GetGBarPhiVDTable2D(GBarAccelerator *GBA,
+                                   double XMin, double XMax, int nx,
+                                   double YMin, double YMax, int ny,
+                                   double ZMin, double ZMax, int nz)
+{
+  double *PhiVDTable = (double *)mallocEC(nx*ny*nz*16*sizeof(double));
+
+  double DX = (XMax-XMin) / ((double)(nx-1));
+  double DY = (YMax-YMin) / ((double)(ny-1));
+  double DZ = (ZMax-ZMin) / ((double)(nz-1));
+
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic,1), num_threads(GetNumThreads())
+#endif
+  for(int nxz=0; nxz<nx*nz; nxz++)
+   { 
+     int n1 = nxz / nz, n3 = nxz % nz;
+     double *R       = (double *)mallocEC(3*ny*sizeof(double));
+     cdouble *GBarVD = (cdouble *)mallocEC(8*ny*sizeof(cdouble));
+     for(int n2=0; n2<ny; n2++)
+      { R[3*n2 + 0] = XMin + n1*DX;
+        R[3*n2 + 1] = YMin + n2*DY;
+        R[3*n2 + 2] = ZMin + n3*DZ;
+      };
+     GBarVDEwald(ny, R, GBA->k, GBA->kBloch, GBA->LBV, GBA->LDim,
+                 -1.0, GBA->ExcludeInnerCells, GBarVD);
+     for(int n2=0; n2<ny; n2++)
+      GBarVDToPhiVD3D(GBarVD + 8*n2, PhiVDTable + 16*(n3 + nz*(n2 + ny*n1)));
+     free(R);
+     free(GBarVD);
+   };
+
+  return PhiVDTable;
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -480,10 +553,12 @@ GBarAccelerator *CreateGBarAccelerator(HMatrix *LBasis,
          if (nRho>NMax) nRho=NMax;
        }
 
+      double *PhiVDTable=GetGBarPhiVDTable1D(GBA, XPoints, nx, RhoPoints, nRho);
       GBA->I3D=0;
-      GBA->I2D=new Interp2D(XPoints, nx, RhoPoints, nRho,
-                            2, GBarVDPhi2D, (void *)GBA, LMDILogLevel);
+      GBA->I2D=new Interp2D(PhiVDTable, XPoints, nx, RhoPoints, nRho,
+                            2, LMDILogLevel);
 
+      free(PhiVDTable);
       delete[] XPoints;
 
    }
@@ -536,10 +611,14 @@ GBarAccelerator *CreateGBarAccelerator(HMatrix *LBasis,
          if (nRho>NMax) nRho=NMax;
        }
 
+      double *PhiVDTable=GetGBarPhiVDTable2D(GBA, -0.5*Lx, 0.5*Lx, nx,
+                                                  -0.5*Ly, 0.5*Ly, ny,
+                                                  RhoMin, RhoMax, nRho);
       GBA->I2D=0;
-      GBA->I3D=new Interp3D(-0.5*Lx, 0.5*Lx, nx, -0.5*Ly, 0.5*Ly, ny,
-                            RhoMin, RhoMax, nRho,
-                            2, GBarVDPhi3D, (void *)GBA, LMDILogLevel);
+      GBA->I3D=new Interp3D(PhiVDTable,
+                            -0.5*Lx, 0.5*Lx, nx, -0.5*Ly, 0.5*Ly, ny,
+                            RhoMin, RhoMax, nRho, 2, LMDILogLevel);
+      free(PhiVDTable);
    }
 
   return GBA;
@@ -39,6 +39,12 @@ void GBarVDEwald(double *R, cdouble k, double *kBloch,
                  double (*LBV)[3], int LDim,
                  double E, bool ExcludeInnerCells, cdouble *GBarVD);
 
+// batched version: GBarVD[8*np + (0..7)] are the values and
+// derivatives at the point R[3*np + (0,1,2)], np=0..NumPoints-1
+void GBarVDEwald(int NumPoints, double *R, cdouble k, double *kBloch,
+                 double (*LBV)[3], int LDim,
+                 double E, bool ExcludeInnerCells, cdouble *GBarVD);
+
 /***************************************************************/
 /* interpolation-based acceleration of periodic GF evaluation  */
 /***************************************************************/
@@ -293,39 +293,56 @@ void GetEEF(double z, double E, cdouble Q, cdouble *EEF, cdouble *EEFPrime)
 /***************************************************************/
 /* add the contribution of a single reciprocal-lattice vector  */
 /* G = n1*Gamma1 + n2*Gamma2 to the reciprocal-lattice sum     */
-/* that defines GBarDistant in the 2D case.                    */
+/* that defines GBarDistant in the 2D case, for each of        */
+/* NumPoints points R[3*np + (0,1,2)].                         */
+/*                                                             */
+/* Q, 1/Q, and the singularity check depend only on G, so they */
+/* are computed once for all points; the erfc-dependent factor */
+/* EEF depends on G and z only, so it is recomputed only when  */
+/* z differs from that of the previous point (the interpolation*/
+/* tables pass batches of points with a common z coordinate).  */
 /***************************************************************/
-void AddGLong2D(double R[3], cdouble k, double P[2],
+void AddGLong2D(int NumPoints, double *R, cdouble k, double P[2],
                 int n1, int n2, double Gamma[3][3],
                 double E, cdouble *GBarVD, bool &Singular)
 { 
   if (Singular) return;
 
   double PmG[2];
-  cdouble PreFactor, Q, EEF, EEFPrime;
-   
   PmG[0] = P[0] - n1*Gamma[0][0] - n2*Gamma[1][0];
   PmG[1] = P[1] - n1*Gamma[0][1] - n2*Gamma[1][1];
 
-  Q = sqrt ( PmG[0]*PmG[0] + PmG[1]*PmG[1] - k*k );
+  cdouble Q = sqrt ( PmG[0]*PmG[0] + PmG[1]*PmG[1] - k*k );
 
   if ( abs(Q) < 1.0e-4*abs(k) )
    { Singular=true;
      return;
    };
 
-  PreFactor = exp( II * (PmG[0]*R[0] + PmG[1]*R[1]) ) / Q;
-
-  GetEEF(R[2], E, Q, &EEF, &EEFPrime);
+  cdouble OneOverQ = 1.0/Q;
+  double PmGxPmGy = PmG[0]*PmG[1];
 
-  GBarVD[0] += PreFactor * EEF;
-  GBarVD[1] += II*PmG[0]*PreFactor*EEF;
-  GBarVD[2] += II*PmG[1]*PreFactor*EEF;
-  GBarVD[3] += PreFactor*EEFPrime;
-  GBarVD[4] += -PmG[0]*PmG[1]*PreFactor*EEF;
-  GBarVD[5] += II*PmG[0]*PreFactor*EEFPrime;
-  GBarVD[6] += II*PmG[1]*PreFactor*EEFPrime;
-  GBarVD[7] += -PmG[0]*PmG[1]*PreFactor*EEFPrime;
+  cdouble EEF=0.0, EEFPrime=0.0;
+  for(int np=0; np<NumPoints; np++)
+   { 
+     double *RR = R + 3*np;
+     if ( np==0 || RR[2]!=R[3*(np-1) + 2] )
+      GetEEF(RR[2], E, Q, &EEF, &EEFPrime);
+
+     double Phase = PmG[0]*RR[0] + PmG[1]*RR[1];
+     cdouble PreFactor = cdouble(cos(Phase), sin(Phase)) * OneOverQ;
+     cdouble PFEEF = PreFactor*EEF, PFEEFPrime = PreFactor*EEFPrime;
+
+     cdouble *Sum = GBarVD + NSUM*np;
+     Sum[0] += PFEEF;
+     Sum[1] += II*PmG[0]*PFEEF;
+     Sum[2] += II*PmG[1]*PFEEF;
+     Sum[3] += PFEEFPrime;
+     Sum[4] += -PmGxPmGy*PFEEF;
+     Sum[5] += II*PmG[0]*PFEEFPrime;
+     Sum[6] += II*PmG[1]*PFEEFPrime;
+     Sum[7] += -PmGxPmGy*PFEEFPrime;
+   };
 
 }
 
@@ -355,9 +372,15 @@ cdouble GFullTwiddle1D(double kx, double Rho, cdouble k,
 /* If dGdRho is non-null, then on return we have     */
 /* dGdRho[0] = dG   / dRho                           */
 /* dGdRho[1] = dG^2 / dRho^2                         */
+/*                                                   */
+/* If E1 is non-null, it points to a cache for the   */
+/* quantity ExpInt(Arg), which depends on kx, k, E   */
+/* but not on Rho: it is computed on the first call  */
+/* with *E1==0 and reused on subsequent calls.       */
 /*****************************************************/
 cdouble GetGLongTwiddle1D(double kx, double Rho, cdouble k, double E,
-                          cdouble *dGdRho, bool &Singular)
+                          cdouble *dGdRho, bool &Singular,
+                          cdouble *E1=0)
 {
   if (Singular)
    return 0.0;
@@ -376,7 +399,13 @@ cdouble GetGLongTwiddle1D(double kx, double Rho, cdouble k, double E,
 
   double E2        = E*E;
   cdouble Arg      = kt2 / (4.0*E2);
-  cdouble Eqp1     = ExpInt(Arg);
+  cdouble Eqp1;
+  if (E1 && *E1!=0.0)
+   Eqp1 = *E1;
+  else
+   { Eqp1 = ExpInt(Arg);
+     if (E1) *E1=Eqp1;
+   };
   double NormFac   = 8.0*M_PI*M_PI;
 
   if (Rho==0.0)
@@ -424,11 +453,15 @@ cdouble GetGLongTwiddle1D(double kx, double Rho, cdouble k, double E,
   
 }
 
-// 
-// 
-void AddGLong1D(double R[3], double Rho, cdouble k, double P[2],
-                int m, double Gamma[3][3], double E, cdouble *GBarVD,
-                bool &Singular)
+/***************************************************************/
+/* 1D analogue of AddGLong2D. Here GLongTwiddle depends on the */
+/* point only through Rho, so it is recomputed only when Rho   */
+/* differs from that of the previous point; the exponential    */
+/* integral entering its series is computed once for all points*/
+/***************************************************************/
+void AddGLong1D(int NumPoints, double *R, double *Rho, cdouble k,
+                double P[2], int m, double Gamma[3][3], double E,
+                cdouble *GBarVD, bool &Singular)
 {
   if (Singular) return;
 
@@ -439,34 +472,68 @@ void AddGLong1D(double R[3], double Rho, cdouble k, double P[2],
    ErrExit("1D lattice vectors must point in the x direction");
   PmGMag = PmG[0];
 
-  cdouble ExpFac = exp( II * ( PmG[0]*R[0] + PmG[1]*R[1]) );
+  cdouble E1=0.0, GT=0.0, dGdRho[2]={0.0, 0.0}, dGTdRho=0.0, dGT2dRho2=0.0;
+  for(int np=0; np<NumPoints; np++)
+   { 
+     double *RR = R + 3*np;
+     double RhoP = Rho[np];
+     if ( np==0 || RhoP!=Rho[np-1] )
+      { GT=GetGLongTwiddle1D(PmGMag, RhoP, k, E, dGdRho, Singular, &E1);
+        if (Singular) return;
+        dGTdRho = dGdRho[0];
+        dGT2dRho2 = RhoP==0.0 ? 0.0 : (dGdRho[1] - dGdRho[0]/RhoP);
+      };
 
-  cdouble dGdRho[2];
-  cdouble GT=GetGLongTwiddle1D(PmGMag, Rho, k, E, dGdRho, Singular);
-  cdouble dGTdRho = dGdRho[0];
-  cdouble dGT2dRho2 = Rho==0.0 ? 0.0 : (dGdRho[1] - dGdRho[0]/Rho);
-  double YOverRho = (Rho==0.0) ? 0.0 : R[1]/Rho;
-  double ZOverRho = (Rho==0.0) ? 0.0 : R[2]/Rho;
+     double Phase = PmG[0]*RR[0] + PmG[1]*RR[1];
+     cdouble ExpFac = cdouble(cos(Phase), sin(Phase));
+     double YOverRho = (RhoP==0.0) ? 0.0 : RR[1]/RhoP;
+     double ZOverRho = (RhoP==0.0) ? 0.0 : RR[2]/RhoP;
+
+     cdouble *Sum = GBarVD + NSUM*np;
+     Sum[0] += ExpFac * GT;
+     Sum[1] += II*PmG[0] * ExpFac * GT;
+     Sum[2] += YOverRho * ExpFac * dGTdRho;
+     Sum[3] += ZOverRho * ExpFac * dGTdRho;
+     Sum[4] += II*PmG[0] * YOverRho * ExpFac * dGTdRho;
+     Sum[5] += II*PmG[0] * ZOverRho * ExpFac * dGTdRho;
+     Sum[6] += YOverRho * ZOverRho * ExpFac * dGT2dRho2;
+     Sum[7] += II*PmG[0] * YOverRho * ZOverRho * ExpFac * dGT2dRho2;
+   };
 
-  GBarVD[0] += ExpFac * GT;
-  GBarVD[1] += II*PmG[0] * ExpFac * GT;
-  GBarVD[2] += YOverRho * ExpFac * dGTdRho;
-  GBarVD[3] += ZOverRho * ExpFac * dGTdRho;
-  GBarVD[4] += II*PmG[0] * YOverRho * ExpFac * dGTdRho;
-  GBarVD[5] += II*PmG[0] * ZOverRho * ExpFac * dGTdRho;
-  GBarVD[6] += YOverRho * ZOverRho * ExpFac * dGT2dRho2;
-  GBarVD[7] += II*PmG[0] * YOverRho * ZOverRho * ExpFac * dGT2dRho2;
+}
 
+/***************************************************************/
+/* the lattice sums for a batch of points are continued until  */
+/* the sums at every point in the batch have converged         */
+/***************************************************************/
+static bool BatchConverged(int NumPoints, cdouble *Sum, cdouble *LastSum)
+{
+  bool Converged=true;
+  for(int np=0; Converged && np<NumPoints; np++)
+   { double MaxRelDelta=0.0, MaxAbsDelta=0.0;
+     for(int ns=0; ns<NSUM; ns++)
+      { double Delta=abs(Sum[NSUM*np+ns]-LastSum[NSUM*np+ns]);
+        if ( Delta>MaxAbsDelta )
+         MaxAbsDelta=Delta;
+        double AbsSum=abs(Sum[NSUM*np+ns]);
+        if ( AbsSum>0.0 && (Delta > MaxRelDelta*AbsSum) )
+         MaxRelDelta=Delta/AbsSum;
+      };
+     Converged = ( MaxAbsDelta<ABSTOL || MaxRelDelta<RELTOL );
+   };
+  memcpy(LastSum, Sum, NumPoints*NSUM*sizeof(cdouble));
+  return Converged;
 }
 
 /***************************************************************/
 /* set Singular=true if singularity encountered ****************/
 /***************************************************************/
-bool GetGBarDistant(double *R, double Rho, cdouble k, double *kBloch,
+bool GetGBarDistant(int NumPoints, double *R, double *Rho,
+                    cdouble k, double *kBloch,
                     double Gamma[3][3], int LDim,
                     double E, int *pnCells, cdouble *Sum)
 {
-  memset(Sum,0,NSUM*sizeof(cdouble));
+  memset(Sum,0,NumPoints*NSUM*sizeof(cdouble));
   if (E==0.0) return false;
 
   bool Singular=false;
@@ -478,12 +545,12 @@ bool GetGBarDistant(double *R, double Rho, cdouble k, double *kBloch,
   int nCells=0;
   if (LDim==1)
    { for (int m=-NFIRSTROUND; m<=NFIRSTROUND; m++)
-      AddGLong1D(R, Rho, k, kBloch, m, Gamma, E, Sum, Singular);
+      AddGLong1D(NumPoints, R, Rho, k, kBloch, m, Gamma, E, Sum, Singular);
    }
   else // LDim==2
    { for (int m1=-NFIRSTROUND; m1<=NFIRSTROUND; m1++)
       for (int m2=-NFIRSTROUND; m2<=NFIRSTROUND; m2++, nCells++)
-       AddGLong2D(R, k, kBloch, m1, m2, Gamma, E, Sum, Singular);
+       AddGLong2D(NumPoints, R, k, kBloch, m1, m2, Gamma, E, Sum, Singular);
    };
 
   if (Singular) return true;
@@ -491,14 +558,13 @@ bool GetGBarDistant(double *R, double Rho, cdouble k, double *kBloch,
   /***************************************************************/
   /* continue to add contributions of outer cells until converged*/
   /***************************************************************/
-  cdouble LastSum[NSUM];
-  memcpy(LastSum,Sum,NSUM*sizeof(cdouble));
+  cdouble *LastSum = (cdouble *)memdup(Sum, NumPoints*NSUM*sizeof(cdouble));
   int ConvergedIters=0;
   for(int NN=NFIRSTROUND+1; ConvergedIters<3 && NN<=NMAX; NN++)
    {  
      if (LDim==1)
-      { AddGLong1D(R, Rho, k, kBloch,  NN, Gamma, E, Sum, Singular);
-        AddGLong1D(R, Rho, k, kBloch, -NN, Gamma, E, Sum, Singular);
+      { AddGLong1D(NumPoints, R, Rho, k, kBloch,  NN, Gamma, E, Sum, Singular);
+        AddGLong1D(NumPoints, R, Rho, k, kBloch, -NN, Gamma, E, Sum, Singular);
         nCells+=2;
       }
      else // LDim==2
@@ -508,36 +574,29 @@ bool GetGBarDistant(double *R, double Rho, cdouble k, double *kBloch,
         /* NNxNN square of grid cells                                   */
         /*--------------------------------------------------------------*/
         for(int m=-NN; m<NN; m++)
-         { AddGLong2D(R, k, kBloch,   m,  NN, Gamma, E, Sum, Singular);
-           AddGLong2D(R, k, kBloch,  NN,  -m, Gamma, E, Sum, Singular);
-           AddGLong2D(R, k, kBloch,  -m, -NN, Gamma, E, Sum, Singular);
-           AddGLong2D(R, k, kBloch, -NN,   m, Gamma, E, Sum, Singular);
+         { AddGLong2D(NumPoints, R, k, kBloch,   m,  NN, Gamma, E, Sum, Singular);
+           AddGLong2D(NumPoints, R, k, kBloch,  NN,  -m, Gamma, E, Sum, Singular);
+           AddGLong2D(NumPoints, R, k, kBloch,  -m, -NN, Gamma, E, Sum, Singular);
+           AddGLong2D(NumPoints, R, k, kBloch, -NN,   m, Gamma, E, Sum, Singular);
            nCells+=4;
          };
       };
 
-     if (Singular) return true;
+     if (Singular) 
+      { free(LastSum);
+        return true;
+      };
 
      /*--------------------------------------------------------------*/
      /* convergence analysis ----------------------------------------*/
      /*--------------------------------------------------------------*/
-     double MaxRelDelta=0.0, MaxAbsDelta=0.0;
-     for(int ns=0; ns<NSUM; ns++)
-      { double Delta=abs(Sum[ns]-LastSum[ns]);
-        if ( Delta>MaxAbsDelta )
-         MaxAbsDelta=Delta;
-        double AbsSum=abs(Sum[ns]);
-        if ( AbsSum>0.0 && (Delta > MaxRelDelta*AbsSum) )
-         MaxRelDelta=Delta/AbsSum;
-      };
-     if ( MaxAbsDelta<ABSTOL || MaxRelDelta<RELTOL )
+     if ( BatchConverged(NumPoints, Sum, LastSum) )
       ConvergedIters++;
      else
       ConvergedIters=0;
 
-     memcpy(LastSum,Sum,NSUM*sizeof(cdouble));
-
    };
+  free(LastSum);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -548,7 +607,7 @@ bool GetGBarDistant(double *R, double Rho, cdouble k, double *kBloch,
   else
    PreFactor = (Gamma[0][0]*Gamma[1][1] - Gamma[0][1]*Gamma[1][0])/(16.0*M_PI*M_PI);
 
-  for(int ns=0; ns<NSUM; ns++)
+  for(int ns=0; ns<NumPoints*NSUM; ns++)
    Sum[ns] *= PreFactor;
 
   if (pnCells) 
@@ -558,6 +617,13 @@ bool GetGBarDistant(double *R, double Rho, cdouble k, double *kBloch,
 
 }
 
+bool GetGBarDistant(double *R, double Rho, cdouble k, double *kBloch,
+                    double Gamma[3][3], int LDim,
+                    double E, int *pnCells, cdouble *Sum)
+{ 
+  return GetGBarDistant(1, R, &Rho, k, kBloch, Gamma, LDim, E, pnCells, Sum);
+}
+
 /***************************************************************/
 /* get the contributions of a single real-space lattice cell to*/
 /* the FULL periodic green's function (no ewald decomposition).*/
@@ -602,9 +668,31 @@ void AddGFull(double R[3], cdouble k, double kBloch[2],
  
 }
 
+/***************************************************************/
+/* quantities entering the direct-lattice summand below that   */
+/* depend only on k and E, computed once per batch of points   */
+/***************************************************************/
+typedef struct GShortData
+ { cdouble k, ik, k2, ikOver2E, g4Factor;
+   double E, E2, E4;
+ } GShortData;
+
+static void InitGShortData(cdouble k, double E, GShortData *Data)
+{ 
+  Data->k        = k;
+  Data->ik       = II*k;
+  Data->k2       = k*k;
+  Data->E        = E;
+  Data->E2       = E*E;
+  Data->E4       = E*E*E*E;
+  Data->ikOver2E = II*k/(2.0*E);
+  Data->g4Factor = -2.0*M_2_SQRTPI*E*exp(k*k/(4.0*E*E));
+}
+
 /***************************************************************/
 /* add the contribution of a single direct lattice vector L    */
-/* to the direct-lattice sum, where L = n1*L1 + n2*L2.         */
+/* to the direct-lattice sum at the point R, where RmL = R-L   */
+/* and PhaseFactor = exp(i kBloch\dot L) / (8*pi).             */
 /*                                                             */
 /* note: the summand is:                                       */
 /*                                                             */
@@ -633,42 +721,11 @@ void AddGFull(double R[3], cdouble k, double kBloch[2],
 /* where g4 = (-4E/sqrt(pi)) * exp( -(E)^2R^2 + k^2/(4(E)^2).  */
 /*                                                             */
 /***************************************************************/
-void AddGShort(double *R, cdouble k, double *kBloch,
-               int n1, int n2, double (*LBV)[3], int LDim,
-               double E, cdouble *Sum)
+static void AddGShortTerm(double RmL[3], cdouble PhaseFactor,
+                          GShortData *Data, cdouble *Sum)
 { 
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  double L[2];
-  if (LDim==1)
-   { L[0] = n1*LBV[0][0];
-     L[1] = n1*LBV[0][1];
-   }
-  else // (LDim==2)
-   { L[0] = n1*LBV[0][0] + n2*LBV[1][0];
-     L[1] = n1*LBV[0][1] + n2*LBV[1][1];
-   };
-
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  if (E==0.0)
-   { AddGFull(R, k, kBloch, L[0], L[1], Sum);
-     return;
-   };
-
-  cdouble PhaseFactor=exp( II * (kBloch[0]*L[0] + kBloch[1]*L[1]) ) / (8.0*M_PI);
-
-  double RmL[3], rml2, rml, rml3, rml4, rml5, rml6, rml7;
-  cdouble g2p, g3p, g2m, g3m, g4, ggPgg, ggMgg, Term;
-
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  RmL[0] = (R[0]-L[0]);
-  RmL[1] = (R[1]-L[1]);
-  RmL[2] =  R[2];
+  double rml2, rml, rml3, rml4, rml5, rml6, rml7;
+  cdouble g4, ggPgg, ggMgg, Term;
 
   rml2=RmL[0]*RmL[0] + RmL[1]*RmL[1] + RmL[2]*RmL[2];
   rml=sqrt(rml2);
@@ -680,26 +737,26 @@ void AddGShort(double *R, cdouble k, double *kBloch,
   rml6=rml5*rml;
   rml7=rml6*rml;
 
-  double E2 = E*E;
-  double E4 = E2*E2;
+  cdouble ik = Data->ik, k2 = Data->k2;
+  double E = Data->E, E2 = Data->E2, E4 = Data->E4;
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   //g2p = exp( II*k*rml );
   //g3p = Faddeeva::erfc( E*rml + II*k/(2.0*E) );
-  cdouble g2pTg3p = erfc_s( II*k*rml, E*rml + II*k/(2.0*E) );
+  cdouble g2pTg3p = erfc_s( ik*rml, E*rml + Data->ikOver2E );
 
   //g2m = exp( -II*k*rml );
   //g3m = Faddeeva::erfc( E*rml - II*k/(2.0*E) );
-  cdouble g2mTg3m = erfc_s( -II*k*rml, E*rml - II*k/(2.0*E) );
+  cdouble g2mTg3m = erfc_s( -ik*rml, E*rml - Data->ikOver2E );
 
   //ggPgg = g2p*g3p + g2m*g3m;
   //ggMgg = g2p*g3p - g2m*g3m;
   ggPgg = g2pTg3p + g2mTg3m;
   ggMgg = g2pTg3p - g2mTg3m;
 
-  g4 = -2.0*M_2_SQRTPI*E*exp(-E2*rml2 + k*k/(4.0*E2));
+  g4 = Data->g4Factor*exp(-E2*rml2);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -709,7 +766,7 @@ void AddGShort(double *R, cdouble k, double *kBloch,
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
-  Term = -ggPgg/rml3 + (g4 + II*k*ggMgg)/rml2;
+  Term = -ggPgg/rml3 + (g4 + ik*ggMgg)/rml2;
 
   Sum[1] += PhaseFactor * RmL[0] * Term;
   Sum[2] += PhaseFactor * RmL[1] * Term;
@@ -718,8 +775,8 @@ void AddGShort(double *R, cdouble k, double *kBloch,
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
-  Term = 3.0*ggPgg/rml5 - 3.0*(g4+II*k*ggMgg)/rml4 
-           - k*k*ggPgg/rml3 - 2.0*E2*g4/rml2;
+  Term = 3.0*ggPgg/rml5 - 3.0*(g4+ik*ggMgg)/rml4 
+           - k2*ggPgg/rml3 - 2.0*E2*g4/rml2;
 
   Sum[4] += PhaseFactor * RmL[0] * RmL[1] * Term;
   Sum[5] += PhaseFactor * RmL[0] * RmL[2] * Term;
@@ -728,53 +785,106 @@ void AddGShort(double *R, cdouble k, double *kBloch,
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
-  Term = -15.0*ggPgg/rml7 + 15.0*(g4+II*k*ggMgg)/rml6 
-        + 6.0*k*k*ggPgg/rml5 + 10.0*E2*g4/rml4
-         -k*k*(II*k*ggMgg + g4)/rml4 + 4.0*E4*g4/rml2;
+  Term = -15.0*ggPgg/rml7 + 15.0*(g4+ik*ggMgg)/rml6 
+        + 6.0*k2*ggPgg/rml5 + 10.0*E2*g4/rml4
+         -k2*(ik*ggMgg + g4)/rml4 + 4.0*E4*g4/rml2;
 
   Sum[7] += PhaseFactor * RmL[0] * RmL[1] * RmL[2] * Term;
 
 }
 
+/***************************************************************/
+/* add the contribution of the direct lattice vector           */
+/* L = n1*L1 + n2*L2 to the direct-lattice sums at each of     */
+/* NumPoints points R[3*np + (0,1,2)].                         */
+/***************************************************************/
+static void AddGShort(int NumPoints, double *R, double *kBloch,
+                      int n1, int n2, double (*LBV)[3], int LDim,
+                      GShortData *Data, cdouble *Sum)
+{ 
+  double L[2];
+  if (LDim==1)
+   { L[0] = n1*LBV[0][0];
+     L[1] = n1*LBV[0][1];
+   }
+  else // (LDim==2)
+   { L[0] = n1*LBV[0][0] + n2*LBV[1][0];
+     L[1] = n1*LBV[0][1] + n2*LBV[1][1];
+   };
+
+  if (Data->E==0.0)
+   { for(int np=0; np<NumPoints; np++)
+      AddGFull(R + 3*np, Data->k, kBloch, L[0], L[1], Sum + NSUM*np);
+     return;
+   };
+
+  cdouble PhaseFactor=exp( II * (kBloch[0]*L[0] + kBloch[1]*L[1]) ) / (8.0*M_PI);
+
+  for(int np=0; np<NumPoints; np++)
+   { double RmL[3];
+     RmL[0] = R[3*np + 0] - L[0];
+     RmL[1] = R[3*np + 1] - L[1];
+     RmL[2] = R[3*np + 2];
+     AddGShortTerm(RmL, PhaseFactor, Data, Sum + NSUM*np);
+   };
+}
+
+void AddGShort(double *R, cdouble k, double *kBloch,
+               int n1, int n2, double (*LBV)[3], int LDim,
+               double E, cdouble *Sum)
+{ 
+  GShortData Data;
+  Data.k=k;
+  Data.E=0.0;
+  if (E!=0.0) 
+   InitGShortData(k, E, &Data);
+  AddGShort(1, R, kBloch, n1, n2, LBV, LDim, &Data, Sum);
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
-void GetGBarNearby(double *R, cdouble k, double *kBloch,
+void GetGBarNearby(int NumPoints, double *R, cdouble k, double *kBloch,
                    double (*LBV)[3], int LDim,
                    double E, bool ExcludeInnerCells,
                    int *pnCells, cdouble *Sum)
 { 
+  GShortData Data;
+  Data.k=k;
+  Data.E=0.0;
+  if (E!=0.0) 
+   InitGShortData(k, E, &Data);
+
   /***************************************************************/
   /* add the contributions of a 'first round' of grid cells near */
   /* the center                                                  */
   /***************************************************************/
   int nCells=0;
-  memset(Sum,0,NSUM*sizeof(cdouble));
+  memset(Sum,0,NumPoints*NSUM*sizeof(cdouble));
   if (LDim==1)
    { 
      for (int n1=-NFIRSTROUND; n1<=NFIRSTROUND; n1++, nCells++)
        if ( !ExcludeInnerCells || abs(n1)>1 )
-        AddGShort(R, k, kBloch, n1, 0, LBV, LDim, E, Sum);
+        AddGShort(NumPoints, R, kBloch, n1, 0, LBV, LDim, &Data, Sum);
    }
   else if (LDim==2)
    { 
      for (int n1=-NFIRSTROUND; n1<=NFIRSTROUND; n1++)
       for (int n2=-NFIRSTROUND; n2<=NFIRSTROUND; n2++, nCells++)
        if ( !ExcludeInnerCells || abs(n1)>1 || abs(n2)>1 )
-        AddGShort(R, k, kBloch, n1, n2, LBV, LDim, E, Sum);
+        AddGShort(NumPoints, R, kBloch, n1, n2, LBV, LDim, &Data, Sum);
    };
          
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
-  cdouble LastSum[NSUM];
-  memcpy(LastSum,Sum,NSUM*sizeof(cdouble));
+  cdouble *LastSum = (cdouble *)memdup(Sum, NumPoints*NSUM*sizeof(cdouble));
   int ConvergedIters=0;
   for(int NN=NFIRSTROUND+1; ConvergedIters<3 && NN<=NMAX; NN++)
    {  
      if (LDim==1)
-      { AddGShort(R, k, kBloch,  NN, 0, LBV, LDim, E, Sum);
-        AddGShort(R, k, kBloch, -NN, 0, LBV, LDim, E, Sum);
+      { AddGShort(NumPoints, R, kBloch,  NN, 0, LBV, LDim, &Data, Sum);
+        AddGShort(NumPoints, R, kBloch, -NN, 0, LBV, LDim, &Data, Sum);
         nCells+=2;
       }
      else // LDim==2
@@ -784,10 +894,10 @@ void GetGBarNearby(double *R, cdouble k, double *kBloch,
         /* NNxNN square of grid cells.                                  */
         /*--------------------------------------------------------------*/
         for(int n=-NN; n<NN; n++)
-         { AddGShort(R, k, kBloch,   n,  NN, LBV, LDim, E, Sum);
-           AddGShort(R, k, kBloch,  NN,  -n, LBV, LDim, E, Sum);
-           AddGShort(R, k, kBloch,  -n, -NN, LBV, LDim, E, Sum);
-           AddGShort(R, k, kBloch, -NN,   n, LBV, LDim, E, Sum);
+         { AddGShort(NumPoints, R, kBloch,   n,  NN, LBV, LDim, &Data, Sum);
+           AddGShort(NumPoints, R, kBloch,  NN,  -n, LBV, LDim, &Data, Sum);
+           AddGShort(NumPoints, R, kBloch,  -n, -NN, LBV, LDim, &Data, Sum);
+           AddGShort(NumPoints, R, kBloch, -NN,   n, LBV, LDim, &Data, Sum);
            nCells+=4;
          };
       };
@@ -795,28 +905,26 @@ void GetGBarNearby(double *R, cdouble k, double *kBloch,
      /*--------------------------------------------------------------*/
      /* convergence analysis ----------------------------------------*/
      /*--------------------------------------------------------------*/
-     double MaxAbsDelta=0.0, MaxRelDelta=0.0;
-     for(int ns=0; ns<NSUM; ns++)
-      { double Delta=abs(Sum[ns]-LastSum[ns]);
-        if ( Delta>MaxAbsDelta )
-         MaxAbsDelta=Delta;
-        double AbsSum=abs(Sum[ns]);
-        if ( AbsSum>0.0 && (Delta > MaxRelDelta*AbsSum) )
-         MaxRelDelta=Delta/AbsSum;
-      };
-     if ( MaxAbsDelta<ABSTOL || MaxRelDelta<RELTOL )
+     if ( BatchConverged(NumPoints, Sum, LastSum) )
       ConvergedIters++;
      else
       ConvergedIters=0;
 
-     memcpy(LastSum,Sum,NSUM*sizeof(cdouble));
-
    };
+  free(LastSum);
 
   if (pnCells) *pnCells=nCells;
 
 }
 
+void GetGBarNearby(double *R, cdouble k, double *kBloch,
+                   double (*LBV)[3], int LDim,
+                   double E, bool ExcludeInnerCells,
+                   int *pnCells, cdouble *Sum)
+{ 
+  GetGBarNearby(1, R, k, kBloch, LBV, LDim, E, ExcludeInnerCells, pnCells, Sum);
+}
+
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
@@ -928,11 +1036,36 @@ void AddGLongRealSpace(double *R, cdouble k, double *kBloch,
 /*  GBarVD[6] = d^2GBar/dYdZ                                   */
 /*  GBarVD[7] = d^3GBar/dXdYdZ                                 */
 /***************************************************************/
-void GBarVDEwald(double *R, cdouble k, double *kBloch0,
+void GBarVDEwald(double *R, cdouble k, double *kBloch,
+                 double (*LBV)[3], int LDim,
+                 double E, bool ExcludeInnerCells,
+                 cdouble *GBarVD)
+{ 
+  GBarVDEwald(1, R, k, kBloch, LBV, LDim, E, ExcludeInnerCells, GBarVD);
+}
+
+/***************************************************************/
+/* Batched version of the above: on return, GBarVD[8*np + ns]  */
+/* is the nsth value/derivative at the point R[3*np+(0,1,2)].  */
+/*                                                             */
+/* All points in the batch share a single value of the Ewald   */
+/* parameter E, so that everything in the lattice sums that    */
+/* depends only on (k, kBloch, E) and the lattice vector is    */
+/* computed once per batch rather than once per point. In the  */
+/* 1D case the automatic choice of E depends on the transverse */
+/* distance Rho, and we take the smallest of the optimal values*/
+/* over the batch (which is the value for the largest Rho).    */
+/* Batches of points with equal z (2D) or equal Rho (1D) are   */
+/* cheapest, since the erfc / exponential-integral factors in  */
+/* the reciprocal-lattice sums depend only on those quantities.*/
+/***************************************************************/
+void GBarVDEwald(int NumPoints, double *R, cdouble k, double *kBloch0,
                  double (*LBV)[3], int LDim,
                  double E, bool ExcludeInnerCells,
                  cdouble *GBarVD)
 { 
+  if (NumPoints<=0) return;
+
   /*--------------------------------------------------------------*/
   /* the periodic green's function is well-defined at k==0 (i.e.  */
   /* the electrostatic case), but in that case the method used    */
@@ -943,15 +1076,21 @@ void GBarVDEwald(double *R, cdouble k, double *kBloch0,
   /* matrix, so we want to return zeros in this case.             */
   /*--------------------------------------------------------------*/
    if (k==0.0)
-    { memset(GBarVD, 0, 8*sizeof(cdouble));
+    { memset(GBarVD, 0, NumPoints*NSUM*sizeof(cdouble));
       return;
     };
 
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
-  double Gamma[3][3], EOpt, Rho;
-  GetRLBasis(LDim, LBV, Gamma, k, &EOpt, R, &Rho);
+  double Gamma[3][3], EOpt=0.0;
+  double *Rho = (double *)mallocEC(NumPoints*sizeof(double));
+  for(int np=0; np<NumPoints; np++)
+   { double EOptP;
+     Rho[np]=0.0;
+     GetRLBasis(LDim, LBV, Gamma, k, &EOptP, R + 3*np, Rho + np);
+     if (np==0 || EOptP<EOpt) EOpt=EOptP;
+   };
   if (E==-1.0) E=EOpt;
 
   /***************************************************************/
@@ -960,22 +1099,25 @@ void GBarVDEwald(double *R, cdouble k, double *kBloch0,
   double kBloch[3]={0.0, 0.0, 0.0};
   memcpy(kBloch, kBloch0, LDim*sizeof(double));
 
-  cdouble GBarNearby[NSUM], GBarDistant[NSUM];
-  GetGBarNearby(R, k, kBloch, LBV, LDim,
-                E, ExcludeInnerCells, 0, GBarNearby);
+  cdouble *GBarDistant = (cdouble *)mallocEC(NumPoints*NSUM*sizeof(cdouble));
+  GetGBarNearby(NumPoints, R, k, kBloch, LBV, LDim,
+                E, ExcludeInnerCells, 0, GBarVD);
   bool Singular
-   = GetGBarDistant(R, Rho, k, kBloch, Gamma, LDim, E, 0, GBarDistant);
+   = GetGBarDistant(NumPoints, R, Rho, k, kBloch, Gamma, LDim, E, 0, GBarDistant);
 
   if (Singular)
    { Log("Ewald spectral sum is singular (recomputing at displaced kBloch)");
      kBloch[0] += (1.0e-2)*abs(k);
-     GetGBarNearby(R, k, kBloch, LBV, LDim,
-                   E, ExcludeInnerCells, 0, GBarNearby);
-     GetGBarDistant(R, Rho, k, kBloch, Gamma, LDim, E, 0, GBarDistant);
+     GetGBarNearby(NumPoints, R, k, kBloch, LBV, LDim,
+                   E, ExcludeInnerCells, 0, GBarVD);
+     GetGBarDistant(NumPoints, R, Rho, k, kBloch, Gamma, LDim, E, 0, GBarDistant);
    };
    
-  for(int ns=0; ns<NSUM; ns++)
-   GBarVD[ns] = GBarNearby[ns] + GBarDistant[ns];
+  for(int ns=0; ns<NumPoints*NSUM; ns++)
+   GBarVD[ns] += GBarDistant[ns];
+
+  free(GBarDistant);
+  free(Rho);
 
   /***************************************************************/
   /* subtract off the contributions to the 'distant' sum coming  */
@@ -983,14 +1125,16 @@ void GBarVDEwald(double *R, cdouble k, double *kBloch0,
   /***************************************************************/
   if (ExcludeInnerCells)
    { 
-     cdouble GLongInner[NSUM];
-     memset(GLongInner,0,NSUM*sizeof(cdouble));
      int n2Mult = (LDim==2) ? 1 : 0;
-     for(int n1=-1; n1<=1; n1++)
-      for(int n2=-1*n2Mult; n2<=1*n2Mult; n2++)
-       AddGLongRealSpace(R, k, kBloch, n1, n2, LBV, LDim, E, GLongInner);
-     for(int ns=0; ns<NSUM; ns++)
-      GBarVD[ns] -= GLongInner[ns];
+     for(int np=0; np<NumPoints; np++)
+      { cdouble GLongInner[NSUM];
+        memset(GLongInner,0,NSUM*sizeof(cdouble));
+        for(int n1=-1; n1<=1; n1++)
+         for(int n2=-1*n2Mult; n2<=1*n2Mult; n2++)
+          AddGLongRealSpace(R + 3*np, k, kBloch, n1, n2, LBV, LDim, E, GLongInner);
+        for(int ns=0; ns<NSUM; ns++)
+         GBarVD[NSUM*np + ns] -= GLongInner[ns];
+      };
    };
 
 } 
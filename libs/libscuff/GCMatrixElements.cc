@@ -624,6 +624,22 @@ void GetGCMatrixElements(RWGGeometry *G, GetGCMEArgStruct *Args,
   if (Args->ForceDeSingularize) DeSingularize=true;
   if (Args->DoNotDeSingularize) DeSingularize=false;
   int Order = (DeSingularize || rRel>4.0) ? 4 : (rRel>1.0 ? 9 : 25);
+
+  // with an integration tolerance, the order for non-desingularized
+  // pairs is chosen from the panel-panel error model; the panels of
+  // the two basis functions are at least rRel-2 panel radii apart
+  double Tolerance=RWGGeometry::IntegrationTolerance;
+  if (Tolerance>0.0 && !DeSingularize)
+   { RWGEdge *Ea=Sa->GetEdgeByIndex(nea), *Eb=Sb->GetEdgeByIndex(neb);
+     double kMax=0.0;
+     for(int nr=0; nr<Args->NumRegions; nr++)
+      kMax=fmax(kMax, abs(Args->k[nr]));
+     double kR=kMax*fmax(Ea->Radius, Eb->Radius);
+     int AdaptiveOrder=SelectPPICubatureOrder(rRel-2.0, kR, Tolerance);
+     if (AdaptiveOrder>0)
+      Order=AdaptiveOrder;
+   };
+
   if (Args->ForceOrder!=-1)
    Order=Args->ForceOrder;
 
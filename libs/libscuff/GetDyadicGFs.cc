@@ -42,6 +42,46 @@
 
 namespace scuff { 
 
+/***************************************************************/
+/* contract the reduced-field vectors of NX points:            */
+/*  GE[nx][i][j] = sum_nbf RFDest[nbf,6nx+i] RFSource[nbf,6nx+j]*/
+/*  GM[nx][i][j] = same with i,j -> 3+i, 3+j                    */
+/* both matrices are stored column-major with leading dimension*/
+/* NBF, so the six columns belonging to each point are         */
+/* contiguous; we sweep once through them, accumulating all 18 */
+/* sums together, with the points distributed among threads.   */
+/***************************************************************/
+static void ContractRFMatrices(int NBF, int NX,
+                               cdouble *RFDest, cdouble *RFSource,
+                               cdouble *GEGM)
+{
+  int NT=1;
+#ifdef USE_OPENMP
+  NT=GetNumThreads();
+#pragma omp parallel for schedule(dynamic,1), num_threads(NT)
+#endif
+  for(int nx=0; nx<NX; nx++)
+   { 
+     cdouble *D = RFDest   + ((size_t)NBF)*6*nx;
+     cdouble *S = RFSource + ((size_t)NBF)*6*nx;
+     cdouble Sum[18];
+     for(int n=0; n<18; n++) Sum[n]=0.0;
+     for(int nbf=0; nbf<NBF; nbf++)
+      { cdouble DE[3], DM[3], SE[3], SM[3];
+        for(int i=0; i<3; i++)
+         { DE[i]=D[nbf + i*NBF];  DM[i]=D[nbf + (3+i)*NBF];
+           SE[i]=S[nbf + i*NBF];  SM[i]=S[nbf + (3+i)*NBF];
+         };
+        for(int i=0; i<3; i++)
+         for(int j=0; j<3; j++)
+          { Sum[0 + 3*i + j] += DE[i]*SE[j];
+            Sum[9 + 3*i + j] += DM[i]*SM[j];
+          };
+      };
+     memcpy(GEGM + 18*nx, Sum, 18*sizeof(cdouble));
+   };
+}
+
 /***************************************************************/
 /* 20151212 new routine for computing dyadic GFs that uses a   */
 /* much faster strategy and computes DGFs at many points       */
@@ -54,31 +94,44 @@ namespace scuff {
 /*      and destination points can be different, and we have   */
 /*       X[nx,0:2] = destination point                         */
 /*       X[nx,3:5] = source points                             */
+/*                                                             */
+/* The reduced-field matrices have 6 columns per point, so for */
+/* large NX the points are processed in blocks whose matrices  */
+/* fit within DGFMemoryBudget megabytes.                       */
 /***************************************************************/
 HMatrix *RWGGeometry::GetDyadicGFs(cdouble Omega, double *kBloch,
                                    HMatrix *XMatrix, HMatrix *M,
                                    HMatrix *GMatrix,
-                                   bool ScatteringOnly)
+                                   bool ScatteringOnly,
+                                   SCUFFWorkspace *Workspace)
 { 
   int NBF = TotalBFs;
   int NX  = XMatrix->NR;
   Log("Getting DGFs at %i eval points...",NX);
 
   /*--------------------------------------------------------------*/
-  /* allocate storage for RFSource, RFDest matrices. I keep these */
-  /* on hand as statically-allocated buffers on the assumption    */
-  /* that the routine will be called many times with the same     */
-  /* number of evaluation points, for example in Brillouin-zone   */
-  /* integrations                                                 */
+  /*- choose the number of points per block: RFSource and RFDest -*/
+  /*- together take 2*6*NBF complex numbers per point            -*/
   /*--------------------------------------------------------------*/
-  static HMatrix *RFSource=0, *RFDest=0;
-  if ( RFSource==0 || RFSource->NR!=NBF || RFSource->NC!=(6*NX) )
-   { 
-     if (RFSource) delete RFSource;
-     if (RFDest)   delete RFDest;
-     RFSource=new HMatrix(NBF, 6*NX, LHM_COMPLEX);
-     RFDest=new HMatrix(NBF, 6*NX, LHM_COMPLEX);
-   };
+  double BytesPerPoint = 12.0*NBF*sizeof(cdouble);
+  double MaxPoints = DGFMemoryBudget*1048576.0 / BytesPerPoint;
+  int NXBlock = (MaxPoints >= (double)NX) ? NX : (int)MaxPoints;
+  if (NXBlock<1) NXBlock=1;
+  int NumBlocks = (NX + NXBlock - 1) / NXBlock;
+  if (NumBlocks>1)
+   Log(" processing %i points per block (%i blocks)",NXBlock,NumBlocks);
+
+  /*--------------------------------------------------------------*/
+  /* get storage for RFSource, RFDest matrices. callers that call */
+  /* this routine many times with the same number of evaluation   */
+  /* points (for example in Brillouin-zone integrations) should   */
+  /* pass a Workspace so that the buffers are reused across calls;*/
+  /* otherwise they are allocated afresh for each call.           */
+  /*--------------------------------------------------------------*/
+  SCUFFWorkspace LocalWorkspace;
+  if (Workspace==0) Workspace=&LocalWorkspace;
+  HMatrix *RFSourceBuffer=Workspace->GetMatrix(WSSLOT_DGF_RFSOURCE, NBF, 6*NXBlock, LHM_COMPLEX);
+  HMatrix *RFDestBuffer=Workspace->GetMatrix(WSSLOT_DGF_RFDEST, NBF, 6*NXBlock, LHM_COMPLEX);
 
   /*--------------------------------------------------------------*/
   /*- allocate an output matrix of the right size if necessary   -*/
@@ -100,35 +153,68 @@ HMatrix *RWGGeometry::GetDyadicGFs(cdouble Omega, double *kBloch,
   bool AddDirectContribution = TwoPointDGF && !ScatteringOnly;
   PointSource PSBuffer, *PS = (AddDirectContribution ? &PSBuffer : 0);
 
-  /*--------------------------------------------------------------*/
-  /*- precompute 'reduced-field' vectors -------------------------*/
-  /*--------------------------------------------------------------*/
   bool HavekBloch = false;
   if (kBloch)
    for(int d=0; d<LDim; d++)
     if (kBloch[d]!=0.0) HavekBloch=true;  
 
-  GetRFMatrix(Omega, kBloch, XMatrix, RFDest, true);
-  if ( TwoPointDGF || HavekBloch )
-   GetRFMatrix(Omega, kBloch, XMatrix, RFSource, false, TwoPointDGF ? 3 : 0);
-  else
-   RFSource->Copy(RFDest);
-
   /*--------------------------------------------------------------*/
+  /*- unnormalized scattering parts of the DGFs for all points,  -*/
+  /*- 18 per point (GE[0..8], GM[0..8])                          -*/
   /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  Log(" LUSolving...");
-  M->LUSolve(RFSource);
+  cdouble *GEGM = (cdouble *)mallocEC(18*((size_t)NX)*sizeof(cdouble));
+
+  for(int nb=0; nb<NumBlocks; nb++)
+   { 
+     int nx0 = nb*NXBlock;
+     int NXB = (nx0 + NXBlock <= NX) ? NXBlock : NX - nx0;
+
+     // evaluation points for this block, and views of the first
+     // 6*NXB columns of the workspace buffers
+     HMatrix *XBlock=XMatrix;
+     if (NumBlocks>1)
+      { XBlock=new HMatrix(NXB, XMatrix->NC, LHM_REAL);
+        for(int nx=0; nx<NXB; nx++)
+         for(int nc=0; nc<XMatrix->NC; nc++)
+          XBlock->SetEntry(nx, nc, XMatrix->GetEntryD(nx0+nx, nc));
+      };
+     HMatrix *RFSource=RFSourceBuffer, *RFDest=RFDestBuffer;
+     if (NXB<NXBlock)
+      { RFSource=new HMatrix(NBF, 6*NXB, RFSourceBuffer->ZM);
+        RFDest=new HMatrix(NBF, 6*NXB, RFDestBuffer->ZM);
+      };
+
+     /*--------------------------------------------------------------*/
+     /*- precompute 'reduced-field' vectors -------------------------*/
+     /*--------------------------------------------------------------*/
+     GetRFMatrix(Omega, kBloch, XBlock, RFDest, true);
+     if ( TwoPointDGF || HavekBloch )
+      GetRFMatrix(Omega, kBloch, XBlock, RFSource, false, TwoPointDGF ? 3 : 0);
+     else
+      RFSource->Copy(RFDest);
+
+     Log(" LUSolving...");
+     M->LUSolve(RFSource);
+
+     Log(" Computing VMVPs...");
+     ContractRFMatrices(NBF, NXB, RFDest->ZM, RFSource->ZM, GEGM + 18*((size_t)nx0));
+
+     if (XBlock!=XMatrix) delete XBlock;
+     if (RFSource!=RFSourceBuffer) delete RFSource;
+     if (RFDest!=RFDestBuffer) delete RFDest;
+   };
 
   /*--------------------------------------------------------------*/
+  /*- normalize and add direct contributions ---------------------*/
   /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  Log(" Computing VMVPs...");
+  int *RegionIndices = GetRegionIndices(XMatrix);
+  double LastXSource[3];
+  bool HaveLastXSource=false;
   for(int nx=0; nx<NX; nx++)
    { 
      double XDest[3];
      XMatrix->GetEntriesD(nx,"0:2",XDest);
-     int nr=GetRegionIndex(XDest);
+     int nr=RegionIndices[nx];
      if (nr==-1) continue;
 
      cdouble Eps, Mu;
@@ -139,7 +225,6 @@ HMatrix *RWGGeometry::GetDyadicGFs(cdouble Omega, double *kBloch,
      cdouble GMScatNormFac = +ZRel/(II*k);
 
      cdouble GEDirect[3][3], GMDirect[3][3];
-     double LastXSource[3];
      if (AddDirectContribution)
       { 
         cdouble GEDirectNormFac = k*k/Eps;
@@ -147,9 +232,10 @@ HMatrix *RWGGeometry::GetDyadicGFs(cdouble Omega, double *kBloch,
         double XSource[3];
         XMatrix->GetEntriesD(nx,"3:5",XSource);
         PS->SetX0(XSource);
-        if (nx==0 || !VecEqualFloat(XSource,LastXSource) )
+        if (!HaveLastXSource || !VecEqualFloat(XSource,LastXSource) )
          UpdateIncFields(PS, Omega, kBloch);
         memcpy(LastXSource,XSource,3*sizeof(double));
+        HaveLastXSource=true;
         for(int i=0; i<3; i++)
          { cdouble EH[6];
            cdouble P[3]={0.0, 0.0, 0.0};
@@ -169,13 +255,8 @@ HMatrix *RWGGeometry::GetDyadicGFs(cdouble Omega, double *kBloch,
      for(int i=0; i<3; i++)
       for(int j=0; j<3; j++)
        { 
-         cdouble GEScat=0.0, GMScat=0.0;
-         for(int nbf=0; nbf<NBF; nbf++)
-          { GEScat += RFDest->GetEntry(nbf, 6*nx+0+i) * RFSource->GetEntry(nbf, 6*nx+0+j);
-            GMScat += RFDest->GetEntry(nbf, 6*nx+3+i) * RFSource->GetEntry(nbf, 6*nx+3+j);
-          };
-         GEScat *= GEScatNormFac;
-         GMScat *= GMScatNormFac;
+         cdouble GEScat = GEScatNormFac * GEGM[18*nx + 0 + 3*i + j];
+         cdouble GMScat = GMScatNormFac * GEGM[18*nx + 9 + 3*i + j];
 
          GMatrix->SetEntry(nx, 0 + 3*i + j, GEScat);
          GMatrix->SetEntry(nx, 9 + 3*i + j, GMScat);
@@ -186,6 +267,8 @@ HMatrix *RWGGeometry::GetDyadicGFs(cdouble Omega, double *kBloch,
           };
        };
    };
+  free(RegionIndices);
+  free(GEGM);
 
   return GMatrix;
 
@@ -212,13 +212,12 @@ void RWGSurface::GetReducedPotentials(int ne, const double *X, cdouble K,
 /***************************************************************/
 /***************************************************************/
 void GetScatteredFields(RWGGeometry *G, const double *X, const int RegionIndex,
-                        HVector *KN, const cdouble Omega, Interp3D *GBarInterp,
-                        cdouble EHS[6])
+                        HVector *KN, const cdouble Omega,
+                        const cdouble Eps, const cdouble Mu,
+                        Interp3D *GBarInterp, cdouble EHS[6])
 { 
   memset(EHS, 0, 6*sizeof(cdouble));
 
-  cdouble Eps=G->EpsTF[RegionIndex];
-  cdouble Mu=G->MuTF[RegionIndex];
   cdouble iwe=II*Omega*Eps;
   cdouble iwu=II*Omega*Mu;
   cdouble K=csqrt2(Eps*Mu)*Omega;
@@ -284,6 +283,7 @@ typedef struct ThreadData
    HVector *KN;
    IncField *IF;
    cdouble Omega;
+   cdouble *EpsValues, *MuValues; // per-region values at Omega
    Interp3D **RegionInterpolators;
    ParsedFieldFunc **PFFuncs;
    int NumFuncs;
@@ -310,6 +310,8 @@ void *GetFields_Thread(void *data)
   HVector *KN                    = TD->KN;
   IncField *IFList               = TD->IF;
   cdouble Omega                  = TD->Omega;
+  cdouble *EpsValues             = TD->EpsValues;
+  cdouble *MuValues              = TD->MuValues;
   Interp3D **RegionInterpolators = TD->RegionInterpolators;
   ParsedFieldFunc **PFFuncs      = TD->PFFuncs;
   int NumFuncs                   = TD->NumFuncs;
@@ -340,8 +342,8 @@ void *GetFields_Thread(void *data)
      X[2]=XMatrix->GetEntryD(nr, 2);
 
      RegionIndex = G->GetRegionIndex(X);
-     Eps = G->EpsTF[RegionIndex];
-     Mu  = G->MuTF[RegionIndex];
+     Eps = EpsValues[RegionIndex];
+     Mu  = MuValues[RegionIndex];
      GBarInterp = RegionInterpolators ? RegionInterpolators[RegionIndex] : 0;
      memset(EH, 0, 6*sizeof(cdouble));
     
@@ -349,7 +351,7 @@ void *GetFields_Thread(void *data)
      /*- get scattered fields at X                                   */
      /*--------------------------------------------------------------*/
      if (KN)
-      GetScatteredFields(G, X, RegionIndex, KN, Omega, GBarInterp, EH);
+      GetScatteredFields(G, X, RegionIndex, KN, Omega, Eps, Mu, GBarInterp, EH);
 
      /*--------------------------------------------------------------*/
      /*- add incident fields by summing contributions of all        -*/
@@ -411,6 +413,15 @@ HMatrix *RWGGeometry::GetFieldGradients(IncField *IF, HVector *KN, cdouble Omega
   /***************************************************************/
   UpdateIncFields(IF, Omega, kBloch);
 
+  /***************************************************************/
+  /* material properties of each region at this frequency, in    */
+  /* per-call storage (the cached EpsTF/MuTF arrays are no       */
+  /* longer kept up to date by libscuff)                         */
+  /***************************************************************/
+  cdouble *EpsValues = new cdouble[NumRegions];
+  cdouble *MuValues  = new cdouble[NumRegions];
+  GetEpsMuValues(Omega, EpsValues, MuValues);
+
   /***************************************************************/
   /* For the periodic-boundary-condition case, we need to        */
   /* initialize interpolator objects for computing the periodic  */
@@ -443,6 +454,8 @@ HMatrix *RWGGeometry::GetFieldGradients(IncField *IF, HVector *KN, cdouble Omega
   ReferenceTD.KN=KN;
   ReferenceTD.IF=IF;
   ReferenceTD.Omega=Omega;
+  ReferenceTD.EpsValues=EpsValues;
+  ReferenceTD.MuValues=MuValues;
   ReferenceTD.RegionInterpolators=RegionInterpolators;
   ReferenceTD.PFFuncs=PFFuncs;
   ReferenceTD.NumFuncs=NumFuncs;
@@ -488,6 +501,8 @@ HMatrix *RWGGeometry::GetFieldGradients(IncField *IF, HVector *KN, cdouble Omega
   /* deallocate temporary storage ********************************/
   /***************************************************************/
   free(FCopy);
+  delete[] EpsValues;
+  delete[] MuValues;
   for(nf=0; nf<NumFuncs; nf++)
    delete PFFuncs[nf];
   delete[] PFFuncs;
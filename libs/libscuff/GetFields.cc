@@ -136,6 +136,19 @@ void GetDistanceToBF(double X0[3], RWGSurface *S, int ne)
 }
 #endif
 
+/***************************************************************/
+/* check (once) whether the new RF method has been requested   */
+/***************************************************************/
+static bool CheckNewRFMethod()
+{
+  char *s = getenv("SCUFF_NEW_RFMETHOD");
+  if (s && s[0]=='1')
+   { printf("Using new RF method.\n");
+     return true;
+   };
+  return false;
+}
+
 /***************************************************************/
 /* RFMatrix is a matrix of "reduced fields", i.e. a matrix     */
 /* whose columns may be dot-producted with the KN vector (BEM  */
@@ -149,6 +162,8 @@ HMatrix *RWGGeometry::GetRFMatrix(cdouble Omega, double *kBloch0,
                                   HMatrix *XMatrix, HMatrix *RFMatrix,
                                   bool MinuskBloch, int ColumnOffset)
 {
+  ProfileTimer PT("GetRFMatrix");
+
   double *kBloch=kBloch0;
   double kBlochBuffer[3];
   if (kBloch && MinuskBloch)
@@ -195,6 +210,12 @@ HMatrix *RWGGeometry::GetRFMatrix(cdouble Omega, double *kBloch0,
    Log("({O,I}rRelThreshold | LowOrder | HighOrder)=(%e,%e,%i,%i)",
        rRelOuterThreshold,rRelInnerThreshold,LowOrder,HighOrder);
 
+  // with an integration tolerance (and no explicitly requested
+  // orders) the cubature order is chosen per (edge, point) pair
+  // from the error model; the evaluation point is at least rRel-1
+  // panel radii from the centroid of either panel
+  double Tolerance = (s3||s4) ? 0.0 : IntegrationTolerance;
+
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
@@ -226,17 +247,16 @@ HMatrix *RWGGeometry::GetRFMatrix(cdouble Omega, double *kBloch0,
   /***************************************************************/
   /***************************************************************/
 /*!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
-  static bool Initialized=false, UseNewMethod=false;
-  if (Initialized==false)
-   { Initialized=true;
-     char *s = getenv("SCUFF_NEW_RFMETHOD");
-     if(s && s[0]=='1')
-      { printf("Using new RF method.\n");
-        UseNewMethod=true;
-      };
-   };
+  // (function-local static initialization is thread-safe)
+  static bool UseNewMethod=CheckNewRFMethod();
 /*!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!*/
 
+  /***************************************************************/
+  /* classify all evaluation points once up front, rather than   */
+  /* once per (edge, point) pair inside the loop below           */
+  /***************************************************************/
+  int *RegionIndices = GetRegionIndices(XMatrix, 0, ColumnOffset);
+
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
@@ -257,13 +277,13 @@ HMatrix *RWGGeometry::GetRFMatrix(cdouble Omega, double *kBloch0,
 
      int ns, ne, nbf;
      RWGSurface *S = ResolveEdge(neFull, &ns, &ne, &nbf);
-     RWGEdge *E    = S->Edges[ne];
+     RWGPackedMesh *PM = S->Packed;
 
      double X[3];
      X[0]=XMatrix->GetEntryD(nx,ColumnOffset+0);
      X[1]=XMatrix->GetEntryD(nx,ColumnOffset+1);
      X[2]=XMatrix->GetEntryD(nx,ColumnOffset+2);
-     int RegionIndex = GetRegionIndex(X);
+     int RegionIndex = RegionIndices[nx];
      if (RegionIndex==-1) continue; // inside a closed PEC surface
    
      double Sign=0.0;
@@ -289,9 +309,17 @@ HMatrix *RWGGeometry::GetRFMatrix(cdouble Omega, double *kBloch0,
      Data->RLVolume= RLVolume;
      Data->NewMethod = UseNewMethod;
 
-     double rRel = VecDistance(X, E->Centroid) / E->Radius;
+     double rRel = VecDistance(X, PM->ECentroid + 3*ne) / PM->ERadius[ne];
      const int IDim=12;
-     if (rRel >= rRelOuterThreshold)
+     int AdaptiveOrder=0;
+     if (Tolerance>0.0 && rRel>=rRelInnerThreshold && !Data->GBA)
+      AdaptiveOrder=SelectFieldCubatureOrder(rRel-1.0, abs(k)*PM->ERadius[ne], Tolerance);
+     if (AdaptiveOrder>0)
+      { 
+        GetBFCubature2(this, ns, ne, RFIntegrand, (void *)Data,
+                       IDim, AdaptiveOrder, (double *)GC);
+      }
+     else if (rRel >= rRelOuterThreshold)
       { 
         GetBFCubature2(this, ns, ne, RFIntegrand, (void *)Data,
                        IDim, LowOrder, (double *)GC);
@@ -362,6 +390,7 @@ HMatrix *RWGGeometry::GetRFMatrix(cdouble Omega, double *kBloch0,
      free(RegionGBAs);
    };
 
+  free(RegionIndices);
   delete[] ZRels;
   delete[] ks;
 
@@ -375,6 +404,8 @@ HMatrix *RWGGeometry::GetFields(IncField *IFList, HVector *KN,
                                 cdouble Omega, double *kBloch,
                                 HMatrix *XMatrix, HMatrix *FMatrix)
 { 
+  ProfileTimer PT("GetFields");
+
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
@@ -427,24 +458,39 @@ HMatrix *RWGGeometry::GetFields(IncField *IFList, HVector *KN,
    };
 
   /***************************************************************/
-  /* add contributions of incident fields if present *************/
+  /* add contributions of incident fields if present; each       */
+  /* IncField is called once, with a batch consisting of all     */
+  /* evaluation points that lie in its source region             */
   /***************************************************************/
   if (IFList)
-   for(int nx=0; nx<NX; nx++)
-    { 
-      double X[3];
-      XMatrix->GetEntriesD(nx,"0:2",X);
-      int RegionIndex = GetRegionIndex(X);
-      if (RegionIndex==-1) continue; // inside a closed PEC surface
-
-      for(IncField *IF=IFList; IF; IF=IF->Next)
-       if ( IF->RegionIndex == RegionIndex )
-        { cdouble EH[6];
-          IF->GetFields(X, EH);
-          for(int Mu=0; Mu<6; Mu++)
-           FMatrix->AddEntry(nx, Mu, EH[Mu]);
-        };
-    };
+   { ProfileTimer PTIF("IncidentFields");
+     int *RegionIndices = GetRegionIndices(XMatrix);
+     int *PointIndices  = (int *)mallocEC(NX*sizeof(int));
+     double *X          = (double *)mallocEC(3*NX*sizeof(double));
+     cdouble *EH        = (cdouble *)mallocEC(6*NX*sizeof(cdouble));
+     for(IncField *IF=IFList; IF; IF=IF->Next)
+      {
+        int NXIF=0;
+        for(int nx=0; nx<NX; nx++)
+         if ( RegionIndices[nx]!=-1 && IF->RegionIndex==RegionIndices[nx] )
+          PointIndices[NXIF++]=nx;
+        if (NXIF==0) continue;
+
+        for(int n=0; n<NXIF; n++)
+         for(int i=0; i<3; i++)
+          X[n + NXIF*i] = XMatrix->GetEntryD(PointIndices[n], i);
+
+        IF->GetFields(NXIF, X, EH);
+
+        for(int n=0; n<NXIF; n++)
+         for(int Mu=0; Mu<6; Mu++)
+          FMatrix->AddEntry(PointIndices[n], Mu, EH[n + NXIF*Mu]);
+      };
+     free(EH);
+     free(X);
+     free(PointIndices);
+     free(RegionIndices);
+   };
 
   return FMatrix;
          
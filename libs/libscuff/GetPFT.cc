@@ -63,7 +63,7 @@ HMatrix *GetEMTPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
                          HVector *KNVector, HMatrix *DRMatrix=0,
                          HMatrix *PFTMatrix=0, bool Interior=false,
                          int EMTPFTIMethod=SCUFF_EMTPFTI_DEFAULT,
-                         bool Itemize=false);
+                         bool Itemize=false, SCUFFWorkspace *Workspace=0);
 
 // matrix-trace version of DSIPFT for non-equilibrium calculations
 void GetDSIPFTTrace(RWGGeometry *G, cdouble Omega, HMatrix *DRMatrix,
@@ -151,6 +151,8 @@ void RWGGeometry::GetPFT(int SurfaceIndex, HVector *KN,
                          cdouble Omega, double PFT[NUMPFT],
                          PFTOptions *Options)
 {
+  ProfileTimer PT("GetPFT");
+
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
@@ -223,7 +225,8 @@ void RWGGeometry::GetPFT(int SurfaceIndex, HVector *KN,
      bool Interior      = Options->Interior;
      int  Method        = Options->EMTPFTIMethod;  
      HMatrix *PFTMatrix  = new HMatrix(NumSurfaces, NUMPFT);
-     GetEMTPFTMatrix(this, Omega, IF, KN, DRMatrix, PFTMatrix, Interior, Method);
+     GetEMTPFTMatrix(this, Omega, IF, KN, DRMatrix, PFTMatrix, Interior, Method,
+                     false, Options->Workspace);
      PFTMatrix->GetEntriesD(SurfaceIndex, ":", PFT);
      delete PFTMatrix;
    }
@@ -256,6 +259,8 @@ HMatrix *RWGGeometry::GetPFTMatrix(HVector *KN, cdouble Omega,
                                    PFTOptions *Options, 
                                    HMatrix *PFTMatrix)
 {
+  ProfileTimer PT("GetPFTMatrix");
+
   /***************************************************************/
   /***************************************************************/
   /***************************************************************/
@@ -286,7 +291,8 @@ HMatrix *RWGGeometry::GetPFTMatrix(HVector *KN, cdouble Omega,
   if (Options->PFTMethod==SCUFF_PFT_EMT)
    { 
      GetEMTPFTMatrix(this, Omega, IF, KN, DRMatrix,
-                     PFTMatrix, Options->Interior, Options->EMTPFTIMethod);
+                     PFTMatrix, Options->Interior, Options->EMTPFTIMethod,
+                     false, Options->Workspace);
    }
   else if (Options->PFTMethod==SCUFF_PFT_MOMENTS)
    { 
@@ -361,6 +367,7 @@ PFTOptions *InitPFTOptions(PFTOptions *Options)
   Options->DRMatrix=0;
   Options->IF=0;
   Options->kBloch=0;
+  Options->Workspace=0;
 
   // options affecting overlap PFT computation
   Options->RHSVector = 0;
@@ -261,3 +261,242 @@ HVector *GetSphericalMoments(RWGGeometry *G, cdouble Omega, int lMax,
   return MomentVector;
    
 }
+
+/***************************************************************/
+/* integrand function passed to GetBFCubature2 to compute, for */
+/* a single RWG function b, both the projections <W|b> used by */
+/* GetSphericalMoments and the incident-field inner products   */
+/* (b,W) used to assemble RHS vectors for regular VSWs         */
+/***************************************************************/
+typedef struct VSWMatrixData
+ {
+   double lMax;
+   cdouble k;
+   HMatrix *MWMatrix, *MWMatrix2;
+   cdouble *Workspace;
+   double X0[3];
+ } VSWMatrixData;
+
+void VSWRWGMatrixIntegrand(double x[3], double b[3], double Divb,
+                           void *UserData, double Weight,
+                           double *Integral)
+{
+  (void) Divb; // unused 
+
+  VSWMatrixData *Data = (VSWMatrixData *)UserData;
+  int NumMoments      = Data->MWMatrix->NC;
+
+  double xRel[3], r, Theta, Phi, bS[3];
+  VecSub(x, Data->X0, xRel);
+  CoordinateC2S(xRel,&r,&Theta,&Phi);
+  VectorC2S(Theta,Phi,b,bS);
+
+  GetMWMatrix(r, Theta, Phi, Data->k, Data->lMax, LS_REGULAR,
+              Data->MWMatrix, Data->Workspace, true);
+  GetMWMatrix(r, Theta, Phi, Data->k, Data->lMax, LS_REGULAR,
+              Data->MWMatrix2, Data->Workspace, false);
+
+  cdouble *zIntegral=(cdouble *)Integral;
+  for(int nmw=0; nmw<NumMoments; nmw++)
+   { cdouble *W  = (cdouble *)Data->MWMatrix->GetColumnPointer(nmw);
+     cdouble *W2 = (cdouble *)Data->MWMatrix2->GetColumnPointer(nmw);
+     zIntegral[nmw]            += Weight*conj(W[0]*bS[0] + W[1]*bS[1] + W[2]*bS[2]);
+     zIntegral[NumMoments+nmw] += Weight*(W2[0]*bS[0] + W2[1]*bS[1] + W2[2]*bS[2]);
+   };
+}
+
+/***************************************************************/
+/* compute, in a single pass over all basis functions, the     */
+/* matrices that relate surface-current vectors to spherical   */
+/* waves:                                                      */
+/*                                                             */
+/*  RHSMatrix (TotalBFs x NumMoments): column #Beta is the RHS */
+/*   vector that AssembleRHSVector would produce for the       */
+/*   incident regular spherical wave #Beta (sourced in the     */
+/*   exterior region).                                         */
+/*                                                             */
+/*  PMatrix (NumMoments x TotalBFs): PMatrix*KN is the vector  */
+/*   of spherical moments that GetSphericalMoments would       */
+/*   return for the surface-current vector KN.                 */
+/*                                                             */
+/* thus the T-matrix is PMatrix * Inverse[M] * RHSMatrix.      */
+/* either matrix may be NULL if it is not needed.              */
+/*                                                             */
+/* if WhichSurface is -1, all surfaces are included and the    */
+/* matrices have TotalBFs rows (columns); otherwise only       */
+/* surface #WhichSurface is included and the matrices have     */
+/* Surfaces[WhichSurface]->NumBFs rows (columns).              */
+/*                                                             */
+/* the spherical waves are centered at X0 (the origin if X0 is */
+/* NULL).                                                      */
+/***************************************************************/
+static void AssembleSphericalWaveMatrices(RWGGeometry *G, int WhichSurface,
+                                          double *X0, cdouble Omega, int lMax,
+                                          HMatrix *RHSMatrix, HMatrix *PMatrix)
+{
+  int NumLMs     = (lMax+1)*(lMax+1) - 1;
+  int NumMoments = 2*NumLMs;
+  int NBF        = (WhichSurface==-1) ? G->TotalBFs : G->Surfaces[WhichSurface]->NumBFs;
+  if (    (RHSMatrix && (RHSMatrix->NR!=NBF || RHSMatrix->NC!=NumMoments))
+       || (PMatrix   && (PMatrix->NR!=NumMoments || PMatrix->NC!=NBF))
+     )
+   ErrExit("%s:%i: wrong-size matrix passed to GetSphericalWaveMatrices",__FILE__,__LINE__);
+  if (RHSMatrix) RHSMatrix->Zero();
+  if (PMatrix) PMatrix->Zero();
+
+  cdouble EpsRel, MuRel;
+  G->RegionMPs[EXTERIOR_REGION]->GetEpsMu(Omega, &EpsRel, &MuRel);
+  cdouble k2 = EpsRel*MuRel*Omega*Omega, k=sqrt(k2);
+  cdouble Z  = ZVAC*sqrt(MuRel/EpsRel);
+
+  int NT=GetNumThreads();
+  char *s=getenv("SCUFF_SPHERICAL_SINGLETHREADED");
+  if ( s && s[0]=='1' )
+   NT=1;
+  int Order=20;
+  s=getenv("SCUFF_SPHERICAL_MOMENT_ORDER");
+  if (s && 1==sscanf(s,"%i",&Order))
+   Log("Using cubature order %i in GetSphericalWaveMatrices", Order);
+
+  /***************************************************************/
+  /* flat list of (surface, edge) pairs on surfaces bounding the */
+  /* exterior region, with Sign = +1 (-1) if the exterior region */
+  /* is on the positive (negative) side of the surface           */
+  /***************************************************************/
+  int NumEdges=0;
+  for(int ns=0; ns<G->NumSurfaces; ns++)
+   NumEdges += G->Surfaces[ns]->NumEdges;
+  int *SurfaceEdge = (int *)mallocEC(2*NumEdges*sizeof(int));
+  double *Signs    = (double *)mallocEC(G->NumSurfaces*sizeof(double));
+  int NumTasks=0;
+  for(int ns=0; ns<G->NumSurfaces; ns++)
+   { RWGSurface *S=G->Surfaces[ns];
+     if (WhichSurface!=-1 && ns!=WhichSurface)
+      continue;
+     if (S->RegionIndices[0]==EXTERIOR_REGION)
+      Signs[ns]=+1.0;
+     else if (S->RegionIndices[1]==EXTERIOR_REGION)
+      Signs[ns]=-1.0;
+     else
+      continue;
+     for(int ne=0; ne<S->NumEdges; ne++, NumTasks++)
+      { SurfaceEdge[2*NumTasks+0]=ns;
+        SurfaceEdge[2*NumTasks+1]=ne;
+      }
+   }
+
+  /***************************************************************/
+  /* allocate per-thread storage buffers                         */
+  /***************************************************************/
+  VSWMatrixData *Data = (VSWMatrixData *)mallocEC(NT*sizeof(Data[0]));
+  cdouble *IBuffer    = (cdouble *)mallocEC(2*NT*NumMoments*sizeof(cdouble));
+  for(int nt=0; nt<NT; nt++)
+   { Data[nt].lMax      = lMax;
+     Data[nt].k         = k;
+     Data[nt].MWMatrix  = new HMatrix(3, NumMoments, LHM_COMPLEX);
+     Data[nt].MWMatrix2 = new HMatrix(3, NumMoments, LHM_COMPLEX);
+     Data[nt].Workspace = (cdouble *)mallocEC(7*(NumLMs+1)*sizeof(cdouble));
+     if (X0)
+      memcpy(Data[nt].X0, X0, 3*sizeof(double));
+     else
+      Data[nt].X0[0] = Data[nt].X0[1] = Data[nt].X0[2] = 0.0;
+   };
+  Log("Computing spherical-wave incidence/projection matrices (%i BFs, %i waves, %i threads)",
+       NBF, NumMoments, NT);
+
+  /***************************************************************/
+  /* each basis function fills its own row(s) of RHSMatrix and   */
+  /* column(s) of PMatrix, so threads never write the same entry */
+  /***************************************************************/
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic,1), num_threads(NT)
+#endif
+  for(int nTask=0; nTask<NumTasks; nTask++)
+   { 
+     int nt=0;
+#ifdef USE_OPENMP
+     nt = omp_get_thread_num();
+#endif
+     int ns = SurfaceEdge[2*nTask+0], ne = SurfaceEdge[2*nTask+1];
+     RWGSurface *S = G->Surfaces[ns];
+     double Sign   = Signs[ns];
+
+     // Integral[nmw]            = <W_{nmw} | b>
+     // Integral[NumMoments+nmw] = (b, W_{nmw})
+     cdouble *Integral = IBuffer + 2*nt*NumMoments;
+     GetBFCubature2(G, ns, ne, VSWRWGMatrixIntegrand, (void *)(Data+nt),
+                    4*NumMoments, Order, (double *)Integral);
+     cdouble *RIntegral = Integral + NumMoments;
+
+     // indices of the electric and magnetic current coefficients
+     int Offset = (WhichSurface==-1) ? G->BFIndexOffset[ns] : 0;
+     int kIndex = S->IsPEC ? Offset + ne : Offset + 2*ne + 0;
+     int nIndex = S->IsPEC ? -1          : Offset + 2*ne + 1;
+
+     for(int nlm=0; nlm<NumLMs; nlm++)
+      { 
+        // see GetSphericalMoments and GetKNCoefficients for the
+        // signs and factors here, and SphericalWave::GetFields
+        // and AssembleRHSVector for those in the RHS entries
+        if (PMatrix)
+         { cdouble MdotB = Integral[2*nlm+0], NdotB = Integral[2*nlm+1];
+           cdouble PreFac = -1.0*Sign*k2*ZVAC;
+           PMatrix->SetEntry(2*nlm+0, kIndex, PreFac*MdotB);
+           PMatrix->SetEntry(2*nlm+1, kIndex, PreFac*NdotB);
+           if (nIndex!=-1)
+            { PMatrix->SetEntry(2*nlm+0, nIndex,  PreFac*NdotB);
+              PMatrix->SetEntry(2*nlm+1, nIndex, -PreFac*MdotB);
+            }
+         }
+
+        if (RHSMatrix)
+         { cdouble BdotM = RIntegral[2*nlm+0], BdotN = RIntegral[2*nlm+1];
+           double RHSSign = -1.0*Sign;
+           RHSMatrix->SetEntry(kIndex, 2*nlm+0, RHSSign*BdotM/ZVAC);
+           RHSMatrix->SetEntry(kIndex, 2*nlm+1, RHSSign*BdotN/ZVAC);
+           if (nIndex!=-1)
+            { RHSMatrix->SetEntry(nIndex, 2*nlm+0, -1.0*RHSSign*BdotN/Z);
+              RHSMatrix->SetEntry(nIndex, 2*nlm+1,      RHSSign*BdotM/Z);
+            }
+         }
+      }
+   }
+
+  if (RHSMatrix && WhichSurface==-1 && G->UseHRWGFunctions && G->NumMMJs>0)
+   for(int nc=0; nc<NumMoments; nc++)
+    { HVector RHSColumn(NBF, LHM_COMPLEX, (cdouble *)RHSMatrix->GetColumnPointer(nc));
+      G->ApplyMMJTransformation(0, &RHSColumn);
+    }
+
+  /***************************************************************/
+  /***************************************************************/
+  /***************************************************************/
+  for(int nt=0; nt<NT; nt++)
+   { delete Data[nt].MWMatrix;
+     delete Data[nt].MWMatrix2;
+     free(Data[nt].Workspace);
+   };
+  free(IBuffer);
+  free(Data);
+  free(Signs);
+  free(SurfaceEdge);
+}
+
+void GetSphericalWaveMatrices(RWGGeometry *G, cdouble Omega, int lMax,
+                              HMatrix *RHSMatrix, HMatrix *PMatrix)
+{
+  AssembleSphericalWaveMatrices(G, -1, 0, Omega, lMax, RHSMatrix, PMatrix);
+}
+
+/***************************************************************/
+/* same as above, but for the single surface #ns, with the     */
+/* spherical waves centered at X0. the matrices have           */
+/* Surfaces[ns]->NumBFs rows (RHSMatrix) or columns (PMatrix), */
+/* and both are zero if ns does not bound the exterior region. */
+/***************************************************************/
+void GetSphericalWaveMatrices(RWGGeometry *G, int ns, double X0[3],
+                              cdouble Omega, int lMax,
+                              HMatrix *RHSMatrix, HMatrix *PMatrix)
+{
+  AssembleSphericalWaveMatrices(G, ns, X0, Omega, lMax, RHSMatrix, PMatrix);
+}
@@ -0,0 +1,500 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * IntegrationRules.cc -- tolerance-driven choice of the cubature rules
+ *                     -- used for panel-panel and field integrals, and
+ *                     -- statistics on the panel-panel integration
+ *                     -- algorithms used during BEM matrix assembly
+ *
+ * The error model is a table of the worst-case relative error
+ * incurred by each of the triangle cubature rules of GetTCR
+ * in computing
+ *
+ *  (a) the panel-panel integrals H[0], H[1] (same rule on both panels)
+ *  (b) the reduced-field integrals \int f G, \int f x \nabla G over a
+ *      single panel at an evaluation point
+ *
+ * tabulated vs. rRel (the distance between panel centroids, or between
+ * evaluation point and panel centroid, in units of the panel radius)
+ * and kR (|k| times the panel radius). The tables were generated by
+ * CalibrateIntegrationRules.cc (with its default options), which
+ * compares each rule to a reference computation (the order-25 rule
+ * on subdivided panels) for 64 random well-shaped panel pairs and
+ * 256 random panel/evaluation-point configurations at each (rRel,kR)
+ * point; entries are log10(error), clamped at 1e-12,
+ * and made monotonic (nonincreasing in rRel, nondecreasing in kR) so
+ * that looking up the grid point nearer the panel and at the
+ * next-higher kR yields an upper bound. The unit test
+ * unit-test-IntegrationRules checks the orders selected from the
+ * tables against a reference panel pair.
+ *
+ * Given a tolerance, we pick the rule with the fewest cubature points
+ * whose tabulated error does not exceed the tolerance.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libhrutil.h>
+
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+namespace scuff {
+
+/***************************************************************/
+/* the cubature rules, in order of increasing cost             */
+/***************************************************************/
+#define NUMRULES 11
+static const int RuleOrders[NUMRULES]={1, 2, 4, 5, 7, 9, 13, 14, 16, 20, 25};
+
+#define NUMKR 6
+static const double kRValues[NUMKR]={0.0, 0.5, 1.0, 2.0, 4.0, 8.0};
+
+#define NUMPPIRREL 9
+static const double PPIrRelValues[NUMPPIRREL]=
+ {2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 24.0, 32.0};
+
+#define NUMFIELDRREL 11
+static const double FieldrRelValues[NUMFIELDRREL]=
+ {1.0, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 24.0, 32.0};
+
+/***************************************************************/
+/* log10(relative error) for panel-panel integrals             */
+/***************************************************************/
+static const double PPIErrorTable[NUMRULES][NUMPPIRREL][NUMKR]=
+ {
+   { // order 1
+     {  -1.3,  -1.1,  -0.8,   0.2,   1.1,   2.4 }, // rRel=2
+     {  -1.7,  -1.4,  -0.8,   0.2,   1.1,   2.4 }, // rRel=3
+     {  -1.9,  -1.5,  -0.8,   0.2,   1.1,   2.4 }, // rRel=4
+     {  -2.3,  -1.5,  -0.8,   0.2,   1.1,   2.4 }, // rRel=6
+     {  -2.5,  -1.5,  -0.8,   0.2,   1.1,   2.4 }, // rRel=8
+     {  -3.0,  -1.5,  -0.8,   0.2,   1.1,   2.4 }, // rRel=12
+     {  -3.1,  -1.5,  -0.8,   0.2,   1.1,   2.4 }, // rRel=16
+     {  -3.6,  -1.5,  -0.8,   0.2,   1.1,   2.4 }, // rRel=24
+     {  -3.8,  -1.5,  -0.8,  -0.1,   0.9,   2.4 }  // rRel=32
+   },
+   { // order 2
+     {  -2.5,  -2.4,  -2.0,  -0.6,   0.2,   1.9 }, // rRel=2
+     {  -3.0,  -3.0,  -2.3,  -0.6,   0.1,   1.9 }, // rRel=3
+     {  -3.5,  -3.2,  -2.4,  -0.6,   0.1,   1.9 }, // rRel=4
+     {  -3.9,  -3.4,  -2.5,  -0.6,   0.1,   1.9 }, // rRel=6
+     {  -4.4,  -3.5,  -2.5,  -0.6,   0.1,   1.9 }, // rRel=8
+     {  -4.9,  -3.5,  -2.5,  -0.6,   0.1,   1.9 }, // rRel=12
+     {  -5.3,  -3.5,  -2.5,  -0.6,   0.1,   1.9 }, // rRel=16
+     {  -5.7,  -3.5,  -2.5,  -0.6,   0.1,   1.9 }, // rRel=24
+     {  -6.1,  -3.5,  -2.5,  -1.2,   0.0,   1.9 }  // rRel=32
+   },
+   { // order 4
+     {  -3.6,  -3.6,  -3.4,  -1.9,  -0.7,   0.9 }, // rRel=2
+     {  -4.6,  -4.6,  -4.3,  -1.9,  -0.9,   0.9 }, // rRel=3
+     {  -5.5,  -5.3,  -4.4,  -1.9,  -0.9,   0.9 }, // rRel=4
+     {  -6.5,  -5.9,  -4.4,  -1.9,  -0.9,   0.9 }, // rRel=6
+     {  -7.1,  -6.0,  -4.4,  -1.9,  -0.9,   0.7 }, // rRel=8
+     {  -7.9,  -6.0,  -4.4,  -1.9,  -0.9,   0.7 }, // rRel=12
+     {  -8.6,  -6.0,  -4.4,  -1.9,  -0.9,   0.7 }, // rRel=16
+     {  -9.4,  -6.0,  -4.4,  -1.9,  -0.9,   0.7 }, // rRel=24
+     { -10.1,  -6.0,  -4.4,  -2.6,  -1.0,   0.7 }  // rRel=32
+   },
+   { // order 5
+     {  -3.9,  -3.8,  -3.4,  -2.4,  -0.9,   0.8 }, // rRel=2
+     {  -5.0,  -4.8,  -4.7,  -2.4,  -0.9,   0.8 }, // rRel=3
+     {  -5.8,  -5.8,  -5.0,  -2.4,  -0.9,   0.8 }, // rRel=4
+     {  -6.9,  -6.7,  -5.0,  -2.4,  -0.9,   0.8 }, // rRel=6
+     {  -7.7,  -7.0,  -5.0,  -2.4,  -0.9,   0.8 }, // rRel=8
+     {  -8.7,  -7.0,  -5.0,  -2.4,  -0.9,   0.8 }, // rRel=12
+     {  -9.5,  -7.0,  -5.0,  -2.4,  -0.9,   0.8 }, // rRel=16
+     { -10.5,  -7.0,  -5.0,  -2.4,  -0.9,   0.8 }, // rRel=24
+     { -11.3,  -7.0,  -5.0,  -3.1,  -1.1,   0.8 }  // rRel=32
+   },
+   { // order 7
+     {  -4.4,  -4.2,  -4.2,  -3.7,  -2.1,   0.3 }, // rRel=2
+     {  -6.4,  -6.4,  -6.0,  -4.2,  -2.1,   0.3 }, // rRel=3
+     {  -7.5,  -7.3,  -6.9,  -4.2,  -2.1,   0.3 }, // rRel=4
+     {  -9.1,  -8.9,  -7.5,  -4.2,  -2.1,   0.3 }, // rRel=6
+     { -10.1,  -9.8,  -7.5,  -4.2,  -2.1,   0.3 }, // rRel=8
+     { -11.5, -10.1,  -7.5,  -4.2,  -2.1,   0.3 }, // rRel=12
+     { -12.0, -10.1,  -7.5,  -4.2,  -2.1,   0.3 }, // rRel=16
+     { -12.0, -10.1,  -7.5,  -4.2,  -2.1,   0.3 }, // rRel=24
+     { -12.0, -10.1,  -7.5,  -4.8,  -2.4,   0.3 }  // rRel=32
+   },
+   { // order 9
+     {  -5.8,  -5.6,  -5.4,  -5.0,  -3.8,  -0.6 }, // rRel=2
+     {  -8.4,  -8.4,  -7.8,  -6.5,  -3.8,  -0.6 }, // rRel=3
+     { -10.2,  -9.9,  -9.5,  -6.5,  -3.8,  -0.6 }, // rRel=4
+     { -12.0, -11.8, -10.3,  -6.5,  -3.8,  -0.6 }, // rRel=6
+     { -12.0, -12.0, -10.3,  -6.5,  -3.8,  -0.6 }, // rRel=8
+     { -12.0, -12.0, -10.3,  -6.5,  -3.8,  -0.6 }, // rRel=12
+     { -12.0, -12.0, -10.3,  -6.5,  -3.8,  -0.6 }, // rRel=16
+     { -12.0, -12.0, -10.3,  -6.5,  -3.8,  -0.6 }, // rRel=24
+     { -12.0, -12.0, -10.3,  -7.1,  -4.0,  -0.6 }  // rRel=32
+   },
+   { // order 13
+     {  -7.5,  -7.1,  -7.1,  -6.9,  -5.5,  -3.0 }, // rRel=2
+     { -10.8, -10.8, -10.4, -10.4,  -7.3,  -3.0 }, // rRel=3
+     { -12.0, -12.0, -12.0, -11.2,  -7.3,  -3.0 }, // rRel=4
+     { -12.0, -12.0, -12.0, -11.2,  -7.3,  -3.0 }, // rRel=6
+     { -12.0, -12.0, -12.0, -11.2,  -7.3,  -3.0 }, // rRel=8
+     { -12.0, -12.0, -12.0, -11.2,  -7.4,  -3.0 }, // rRel=12
+     { -12.0, -12.0, -12.0, -11.2,  -7.4,  -3.0 }, // rRel=16
+     { -12.0, -12.0, -12.0, -11.2,  -7.4,  -3.0 }, // rRel=24
+     { -12.0, -12.0, -12.0, -11.6,  -7.4,  -3.0 }  // rRel=32
+   },
+   { // order 14
+     {  -7.4,  -7.2,  -7.0,  -6.7,  -5.6,  -2.9 }, // rRel=2
+     { -11.3, -11.3, -10.6,  -9.8,  -7.2,  -2.9 }, // rRel=3
+     { -11.6, -11.6, -11.6, -11.3,  -7.2,  -2.9 }, // rRel=4
+     { -11.6, -11.6, -11.6, -11.3,  -7.2,  -2.9 }, // rRel=6
+     { -11.6, -11.6, -11.6, -11.4,  -7.3,  -2.9 }, // rRel=8
+     { -11.6, -11.6, -11.6, -11.4,  -7.4,  -2.9 }, // rRel=12
+     { -11.6, -11.6, -11.6, -11.4,  -7.4,  -2.9 }, // rRel=16
+     { -11.6, -11.6, -11.6, -11.4,  -7.4,  -2.9 }, // rRel=24
+     { -11.6, -11.6, -11.6, -11.5,  -7.4,  -2.9 }  // rRel=32
+   },
+   { // order 16
+     {  -8.7,  -8.3,  -8.3,  -8.3,  -7.1,  -5.9 }, // rRel=2
+     { -11.8, -11.8, -11.8, -11.7, -10.8,  -5.9 }, // rRel=3
+     { -11.8, -11.8, -11.8, -11.7, -10.8,  -5.9 }, // rRel=4
+     { -11.8, -11.8, -11.8, -11.7, -10.8,  -5.9 }, // rRel=6
+     { -11.8, -11.8, -11.8, -11.7, -10.8,  -5.9 }, // rRel=8
+     { -11.8, -11.8, -11.8, -11.8, -10.9,  -5.9 }, // rRel=12
+     { -11.8, -11.8, -11.8, -11.8, -10.9,  -5.9 }, // rRel=16
+     { -11.8, -11.8, -11.8, -11.8, -10.9,  -5.9 }, // rRel=24
+     { -11.8, -11.8, -11.8, -11.8, -10.9,  -5.9 }  // rRel=32
+   },
+   { // order 20
+     { -10.0,  -9.5,  -9.5,  -9.5,  -8.2,  -7.4 }, // rRel=2
+     { -11.7, -11.7, -11.6, -11.1, -11.1,  -9.0 }, // rRel=3
+     { -11.7, -11.7, -11.7, -11.1, -11.1,  -9.0 }, // rRel=4
+     { -11.7, -11.7, -11.7, -11.2, -11.1,  -9.0 }, // rRel=6
+     { -11.7, -11.7, -11.7, -11.4, -11.1,  -9.0 }, // rRel=8
+     { -11.7, -11.7, -11.7, -11.4, -11.1,  -9.0 }, // rRel=12
+     { -11.7, -11.7, -11.7, -11.4, -11.1,  -9.0 }, // rRel=16
+     { -11.7, -11.7, -11.7, -11.4, -11.3,  -9.0 }, // rRel=24
+     { -11.7, -11.7, -11.7, -11.6, -11.3,  -9.0 }  // rRel=32
+   },
+   { // order 25
+     { -11.6, -11.1, -11.1, -11.1,  -9.9,  -9.1 }, // rRel=2
+     { -12.0, -12.0, -12.0, -11.5, -11.0, -10.4 }, // rRel=3
+     { -12.0, -12.0, -12.0, -11.5, -11.0, -10.5 }, // rRel=4
+     { -12.0, -12.0, -12.0, -11.6, -11.0, -10.5 }, // rRel=6
+     { -12.0, -12.0, -12.0, -11.6, -11.0, -10.5 }, // rRel=8
+     { -12.0, -12.0, -12.0, -11.7, -11.0, -10.5 }, // rRel=12
+     { -12.0, -12.0, -12.0, -11.7, -11.0, -10.5 }, // rRel=16
+     { -12.0, -12.0, -12.0, -11.7, -11.0, -10.5 }, // rRel=24
+     { -12.0, -12.0, -12.0, -11.8, -11.3, -10.5 }  // rRel=32
+   }
+ };
+
+/***************************************************************/
+/* log10(relative error) for reduced-field integrals           */
+/***************************************************************/
+static const double FieldErrorTable[NUMRULES][NUMFIELDRREL][NUMKR]=
+ {
+   { // order 1
+     {  -0.1,  -0.1,  -0.1,   0.0,   0.8,   1.7 }, // rRel=1
+     {  -0.6,  -0.6,  -0.4,  -0.2,   0.8,   1.7 }, // rRel=1.5
+     {  -0.8,  -0.7,  -0.6,  -0.2,   0.8,   1.7 }, // rRel=2
+     {  -1.0,  -0.9,  -0.6,  -0.2,   0.8,   1.7 }, // rRel=3
+     {  -1.2,  -0.9,  -0.6,  -0.2,   0.8,   1.7 }, // rRel=4
+     {  -1.4,  -0.9,  -0.6,  -0.2,   0.8,   1.7 }, // rRel=6
+     {  -1.5,  -1.0,  -0.6,  -0.2,   0.8,   1.7 }, // rRel=8
+     {  -1.7,  -1.0,  -0.6,  -0.2,   0.8,   1.5 }, // rRel=12
+     {  -1.8,  -1.0,  -0.6,  -0.2,   0.8,   1.5 }, // rRel=16
+     {  -2.0,  -1.0,  -0.7,  -0.2,   0.8,   1.5 }, // rRel=24
+     {  -2.1,  -1.0,  -0.7,  -0.2,   0.8,   1.5 }  // rRel=32
+   },
+   { // order 2
+     {  -0.4,  -0.4,  -0.4,  -0.4,   0.2,   1.4 }, // rRel=1
+     {  -1.4,  -1.4,  -1.3,  -1.0,   0.2,   1.4 }, // rRel=1.5
+     {  -1.9,  -1.9,  -1.6,  -1.2,   0.2,   1.4 }, // rRel=2
+     {  -2.4,  -2.3,  -1.9,  -1.2,   0.2,   1.4 }, // rRel=3
+     {  -2.7,  -2.5,  -2.0,  -1.2,   0.2,   1.4 }, // rRel=4
+     {  -3.1,  -2.7,  -2.0,  -1.2,   0.2,   1.4 }, // rRel=6
+     {  -3.4,  -2.7,  -2.0,  -1.2,   0.2,   1.4 }, // rRel=8
+     {  -3.9,  -2.8,  -2.1,  -1.2,   0.2,   1.3 }, // rRel=12
+     {  -4.1,  -2.8,  -2.1,  -1.2,   0.2,   1.3 }, // rRel=16
+     {  -4.5,  -2.8,  -2.1,  -1.2,   0.2,   1.3 }, // rRel=24
+     {  -4.8,  -2.8,  -2.1,  -1.2,   0.2,   1.3 }  // rRel=32
+   },
+   { // order 4
+     {  -0.7,  -0.6,  -0.6,  -0.6,  -0.5,   1.0 }, // rRel=1
+     {  -2.2,  -2.2,  -2.2,  -2.0,  -0.8,   1.0 }, // rRel=1.5
+     {  -3.1,  -3.0,  -2.8,  -2.3,  -0.8,   1.0 }, // rRel=2
+     {  -3.9,  -3.9,  -3.6,  -2.5,  -0.8,   1.0 }, // rRel=3
+     {  -4.5,  -4.4,  -3.8,  -2.5,  -0.8,   1.0 }, // rRel=4
+     {  -5.3,  -5.0,  -3.8,  -2.5,  -0.8,   1.0 }, // rRel=6
+     {  -5.9,  -5.1,  -3.8,  -2.5,  -0.8,   1.0 }, // rRel=8
+     {  -6.7,  -5.1,  -3.8,  -2.5,  -0.8,   0.9 }, // rRel=12
+     {  -7.1,  -5.1,  -3.8,  -2.6,  -0.8,   0.9 }, // rRel=16
+     {  -7.9,  -5.1,  -3.8,  -2.6,  -0.8,   0.9 }, // rRel=24
+     {  -8.4,  -5.1,  -3.9,  -2.6,  -0.8,   0.9 }  // rRel=32
+   },
+   { // order 5
+     {  -0.6,  -0.6,  -0.6,  -0.6,  -0.4,   1.2 }, // rRel=1
+     {  -2.3,  -2.3,  -2.3,  -2.2,  -0.9,   1.2 }, // rRel=1.5
+     {  -3.2,  -3.1,  -3.1,  -2.8,  -0.9,   1.2 }, // rRel=2
+     {  -4.2,  -4.1,  -4.1,  -2.9,  -0.9,   1.2 }, // rRel=3
+     {  -4.9,  -4.8,  -4.4,  -2.9,  -0.9,   1.2 }, // rRel=4
+     {  -5.9,  -5.8,  -4.4,  -2.9,  -0.9,   1.2 }, // rRel=6
+     {  -6.6,  -6.0,  -4.4,  -2.9,  -0.9,   1.2 }, // rRel=8
+     {  -7.6,  -6.0,  -4.4,  -2.9,  -0.9,   1.0 }, // rRel=12
+     {  -8.3,  -6.0,  -4.4,  -2.9,  -0.9,   1.0 }, // rRel=16
+     {  -9.2,  -6.0,  -4.5,  -2.9,  -0.9,   1.0 }, // rRel=24
+     {  -9.8,  -6.0,  -4.5,  -2.9,  -0.9,   1.0 }  // rRel=32
+   },
+   { // order 7
+     {  -0.7,  -0.5,  -0.5,  -0.5,  -0.5,   0.8 }, // rRel=1
+     {  -2.8,  -2.8,  -2.8,  -2.7,  -2.1,   0.8 }, // rRel=1.5
+     {  -3.9,  -3.8,  -3.8,  -3.8,  -2.1,   0.8 }, // rRel=2
+     {  -5.5,  -5.5,  -5.5,  -4.6,  -2.1,   0.8 }, // rRel=3
+     {  -6.5,  -6.5,  -6.2,  -4.7,  -2.1,   0.8 }, // rRel=4
+     {  -8.0,  -7.9,  -6.7,  -4.7,  -2.1,   0.8 }, // rRel=6
+     {  -8.9,  -8.6,  -6.7,  -4.7,  -2.1,   0.8 }, // rRel=8
+     { -10.2,  -8.9,  -6.7,  -4.7,  -2.1,   0.5 }, // rRel=12
+     { -11.2,  -8.9,  -6.7,  -4.7,  -2.1,   0.5 }, // rRel=16
+     { -12.0,  -8.9,  -6.8,  -4.7,  -2.1,   0.5 }, // rRel=24
+     { -12.0,  -8.9,  -6.8,  -4.7,  -2.1,   0.5 }  // rRel=32
+   },
+   { // order 9
+     {  -1.3,  -1.3,  -1.3,  -1.3,  -1.3,  -0.2 }, // rRel=1
+     {  -4.1,  -4.1,  -4.1,  -4.1,  -3.7,  -0.2 }, // rRel=1.5
+     {  -5.5,  -5.5,  -5.5,  -5.5,  -3.7,  -0.2 }, // rRel=2
+     {  -7.7,  -7.6,  -7.6,  -6.9,  -3.7,  -0.2 }, // rRel=3
+     {  -9.0,  -9.0,  -8.8,  -6.9,  -3.7,  -0.2 }, // rRel=4
+     { -10.9, -10.8,  -9.6,  -6.9,  -3.7,  -0.2 }, // rRel=6
+     { -12.0, -11.9,  -9.6,  -6.9,  -3.7,  -0.2 }, // rRel=8
+     { -12.0, -12.0,  -9.6,  -6.9,  -3.7,  -0.5 }, // rRel=12
+     { -12.0, -12.0,  -9.6,  -6.9,  -3.7,  -0.5 }, // rRel=16
+     { -12.0, -12.0,  -9.6,  -6.9,  -3.7,  -0.5 }, // rRel=24
+     { -12.0, -12.0,  -9.7,  -6.9,  -3.7,  -0.5 }  // rRel=32
+   },
+   { // order 13
+     {  -1.7,  -1.7,  -1.7,  -1.7,  -1.5,  -1.0 }, // rRel=1
+     {  -5.8,  -5.8,  -5.8,  -5.8,  -5.5,  -2.4 }, // rRel=1.5
+     {  -8.0,  -7.9,  -7.9,  -7.9,  -7.2,  -2.4 }, // rRel=2
+     { -10.8, -10.8, -10.8, -10.7,  -7.2,  -2.4 }, // rRel=3
+     { -12.0, -12.0, -12.0, -11.5,  -7.2,  -2.4 }, // rRel=4
+     { -12.0, -12.0, -12.0, -11.5,  -7.2,  -2.4 }, // rRel=6
+     { -12.0, -12.0, -12.0, -11.5,  -7.2,  -2.4 }, // rRel=8
+     { -12.0, -12.0, -12.0, -11.5,  -7.2,  -2.8 }, // rRel=12
+     { -12.0, -12.0, -12.0, -11.5,  -7.2,  -2.8 }, // rRel=16
+     { -12.0, -12.0, -12.0, -11.6,  -7.2,  -2.8 }, // rRel=24
+     { -12.0, -12.0, -12.0, -11.7,  -7.2,  -2.8 }  // rRel=32
+   },
+   { // order 14
+     {  -1.7,  -1.6,  -1.6,  -1.6,  -1.5,  -1.1 }, // rRel=1
+     {  -5.9,  -5.9,  -5.9,  -5.9,  -5.6,  -2.3 }, // rRel=1.5
+     {  -8.1,  -8.1,  -8.0,  -8.0,  -7.1,  -2.3 }, // rRel=2
+     { -10.8, -10.7, -10.7, -10.6,  -7.1,  -2.3 }, // rRel=3
+     { -11.7, -11.7, -11.7, -11.4,  -7.1,  -2.3 }, // rRel=4
+     { -11.7, -11.7, -11.7, -11.4,  -7.1,  -2.3 }, // rRel=6
+     { -11.7, -11.7, -11.7, -11.4,  -7.1,  -2.3 }, // rRel=8
+     { -11.7, -11.7, -11.7, -11.4,  -7.1,  -2.7 }, // rRel=12
+     { -11.7, -11.7, -11.7, -11.4,  -7.1,  -2.7 }, // rRel=16
+     { -11.7, -11.7, -11.7, -11.5,  -7.1,  -2.7 }, // rRel=24
+     { -11.7, -11.7, -11.7, -11.5,  -7.1,  -2.7 }  // rRel=32
+   },
+   { // order 16
+     {  -2.3,  -1.5,  -1.5,  -1.5,  -1.5,  -1.1 }, // rRel=1
+     {  -7.1,  -7.1,  -7.1,  -7.1,  -6.8,  -5.2 }, // rRel=1.5
+     { -10.2,  -9.9,  -9.9,  -9.9,  -9.8,  -5.2 }, // rRel=2
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.2 }, // rRel=3
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.2 }, // rRel=4
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.2 }, // rRel=6
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.2 }, // rRel=8
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.6 }, // rRel=12
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.6 }, // rRel=16
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.6 }, // rRel=24
+     { -11.9, -11.9, -11.9, -11.9, -10.9,  -5.6 }  // rRel=32
+   },
+   { // order 20
+     {  -2.8,  -2.1,  -2.1,  -2.1,  -2.1,  -1.7 }, // rRel=1
+     {  -8.9,  -8.9,  -8.9,  -8.8,  -8.5,  -8.2 }, // rRel=1.5
+     { -11.6, -11.6, -11.6, -11.5, -11.2,  -8.3 }, // rRel=2
+     { -11.7, -11.7, -11.6, -11.5, -11.4,  -8.3 }, // rRel=3
+     { -11.7, -11.7, -11.6, -11.5, -11.4,  -8.3 }, // rRel=4
+     { -11.7, -11.7, -11.6, -11.6, -11.4,  -8.3 }, // rRel=6
+     { -11.7, -11.7, -11.6, -11.6, -11.4,  -8.3 }, // rRel=8
+     { -11.7, -11.7, -11.6, -11.6, -11.4,  -8.7 }, // rRel=12
+     { -11.7, -11.7, -11.6, -11.6, -11.4,  -8.7 }, // rRel=16
+     { -11.7, -11.7, -11.6, -11.6, -11.4,  -8.7 }, // rRel=24
+     { -11.7, -11.7, -11.6, -11.6, -11.4,  -8.7 }  // rRel=32
+   },
+   { // order 25
+     {  -3.7,  -2.4,  -2.4,  -2.4,  -2.4,  -2.1 }, // rRel=1
+     { -11.0, -11.0, -11.0, -11.0, -10.9, -10.3 }, // rRel=1.5
+     { -11.9, -11.9, -11.9, -11.8, -11.0, -10.5 }, // rRel=2
+     { -12.0, -12.0, -11.9, -11.8, -11.0, -10.5 }, // rRel=3
+     { -12.0, -12.0, -11.9, -11.8, -11.0, -10.5 }, // rRel=4
+     { -12.0, -12.0, -12.0, -11.8, -11.0, -10.5 }, // rRel=6
+     { -12.0, -12.0, -12.0, -11.8, -11.0, -10.5 }, // rRel=8
+     { -12.0, -12.0, -12.0, -11.8, -11.1, -10.6 }, // rRel=12
+     { -12.0, -12.0, -12.0, -11.9, -11.1, -10.7 }, // rRel=16
+     { -12.0, -12.0, -12.0, -11.9, -11.1, -10.7 }, // rRel=24
+     { -12.0, -12.0, -12.0, -11.9, -11.1, -10.7 }  // rRel=32
+   }
+ };
+
+/***************************************************************/
+/* return the tabulated log10(error) of rule #nr, or HUGE_VAL  */
+/* if (rRel, kR) lies outside the table (too near, or too      */
+/* oscillatory, for us to vouch for any rule)                  */
+/***************************************************************/
+static double LookupError(const double *Table, const double *rRelValues,
+                          int NumrRel, int nr, double rRel, double kR)
+{
+  if ( rRel<rRelValues[0] || kR>kRValues[NUMKR-1] )
+   return HUGE_VAL;
+
+  int nrr;
+  for(nrr=NumrRel-1; rRelValues[nrr]>rRel; nrr--)
+   ;
+  int nk;
+  for(nk=0; kRValues[nk]<kR; nk++)
+   ;
+
+  return Table[ (nr*NumrRel + nrr)*NUMKR + nk ];
+}
+
+static int FindRule(int Order)
+{
+  for(int nr=0; nr<NUMRULES; nr++)
+   if (RuleOrders[nr]==Order)
+    return nr;
+  ErrExit("%s:%i: no cubature rule of order %i",__FILE__,__LINE__,Order);
+  return 0;
+}
+
+/***************************************************************/
+/* the cheapest rule meeting the tolerance; if none does, the  */
+/* highest-order rule, or 0 if we are outside the table in the */
+/* near-field direction (in which case the caller should fall  */
+/* back to its usual choice)                                   */
+/***************************************************************/
+static int SelectOrder(const double *Table, const double *rRelValues,
+                       int NumrRel, double rRel, double kR, double Tolerance)
+{
+  if (rRel<rRelValues[0])
+   return 0;
+
+  double LogTol = log10(Tolerance);
+  for(int nr=0; nr<NUMRULES; nr++)
+   if ( LookupError(Table, rRelValues, NumrRel, nr, rRel, kR) <= LogTol )
+    return RuleOrders[nr];
+
+  return RuleOrders[NUMRULES-1];
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int SelectPPICubatureOrder(double rRel, double kR, double Tolerance)
+{ return SelectOrder(&(PPIErrorTable[0][0][0]), PPIrRelValues,
+                     NUMPPIRREL, rRel, kR, Tolerance);
+}
+
+int SelectFieldCubatureOrder(double rRel, double kR, double Tolerance)
+{ return SelectOrder(&(FieldErrorTable[0][0][0]), FieldrRelValues,
+                     NUMFIELDRREL, rRel, kR, Tolerance);
+}
+
+double GetPPICubatureError(int Order, double rRel, double kR)
+{ return pow(10.0, LookupError(&(PPIErrorTable[0][0][0]), PPIrRelValues,
+                               NUMPPIRREL, FindRule(Order), rRel, kR));
+}
+
+double GetFieldCubatureError(int Order, double rRel, double kR)
+{ return pow(10.0, LookupError(&(FieldErrorTable[0][0][0]), FieldrRelValues,
+                               NUMFIELDRREL, FindRule(Order), rRel, kR));
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void InitPPIStatistics(PPIStatistics *Stats)
+{ memset(Stats, 0, sizeof(PPIStatistics)); }
+
+void AddPPIStatistics(PPIStatistics *Total, PPIStatistics *Stats)
+{
+  for(int n=0; n<NUMPPIALGORITHMS; n++)
+   { Total->Count[n] += Stats->Count[n];
+     Total->Time[n]  += Stats->Time[n];
+   };
+  for(int n=0; n<=MAXTCRORDER; n++)
+   Total->OrderCount[n] += Stats->OrderCount[n];
+}
+
+/***************************************************************/
+/* write the statistics to the log file as a single line of    */
+/* 'key=value' pairs, e.g.                                     */
+/*  PPIs(label): LOC=12000/0.41s HOC=0/0s TD=...               */
+/*   orders=[4:11800,7:200]                                    */
+/* (times are only nonzero if timing was requested)            */
+/***************************************************************/
+static const char *PPIAlgorithmNames[NUMPPIALGORITHMS]
+ ={"LOC","HOC","TD","HKTD","DESING"};
+
+void LogPPIStatistics(PPIStatistics *Stats, const char *Label)
+{
+  const char **Names=PPIAlgorithmNames;
+
+  char Line[1000];
+  int n=snprintf(Line, 1000, "PPIs(%s):", Label ? Label : "");
+  for(int na=0; na<NUMPPIALGORITHMS && n<1000; na++)
+   n+=snprintf(Line+n, 1000-n, " %s=%lu/%.3gs",
+               Names[na], Stats->Count[na], Stats->Time[na]);
+
+  const char *Separator="";
+  if (n<1000) n+=snprintf(Line+n, 1000-n, " orders=[");
+  for(int p=0; p<=MAXTCRORDER && n<1000; p++)
+   if (Stats->OrderCount[p])
+    { n+=snprintf(Line+n, 1000-n, "%s%i:%lu",Separator,p,Stats->OrderCount[p]);
+      Separator=",";
+    };
+  if (n<1000) snprintf(Line+n, 1000-n, "]");
+
+  Log("%s",Line);
+}
+
+/***************************************************************/
+/* add the statistics to the performance profile: the time in  */
+/* each algorithm goes under the innermost running timer, and  */
+/* the cubature-order histogram goes to counters               */
+/***************************************************************/
+void ProfilePPIStatistics(PPIStatistics *Stats)
+{
+  char Name[100];
+  for(int na=0; na<NUMPPIALGORITHMS; na++)
+   if (Stats->Count[na])
+    { snprintf(Name, 100, "PPI.%s", PPIAlgorithmNames[na]);
+      ProfileAccumulate(Name, Stats->Time[na], Stats->Count[na]);
+    };
+  for(int p=0; p<=MAXTCRORDER; p++)
+   if (Stats->OrderCount[p])
+    { snprintf(Name, 100, "PPI.Order%i", p);
+      ProfileCount(Name, Stats->OrderCount[p]);
+    };
+}
+
+} // namespace scuff
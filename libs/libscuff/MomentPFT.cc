@@ -211,27 +211,11 @@ HMatrix *GetMomentPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
   /* ScatteredPFT[ns] = contributions of surface #ns to          */
   /*                    scattered PFT                            */
   /***************************************************************/
-  static int NSSave=0;
-  static HMatrix **ScatteredPFT=0, *ExtinctionPFT=0;
-  static HMatrix *PM;
-  if (NSSave!=NS)
-   { if (ScatteredPFT)
-      { for(int ns=0; ns<NSSave; ns++)
-         if (ScatteredPFT[ns]) 
-          delete ScatteredPFT[ns];
-        free(ScatteredPFT);
-       if (ExtinctionPFT)
-        delete ExtinctionPFT;
-       if (PM)
-        delete PM;
-      };
-     NSSave=NS;
-     ScatteredPFT=(HMatrix **)mallocEC(NS*sizeof(HMatrix));
-     for(int ns=0; ns<NS; ns++)
-      ScatteredPFT[ns]=new HMatrix(NS, NUMPFT);
-     ExtinctionPFT=new HMatrix(NS, NUMPFT);
-     PM=new HMatrix(NS, 6, LHM_COMPLEX);
-   };
+  HMatrix **ScatteredPFT=(HMatrix **)mallocEC(NS*sizeof(HMatrix *));
+  for(int ns=0; ns<NS; ns++)
+   ScatteredPFT[ns]=new HMatrix(NS, NUMPFT);
+  HMatrix *ExtinctionPFT=new HMatrix(NS, NUMPFT);
+  HMatrix *PM=new HMatrix(NS, 6, LHM_COMPLEX);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -338,6 +322,12 @@ HMatrix *GetMomentPFTMatrix(RWGGeometry *G, cdouble Omega, IncField *IF,
      WrotePreamble=true;
    };
 
+  for(int ns=0; ns<NS; ns++)
+   delete ScatteredPFT[ns];
+  free(ScatteredPFT);
+  delete ExtinctionPFT;
+  delete PM;
+
   return PFTMatrix;
 }
   
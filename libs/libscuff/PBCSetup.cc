@@ -298,6 +298,7 @@ void RWGSurface::AddStraddlers(HMatrix *LBasis,
    Log("  %i straddlers normal to lattice vector #%i",NumStraddlers[nd],nd);
   Log("  %i total straddlers ",TotalStraddlers);
 
+  UpdatePackedMesh();
 }
 
 /***************************************************************/
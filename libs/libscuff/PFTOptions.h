@@ -96,6 +96,8 @@ namespace scuff {
 /***************************************************************/
 /***************************************************************/
 /***************************************************************/
+class SCUFFWorkspace;
+
 typedef struct PFTOptions 
  {
    // general options
@@ -105,6 +107,7 @@ typedef struct PFTOptions
    HMatrix *DRMatrix;
    IncField *IF;
    HVector *RHSVector;
+   SCUFFWorkspace *Workspace; // optional; see libscuff.h
 
    // options affecting DSI PFT computation
    char *DSIMesh;
@@ -139,7 +142,8 @@ PFTOptions *InitPFTOptions(PFTOptions *Options=0);
 class RWGGeometry;
 HMatrix *GetSRFluxTrace(RWGGeometry *G, HMatrix *XMatrix, cdouble Omega,
                    HMatrix *DRMatrix, HMatrix *FMatrix=0,
-                   HMatrix *RFMatrix=0, bool RFMatrixDirty=true);
+                   HMatrix *RFMatrix=0, bool RFMatrixDirty=true,
+                   SCUFFWorkspace *Workspace=0);
 
 void GetKNBilinears(HVector *KNVector, HMatrix *DRMatrix,
                     bool IsPECA, int KNIndexA,
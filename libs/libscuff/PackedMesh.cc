@@ -0,0 +1,247 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * PackedMesh.cc -- structure-of-arrays view of the panels and edges
+ *               -- of an RWGSurface, for use in inner loops
+ *
+ * The RWGPanel and RWGEdge structures are allocated individually and
+ * reached through arrays of pointers, and the coordinates of their
+ * vertices live in yet another array; the RWGPackedMesh gathers
+ * everything the assembly, field, and PFT kernels need into
+ * contiguous, cache-line-aligned arrays indexed by panel or edge
+ * index. Panel and edge indices themselves are unchanged (they
+ * define the ordering of basis functions); instead, the PanelOrder
+ * and EdgeOrder arrays list the indices in Morton order, for loops
+ * that may visit panels or edges in any order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+namespace scuff {
+
+#define PACKED_ALIGNMENT 64
+
+/***************************************************************/
+/* interleave the low 21 bits of i, j, k to form a key that    */
+/* orders points along a Morton (Z-order) space-filling curve  */
+/***************************************************************/
+static unsigned long long MortonKey(unsigned i, unsigned j, unsigned k)
+{
+  unsigned long long Key=0;
+  for(int b=0; b<21; b++)
+   Key |=   ((unsigned long long)((i>>b)&1)) << (3*b+0)
+          | ((unsigned long long)((j>>b)&1)) << (3*b+1)
+          | ((unsigned long long)((k>>b)&1)) << (3*b+2);
+  return Key;
+}
+
+typedef struct MortonPoint
+ { unsigned long long Key;
+   int n;
+ } MortonPoint;
+
+static int CompareMortonPoints(const void *p1, const void *p2)
+{
+  const MortonPoint *MP1=(const MortonPoint *)p1;
+  const MortonPoint *MP2=(const MortonPoint *)p2;
+  if (MP1->Key < MP2->Key) return -1;
+  if (MP1->Key > MP2->Key) return +1;
+  return MP1->n - MP2->n;
+}
+
+/***************************************************************/
+/* on return, Order[0..N-1] are the indices of the N points    */
+/* X + n*Stride (n=0..N-1) sorted along a Morton curve through */
+/* their bounding box.                                         */
+/***************************************************************/
+void GetMortonOrder(const double *X, int N, int *Order, int Stride)
+{
+  if (N<=0) return;
+
+  double XMin[3]={HUGE_VAL, HUGE_VAL, HUGE_VAL};
+  double XMax[3]={-HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+  for(int n=0; n<N; n++)
+   for(int i=0; i<3; i++)
+    { XMin[i]=fmin(XMin[i], X[n*Stride+i]);
+      XMax[i]=fmax(XMax[i], X[n*Stride+i]);
+    };
+
+  double Extent=fmax(XMax[0]-XMin[0], fmax(XMax[1]-XMin[1], XMax[2]-XMin[2]));
+  double Scale = Extent>0.0 ? 2097151.0/Extent : 0.0; // 2^21 - 1
+  MortonPoint *MPs=(MortonPoint *)mallocEC(N*sizeof(MortonPoint));
+  for(int n=0; n<N; n++)
+   { const double *XX=X+n*Stride;
+     MPs[n].Key = MortonKey( (unsigned)(Scale*(XX[0]-XMin[0])),
+                             (unsigned)(Scale*(XX[1]-XMin[1])),
+                             (unsigned)(Scale*(XX[2]-XMin[2])) );
+     MPs[n].n   = n;
+   };
+  qsort(MPs, N, sizeof(MortonPoint), CompareMortonPoints);
+  for(int n=0; n<N; n++)
+   Order[n]=MPs[n].n;
+  free(MPs);
+}
+
+/***************************************************************/
+/* carve an array of Size bytes out of a block, keeping every  */
+/* array aligned to a cache-line boundary                      */
+/***************************************************************/
+static size_t PadToAlignment(size_t Size)
+{ return (Size + PACKED_ALIGNMENT - 1) & ~((size_t)PACKED_ALIGNMENT - 1); }
+
+static void *CarveArray(char **Cursor, size_t Size)
+{ void *p = (void *)(*Cursor);
+  *Cursor += PadToAlignment(Size);
+  return p;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+static RWGPackedMesh *AllocatePackedMesh(int NP, int NE)
+{
+  size_t DSize=sizeof(double), ISize=sizeof(int);
+  size_t BlockSize
+   = PadToAlignment(9*NP*DSize)    // PV
+   + PadToAlignment(3*NP*DSize)    // PCentroid
+   + PadToAlignment(3*NP*DSize)    // PZHat
+   + PadToAlignment(  NP*DSize)    // PRadius
+   + PadToAlignment(  NP*DSize)    // PArea
+   + PadToAlignment( 18*NE*DSize)  // EQAB
+   + PadToAlignment(  2*NE*DSize)  // EArea
+   + PadToAlignment(  3*NE*DSize)  // ECentroid
+   + PadToAlignment(    NE*DSize)  // ERadius
+   + PadToAlignment(    NE*DSize)  // ELength
+   + PadToAlignment(  2*NE*ISize)  // EPanels
+   + PadToAlignment(  2*NE*ISize)  // EQIndex
+   + PadToAlignment(    NP*ISize)  // PanelOrder
+   + PadToAlignment(    NE*ISize); // EdgeOrder
+
+  void *Block=0;
+  if (posix_memalign(&Block, PACKED_ALIGNMENT, BlockSize ? BlockSize : PACKED_ALIGNMENT))
+   ErrExit("%s:%i: out of memory (%lu bytes)",__FILE__,__LINE__,(unsigned long)BlockSize);
+  memset(Block, 0, BlockSize);
+
+  RWGPackedMesh *PM=(RWGPackedMesh *)mallocEC(sizeof(RWGPackedMesh));
+  PM->NumPanels  = NP;
+  PM->NumEdges   = NE;
+  PM->Block      = Block;
+
+  char *Cursor=(char *)Block;
+  PM->PV         = (double *)CarveArray(&Cursor, 9*NP*DSize);
+  PM->PCentroid  = (double *)CarveArray(&Cursor, 3*NP*DSize);
+  PM->PZHat      = (double *)CarveArray(&Cursor, 3*NP*DSize);
+  PM->PRadius    = (double *)CarveArray(&Cursor,   NP*DSize);
+  PM->PArea      = (double *)CarveArray(&Cursor,   NP*DSize);
+  PM->EQAB       = (double *)CarveArray(&Cursor, 18*NE*DSize);
+  PM->EArea      = (double *)CarveArray(&Cursor,  2*NE*DSize);
+  PM->ECentroid  = (double *)CarveArray(&Cursor,  3*NE*DSize);
+  PM->ERadius    = (double *)CarveArray(&Cursor,    NE*DSize);
+  PM->ELength    = (double *)CarveArray(&Cursor,    NE*DSize);
+  PM->EPanels    = (int    *)CarveArray(&Cursor,  2*NE*ISize);
+  PM->EQIndex    = (int    *)CarveArray(&Cursor,  2*NE*ISize);
+  PM->PanelOrder = (int    *)CarveArray(&Cursor,    NP*ISize);
+  PM->EdgeOrder  = (int    *)CarveArray(&Cursor,    NE*ISize);
+
+  return PM;
+}
+
+void DestroyPackedMesh(RWGPackedMesh *PM)
+{
+  if (!PM) return;
+  free(PM->Block);
+  free(PM);
+}
+
+/***************************************************************/
+/* (re)build the packed view of the panels and (full or        */
+/* promoted half-) RWG edges in the Panels and Edges arrays.   */
+/* this must be called whenever the mesh connectivity changes  */
+/* (the arrays are reallocated and the Morton ordering is      */
+/* recomputed) or the surface is moved (the arrays are simply  */
+/* refilled in place).                                         */
+/***************************************************************/
+void RWGSurface::UpdatePackedMesh()
+{
+  bool Resized = (Packed==0 || Packed->NumPanels!=NumPanels || Packed->NumEdges!=NumEdges);
+  if (Resized)
+   { DestroyPackedMesh(Packed);
+     Packed=AllocatePackedMesh(NumPanels, NumEdges);
+   };
+  RWGPackedMesh *PM=Packed;
+
+  /*--------------------------------------------------------------*/
+  /*- panels -----------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  for(int np=0; np<NumPanels; np++)
+   { RWGPanel *P=Panels[np];
+     for(int i=0; i<3; i++)
+      memcpy(PM->PV + 9*np + 3*i, Vertices + 3*P->VI[i], 3*sizeof(double));
+     memcpy(PM->PCentroid + 3*np, P->Centroid, 3*sizeof(double));
+     memcpy(PM->PZHat + 3*np, P->ZHat, 3*sizeof(double));
+     PM->PRadius[np] = P->Radius;
+     PM->PArea[np]   = P->Area;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- edges: for each of the (one or two) panels of the basis    -*/
+  /*- function, store the source/sink vertex Q and the two edge  -*/
+  /*- vectors A=V1-Q, B=V2-Q used to parameterize the panel      -*/
+  /*--------------------------------------------------------------*/
+  for(int ne=0; ne<NumEdges; ne++)
+   { RWGEdge *E=Edges[ne];
+     double *QAB=PM->EQAB + 18*ne;
+     double *V1=Vertices + 3*E->iV1, *V2=Vertices + 3*E->iV2;
+     for(int PM2=0; PM2<2; PM2++)
+      { int iQ = (PM2==0) ? E->iQP : E->iQM;
+        if (iQ==-1) continue;
+        double *Q=Vertices + 3*iQ;
+        memcpy(QAB + 9*PM2 + 0, Q, 3*sizeof(double));
+        VecSub(V1, Q, QAB + 9*PM2 + 3);
+        VecSub(V2, Q, QAB + 9*PM2 + 6);
+      };
+     PM->EArea[2*ne+0]   = Panels[E->iPPanel]->Area;
+     PM->EArea[2*ne+1]   = (E->iMPanel==-1) ? 0.0 : Panels[E->iMPanel]->Area;
+     memcpy(PM->ECentroid + 3*ne, E->Centroid, 3*sizeof(double));
+     PM->ERadius[ne]     = E->Radius;
+     PM->ELength[ne]     = E->Length;
+     PM->EPanels[2*ne+0] = E->iPPanel;
+     PM->EPanels[2*ne+1] = E->iMPanel;
+     PM->EQIndex[2*ne+0] = E->PIndex;
+     PM->EQIndex[2*ne+1] = E->MIndex;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- the Morton ordering is only recomputed when the mesh       -*/
+  /*- changes; rigid motions preserve the locality it captures   -*/
+  /*--------------------------------------------------------------*/
+  if (Resized)
+   { GetMortonOrder(PM->PCentroid, NumPanels, PM->PanelOrder);
+     GetMortonOrder(PM->ECentroid, NumEdges, PM->EdgeOrder);
+   };
+}
+
+} // namespace scuff
@@ -704,28 +704,35 @@ void PPCFunction_BFBFC2(double *x, double *xp, PPCData *PPCD,
 }
 
 /***************************************************************/
-/* 20151118 streamlined implementation of GetBFCubature and    */
-/* GetBFBFCubature that are 2x and 4x faster respectively.     */
-/*                                                             */
-/* In these versions, the user's integrand function must       */
-/* *accumulate* contributions to Integral with weight Weight.  */
+/* fetch the data needed to parameterize the one or two panels */
+/* of the basis function for edge #ne: on return, the points   */
+/* of panel PM are Q[PM] + u*A[PM] + v*B[PM], and the return   */
+/* value is the number of panels. full RWG edges are read from */
+/* the packed mesh arrays, in which Q, A, B are precomputed.   */
 /***************************************************************/
-void GetBFCubature2(RWGGeometry *G, int ns, int ne,
-                    PCFunction2 Integrand, void *UserData, int IDim,
-                    int Order, double *Integral, int PanelOnly)
+static int GetEdgeFrame(RWGSurface *S, int ne, double *Length,
+                        double *Q[2], double *A[2], double *B[2],
+                        double Area[2], double Buffer[12])
 {
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  RWGSurface *S = G->Surfaces[ns];
+  RWGPackedMesh *PM=S->Packed;
+  if ( 0<=ne && ne<PM->NumEdges )
+   { double *QAB = PM->EQAB + 18*ne;
+     *Length = PM->ELength[ne];
+     Q[0]    = QAB + 0;  A[0] = QAB + 3;  B[0] = QAB + 6;
+     Q[1]    = QAB + 9;  A[1] = QAB + 12; B[1] = QAB + 15;
+     Area[0] = PM->EArea[2*ne+0];
+     Area[1] = PM->EArea[2*ne+1];
+     return PM->EPanels[2*ne+1]==-1 ? 1 : 2;
+   };
+
   RWGEdge *E    = S->GetEdgeByIndex(ne);
-  double Length = E->Length;
+  *Length       = E->Length;
   double *QP    = S->Vertices + 3*(E->iQP);
   double *V1    = S->Vertices + 3*(E->iV1);
   double *V2    = S->Vertices + 3*(E->iV2);
   double *QM    = (E->iQM==-1) ? 0 : S->Vertices + 3*(E->iQM);
 
-  double A[2][3], B[2][3], Area[2], *Q[2];
+  A[0]=Buffer+0; B[0]=Buffer+3; A[1]=Buffer+6; B[1]=Buffer+9;
   VecSub(V1, QP, A[0]);
   VecSub(V2, QP, B[0]);
   Q[0]=QP;
@@ -737,7 +744,26 @@ void GetBFCubature2(RWGGeometry *G, int ns, int ne,
      Area[1] = S->Panels[E->iMPanel]->Area;
    };
 
-  int NumPM=QM ? 2 : 1;
+  return QM ? 2 : 1;
+}
+
+/***************************************************************/
+/* 20151118 streamlined implementation of GetBFCubature and    */
+/* GetBFBFCubature that are 2x and 4x faster respectively.     */
+/*                                                             */
+/* In these versions, the user's integrand function must       */
+/* *accumulate* contributions to Integral with weight Weight.  */
+/***************************************************************/
+void GetBFCubature2(RWGGeometry *G, int ns, int ne,
+                    PCFunction2 Integrand, void *UserData, int IDim,
+                    int Order, double *Integral, int PanelOnly)
+{
+  /*--------------------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  RWGSurface *S = G->Surfaces[ns];
+  double Length, *Q[2], *A[2], *B[2], Area[2], Buffer[12];
+  int NumPM=GetEdgeFrame(S, ne, &Length, Q, A, B, Area, Buffer);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -803,50 +829,11 @@ void GetBFBFCubature2(RWGSurface *S, int ne,
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
-  RWGEdge *E    = S->GetEdgeByIndex(ne);
-  double Length = E->Length;
-  double *QP    = S->Vertices + 3*(E->iQP);
-  double *V1    = S->Vertices + 3*(E->iV1);
-  double *V2    = S->Vertices + 3*(E->iV2);
-  double *QM    = (E->iQM==-1) ? 0 : S->Vertices + 3*(E->iQM);
-
-  double A[2][3], B[2][3], Area[2], *Q[2];
-  VecSub(V1, QP, A[0]);
-  VecSub(V2, QP, B[0]);
-  Q[0]=QP;
-  Area[0] = S->Panels[E->iPPanel]->Area;
-  if (QM)
-   { VecSub(V1, QM, A[1]);
-     VecSub(V2, QM, B[1]);
-     Q[1]=QM;
-     Area[1] = S->Panels[E->iMPanel]->Area;
-   };
-
-  int NumPM=QM ? 2 : 1;
-
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  RWGEdge *EP    = SP->GetEdgeByIndex(neP);
-  double LengthP = EP->Length;
-  double *QPP    = SP->Vertices + 3*(EP->iQP);
-  double *V1P    = SP->Vertices + 3*(EP->iV1);
-  double *V2P    = SP->Vertices + 3*(EP->iV2);
-  double *QMP    = (EP->iQM==-1) ? 0 : SP->Vertices + 3*(EP->iQM);
-
-  double AP[2][3], BP[2][3], AreaP[2], *QPArray[2];
-  VecSub(V1P, QPP, AP[0]);
-  VecSub(V2P, QPP, BP[0]);
-  QPArray[0]=QPP;
-  AreaP[0] = SP->Panels[EP->iPPanel]->Area;
-  if (QMP)
-   { VecSub(V1P, QMP, AP[1]);
-     VecSub(V2P, QMP, BP[1]);
-     QPArray[1]=QMP;
-     AreaP[1] = SP->Panels[EP->iMPanel]->Area;
-   };
+  double Length, *Q[2], *A[2], *B[2], Area[2], Buffer[12];
+  int NumPM=GetEdgeFrame(S, ne, &Length, Q, A, B, Area, Buffer);
 
-  int NumPMP=QMP ? 2 : 1;
+  double LengthP, *QPArray[2], *AP[2], *BP[2], AreaP[2], BufferP[12];
+  int NumPMP=GetEdgeFrame(SP, neP, &LengthP, QPArray, AP, BP, AreaP, BufferP);
 
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
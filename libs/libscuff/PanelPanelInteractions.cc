@@ -209,7 +209,7 @@ if ( MyRD > 1.0e-2 )
 /*--------------------------------------------------------------*/
 /*--------------------------------------------------------------*/
 void GetPPIs_Cubature(GetPPIArgStruct *Args,
-                      int DeSingularize, int HighOrder,
+                      int DeSingularize, int Order,
                       double **Va, double *Qa,
                       double **Vb, double *Qb)
 { 
@@ -260,7 +260,7 @@ void GetPPIs_Cubature(GetPPIArgStruct *Args,
   cdouble *dHdTInner  = dHdT  ? dHdTInnerBuffer  : 0;
 
   /***************************************************************/
-  /* choose order of quadrature scheme to use.                   */
+  /* get the quadrature scheme of the requested order.           */
   /* TCR ('triangle cubature rule') points to a vector of 3N     */
   /* doubles (for an N-point cubature rule).                     */
   /* TCR[3*n,3*n+1,3*n+2]=(u,v,w), where (u,v)                   */
@@ -269,12 +269,8 @@ void GetPPIs_Cubature(GetPPIArgStruct *Args,
   /* note we use the same quadrature rule for both the source    */
   /* and destination triangles.                                  */
   /***************************************************************/
-  double *TCR;
   int NumPts;
-  if (HighOrder)
-   TCR=GetTCR(20, &NumPts);
-  else
-   TCR=GetTCR(4, &NumPts);
+  double *TCR=GetTCR(Order, &NumPts);
 
   /***************************************************************/
   /* outer loop **************************************************/
@@ -377,10 +373,11 @@ void GetPanelPanelInteractions(GetPPIArgStruct *Args)
   /* extract panel vertices, detect common vertices, measure     */
   /* relative distance                                           */
   /***************************************************************/
-  RWGPanel *Pa = Sa->Panels[npa];
-  RWGPanel *Pb = Sb->Panels[npb];
-  double *Qa   = Sa->Vertices + 3*Pa->VI[iQa];
-  double *Qb   = Sb->Vertices + 3*Pb->VI[iQb];
+  RWGPackedMesh *PMa = Sa->Packed;
+  RWGPackedMesh *PMb = Sb->Packed;
+  double *Qa   = PMa->PV + 9*npa + 3*iQa;
+  double *Qb   = PMb->PV + 9*npb + 3*iQb;
+  double RMax  = fmax(PMa->PRadius[npa], PMb->PRadius[npb]);
   double *Va[3], *Vb[3];
   double VbDisplaced[3][3];
   double rRel; 
@@ -390,43 +387,54 @@ void GetPanelPanelInteractions(GetPPIArgStruct *Args)
    ncv=AssessPanelPair(Sa,npa,Sb,npb,&rRel,Va,Vb);
   else 
    { 
-     Va[0] = Sa->Vertices + 3*Pa->VI[0];
-     Va[1] = Sa->Vertices + 3*Pa->VI[1];
-     Va[2] = Sa->Vertices + 3*Pa->VI[2];
+     Va[0] = PMa->PV + 9*npa + 0;
+     Va[1] = PMa->PV + 9*npa + 3;
+     Va[2] = PMa->PV + 9*npa + 6;
 
-     VecScaleAdd(Sb->Vertices + 3*Pb->VI[0], 1.0, Displacement, VbDisplaced[0]);
-     VecScaleAdd(Sb->Vertices + 3*Pb->VI[1], 1.0, Displacement, VbDisplaced[1]);
-     VecScaleAdd(Sb->Vertices + 3*Pb->VI[2], 1.0, Displacement, VbDisplaced[2]);
+     VecScaleAdd(PMb->PV + 9*npb + 0, 1.0, Displacement, VbDisplaced[0]);
+     VecScaleAdd(PMb->PV + 9*npb + 3, 1.0, Displacement, VbDisplaced[1]);
+     VecScaleAdd(PMb->PV + 9*npb + 6, 1.0, Displacement, VbDisplaced[2]);
      Vb[0] = VbDisplaced[0];
      Vb[1] = VbDisplaced[1];
      Vb[2] = VbDisplaced[2];
      Qb    = VbDisplaced[iQb];
 
      double DC[3]; // 'delta centroid' 
-     DC[0] = Pa->Centroid[0] - Pb->Centroid[0] - Displacement[0];
-     DC[1] = Pa->Centroid[1] - Pb->Centroid[1] - Displacement[1];
-     DC[2] = Pa->Centroid[2] - Pb->Centroid[2] - Displacement[2];
+     double *CA = PMa->PCentroid + 3*npa, *CB = PMb->PCentroid + 3*npb;
+     DC[0] = CA[0] - CB[0] - Displacement[0];
+     DC[1] = CA[1] - CB[1] - Displacement[1];
+     DC[2] = CA[2] - CB[2] - Displacement[2];
 
-     double rMax = fmax(Pa->Radius, Pb->Radius);
-     rRel = VecNorm(DC) / rMax; 
+     rRel = VecNorm(DC) / RMax; 
 
-     ncv=AssessPanelPair(Va, Vb, rMax);
+     ncv=AssessPanelPair(Va, Vb, RMax);
    };
 
+  /***************************************************************/
+  /* if the user set an integration tolerance, the orders of the */
+  /* cubature rules used below for non-touching panels are       */
+  /* chosen to meet it; otherwise we use fixed orders            */
+  /***************************************************************/
+  double kR=abs(k*RMax);
+  double Tolerance=RWGGeometry::IntegrationTolerance;
+  int AdaptiveOrder = (Tolerance>0.0) ? SelectPPICubatureOrder(rRel, kR, Tolerance) : 0;
+
   /***************************************************************/
   /* if the panels are far apart, or if we have an interpolator, */
   /* then just use simple low-order non-desingularized cubature  */
+  /* (in the periodic case rRel does not measure the smoothness  */
+  /* of the kernel, so we stick with the fixed order there)      */
   /***************************************************************/
   if ( Args->GBA || (rRel > DESINGULARIZATION_RADIUS) )
    { Args->WhichAlgorithm=PPIALG_LOCUBATURE;
-     GetPPIs_Cubature(Args, 0, 0, Va, Qa, Vb, Qb);
+     Args->Order = (AdaptiveOrder && !Args->GBA) ? AdaptiveOrder : 4;
+     GetPPIs_Cubature(Args, 0, Args->Order, Va, Qa, Vb, Qb);
      return;
    };
 
   /***************************************************************/
   /* determine if we are in the short-wavelength regime          */
   /***************************************************************/
-  double kR=abs(k*fmax(Pa->Radius, Pb->Radius));
   int InSWRegime = kR > SWTHRESHOLD;
   int InVerySWRegime = kR > VERYSWTHRESHOLD;
 
@@ -436,7 +444,8 @@ void GetPanelPanelInteractions(GetPPIArgStruct *Args)
   /***************************************************************/
   if ( InSWRegime && ncv==0 )
    { Args->WhichAlgorithm=PPIALG_HOCUBATURE;
-     GetPPIs_Cubature(Args, 0, 1, Va, Qa, Vb, Qb);
+     Args->Order = AdaptiveOrder ? AdaptiveOrder : 20;
+     GetPPIs_Cubature(Args, 0, Args->Order, Va, Qa, Vb, Qb);
      return; 
    };
 
@@ -479,6 +488,7 @@ void GetPanelPanelInteractions(GetPPIArgStruct *Args)
       }
      else
       Args->WhichAlgorithm=PPIALG_TD;
+     Args->Order=0;
 
      TaylorDuffy(TDArgs);
 
@@ -503,8 +513,9 @@ void GetPanelPanelInteractions(GetPPIArgStruct *Args)
   /*****************************************************************/
   cdouble GradHSave[6], dHdTSave[6];
   Args->WhichAlgorithm=PPIALG_DESING;
+  Args->Order=4;
   if ( NumGradientComponents>0 || NumTorqueAxes>0 )
-   { GetPPIs_Cubature(Args, 0, 1, Va, Qa, Vb, Qb);
+   { GetPPIs_Cubature(Args, 0, 20, Va, Qa, Vb, Qb);
      memcpy(GradHSave, Args->GradH, 2*NumGradientComponents*sizeof(cdouble));
      memcpy(dHdTSave, Args->dHdT, 2*NumTorqueAxes*sizeof(cdouble));
    };
@@ -521,7 +532,7 @@ void GetPanelPanelInteractions(GetPPIArgStruct *Args)
   /*                                                               */
   /*****************************************************************/
   // step 1
-  GetPPIs_Cubature(Args, 1, 0, Va, Qa, Vb, Qb);
+  GetPPIs_Cubature(Args, 1, 4, Va, Qa, Vb, Qb);
 
   // step 2
   QDFIPPIData MyQDFD, *QDFD=&MyQDFD;
@@ -67,8 +67,14 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "libscuff.h"
+#include "libscuffInternals.h"
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
 
 namespace scuff {
 
@@ -207,6 +213,7 @@ static void partition(void *base_, size_t nmemb, size_t size, size_t which,
 typedef struct {
   float bmin[2], bmax[2]; /* corners of bounding box */
   float x[3], y[3], z[3]; /* corners of triangle, sorted by y[i] */
+  int ns; /* index of surface (only used in geometry-wide trees) */
 } boxtri;
 
 struct kdtri_s {
@@ -482,8 +489,100 @@ static int kdtri_surface_piercings(kdtri t, const double p[3])
   return kdtri_count_below(t, p);
 }
 
+/* like kdtri_count_below, but accumulate the counts separately for
+   each surface of a geometry-wide tree: Counts[ns] is incremented for
+   each panel of surface #ns lying below p. */
+static void kdtri_count_below_by_surface(kdtri t, const double p[3],
+                                         int *Counts)
+{
+  if (!t) return;
+  if (t->le) { /* search subtrees */
+    if (p[t->dim] <= t->div)
+      kdtri_count_below_by_surface(t->le, p, Counts);
+    else
+      kdtri_count_below_by_surface(t->gt, p, Counts);
+  }
+  else { /* we are at a leaf node: search directly */
+    size_t i, n = t->n;
+    boxtri *B = t->B;
+    for (i = 0; i < n; ++i)
+      if (boxtri_contains(B+i, p)
+	  && point_above_tri(p[0],p[1],p[2], B[i].x,B[i].y,B[i].z))
+	++Counts[B[i].ns];
+  }
+}
+
+/* distance from p to the box [bmin, bmax] (zero if p is inside) */
+static double box_distance(const double p[3],
+                           const float bmin[3], const float bmax[3])
+{
+  double d2 = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    double d = (p[i] < bmin[i] ? bmin[i] - p[i]
+                : (p[i] > bmax[i] ? p[i] - bmax[i] : 0.0));
+    d2 += d*d;
+  }
+  return sqrt(d2);
+}
+
+/* return min(dmax, distance from p to the nearest triangle bounding
+   box in t). this is a lower bound on the distance from p to the
+   surface, so every point closer than this to p lies in the same
+   region as p. */
+static double kdtri_box_distance(kdtri t, const double p[3], double dmax)
+{
+  if (!t || box_distance(p, t->bmin, t->bmax) >= dmax) return dmax;
+  if (t->le) { /* search nearer subtree first */
+    kdtri first = (p[t->dim] <= t->div) ? t->le : t->gt;
+    kdtri second = (first == t->le) ? t->gt : t->le;
+    dmax = kdtri_box_distance(first, p, dmax);
+    return kdtri_box_distance(second, p, dmax);
+  }
+  else {
+    size_t i, n = t->n;
+    boxtri *B = t->B;
+    for (i = 0; i < n; ++i) {
+      float bmin[3], bmax[3];
+      bmin[0] = B[i].bmin[0]; bmax[0] = B[i].bmax[0];
+      bmin[1] = B[i].bmin[1]; bmax[1] = B[i].bmax[1];
+      bmin[2] = MIN3(B[i].z[0], B[i].z[1], B[i].z[2]);
+      bmax[2] = MAX3(B[i].z[0], B[i].z[1], B[i].z[2]);
+      double d = box_distance(p, bmin, bmax);
+      if (d < dmax) dmax = d;
+    }
+    return dmax;
+  }
+}
+
 /***********************************************************************/
 
+/* initialize the boxtri for panel P of a surface with vertices V. */
+static void boxtri_init(boxtri *b, const double *V, const RWGPanel *P, int ns)
+{
+  int j;
+  for (j = 0; j < 3; ++j) {
+    int k, vj = P->VI[j];
+    b->x[j] = V[3*vj];
+    b->y[j] = V[3*vj+1];
+    b->z[j] = V[3*vj+2];
+    for (k = 0; k < j; ++k) /* sort in y order */
+      if (b->y[k] > b->y[j]) {
+	float x = b->x[k], y = b->y[k], z = b->z[k];
+	b->x[k] = b->x[j];
+	b->y[k] = b->y[j];
+	b->z[k] = b->z[j];
+	b->x[j] = x; b->y[j] = y; b->z[j] = z;
+      }
+  }
+
+  /* compute bounding box */
+  b->bmin[0] = MIN3(b->x[0], b->x[1], b->x[2]);
+  b->bmin[1] = MIN3(b->y[0], b->y[1], b->y[2]);
+  b->bmax[0] = MAX3(b->x[0], b->x[1], b->x[2]);
+  b->bmax[1] = MAX3(b->y[0], b->y[1], b->y[2]);
+  b->ns = ns;
+}
+
 /* Create a (tree-partitioned) kdtri object for the panels of S, using
    O(NumPanels) storage and O(NumPanels*log(NumPanels)) time.   Returns
    NULL if we ran out of memory. */
@@ -496,31 +595,42 @@ static kdtri kdtri_create_from_surface(const RWGSurface *S)
   if (!S || !S->NumPanels) goto done;
   if (!(B = (boxtri *) malloc(sizeof(boxtri) * S->NumPanels))) goto done;
 
-  for (i = 0; i < S->NumPanels; ++i) {
-    int j;
-    for (j = 0; j < 3; ++j) {
-      int k, vj = S->Panels[i]->VI[j];
-      B[i].x[j] = S->Vertices[3*vj];
-      B[i].y[j] = S->Vertices[3*vj+1];
-      B[i].z[j] = S->Vertices[3*vj+2];
-      for (k = 0; k < j; ++k) /* sort in y order */
-	if (B[i].y[k] > B[i].y[j]) {
-	  float x = B[i].x[k], y = B[i].y[k], z = B[i].z[k];
-	  B[i].x[k] = B[i].x[j];
-	  B[i].y[k] = B[i].y[j];
-	  B[i].z[k] = B[i].z[j];
-	  B[i].x[j] = x; B[i].y[j] = y; B[i].z[j] = z;
-	}
-    }
+  for (i = 0; i < S->NumPanels; ++i)
+    boxtri_init(B+i, S->Vertices, S->Panels[i], 0);
 
-    /* compute bounding box */
-    B[i].bmin[0] = MIN3(B[i].x[0], B[i].x[1], B[i].x[2]);
-    B[i].bmin[1] = MIN3(B[i].y[0], B[i].y[1], B[i].y[2]);
-    B[i].bmax[0] = MAX3(B[i].x[0], B[i].x[1], B[i].x[2]);
-    B[i].bmax[1] = MAX3(B[i].y[0], B[i].y[1], B[i].y[2]);
+  if (!(t = kdtri_create(B, (size_t) S->NumPanels))) {
+    free(B);
+    goto done;
   }
 
-  if (!(t = kdtri_create(B, (size_t) S->NumPanels))) {
+  if (kdtri_partition(t) != EXIT_SUCCESS) {
+    kdtri_destroy(t); t = NULL;
+    goto done;
+  }
+
+ done:
+  return t;
+}
+
+/* Create a single kdtri object for the panels of all surfaces in G, in
+   their current (transformed) positions, with each boxtri tagged by the
+   index of its surface. Returns NULL if we ran out of memory. */
+static kdtri kdtri_create_from_geometry(const RWGGeometry *G)
+{
+  int ns, np, nbt;
+  boxtri *B;
+  kdtri t = NULL;
+
+  if (!G || !G->TotalPanels) goto done;
+  if (!(B = (boxtri *) malloc(sizeof(boxtri) * G->TotalPanels))) goto done;
+
+  for (ns = nbt = 0; ns < G->NumSurfaces; ++ns) {
+    RWGSurface *S = G->Surfaces[ns];
+    for (np = 0; np < S->NumPanels; ++np)
+      boxtri_init(B + (nbt++), S->Vertices, S->Panels[np], ns);
+  }
+
+  if (!(t = kdtri_create(B, (size_t) nbt))) {
     free(B);
     goto done;
   }
@@ -656,39 +766,232 @@ int RWGGeometry::PointInRegion(int RegionIndex, const double X[3])
 } 
 
 /***************************************************************/
+/* (re)build the geometry-wide panel tree used by             */
+/* GetRegionIndex() if it does not yet exist, or if any        */
+/* surface has been transformed since it was built. this may   */
+/* be called from several threads at once, provided no surface */
+/* is transformed in the meantime.                             */
+/*                                                             */
+/* the unlocked fast path relies on the builder storing the    */
+/* tree pointer and then the stamp with release semantics, and */
+/* on readers loading them in the opposite order with acquire  */
+/* semantics: a reader that sees the current stamp also sees   */
+/* the tree built for it, and a reader that sees a nonzero     */
+/* pointer sees the fully-built tree.                          */
+/***************************************************************/
+void RWGGeometry::InitkdAllPanels()
+{
+  unsigned Stamp=0;
+  for(int ns=0; ns<NumSurfaces; ns++)
+   Stamp+=Surfaces[ns]->TransformStamp;
+  if (    __atomic_load_n(&kdAllPanelsStamp, __ATOMIC_ACQUIRE)==Stamp
+       && __atomic_load_n(&kdAllPanels, __ATOMIC_ACQUIRE)!=0
+     )
+   return;
+
+#ifdef USE_OPENMP
+#pragma omp critical(kdAllPanels)
+#endif
+  if (kdAllPanels==0 || kdAllPanelsStamp!=Stamp)
+   { if (kdAllPanels) 
+      kdtri_destroy(kdAllPanels);
+     kdtri t=kdtri_create_from_geometry(this);
+     if (!t) 
+      ErrExit("out of memory when creating geometry-wide panel kd-tree");
+     if (LogLevel >= SCUFF_VERBOSELOGGING)
+      Log("kdAllPanels: %i panels, depth mean %g/max %u, leaf mean %g/max %lu",
+           TotalPanels, kdtri_meandepth(t), kdtri_maxdepth(t),
+           kdtri_meanleaf(t), (unsigned long) kdtri_maxleaf(t));
+     __atomic_store_n(&kdAllPanels, t, __ATOMIC_RELEASE);
+     __atomic_store_n(&kdAllPanelsStamp, Stamp, __ATOMIC_RELEASE);
+   };
+}
+
+/***************************************************************/
+/* true if X lies within the bounding box of surface S (as in  */
+/* RWGSurface::Contains()). this matters for surfaces that are */
+/* 'closed' only by virtue of periodicity, such as an infinite */
+/* plate, which a plumb line from any point above it pierces  */
+/* exactly once.                                               */
+/***************************************************************/
+static bool InBoundingBox(RWGSurface *S, const double X0[3])
+{
+  double X[3];
+  X[0]=X0[0]; X[1]=X0[1]; X[2]=X0[2];
+  if (S->GT) S->GT->UnApply(X);
+  kdtri t=S->kdPanels;
+  return    X[0]>=t->bmin[0] && X[0]<=t->bmax[0]
+         && X[1]>=t->bmin[1] && X[1]<=t->bmax[1]
+         && X[2]>=t->bmin[2] && X[2]<=t->bmax[2];
+}
+
+/***************************************************************/
+/* given the number of panels on each surface pierced by a     */
+/* plumb line dropped from X to z=minus infinity, return the   */
+/* index of the region containing X.                           */
+/***************************************************************/
+static int GetRegionIndexFromPiercings(RWGGeometry *G, const int *Piercings,
+                                       const double X[3])
+{
+  /*--------------------------------------------------------------*/
+  /*- if all surfaces are closed, find the innermost surface      */
+  /*- containing X; if there is none, X is in the exterior medium */
+  /*--------------------------------------------------------------*/
+  if (G->AllSurfacesClosed)
+   { for (int ns=G->NumSurfaces-1; ns>=0; ns--) // innermost to outermost order
+      if ( (Piercings[ns]%2) && InBoundingBox(G->Surfaces[ns], X) )
+       return G->Surfaces[ns]->RegionIndices[1];
+     return 0;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- otherwise, for each region, count the total piercings of    */
+  /*- all non-PEC surfaces bounding that region (as in            */
+  /*- PointInRegion())                                            */
+  /*--------------------------------------------------------------*/
+  for(int nr=0; nr<G->NumRegions; nr++)
+   { int TotalPiercings=0;
+     for(int ns=0; ns<G->NumSurfaces; ns++)
+      { RWGSurface *S=G->Surfaces[ns];
+        if (S->IsPEC) continue;
+        if ( S->RegionIndices[0]==nr || S->RegionIndices[1]==nr )
+         TotalPiercings+=Piercings[ns];
+      };
+     if ( nr==0 ? (TotalPiercings%2==0) : (TotalPiercings%2==1) )
+      return nr;
+   };
+
+  return 0;
+}
+
+/***************************************************************/
+/* region index of a point that has already been mapped into   */
+/* the unit cell (for periodic geometries)                     */
+/***************************************************************/
+#define MAXSTACKSURFACES 64
+static int GetRegionIndexOfRepresentative(RWGGeometry *G, const double XX[3])
+{
+  // a point outside the bounding box of the geometry-wide tree (or
+  // below it) pierces no surfaces and hence lies in the exterior medium
+  kdtri t=G->kdAllPanels;
+  if (    XX[0] < t->bmin[0] || XX[0] > t->bmax[0]
+       || XX[1] < t->bmin[1] || XX[1] > t->bmax[1]
+       || XX[2] < t->bmin[2] 
+     )
+   return 0;
+
+  int NS=G->NumSurfaces;
+  int PiercingBuffer[MAXSTACKSURFACES];
+  int *Piercings = (NS<=MAXSTACKSURFACES) ? PiercingBuffer : new int[NS];
+  memset(Piercings, 0, NS*sizeof(int));
+  kdtri_count_below_by_surface(t, XX, Piercings);
+  int nr=GetRegionIndexFromPiercings(G, Piercings, XX);
+  if (Piercings!=PiercingBuffer)
+   delete[] Piercings;
+  return nr;
+}
+
 /***************************************************************/
+/* 20181018 this now uses a single kd-tree over the panels of  */
+/* all surfaces, in their current positions, so that one tree  */
+/* traversal suffices regardless of the number of surfaces.    */
+/* the plumb line is dropped along the -z axis of the lab frame*/
+/* for all surfaces (previously it was the -z axis of each     */
+/* surface's untransformed frame); this makes no difference    */
+/* for closed surfaces.                                        */
 /***************************************************************/
 int RWGGeometry::GetRegionIndex(const double X[3]) 
 {
-  /***************************************************************/
-  /***************************************************************/
-  /***************************************************************/
   double XX[3];
   if (LBasis)
    GetUnitCellRepresentative(X,XX);
   else 
    { XX[0]=X[0]; XX[1]=X[1]; XX[2]=X[2]; }
 
-  /***************************************************************/
-  /***************************************************************/
-  /***************************************************************/
-  if (AllSurfacesClosed)
-   { // find the innermost object containing X
-     for (int i = NumSurfaces - 1; i >= 0; --i) // innermost to outermost order
-      if (Surfaces[i]->Contains(XX))
-       return Surfaces[i]->RegionIndices[1];
-     return 0; // if not in any object, then in exterior medium 
-   };
+  InitkdAllPanels();
+  return GetRegionIndexOfRepresentative(this, XX);
+}
 
-  /***************************************************************/
-  /***************************************************************/
-  /***************************************************************/
-  for (int nr=0; nr<NumRegions; nr++)
-   if (PointInRegion(nr, XX))
-    return nr;
+/***************************************************************/
+/* batched version of GetRegionIndex for the points stored in  */
+/* columns ColumnOffset..ColumnOffset+2 of the rows of XMatrix.*/
+/* on return, Regions[nx] is the index of the region containing*/
+/* point #nx. (if Regions is NULL on entry, it is allocated.)  */
+/*                                                             */
+/* the points are sorted along a space-filling curve and       */
+/* classified in that order. each time a point is classified by*/
+/* an explicit ray test, we also compute the radius of a ball  */
+/* about it that contains no panels; subsequent points falling */
+/* inside that ball must lie in the same region, so they are   */
+/* classified without any ray test. for field-visualization    */
+/* grids most points are classified this way.                  */
+/***************************************************************/
+int *RWGGeometry::GetRegionIndices(HMatrix *XMatrix, int *Regions, int ColumnOffset)
+{
+  int NX=XMatrix->NR;
+  if (Regions==0)
+   Regions=(int *)mallocEC(NX*sizeof(int));
+  if (NX==0)
+   return Regions;
+
+  InitkdAllPanels();
+
+  /*--------------------------------------------------------------*/
+  /*- map all points into the unit cell if necessary and sort    -*/
+  /*- them along a Morton curve                                  -*/
+  /*--------------------------------------------------------------*/
+  double *XX=(double *)mallocEC(3*NX*sizeof(double));
+  for(int nx=0; nx<NX; nx++)
+   { double X[3];
+     for(int i=0; i<3; i++)
+      X[i]=XMatrix->GetEntryD(nx, ColumnOffset+i);
+     if (LBasis)
+      GetUnitCellRepresentative(X, XX+3*nx);
+     else 
+      memcpy(XX+3*nx, X, 3*sizeof(double));
+   };
+  int *Order=(int *)mallocEC(NX*sizeof(int));
+  GetMortonOrder(XX, NX, Order);
+
+  /*--------------------------------------------------------------*/
+  /*- classify points in sorted order, in chunks that may be     -*/
+  /*- handled by separate threads                                -*/
+  /*--------------------------------------------------------------*/
+  const int ChunkSize=256;
+  int NumChunks=(NX+ChunkSize-1)/ChunkSize;
+  int NumRayTests=0;
+#ifdef USE_OPENMP
+  int NumThreads=GetNumThreads();
+#pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads), reduction(+:NumRayTests)
+#endif
+  for(int nc=0; nc<NumChunks; nc++)
+   { 
+     double *XA=0;        // most recent explicitly-classified point
+     double RA=-1.0;      // radius of panel-free ball about XA
+     int RegionA=0;       // region containing XA
+     int nMax = (nc+1)*ChunkSize < NX ? (nc+1)*ChunkSize : NX;
+     for(int n=nc*ChunkSize; n<nMax; n++)
+      { int nx=Order[n];
+        double *X=XX+3*nx;
+        if ( XA && VecDistance(X, XA) < RA )
+         { Regions[nx]=RegionA;
+           continue;
+         };
+        RegionA = Regions[nx] = GetRegionIndexOfRepresentative(this, X);
+        // (shrink the ball slightly to allow for the single-precision
+        //  panel coordinates stored in the tree)
+        RA      = 0.99*kdtri_box_distance(kdAllPanels, X, HUGE_VAL);
+        XA      = X;
+        NumRayTests++;
+      };
+   };
 
-  return 0;
+  if (LogLevel >= SCUFF_VERBOSELOGGING)
+   Log("GetRegionIndices: classified %i points with %i ray tests",NX,NumRayTests);
 
+  free(Order);
+  free(XX);
+  return Regions;
 }
 
 } // namespace scuff
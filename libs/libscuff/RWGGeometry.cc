@@ -35,6 +35,7 @@
 #include <BZIntegration.h> // needed for GetRLBasis
 
 #include "libscuff.h"
+#include "libscuffInternals.h"
 
 namespace scuff {
 
@@ -49,6 +50,8 @@ bool RWGGeometry::UseHRWGFunctions=false;
 bool RWGGeometry::UseHighKTaylorDuffy=true;
 bool RWGGeometry::UseTaylorDuffyV2P0=true;
 bool RWGGeometry::DisableCache=false;
+double RWGGeometry::IntegrationTolerance=0.0;
+double RWGGeometry::DGFMemoryBudget=1024.0;
 
 /***********************************************************************/
 /* subroutine to parse the MEDIUM...ENDMEDIUM section in a .scuffgeo   */
@@ -365,6 +368,8 @@ RWGGeometry::RWGGeometry(const char *pGeoFileName, int pLogLevel)
   GeoFileName=strdupEC(pGeoFileName);
   Surfaces=0;
   AllSurfacesClosed=1;
+  kdAllPanels=0;
+  kdAllPanelsStamp=0;
   Substrate=0;
 
   /***************************************************************/
@@ -402,6 +407,17 @@ RWGGeometry::RWGGeometry(const char *pGeoFileName, int pLogLevel)
   RWGGeometry::DisableCache=CheckEnv("SCUFF_DISABLE_CACHE");
   RWGGeometry::UseHRWGFunctions=CheckEnv("SCUFF_HALF_RWG");
 
+  if ( (s=getenv("SCUFF_INTEGRATION_TOLERANCE")) )
+   { if ( 1!=sscanf(s,"%le",&IntegrationTolerance) || IntegrationTolerance<0.0 )
+      ErrExit("invalid value %s for SCUFF_INTEGRATION_TOLERANCE",s);
+     Log("Selecting cubature rules for integration tolerance %.1e.",IntegrationTolerance);
+   };
+
+  if ( (s=getenv("SCUFF_DGF_MEMORY")) )
+   { if ( 1!=sscanf(s,"%le",&DGFMemoryBudget) || DGFMemoryBudget<=0.0 )
+      ErrExit("invalid value %s for SCUFF_DGF_MEMORY",s);
+   };
+
   if (CheckEnv("SCUFF_ABORT_ON_FPE"))
    {
 #ifndef __APPLE__
@@ -837,6 +853,9 @@ RWGGeometry::~RWGGeometry()
     DestroyFIBBICache(FIBBICaches[ns]);
   free(FIBBICaches);
 
+  LogSharedCacheStatistics();
+
+  kdtri_destroy(kdAllPanels);
 }
 
 /***************************************************************/
@@ -1107,9 +1126,20 @@ void RWGGeometry::UpdateCachedEpsMuValues(cdouble Omega)
   //if (Omega != StoredOmega )
   if (1)
    { StoredOmega=Omega;
-     for(int nr=0; nr<NumRegions; nr++)
-      RegionMPs[nr]->GetEpsMu(Omega, &(EpsTF[nr]), &(MuTF[nr]) );
+     GetEpsMuValues(Omega, EpsTF, MuTF);
    };
 }
 
+/***************************************************************/
+/* reentrant alternative to UpdateCachedEpsMuValues: fill in   */
+/* caller-supplied arrays of length NumRegions instead of the  */
+/* EpsTF, MuTF fields, so that calls at different frequencies  */
+/* may proceed simultaneously.                                 */
+/***************************************************************/
+void RWGGeometry::GetEpsMuValues(cdouble Omega, cdouble *Eps, cdouble *Mu)
+{
+  for(int nr=0; nr<NumRegions; nr++)
+   RegionMPs[nr]->GetEpsMu(Omega, Eps+nr, Mu+nr);
+}
+
 } // namespace scuff
@@ -34,6 +34,7 @@
 #include <libhrutil.h>
 
 #include "libscuff.h"
+#include "libscuffInternals.h"
 #include "cmatheval.h"
 
 namespace scuff {
@@ -206,6 +207,9 @@ char *RWGSurface::ParseOBJECTSURFACESection(FILE *f, int *LineNum)
         cevaluator_set_var_index(SurfaceZeta, "x", 1);
         cevaluator_set_var_index(SurfaceZeta, "y", 2);
         cevaluator_set_var_index(SurfaceZeta, "z", 3);
+        char *ZetaVars[4]={ const_cast<char *>("w"), const_cast<char *>("x"),
+                            const_cast<char *>("y"), const_cast<char *>("z") };
+        SurfaceZetaProgram=cevaluator_compile(SurfaceZeta, 4, ZetaVars);
         Log("Surface %s has surface impedance Zeta=%s.\n",Label,cevaluator_get_string(SurfaceZeta));
       }
      else if (   !StrCaseCmp(Tokens[0],"ENDOBJECT") || !StrCaseCmp(Tokens[0],"ENDSURFACE") )
@@ -224,10 +228,76 @@ char *RWGSurface::ParseOBJECTSURFACESection(FILE *f, int *LineNum)
 /* On success, the return value is NULL and the *MeshFileDir,  */
 /* VertexCoordinates, and PanelVertexIndices fields are        */
 /* filled in.                                                  */
+/*                                                             */
+/* If the mesh was read from a binary .scuffmesh file, or if   */
+/* a cached .scuffmesh file should be written for it (see      */
+/* GetScuffMeshCacheFile below), *SMF is set to a non-NULL     */
+/* value on return, for use by InitRWGSurface().               */
 /***************************************************************/
+char *ReadScuffMeshFile(char *MeshFileName, const char *FullName, int MeshTag,
+                        ScuffMeshFile **SMF,
+                        dVec &VertexCoordinates, iVec &PanelVertexIndices)
+{
+  char *ErrMsg=0;
+  ScuffMeshFile *S=OpenScuffMeshFile(FullName, &ErrMsg);
+  if (ErrMsg) return ErrMsg;
+
+  // a .scuffmesh file holds a single physical region (or the whole
+  // mesh, if it was written with MeshTag=-1) of its source mesh
+  if (MeshTag!=-1 && S->MeshTag!=MeshTag)
+   { if (S->MeshTag==-1)
+      ErrMsg=vstrdup("%s: file contains the whole mesh, not physical region %i",
+                     MeshFileName, MeshTag);
+     else
+      ErrMsg=vstrdup("%s: file contains physical region %i, not %i",
+                     MeshFileName, S->MeshTag, MeshTag);
+     CloseScuffMeshFile(S);
+     return ErrMsg;
+   };
+  VertexCoordinates.assign(S->Vertices, S->Vertices + 3*S->NumVertices);
+  PanelVertexIndices.assign(S->PanelVI, S->PanelVI + 3*S->NumPanels);
+  Log(" Read %i vertices, %i panels, %i edges from %s",
+        S->NumVertices, S->NumPanels, S->NumEdges, MeshFileName);
+  *SMF=S;
+  return 0;
+}
+
+/***************************************************************/
+/* If the environment variable SCUFF_MESH_CACHE names a        */
+/* directory, look there for a .scuffmesh file generated from  */
+/* the given mesh file (as identified by a hash of its         */
+/* contents). If one exists, it is opened; otherwise we return */
+/* a request to write one once the surface has been set up.    */
+/***************************************************************/
+ScuffMeshFile *GetScuffMeshCacheFile(FILE *MeshFile, char *MeshFileName, int MeshTag)
+{
+  char *CacheDir=getenv("SCUFF_MESH_CACHE");
+  if (!CacheDir || !*CacheDir) return 0;
+
+  unsigned long long Hash=GetMeshFileHash(MeshFile, MeshTag);
+  char CacheFileName[MAXSTR];
+  snprintf(CacheFileName, MAXSTR, "%s/%s_%016llx.scuffmesh",
+           CacheDir, GetFileBase(MeshFileName), Hash);
+
+  char *ErrMsg=0;
+  ScuffMeshFile *SMF=OpenScuffMeshFile(CacheFileName, &ErrMsg);
+  if (SMF && SMF->SourceHash==Hash && SMF->MeshTag==MeshTag)
+   { Log(" Using cached mesh data from %s",CacheFileName);
+     return SMF;
+   };
+  if (SMF) 
+   CloseScuffMeshFile(SMF);
+  if (ErrMsg) 
+   free(ErrMsg);
+  return CreateScuffMeshFileRequest(CacheFileName, Hash);
+}
+
 char *ParseMeshFile(char *MeshFileName, int MeshTag, char **MeshFileDir,
-                    dVec &VertexCoordinates, iVec &PanelVertexIndices)
+                    dVec &VertexCoordinates, iVec &PanelVertexIndices,
+                    ScuffMeshFile **SMF)
 {
+  *SMF=0;
+
   /*------------------------------------------------------------*/
   /*- try to open the mesh file. we look in several places:     */
   /*- (a) the current working directory                         */
@@ -249,7 +319,27 @@ char *ParseMeshFile(char *MeshFileName, int MeshTag, char **MeshFileDir,
   char *p=GetFileExtension(MeshFileName);
   if (!p) 
    return vstrdup("file %s: invalid extension",MeshFileName);
-  else if (!StrCaseCmp(p,"msh"))
+  else if (!StrCaseCmp(p,"scuffmesh"))
+   { fclose(MeshFile);
+     char FullName[MAXSTR];
+     snprintf(FullName, MAXSTR, "%s%s%s", Dir ? Dir : "", Dir ? "/" : "", MeshFileName);
+     return ReadScuffMeshFile(MeshFileName, FullName, MeshTag, SMF, 
+                              VertexCoordinates, PanelVertexIndices);
+   }
+
+  /*------------------------------------------------------------*/
+  /*- if a cached binary version of this mesh exists, use it    */
+  /*------------------------------------------------------------*/
+  *SMF=GetScuffMeshCacheFile(MeshFile, MeshFileName, MeshTag);
+  if (*SMF && (*SMF)->Map)
+   { ScuffMeshFile *S=*SMF;
+     fclose(MeshFile);
+     VertexCoordinates.assign(S->Vertices, S->Vertices + 3*S->NumVertices);
+     PanelVertexIndices.assign(S->PanelVI, S->PanelVI + 3*S->NumPanels);
+     return 0;
+   }
+
+  if (!StrCaseCmp(p,"msh"))
    return ParseGMSHFile(MeshFile,MeshFileName,MeshTag, VertexCoordinates,PanelVertexIndices);
   else if (!StrCaseCmp(p,"mphtxt"))
    return ParseComsolFile(MeshFile,MeshFileName,MeshTag,VertexCoordinates, PanelVertexIndices);
@@ -273,7 +363,7 @@ char *ParseMeshFile(char *MeshFileName, int MeshTag, char **MeshFileDir,
 /*--------------------------------------------------------------*/
 RWGSurface::RWGSurface(FILE *f, const char *pLabel, int *LineNum, char *Keyword)
 { 
-  SurfaceZeta=0;
+  SurfaceZeta=SurfaceZetaProgram=0;
   MeshTag=-1;
   MeshFileName=MeshFileDir=0;
   MaterialName=0;
@@ -293,8 +383,12 @@ RWGSurface::RWGSurface(FILE *f, const char *pLabel, int *LineNum, char *Keyword)
 
   dVec VertexCoordinates;
   iVec PanelVertexIndices;
-  ErrMsg=ParseMeshFile(MeshFileName, MeshTag, &MeshFileDir, VertexCoordinates, PanelVertexIndices);
-  if (ErrMsg) return;
+  ScuffMeshFile *SMF=0;
+  ErrMsg=ParseMeshFile(MeshFileName, MeshTag, &MeshFileDir, VertexCoordinates, PanelVertexIndices, &SMF);
+  if (ErrMsg) 
+   { CloseScuffMeshFile(SMF);
+     return;
+   }
 
   // if we are an OBJECT and there was no MATERIAL specification,
   // or we are a SURFACE and there was no REGIONS specification, then
@@ -306,7 +400,8 @@ RWGSurface::RWGSurface(FILE *f, const char *pLabel, int *LineNum, char *Keyword)
    }
 
   // ok, all checks passed, now on to the main body of the class constructor.
-  ErrMsg=InitRWGSurface(VertexCoordinates, PanelVertexIndices);
+  ErrMsg=InitRWGSurface(VertexCoordinates, PanelVertexIndices, SMF);
+  CloseScuffMeshFile(SMF);
 }
 
 /*--------------------------------------------------------------*/
@@ -319,15 +414,17 @@ RWGSurface::RWGSurface(const char *MeshFile, int pMeshTag)
   MeshFileDir=0;
   MeshTag=pMeshTag;
   Label=strdup(MeshFile);
-  SurfaceZeta=0;
+  SurfaceZeta=SurfaceZetaProgram=0;
   MaterialName=RegionLabels[0]=RegionLabels[1]=0;
   IsPEC=true;
   OTGT=0;
   dVec VertexCoordinates;
   iVec PanelVertexIndices;
-  ErrMsg=ParseMeshFile(MeshFileName, MeshTag, &MeshFileDir, VertexCoordinates, PanelVertexIndices);
-  if (ErrMsg) return;
-  ErrMsg=InitRWGSurface(VertexCoordinates, PanelVertexIndices);
+  ScuffMeshFile *SMF=0;
+  ErrMsg=ParseMeshFile(MeshFileName, MeshTag, &MeshFileDir, VertexCoordinates, PanelVertexIndices, &SMF);
+  if (!ErrMsg)
+   ErrMsg=InitRWGSurface(VertexCoordinates, PanelVertexIndices, SMF);
+  CloseScuffMeshFile(SMF);
 }
 
 /*--------------------------------------------------------------*/
@@ -344,7 +441,7 @@ RWGSurface::RWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices, char *pL
   MeshFileName=vstrdup("Manual_NV%i_NP%i",VertexCoordinates.size() / 3, PanelVertexIndices.size() / 3 );
   MeshFileDir=0;
   MeshTag=0;
-  SurfaceZeta=0;
+  SurfaceZeta=SurfaceZetaProgram=0;
   MaterialName=RegionLabels[0]=RegionLabels[1]=0;
   IsPEC=1;
   OTGT=0;
@@ -385,7 +482,7 @@ RWGSurface::RWGSurface(dVec X0, dVec L1, dVec L2, int N1, int N2, char *pLabel)
   Label = strdup( pLabel ? pLabel : MeshFileName );
   MeshFileDir=MaterialName=RegionLabels[0]=RegionLabels[1]=0;
   MeshTag=0;
-  SurfaceZeta=0;
+  SurfaceZeta=SurfaceZetaProgram=0;
   OTGT=0;
   IsPEC=IsObject=true;
   ErrMsg=InitRWGSurface(VertexCoordinates,PanelVertexIndices);
@@ -403,7 +500,8 @@ RWGSurface::RWGSurface(dVec X0, dVec L1, dVec L2, int N1, int N2, char *pLabel)
 /*- NumVertices, Panels, NumPanels.                             */
 /*--------------------------------------------------------------*/
 /*--------------------------------------------------------------*/
-char *RWGSurface::InitRWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices)
+char *RWGSurface::InitRWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices,
+                                 ScuffMeshFile *SMF)
 { 
   /*------------------------------------------------------------*/
   /*- initialize simple fields ---------------------------------*/
@@ -417,6 +515,8 @@ char *RWGSurface::InitRWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices
   ErrMsg=0;
   GT=0;
   kdPanels=0;
+  Packed=0;
+  TransformStamp=0;
   NumEdges=TotalStraddlers=0;
   PhasedBFCs=0;
   tolVecClose=0.0;
@@ -450,10 +550,25 @@ char *RWGSurface::InitRWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices
   /*------------------------------------------------------------*/
   /* gather necessary edge connectivity info. this is           */
   /* complicated enough to warrant its own separate routine.    */
+  /* if the mesh came from a .scuffmesh file, the edge list     */
+  /* was stored with it; otherwise, if SMF is non-NULL, it      */
+  /* names a cache file to which we write the edge list once    */
+  /* we have computed it.                                       */
   /*------------------------------------------------------------*/
-  ErrMsg=InitEdgeList();
+  if (SMF && SMF->Map)
+   ErrMsg=InitEdgeListFromScuffMesh(SMF);
+  else
+   ErrMsg=InitEdgeList();
   if (ErrMsg) return ErrMsg;
 
+  if (SMF && !SMF->Map)
+   { char *WriteErr=WriteScuffMeshFile(SMF->FileName, &(VertexCoordinates[0]), SMF->SourceHash);
+     if (WriteErr)
+      { Warn("%s (continuing without mesh cache)",WriteErr);
+        free(WriteErr);
+      };
+   };
+
   /*------------------------------------------------------------*/
   /*- After InitEdgeList, the Edges array has length NumEdges   */
   /*- and contains only full RWG edges, while the HalfRWGEdges  */
@@ -525,6 +640,8 @@ char *RWGSurface::InitRWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices
   /*------------------------------------------------------------*/
   InitkdPanels(false);
 
+  UpdatePackedMesh();
+
   return 0;
 } 
 
@@ -564,6 +681,49 @@ RWGSurface::~RWGSurface()
   if (RegionLabels[1]) free(RegionLabels[1]);
 
   kdtri_destroy(kdPanels);
+  DestroyPackedMesh(Packed);
+
+  if (SurfaceZetaProgram) cevaluator_destroy_compiled(SurfaceZetaProgram);
+  if (SurfaceZeta) cevaluator_destroy(SurfaceZeta);
+}
+
+/***************************************************************/
+/* evaluate the user-specified surface impedance at angular    */
+/* frequency Omega at each of NumPoints points X[0..2],        */
+/* X[3..5], ...                                                */
+/***************************************************************/
+void RWGSurface::GetSurfaceZeta(cdouble Omega, int NumPoints,
+                                const double *X, cdouble *Zeta)
+{
+  if (SurfaceZeta==0)
+   { for(int np=0; np<NumPoints; np++)
+      Zeta[np]=0.0;
+     return;
+   };
+
+  // the input array holds (w,x,y,z) for each point
+#define ZETA_CHUNK 64
+  cdouble Inputs[4*ZETA_CHUNK];
+  cdouble w = Omega*MatProp::FreqUnit;
+  for(int np0=0; np0<NumPoints; np0+=ZETA_CHUNK)
+   { 
+     int NP = (NumPoints-np0 < ZETA_CHUNK) ? NumPoints-np0 : ZETA_CHUNK;
+     for(int np=0; np<NP; np++)
+      { Inputs[4*np+0] = w;
+        Inputs[4*np+1] = X[3*(np0+np) + 0];
+        Inputs[4*np+2] = X[3*(np0+np) + 1];
+        Inputs[4*np+3] = X[3*(np0+np) + 2];
+      };
+
+     if (SurfaceZetaProgram)
+      cevaluator_evaluate_compiled(SurfaceZetaProgram, NP, Inputs, Zeta+np0);
+     else
+      { char *ParmNames[4]={ const_cast<char *>("w"), const_cast<char *>("x"),
+                             const_cast<char *>("y"), const_cast<char *>("z") };
+        for(int np=0; np<NP; np++)
+         Zeta[np0+np]=cevaluator_evaluate(SurfaceZeta, 4, ParmNames, Inputs+4*np);
+      };
+   };
 }
 
 
@@ -616,6 +776,8 @@ void RWGSurface::Transform(const GTransformation *DeltaGT)
    InitRWGPanel(Panels[np], Vertices);
 
   UpdateBoundingBox();
+  UpdatePackedMesh();
+  TransformStamp++;
 
   /***************************************************************/
   /* update the internally stored GTransformation ****************/
@@ -664,6 +826,8 @@ void RWGSurface::UnTransform()
   for(int np=0; np<NumPanels; np++)
    InitRWGPanel(Panels[np], Vertices);
   UpdateBoundingBox();
+  UpdatePackedMesh();
+  TransformStamp++;
 }
 
 /*--------------------------------------------------------------*/
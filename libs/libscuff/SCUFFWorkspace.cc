@@ -0,0 +1,104 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * SCUFFWorkspace.cc -- per-caller scratch storage for libscuff routines
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+
+namespace scuff {
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+SCUFFWorkspace::SCUFFWorkspace()
+{
+  NumSlots=0;
+  Buffers=0;
+  BufferSizes=0;
+  Matrices=0;
+}
+
+SCUFFWorkspace::~SCUFFWorkspace()
+{
+  for(int ns=0; ns<NumSlots; ns++)
+   { if (Buffers[ns]) free(Buffers[ns]);
+     if (Matrices[ns]) delete Matrices[ns];
+   };
+  if (Buffers) free(Buffers);
+  if (BufferSizes) free(BufferSizes);
+  if (Matrices) free(Matrices);
+}
+
+/***************************************************************/
+/* make sure slot #Slot exists *********************************/
+/***************************************************************/
+void SCUFFWorkspace::Grow(int Slot)
+{
+  if (Slot<NumSlots)
+   return;
+
+  int NewNumSlots = Slot+1;
+  Buffers     = (void **)reallocEC(Buffers, NewNumSlots*sizeof(void *));
+  BufferSizes = (size_t *)reallocEC(BufferSizes, NewNumSlots*sizeof(size_t));
+  Matrices    = (HMatrix **)reallocEC(Matrices, NewNumSlots*sizeof(HMatrix *));
+  for(int ns=NumSlots; ns<NewNumSlots; ns++)
+   { Buffers[ns]=0;
+     BufferSizes[ns]=0;
+     Matrices[ns]=0;
+   };
+  NumSlots=NewNumSlots;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void *SCUFFWorkspace::GetBuffer(int Slot, size_t Size)
+{
+  Grow(Slot);
+  if (BufferSizes[Slot] < Size)
+   { if (Buffers[Slot]) free(Buffers[Slot]);
+     Buffers[Slot]=mallocEC(Size);
+     BufferSizes[Slot]=Size;
+   };
+  if (Buffers[Slot]) 
+   memset(Buffers[Slot], 0, Size);
+  return Buffers[Slot];
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+HMatrix *SCUFFWorkspace::GetMatrix(int Slot, int NR, int NC, int RealComplex)
+{
+  Grow(Slot);
+  HMatrix *M=Matrices[Slot];
+  if ( M==0 || M->NR!=NR || M->NC!=NC || M->RealComplex!=RealComplex )
+   { if (M) delete M;
+     M = Matrices[Slot] = new HMatrix(NR, NC, RealComplex);
+   };
+  return M;
+}
+
+} // namespace scuff
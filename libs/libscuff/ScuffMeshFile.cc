@@ -0,0 +1,495 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * ScuffMeshFile.cc -- reading and writing .scuffmesh files, a binary
+ *                  -- container for a surface mesh together with the
+ *                  -- topology computed from it by InitEdgeList()
+ *
+ * A .scuffmesh file stores the (untransformed) vertices and panels of
+ * a mesh, the table of interior and exterior RWG edges, and the
+ * exterior boundary contours, each in a 64-byte-aligned section, so
+ * that the file may be mapped into memory and the RWGSurface built
+ * directly from it without parsing text or rebuilding the edge list.
+ * The header records a hash of the source mesh file (plus the physical
+ * region and any SCUFF_PIXEL_SIZE rounding) from which the file was
+ * generated.
+ *
+ * Files are produced either by scuff-analyze --WriteScuffMesh or
+ * automatically, if the SCUFF_MESH_CACHE environment variable names a
+ * directory, the first time a given mesh is read; on subsequent runs
+ * the cached file is used as long as the hash still matches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <libhrutil.h>
+
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+namespace scuff {
+
+#define MAXSTR 1000
+
+#define SCUFFMESH_MAGIC     "SCUFFMSH"
+#define SCUFFMESH_VERSION   1
+#define SCUFFMESH_BOM       0x01020304U
+#define SCUFFMESH_ALIGNMENT 64
+
+// number of integers per entry in the edge table:
+// iV1, iV2, iQP, iQM, iPPanel, iMPanel, PIndex, MIndex
+#define EDGE_TABLE_WIDTH 8
+
+enum { SECTION_VERTICES, SECTION_PANELS, SECTION_EDGES,
+       SECTION_NUMBCEDGES, SECTION_BCEDGES, SECTION_WHICHBC,
+       NUMSECTIONS };
+
+typedef struct ScuffMeshHeader
+ { char Magic[8];
+   unsigned int Version;
+   unsigned int ByteOrderMark;
+   unsigned long long SourceHash;
+   int MeshTag;
+   int NumVertices, NumPanels, NumEdges, NumExteriorEdges;
+   int NumBCs, NumBCEdgesTotal, NumInteriorVertices;
+   unsigned long long Offsets[NUMSECTIONS];
+   unsigned long long FileSize;
+ } ScuffMeshHeader;
+
+static unsigned long long AlignOffset(unsigned long long Offset)
+{ return (Offset + SCUFFMESH_ALIGNMENT - 1) & ~((unsigned long long)SCUFFMESH_ALIGNMENT - 1); }
+
+/***************************************************************/
+/* 64-bit FNV-1a hash of the contents of an open file, of the  */
+/* physical-region tag, and of the SCUFF_PIXEL_SIZE setting    */
+/* (which affects the vertices we read). the file is rewound   */
+/* on return.                                                  */
+/***************************************************************/
+static unsigned long long HashBytes(unsigned long long Hash, const void *Data, size_t Size)
+{ const unsigned char *p=(const unsigned char *)Data;
+  for(size_t n=0; n<Size; n++)
+   { Hash ^= p[n];
+     Hash *= 1099511628211ULL;
+   };
+  return Hash;
+}
+
+unsigned long long GetMeshFileHash(FILE *MeshFile, int MeshTag)
+{
+  unsigned long long Hash=14695981039346656037ULL;
+  char Buffer[65536];
+  size_t n;
+  rewind(MeshFile);
+  while( (n=fread(Buffer, 1, sizeof(Buffer), MeshFile)) > 0 )
+   Hash=HashBytes(Hash, Buffer, n);
+  rewind(MeshFile);
+
+  Hash=HashBytes(Hash, &MeshTag, sizeof(int));
+  const char *s=getenv("SCUFF_PIXEL_SIZE");
+  if (s)
+   Hash=HashBytes(Hash, s, strlen(s));
+  return Hash;
+}
+
+/***************************************************************/
+/* check that all indices stored in a mapped file are in range,*/
+/* so that a corrupted file produces an error message rather   */
+/* than a crash                                                */
+/***************************************************************/
+static char *CheckScuffMeshFile(ScuffMeshFile *SMF)
+{
+  int NV=SMF->NumVertices, NP=SMF->NumPanels;
+  int NTE=SMF->NumEdges + SMF->NumExteriorEdges;
+
+  for(int n=0; n<3*NP; n++)
+   if ( SMF->PanelVI[n]<0 || SMF->PanelVI[n]>=NV )
+    return vstrdup("%s: invalid vertex index in panel table",SMF->FileName);
+
+  for(int ne=0; ne<NTE; ne++)
+   { const int *ET=SMF->EdgeTable + EDGE_TABLE_WIDTH*ne;
+     bool Exterior = (ne>=SMF->NumEdges);
+     for(int i=0; i<4; i++)
+      if ( (ET[i]<0 && !(i==3 && Exterior)) || ET[i]>=NV )
+       return vstrdup("%s: invalid vertex index in edge table",SMF->FileName);
+     if (    ET[4]<0 || ET[4]>=NP
+          || (Exterior ? ET[5]!=-1 : (ET[5]<0 || ET[5]>=NP))
+          || ET[6]<0 || ET[6]>2 || ET[7]<0 || ET[7]>2 )
+      return vstrdup("%s: invalid panel index in edge table",SMF->FileName);
+   };
+
+  for(int n=0; n<SMF->NumBCEdgesTotal; n++)
+   if ( SMF->BCEdges[n]<0 || SMF->BCEdges[n]>=SMF->NumExteriorEdges )
+    return vstrdup("%s: invalid edge index in boundary-contour table",SMF->FileName);
+
+  // WhichBC is zero for vertices not on any boundary contour
+  for(int nv=0; nv<NV; nv++)
+   if ( SMF->WhichBC[nv]<0 || (SMF->WhichBC[nv]>0 && SMF->WhichBC[nv]>=SMF->NumBCs) )
+    return vstrdup("%s: invalid boundary-contour index in vertex table",SMF->FileName);
+
+  return 0;
+}
+
+/***************************************************************/
+/* map a .scuffmesh file into memory and check its header,     */
+/* section layout, and index tables. on failure, returns NULL  */
+/* and sets *ErrMsg.                                           */
+/***************************************************************/
+ScuffMeshFile *OpenScuffMeshFile(const char *FileName, char **ErrMsg)
+{
+  *ErrMsg=0;
+  int fd=open(FileName, O_RDONLY);
+  if (fd<0)
+   { *ErrMsg=vstrdup("could not open file %s",FileName);
+     return 0;
+   };
+
+  struct stat st;
+  if ( fstat(fd, &st)!=0 || (size_t)st.st_size < sizeof(ScuffMeshHeader) )
+   { close(fd);
+     *ErrMsg=vstrdup("%s: not a .scuffmesh file",FileName);
+     return 0;
+   };
+
+  size_t MapSize=st.st_size;
+  void *Map=mmap(0, MapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (Map==MAP_FAILED)
+   { *ErrMsg=vstrdup("%s: could not map file into memory",FileName);
+     return 0;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- sanity-check the header -------------------------------------*/
+  /*--------------------------------------------------------------*/
+  const ScuffMeshHeader *H=(const ScuffMeshHeader *)Map;
+  const char *Problem=0;
+  if ( strncmp(H->Magic, SCUFFMESH_MAGIC, 8) )
+   Problem="not a .scuffmesh file";
+  else if ( H->ByteOrderMark!=SCUFFMESH_BOM )
+   Problem="file was written on a machine with different byte order";
+  else if ( H->Version!=SCUFFMESH_VERSION )
+   Problem="unsupported .scuffmesh version";
+  else if ( H->FileSize!=MapSize )
+   Problem="file is truncated";
+  else if (    H->NumVertices<0 || H->NumPanels<=0 || H->NumEdges<0
+            || H->NumExteriorEdges<0 || H->NumBCs<0 || H->NumBCEdgesTotal<0 )
+   Problem="invalid header";
+
+  /*--------------------------------------------------------------*/
+  /*- check that each section lies within the file (the counts    -*/
+  /*- are nonnegative ints, so the sizes cannot overflow)         -*/
+  /*--------------------------------------------------------------*/
+  char *Base=(char *)Map;
+  if (!Problem)
+   { unsigned long long NTE = (unsigned long long)H->NumEdges + H->NumExteriorEdges;
+     unsigned long long SectionSize[NUMSECTIONS];
+     SectionSize[SECTION_VERTICES]   = 3ULL*H->NumVertices*sizeof(double);
+     SectionSize[SECTION_PANELS]     = 3ULL*H->NumPanels*sizeof(int);
+     SectionSize[SECTION_EDGES]      = EDGE_TABLE_WIDTH*NTE*sizeof(int);
+     SectionSize[SECTION_NUMBCEDGES] = (unsigned long long)H->NumBCs*sizeof(int);
+     SectionSize[SECTION_BCEDGES]    = (unsigned long long)H->NumBCEdgesTotal*sizeof(int);
+     SectionSize[SECTION_WHICHBC]    = (unsigned long long)H->NumVertices*sizeof(int);
+     for(int ns=0; ns<NUMSECTIONS && !Problem; ns++)
+      { unsigned long long Offset=H->Offsets[ns];
+        if (    Offset<sizeof(ScuffMeshHeader) || Offset%SCUFFMESH_ALIGNMENT
+             || Offset>MapSize || SectionSize[ns]>MapSize-Offset )
+         Problem="invalid section offset or size (file is corrupted)";
+      };
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- the boundary-contour lengths must add up to the size of the -*/
+  /*- boundary-contour edge table                                 -*/
+  /*--------------------------------------------------------------*/
+  if (!Problem)
+   { const int *NumBCEdges=(const int *)(Base + H->Offsets[SECTION_NUMBCEDGES]);
+     long long NumBCEdgesTotal=0;
+     for(int nbc=0; nbc<H->NumBCs && !Problem; nbc++)
+      { if (NumBCEdges[nbc]<0)
+         Problem="invalid boundary-contour table";
+        NumBCEdgesTotal+=NumBCEdges[nbc];
+      };
+     if (!Problem && NumBCEdgesTotal!=H->NumBCEdgesTotal)
+      Problem="inconsistent boundary-contour table";
+   };
+
+  if (Problem)
+   { munmap(Map, MapSize);
+     *ErrMsg=vstrdup("%s: %s",FileName,Problem);
+     return 0;
+   };
+
+  ScuffMeshFile *SMF=(ScuffMeshFile *)mallocEC(sizeof(ScuffMeshFile));
+  SMF->FileName            = strdupEC(FileName);
+  SMF->Map                 = Map;
+  SMF->MapSize             = MapSize;
+  SMF->SourceHash          = H->SourceHash;
+  SMF->MeshTag             = H->MeshTag;
+  SMF->NumVertices         = H->NumVertices;
+  SMF->NumPanels           = H->NumPanels;
+  SMF->NumEdges            = H->NumEdges;
+  SMF->NumExteriorEdges    = H->NumExteriorEdges;
+  SMF->NumBCs              = H->NumBCs;
+  SMF->NumBCEdgesTotal     = H->NumBCEdgesTotal;
+  SMF->NumInteriorVertices = H->NumInteriorVertices;
+  SMF->Vertices   = (const double *)(Base + H->Offsets[SECTION_VERTICES]);
+  SMF->PanelVI    = (const int *)   (Base + H->Offsets[SECTION_PANELS]);
+  SMF->EdgeTable  = (const int *)   (Base + H->Offsets[SECTION_EDGES]);
+  SMF->NumBCEdges = (const int *)   (Base + H->Offsets[SECTION_NUMBCEDGES]);
+  SMF->BCEdges    = (const int *)   (Base + H->Offsets[SECTION_BCEDGES]);
+  SMF->WhichBC    = (const int *)   (Base + H->Offsets[SECTION_WHICHBC]);
+
+  // check the index tables before anything is built from them
+  *ErrMsg=CheckScuffMeshFile(SMF);
+  if (*ErrMsg)
+   { CloseScuffMeshFile(SMF);
+     return 0;
+   };
+
+  return SMF;
+}
+
+/***************************************************************/
+/* a ScuffMeshFile with no mapping is just a note to write the */
+/* cache file FileName once the edge list has been computed    */
+/***************************************************************/
+ScuffMeshFile *CreateScuffMeshFileRequest(const char *FileName, unsigned long long SourceHash)
+{
+  ScuffMeshFile *SMF=(ScuffMeshFile *)mallocEC(sizeof(ScuffMeshFile));
+  memset(SMF, 0, sizeof(ScuffMeshFile));
+  SMF->FileName   = strdupEC(FileName);
+  SMF->SourceHash = SourceHash;
+  return SMF;
+}
+
+void CloseScuffMeshFile(ScuffMeshFile *SMF)
+{
+  if (!SMF) return;
+  if (SMF->Map)
+   munmap(SMF->Map, SMF->MapSize);
+  free(SMF->FileName);
+  free(SMF);
+}
+
+/***************************************************************/
+/* counterpart of InitEdgeList() that takes the edge table and */
+/* boundary contours from a mapped .scuffmesh file. on entry,  */
+/* the Vertices and Panels arrays have been filled in from the */
+/* same file (and the vertices transformed by any OTGT).       */
+/***************************************************************/
+char *RWGSurface::InitEdgeListFromScuffMesh(ScuffMeshFile *SMF)
+{
+  if ( SMF->NumVertices!=NumVertices || SMF->NumPanels!=NumPanels )
+   return vstrdup("%s: internal inconsistency",SMF->FileName);
+
+  NumEdges         = SMF->NumEdges;
+  NumExteriorEdges = SMF->NumExteriorEdges;
+  NumHalfRWGEdges  = NumExteriorEdges;
+  NumTotalEdges    = NumEdges + NumExteriorEdges;
+
+  Edges=(RWGEdge **)mallocEC(NumEdges*sizeof(Edges[0]));
+  HalfRWGEdges=(RWGEdge **)mallocEC(NumExteriorEdges*sizeof(Edges[0]));
+
+  /*--------------------------------------------------------------*/
+  /*- rebuild each RWGEdge from its table entry; the geometric    */
+  /*- fields are computed exactly as in InitEdgeList()            */
+  /*--------------------------------------------------------------*/
+  for(int ne=0; ne<NumTotalEdges; ne++)
+   { const int *ET=SMF->EdgeTable + EDGE_TABLE_WIDTH*ne;
+     RWGEdge *E=(RWGEdge *)mallocEC(sizeof *E);
+     E->iV1     = ET[0];
+     E->iV2     = ET[1];
+     E->iQP     = ET[2];
+     E->iQM     = ET[3];
+     E->iPPanel = ET[4];
+     E->iMPanel = ET[5];
+     E->PIndex  = ET[6];
+     E->MIndex  = ET[7];
+     E->Next    = 0;
+
+     double *V1=Vertices + 3*E->iV1, *V2=Vertices + 3*E->iV2;
+     for(int i=0; i<3; i++)
+      E->Centroid[i]=(V1[i] + V2[i]) / 2.0;
+     E->Length = VecDistance(V1, V2);
+     E->Radius = VecDistance(E->Centroid, Vertices+3*E->iQP);
+     E->Radius = fmax(E->Radius, VecDistance(E->Centroid,V1));
+     E->Radius = fmax(E->Radius, VecDistance(E->Centroid,V2));
+     if (E->iQM!=-1)
+      E->Radius = fmax(E->Radius, VecDistance(E->Centroid,Vertices+3*E->iQM));
+
+     if (ne<NumEdges)
+      { E->Index=ne;
+        Edges[ne]=E;
+      }
+     else
+      { int nx=ne-NumEdges;
+        E->Index=-(nx+1);
+        HalfRWGEdges[nx]=E;
+      };
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- boundary contours ------------------------------------------*/
+  /*--------------------------------------------------------------*/
+  NumBCs=SMF->NumBCs;
+  WhichBC=(int *)mallocEC(NumVertices*sizeof(int));
+  memcpy(WhichBC, SMF->WhichBC, NumVertices*sizeof(int));
+  NumBCEdges=0;
+  BCEdges=0;
+  if (NumBCs>0)
+   { NumBCEdges=(int *)mallocEC(NumBCs*sizeof(int));
+     memcpy(NumBCEdges, SMF->NumBCEdges, NumBCs*sizeof(int));
+     BCEdges=(RWGEdge ***)mallocEC(NumBCs*sizeof(RWGEdge **));
+     const int *BCE=SMF->BCEdges;
+     for(int nbc=0; nbc<NumBCs; nbc++)
+      { BCEdges[nbc]=(RWGEdge **)mallocEC(NumBCEdges[nbc]*sizeof(RWGEdge *));
+        for(int n=0; n<NumBCEdges[nbc]; n++)
+         BCEdges[nbc][n]=HalfRWGEdges[ *(BCE++) ];
+      };
+   };
+
+  NumInteriorVertices=SMF->NumInteriorVertices;
+  return 0;
+}
+
+/***************************************************************/
+/* write a .scuffmesh file for this surface. MeshVertices, if  */
+/* non-NULL, are the vertex coordinates as read from the mesh  */
+/* file (before any OTGT was applied); otherwise the current   */
+/* Vertices array is used.                                     */
+/***************************************************************/
+char *RWGSurface::WriteScuffMeshFile(const char *FileName,
+                                     const double *MeshVertices,
+                                     unsigned long long SourceHash)
+{
+  if (TotalStraddlers>0)
+   return vstrdup("WriteScuffMeshFile: not supported for periodic surfaces");
+  for(int ne=0; ne<NumEdges; ne++)
+   if (Edges[ne]->iMPanel==-1)
+    return vstrdup("WriteScuffMeshFile: not supported with half-RWG basis functions");
+  if (MeshVertices==0)
+   MeshVertices=Vertices;
+
+  /*--------------------------------------------------------------*/
+  /*- flatten the edge table and boundary contours ----------------*/
+  /*--------------------------------------------------------------*/
+  int NTE=NumEdges + NumExteriorEdges;
+  int *EdgeTable=(int *)mallocEC((EDGE_TABLE_WIDTH*NTE + 1)*sizeof(int));
+  for(int ne=0; ne<NTE; ne++)
+   { RWGEdge *E = ne<NumEdges ? Edges[ne] : HalfRWGEdges[ne-NumEdges];
+     int *ET=EdgeTable + EDGE_TABLE_WIDTH*ne;
+     ET[0]=E->iV1;     ET[1]=E->iV2;     ET[2]=E->iQP;    ET[3]=E->iQM;
+     ET[4]=E->iPPanel; ET[5]=E->iMPanel; ET[6]=E->PIndex; ET[7]=E->MIndex;
+   };
+
+  int NumBCEdgesTotal=0;
+  for(int nbc=0; nbc<NumBCs; nbc++)
+   NumBCEdgesTotal+=NumBCEdges[nbc];
+  int *BCEdgeIndices=(int *)mallocEC((NumBCEdgesTotal+1)*sizeof(int));
+  for(int nbc=0, n=0; nbc<NumBCs; nbc++)
+   for(int nbce=0; nbce<NumBCEdges[nbc]; nbce++)
+    BCEdgeIndices[n++] = -(BCEdges[nbc][nbce]->Index) - 1;
+
+  int *PanelVI=(int *)mallocEC(3*NumPanels*sizeof(int));
+  for(int np=0; np<NumPanels; np++)
+   memcpy(PanelVI + 3*np, Panels[np]->VI, 3*sizeof(int));
+
+  /*--------------------------------------------------------------*/
+  /*- lay out the sections ----------------------------------------*/
+  /*--------------------------------------------------------------*/
+  const void *SectionData[NUMSECTIONS];
+  size_t SectionSize[NUMSECTIONS];
+  SectionData[SECTION_VERTICES]   = MeshVertices;
+  SectionSize[SECTION_VERTICES]   = 3*NumVertices*sizeof(double);
+  SectionData[SECTION_PANELS]     = PanelVI;
+  SectionSize[SECTION_PANELS]     = 3*NumPanels*sizeof(int);
+  SectionData[SECTION_EDGES]      = EdgeTable;
+  SectionSize[SECTION_EDGES]      = EDGE_TABLE_WIDTH*NTE*sizeof(int);
+  SectionData[SECTION_NUMBCEDGES] = NumBCEdges;
+  SectionSize[SECTION_NUMBCEDGES] = NumBCs*sizeof(int);
+  SectionData[SECTION_BCEDGES]    = BCEdgeIndices;
+  SectionSize[SECTION_BCEDGES]    = NumBCEdgesTotal*sizeof(int);
+  SectionData[SECTION_WHICHBC]    = WhichBC;
+  SectionSize[SECTION_WHICHBC]    = NumVertices*sizeof(int);
+
+  ScuffMeshHeader H;
+  memset(&H, 0, sizeof(H));
+  memcpy(H.Magic, SCUFFMESH_MAGIC, 8);
+  H.Version             = SCUFFMESH_VERSION;
+  H.ByteOrderMark       = SCUFFMESH_BOM;
+  H.SourceHash          = SourceHash;
+  H.MeshTag             = MeshTag;
+  H.NumVertices         = NumVertices;
+  H.NumPanels           = NumPanels;
+  H.NumEdges            = NumEdges;
+  H.NumExteriorEdges    = NumExteriorEdges;
+  H.NumBCs              = NumBCs;
+  H.NumBCEdgesTotal     = NumBCEdgesTotal;
+  H.NumInteriorVertices = NumInteriorVertices;
+  unsigned long long Offset=AlignOffset(sizeof(H));
+  for(int ns=0; ns<NUMSECTIONS; ns++)
+   { H.Offsets[ns]=Offset;
+     Offset=AlignOffset(Offset + SectionSize[ns]);
+   };
+  H.FileSize=Offset;
+
+  /*--------------------------------------------------------------*/
+  /*- write to a temporary file and rename it into place, so that -*/
+  /*- concurrent jobs never see a partially-written file          -*/
+  /*--------------------------------------------------------------*/
+  char TempName[MAXSTR];
+  snprintf(TempName, MAXSTR, "%s.%i.tmp", FileName, (int)getpid());
+  FILE *f=fopen(TempName,"w");
+  char *WriteErr=0;
+  if (!f)
+   WriteErr=vstrdup("could not open file %s",TempName);
+  else
+   { static const char Zeros[SCUFFMESH_ALIGNMENT]={0};
+     bool OK = (fwrite(&H, sizeof(H), 1, f)==1);
+     unsigned long long Position=sizeof(H);
+     for(int ns=0; OK && ns<NUMSECTIONS; ns++)
+      { OK = OK && fwrite(Zeros, 1, H.Offsets[ns]-Position, f)==H.Offsets[ns]-Position;
+        OK = OK && fwrite(SectionData[ns], 1, SectionSize[ns], f)==SectionSize[ns];
+        Position=H.Offsets[ns] + SectionSize[ns];
+      };
+     OK = OK && fwrite(Zeros, 1, H.FileSize-Position, f)==H.FileSize-Position;
+     OK = (fclose(f)==0) && OK;
+     if (!OK || rename(TempName, FileName)!=0)
+      { unlink(TempName);
+        WriteErr=vstrdup("could not write file %s",FileName);
+      };
+   };
+
+  free(EdgeTable);
+  free(BCEdgeIndices);
+  free(PanelVI);
+  if (!WriteErr)
+   Log("Wrote mesh data for %s to %s.",MeshFileName ? MeshFileName : Label,FileName);
+  return WriteErr;
+}
+
+} // namespace scuff
@@ -0,0 +1,523 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * SharedCache.cc -- a node-local cache of FIPPI and FIBBI records
+ *                -- shared by all scuff-em processes on a machine
+ *
+ * If the environment variable SCUFF_SHARED_CACHE names a POSIX
+ * shared-memory segment, the first process to need it creates the
+ * segment (of SCUFF_SHARED_CACHE_SIZE megabytes, default 1024) and
+ * every other process attaches to the same segment. FIPPICache and
+ * FIBBICache consult it whenever a record is missing from their own
+ * (per-process) tables, and publish every record they compute.
+ *
+ * The segment holds one open-addressing hash table per record type.
+ * A slot is claimed and published with atomic operations on its
+ * sequence word (0 = empty, odd = being written, even = valid), so
+ * no locks are shared between processes, and readers copy records
+ * out under a seqlock-style check. An insertion probes at most
+ * MAXPROBE slots; if all are taken by other keys it overwrites the
+ * least recently used of them, which caps the memory footprint.
+ * Records are never handed out by pointer, since they may be
+ * evicted at any time.
+ *
+ * The sequence word also records the PID of the process that last
+ * claimed the slot. A slot left half-written by a process that died
+ * is reclaimed by the next process to find it, instead of being
+ * waited on at every visit. (This requires all processes to share
+ * a PID namespace; processes in other namespaces just skip such
+ * slots.)
+ *
+ * Processes may share a segment while running with different
+ * integration settings (e.g. SCUFF_TAYLORDUFFY_RELTOL), so every
+ * record is keyed on a fingerprint of those settings as well as on
+ * its geometric key.
+ *
+ * The segment outlives the processes that use it; remove it with
+ * 'rm /dev/shm/NAME' to reclaim the memory.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <libhrutil.h>
+
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+namespace scuff {
+
+long JenkinsHash(const char *key, size_t len); // in FIBBICache.cc
+
+#define SHAREDCACHE_MAGIC   0x53435546464345ULL // "SCUFFCE"
+#define SHAREDCACHE_VERSION 2
+#define MAXPROBE            16
+#define MAXSPINS            100000
+#define LIVENESSCHECK       1024   // spins between checks for a dead writer
+#define DEFAULT_SIZE_MB     1024
+
+/***************************************************************/
+/* key and data sizes of the records in each table             */
+/***************************************************************/
+static const size_t KeySizes[NUMSHAREDCACHETABLES]
+ = { 15*sizeof(float),  21*sizeof(float)  };
+static const size_t DataSizes[NUMSHAREDCACHETABLES]
+ = { sizeof(QIFIPPIData), 51*sizeof(double) };
+static const char *TableNames[NUMSHAREDCACHETABLES]
+ = { "FIPPI", "FIBBI" };
+
+/***************************************************************/
+/* environment variables that change the values of the FIPPI   */
+/* and FIBBI records computed by this process                  */
+/***************************************************************/
+static const char *SettingsVariables[]
+ = { "SCUFF_TAYLORDUFFY_ABSTOL",
+     "SCUFF_TAYLORDUFFY_RELTOL",
+     "SCUFF_TAYLORDUFFY_MAXEVAL",
+     "SCUFF_TDMAXEVAL",
+     "SCUFF_UNFORCE_FORCE",
+     0
+   };
+
+/***************************************************************/
+/* layout of the shared segment: a header followed by the      */
+/* slots of each table. each slot is a SlotHeader followed by  */
+/* the key and the data, padded to a multiple of 8 bytes.      */
+/***************************************************************/
+typedef struct SharedCacheHeader
+ { uint64_t Magic;
+   uint32_t Version;
+   uint32_t NumTables;
+   uint64_t SegmentSize;
+   uint64_t Clock;      // incremented on every insertion, for LRU
+   uint64_t PIDNamespace; // of the creating process
+   uint64_t Offset[NUMSHAREDCACHETABLES];
+   uint64_t NumSlots[NUMSHAREDCACHETABLES];
+   uint64_t SlotSize[NUMSHAREDCACHETABLES];
+   uint64_t KeySize[NUMSHAREDCACHETABLES];
+   uint64_t DataSize[NUMSHAREDCACHETABLES];
+   uint64_t Inserts[NUMSHAREDCACHETABLES];
+   uint64_t Evictions[NUMSHAREDCACHETABLES];
+ } SharedCacheHeader;
+
+typedef struct SlotHeader
+ { uint64_t Seq;        // PID of last writer (high), counter (low)
+   uint64_t Stamp;
+   uint64_t Hash;
+   uint64_t Settings;
+ } SlotHeader;
+
+static SharedCacheHeader *Segment=0;
+static pthread_once_t AttachOnce=PTHREAD_ONCE_INIT;
+static uint64_t Settings=0;     // fingerprint of this process's settings
+static bool CanReclaim=false;   // true if we share the creator's PID namespace
+
+static size_t GetSlotSize(int Table)
+{ size_t Size = sizeof(SlotHeader) + KeySizes[Table] + DataSizes[Table];
+  return (Size + 7) & ~((size_t)7);
+}
+
+static SlotHeader *GetSlot(int Table, uint64_t ns)
+{ char *Base = ((char *)Segment) + Segment->Offset[Table];
+  return (SlotHeader *)(Base + ns*Segment->SlotSize[Table]);
+}
+
+/***************************************************************/
+/* fingerprint of the settings that affect record values       */
+/***************************************************************/
+static uint64_t GetSettingsFingerprint()
+{
+  char Buffer[1024];
+  size_t n=snprintf(Buffer, 1024, "V2P0=%i;", RWGGeometry::UseTaylorDuffyV2P0 ? 1 : 0);
+  for(int nv=0; SettingsVariables[nv] && n<1024; nv++)
+   { char *Value=getenv(SettingsVariables[nv]);
+     if (Value)
+      n+=snprintf(Buffer+n, 1024-n, "%s=%s;", SettingsVariables[nv], Value);
+   };
+  return (uint64_t)JenkinsHash(Buffer, strlen(Buffer));
+}
+
+static uint64_t GetPIDNamespace()
+{ struct stat st;
+  if (stat("/proc/self/ns/pid", &st)!=0)
+   return 0;
+  return (uint64_t)st.st_ino;
+}
+
+/***************************************************************/
+/* the segment is initialized by whichever process creates it; */
+/* the others wait for the magic number to appear and then     */
+/* check that the layout matches what they expect.             */
+/***************************************************************/
+static void InitializeSegment(SharedCacheHeader *H, size_t SegmentSize)
+{
+  H->Version     = SHAREDCACHE_VERSION;
+  H->NumTables   = NUMSHAREDCACHETABLES;
+  H->SegmentSize = SegmentSize;
+  H->Clock       = 0;
+  H->PIDNamespace = GetPIDNamespace();
+
+  // divide the segment equally among the tables; the number of
+  // slots in each table is a power of 2
+  size_t Offset = (sizeof(SharedCacheHeader) + 63) & ~((size_t)63);
+  size_t TableBytes = (SegmentSize - Offset) / NUMSHAREDCACHETABLES;
+  for(int nt=0; nt<NUMSHAREDCACHETABLES; nt++)
+   { uint64_t NumSlots=1;
+     while ( 2*NumSlots*GetSlotSize(nt) <= TableBytes )
+      NumSlots*=2;
+     H->Offset[nt]    = Offset;
+     H->NumSlots[nt]  = NumSlots;
+     H->SlotSize[nt]  = GetSlotSize(nt);
+     H->KeySize[nt]   = KeySizes[nt];
+     H->DataSize[nt]  = DataSizes[nt];
+     H->Inserts[nt]   = 0;
+     H->Evictions[nt] = 0;
+     Offset += TableBytes;
+   };
+
+  __atomic_store_n(&(H->Magic), SHAREDCACHE_MAGIC, __ATOMIC_RELEASE);
+}
+
+static bool LayoutMatches(SharedCacheHeader *H)
+{
+  if (H->Version!=SHAREDCACHE_VERSION || H->NumTables!=NUMSHAREDCACHETABLES)
+   return false;
+  for(int nt=0; nt<NUMSHAREDCACHETABLES; nt++)
+   if (H->KeySize[nt]!=KeySizes[nt] || H->DataSize[nt]!=DataSizes[nt])
+    return false;
+  return true;
+}
+
+static void AttachSharedCache()
+{
+  char *Name=getenv("SCUFF_SHARED_CACHE");
+  if (!Name || Name[0]==0)
+   return;
+
+  char SegmentName[256];
+  snprintf(SegmentName, 256, "%s%s", Name[0]=='/' ? "" : "/", Name);
+
+  int SizeMB=DEFAULT_SIZE_MB;
+  CheckEnv("SCUFF_SHARED_CACHE_SIZE", &SizeMB);
+  if (SizeMB<1) SizeMB=1;
+  size_t SegmentSize = ((size_t)SizeMB) << 20;
+
+  /*--------------------------------------------------------------*/
+  /*- try to create the segment; if it already exists, attach to -*/
+  /*- it, taking its size from the segment itself                -*/
+  /*--------------------------------------------------------------*/
+  bool Creator=true;
+  int fd=shm_open(SegmentName, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd==-1)
+   { Creator=false;
+     fd=shm_open(SegmentName, O_RDWR, 0600);
+   };
+  if (fd==-1)
+   { Warn("could not open shared cache %s (continuing without it)",SegmentName);
+     return;
+   };
+
+  if (Creator)
+   { if (ftruncate(fd, SegmentSize)!=0)
+      { Warn("could not size shared cache %s (continuing without it)",SegmentName);
+        close(fd);
+        shm_unlink(SegmentName);
+        return;
+      };
+   }
+  else
+   { // wait for the creator to size the segment
+     struct stat st;
+     for(int ns=0; ns<1000; ns++)
+      { if (fstat(fd,&st)==0 && st.st_size>=(off_t)sizeof(SharedCacheHeader))
+         break;
+        usleep(1000);
+      };
+     if (fstat(fd,&st)!=0 || st.st_size<(off_t)sizeof(SharedCacheHeader))
+      { Warn("shared cache %s is not initialized (continuing without it)",SegmentName);
+        close(fd);
+        return;
+      };
+     SegmentSize=st.st_size;
+   };
+
+  void *Address=mmap(0, SegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (Address==MAP_FAILED)
+   { Warn("could not map shared cache %s (continuing without it)",SegmentName);
+     return;
+   };
+  SharedCacheHeader *H=(SharedCacheHeader *)Address;
+
+  if (Creator)
+   InitializeSegment(H, SegmentSize);
+  else
+   { for(int ns=0; ns<1000; ns++)
+      { if (__atomic_load_n(&(H->Magic), __ATOMIC_ACQUIRE)==SHAREDCACHE_MAGIC)
+         break;
+        usleep(1000);
+      };
+     if (    __atomic_load_n(&(H->Magic), __ATOMIC_ACQUIRE)!=SHAREDCACHE_MAGIC
+          || H->SegmentSize!=SegmentSize
+          || !LayoutMatches(H)
+        )
+      { Warn("shared cache %s has an incompatible layout (continuing without it)",SegmentName);
+        munmap(Address, SegmentSize);
+        return;
+      };
+   };
+
+  Settings=GetSettingsFingerprint();
+  CanReclaim=(H->PIDNamespace!=0 && H->PIDNamespace==GetPIDNamespace());
+  Segment=H;
+  Log("%s shared cache %s (%lu MB, %lu FIPPI / %lu FIBBI slots)",
+       Creator ? "Created" : "Attached to", SegmentName,
+       (unsigned long)(SegmentSize>>20),
+       (unsigned long)H->NumSlots[SHAREDCACHE_FIPPI],
+       (unsigned long)H->NumSlots[SHAREDCACHE_FIBBI]);
+}
+
+static bool SharedCacheAvailable()
+{ pthread_once(&AttachOnce, AttachSharedCache);
+  return Segment!=0;
+}
+
+/***************************************************************/
+/* a sequence word holds the PID of the process that last     */
+/* claimed the slot in its upper 32 bits, and in its lower 32  */
+/* bits a counter that is odd while the slot is being written  */
+/***************************************************************/
+static uint64_t AdvanceSeq(uint64_t Seq, int Steps)
+{ return (((uint64_t)getpid())<<32) | (uint32_t)(Seq+Steps); }
+
+static bool WriterIsDead(uint64_t Seq)
+{ pid_t PID=(pid_t)(Seq>>32);
+  return CanReclaim && PID>0 && kill(PID,0)==-1 && errno==ESRCH;
+}
+
+static uint64_t GetRecordHash(int Table, const void *Key)
+{ uint64_t Hash=(uint64_t)JenkinsHash((const char *)Key, KeySizes[Table]);
+  return Hash ^ (Settings*0x9E3779B97F4A7C15ULL);
+}
+
+/***************************************************************/
+/* wait for a slot that is being written to be published;      */
+/* returns the new sequence number, which is odd if the writer */
+/* died or did not finish within MAXSPINS spins                */
+/***************************************************************/
+static uint64_t WaitForSlot(SlotHeader *S)
+{ uint64_t Seq=__atomic_load_n(&(S->Seq), __ATOMIC_ACQUIRE);
+  for(int ns=0; (Seq&1) && ns<MAXSPINS; ns++)
+   { // check the writer right away, so that on a loaded machine
+     // we don't yield LIVENESSCHECK times before finding it dead
+     if ( (ns%LIVENESSCHECK)==0 && WriterIsDead(Seq) )
+      break;
+     sched_yield();
+     Seq=__atomic_load_n(&(S->Seq), __ATOMIC_ACQUIRE);
+   };
+  return Seq;
+}
+
+/***************************************************************/
+/* claim a slot left half-written (sequence number Seq) by a   */
+/* process that has since died; on success, *Seq is updated to */
+/* the (odd) sequence number of our claim.                     */
+/***************************************************************/
+static bool ReclaimSlot(SlotHeader *S, uint64_t *Seq)
+{ 
+  if ( ((*Seq)&1)==0 || !WriterIsDead(*Seq) )
+   return false;
+  uint64_t Claimed=AdvanceSeq(*Seq, 2);
+  if (!__atomic_compare_exchange_n(&(S->Seq), Seq, Claimed, false,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+   return false;
+  *Seq=Claimed;
+  return true;
+}
+
+/***************************************************************/
+/* fill in a slot we have claimed (sequence number Seq) and    */
+/* publish it. if Key is NULL, the slot is left as a tombstone */
+/* that matches no key and is the first to be evicted.        */
+/***************************************************************/
+static void WriteSlot(int Table, SlotHeader *S, uint64_t Seq,
+                      uint64_t Hash, uint64_t Stamp,
+                      const void *Key, const void *Data)
+{
+  size_t KeySize=KeySizes[Table], DataSize=DataSizes[Table];
+  char *SKey=(char *)(S+1), *SData=SKey+KeySize;
+  S->Hash=Hash;
+  S->Stamp=Stamp;
+  S->Settings=Settings;
+  if (Key)
+   { memcpy(SKey, Key, KeySize);
+     memcpy(SData, Data, DataSize);
+   }
+  else
+   memset(SKey, 0xFF, KeySize); // NaN bit patterns; no real key matches
+  __atomic_store_n(&(S->Seq), AdvanceSeq(Seq, 1), __ATOMIC_RELEASE);
+}
+
+/***************************************************************/
+/* look up a record; on success, copy its data into Data and   */
+/* return true.                                                */
+/***************************************************************/
+bool SharedCacheLookup(int Table, const void *Key, void *Data)
+{
+  if (!SharedCacheAvailable())
+   return false;
+
+  size_t KeySize=KeySizes[Table], DataSize=DataSizes[Table];
+  uint64_t Hash=GetRecordHash(Table, Key);
+  uint64_t Mask=Segment->NumSlots[Table]-1;
+
+  char KeyBuffer[256];
+  for(int np=0; np<MAXPROBE; np++)
+   {
+     SlotHeader *S=GetSlot(Table, (Hash+np)&Mask);
+     char *SKey=(char *)(S+1), *SData=SKey+KeySize;
+
+     for(int Retry=0; Retry<3; Retry++)
+      { uint64_t Seq1=WaitForSlot(S);
+        if (Seq1==0) return false;  // empty slot terminates the probe
+        if (Seq1&1)
+         { // abandoned or slow writer: tombstone the slot if its
+           // writer is dead, and skip it either way
+           if (ReclaimSlot(S, &Seq1))
+            WriteSlot(Table, S, Seq1, 0, 0, 0, 0);
+           break;
+         };
+        if (S->Hash!=Hash) break;
+
+        memcpy(KeyBuffer, SKey, KeySize);
+        memcpy(Data, SData, DataSize);
+        uint64_t SSettings=S->Settings;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&(S->Seq), __ATOMIC_RELAXED)!=Seq1)
+         continue; // slot was overwritten while we read it
+
+        if (SSettings!=Settings || memcmp(KeyBuffer, Key, KeySize))
+         break;
+        __atomic_store_n(&(S->Stamp),
+                         __atomic_load_n(&(Segment->Clock), __ATOMIC_RELAXED),
+                         __ATOMIC_RELAXED);
+        return true;
+      };
+   };
+
+  return false;
+}
+
+/***************************************************************/
+/* insert a record unless a record with the same key is        */
+/* already present                                             */
+/***************************************************************/
+void SharedCacheInsert(int Table, const void *Key, const void *Data)
+{
+  if (!SharedCacheAvailable())
+   return;
+
+  size_t KeySize=KeySizes[Table];
+  uint64_t Hash=GetRecordHash(Table, Key);
+  uint64_t Mask=Segment->NumSlots[Table]-1;
+  uint64_t Stamp=__atomic_add_fetch(&(Segment->Clock), 1, __ATOMIC_RELAXED);
+
+  SlotHeader *Victim=0;
+  uint64_t VictimSeq=0, VictimStamp=0;
+  for(int np=0; np<MAXPROBE; np++)
+   {
+     SlotHeader *S=GetSlot(Table, (Hash+np)&Mask);
+     char *SKey=(char *)(S+1);
+
+     uint64_t Seq=WaitForSlot(S);
+     if (Seq==0)
+      { uint64_t Expected=0, Claimed=AdvanceSeq(0, 1);
+        if (__atomic_compare_exchange_n(&(S->Seq), &Expected, Claimed, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+         { WriteSlot(Table, S, Claimed, Hash, Stamp, Key, Data);
+           __atomic_add_fetch(&(Segment->Inserts[Table]), 1, __ATOMIC_RELAXED);
+           return;
+         };
+        // another process claimed the slot first; fall through
+        // to see whether it inserted the same key
+        Seq=WaitForSlot(S);
+      };
+     if (Seq&1)
+      { if (ReclaimSlot(S, &Seq))
+         { WriteSlot(Table, S, Seq, Hash, Stamp, Key, Data);
+           __atomic_add_fetch(&(Segment->Inserts[Table]), 1, __ATOMIC_RELAXED);
+           return;
+         };
+        continue;
+      };
+
+     if (    S->Hash==Hash && S->Settings==Settings 
+          && !memcmp(SKey, Key, KeySize)
+        )
+      return; // already present
+
+     if (Victim==0 || S->Stamp < VictimStamp)
+      { Victim=S;
+        VictimSeq=Seq;
+        VictimStamp=S->Stamp;
+      };
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- all probed slots hold other keys: overwrite the least      -*/
+  /*- recently used one, unless someone else got to it first     -*/
+  /*--------------------------------------------------------------*/
+  if (Victim==0)
+   return;
+  uint64_t Claimed=AdvanceSeq(VictimSeq, 1);
+  if (!__atomic_compare_exchange_n(&(Victim->Seq), &VictimSeq, Claimed,
+                                   false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+   return;
+  WriteSlot(Table, Victim, Claimed, Hash, Stamp, Key, Data);
+  __atomic_add_fetch(&(Segment->Evictions[Table]), 1, __ATOMIC_RELAXED);
+}
+
+/***************************************************************/
+/* write a one-line summary of the shared cache to the log     */
+/***************************************************************/
+void LogSharedCacheStatistics()
+{
+  if (Segment==0) return;
+  for(int nt=0; nt<NUMSHAREDCACHETABLES; nt++)
+   Log("Shared %s cache: %lu slots, %lu insertions, %lu evictions (all processes)",
+        TableNames[nt],
+        (unsigned long)Segment->NumSlots[nt],
+        (unsigned long)__atomic_load_n(&(Segment->Inserts[nt]), __ATOMIC_RELAXED),
+        (unsigned long)__atomic_load_n(&(Segment->Evictions[nt]), __ATOMIC_RELAXED));
+}
+
+} // namespace scuff
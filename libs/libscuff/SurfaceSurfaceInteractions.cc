@@ -95,11 +95,36 @@ int CountCommonRegions(RWGSurface *Sa, RWGSurface *Sb,
 typedef struct ThreadData
  { 
    GetSSIArgStruct *Args;
-   unsigned PPIAlgorithmCount[NUMPPIALGORITHMS];
+   PPIStatistics PPIStats;
    int nt, NumTasks;
 
  } ThreadData;
 
+/***************************************************************/
+/* range [ne0, ne1) of the edges of S whose basis functions    */
+/* overlap the range BFRange (or all edges if BFRange is unset)*/
+/***************************************************************/
+static void GetEdgeRange(RWGSurface *S, int BFRange[2], int *ne0, int *ne1)
+{
+  if (BFRange[1]<0)
+   { *ne0=0; *ne1=S->NumEdges; return; }
+  int BFsPerEdge = S->IsPEC ? 1 : 2;
+  *ne0 = BFRange[0] / BFsPerEdge;
+  *ne1 = (BFRange[1] + BFsPerEdge - 1) / BFsPerEdge;
+}
+
+/***************************************************************/
+/* add an entry to B unless it lies outside the requested      */
+/* block of rows and columns                                   */
+/***************************************************************/
+static inline void AddBEntry(HMatrix *B, int X, int Y, cdouble Entry,
+                             int XRange[2], int YRange[2])
+{
+  if ( X<XRange[0] || X>=XRange[1] || Y<YRange[0] || Y>=YRange[1] )
+   return;
+  B->AddEntry(X, Y, Entry);
+}
+
 /***************************************************************/
 /* 'GetSurfaceSurfaceInteractionThread'                        */
 /***************************************************************/
@@ -149,6 +174,7 @@ void *GSSIThread(void *data)
   GetEEIArgs->NumTorqueAxes=NumTorqueAxes;
   GetEEIArgs->GammaMatrix=GammaMatrix;
   GetEEIArgs->Displacement=Displacement;
+  GetEEIArgs->TimePPIs = (G->LogLevel>=SCUFF_VERBOSELOGGING) || ProfileEnabled();
 
   /* pointers to arrays inside the structure */
   cdouble *GC=GetEEIArgs->GC;
@@ -178,20 +204,49 @@ void *GSSIThread(void *data)
   /***************************************************************/
   /* loop over all internal edges on both objects.               */
   /***************************************************************/
-  int nea, NEa=Sa->NumEdges;
-  int neb, NEb=Sb->NumEdges;
+  int nea, NEa=Sa->NumEdges, neaMin, neaMax;
+  int neb, NEb=Sb->NumEdges, nebMin, nebMax;
+  GetEdgeRange(Sa, Args->BFRangeA, &neaMin, &neaMax);
+  GetEdgeRange(Sb, Args->BFRangeB, &nebMin, &nebMax);
+
+  // rows and columns of B that we may write; edges at the ends
+  // of the edge ranges may carry basis functions outside them
+  int XRange[2]={RowOffset, RowOffset+Sa->NumBFs};
+  int YRange[2]={ColOffset, ColOffset+Sb->NumBFs};
+  if (Args->BFRangeA[1]>=0)
+   { XRange[0]=RowOffset+Args->BFRangeA[0]; XRange[1]=RowOffset+Args->BFRangeA[1]; }
+  if (Args->BFRangeB[1]>=0)
+   { YRange[0]=ColOffset+Args->BFRangeB[0]; YRange[1]=ColOffset+Args->BFRangeB[1]; }
   int X, Y, Mu, nt=0;
   int NumGradientComponents = GradB ? 3 : 0;
   int nebStart = Symmetric ? 1 : 0;
-  for(nea=0; nea<NEa; nea++)
-   for(neb=nebStart*nea; neb<NEb; neb++)
+
+  /***************************************************************/
+  /* when computing the full block, visit the edges of each      */
+  /* surface in the Morton order of their centroids, so that     */
+  /* consecutive edge pairs touch nearby panels (and nearby      */
+  /* entries of the packed mesh arrays and the FIPPI cache).     */
+  /* in the symmetric case we still visit each unordered pair    */
+  /* exactly once, with nea<=neb.                                */
+  /***************************************************************/
+  bool FullBlock = (neaMin==0 && neaMax==NEa && nebMin==0 && nebMax==NEb);
+  int *OrderA = FullBlock ? Sa->Packed->EdgeOrder : 0;
+  int *OrderB = FullBlock ? Sb->Packed->EdgeOrder : 0;
+  int ia, ib;
+  for(ia=neaMin; ia<neaMax; ia++)
+   for(ib=(nebStart*ia > nebMin ? nebStart*ia : nebMin); ib<nebMax; ib++)
     { 
       nt++;
       if (nt==TD->NumTasks) nt=0;
       if (nt!=TD->nt) continue;
 
-      if (G->LogLevel>=SCUFF_VERBOSE2 && (neb==nebStart*nea) )
-       LogPercent(nea, NEa);
+      if (G->LogLevel>=SCUFF_VERBOSE2 && (ib==nebStart*ia) )
+       LogPercent(ia-neaMin, neaMax-neaMin);
+
+      nea = OrderA ? OrderA[ia] : ia;
+      neb = OrderB ? OrderB[ib] : ib;
+      if (Symmetric && nea>neb)
+       { int Temp=nea; nea=neb; neb=Temp; }
 
       /*--------------------------------------------------------------*/
       /*- contributions of first medium (EpsA, MuA)  -----------------*/
@@ -207,7 +262,7 @@ void *GSSIThread(void *data)
          X=RowOffset + nea;
          Y=ColOffset + neb;  
 
-         B->AddEntry( X, Y, PreFac1A*GC[0] );
+         AddBEntry(B, X, Y, PreFac1A*GC[0], XRange, YRange);
 
          for(Mu=0; Mu<NumGradientComponents; Mu++)
           if (GradB[Mu]) GradB[Mu]->AddEntry( X, Y, PreFac1A*GradGC[2*Mu+0]);
@@ -221,8 +276,8 @@ void *GSSIThread(void *data)
          X=RowOffset + nea;
          Y=ColOffset + 2*neb;  
 
-         B->AddEntry( X, Y,   PreFac1A*GC[0] );
-         B->AddEntry( X, Y+1, PreFac2A*GC[1] );
+         AddBEntry(B, X, Y,   PreFac1A*GC[0], XRange, YRange);
+         AddBEntry(B, X, Y+1, PreFac2A*GC[1], XRange, YRange);
 
          for(Mu=0; Mu<NumGradientComponents; Mu++)
           { if (!GradB[Mu]) continue;
@@ -240,8 +295,8 @@ void *GSSIThread(void *data)
          X=RowOffset + 2*nea;
          Y=ColOffset + neb;  
 
-         B->AddEntry( X,   Y, PreFac1A*GC[0] );
-         B->AddEntry( X+1, Y, PreFac2A*GC[1] );
+         AddBEntry(B, X,   Y, PreFac1A*GC[0], XRange, YRange);
+         AddBEntry(B, X+1, Y, PreFac2A*GC[1], XRange, YRange);
 
          for(Mu=0; Mu<NumGradientComponents; Mu++)
           { if (!GradB[Mu]) continue;
@@ -259,11 +314,11 @@ void *GSSIThread(void *data)
          X=RowOffset + 2*nea;
          Y=ColOffset + 2*neb;
 
-         B->AddEntry( X, Y,   PreFac1A*GC[0]);
-         B->AddEntry( X, Y+1, PreFac2A*GC[1]);
+         AddBEntry(B, X, Y,   PreFac1A*GC[0], XRange, YRange);
+         AddBEntry(B, X, Y+1, PreFac2A*GC[1], XRange, YRange);
          if ( !Symmetric || (nea!=neb) )
-          B->AddEntry( X+1, Y, PreFac2A*GC[1]);
-         B->AddEntry( X+1, Y+1, PreFac3A*GC[0]);
+          AddBEntry(B, X+1, Y, PreFac2A*GC[1], XRange, YRange);
+         AddBEntry(B, X+1, Y+1, PreFac3A*GC[0], XRange, YRange);
 
          for(Mu=0; Mu<NumGradientComponents; Mu++)
           { 
@@ -300,11 +355,11 @@ void *GSSIThread(void *data)
          X=RowOffset + 2*nea;
          Y=ColOffset + 2*neb;
 
-         B->AddEntry( X, Y,   PreFac1B*GC[0]);
-         B->AddEntry( X, Y+1, PreFac2B*GC[1]);
+         AddBEntry(B, X, Y,   PreFac1B*GC[0], XRange, YRange);
+         AddBEntry(B, X, Y+1, PreFac2B*GC[1], XRange, YRange);
          if ( !Symmetric || (nea!=neb) )
-          B->AddEntry( X+1, Y, PreFac2B*GC[1]);
-         B->AddEntry( X+1, Y+1, PreFac3B*GC[0]);
+          AddBEntry(B, X+1, Y, PreFac2B*GC[1], XRange, YRange);
+         AddBEntry(B, X+1, Y+1, PreFac3B*GC[0], XRange, YRange);
 
          for(Mu=0; Mu<NumGradientComponents; Mu++)
           { 
@@ -328,7 +383,7 @@ void *GSSIThread(void *data)
 
     }; // for(nea=0; nea<NEa; nea++), for(neb=nebStart*nea; neb<NEb; neb++) ... 
 
-  memcpy(TD->PPIAlgorithmCount, GetEEIArgs->PPIAlgorithmCount, NUMPPIALGORITHMS*sizeof(unsigned));
+  TD->PPIStats = GetEEIArgs->PPIStats;
   return 0;
 
 }
@@ -352,71 +407,101 @@ void AddSurfaceZetaContributionToBEMMatrix(GetSSIArgStruct *Args)
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   HMatrix *B    = Args->B;
-  int Offset    = Args->RowOffset;
-
-  if (Offset!=Args->ColOffset)
+  int RowOffset = Args->RowOffset;
+  int ColOffset = Args->ColOffset;
+
+  // if only a sub-block of the matrix was requested, we visit
+  // every (Alpha,Beta) pair in the sub-block instead of using
+  // symmetry to fill in the lower triangle. (only PEC surfaces
+  // get zeta contributions, so basis functions are edges here.)
+  bool FullBlock = (Args->BFRangeA[1]<0 && Args->BFRangeB[1]<0);
+  int AlphaMin = 0, AlphaMax = S->NumEdges;
+  int BetaMin  = 0, BetaMax  = S->NumEdges;
+  if (Args->BFRangeA[1]>=0)
+   { AlphaMin = Args->BFRangeA[0]; AlphaMax = Args->BFRangeA[1]; }
+  if (Args->BFRangeB[1]>=0)
+   { BetaMin = Args->BFRangeB[0]; BetaMax = Args->BFRangeB[1]; }
+
+  if (FullBlock && RowOffset!=ColOffset)
    ErrExit("%s:%i: internal error",__FILE__,__LINE__);
 
   /*--------------------------------------------------------------*/
+  /*- first pass: collect the (Alpha,Beta) pairs with nonzero    -*/
+  /*- overlap, which can only be pairs of edges sharing a panel, -*/
+  /*- together with the point at which to evaluate the surface   -*/
+  /*- impedance for each pair: the centroid of the common panel   -*/
+  /*- (if there was only one common panel) or of the common edge  -*/
+  /*- (if there were two common panels).                          -*/
   /*--------------------------------------------------------------*/
-  /*--------------------------------------------------------------*/
-  int neAlpha, neBeta;
-  double Overlap;
-  for(neAlpha=0; neAlpha<S->NumEdges; neAlpha++)
-   for(neBeta=neAlpha; neBeta<S->NumEdges; neBeta++)
-    { 
-      Overlap=S->GetOverlap(neAlpha, neBeta);
-      if (Overlap==0.0) continue;
-
-      // if there was a nonzero overlap, get the value
-      // of the dimensionless surface impedance at the centroid
-      // of the common panel (if there was only one common panel)
-      // or of the common edge if there were two common panels.
-      RWGEdge *EAlpha = S->Edges[neAlpha];
-      RWGEdge *EBeta  = S->Edges[neBeta];
-      double *X = EAlpha->Centroid;
-      if (neAlpha==neBeta)
-       {
+  int MaxPairs = 5*(AlphaMax - AlphaMin);
+  int *PairIndices   = (int *)mallocEC(2*MaxPairs*sizeof(int));
+  double *Overlaps   = (double *)mallocEC(MaxPairs*sizeof(double));
+  double *PairPoints = (double *)mallocEC(3*MaxPairs*sizeof(double));
+  int NumPairs=0;
+  for(int neAlpha=AlphaMin; neAlpha<AlphaMax; neAlpha++)
+   { 
+     int nebArray[5];
+     int nebCount=GetOverlappingEdgeIndices(S, neAlpha, nebArray);
+     for(int nn=0; nn<nebCount; nn++)
+      { 
+        int neBeta=nebArray[nn];
+        if (FullBlock && neBeta<neAlpha) continue;
+        if (!FullBlock && (neBeta<BetaMin || neBeta>=BetaMax)) continue;
+
+        double Overlap=S->GetOverlap(neAlpha, neBeta);
+        if (Overlap==0.0) continue;
+
+        RWGEdge *EAlpha = S->Edges[neAlpha];
+        RWGEdge *EBeta  = S->Edges[neBeta];
+        double *X = EAlpha->Centroid;
+        if (neAlpha==neBeta)
          X = EAlpha->Centroid;
-       }
-      else if (    EAlpha->iPPanel==EBeta->iPPanel 
-                || EAlpha->iPPanel==EBeta->iMPanel 
-              )
-       {
-        X = S->Panels[EAlpha->iPPanel]->Centroid;
-       }
-      else if ( (EAlpha->iMPanel!=-1) && 
-                (    (EAlpha->iMPanel==EBeta->iPPanel) 
-                  || (EAlpha->iMPanel==EBeta->iMPanel) 
+        else if (    EAlpha->iPPanel==EBeta->iPPanel 
+                  || EAlpha->iPPanel==EBeta->iMPanel 
+                )
+         X = S->Panels[EAlpha->iPPanel]->Centroid;
+        else if ( (EAlpha->iMPanel!=-1) && 
+                  (    (EAlpha->iMPanel==EBeta->iPPanel) 
+                    || (EAlpha->iMPanel==EBeta->iMPanel) 
+                  ) 
                 ) 
-              ) 
-       {
          X = S->Panels[EAlpha->iMPanel]->Centroid;
-       };
-
-
-      char *ParmNames[4]={ const_cast<char *>("w"), 
-                           const_cast<char *>("x"), 
-                           const_cast<char *>("y"), 
-                           const_cast<char *>("z") 
-                         };
-      cdouble ParmValues[4];
-      ParmValues[0] = Args->Omega*MatProp::FreqUnit;
-      ParmValues[1] = X[0];
-      ParmValues[2] = X[1];
-      ParmValues[3] = X[2];
-      cdouble Zeta=cevaluator_evaluate(S->SurfaceZeta, 4, ParmNames, ParmValues);
-
-      if (neAlpha==0 && neBeta==neAlpha)
-       Log("Zeta = %s ",CD2S(Zeta));
-
-      if ( S->IsPEC )
-       { B->AddEntry(Offset+neAlpha, Offset+neBeta, -1.0*Zeta*Overlap);
-         if (neAlpha!=neBeta)
-          B->AddEntry(Offset+neBeta, Offset+neAlpha, -1.0*Zeta*Overlap);
-       };
-      
-    };
+
+        PairIndices[2*NumPairs+0]=neAlpha;
+        PairIndices[2*NumPairs+1]=neBeta;
+        Overlaps[NumPairs]=Overlap;
+        memcpy(PairPoints + 3*NumPairs, X, 3*sizeof(double));
+        NumPairs++;
+      };
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- second pass: evaluate the surface impedance at all points  -*/
+  /*- in a single batch and stamp the contributions into B       -*/
+  /*--------------------------------------------------------------*/
+  cdouble *Zetas = (cdouble *)mallocEC((NumPairs+1)*sizeof(cdouble));
+  S->GetSurfaceZeta(Args->Omega, NumPairs, PairPoints, Zetas);
+
+  for(int np=0; np<NumPairs; np++)
+   { 
+     int neAlpha=PairIndices[2*np+0], neBeta=PairIndices[2*np+1];
+     cdouble Zeta=Zetas[np];
+     double Overlap=Overlaps[np];
+
+     if (neAlpha==0 && neBeta==neAlpha)
+      Log("Zeta = %s ",CD2S(Zeta));
+
+     if ( S->IsPEC )
+      { B->AddEntry(RowOffset+neAlpha, ColOffset+neBeta, -1.0*Zeta*Overlap);
+        if (FullBlock && neAlpha!=neBeta)
+         B->AddEntry(RowOffset+neBeta, ColOffset+neAlpha, -1.0*Zeta*Overlap);
+      };
+   };
+
+  free(PairIndices);
+  free(Overlaps);
+  free(PairPoints);
+  free(Zetas);
 
 }
 
@@ -430,12 +515,6 @@ void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args)
   RWGSurface  *Sa = Args->Sa;
   RWGSurface  *Sb = Args->Sb;
 
-  /*--------------------------------------------------------------*/
-  /*- make sure the cached epsilon and mu values for all regions  */
-  /*- are up-to-date for the present frequency                    */
-  /*--------------------------------------------------------------*/
-  G->UpdateCachedEpsMuValues(Omega);
-
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
   /*--------------------------------------------------------------*/
@@ -465,12 +544,15 @@ void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args)
   if (NumCommonRegions==0)
    return;
 
-  Args->EpsA  = G->EpsTF[ CommonRegions[0] ];
-  Args->MuA   = G->MuTF[  CommonRegions[0] ];
+  /*--------------------------------------------------------------*/
+  /*- note: material properties are fetched directly here rather  */
+  /*- than from the geometry's EpsTF/MuTF arrays, which would be  */
+  /*- clobbered by a simultaneous call at a different frequency   */
+  /*--------------------------------------------------------------*/
+  G->RegionMPs[ CommonRegions[0] ]->GetEpsMu(Omega, &(Args->EpsA), &(Args->MuA));
   Args->SignA = Signs[0];
   if ( NumCommonRegions==2 )
-   { Args->EpsB = G->EpsTF[ CommonRegions[1] ];
-     Args->MuB  = G->MuTF[  CommonRegions[1] ];
+   { G->RegionMPs[ CommonRegions[1] ]->GetEpsMu(Omega, &(Args->EpsB), &(Args->MuB));
      Args->SignB = Signs[1];
    }
   else
@@ -494,11 +576,14 @@ void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args)
   /***************************************************************/
   /* fire off threads ********************************************/
   /***************************************************************/
-  GlobalFIPPICache.Hits=GlobalFIPPICache.Misses=0;
+  // the FIPPI cache counters are cumulative and shared by all
+  // callers, so we report the change over this call rather than
+  // resetting them (which would disturb simultaneous callers)
+  int FIPPIHits0=GlobalFIPPICache.Hits, FIPPIMisses0=GlobalFIPPICache.Misses;
 
   int nt, NumTasks, NumThreads = GetNumThreads();
-  unsigned PPIAlgorithmCount[NUMPPIALGORITHMS];  
-  memset(PPIAlgorithmCount, 0, NUMPPIALGORITHMS*sizeof(unsigned));
+  PPIStatistics PPIStats;
+  InitPPIStatistics(&PPIStats);
 
 #ifdef USE_PTHREAD
   ThreadData *TDs = new ThreadData[NumThreads], *TD;
@@ -515,10 +600,9 @@ void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args)
        pthread_create( &(Threads[nt]), 0, GSSIThread, (void *)TD);
    }
   for(nt=0; nt<NumThreads-1; nt++)
-   { pthread_join(Threads[nt],0);
-     for(int n=0; n<NUMPPIALGORITHMS; n++)
-      PPIAlgorithmCount[n] += TD->PPIAlgorithmCount[n];
-   };
+   pthread_join(Threads[nt],0);
+  for(nt=0; nt<NumThreads; nt++)
+   AddPPIStatistics(&PPIStats, &(TDs[nt].PPIStats));
   delete[] Threads;
   delete[] TDs;
 
@@ -529,8 +613,13 @@ void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args)
    Log(" no multithreading...");
 #else
   NumTasks=NumThreads*100;
-  if (NumTasks>Sa->NumEdges) 
-   NumTasks=Sa->NumEdges;
+  int neaMin, neaMax;
+  GetEdgeRange(Sa, Args->BFRangeA, &neaMin, &neaMax);
+  int NumEdgesA = neaMax - neaMin;
+  if (NumTasks>NumEdgesA) 
+   NumTasks=NumEdgesA;
+  if (NumTasks<1)
+   NumTasks=1;
   if (G->LogLevel>=SCUFF_VERBOSE2)
    Log(" OpenMP multithreading (%i threads,%i tasks)...",NumThreads,NumTasks);
 #pragma omp parallel for schedule(dynamic,1), num_threads(NumThreads)
@@ -542,19 +631,25 @@ void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args)
      TD1.NumTasks=NumTasks;
      TD1.Args=Args;
      GSSIThread((void *)&TD1);
-     for(int n=0; n<NUMPPIALGORITHMS; n++)
-      PPIAlgorithmCount[n] += TD1.PPIAlgorithmCount[n];
+#ifdef USE_OPENMP
+#pragma omp critical(PPIStatistics)
+#endif
+     AddPPIStatistics(&PPIStats, &(TD1.PPIStats));
    };
 #endif
 
   if (G->LogLevel>=SCUFF_VERBOSE2)
-   { Log("  %i/%i cache hits/misses",GlobalFIPPICache.Hits,GlobalFIPPICache.Misses);
-     Log("  PPIs: LOC(%u), HOC(%u), TD(%u), HK(%u), D(%u)",
-            PPIAlgorithmCount[PPIALG_LOCUBATURE],
-            PPIAlgorithmCount[PPIALG_HOCUBATURE],
-            PPIAlgorithmCount[PPIALG_TD],
-            PPIAlgorithmCount[PPIALG_HKTD],
-            PPIAlgorithmCount[PPIALG_DESING]);
+   Log("  %i/%i cache hits/misses",GlobalFIPPICache.Hits-FIPPIHits0,
+                                     GlobalFIPPICache.Misses-FIPPIMisses0);
+  if (ProfileEnabled())
+   { ProfileCount("FIPPICache.Hits",   GlobalFIPPICache.Hits-FIPPIHits0);
+     ProfileCount("FIPPICache.Misses", GlobalFIPPICache.Misses-FIPPIMisses0);
+     ProfilePPIStatistics(&PPIStats);
+   };
+  if (G->LogLevel>=SCUFF_VERBOSELOGGING)
+   { char Label[200];
+     snprintf(Label, 200, "%s,%s", Sa->Label, Sb->Label);
+     LogPPIStatistics(&PPIStats, Label);
    };
 
   /***************************************************************/
@@ -568,16 +663,26 @@ void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args)
   /* we have only computed the upper triangle, so now we need to */
   /* fill in the lower triangle. The exception is if the matrix  */
   /* uses packed storage, in which case only the upper triangle  */
-  /* is stored anyway.                                           */
+  /* is stored anyway. (If only a tile of the block was          */
+  /* requested, we fill in the lower triangle of the tile.)      */
   /***************************************************************/
   if ( Args->Symmetric && (Args->B->StorageType==LHM_NORMAL) )
    { 
      if (G->LogLevel>=SCUFF_VERBOSE2)
       Log("Handling symmetry...");
-     int N=Args->B->NR;
-     for(int nr=1; nr<N; nr++)
-      for(int nc=0; nc<nr; nc++)
-       Args->B->SetEntry(nr,nc,Args->B->GetEntry(nc,nr));
+     HMatrix *B=Args->B;
+     if (Args->BFRangeA[1]<0)
+      { int N=B->NR;
+        for(int nr=1; nr<N; nr++)
+         for(int nc=0; nc<nr; nc++)
+          B->SetEntry(nr,nc,B->GetEntry(nc,nr));
+      }
+     else
+      { int RowOffset=Args->RowOffset, ColOffset=Args->ColOffset;
+        for(int n1=Args->BFRangeA[0]+1; n1<Args->BFRangeA[1]; n1++)
+         for(int n2=Args->BFRangeA[0]; n2<n1; n2++)
+          B->SetEntry(RowOffset+n1, ColOffset+n2, B->GetEntry(RowOffset+n2, ColOffset+n1));
+      };
      if (G->LogLevel>=SCUFF_VERBOSE2)
       Log("...done with symmetry...");
    };
@@ -703,6 +808,9 @@ void InitGetSSIArgs(GetSSIArgStruct *Args)
 
   Args->Accumulate=false;
 
+  Args->BFRangeA[0]=Args->BFRangeA[1]=-1;
+  Args->BFRangeB[0]=Args->BFRangeB[1]=-1;
+
 }
 
 } // namespace scuff
@@ -0,0 +1,1146 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * UBlockCache.cc -- reuse of off-diagonal BEM matrix blocks over
+ *                -- the course of a geometrical transformation sweep
+ *
+ * The off-diagonal block U(a,b) depends only on the relative pose
+ * T_a^{-1} T_b of the two surfaces (here T_a is the transformation
+ * applied to surface a since it was read in), so it does not
+ * change when both surfaces are moved by a common motion C that
+ * commutes with the environment: any rigid motion in a homogeneous
+ * medium, translations in periodic geometries, and in-plane
+ * translations and rotations about the z axis above a substrate.
+ *
+ * If instead the relative pose differs from that of a stored block
+ * by a rotation S of one surface that maps its mesh onto itself,
+ * the new block differs from the stored one only by a signed
+ * permutation of that surface's RWG functions: if edge n of b lies
+ * where edge s(n) lay before, with its QP/QM vertices preserved
+ * (sign +1) or swapped (sign -1), then U(m,n) = sign(n)*U0(m,s(n)).
+ *
+ * Finally, if the relative pose varies over the sweep only by a
+ * displacement s along a fixed direction, the block is a smooth
+ * function of s that we interpolate from its values at a few
+ * Chebyshev nodes (see PlanSeparationInterpolation below).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+
+#define DEFAULT_UBC_MEMORY 512 // megabytes
+#define II cdouble(0,1)
+
+namespace scuff {
+
+void InitRWGPanel(RWGPanel *P, double *Vertices);
+
+/***************************************************************/
+/* a UBCEntry describes the poses of the two surfaces for which*/
+/* a block was computed. stored entries own a copy of the      */
+/* block and its derivatives; the record of what is currently  */
+/* in the caller's buffer has U=0.                             */
+/***************************************************************/
+typedef struct UBCEntry
+ { GTransformation GTa, GTb;
+   HMatrix *U, **dU;
+   int NumdU;
+   unsigned dUMask;   // bit Mu set iff dU[Mu] is present
+   unsigned long LastUsed;
+   size_t Bytes;
+ } UBCEntry;
+
+/***************************************************************/
+/* per-surface data needed to look for mesh symmetries: vertex */
+/* coordinates before any transformation, their centroid and   */
+/* bounding-box diagonal, the vertices used by panels sorted   */
+/* by x coordinate, and a sorted table of edges keyed by their */
+/* vertex pairs.                                               */
+/***************************************************************/
+typedef std::pair<long, int> EdgeKey;
+
+typedef struct UBCSurface
+ { double *RestVertices;
+   int *SortedVertices, NumUsedVertices;
+   double Centroid[3], Extent, Tol;
+   EdgeKey *EdgeKeys;
+   bool Usable;  // true if symmetry permutations may be used
+ } UBCSurface;
+
+/***************************************************************/
+/* an SIPlan describes a pair of surfaces whose relative pose  */
+/* over a transformation sweep differs from Rel0 only by       */
+/* displacements s*u, sMin <= s <= sMax, along a fixed unit    */
+/* vector u in the frame of the first surface; at each         */
+/* frequency it holds the Chebyshev expansion in s of the      */
+/* block and its displacement derivatives.                     */
+/*                                                             */
+/* each expansion coefficient is stored either densely (C[k]) */
+/* or as a truncated SVD C[k] = W(:,Offset[k]:Offset[k+1]-1)   */
+/*                         * VT(Offset[k]:Offset[k+1]-1,:)     */
+/***************************************************************/
+#define SI_MAXDU 3  // only dU[0..2] (d/dx, d/dy, d/dz) are interpolated
+
+typedef struct SICoeffs
+ { int NumTerms;
+   HMatrix **C;
+   HMatrix *W, *VT;
+   int *Offset;
+ } SICoeffs;
+
+typedef struct SIPlan
+ { GTransformation Rel0;
+   double u[3], sMin, sMax;
+   double XA[3], XB0[3];      // centroids of a and (at s=0) b in the frame of a
+   int NumNodes;
+   double Tol;
+
+   // frequency-dependent data, built on first use
+   bool Built, Usable;
+   GTransformation GTaBuild;  // pose of surface a when the table was built
+   unsigned dUMask;
+   cdouble k;                 // wavenumber in the medium common to a and b
+   SICoeffs Coeffs[1+SI_MAXDU];
+ } SIPlan;
+
+// orders vertex indices by x coordinate
+struct XCompare
+ { double *V;
+   XCompare(double *_V) : V(_V) {}
+   bool operator()(int i, int j) const { return V[3*i] < V[3*j]; }
+ };
+
+static GTransformation GetPose(RWGSurface *S)
+{ return S->GT ? GTransformation(S->GT) : GTransformation(); }
+
+static size_t BlockBytes(HMatrix *M)
+{ return M->NumEntries() * (M->RealComplex==LHM_REAL ? sizeof(double) : sizeof(cdouble)); }
+
+static unsigned GetdUMask(HMatrix **dU, int NumdU)
+{ unsigned Mask=0;
+  for(int Mu=0; dU && Mu<NumdU; Mu++)
+   if (dU[Mu]) Mask |= (1U<<Mu);
+  return Mask;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+UBlockCache::UBlockCache(RWGGeometry *_G)
+{
+  G=_G;
+  NS=G->NumSurfaces;
+
+  Stored = new std::vector<UBCEntry *>[NS*NS];
+  InBuffer = (UBCEntry **)mallocEC(NS*NS*sizeof(UBCEntry *));
+  SurfaceData = (UBCSurface **)mallocEC(NS*sizeof(UBCSurface *));
+  SIPlans = (SIPlan **)mallocEC(NS*NS*sizeof(SIPlan *));
+  Omega = 0.0;
+
+  int MaxMB=DEFAULT_UBC_MEMORY;
+  CheckEnv("SCUFF_UBLOCK_CACHE_MEMORY", &MaxMB);
+  MaxBytes = ((size_t)MaxMB) * 1048576;
+  Bytes=0;
+  Clock=0;
+
+  NumHits=NumSymmetryHits=NumInterpolationHits=NumMisses=0;
+}
+
+UBlockCache::~UBlockCache()
+{
+  Clear(Omega);
+  for(int np=0; np<NS*NS; np++)
+   if (InBuffer[np]) delete InBuffer[np];
+  free(InBuffer);
+  delete[] Stored;
+
+  for(int ns=0; ns<NS; ns++)
+   { UBCSurface *SD=SurfaceData[ns];
+     if (!SD) continue;
+     if (SD->RestVertices) free(SD->RestVertices);
+     if (SD->SortedVertices) free(SD->SortedVertices);
+     if (SD->EdgeKeys) delete[] SD->EdgeKeys;
+     free(SD);
+   };
+  free(SurfaceData);
+
+  for(int np=0; np<NS*NS; np++)
+   if (SIPlans[np]) delete SIPlans[np];
+  free(SIPlans);
+}
+
+/***************************************************************/
+/* forget everything; called when the frequency or Bloch       */
+/* vector changes. (the frequency is needed only to assemble   */
+/* the blocks used for separation interpolation.)              */
+/***************************************************************/
+void UBlockCache::Clear(cdouble NewOmega)
+{
+  Omega=NewOmega;
+  for(int np=0; np<NS*NS; np++)
+   if (SIPlans[np])
+    ClearSITable(SIPlans[np]);
+
+  for(int np=0; np<NS*NS; np++)
+   { for(unsigned ne=0; ne<Stored[np].size(); ne++)
+      DeleteEntry(Stored[np][ne]);
+     Stored[np].clear();
+     if (InBuffer[np])
+      { delete InBuffer[np];
+        InBuffer[np]=0;
+      };
+   };
+  Bytes=0;
+}
+
+void UBlockCache::DeleteEntry(UBCEntry *E)
+{
+  if (E->U) delete E->U;
+  if (E->dU)
+   { for(int Mu=0; Mu<E->NumdU; Mu++)
+      if (E->dU[Mu]) delete E->dU[Mu];
+     free(E->dU);
+   };
+  delete E;
+}
+
+/***************************************************************/
+/* return true if the common motion C, which carries the pair  */
+/* from an earlier configuration into the current one, leaves  */
+/* a block of the given invariance class unchanged             */
+/***************************************************************/
+bool UBlockCache::CommonMotionAllowed(GTransformation C, int Invariance, double LengthScale)
+{
+  if (C.IsIdentity(LengthScale))
+   return true;
+  if (Invariance==UBC_FIXED)
+   return false;
+
+  GTransformation R(C);
+  R.DX[0]=R.DX[1]=R.DX[2]=0.0;
+  bool Rotates = !R.IsIdentity();
+
+  if (Rotates && (Invariance==UBC_TRANSLATION || G->LDim>0))
+   return false;
+
+  // a layered substrate is invariant only under in-plane
+  // translations and rotations about the z axis
+  if (G->Substrate)
+   { if ( fabs(C.DX[2]) > 1.0e-7*LengthScale ) return false;
+     if ( fabs(C.M[2][2] - 1.0) > 1.0e-7 ) return false;
+   };
+
+  return true;
+}
+
+/***************************************************************/
+/* return true if the block recorded in E is equal to the      */
+/* block for the current poses of surfaces ns, nsp             */
+/***************************************************************/
+bool UBlockCache::Equivalent(UBCEntry *E, int ns, int nsp, int Invariance)
+{
+  RWGSurface *Sa=G->Surfaces[ns], *Sb=G->Surfaces[nsp];
+  GTransformation A=GetPose(Sa), B=GetPose(Sb);
+  double LengthScale = GetLengthScale(ns, nsp);
+
+  GTransformation Rel = (-A) + B, Rel0 = (-E->GTa) + E->GTb;
+  if ( !Rel.IsIdentical(Rel0, LengthScale) )
+   return false;
+
+  return CommonMotionAllowed(A - E->GTa, Invariance, LengthScale);
+}
+
+/***************************************************************/
+/* initialize the data needed to look for symmetries of the    */
+/* mesh of surface #ns                                         */
+/***************************************************************/
+UBCSurface *UBlockCache::GetSurfaceData(int ns)
+{
+  if (SurfaceData[ns])
+   return SurfaceData[ns];
+
+  RWGSurface *S=G->Surfaces[ns];
+  UBCSurface *SD=SurfaceData[ns]=(UBCSurface *)mallocEC(sizeof(UBCSurface));
+
+  int NV=S->NumVertices;
+  SD->RestVertices=(double *)memdup(S->Vertices, 3*NV*sizeof(double));
+  if (S->GT)
+   S->GT->UnApply(SD->RestVertices, NV);
+
+  bool *Used=(bool *)mallocEC(NV*sizeof(bool));
+  for(int np=0; np<S->NumPanels; np++)
+   for(int i=0; i<3; i++)
+    Used[S->Panels[np]->VI[i]]=true;
+
+  SD->SortedVertices=(int *)mallocEC(NV*sizeof(int));
+  int NUV=0;
+  double RMin[3]={+1.0e89, +1.0e89, +1.0e89}, RMax[3]={-1.0e89, -1.0e89, -1.0e89};
+  for(int nv=0; nv<NV; nv++)
+   if (Used[nv])
+    { double *V=SD->RestVertices + 3*nv;
+      SD->SortedVertices[NUV++]=nv;
+      VecPlusEquals(SD->Centroid, 1.0, V);
+      for(int Mu=0; Mu<3; Mu++)
+       { RMin[Mu]=fmin(RMin[Mu], V[Mu]);
+         RMax[Mu]=fmax(RMax[Mu], V[Mu]);
+       };
+    };
+  free(Used);
+  SD->NumUsedVertices=NUV;
+  VecScale(SD->Centroid, 1.0/((double)NUV));
+
+  std::sort(SD->SortedVertices, SD->SortedVertices+NUV,
+            XCompare(SD->RestVertices));
+
+  SD->Extent = VecDistance(RMax, RMin);
+  SD->Tol = 1.0e-6 * SD->Extent;
+
+  SD->EdgeKeys = new EdgeKey[S->NumEdges];
+  for(int ne=0; ne<S->NumEdges; ne++)
+   SD->EdgeKeys[ne] = EdgeKey( ((long)S->Edges[ne]->iV1)*NV + S->Edges[ne]->iV2, ne);
+  std::sort(SD->EdgeKeys, SD->EdgeKeys + S->NumEdges);
+
+  // the signed-permutation correspondence holds only for plain
+  // full-RWG basis sets on compact surfaces
+  int NBF = S->IsPEC ? S->NumEdges : 2*S->NumEdges;
+  SD->Usable = (G->LDim==0 && S->NumHalfRWGEdges==0 && S->NumBFs==NBF);
+
+  return SD;
+}
+
+/***************************************************************/
+/* length scale for pose comparisons of surfaces ns, nsp: the  */
+/* smaller of their extents (computed from the untransformed   */
+/* vertices, so independent of the current poses)              */
+/***************************************************************/
+double UBlockCache::GetLengthScale(int ns, int nsp)
+{ return fmin(GetSurfaceData(ns)->Extent, GetSurfaceData(nsp)->Extent); }
+
+/***************************************************************/
+/* return the index of the used vertex of surface #ns whose    */
+/* untransformed coordinates are X, or -1 if there is none     */
+/***************************************************************/
+static int FindVertex(UBCSurface *SD, double X[3])
+{
+  double *RV=SD->RestVertices;
+  int *SV=SD->SortedVertices, NUV=SD->NumUsedVertices;
+
+  int Lo=0, Hi=NUV;
+  while(Lo<Hi)
+   { int Mid=(Lo+Hi)/2;
+     if ( RV[3*SV[Mid]] < X[0]-SD->Tol ) Lo=Mid+1; else Hi=Mid;
+   };
+  for(int n=Lo; n<NUV && RV[3*SV[n]]<=X[0]+SD->Tol; n++)
+   if ( VecDistance(RV+3*SV[n], X) < SD->Tol )
+    return SV[n];
+  return -1;
+}
+
+/***************************************************************/
+/* if the rigid motion S maps the untransformed mesh of surface*/
+/* #ns onto itself, fill in Perm[nbf], Sign[nbf] such that the */
+/* RWG function nbf, carried along by S, is Sign[nbf] times    */
+/* the RWG function Perm[nbf], and return true.                */
+/***************************************************************/
+bool UBlockCache::GetBFPermutation(int ns, GTransformation S, int *Perm, double *Sign)
+{
+  UBCSurface *SD=GetSurfaceData(ns);
+  if (!SD->Usable)
+   return false;
+
+  // quick rejection: S must fix the vertex centroid
+  double X[3];
+  S.Apply(SD->Centroid, X);
+  if ( VecDistance(X, SD->Centroid) > SD->Tol )
+   return false;
+
+  RWGSurface *Surf=G->Surfaces[ns];
+  int NV=Surf->NumVertices;
+  int *VMap=(int *)mallocEC(NV*sizeof(int));
+  bool Success=true;
+  for(int n=0; Success && n<SD->NumUsedVertices; n++)
+   { int nv=SD->SortedVertices[n];
+     S.Apply(SD->RestVertices + 3*nv, X);
+     if ( (VMap[nv]=FindVertex(SD, X)) == -1 )
+      Success=false;
+   };
+
+  EdgeKey *EKEnd = SD->EdgeKeys + Surf->NumEdges;
+  for(int ne=0; Success && ne<Surf->NumEdges; ne++)
+   { RWGEdge *E=Surf->Edges[ne];
+     int iV1=VMap[E->iV1], iV2=VMap[E->iV2];
+     long Key = ((long)std::min(iV1,iV2))*NV + std::max(iV1,iV2);
+     EdgeKey *EK=std::lower_bound(SD->EdgeKeys, EKEnd, EdgeKey(Key,-1));
+     if ( EK==EKEnd || EK->first!=Key )
+      { Success=false;
+        break;
+      };
+     int nep=EK->second;
+     RWGEdge *EP=Surf->Edges[nep];
+
+     double s;
+     if ( VMap[E->iQP]==EP->iQP && VMap[E->iQM]==EP->iQM )
+      s=1.0;
+     else if ( VMap[E->iQP]==EP->iQM && VMap[E->iQM]==EP->iQP )
+      s=-1.0;
+     else
+      { Success=false;
+        break;
+      };
+
+     if (Surf->IsPEC)
+      { Perm[ne]=nep;
+        Sign[ne]=s;
+      }
+     else
+      { Perm[2*ne+0]=2*nep+0; Sign[2*ne+0]=s;
+        Perm[2*ne+1]=2*nep+1; Sign[2*ne+1]=s;
+      };
+   };
+
+  free(VMap);
+  return Success;
+}
+
+/***************************************************************/
+/* Dest(m,n) = Sign[m]*Src(Perm[m],n)  (PermuteRows==true)     */
+/* Dest(m,n) = Sign[n]*Src(m,Perm[n])  (PermuteRows==false)    */
+/***************************************************************/
+static void PermuteBlock(HMatrix *Src, HMatrix *Dest, bool PermuteRows,
+                         int *Perm, double *Sign)
+{
+  int NR=Src->NR, NC=Src->NC;
+  for(int nc=0; nc<NC; nc++)
+   for(int nr=0; nr<NR; nr++)
+    { int nrp = PermuteRows ? Perm[nr] : nr;
+      int ncp = PermuteRows ? nc : Perm[nc];
+      double s = PermuteRows ? Sign[nr] : Sign[nc];
+      if (Src->RealComplex==LHM_REAL)
+       Dest->DM[nr + ((size_t)nc)*NR] = s*Src->DM[nrp + ((size_t)ncp)*NR];
+      else
+       Dest->ZM[nr + ((size_t)nc)*NR] = s*Src->ZM[nrp + ((size_t)ncp)*NR];
+    };
+}
+
+/***************************************************************/
+/* record the current poses of surfaces ns, nsp as those of    */
+/* the block now in the caller's buffer                        */
+/***************************************************************/
+void UBlockCache::SetBufferPoses(int ns, int nsp, unsigned dUMask)
+{
+  int np=ns*NS+nsp;
+  if (!InBuffer[np])
+   { InBuffer[np]=new UBCEntry;
+     InBuffer[np]->U=0;
+     InBuffer[np]->dU=0;
+     InBuffer[np]->NumdU=0;
+   };
+  InBuffer[np]->GTa=GetPose(G->Surfaces[ns]);
+  InBuffer[np]->GTb=GetPose(G->Surfaces[nsp]);
+  InBuffer[np]->dUMask=dUMask;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+bool UBlockCache::Fetch(int ns, int nsp, HMatrix *U, HMatrix **dU, int NumdU,
+                        int Invariance)
+{
+  int np=ns*NS+nsp;
+  unsigned Mask=GetdUMask(dU, NumdU);
+
+  /*--------------------------------------------------------------*/
+  /*- the caller's buffer may already hold the block             -*/
+  /*--------------------------------------------------------------*/
+  UBCEntry *E=InBuffer[np];
+  if ( E && (Mask & ~E->dUMask)==0 && Equivalent(E, ns, nsp, Invariance) )
+   { NumHits++;
+     return true;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- look for a stored block computed at an equivalent pose     -*/
+  /*--------------------------------------------------------------*/
+  std::vector<UBCEntry *> &Entries=Stored[np];
+  for(unsigned ne=0; ne<Entries.size(); ne++)
+   { E=Entries[ne];
+     if ( (Mask & ~E->dUMask)!=0 || !Equivalent(E, ns, nsp, Invariance) )
+      continue;
+     U->Copy(E->U);
+     for(int Mu=0; Mu<NumdU; Mu++)
+      if (dU[Mu]) dU[Mu]->Copy(E->dU[Mu]);
+     E->LastUsed=++Clock;
+     SetBufferPoses(ns, nsp, Mask);
+     InBuffer[np]->GTa=E->GTa;
+     InBuffer[np]->GTb=E->GTb;
+     NumHits++;
+     return true;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- look for a stored block whose pose differs from the current-*/
+  /*- pose by a symmetry of one of the two meshes                -*/
+  /*--------------------------------------------------------------*/
+  RWGSurface *Sa=G->Surfaces[ns], *Sb=G->Surfaces[nsp];
+  GTransformation A=GetPose(Sa), B=GetPose(Sb);
+  double LengthScale = GetLengthScale(ns, nsp);
+  GTransformation Rel = (-A) + B;
+  int MaxNBF = std::max(Sa->NumBFs, Sb->NumBFs);
+  int *Perm=0;
+  double *Sign=0;
+  for(unsigned ne=0; U->StorageType==LHM_NORMAL && ne<Entries.size(); ne++)
+   { E=Entries[ne];
+     if ( (Mask & ~E->dUMask)!=0 )
+      continue;
+     GTransformation Rel0 = (-E->GTa) + E->GTb;
+     if (!Perm)
+      { Perm=(int *)mallocEC(MaxNBF*sizeof(int));
+        Sign=(double *)mallocEC(MaxNBF*sizeof(double));
+      };
+
+     // surface b differs from its earlier pose by S = Rel0^{-1} Rel
+     bool PermuteRows;
+     if (    CommonMotionAllowed(A - E->GTa, Invariance, LengthScale)
+          && GetBFPermutation(nsp, (-Rel0) + Rel, Perm, Sign)
+        )
+      PermuteRows=false;
+     // surface a differs from its earlier pose by S = Rel0 Rel^{-1}
+     else if (    CommonMotionAllowed(B - E->GTb, Invariance, LengthScale)
+               && GetBFPermutation(ns, Rel0 - Rel, Perm, Sign)
+             )
+      PermuteRows=true;
+     else
+      continue;
+
+     PermuteBlock(E->U, U, PermuteRows, Perm, Sign);
+     for(int Mu=0; Mu<NumdU; Mu++)
+      if (dU[Mu]) PermuteBlock(E->dU[Mu], dU[Mu], PermuteRows, Perm, Sign);
+     free(Perm);
+     free(Sign);
+     E->LastUsed=++Clock;
+     SetBufferPoses(ns, nsp, Mask);
+     NumSymmetryHits++;
+     if (G->LogLevel>=SCUFF_VERBOSE2)
+      Log(" U(%s,%s) reconstructed from a symmetry-equivalent pose",Sa->Label,Sb->Label);
+     return true;
+   };
+  if (Perm) free(Perm);
+  if (Sign) free(Sign);
+
+  /*--------------------------------------------------------------*/
+  /*- interpolate in separation if the pair was planned for that -*/
+  /*--------------------------------------------------------------*/
+  if ( SIPlans[np] && Interpolate(ns, nsp, U, dU, NumdU, Invariance) )
+   { SetBufferPoses(ns, nsp, Mask);
+     NumInterpolationHits++;
+     return true;
+   };
+
+  NumMisses++;
+  return false;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void UBlockCache::Store(int ns, int nsp, HMatrix *U, HMatrix **dU, int NumdU)
+{
+  int np=ns*NS+nsp;
+  unsigned Mask=GetdUMask(dU, NumdU);
+  SetBufferPoses(ns, nsp, Mask);
+
+  size_t EntryBytes = BlockBytes(U);
+  for(int Mu=0; Mu<NumdU; Mu++)
+   if (dU[Mu]) EntryBytes += BlockBytes(dU[Mu]);
+  if (EntryBytes > MaxBytes)
+   return;
+
+  /*--------------------------------------------------------------*/
+  /*- evict least recently used entries to make room             -*/
+  /*--------------------------------------------------------------*/
+  while( Bytes + EntryBytes > MaxBytes )
+   { int npLRU=-1, neLRU=-1;
+     unsigned long OldestUse=0;
+     for(int npp=0; npp<NS*NS; npp++)
+      for(unsigned ne=0; ne<Stored[npp].size(); ne++)
+       if ( npLRU==-1 || Stored[npp][ne]->LastUsed < OldestUse )
+        { npLRU=npp;
+          neLRU=ne;
+          OldestUse=Stored[npp][ne]->LastUsed;
+        };
+     Bytes -= Stored[npLRU][neLRU]->Bytes;
+     DeleteEntry(Stored[npLRU][neLRU]);
+     Stored[npLRU].erase(Stored[npLRU].begin() + neLRU);
+   };
+
+  UBCEntry *E=new UBCEntry;
+  E->GTa=InBuffer[np]->GTa;
+  E->GTb=InBuffer[np]->GTb;
+  E->U=new HMatrix(U);
+  E->NumdU=NumdU;
+  E->dUMask=Mask;
+  E->dU=0;
+  if (NumdU>0)
+   { E->dU=(HMatrix **)mallocEC(NumdU*sizeof(HMatrix *));
+     for(int Mu=0; Mu<NumdU; Mu++)
+      E->dU[Mu] = dU[Mu] ? new HMatrix(dU[Mu]) : 0;
+   };
+  E->LastUsed=++Clock;
+  E->Bytes=EntryBytes;
+  Stored[np].push_back(E);
+  Bytes+=EntryBytes;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+/* separation interpolation: for a pair of surfaces whose      */
+/* relative pose over the transformation sweep differs only by */
+/* displacements s along a line, we assemble the block U(s)    */
+/* once per frequency at NumNodes Chebyshev nodes in s and      */
+/* reconstruct it at all other s from its Chebyshev expansion. */
+/* the factor exp(ik[R(s)-R(0)]), with R the distance between  */
+/* the surface centroids, is divided out before interpolating  */
+/* to remove the dominant oscillation (real frequencies) or    */
+/* decay (imaginary frequencies) of the block with s.          */
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+
+// Dest += Alpha*Src
+static void AddScaled(HMatrix *Dest, double Alpha, HMatrix *Src)
+{
+  size_t N=Dest->NumEntries();
+  if (Dest->RealComplex==LHM_REAL)
+   for(size_t n=0; n<N; n++) Dest->DM[n] += Alpha*Src->DM[n];
+  else
+   for(size_t n=0; n<N; n++) Dest->ZM[n] += Alpha*Src->ZM[n];
+}
+
+// the phase factors are real for the real blocks that arise at imaginary frequencies
+static void ScaleBlock(HMatrix *M, cdouble Factor)
+{
+  if (M->RealComplex==LHM_REAL)
+   M->Scale(real(Factor));
+  else
+   M->Scale(Factor);
+}
+
+// Frobenius norm of A (if B==0) or of A-B
+static double FrobeniusNorm(HMatrix *A, HMatrix *B=0)
+{
+  double Sum=0.0;
+  size_t N=A->NumEntries();
+  if (A->RealComplex==LHM_REAL)
+   for(size_t n=0; n<N; n++)
+    { double d = A->DM[n] - (B ? B->DM[n] : 0.0);
+      Sum+=d*d;
+    }
+  else
+   for(size_t n=0; n<N; n++)
+    Sum+=norm( A->ZM[n] - (B ? B->ZM[n] : 0.0) );
+  return sqrt(Sum);
+}
+
+// |A-B| / |B|, or |A-B| if B vanishes
+static double RelativeError(HMatrix *A, HMatrix *B)
+{
+  double Norm=FrobeniusNorm(B), Diff=FrobeniusNorm(A,B);
+  return Norm>0.0 ? Diff/Norm : Diff;
+}
+
+static cdouble GetPhase(SIPlan *P, double s)
+{
+  double XB[3];
+  VecScaleAdd(P->XB0, s, P->u, XB);
+  double DeltaR = VecDistance(P->XA, XB) - VecDistance(P->XA, P->XB0);
+  return exp(II*P->k*DeltaR);
+}
+
+static double GetChebyshevNode(SIPlan *P, double Theta)
+{ return 0.5*(P->sMax+P->sMin) + 0.5*(P->sMax-P->sMin)*cos(Theta); }
+
+static void FreeSICoeffs(SICoeffs *SC)
+{
+  if (SC->C)
+   { for(int k=0; k<SC->NumTerms; k++)
+      delete SC->C[k];
+     free(SC->C);
+   };
+  if (SC->W) delete SC->W;
+  if (SC->VT) delete SC->VT;
+  if (SC->Offset) free(SC->Offset);
+  memset(SC, 0, sizeof(SICoeffs));
+}
+
+void UBlockCache::ClearSITable(SIPlan *P)
+{
+  for(int Mu=0; Mu<=SI_MAXDU; Mu++)
+   FreeSICoeffs(P->Coeffs + Mu);
+  P->Built=P->Usable=false;
+}
+
+/***************************************************************/
+/* store the Chebyshev coefficient matrices C[0..N-1], dropping*/
+/* trailing terms and singular values whose contribution is    */
+/* below AbsTol/100, and keeping the truncated SVDs if they    */
+/* take less memory than the dense matrices. takes ownership   */
+/* of C.                                                       */
+/***************************************************************/
+static void CompressCoefficients(HMatrix **C, int N, double AbsTol, SICoeffs *SC)
+{
+  int NR=C[0]->NR, NC=C[0]->NC, RC=C[0]->RealComplex;
+  double Threshold=0.01*AbsTol;
+
+  int NumTerms=N;
+  while( NumTerms>1 && FrobeniusNorm(C[NumTerms-1])<Threshold )
+   delete C[--NumTerms];
+  SC->NumTerms=NumTerms;
+
+  int NMin = (NR<NC ? NR : NC);
+  HMatrix **UFactors  = (HMatrix **)mallocEC(NumTerms*sizeof(HMatrix *));
+  HMatrix **VTFactors = (HMatrix **)mallocEC(NumTerms*sizeof(HMatrix *));
+  HVector **Sigmas    = (HVector **)mallocEC(NumTerms*sizeof(HVector *));
+  int *Ranks          = (int *)mallocEC(NumTerms*sizeof(int));
+  size_t DenseSize = ((size_t)NumTerms)*NR*NC, LowRankSize=0;
+  int RTotal=0;
+  for(int k=0; k<NumTerms && LowRankSize<DenseSize; k++)
+   { HMatrix *Scratch=new HMatrix(C[k]);
+     UFactors[k]=new HMatrix(NR, NMin, RC);
+     VTFactors[k]=new HMatrix(NMin, NC, RC);
+     Sigmas[k]=Scratch->SVD(0, UFactors[k], VTFactors[k]);
+     delete Scratch;
+
+     double Discarded=0.0;
+     int r=NMin;
+     while( r>0 && sqrt(Discarded + Sigmas[k]->DV[r-1]*Sigmas[k]->DV[r-1])<Threshold )
+      { r--;
+        Discarded += Sigmas[k]->DV[r]*Sigmas[k]->DV[r];
+      };
+     Ranks[k]=r;
+     RTotal+=r;
+     LowRankSize += ((size_t)r)*(NR+NC);
+   };
+
+  if ( RTotal==0 || LowRankSize>=DenseSize )
+   SC->C=C;
+  else
+   { SC->Offset=(int *)mallocEC((NumTerms+1)*sizeof(int));
+     SC->W=new HMatrix(NR, RTotal, RC);
+     SC->VT=new HMatrix(RTotal, NC, RC);
+     for(int k=0; k<NumTerms; k++)
+      { SC->Offset[k+1]=SC->Offset[k]+Ranks[k];
+        for(int i=0; i<Ranks[k]; i++)
+         { int ni=SC->Offset[k]+i;
+           double Sigma=Sigmas[k]->DV[i];
+           for(int nr=0; nr<NR; nr++)
+            SC->W->SetEntry(nr, ni, Sigma*UFactors[k]->GetEntry(nr,i));
+           for(int nc=0; nc<NC; nc++)
+            SC->VT->SetEntry(ni, nc, VTFactors[k]->GetEntry(i,nc));
+         };
+        delete C[k];
+      };
+     free(C);
+   };
+
+  for(int k=0; k<NumTerms; k++)
+   { if (UFactors[k]) delete UFactors[k];
+     if (VTFactors[k]) delete VTFactors[k];
+     if (Sigmas[k]) delete Sigmas[k];
+   };
+  free(UFactors);
+  free(VTFactors);
+  free(Sigmas);
+  free(Ranks);
+}
+
+/***************************************************************/
+/* Dest <- interpolated block at separation s                  */
+/***************************************************************/
+static void EvaluateSI(SIPlan *P, SICoeffs *SC, double s, HMatrix *Dest)
+{
+  int NT=SC->NumTerms;
+  double x = (2.0*s - (P->sMax+P->sMin)) / (P->sMax-P->sMin);
+  double *T=(double *)mallocEC(NT*sizeof(double));
+  T[0]=1.0;
+  if (NT>1) T[1]=x;
+  for(int k=2; k<NT; k++)
+   T[k]=2.0*x*T[k-1] - T[k-2];
+
+  if (SC->C)
+   { Dest->Zero();
+     for(int k=0; k<NT; k++)
+      AddScaled(Dest, T[k], SC->C[k]);
+   }
+  else
+   { HMatrix *WT=new HMatrix(SC->W);
+     for(int k=0; k<NT; k++)
+      for(int nc=SC->Offset[k]; nc<SC->Offset[k+1]; nc++)
+       for(int nr=0; nr<WT->NR; nr++)
+        WT->ScaleEntry(nr, nc, T[k]);
+     WT->Multiply(SC->VT, Dest);
+     delete WT;
+   };
+  ScaleBlock(Dest, GetPhase(P, s));
+  free(T);
+}
+
+/***************************************************************/
+/* assemble block (ns,nsp), and optionally its displacement    */
+/* derivatives, at separation s by temporarily moving surface  */
+/* nsp. the geometric data changed by RWGSurface::Transform()  */
+/* are saved beforehand and copied back afterwards, rather     */
+/* than transforming back by the inverse displacement, so that */
+/* the surface is returned exactly (not merely to within       */
+/* roundoff) to its current pose.                              */
+/***************************************************************/
+void UBlockCache::AssembleAtSeparation(int ns, int nsp, SIPlan *P, double s,
+                                       HMatrix *U, HMatrix **GradU)
+{
+  RWGSurface *Sb=G->Surfaces[nsp];
+  GTransformation Rel(P->Rel0);
+  VecPlusEquals(Rel.DX, s, P->u);
+  GTransformation Delta = (GetPose(G->Surfaces[ns]) + Rel) - GetPose(Sb);
+
+  int NV=Sb->NumVertices, NE=Sb->NumEdges, NH=Sb->NumHalfRWGEdges;
+  double *SavedVertices=(double *)memdup(Sb->Vertices, 3*NV*sizeof(double));
+  double *SavedCentroids=(double *)mallocEC(3*(NE+NH+1)*sizeof(double));
+  for(int ne=0; ne<NE; ne++)
+   VecCopy(Sb->Edges[ne]->Centroid, SavedCentroids + 3*ne);
+  for(int ne=0; ne<NH; ne++)
+   VecCopy(Sb->HalfRWGEdges[ne]->Centroid, SavedCentroids + 3*(NE+ne));
+  double SavedOrigin[3];
+  VecCopy(Sb->Origin, SavedOrigin);
+  GTransformation *SavedGT = Sb->GT ? new GTransformation(Sb->GT) : 0;
+
+  Sb->Transform(&Delta);
+  G->AssembleBEMMatrixBlock(ns, nsp, Omega, 0, U, GradU);
+
+  memcpy(Sb->Vertices, SavedVertices, 3*NV*sizeof(double));
+  for(int ne=0; ne<NE; ne++)
+   VecCopy(SavedCentroids + 3*ne, Sb->Edges[ne]->Centroid);
+  for(int ne=0; ne<NH; ne++)
+   VecCopy(SavedCentroids + 3*(NE+ne), Sb->HalfRWGEdges[ne]->Centroid);
+  VecCopy(SavedOrigin, Sb->Origin);
+  if (SavedGT)
+   { *(Sb->GT) = *SavedGT;
+     delete SavedGT;
+   }
+  else
+   { delete Sb->GT;
+     Sb->GT=0;
+   };
+  for(int np=0; np<Sb->NumPanels; np++)
+   InitRWGPanel(Sb->Panels[np], Sb->Vertices);
+  Sb->UpdateBoundingBox();
+  Sb->UpdatePackedMesh();
+  Sb->TransformStamp++;
+
+  free(SavedVertices);
+  free(SavedCentroids);
+}
+
+/***************************************************************/
+/* assemble the blocks at the Chebyshev nodes at the current   */
+/* frequency, convert to Chebyshev coefficients, and check the */
+/* accuracy of the expansion: the error estimate is the larger */
+/* of the relative size of the last two coefficients and the   */
+/* actual error at the midpoint of the two central nodes.      */
+/***************************************************************/
+void UBlockCache::BuildSITable(int ns, int nsp, SIPlan *P, HMatrix *U, unsigned Mask)
+{
+  RWGSurface *Sa=G->Surfaces[ns], *Sb=G->Surfaces[nsp];
+  int N=P->NumNodes, NR=U->NR, NC=U->NC, RC=U->RealComplex;
+
+  P->Built=true;
+  P->Usable=false;
+  P->GTaBuild=GetPose(Sa);
+  P->dUMask=Mask;
+
+  // wavenumber in the common exterior medium; we skip the
+  // demodulation if it would overflow
+  P->k=0.0;
+  int CRI[2];
+  double Signs[2];
+  if ( CountCommonRegions(Sa, Sb, CRI, Signs) > 0 )
+   { cdouble Eps, Mu;
+     G->RegionMPs[CRI[0]]->GetEpsMu(Omega, &Eps, &Mu);
+     P->k = sqrt(Eps*Mu)*Omega;
+     if ( fabs(imag(P->k))*(P->sMax-P->sMin) > 500.0 )
+      P->k=0.0;
+   };
+
+  Log(" Assembling U(%s,%s) at %i separations for interpolation...",Sa->Label,Sb->Label,N);
+
+  /*--------------------------------------------------------------*/
+  /*- Nodes[Mu*N+j] = block Mu (0=U, 1..3=dU/dx,y,z) at node j   -*/
+  /*--------------------------------------------------------------*/
+  int NumBlocks=1+SI_MAXDU;
+  HMatrix **Nodes=(HMatrix **)mallocEC(NumBlocks*N*sizeof(HMatrix *));
+  for(int j=0; j<N; j++)
+   { double s = GetChebyshevNode(P, M_PI*(j+0.5)/N);
+     HMatrix *GradU[SI_MAXDU]={0,0,0};
+     Nodes[j]=new HMatrix(NR, NC, RC);
+     for(int Mu=0; Mu<SI_MAXDU; Mu++)
+      if ( Mask & (1U<<Mu) )
+       Nodes[(1+Mu)*N+j] = GradU[Mu] = new HMatrix(NR, NC, RC);
+     AssembleAtSeparation(ns, nsp, P, s, Nodes[j], Mask ? GradU : 0);
+
+     cdouble InvPhase = 1.0/GetPhase(P, s);
+     for(int Mu=0; Mu<NumBlocks; Mu++)
+      if (Nodes[Mu*N+j])
+       ScaleBlock(Nodes[Mu*N+j], InvPhase);
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- convert node values to Chebyshev coefficients in place:    -*/
+  /*-  C_k = (2-delta_{k0})/N \sum_j f(s_j) cos(k(j+1/2)pi/N)    -*/
+  /*--------------------------------------------------------------*/
+  double *Cos=(double *)mallocEC(N*N*sizeof(double));
+  for(int k=0; k<N; k++)
+   for(int j=0; j<N; j++)
+    Cos[k*N+j] = (k==0 ? 1.0 : 2.0)*cos(M_PI*k*(j+0.5)/N)/N;
+  double TailEstimate=0.0;
+  for(int Mu=0; Mu<NumBlocks; Mu++)
+   { HMatrix **C=Nodes + Mu*N;
+     if (C[0]==0) continue;
+
+     size_t NE=C[0]->NumEntries();
+     if (RC==LHM_REAL)
+      { double *f=(double *)mallocEC(N*sizeof(double));
+        for(size_t n=0; n<NE; n++)
+         { for(int j=0; j<N; j++) f[j]=C[j]->DM[n];
+           for(int k=0; k<N; k++)
+            { double Sum=0.0;
+              for(int j=0; j<N; j++) Sum+=Cos[k*N+j]*f[j];
+              C[k]->DM[n]=Sum;
+            };
+         };
+        free(f);
+      }
+     else
+      { cdouble *f=(cdouble *)mallocEC(N*sizeof(cdouble));
+        for(size_t n=0; n<NE; n++)
+         { for(int j=0; j<N; j++) f[j]=C[j]->ZM[n];
+           for(int k=0; k<N; k++)
+            { cdouble Sum=0.0;
+              for(int j=0; j<N; j++) Sum+=Cos[k*N+j]*f[j];
+              C[k]->ZM[n]=Sum;
+            };
+         };
+        free(f);
+      };
+
+     // a block that vanishes identically (Norm0==0) has no tail
+     double Norm0=FrobeniusNorm(C[0]);
+     if (Norm0>0.0)
+      TailEstimate = fmax(TailEstimate,
+                          (FrobeniusNorm(C[N-1]) + FrobeniusNorm(C[N-2])) / Norm0);
+     HMatrix **CCopy=(HMatrix **)memdup(C, N*sizeof(HMatrix *));
+     CompressCoefficients(CCopy, N, P->Tol*Norm0, P->Coeffs + Mu);
+   };
+  free(Cos);
+  free(Nodes);
+
+  /*--------------------------------------------------------------*/
+  /*- a-posteriori check of the block and its derivatives against-*/
+  /*- a direct calculation                                       -*/
+  /*--------------------------------------------------------------*/
+  double sTest = GetChebyshevNode(P, M_PI*(N/2)/((double)N));
+  HMatrix *Direct[1+SI_MAXDU]={0,0,0,0};
+  for(int Mu=0; Mu<NumBlocks; Mu++)
+   if ( Mu==0 || (Mask & (1U<<(Mu-1))) )
+    Direct[Mu]=new HMatrix(NR, NC, RC);
+  AssembleAtSeparation(ns, nsp, P, sTest, Direct[0], Mask ? Direct+1 : 0);
+  HMatrix *Interp=new HMatrix(NR, NC, RC);
+  double TestError=0.0;
+  for(int Mu=0; Mu<NumBlocks; Mu++)
+   if (Direct[Mu])
+    { EvaluateSI(P, P->Coeffs + Mu, sTest, Interp);
+      TestError = fmax(TestError, RelativeError(Interp, Direct[Mu]));
+      delete Direct[Mu];
+    };
+  delete Interp;
+
+  double Error = fmax(TailEstimate, TestError);
+  if (Error <= P->Tol)
+   { P->Usable=true;
+     Log(" ...estimated interpolation error %.1e",Error);
+   }
+  else
+   { ClearSITable(P);
+     P->Built=true;
+     Log(" ...estimated interpolation error %.1e exceeds %.1e (assembling U(%s,%s) directly)",
+         Error,P->Tol,Sa->Label,Sb->Label);
+   };
+}
+
+/***************************************************************/
+/* if the current relative pose of surfaces ns, nsp lies on the*/
+/* line of displacements planned for this pair, fill in U (and */
+/* dU) by interpolation and return true                        */
+/***************************************************************/
+bool UBlockCache::Interpolate(int ns, int nsp, HMatrix *U, HMatrix **dU, int NumdU,
+                              int Invariance)
+{
+  SIPlan *P=SIPlans[ns*NS+nsp];
+  unsigned Mask=GetdUMask(dU, NumdU);
+  if ( Invariance==UBC_FIXED || (Mask >> SI_MAXDU)!=0 || U->StorageType!=LHM_NORMAL )
+   return false;
+
+  RWGSurface *Sa=G->Surfaces[ns], *Sb=G->Surfaces[nsp];
+  GTransformation A=GetPose(Sa), B=GetPose(Sb);
+  double LengthScale = GetLengthScale(ns, nsp);
+  double Tol=1.0e-7*LengthScale;
+
+  // s = displacement along u; the rest of the relative pose must match Rel0
+  GTransformation Rel = (-A) + B;
+  double dX[3];
+  VecSub(Rel.DX, P->Rel0.DX, dX);
+  double s=VecDot(dX, P->u);
+  VecPlusEquals(dX, -s, P->u);
+  if ( VecNorm(dX)>Tol || s<(P->sMin-Tol) || s>(P->sMax+Tol) )
+   return false;
+  VecCopy(P->Rel0.DX, Rel.DX);
+  if ( !Rel.IsIdentical(P->Rel0, LengthScale) )
+   return false;
+
+  if (!P->Built)
+   BuildSITable(ns, nsp, P, U, Mask);
+  if ( !P->Usable || (Mask & ~P->dUMask)!=0 )
+   return false;
+  if ( !CommonMotionAllowed(A - P->GTaBuild, Invariance, LengthScale) )
+   return false;
+
+  EvaluateSI(P, P->Coeffs + 0, s, U);
+  for(int Mu=0; Mu<SI_MAXDU && Mu<NumdU; Mu++)
+   if (dU[Mu])
+    EvaluateSI(P, P->Coeffs + 1 + Mu, s, dU[Mu]);
+  return true;
+}
+
+/***************************************************************/
+/* look through the list of transformations for pairs of       */
+/* surfaces whose relative pose varies only by displacements   */
+/* along a line, at enough distinct separations to make        */
+/* interpolation on NumNodes Chebyshev nodes worthwhile, and   */
+/* plan to interpolate the blocks for those pairs. returns the */
+/* number of pairs planned.                                    */
+/***************************************************************/
+int UBlockCache::PlanSeparationInterpolation(GTCList GTCs, int NumNodes, double Tol)
+{
+  if (NumNodes<4)
+   ErrExit("separation interpolation needs at least 4 nodes (got %i)",NumNodes);
+  if (G->LDim>0)
+   { Warn("separation interpolation not available for periodic geometries (skipping)");
+     return 0;
+   };
+
+  /*--------------------------------------------------------------*/
+  /*- record the poses of all surfaces under all transformations -*/
+  /*--------------------------------------------------------------*/
+  int NT=GTCs.size();
+  GTransformation *Poses=new GTransformation[NT*NS];
+  for(int nt=0; nt<NT; nt++)
+   { G->Transform(GTCs[nt]);
+     for(int ns=0; ns<NS; ns++)
+      Poses[nt*NS+ns]=GetPose(G->Surfaces[ns]);
+     G->UnTransform();
+   };
+
+  int NumPlanned=0;
+  double *s=new double[NT];
+  for(int ns=0; ns<NS; ns++)
+   for(int nsp=ns+1; nsp<NS; nsp++)
+    { 
+      RWGSurface *Sa=G->Surfaces[ns], *Sb=G->Surfaces[nsp];
+      double LengthScale = GetLengthScale(ns, nsp);
+      double LTol=1.0e-7*LengthScale;
+
+      // the direction of the largest displacement from the first pose
+      GTransformation Rel0 = (-Poses[ns]) + Poses[nsp];
+      double u[3]={0.0, 0.0, 0.0}, MaxNorm=0.0;
+      bool OnLine=true;
+      for(int nt=1; OnLine && nt<NT; nt++)
+       { GTransformation Rel = (-Poses[nt*NS+ns]) + Poses[nt*NS+nsp];
+         double dX[3];
+         VecSub(Rel.DX, Rel0.DX, dX);
+         VecCopy(Rel0.DX, Rel.DX);
+         if ( !Rel.IsIdentical(Rel0, LengthScale) )
+          OnLine=false;
+         else if ( VecNorm(dX) > MaxNorm )
+          { MaxNorm=VecNorm(dX);
+            VecScale(dX, 1.0/MaxNorm, u);
+          };
+       };
+      if (!OnLine || MaxNorm<LTol)
+       continue;
+
+      // separations along u
+      for(int nt=0; OnLine && nt<NT; nt++)
+       { GTransformation Rel = (-Poses[nt*NS+ns]) + Poses[nt*NS+nsp];
+         double dX[3];
+         VecSub(Rel.DX, Rel0.DX, dX);
+         s[nt]=VecDot(dX, u);
+         VecPlusEquals(dX, -s[nt], u);
+         if (VecNorm(dX) > LTol)
+          OnLine=false;
+       };
+      if (!OnLine)
+       continue;
+
+      std::sort(s, s+NT);
+      int NumDistinct=1;
+      for(int nt=1; nt<NT; nt++)
+       if ( (s[nt]-s[nt-1]) > LTol )
+        NumDistinct++;
+      if (NumDistinct < NumNodes+2)
+       continue;
+
+      SIPlan *P=SIPlans[ns*NS+nsp]=new SIPlan;
+      memset(P->Coeffs, 0, sizeof(P->Coeffs));
+      P->Rel0=Rel0;
+      VecCopy(u, P->u);
+      P->sMin=s[0];
+      P->sMax=s[NT-1];
+      VecCopy(GetSurfaceData(ns)->Centroid, P->XA);
+      Rel0.Apply(GetSurfaceData(nsp)->Centroid, P->XB0);
+      P->NumNodes=NumNodes;
+      P->Tol=Tol;
+      P->Built=P->Usable=false;
+      NumPlanned++;
+
+      Log("Interpolating U(%s,%s) over displacements [%g,%g] along (%g,%g,%g) (%i nodes, %i transformations)",
+           Sa->Label,Sb->Label,P->sMin,P->sMax,u[0],u[1],u[2],NumNodes,NumDistinct);
+    };
+
+  delete[] s;
+  delete[] Poses;
+  return NumPlanned;
+}
+
+} // namespace scuff
@@ -145,10 +145,49 @@ typedef struct RWGEdge
 
 } RWGEdge;
 
+/***************************************************************/
+/* RWGPackedMesh is a structure-of-arrays copy of the panel    */
+/* and edge data of an RWGSurface, with each array aligned to  */
+/* a 64-byte boundary, for use in inner loops.                 */
+/*                                                             */
+/* note: after the following code snippet                      */
+/*  double *V = S->Packed->PV + 9*np + 3*i                     */
+/* V[0..2] are the coordinates of the ith vertex of panel np,  */
+/* i.e. the same numbers as S->Vertices + 3*S->Panels[np]->VI[i].*/
+/***************************************************************/
+typedef struct RWGPackedMesh
+ { 
+   int NumPanels, NumEdges;
+
+   double *PV;          /* PV[9*np + 3*i + Mu] = vertex #i of panel #np */
+   double *PCentroid;   /* PCentroid[3*np + Mu] */
+   double *PZHat;       /* PZHat[3*np + Mu] */
+   double *PRadius;     /* PRadius[np] */
+   double *PArea;       /* PArea[np] */
+
+   double *EQAB;        /* EQAB[18*ne + 9*PM + {0,3,6} + Mu] = Q, V1-Q, V2-Q */
+                        /*  for the positive (PM=0) and negative (PM=1)     */
+                        /*  panels of the basis function for edge #ne       */
+   double *EArea;       /* EArea[2*ne + PM] = area of panel PM (0 if none) */
+   double *ECentroid;   /* ECentroid[3*ne + Mu] */
+   double *ERadius;     /* ERadius[ne] */
+   double *ELength;     /* ELength[ne] */
+   int *EPanels;        /* EPanels[2*ne + PM] = iPPanel, iMPanel */
+   int *EQIndex;        /* EQIndex[2*ne + PM] = PIndex, MIndex */
+
+   int *PanelOrder;     /* panel indices in Morton order of centroids */
+   int *EdgeOrder;      /* edge indices in Morton order of centroids */
+
+   void *Block;         /* single allocation holding all of the above */
+
+ } RWGPackedMesh;
+
 /***************************************************************/
 /* fast kd-tree based point-in-object calculations             */
 /***************************************************************/
 typedef struct kdtri_s *kdtri;
+
+struct ScuffMeshFile; // binary mesh container, defined in libscuffInternals.h
 void kdtri_destroy(kdtri t); // destructor
 
 // some tree statistics for informational purposes:
@@ -288,6 +327,14 @@ class RWGSurface
    kdtri kdPanels; /* kd-tree of panels */
    void InitkdPanels(bool reinit = false, int LogLevel = SCUFF_NOLOGGING);
 
+   RWGPackedMesh *Packed; /* packed copy of panel and edge data */
+   void UpdatePackedMesh();
+
+   /* write mesh and edge topology to a binary .scuffmesh file */
+   char *WriteScuffMeshFile(const char *FileName,
+                            const double *MeshVertices=0,
+                            unsigned long long SourceHash=0);
+
    /* OTGT is a 'one-time geometry transformation' that is applied  */
    /* once to the mesh upon the initial read in from the mesh file  */
    /* and is not subsequently undone.                               */
@@ -299,10 +346,17 @@ class RWGSurface
    GTransformation *OTGT, *GT;
    double Origin[3];
 
+   /* TransformStamp is incremented whenever the surface is moved, */
+   /* so that geometry-wide data structures that depend on panel   */
+   /* positions can tell when they are stale.                      */
+   unsigned TransformStamp;
+
    /* SurfaceZeta, if non-NULL, points to a cevaluator for a      */
    /* user-specified function of frequency and position (w,x,y,z) */
    /* describing surface impedance in units of ZVAC               */
    void *SurfaceZeta;
+   void *SurfaceZetaProgram; /* compiled version of SurfaceZeta */
+   void GetSurfaceZeta(cdouble Omega, int NumPoints, const double *X, cdouble *Zeta);
 
    // the following fields are used to pass some data items up to the 
    // higher-level routine that calls the RWGSurface constructor
@@ -320,9 +374,11 @@ class RWGSurface
    RWGEdge *GetEdgeByIndex(int ne);
 
    /* constructor helper subroutines */
-   char *InitRWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices);
+   char *InitRWGSurface(dVec VertexCoordinates, iVec PanelVertexIndices,
+                        ScuffMeshFile *SMF=0);
    char *ParseOBJECTSURFACESection(FILE *f, int *LineNum);
    char *InitEdgeList();
+   char *InitEdgeListFromScuffMesh(ScuffMeshFile *SMF);
    void AddStraddlers(HMatrix *LBasis, int NumStraddlers[MAXLDIM]);
    void UpdateBoundingBox();
  };
@@ -341,6 +397,40 @@ typedef struct MMJData
 
 class EquivalentEdgePairTable; // forward declaration
 
+/***************************************************************/
+/* an SCUFFWorkspace owns the scratch buffers used by the PFT, */
+/* DSI-flux, and DGF routines. these routines formerly kept    */
+/* their buffers in function-level static variables, which     */
+/* made it impossible to call them simultaneously from more    */
+/* than one thread (e.g. at different frequencies). now each   */
+/* routine takes an optional SCUFFWorkspace; if none is given, */
+/* it uses a temporary one that is destroyed on return, and if */
+/* one is given its buffers are reused across calls. a given   */
+/* workspace must only be used by one caller at a time.        */
+/***************************************************************/
+class SCUFFWorkspace
+ {
+public:
+   SCUFFWorkspace();
+   ~SCUFFWorkspace();
+
+   // return scratch buffer #Slot, grown to at least Size
+   // bytes as necessary and zeroed on return
+   void *GetBuffer(int Slot, size_t Size);
+
+   // return scratch matrix #Slot, (re)allocated if it does
+   // not have the requested dimensions; contents unspecified
+   HMatrix *GetMatrix(int Slot, int NR, int NC, int RealComplex=LHM_REAL);
+
+private:
+   void Grow(int Slot);
+
+   int NumSlots;
+   void **Buffers;
+   size_t *BufferSizes;
+   HMatrix **Matrices;
+ };
+
 /*************************** ***********************************/
 /* an RWGGeometry is a collection of regions with interfaces   */
 /* described by RWGSurfaces.                                   */
@@ -364,6 +454,11 @@ class RWGGeometry
    HMatrix *AssembleBEMMatrix(cdouble Omega, double *kBloch, HMatrix *M = NULL);
    HMatrix *AssembleBEMMatrix(cdouble Omega, HMatrix *M = NULL);
 
+   // distributed-memory (MPI) versions of the above, for compact
+   // geometries; see DistributedBEMMatrix.cc
+   DMatrix *AllocateDistributedBEMMatrix(int BlockSize = 0);
+   DMatrix *AssembleDistributedBEMMatrix(cdouble Omega, DMatrix *M = NULL);
+
    HVector *AllocateRHSVector(bool PureImagFreq = false );
    HVector *AssembleRHSVector(cdouble Omega, double *kBloch,
                               IncField *IF, HVector *RHS = NULL);
@@ -390,7 +485,8 @@ class RWGGeometry
    HMatrix *GetDyadicGFs(cdouble Omega, double *kBloch,
                          HMatrix *XMatrix, HMatrix *M,
                          HMatrix *GMatrix=0, 
-                         bool ScatteringOnly=false);
+                         bool ScatteringOnly=false,
+                         SCUFFWorkspace *Workspace=0);
 
    // these next two are legacy interfaces which will be
    // removed in future versions
@@ -476,6 +572,7 @@ class RWGGeometry
    int GetRegionByLabel(const char *Label);
    RWGSurface *GetSurfaceByLabel(const char *Label, int *pns=NULL);
    int GetRegionIndex(const double X[3]); // index of region containing X
+   int *GetRegionIndices(HMatrix *XMatrix, int *Regions=0, int ColumnOffset=0); // same for all rows of XMatrix
    int PointInRegion(int RegionIndex, const double X[3]); 
 
    /* geometrical transformations */
@@ -496,7 +593,8 @@ class RWGGeometry
    void DetectMultiMaterialJunctions();
 
    // helper functions for AssembleBEMMatrix
-   void UpdateCachedEpsMuValues(cdouble Omega);
+   void UpdateCachedEpsMuValues(cdouble Omega); // fills the deprecated EpsTF/MuTF
+   void GetEpsMuValues(cdouble Omega, cdouble *Eps, cdouble *Mu);
    void AssembleBEMMatrixBlock(int nsa, int nsb, cdouble Omega, double *kBloch,
                                HMatrix *M, HMatrix **GradM=0,
                                int RowOffset=0, int ColOffset=0,
@@ -507,6 +605,9 @@ class RWGGeometry
                                bool NeedZDerivative=false);
    void DestroyABMBAccelerator(void *Accelerator);
    void ApplyMMJTransformation(HMatrix *M, HVector *RHS);
+   void AssembleBEMMatrixTile(cdouble Omega, int RowStart, int NumRows,
+                              int ColStart, int NumCols, HMatrix *M,
+                              int RowOffset=0, int ColOffset=0);
 
    // helper function for GetFields, GetDyadicGFs, GetSRFluxTrace
    HMatrix *GetRFMatrix(cdouble Omega, double *kBloch, HMatrix *XMatrix,
@@ -545,6 +646,10 @@ class RWGGeometry
 
    // cached values of epsilon and mu for each region
    // 'EpsTF' = 'epsilon, this frequency'
+   // (deprecated: libscuff neither reads nor updates these
+   //  itself; they hold meaningful values only after an
+   //  explicit call to UpdateCachedEpsMuValues(). new code
+   //  should call GetEpsMuValues() with its own storage.)
    cdouble *EpsTF, *MuTF;
    cdouble StoredOmega;
 
@@ -552,6 +657,13 @@ class RWGGeometry
    RWGSurface **Surfaces;
    int AllSurfacesClosed;
 
+   // kd-tree over the panels of all surfaces in their current
+   // positions, used by GetRegionIndex(); rebuilt on demand
+   // when any surface's TransformStamp changes
+   kdtri kdAllPanels;
+   unsigned kdAllPanelsStamp;
+   void InitkdAllPanels();
+
    int TotalBFs;
    int TotalEdges;
    int TotalPanels;
@@ -631,6 +743,91 @@ class RWGGeometry
    static bool UseHighKTaylorDuffy;
    static bool UseTaylorDuffyV2P0;
    static bool DisableCache;
+
+   /* if positive, the relative accuracy targeted by the          */
+   /* tolerance-driven choice of cubature rules for panel-panel   */
+   /* and field integrals (set by SCUFF_INTEGRATION_TOLERANCE);   */
+   /* if zero, the traditional fixed-order rules are used.        */
+   static double IntegrationTolerance;
+
+   /* upper bound, in megabytes, on the reduced-field matrices    */
+   /* held at once by the many-point GetDyadicGFs; larger sets of */
+   /* evaluation points are processed in blocks that fit within   */
+   /* this budget (set by SCUFF_DGF_MEMORY).                      */
+   static double DGFMemoryBudget;
+ };
+
+/***************************************************************/
+/* a UBlockCache remembers the off-diagonal BEM matrix blocks  */
+/* U(ns,nsp)---and optionally their derivatives dU---computed  */
+/* at one frequency and Bloch vector for the various poses     */
+/* that the surfaces take during a geometrical transformation  */
+/* sweep. a block is reused whenever the relative pose of the  */
+/* two surfaces repeats (up to a common motion of the pair     */
+/* that leaves the block unchanged), and is reconstructed by a */
+/* signed permutation of the RWG basis when the two poses      */
+/* differ by a rotation that maps one mesh onto itself.        */
+/*                                                             */
+/* usage: call Fetch() before assembling block (ns,nsp) into   */
+/* the buffer U; if it returns false, assemble the block and   */
+/* then call Store(). the caller must not otherwise modify U   */
+/* between calls. call Clear() whenever Omega or kBloch change.*/
+/* stored copies are limited to SCUFF_UBLOCK_CACHE_MEMORY      */
+/* megabytes.                                                  */
+/*                                                             */
+/* PlanSeparationInterpolation() looks through a list of       */
+/* transformations for pairs of surfaces whose relative pose   */
+/* varies only by displacement along a line; for these pairs,  */
+/* Fetch() reconstructs the block at any separation from its   */
+/* Chebyshev expansion, assembled once per frequency at        */
+/* NumNodes separations and checked against the accuracy Tol. */
+/***************************************************************/
+// invariance classes of cached blocks under common motions of the pair
+#define UBC_RIGID       0 // invariant under rotations and translations
+#define UBC_TRANSLATION 1 // invariant under translations only (e.g. dU/dx)
+#define UBC_FIXED       2 // not invariant (e.g. dU/dTheta about lab axes)
+
+struct UBCEntry;   // forward declarations
+struct UBCSurface;
+struct SIPlan;
+
+class UBlockCache
+ {
+public:
+   UBlockCache(RWGGeometry *G);
+   ~UBlockCache();
+
+   void Clear(cdouble Omega);
+   int PlanSeparationInterpolation(GTCList GTCs, int NumNodes, double Tol=1.0e-6);
+
+   bool Fetch(int ns, int nsp, HMatrix *U, HMatrix **dU=0, int NumdU=0,
+              int Invariance=UBC_RIGID);
+   void Store(int ns, int nsp, HMatrix *U, HMatrix **dU=0, int NumdU=0);
+
+   int NumHits, NumSymmetryHits, NumInterpolationHits, NumMisses;
+
+private:
+   bool CommonMotionAllowed(GTransformation C, int Invariance, double LengthScale);
+   bool Equivalent(UBCEntry *E, int ns, int nsp, int Invariance);
+   UBCSurface *GetSurfaceData(int ns);
+   double GetLengthScale(int ns, int nsp);
+   bool GetBFPermutation(int ns, GTransformation S, int *Perm, double *Sign);
+   void SetBufferPoses(int ns, int nsp, unsigned dUMask);
+   void DeleteEntry(UBCEntry *E);
+   bool Interpolate(int ns, int nsp, HMatrix *U, HMatrix **dU, int NumdU, int Invariance);
+   void AssembleAtSeparation(int ns, int nsp, SIPlan *P, double s, HMatrix *U, HMatrix **GradU);
+   void BuildSITable(int ns, int nsp, SIPlan *P, HMatrix *U, unsigned Mask);
+   void ClearSITable(SIPlan *P);
+
+   RWGGeometry *G;
+   int NS;
+   std::vector<UBCEntry *> *Stored; // Stored[ns*NS+nsp] = copies of earlier blocks
+   UBCEntry **InBuffer;             // poses of the blocks now in the caller's buffers
+   UBCSurface **SurfaceData;
+   SIPlan **SIPlans;                // SIPlans[ns*NS+nsp] = separation-interpolation data
+   cdouble Omega;
+   size_t Bytes, MaxBytes;
+   unsigned long Clock;
  };
 
 /***************************************************************/
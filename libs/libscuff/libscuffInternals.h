@@ -44,6 +44,19 @@ namespace scuff {
 #define PPIALG_DESING        4
 #define NUMPPIALGORITHMS     5
 
+// highest order of the triangle cubature rules returned by GetTCR
+#define MAXTCRORDER          25
+
+// SCUFFWorkspace slots used by the various libscuff routines;
+// routines that may call one another must use distinct slots
+#define WSSLOT_EMTPFT_DELTA  0
+#define WSSLOT_EXTPFT_DELTA  1
+#define WSSLOT_SRFLUX_DELTA  2
+#define WSSLOT_DGF_RFSOURCE  3
+#define WSSLOT_DGF_RFDEST    4
+#define WSSLOT_EMTPFT_SCATTERED  5
+#define WSSLOT_EMTPFT_EXTINCTION 6
+
 /***************************************************************/ 
 /* 1. argument structures for routines whose input/output      */
 /*    interface is so complicated that an ordinary C++         */
@@ -81,10 +94,12 @@ typedef struct GetPPIArgStruct
    // this is an optional 3-vector displacement applied to object b
    double *Displacement;
 
-   // this field is filled in by the PanelPanelInteractions() routine
+   // these fields are filled in by the PanelPanelInteractions() routine
    // to indicate which of the various computational algorithms was   
-   // used to compute the panel-panel integrals
+   // used to compute the panel-panel integrals, and the order of the
+   // cubature rule used for the non-singular part (0 if none)
    int WhichAlgorithm;
+   int Order;
 
    // if this object is nonzero, it is used to compute the 
    // periodic kernel; otherwise we use the usual Helmholtz kernel.
@@ -106,11 +121,36 @@ typedef struct GetPPIArgStruct
 
 void InitGetPPIArgs(GetPPIArgStruct *Args);
 void GetPanelPanelInteractions(GetPPIArgStruct *Args);
+void GetPPIs_Cubature(GetPPIArgStruct *Args,
+                      int DeSingularize, int Order,
+                      double **Va, double *Qa,
+                      double **Vb, double *Qb);
 void GetPanelPanelInteractions(GetPPIArgStruct *Args,
                                cdouble *H,
                                cdouble *GradH,
                                cdouble *dHdT);
 
+/*--------------------------------------------------------------*/
+/*- tolerance-driven choice of cubature rules, and statistics   */
+/*- on the panel-panel integration algorithms actually used     */
+/*- (IntegrationRules.cc)                                       */
+/*--------------------------------------------------------------*/
+int SelectPPICubatureOrder(double rRel, double kR, double Tolerance);
+int SelectFieldCubatureOrder(double rRel, double kR, double Tolerance);
+double GetPPICubatureError(int Order, double rRel, double kR);
+double GetFieldCubatureError(int Order, double rRel, double kR);
+
+typedef struct PPIStatistics
+ { unsigned long Count[NUMPPIALGORITHMS]; // PPIs computed by each algorithm
+   double Time[NUMPPIALGORITHMS];         // wall-clock seconds spent in each
+   unsigned long OrderCount[MAXTCRORDER+1]; // PPIs using each cubature order
+ } PPIStatistics;
+
+void InitPPIStatistics(PPIStatistics *Stats);
+void AddPPIStatistics(PPIStatistics *Total, PPIStatistics *Stats);
+void LogPPIStatistics(PPIStatistics *Stats, const char *Label);
+void ProfilePPIStatistics(PPIStatistics *Stats);
+
 /*--------------------------------------------------------------*/
 /*- GetEdgeEdgeInteractions() ----------------------------------*/
 /*--------------------------------------------------------------*/
@@ -144,8 +184,10 @@ typedef struct GetEEIArgStruct
    
    // this field provides diagnostic information on 
    // how many times the various panel-panel integral 
-   // algorithms were invoked 
-   unsigned PPIAlgorithmCount[NUMPPIALGORITHMS];
+   // algorithms were invoked; if TimePPIs is true, the
+   // time spent in each algorithm is recorded as well
+   PPIStatistics PPIStats;
+   bool TimePPIs;
 
    // output fields filled in by routine
    //  GC[0] = <f_a|G|f_b>
@@ -249,6 +291,13 @@ typedef struct GetSSIArgStruct
    // augments (does not overwrite) the matrix entries
    bool Accumulate;
 
+   // if BFRangeA[1]>=0, only the rows of B for basis functions
+   // BFRangeA[0]<=nbf<BFRangeA[1] of Sa are computed (similarly for
+   // BFRangeB and the columns for Sb). this is used to compute tiles of
+   // the BEM matrix; it requires Accumulate=true and no GradB or
+   // dBdTheta, and Symmetric=true requires BFRangeA==BFRangeB.
+   int BFRangeA[2], BFRangeB[2];
+
    // output fields filled in by routine
    HMatrix *B;
    HMatrix **GradB;
@@ -266,6 +315,7 @@ typedef struct GetSSIArgStruct
 void InitGetSSIArgs(GetSSIArgStruct *Args);
 void GetSurfaceSurfaceInteractions(GetSSIArgStruct *Args);
 void AddSurfaceZetaContributionToBEMMatrix(GetSSIArgStruct *Args);
+int GetOverlappingEdgeIndices(RWGSurface *S, int nea, int nebArray[5]);
 
 /***************************************************************/
 /* 2. definition of data structures and methods for working    */
@@ -359,6 +409,21 @@ class FIPPICache
 /***************************************************************/   
 extern FIPPICache GlobalFIPPICache;
 
+/***************************************************************/
+/* node-wide cache of FIPPI and FIBBI records in a POSIX       */
+/* shared-memory segment, shared by all processes that set     */
+/* SCUFF_SHARED_CACHE to the same segment name. records are    */
+/* copied in and out; lookups fail and insertions are no-ops   */
+/* if no segment is configured.                                */
+/***************************************************************/
+#define SHAREDCACHE_FIPPI    0
+#define SHAREDCACHE_FIBBI    1
+#define NUMSHAREDCACHETABLES 2
+
+bool SharedCacheLookup(int Table, const void *Key, void *Data);
+void SharedCacheInsert(int Table, const void *Key, const void *Data);
+void LogSharedCacheStatistics();
+
 /****************************************************************/
 /*- 3. Utility routines for analyzing geometrical data          */
 /*-    associated with SCUFF geometries.                        */
@@ -391,6 +456,39 @@ int NumCommonVertices(RWGSurface *Sa, int npa, RWGSurface *Sb, int npb);
 int CanonicallyOrderVertices(double **Va, double **Vb, int ncv,
                              double **OVa, double **OVb);
 
+/***************************************************************/
+/* packed (structure-of-arrays) mesh data and Morton ordering  */
+/***************************************************************/
+void GetMortonOrder(const double *X, int N, int *Order, int Stride=3);
+void DestroyPackedMesh(RWGPackedMesh *PM);
+
+/***************************************************************/
+/* binary .scuffmesh files. a ScuffMeshFile with Map==NULL     */
+/* records only the name of a cache file to be written once    */
+/* the edge list has been computed.                            */
+/***************************************************************/
+typedef struct ScuffMeshFile
+ { char *FileName;
+   void *Map;
+   size_t MapSize;
+   unsigned long long SourceHash;
+   int MeshTag;             // physical region, or -1 for the whole mesh
+   int NumVertices, NumPanels, NumEdges, NumExteriorEdges;
+   int NumBCs, NumBCEdgesTotal, NumInteriorVertices;
+   const double *Vertices;  // 3*NumVertices, untransformed
+   const int *PanelVI;      // 3*NumPanels
+   const int *EdgeTable;    // 8*(NumEdges+NumExteriorEdges)
+   const int *NumBCEdges;   // NumBCs
+   const int *BCEdges;      // indices into HalfRWGEdges
+   const int *WhichBC;      // NumVertices
+ } ScuffMeshFile;
+
+unsigned long long GetMeshFileHash(FILE *MeshFile, int MeshTag);
+ScuffMeshFile *OpenScuffMeshFile(const char *FileName, char **ErrMsg);
+ScuffMeshFile *CreateScuffMeshFileRequest(const char *FileName,
+                                          unsigned long long SourceHash);
+void CloseScuffMeshFile(ScuffMeshFile *SMF);
+
 } // namespace scuff
 
 #endif //LIBSCUFFINTERNALS_H
@@ -81,6 +81,7 @@ void scuffSolver::InitSolver()
 
   TBlocks        = 0;
   UBlocks        = 0;
+  UBCache        = 0;
 
   Medium         = 0;
   SubstrateFile  = 0;
@@ -105,6 +106,7 @@ scuffSolver::~scuffSolver()
       delete UBlocks[nu];
      delete UBlocks;
    }
+  if (UBCache) delete UBCache;
 
   if (CachedPortCurrents) delete CachedPortCurrents;
   if (CachedIF)     delete CachedIF;
@@ -558,6 +560,7 @@ void scuffSolver::EnableSystemBlockCache()
 
   UBlocks = new HMatrix *[NU];
   memset(UBlocks, 0, NU*sizeof(HMatrix *)); // allocated lazily
+  UBCache = new UBlockCache(G);
 
   OmegaSIE = CACHE_DIRTY;
 }
@@ -582,19 +585,23 @@ void scuffSolver::UpdateSystemMatrix(cdouble Omega)
         AssembleMOIMatrixBlock(G, ns, ns, Omega, TBlocks[ns]);
      }
 
-  // UBlocks recomputed if frequency has changed or surfaces were moved
+  // UBlocks recomputed unless the relative pose of the two surfaces
+  // was already seen at this frequency
+  if (Omega!=OmegaSIE)
+   UBCache->Clear(Omega);
   for(int nsa=0, nu=0; nsa<G->NumSurfaces; nsa++)
    for(int nsb=nsa+1; nsb<G->NumSurfaces; nsb++, nu++)
     { if (FindEquivalentSurfacePair(G, nsa, nsb)!=-1)
        continue;
-      if (Omega!=OmegaSIE || G->SurfaceMoved[nsa] || G->SurfaceMoved[nsb])
-       { if (UBlocks[nu]==0) 
-          UBlocks[nu]=new HMatrix(G->Surfaces[nsa]->NumBFs, G->Surfaces[nsb]->NumBFs, LHM_COMPLEX);
-         if(NumPorts==0)
-          G->AssembleBEMMatrixBlock(nsa, nsb, Omega, 0, UBlocks[nu]);
-         else
-          AssembleMOIMatrixBlock(G, nsa, nsb, Omega, UBlocks[nu]);
-       }
+      if (UBlocks[nu]==0) 
+       UBlocks[nu]=new HMatrix(G->Surfaces[nsa]->NumBFs, G->Surfaces[nsb]->NumBFs, LHM_COMPLEX);
+      if (UBCache->Fetch(nsa, nsb, UBlocks[nu]))
+       continue;
+      if(NumPorts==0)
+       G->AssembleBEMMatrixBlock(nsa, nsb, Omega, 0, UBlocks[nu]);
+      else
+       AssembleMOIMatrixBlock(G, nsa, nsb, Omega, UBlocks[nu]);
+      UBCache->Store(nsa, nsb, UBlocks[nu]);
     }
 
   // stamp blocks into M matrix
@@ -216,6 +216,7 @@ public:
     // optional caching of system matrix blocks (useful with geometrical transformations)
     HMatrix **TBlocks; 
     HMatrix **UBlocks;
+    UBlockCache *UBCache;   // UBlocks for previously-seen relative surface poses
 
     ////////////////////////////////////////////////////
     // stuff to facilitate python-driven sessions by storing user-specified
@@ -234,7 +234,10 @@ int main(int argc, char *argv[])
      if (f) 
       fclose(f);
      else
-      ErrExit("could not open reference file %s",REF_FILENAME);
+      { // exit status 77 tells 'make check' the test was skipped
+        printf("reference file %s not found (run with --Reference to create it); skipping\n",REF_FILENAME);
+        exit(77);
+      };
    };
 
   /***************************************************************/
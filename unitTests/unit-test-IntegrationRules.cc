@@ -0,0 +1,182 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * unit-test-IntegrationRules.cc -- SCUFF-EM unit test for the
+ *                               -- tolerance-driven choice of
+ *                               -- cubature orders
+ *
+ * For a reference pair of panels at several separations and
+ * wavenumbers (chosen between the grid points of the error tables
+ * in IntegrationRules.cc), we check that the panel-panel integrals
+ * computed with the cubature order selected for a given tolerance
+ * agree with a reference calculation (the order-25 rule on 16-fold
+ * subdivided panels) to within that tolerance.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+using namespace scuff;
+
+/***************************************************************/
+/* split each of the NT triangles in V into 4 by joining the   */
+/* edge midpoints                                              */
+/***************************************************************/
+static int Subdivide(double (*V)[3][3], int NT)
+{
+  for(int nt=NT-1; nt>=0; nt--)
+   { double V0[3], V1[3], V2[3], M01[3], M12[3], M20[3];
+     VecCopy(V[nt][0], V0);
+     VecCopy(V[nt][1], V1);
+     VecCopy(V[nt][2], V2);
+     VecLinComb(0.5, V0, 0.5, V1, M01);
+     VecLinComb(0.5, V1, 0.5, V2, M12);
+     VecLinComb(0.5, V2, 0.5, V0, M20);
+     double (*T)[3][3] = V + 4*nt;
+     VecCopy(V0,  T[0][0]); VecCopy(M01, T[0][1]); VecCopy(M20, T[0][2]);
+     VecCopy(M01, T[1][0]); VecCopy(V1,  T[1][1]); VecCopy(M12, T[1][2]);
+     VecCopy(M20, T[2][0]); VecCopy(M12, T[2][1]); VecCopy(V2,  T[2][2]);
+     VecCopy(M01, T[3][0]); VecCopy(M12, T[3][1]); VecCopy(M20, T[3][2]);
+   };
+  return 4*NT;
+}
+
+/***************************************************************/
+/* panel-panel integrals with both panels subdivided 4^Levels  */
+/* times (GetPPIs_Cubature normalizes by the panel areas, so   */
+/* each subpanel pair contributes with weight 1/(NTa*NTb))     */
+/***************************************************************/
+#define REFLEVELS 2
+static void GetPPIs(double Va[3][3], double *Qa, double Vb[3][3], double *Qb,
+                    cdouble k, int Order, int Levels, cdouble H[2])
+{
+  static double Ta[256][3][3], Tb[256][3][3];
+  memcpy(Ta[0], Va, 9*sizeof(double));
+  memcpy(Tb[0], Vb, 9*sizeof(double));
+  int NTa=1, NTb=1;
+  for(int nl=0; nl<Levels; nl++)
+   { NTa=Subdivide(Ta, NTa);
+     NTb=Subdivide(Tb, NTb);
+   };
+
+  GetPPIArgStruct MyArgs, *Args=&MyArgs;
+  InitGetPPIArgs(Args);
+  Args->k=k;
+
+  H[0]=H[1]=0.0;
+  for(int nta=0; nta<NTa; nta++)
+   for(int ntb=0; ntb<NTb; ntb++)
+    { double *VVa[3]={Ta[nta][0], Ta[nta][1], Ta[nta][2]};
+      double *VVb[3]={Tb[ntb][0], Tb[ntb][1], Tb[ntb][2]};
+      GetPPIs_Cubature(Args, 0, Order, VVa, Qa, VVb, Qb);
+      H[0] += Args->H[0] / ((double)(NTa*NTb));
+      H[1] += Args->H[1] / ((double)(NTa*NTb));
+    };
+}
+
+static double PanelRadius(double V[3][3], double *Centroid)
+{
+  for(int Mu=0; Mu<3; Mu++)
+   Centroid[Mu]=(V[0][Mu] + V[1][Mu] + V[2][Mu])/3.0;
+  return fmax( VecDistance(V[0], Centroid),
+               fmax( VecDistance(V[1], Centroid), VecDistance(V[2], Centroid) ) );
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  SetLogFileName("scuff-test-IntegrationRules.log");
+
+  /*--------------------------------------------------------------*/
+  /*- the reference pair: panel B is a differently shaped panel  -*/
+  /*- in a tilted plane, translated along D so that the centroid -*/
+  /*- separation is rRel times the larger panel radius           -*/
+  /*--------------------------------------------------------------*/
+  double Va[3][3]={ {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.4, 0.8, 0.0} };
+  double Vb0[3][3]={ {0.0, 0.0, 0.0}, {0.3, 0.9, 0.2}, {-0.7, 0.5, 0.4} };
+  double D[3]={1.0/3.0, 2.0/3.0, 2.0/3.0};
+
+  double Ca[3], Cb0[3];
+  double RMax=fmax(PanelRadius(Va, Ca), PanelRadius(Vb0, Cb0));
+
+  double rRelValues[]={2.5, 5.0, 10.0, 20.0};
+  double kRValues[]={0.3, 1.5, 3.0, 6.0};
+  double Tolerances[]={1.0e-2, 1.0e-4, 1.0e-6, 1.0e-8};
+
+  bool Failed=false;
+  int NumChecked=0, NumSkipped=0;
+  for(int nrr=0; nrr<4; nrr++)
+   for(int nk=0; nk<4; nk++)
+    { double rRel=rRelValues[nrr], kR=kRValues[nk];
+      cdouble k = kR/RMax;
+
+      double Vb[3][3];
+      for(int nv=0; nv<3; nv++)
+       for(int Mu=0; Mu<3; Mu++)
+        Vb[nv][Mu] = Vb0[nv][Mu] - Cb0[Mu] + Ca[Mu] + rRel*RMax*D[Mu];
+
+      cdouble HRef[2];
+      GetPPIs(Va, Va[0], Vb, Vb[1], k, 25, REFLEVELS, HRef);
+      double Norm=abs(HRef[0]) + abs(HRef[1]);
+
+      for(int nt=0; nt<4; nt++)
+       { double Tol=Tolerances[nt];
+         int Order=SelectPPICubatureOrder(rRel, kR, Tol);
+
+         // no rule is certified for this tolerance here
+         if ( GetPPICubatureError(Order, rRel, kR) > Tol )
+          { NumSkipped++;
+            continue;
+          };
+
+         cdouble H[2];
+         GetPPIs(Va, Va[0], Vb, Vb[1], k, Order, 0, H);
+         double Error=(abs(H[0]-HRef[0]) + abs(H[1]-HRef[1])) / Norm;
+         NumChecked++;
+
+         char Description[100];
+         snprintf(Description,100,"rRel=%4.1f kR=%3.1f Tol=%.0e (order %2i)",rRel,kR,Tol,Order);
+         if (Error<=Tol)
+          Log("%s: error %.1e",Description,Error);
+         else
+          { printf("%-50s FAILED (error %.1e)\n",Description,Error);
+            Failed=true;
+          };
+       };
+    };
+  printf("%-50s %s\n","selected cubature orders meet tolerance",Failed ? "FAILED" : "PASSED");
+  printf("(%i cases checked, %i without a certified rule)\n",NumChecked,NumSkipped);
+
+  if (Failed)
+   exit(1);
+
+  printf("All tests successfully passed.\n");
+  exit(0);
+}
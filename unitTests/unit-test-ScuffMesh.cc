@@ -0,0 +1,212 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * unit-test-ScuffMesh.cc -- SCUFF-EM unit test for reading binary
+ *                        -- .scuffmesh files: a file written from a
+ *                        -- mesh must reproduce its topology, and
+ *                        -- truncated or corrupted files must be
+ *                        -- rejected with an error message (not a crash)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+
+using namespace scuff;
+
+#define MESHFILE  "Square_40.msh"
+#define GOODFILE  "unit-test-ScuffMesh.scuffmesh"
+#define BADFILE   "unit-test-ScuffMesh.bad.scuffmesh"
+
+/***************************************************************/
+/* header layout; must agree with ScuffMeshFile.cc             */
+/***************************************************************/
+#define NUMSECTIONS 6
+#define SECTION_NUMBCEDGES 3
+typedef struct ScuffMeshHeader
+ { char Magic[8];
+   unsigned int Version;
+   unsigned int ByteOrderMark;
+   unsigned long long SourceHash;
+   int MeshTag;
+   int NumVertices, NumPanels, NumEdges, NumExteriorEdges;
+   int NumBCs, NumBCEdgesTotal, NumInteriorVertices;
+   unsigned long long Offsets[NUMSECTIONS];
+   unsigned long long FileSize;
+ } ScuffMeshHeader;
+
+/***************************************************************/
+/* read the good file into memory                              */
+/***************************************************************/
+char *FileData;
+size_t FileSize;
+
+void ReadGoodFile()
+{
+  FILE *f=fopen(GOODFILE,"r");
+  if (!f) ErrExit("could not open %s",GOODFILE);
+  fseek(f, 0, SEEK_END);
+  FileSize=ftell(f);
+  rewind(f);
+  FileData=(char *)mallocEC(FileSize);
+  if (fread(FileData, 1, FileSize, f)!=FileSize)
+   ErrExit("could not read %s",GOODFILE);
+  fclose(f);
+}
+
+/***************************************************************/
+/* write the first Size bytes of Data to BADFILE and try to    */
+/* read a surface from it; the attempt must fail               */
+/***************************************************************/
+bool Rejected(const char *Description, const char *Data, size_t Size, int MeshTag=-1)
+{
+  FILE *f=fopen(BADFILE,"w");
+  if ( !f || fwrite(Data, 1, Size, f)!=Size )
+   ErrExit("could not write %s",BADFILE);
+  fclose(f);
+
+  RWGSurface *S=new RWGSurface(BADFILE, MeshTag);
+  bool OK = (S->ErrMsg!=0);
+  printf("%-45s %s (%s)\n",Description, OK ? "PASSED" : "FAILED",
+          S->ErrMsg ? S->ErrMsg : "file accepted");
+  return OK;
+}
+
+/***************************************************************/
+/* return a copy of the good file with one header field or one */
+/* integer in a data section overwritten                       */
+/***************************************************************/
+char *Corrupt(size_t Offset, const void *Value, size_t Size)
+{
+  char *Data=(char *)mallocEC(FileSize);
+  memcpy(Data, FileData, FileSize);
+  memcpy(Data + Offset, Value, Size);
+  return Data;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  SetLogFileName("scuff-test-ScuffMesh.log");
+
+  /*--------------------------------------------------------------*/
+  /*- write a .scuffmesh file and check that it reproduces the    */
+  /*- topology of the original mesh                               */
+  /*--------------------------------------------------------------*/
+  RWGSurface *S0=new RWGSurface(MESHFILE);
+  if (S0->ErrMsg)
+   ErrExit("%s",S0->ErrMsg);
+  char *ErrMsg=S0->WriteScuffMeshFile(GOODFILE);
+  if (ErrMsg)
+   ErrExit("%s",ErrMsg);
+
+  RWGSurface *S1=new RWGSurface(GOODFILE);
+  bool Failed=false;
+  if (S1->ErrMsg)
+   { printf("reading %s: FAILED (%s)\n",GOODFILE,S1->ErrMsg);
+     Failed=true;
+   }
+  else if (    S1->NumVertices!=S0->NumVertices || S1->NumPanels!=S0->NumPanels
+            || S1->NumEdges!=S0->NumEdges || S1->NumExteriorEdges!=S0->NumExteriorEdges
+            || S1->NumBCs!=S0->NumBCs )
+   { printf("reading %s: FAILED (topology differs from %s)\n",GOODFILE,MESHFILE);
+     Failed=true;
+   }
+  else
+   printf("%-45s PASSED\n","reading intact file");
+  if (Failed) exit(1);
+
+  /*--------------------------------------------------------------*/
+  /*- truncated and corrupted files                              -*/
+  /*--------------------------------------------------------------*/
+  ReadGoodFile();
+  ScuffMeshHeader *H=(ScuffMeshHeader *)FileData;
+  if (H->NumBCs<1)
+   ErrExit("%s: test requires a mesh with boundary contours",MESHFILE);
+
+  int Zero=0, Huge=1<<30, MinusOne=-1;
+  unsigned long long BadOffset=FileSize + 64;
+  unsigned long long ShortSize=FileSize/2;
+  size_t WhichBCOffset=H->Offsets[NUMSECTIONS-1];
+
+  // file cut off in the middle
+  if (!Rejected("truncated file", FileData, FileSize/2))
+   Failed=true;
+
+  // file cut off, with the header's file size patched to match
+  char *Data=Corrupt(offsetof(ScuffMeshHeader,FileSize), &ShortSize, sizeof(ShortSize));
+  if (!Rejected("truncated file with consistent header", Data, ShortSize))
+   Failed=true;
+  free(Data);
+
+  // section offset beyond the end of the file
+  Data=Corrupt(offsetof(ScuffMeshHeader,Offsets) + 4*sizeof(unsigned long long),
+               &BadOffset, sizeof(BadOffset));
+  if (!Rejected("section offset beyond end of file", Data, FileSize))
+   Failed=true;
+  free(Data);
+
+  // vertex count too large for the vertex section
+  Data=Corrupt(offsetof(ScuffMeshHeader,NumVertices), &Huge, sizeof(int));
+  if (!Rejected("vertex count too large", Data, FileSize))
+   Failed=true;
+  free(Data);
+
+  // boundary-contour lengths inconsistent with header total
+  Data=Corrupt(offsetof(ScuffMeshHeader,NumBCEdgesTotal), &Zero, sizeof(int));
+  if (!Rejected("boundary-contour total inconsistent", Data, FileSize))
+   Failed=true;
+  free(Data);
+
+  Data=Corrupt(H->Offsets[SECTION_NUMBCEDGES], &Huge, sizeof(int));
+  if (!Rejected("boundary-contour length too large", Data, FileSize))
+   Failed=true;
+  free(Data);
+
+  // out-of-range index in a data section
+  Data=Corrupt(WhichBCOffset, &MinusOne, sizeof(int));
+  if (!Rejected("invalid boundary-contour index", Data, FileSize))
+   Failed=true;
+  free(Data);
+
+  Data=Corrupt(H->Offsets[1], &Huge, sizeof(int));
+  if (!Rejected("invalid panel vertex index", Data, FileSize))
+   Failed=true;
+  free(Data);
+
+  // file written for a different physical region than requested
+  if (!Rejected("wrong physical region", FileData, FileSize, 7))
+   Failed=true;
+
+  unlink(BADFILE);
+  unlink(GOODFILE);
+  if (Failed)
+   exit(1);
+  printf("All tests successfully passed.\n");
+  exit(0);
+}
@@ -0,0 +1,187 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * unit-test-SharedCache.cc -- SCUFF-EM unit test for the node-wide
+ *                          -- shared-memory cache of FIPPI and FIBBI
+ *                          -- records: records published by one
+ *                          -- process are seen by another only if
+ *                          -- both run with the same integration
+ *                          -- settings, and a slot left half-written
+ *                          -- by a process that crashed is reclaimed
+ *                          -- rather than waited on
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+#include "libscuffInternals.h"
+
+using namespace scuff;
+
+// sizes of the key and data of a FIBBI record
+#define KEYLEN  21
+#define DATALEN 51
+
+// time allowed for repeated lookups that probe an abandoned slot;
+// without reclamation each of them spins until MAXSPINS runs out
+#define NUMLOOKUPS 1000
+#define MAXTIME    1.0
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+void InitRecord(float *Key, double *Data, double Seed)
+{ for(int n=0; n<KEYLEN; n++)  Key[n]  = (float)(Seed + 0.1*n);
+  for(int n=0; n<DATALEN; n++) Data[n] = Seed*(n+1);
+}
+
+bool Check(const char *Description, bool OK)
+{ printf("%-50s %s\n",Description, OK ? "PASSED" : "FAILED");
+  return OK;
+}
+
+// run Body in a child process and return its wait status
+int RunInChild(void (*Body)(void *), void *UserData)
+{ fflush(stdout);
+  pid_t PID=fork();
+  if (PID==0)
+   { Body(UserData);
+     _exit(0);
+   };
+  int Status;
+  waitpid(PID, &Status, 0);
+  return Status;
+}
+
+/***************************************************************/
+/* child 1: publish a record computed with a different         */
+/* Taylor-Duffy tolerance                                      */
+/***************************************************************/
+void PublishWithOtherSettings(void *UserData)
+{
+  setenv("SCUFF_TAYLORDUFFY_RELTOL", "1.0e-8", 1);
+  float Key[KEYLEN];
+  double Data[DATALEN], Data2[DATALEN];
+  InitRecord(Key, Data, *(double *)UserData);
+  for(int n=0; n<DATALEN; n++) Data[n]*=-1.0;
+  SharedCacheInsert(SHAREDCACHE_FIBBI, Key, Data);
+  if (    !SharedCacheLookup(SHAREDCACHE_FIBBI, Key, Data2)
+       || memcmp(Data, Data2, sizeof(Data))
+     )
+   _exit(1);
+}
+
+/***************************************************************/
+/* child 2: die while writing a record, by passing a data      */
+/* pointer that faults after the slot has been claimed         */
+/***************************************************************/
+void CrashWhileInserting(void *UserData)
+{
+  signal(SIGSEGV, SIG_DFL);
+  float Key[KEYLEN];
+  double Data[DATALEN];
+  InitRecord(Key, Data, *(double *)UserData);
+  void *BadData=mmap(0, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  SharedCacheInsert(SHAREDCACHE_FIBBI, Key, BadData);
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  SetLogFileName("scuff-test-SharedCache.log");
+
+  char SegmentName[100];
+  snprintf(SegmentName, 100, "scuff-unit-test-SharedCache-%i", (int)getpid());
+  setenv("SCUFF_SHARED_CACHE", SegmentName, 1);
+  setenv("SCUFF_SHARED_CACHE_SIZE", "1", 1);
+  unsetenv("SCUFF_TAYLORDUFFY_RELTOL");
+
+  bool Failed=false;
+  float Key[KEYLEN];
+  double Data[DATALEN], Data2[DATALEN];
+
+  /*--------------------------------------------------------------*/
+  /*- a record published under other settings is not visible; one -*/
+  /*- published under ours is                                     */
+  /*--------------------------------------------------------------*/
+  double Seed1=1.0;
+  int Status=RunInChild(PublishWithOtherSettings, &Seed1);
+  if (!Check("child process publishes a record",
+             WIFEXITED(Status) && WEXITSTATUS(Status)==0))
+   Failed=true;
+
+  InitRecord(Key, Data, Seed1);
+  if (!Check("record keyed on integration settings",
+             !SharedCacheLookup(SHAREDCACHE_FIBBI, Key, Data2)))
+   Failed=true;
+
+  SharedCacheInsert(SHAREDCACHE_FIBBI, Key, Data);
+  bool Found=SharedCacheLookup(SHAREDCACHE_FIBBI, Key, Data2);
+  if (!Check("record inserted and retrieved",
+             Found && !memcmp(Data, Data2, sizeof(Data))))
+   Failed=true;
+
+  /*--------------------------------------------------------------*/
+  /*- a slot abandoned by a crashed writer is reclaimed           */
+  /*--------------------------------------------------------------*/
+  double Seed2=2.0;
+  Status=RunInChild(CrashWhileInserting, &Seed2);
+  if (!Check("child process crashes while inserting",
+             WIFSIGNALED(Status) && WTERMSIG(Status)==SIGSEGV))
+   Failed=true;
+
+  InitRecord(Key, Data, Seed2);
+  double Time=Secs();
+  Found=false;
+  for(int n=0; n<NUMLOOKUPS; n++)
+   Found = SharedCacheLookup(SHAREDCACHE_FIBBI, Key, Data2) || Found;
+  Time=Secs()-Time;
+  printf("%-50s %s (%i lookups in %.2e s)\n","abandoned slot reclaimed",
+         (!Found && Time<MAXTIME) ? "PASSED" : "FAILED", NUMLOOKUPS, Time);
+  if (Found || Time>=MAXTIME)
+   Failed=true;
+
+  SharedCacheInsert(SHAREDCACHE_FIBBI, Key, Data);
+  Found=SharedCacheLookup(SHAREDCACHE_FIBBI, Key, Data2);
+  if (!Check("record inserted after crash and retrieved",
+             Found && !memcmp(Data, Data2, sizeof(Data))))
+   Failed=true;
+
+  char SegmentPath[120];
+  snprintf(SegmentPath, 120, "/%s", SegmentName);
+  shm_unlink(SegmentPath);
+
+  if (Failed)
+   exit(1);
+
+  printf("All tests successfully passed.\n");
+  exit(0);
+}
@@ -0,0 +1,154 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * unit-test-StaticSolver.cc -- SCUFF-EM unit test for the fast
+ *                           -- (octree-accelerated iterative) solver
+ *                           -- in libStaticSolver
+ *
+ * For a geometry with one conducting and one dielectric sphere we
+ * check that the surface-charge densities and the capacitance matrix
+ * computed by the fast solver agree with those obtained by dense LU
+ * solution, that the octree is recognized as stale after the geometry
+ * is transformed, and that the fast solver rebuilt at the new pose
+ * again agrees with dense LU.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+#include "StaticSolver.h"
+
+using namespace scuff;
+
+#define GEOFILE "PECDielectricSpheres_255.scuffgeo"
+
+// the fast solver differs from dense LU by its multipole
+// truncation error and the GMRES tolerance (1e-6)
+#define RELTOL 1.0e-3
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+double RelDiff(HVector *A, HVector *B)
+{
+  double Diff=0.0, Norm=0.0;
+  for(int n=0; n<A->N; n++)
+   { Diff += norm(A->GetEntry(n) - B->GetEntry(n));
+     Norm += norm(B->GetEntry(n));
+   };
+  return sqrt(Diff/Norm);
+}
+
+double RelDiff(HMatrix *A, HMatrix *B)
+{
+  double Diff=0.0, Norm=0.0;
+  for(int nr=0; nr<A->NR; nr++)
+   for(int nc=0; nc<A->NC; nc++)
+    { Diff += norm(A->GetEntry(nr,nc) - B->GetEntry(nr,nc));
+      Norm += norm(B->GetEntry(nr,nc));
+    };
+  return sqrt(Diff/Norm);
+}
+
+bool Check(const char *Description, double Err)
+{
+  bool OK = (Err<RELTOL);
+  printf("%-50s %s (RelErr = %.1e)\n",Description, OK ? "PASSED" : "FAILED", Err);
+  return OK;
+}
+
+/***************************************************************/
+/* compare the fast and dense solutions for a uniform external */
+/* field plus a unit potential on the conductor, and the fast  */
+/* and dense capacitance matrices                              */
+/***************************************************************/
+bool CompareSolvers(StaticSolver *SS, const char *Pose)
+{
+  HMatrix *M=SS->AssembleBEMMatrix();
+  M->LUFactorize();
+
+  ConstantSFData Data;
+  Data.E0[0]=0.3; Data.E0[1]=-0.5; Data.E0[2]=1.0;
+  StaticField SFs[1] = {ConstantStaticField};
+  void *SFData[1]    = {(void *)&Data};
+  double Potentials[2] = {1.0, 0.0};
+  StaticExcitation SE={0, Potentials, SFs, SFData, 1};
+
+  HVector *SigmaLU=SS->AssembleRHSVector(&SE, SS->AllocateRHSVector());
+  HVector *SigmaFast=SS->AllocateRHSVector();
+  SigmaFast->Copy(SigmaLU);
+  SS->SolveBEMSystem(M, SigmaLU);
+  SS->InitFastSolver();
+  SS->SolveBEMSystem(0, SigmaFast);
+
+  char Description[100];
+  snprintf(Description,100,"surface charge, %s",Pose);
+  bool OK=Check(Description, RelDiff(SigmaFast, SigmaLU));
+
+  HMatrix *CLU=SS->GetCapacitanceMatrix(M);
+  HMatrix *CFast=SS->GetCapacitanceMatrix(0);
+  snprintf(Description,100,"capacitance matrix, %s",Pose);
+  OK = Check(Description, RelDiff(CFast, CLU)) && OK;
+
+  delete CLU;
+  delete CFast;
+  delete SigmaLU;
+  delete SigmaFast;
+  delete M;
+  return OK;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  SetLogFileName("scuff-test-StaticSolver.log");
+
+  StaticSolver *SS=new StaticSolver(GEOFILE);
+  RWGGeometry *G=SS->G;
+
+  bool Failed = !CompareSolvers(SS, "initial pose");
+
+  /*--------------------------------------------------------------*/
+  /*- after a transformation the octree must no longer be used    */
+  /*--------------------------------------------------------------*/
+  G->Surfaces[1]->Transform("DISP 0.5 0 -0.7");
+  bool Stale = !SS->HaveFastSolver();
+  printf("%-50s %s\n","octree discarded after transformation",Stale ? "PASSED" : "FAILED");
+  if (!Stale) Failed=true;
+
+  if (!CompareSolvers(SS, "transformed pose"))
+   Failed=true;
+
+  delete SS;
+
+  if (Failed)
+   exit(1);
+
+  printf("All tests successfully passed.\n");
+  exit(0);
+}
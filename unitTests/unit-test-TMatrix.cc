@@ -0,0 +1,133 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * unit-test-TMatrix.cc -- SCUFF-EM unit test for the T-matrix solver
+ *                      -- in scuff-scatter (TMatrixSolver.cc): the
+ *                      -- scattered fields of six cubes (five clusters,
+ *                      -- three distinct cluster types) computed with
+ *                      -- spherical waves up to LMax=3 must agree with
+ *                      -- the full-BEM (LU) solution to within RELTOL
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+#include "libIncField.h"
+#include "scuff-scatter.h"
+
+// the solver is not part of any library, so we compile it in here
+#include "TMatrixSolver.cc"
+
+using namespace scuff;
+
+#define GEOFILE  "TMatrixCubes_96.scuffgeo"
+#define OMEGA    1.0
+#define LMAX     3
+#define RELTOL   1.0e-3
+
+/***************************************************************/
+/* evaluation points (all in the exterior medium)              */
+/***************************************************************/
+#define NUMPOINTS 4
+double XPoints[NUMPOINTS][3]=
+ { {  1.5,  1.5, 1.5 },
+   { -1.0,  4.0, 2.0 },
+   {  6.0, -2.0, 1.0 },
+   {  1.5, -0.2, 3.1 }
+ };
+
+/***************************************************************/
+/* relative difference between two 6-vectors of E, H fields    */
+/***************************************************************/
+double RelDiff(cdouble *EH1, cdouble *EH2)
+{
+  double Diff=0.0, Norm=0.0;
+  for(int n=0; n<6; n++)
+   { Diff += norm(EH1[n]-EH2[n]);
+     Norm += 0.5*(norm(EH1[n]) + norm(EH2[n]));
+   };
+  return Norm==0.0 ? 0.0 : sqrt(Diff/Norm);
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  SetLogFileName("scuff-test-TMatrix.log");
+
+  RWGGeometry *G = new RWGGeometry(GEOFILE);
+
+  cdouble E0[3]  = {1.0, 0.0, 0.0};
+  double nHat[3] = {0.3, 0.0, 0.9539392014169456};
+  PlaneWave *PW  = new PlaneWave(E0, nHat);
+
+  /*--------------------------------------------------------------*/
+  /*- reference solution: dense LU solve of the full BEM system  -*/
+  /*--------------------------------------------------------------*/
+  HMatrix *M      = G->AllocateBEMMatrix();
+  HVector *RHS    = G->AllocateRHSVector();
+  HVector *KNFull = G->AllocateRHSVector();
+  G->AssembleBEMMatrix(OMEGA, M);
+  M->LUFactorize();
+  G->AssembleRHSVector(OMEGA, PW, KNFull);
+  M->LUSolve(KNFull);
+
+  /*--------------------------------------------------------------*/
+  /*- T-matrix solution                                          -*/
+  /*--------------------------------------------------------------*/
+  HVector *KNTM = G->AllocateRHSVector();
+  TMSolver *TMS = CreateTMSolver(G, LMAX, 1.5, 1.0e-8);
+  PrepareTMSolver(TMS, OMEGA);
+  G->AssembleRHSVector(OMEGA, PW, RHS);
+  TMSolve(TMS, RHS, KNTM);
+
+  /*--------------------------------------------------------------*/
+  /*- compare scattered fields                                   -*/
+  /*--------------------------------------------------------------*/
+  bool Failed=false;
+  for(int nx=0; nx<NUMPOINTS; nx++)
+   { cdouble EHFull[6], EHTM[6];
+     G->GetFields(0, KNFull, OMEGA, XPoints[nx], EHFull);
+     G->GetFields(0, KNTM,   OMEGA, XPoints[nx], EHTM);
+     double Err=RelDiff(EHFull, EHTM);
+     printf("(%+.1f,%+.1f,%+.1f): RelErr = %.1e %s\n",
+             XPoints[nx][0], XPoints[nx][1], XPoints[nx][2],
+             Err, Err<RELTOL ? "PASSED" : "FAILED");
+     if ( !(Err<RELTOL) ) Failed=true;
+   };
+
+  DestroyTMSolver(TMS);
+  delete KNTM;
+  delete KNFull;
+  delete RHS;
+  delete M;
+  delete PW;
+  delete G;
+
+  if (Failed)
+   exit(1);
+  printf("All tests successfully passed.\n");
+  exit(0);
+}
@@ -0,0 +1,264 @@
+/* Copyright (C) 2005-2011 M. T. Homer Reid
+ *
+ * This file is part of SCUFF-EM.
+ *
+ * SCUFF-EM is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * SCUFF-EM is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * unit-test-UBlockCache.cc -- SCUFF-EM unit test for the cache of
+ *                          -- off-diagonal BEM matrix blocks: blocks
+ *                          -- reconstructed by the cache must agree
+ *                          -- with blocks assembled directly, both
+ *                          -- for reuse under rigid motions and mesh
+ *                          -- symmetries and for interpolation in the
+ *                          -- separation of two surfaces
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <libhrutil.h>
+#include "libscuff.h"
+
+using namespace scuff;
+
+#define GEOFILE "TwoCubes_96.scuffgeo"
+#define OMEGA   0.5
+
+// blocks assembled directly at poses that differ only by rigid
+// motions agree to a few parts in 10^6 (roundoff in the vertex
+// coordinates can change the choice of cubature rule for some
+// panel pairs); a wrongly reconstructed block is off by O(1)
+#define RELTOL  1.0e-4
+
+/***************************************************************/
+/* relative difference between two blocks                      */
+/***************************************************************/
+double RelDiff(HMatrix *A, HMatrix *B)
+{
+  double Diff=0.0, Norm=0.0;
+  for(int nr=0; nr<A->NR; nr++)
+   for(int nc=0; nc<A->NC; nc++)
+    { Diff += norm(A->GetEntry(nr,nc) - B->GetEntry(nr,nc));
+      Norm += norm(B->GetEntry(nr,nc));
+    };
+  return sqrt(Diff/Norm);
+}
+
+/***************************************************************/
+/* check that the cache reconstructs U(A,B) at the current     */
+/* poses (and counted the lookup as the expected kind of hit)  */
+/* or, if ExpectHit==false, that it does not                   */
+/***************************************************************/
+bool CheckFetch(const char *Description, RWGGeometry *G, UBlockCache *UBC,
+                HMatrix *U, HMatrix *UDirect, bool ExpectHit, int *Counter)
+{
+  // U holds the block for the poses of the previous call (which
+  // the cache may legitimately leave in place)
+  int Count0 = Counter ? *Counter : 0;
+  bool Hit=UBC->Fetch(0, 1, U);
+
+  bool OK;
+  if (!ExpectHit)
+   { OK = !Hit;
+     printf("%-50s %s\n",Description,OK ? "PASSED" : "FAILED (unexpected cache hit)");
+   }
+  else
+   { G->AssembleBEMMatrixBlock(0, 1, OMEGA, 0, UDirect);
+     double Err = Hit ? RelDiff(U, UDirect) : 0.0;
+     OK = Hit && (*Counter==Count0+1) && Err<RELTOL;
+     printf("%-50s %s",Description,OK ? "PASSED" : "FAILED");
+     if (Hit)
+      printf(" (RelErr = %.1e)\n",Err);
+     else
+      printf(" (cache miss)\n");
+   };
+
+  // restore the caller's buffer to the block at the current poses
+  if (!Hit)
+   { G->AssembleBEMMatrixBlock(0, 1, OMEGA, 0, U);
+     UBC->Store(0, 1, U);
+   };
+  return OK;
+}
+
+/***************************************************************/
+/* interpolation of U(A,B) and its derivatives in the          */
+/* displacement of B along x: the blocks fetched at several    */
+/* separations must agree with the blocks assembled directly,  */
+/* and building the interpolation table (which assembles       */
+/* blocks at other separations by moving B) must leave B       */
+/* exactly where it was                                        */
+/***************************************************************/
+#define TRANSFILE  "unit-test-UBlockCache.trans"
+#define NUMTRANS   24
+#define NUMNODES   16
+#define SITOL      1.0e-5
+bool TestInterpolation(RWGGeometry *G)
+{
+  FILE *f=fopen(TRANSFILE,"w");
+  for(int nt=0; nt<NUMTRANS; nt++)
+   fprintf(f,"TRANS S%02i OBJECT B DISP %g 0 0\n",nt,0.05*nt);
+  fclose(f);
+  GTCList GTCs=ReadTransFile(TRANSFILE);
+  unlink(TRANSFILE);
+
+  UBlockCache *UBC=new UBlockCache(G);
+  bool Failed = (UBC->PlanSeparationInterpolation(GTCs, NUMNODES, SITOL) != 1);
+  if (Failed)
+   printf("%-50s FAILED (pair not planned)\n","separation interpolation");
+  UBC->Clear(OMEGA);
+
+  RWGSurface *SA=G->Surfaces[0], *SB=G->Surfaces[1];
+  int NA=SA->NumBFs, NB=SB->NumBFs;
+  HMatrix *U=new HMatrix(NA, NB, LHM_COMPLEX), *UDirect=new HMatrix(NA, NB, LHM_COMPLEX);
+  HMatrix *dU[3], *dUDirect[3];
+  for(int Mu=0; Mu<3; Mu++)
+   { dU[Mu]=new HMatrix(NA, NB, LHM_COMPLEX);
+     dUDirect[Mu]=new HMatrix(NA, NB, LHM_COMPLEX);
+   };
+
+  int WhichTrans[3]={3, 8, 14};
+  for(int n=0; !Failed && n<3; n++)
+   { int nt=WhichTrans[n];
+     G->Transform(GTCs[nt]);
+
+     int NV=SB->NumVertices;
+     double *Vertices=(double *)memdup(SB->Vertices, 3*NV*sizeof(double));
+     GTransformation GT(SB->GT);
+     int Hits0=UBC->NumInterpolationHits;
+
+     bool Hit=UBC->Fetch(0, 1, U, dU, 3);
+
+     char Description[100];
+     snprintf(Description,100,"interpolation at %s",GTCs[nt]->Tag);
+     if (    memcmp(Vertices, SB->Vertices, 3*NV*sizeof(double))
+          || !GT.IsIdentical(*(SB->GT)) )
+      { printf("%-50s FAILED (surface B was moved)\n",Description);
+        Failed=true;
+      }
+     else if ( !Hit || UBC->NumInterpolationHits!=Hits0+1 )
+      { printf("%-50s FAILED (not interpolated)\n",Description);
+        Failed=true;
+      }
+     else
+      { G->AssembleBEMMatrixBlock(0, 1, OMEGA, 0, UDirect, dUDirect);
+        double Err=RelDiff(U, UDirect);
+        for(int Mu=0; Mu<3; Mu++)
+         Err=fmax(Err, RelDiff(dU[Mu], dUDirect[Mu]));
+        if ( !(Err<RELTOL) ) Failed=true;
+        printf("%-50s %s (RelErr = %.1e)\n",Description, Err<RELTOL ? "PASSED" : "FAILED", Err);
+      };
+
+     free(Vertices);
+     G->UnTransform();
+   };
+
+  for(int Mu=0; Mu<3; Mu++)
+   { delete dU[Mu];
+     delete dUDirect[Mu];
+   };
+  delete U;
+  delete UDirect;
+  delete UBC;
+  DestroyGTCList(GTCs);
+  return !Failed;
+}
+
+/***************************************************************/
+/***************************************************************/
+/***************************************************************/
+int main(int argc, char *argv[])
+{
+  SetLogFileName("scuff-test-UBlockCache.log");
+
+  RWGGeometry *G=new RWGGeometry(GEOFILE);
+  RWGSurface *SA=G->Surfaces[0], *SB=G->Surfaces[1];
+  int NA=SA->NumBFs, NB=SB->NumBFs;
+  HMatrix *U=new HMatrix(NA, NB, LHM_COMPLEX);
+  HMatrix *UDirect=new HMatrix(NA, NB, LHM_COMPLEX);
+
+  UBlockCache *UBC=new UBlockCache(G);
+  UBC->Clear(OMEGA);
+  bool Failed=false;
+
+  // initial pose: nothing cached yet
+  if (!CheckFetch("initial pose", G, UBC, U, UDirect, false, 0))
+   Failed=true;
+
+  // move B to a different relative pose; this replaces the block
+  // in the caller's buffer
+  SB->Transform("DISP 0.5 0.25 0");
+  if (!CheckFetch("displaced B", G, UBC, U, UDirect, false, 0))
+   Failed=true;
+
+  // translate both surfaces so that their relative pose is again
+  // the initial one: the block is restored from the stored copy
+  SA->Transform("DISP 0.3 -0.7 1.1");
+  SB->Transform("DISP -0.2 -0.95 1.1");
+  if (!CheckFetch("common translation of A and B", G, UBC, U, UDirect, true, &(UBC->NumHits)))
+   Failed=true;
+
+  // rotate both surfaces by a common rotation: allowed in a
+  // homogeneous medium
+  SA->Transform("ROT 37 ABOUT 1 2 3");
+  SB->Transform("ROT 37 ABOUT 1 2 3");
+  if (!CheckFetch("common rotation of A and B", G, UBC, U, UDirect, true, &(UBC->NumHits)))
+   Failed=true;
+  SA->UnTransform();
+  SB->UnTransform();
+
+  // rotate B by 90 degrees about its own center: the cube mesh is
+  // mapped onto itself, so the block is a signed permutation of
+  // the stored block for the initial pose
+  SB->Transform("DISP -2 0 0");
+  SB->Transform("ROT 90 ABOUT 0 0 1");
+  SB->Transform("DISP 2 0 0");
+  if (!CheckFetch("B rotated about its center (symmetry)", G, UBC, U, UDirect, true, &(UBC->NumSymmetryHits)))
+   Failed=true;
+  SB->UnTransform();
+
+  // same for A, about an axis through its center
+  SA->Transform("ROT 180 ABOUT 1 0 0");
+  if (!CheckFetch("A rotated about its center (symmetry)", G, UBC, U, UDirect, true, &(UBC->NumSymmetryHits)))
+   Failed=true;
+  SA->UnTransform();
+
+  // a rotation that does not map the mesh onto itself
+  SB->Transform("DISP -2 0 0");
+  SB->Transform("ROT 30 ABOUT 0 0 1");
+  SB->Transform("DISP 2 0 0");
+  if (!CheckFetch("B rotated by 30 degrees", G, UBC, U, UDirect, false, 0))
+   Failed=true;
+  SB->UnTransform();
+
+  delete UBC;
+  delete U;
+  delete UDirect;
+
+  if (!TestInterpolation(G))
+   Failed=true;
+
+  delete G;
+
+  if (Failed)
+   exit(1);
+  printf("All tests successfully passed.\n");
+  exit(0);
+}